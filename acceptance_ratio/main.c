@@ -0,0 +1,783 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <time.h>
+#include "../task.h"
+#include "../utility_log.h"
+#include "../utility_time.h"
+#include "../utility_file.h"
+#include "../utility_sched_analysis.h"
+#include "../utility_taskgen.h"
+#include "../utility_taskset.h"
+
+#define NS_PER_MS 1000000ULL
+#define NS_PER_US 1000ULL
+
+/* The tests whose acceptance ratios are measured */
+enum test {
+  TEST_EDF,
+  TEST_DM,
+  TEST_LIU_LAYLAND,
+  TEST_HYPERBOLIC,
+  TEST_COUNT
+};
+static const char *test_names[TEST_COUNT] = {"EDF", "DM", "LL", "HB"};
+
+/* Command line args section */
+static unsigned set_count = 1000;
+static unsigned task_count = 8;
+static double u_from = 0.05, u_to = 1, u_step = 0.05;
+static struct taskgen_params params = {
+  .period_min_ns = 10 * NS_PER_MS,
+  .period_max_ns = 1000 * NS_PER_MS,
+  .period_granularity_ns = NS_PER_MS,
+  .deadline_min_ratio = 1,
+  .wcet_min_ns = 0,
+};
+static int wcet_min_given = 0;
+static unsigned thread_count = 0;
+static unsigned long long seed = 1;
+static const char *dat_path = NULL;
+static const char *live_dir = NULL;
+static unsigned live_count = 10;
+static unsigned long long live_run_ms = 2000;
+static const char *live_policy = "fifo";
+static const char *measure_dir = NULL;
+
+static int parse_cmd_line_args(int argc, char **argv)
+{
+  unsigned long long period_gran_ms = 1;
+  int optchar;
+  char c;
+  opterr = 0;
+  while ((optchar = getopt(argc, argv, ":hn:t:u:p:d:c:j:s:o:w:l:r:P:m:"))
+         != -1) {
+    switch (optchar) {
+    case 'n':
+      if (sscanf(optarg, "%u%c", &set_count, &c) != 1 || set_count == 0) {
+        log_error("Invalid number of task sets '%s'", optarg);
+        return -1;
+      }
+      break;
+    case 't':
+      if (sscanf(optarg, "%u%c", &task_count, &c) != 1 || task_count == 0) {
+        log_error("Invalid number of tasks '%s'", optarg);
+        return -1;
+      }
+      break;
+    case 'u':
+      if (sscanf(optarg, "%lf:%lf:%lf%c", &u_from, &u_to, &u_step, &c) != 3
+          || u_from <= 0 || u_to < u_from || u_step <= 0) {
+        log_error("Invalid utilization range '%s'", optarg);
+        return -1;
+      }
+      break;
+    case 'p':
+      switch (sscanf(optarg, "%llu:%llu:%llu%c", &params.period_min_ns,
+                     &params.period_max_ns, &period_gran_ms, &c)) {
+      case 2:
+        period_gran_ms = 1;
+        /* Fall through */
+      case 3:
+        break;
+      default:
+        log_error("Invalid period range '%s'", optarg);
+        return -1;
+      }
+      params.period_min_ns *= NS_PER_MS;
+      params.period_max_ns *= NS_PER_MS;
+      params.period_granularity_ns = period_gran_ms * NS_PER_MS;
+      if (params.period_granularity_ns == 0
+          || params.period_min_ns < params.period_granularity_ns
+          || params.period_max_ns < params.period_min_ns) {
+        log_error("Invalid period range '%s'", optarg);
+        return -1;
+      }
+      break;
+    case 'd':
+      if (sscanf(optarg, "%lf%c", &params.deadline_min_ratio, &c) != 1
+          || params.deadline_min_ratio < 0
+          || params.deadline_min_ratio > 1) {
+        log_error("Invalid deadline ratio '%s'", optarg);
+        return -1;
+      }
+      break;
+    case 'c':
+      if (sscanf(optarg, "%llu%c", &params.wcet_min_ns, &c) != 1) {
+        log_error("Invalid minimum WCET '%s'", optarg);
+        return -1;
+      }
+      params.wcet_min_ns *= NS_PER_US;
+      wcet_min_given = 1;
+      break;
+    case 'j':
+      if (sscanf(optarg, "%u%c", &thread_count, &c) != 1
+          || thread_count == 0) {
+        log_error("Invalid number of threads '%s'", optarg);
+        return -1;
+      }
+      break;
+    case 's':
+      if (sscanf(optarg, "%llu%c", &seed, &c) != 1) {
+        log_error("Invalid seed '%s'", optarg);
+        return -1;
+      }
+      break;
+    case 'o':
+      dat_path = optarg;
+      break;
+    case 'w':
+      live_dir = optarg;
+      break;
+    case 'l':
+      if (sscanf(optarg, "%u%c", &live_count, &c) != 1 || live_count == 0) {
+        log_error("Invalid number of live task sets '%s'", optarg);
+        return -1;
+      }
+      break;
+    case 'r':
+      if (sscanf(optarg, "%llu%c", &live_run_ms, &c) != 1
+          || live_run_ms == 0) {
+        log_error("Invalid run time '%s'", optarg);
+        return -1;
+      }
+      break;
+    case 'P':
+      if (strcmp(optarg, "fifo") != 0 && strcmp(optarg, "deadline") != 0) {
+        log_error("Invalid policy '%s'", optarg);
+        return -1;
+      }
+      live_policy = optarg;
+      break;
+    case 'm':
+      measure_dir = optarg;
+      break;
+    case 'h':
+      printf("Usage: %1$s [-n SETS] [-t TASKS] [-u FROM:TO:STEP]\n"
+             "          [-p TMIN:TMAX[:GRAN]] [-d RATIO] [-c WCET_MIN]\n"
+             "          [-j THREADS] [-s SEED] [-o DAT_FILE]\n"
+             "          [-w DIR [-l SETS] [-r RUN_TIME] [-P POLICY]]\n"
+             "   or: %1$s -m DIR\n"
+             "\n"
+             "The first form generates SETS random task sets of TASKS\n"
+             "tasks for each total utilization from FROM to TO in steps\n"
+             "of STEP using UUniFast (UUniFast-Discard above 1) and\n"
+             "prints the ratio of the task sets accepted by the EDF\n"
+             "processor demand test, the DM response-time analysis, the\n"
+             "Liu and Layland bound and the hyperbolic bound. The last\n"
+             "two assume implicit deadlines and are printed only if\n"
+             "RATIO is 1. The same SEED gives the same task sets\n"
+             "regardless of THREADS.\n"
+             "The second form reads the statistics of the task sets in\n"
+             "DIR run using ../taskset_runner/main and prints the ratio\n"
+             "of the task sets that the offline analysis accepts and the\n"
+             "ratio of those that meet all deadlines.\n"
+             "\n"
+             "-n SETS is the number of task sets per utilization\n"
+             "   (default 1000).\n"
+             "-t TASKS is the number of tasks per task set (default 8).\n"
+             "-u FROM:TO:STEP is the range of the total utilization\n"
+             "   (default 0.05:1:0.05).\n"
+             "-p TMIN:TMAX[:GRAN] is the range of the periods in ms that\n"
+             "   are drawn log-uniformly as multiples of GRAN ms\n"
+             "   (default 10:1000:1).\n"
+             "-d RATIO draws a relative deadline uniformly from\n"
+             "   [C + RATIO * (T - C), T] (default 1, i.e., implicit).\n"
+             "-c WCET_MIN discards a task set having a WCET less than\n"
+             "   WCET_MIN us (default 0, or 1000 with -w).\n"
+             "-j THREADS is the number of threads to generate and\n"
+             "   analyze the task sets (default the number of CPUs).\n"
+             "-s SEED is the seed of the task sets (default 1).\n"
+             "-o DAT_FILE writes the acceptance ratios as gnuplot data.\n"
+             "-w DIR writes the first SETS task sets of each\n"
+             "   utilization as task set files to run in DIR.\n"
+             "-l SETS is the number of task sets to write per\n"
+             "   utilization (default 10).\n"
+             "-r RUN_TIME is the run time of a written task set in ms\n"
+             "   (default 2000).\n"
+             "-P POLICY is the policy of the written tasks, which is\n"
+             "   either fifo (default) or deadline.\n"
+             "-m DIR enables the second form.\n",
+             prog_name);
+      return -1;
+    case ':':
+      log_error("Option -%c needs an argument (-h for help)", optopt);
+      return -1;
+    case '?':
+      log_error("Unrecognized option -%c (-h for help)", optopt);
+      return -1;
+    default:
+      log_error("Unexpected return value of fn getopt");
+      return -1;
+    }
+  }
+
+  if (optind != argc) {
+    log_error("Unexpected argument '%s' (-h for help)", argv[optind]);
+    return -1;
+  }
+
+  params.task_count = task_count;
+  if (live_dir != NULL && !wcet_min_given) {
+    params.wcet_min_ns = NS_PER_MS;
+  }
+  if (thread_count == 0) {
+    long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+    thread_count = (cpu_count < 1 ? 1 : cpu_count);
+  }
+
+  return 0;
+}
+/* END: Command line args section */
+
+static unsigned point_count(void)
+{
+  return (unsigned) ((u_to - u_from) / u_step + 1e-9) + 1;
+}
+
+static double point_utilization(unsigned point)
+{
+  return u_from + point * u_step;
+}
+
+/* Analysis section */
+struct point_result {
+  unsigned long generated;
+  unsigned long accepted[TEST_COUNT];
+};
+
+struct worker {
+  pthread_t thread;
+  struct point_result *results; /* Indexed by the utilization point */
+  int failed;
+};
+
+static unsigned long next_set = 0;
+
+/* Return 0 if successful, -1 if the task set cannot be generated or
+   -2 in case of error */
+static int analyze_set(unsigned long set_idx, struct point_result *res,
+                       struct taskgen_task *tasks)
+{
+  struct taskgen_params point_params = params;
+  sched_analysis_taskset *set;
+  taskgen_rng rng;
+  int rc;
+
+  point_params.utilization = point_utilization(set_idx / set_count);
+  taskgen_rng_seed(&rng, seed, set_idx);
+  if (taskgen_generate(&rng, &point_params, tasks) != 0) {
+    return -1;
+  }
+
+  set = sched_analysis_taskset_create();
+  if (set == NULL) {
+    log_error("Cannot create a task set to analyze");
+    return -2;
+  }
+  if (taskgen_to_analysis(tasks, task_count, set) != 0) {
+    log_error("Cannot add the generated tasks to the task set to analyze");
+    sched_analysis_taskset_destroy(set);
+    return -2;
+  }
+
+  res->generated++;
+  if (sched_analysis_edf(set)) {
+    res->accepted[TEST_EDF]++;
+  }
+  if ((rc = sched_analysis_fp(set, SCHED_ANALYSIS_DM)) == -1) {
+    log_error("Cannot analyze a generated task set using DM");
+    sched_analysis_taskset_destroy(set);
+    return -2;
+  } else if (rc == 1) {
+    res->accepted[TEST_DM]++;
+  }
+  if (sched_analysis_liu_layland(set)) {
+    res->accepted[TEST_LIU_LAYLAND]++;
+  }
+  if (sched_analysis_hyperbolic_bound(set)) {
+    res->accepted[TEST_HYPERBOLIC]++;
+  }
+
+  sched_analysis_taskset_destroy(set);
+
+  return 0;
+}
+
+static void *worker_thread(void *args)
+{
+  struct worker *w = args;
+  unsigned long total = (unsigned long) point_count() * set_count;
+  struct taskgen_task *tasks = malloc(sizeof(*tasks) * task_count);
+
+  if (tasks == NULL) {
+    log_error("Not enough memory for the tasks of a worker");
+    w->failed = 1;
+    return NULL;
+  }
+
+  while (1) {
+    unsigned long set_idx = __atomic_fetch_add(&next_set, 1,
+                                               __ATOMIC_RELAXED);
+    if (set_idx >= total) {
+      break;
+    }
+    if (analyze_set(set_idx, &w->results[set_idx / set_count], tasks) == -2) {
+      w->failed = 1;
+      break;
+    }
+  }
+
+  free(tasks);
+
+  return NULL;
+}
+
+static void print_results(FILE *report, const struct point_result *results,
+                          int is_gnuplot)
+{
+  unsigned test_count = (params.deadline_min_ratio == 1
+                         ? TEST_COUNT : TEST_LIU_LAYLAND);
+  unsigned point, test;
+
+  fprintf(report, "%s%6s%8s", is_gnuplot ? "#" : "", "U", "sets");
+  for (test = 0; test < test_count; test++) {
+    fprintf(report, "%8s", test_names[test]);
+  }
+  fprintf(report, "\n");
+
+  for (point = 0; point < point_count(); point++) {
+    const struct point_result *res = &results[point];
+
+    fprintf(report, "%7.3f%8lu", point_utilization(point), res->generated);
+    for (test = 0; test < test_count; test++) {
+      if (res->generated == 0) {
+        fprintf(report, "%8s", is_gnuplot ? "?" : "-");
+      } else {
+        fprintf(report, "%8.4f",
+                (double) res->accepted[test] / res->generated);
+      }
+    }
+    fprintf(report, "\n");
+  }
+}
+
+static int run_analysis(void)
+{
+  unsigned points = point_count();
+  struct point_result *results = calloc(points, sizeof(*results));
+  struct worker *workers = calloc(thread_count, sizeof(*workers));
+  struct timespec t_begin, t_end;
+  unsigned i, point, test;
+  int exit_code = EXIT_SUCCESS;
+
+  if (results == NULL || workers == NULL) {
+    log_error("Not enough memory for the results");
+    free(results);
+    free(workers);
+    return EXIT_FAILURE;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &t_begin);
+  for (i = 0; i < thread_count; i++) {
+    int rc;
+    workers[i].results = calloc(points, sizeof(*workers[i].results));
+    if (workers[i].results == NULL) {
+      log_error("Not enough memory for the results of a worker");
+      break;
+    }
+    if ((rc = pthread_create(&workers[i].thread, NULL, worker_thread,
+                             &workers[i])) != 0) {
+      errno = rc;
+      log_syserror("Cannot create worker thread");
+      free(workers[i].results);
+      break;
+    }
+  }
+  if (i == 0) {
+    free(results);
+    free(workers);
+    return EXIT_FAILURE;
+  }
+  thread_count = i;
+
+  for (i = 0; i < thread_count; i++) {
+    pthread_join(workers[i].thread, NULL);
+    if (workers[i].failed) {
+      exit_code = EXIT_FAILURE;
+    }
+    for (point = 0; point < points; point++) {
+      results[point].generated += workers[i].results[point].generated;
+      for (test = 0; test < TEST_COUNT; test++) {
+        results[point].accepted[test]
+          += workers[i].results[point].accepted[test];
+      }
+    }
+    free(workers[i].results);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t_end);
+  free(workers);
+
+  print_results(stdout, results, 0);
+  printf("%lu task sets of %u tasks analyzed in %.3f s using %u threads\n",
+         (unsigned long) points * set_count, task_count,
+         (t_end.tv_sec - t_begin.tv_sec)
+         + (t_end.tv_nsec - t_begin.tv_nsec) / 1e9, thread_count);
+  for (point = 0; point < points; point++) {
+    if (results[point].generated != set_count) {
+      printf("%lu task sets of U = %.3f cannot be generated\n",
+             set_count - results[point].generated, point_utilization(point));
+    }
+  }
+
+  if (dat_path != NULL) {
+    FILE *dat = fopen(dat_path, "w");
+    if (dat == NULL) {
+      log_syserror("Cannot open '%s' for writing", dat_path);
+      exit_code = EXIT_FAILURE;
+    } else {
+      print_results(dat, results, 1);
+      if (utility_file_close(dat, dat_path) != 0) {
+        exit_code = EXIT_FAILURE;
+      }
+    }
+  }
+
+  free(results);
+
+  return exit_code;
+}
+/* END: Analysis section */
+
+/* Live section */
+static int write_live_sets(void)
+{
+  struct taskgen_task *tasks = malloc(sizeof(*tasks) * task_count);
+  char attributes[32];
+  unsigned point, k;
+  size_t path_size = strlen(live_dir) + 32;
+  char *path = malloc(path_size);
+
+  if (tasks == NULL || path == NULL) {
+    log_error("Not enough memory to write the live task sets");
+    free(tasks);
+    free(path);
+    return -1;
+  }
+  snprintf(attributes, sizeof(attributes), "policy=%s", live_policy);
+
+  for (point = 0; point < point_count(); point++) {
+    struct taskgen_params point_params = params;
+    point_params.utilization = point_utilization(point);
+
+    for (k = 0; k < live_count && k < set_count; k++) {
+      unsigned long set_idx = (unsigned long) point * set_count + k;
+      taskgen_rng rng;
+      FILE *f;
+
+      taskgen_rng_seed(&rng, seed, set_idx);
+      if (taskgen_generate(&rng, &point_params, tasks) != 0) {
+        continue;
+      }
+
+      snprintf(path, path_size, "%s/U%.3f-%04u.ts", live_dir,
+               point_params.utilization, k);
+      f = fopen(path, "w");
+      if (f == NULL) {
+        log_syserror("Cannot open '%s' for writing", path);
+        goto error;
+      }
+      fprintf(f, "# Task set %lu of seed %llu at U = %.3f\n"
+              "START 1s\n"
+              "STOP %llums\n",
+              set_idx, seed, point_params.utilization, 1000 + live_run_ms);
+      if (taskgen_write(f, tasks, task_count, attributes) != 0) {
+        log_syserror("Cannot write '%s'", path);
+        utility_file_close(f, path);
+        goto error;
+      }
+      if (utility_file_close(f, path) != 0) {
+        goto error;
+      }
+    }
+  }
+
+  free(tasks);
+  free(path);
+  return 0;
+
+ error:
+  free(tasks);
+  free(path);
+  return -1;
+}
+
+struct late_count {
+  relative_time period;
+  relative_time deadline;
+  absolute_time t_0;
+  relative_time offset;
+  unsigned long nth_job;
+  unsigned long job_count;
+  unsigned long late_count;
+};
+
+static int count_task(task *tau, void *args)
+{
+  struct late_count *prms = args;
+
+  utility_time_to_utility_time_gc(task_statistics_period(tau),
+                                  &prms->period);
+  utility_time_to_utility_time_gc(task_statistics_deadline(tau),
+                                  &prms->deadline);
+  utility_time_to_utility_time_gc(task_statistics_t0(tau), &prms->t_0);
+  utility_time_to_utility_time_gc(task_statistics_offset(tau),
+                                  &prms->offset);
+  prms->nth_job = task_statistics_oldest_job_pos(tau);
+
+  return 0;
+}
+
+/* Count a late job like read_task_stats_file does */
+static int count_job(job_statistics *stats, void *args)
+{
+  struct late_count *prms = args;
+  relative_time *job_offset = utility_time_mul_dyn(&prms->period,
+                                                   prms->nth_job - 1);
+  absolute_time *t_deadline = utility_time_add_dyn(&prms->offset, job_offset);
+  utility_time_inc(t_deadline, &prms->deadline);
+  utility_time_gc(job_offset);
+
+  absolute_time *t_job_finish = job_statistics_time_finish(stats);
+  absolute_time *t_finish = utility_time_sub_dyn(t_job_finish, &prms->t_0);
+  utility_time_gc(t_job_finish);
+
+  if (utility_time_lt_gc(t_deadline, t_finish)) {
+    prms->late_count++;
+  }
+  prms->job_count++;
+  prms->nth_job++;
+
+  return 0;
+}
+
+/* Return 1 if all jobs of the given task set meet their deadlines, 0
+   if some do not, or -1 if the statistics cannot be read */
+static int measure_set(const char *taskset_path, const taskset_desc *ts)
+{
+  size_t base_len = strlen(taskset_path) - 3; /* Without .ts */
+  unsigned i;
+  int res = 1;
+
+  for (i = 0; i < taskset_task_count(ts); i++) {
+    const struct taskset_task *t = taskset_task(ts, i);
+    struct late_count prms = {
+      .job_count = 0,
+      .late_count = 0,
+    };
+    char *path = malloc(base_len + strlen(t->name) + sizeof("__stats.bin"));
+    FILE *stats_file;
+    int rc;
+
+    if (path == NULL) {
+      log_error("Not enough memory to allocate a path");
+      return -1;
+    }
+    sprintf(path, "%.*s_%s_stats.bin", (int) base_len, taskset_path, t->name);
+
+    stats_file = utility_file_open_for_reading_bin(path);
+    if (stats_file == NULL) {
+      log_error("Cannot open task stat file '%s'", path);
+      free(path);
+      return -1;
+    }
+    utility_time_init(&prms.period);
+    utility_time_init(&prms.deadline);
+    utility_time_init(&prms.t_0);
+    utility_time_init(&prms.offset);
+    rc = task_statistics_read(stats_file, count_task, &prms,
+                              count_job, &prms);
+    utility_file_close(stats_file, path);
+    if (rc != 0) {
+      log_error("Cannot read task stat file '%s'", path);
+      free(path);
+      return -1;
+    }
+    free(path);
+
+    if (prms.job_count == 0) {
+      log_error("Task %s of '%s' has no job", t->name, taskset_path);
+      return -1;
+    }
+    if (prms.late_count != 0) {
+      res = 0;
+    }
+  }
+
+  return res;
+}
+
+static int filename_cmp(const void *a, const void *b)
+{
+  return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+static void print_measurement(const char *group, unsigned long run,
+                              unsigned long offline, unsigned long live,
+                              unsigned long offline_but_late)
+{
+  if (run == 0) {
+    return;
+  }
+  printf("%7s%8lu%9.4f%9.4f%14lu\n", group, run, (double) offline / run,
+         (double) live / run, offline_but_late);
+}
+
+static int run_measurement(void)
+{
+  DIR *dir = opendir(measure_dir);
+  struct dirent *entry;
+  char **names = NULL;
+  size_t name_count = 0, name_capacity = 0, i;
+  char group[16] = "";
+  unsigned long run = 0, offline = 0, live = 0, offline_but_late = 0;
+  unsigned long skipped = 0;
+  int exit_code = EXIT_SUCCESS;
+
+  if (dir == NULL) {
+    log_syserror("Cannot open directory '%s'", measure_dir);
+    return EXIT_FAILURE;
+  }
+  while ((entry = readdir(dir)) != NULL) {
+    size_t len = strlen(entry->d_name);
+    if (len < 4 || entry->d_name[0] != 'U'
+        || strcmp(&entry->d_name[len - 3], ".ts") != 0) {
+      continue;
+    }
+    if (name_count == name_capacity) {
+      char **new_names;
+      name_capacity = (name_capacity == 0 ? 64 : name_capacity * 2);
+      new_names = realloc(names, sizeof(*names) * name_capacity);
+      if (new_names == NULL) {
+        log_error("Not enough memory to list the task set files");
+        exit_code = EXIT_FAILURE;
+        break;
+      }
+      names = new_names;
+    }
+    if ((names[name_count] = strdup(entry->d_name)) == NULL) {
+      log_error("Not enough memory to list the task set files");
+      exit_code = EXIT_FAILURE;
+      break;
+    }
+    name_count++;
+  }
+  closedir(dir);
+  if (exit_code == EXIT_FAILURE) {
+    goto out;
+  }
+  qsort(names, name_count, sizeof(*names), filename_cmp);
+
+  printf("%7s%8s%9s%9s%14s\n", "U", "sets", "offline", "live",
+         "offline+late");
+  for (i = 0; i < name_count; i++) {
+    char *path = malloc(strlen(measure_dir) + strlen(names[i]) + 2);
+    char point[sizeof(group)];
+    taskset_desc *ts;
+    int verdict, met;
+
+    if (path == NULL) {
+      log_error("Not enough memory to allocate a path");
+      exit_code = EXIT_FAILURE;
+      break;
+    }
+    sprintf(path, "%s/%s", measure_dir, names[i]);
+
+    /* The utilization in U%.3f-%04u.ts groups the task sets */
+    snprintf(point, sizeof(point), "%.*s", (int) strcspn(&names[i][1], "-"),
+             &names[i][1]);
+    if (strcmp(group, point) != 0) {
+      print_measurement(group, run, offline, live, offline_but_late);
+      strcpy(group, point);
+      run = offline = live = offline_but_late = 0;
+    }
+
+    if (taskset_load(path, &ts) != 0) {
+      log_error("Cannot load task set file '%s'", path);
+      free(path);
+      exit_code = EXIT_FAILURE;
+      break;
+    }
+    verdict = taskset_analyze(ts, 0, NULL);
+    met = measure_set(path, ts);
+    taskset_destroy(ts);
+    free(path);
+
+    if (verdict < 0 || met == -1) {
+      skipped++;
+      continue;
+    }
+    run++;
+    offline += verdict;
+    live += met;
+    if (verdict && !met) {
+      offline_but_late++;
+    }
+  }
+  print_measurement(group, run, offline, live, offline_but_late);
+  if (skipped != 0) {
+    printf("%lu task sets are skipped\n", skipped);
+  }
+
+ out:
+  for (i = 0; i < name_count; i++) {
+    free(names[i]);
+  }
+  free(names);
+
+  return exit_code;
+}
+/* END: Live section */
+
+const char prog_name[] = "acceptance_ratio";
+FILE *log_stream;
+
+int main(int argc, char **argv, char **envp)
+{
+  log_stream = stderr;
+
+  if (parse_cmd_line_args(argc, argv) != 0) {
+    return EXIT_FAILURE;
+  }
+
+  if (measure_dir != NULL) {
+    return run_measurement();
+  }
+
+  if (live_dir != NULL && write_live_sets() != 0) {
+    return EXIT_FAILURE;
+  }
+
+  return run_analysis();
+}
@@ -24,8 +24,10 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <signal.h>
 #include <string.h>
+#include <strings.h>
 #include <pthread.h>
 #include <errno.h>
 #include <time.h>
@@ -37,16 +39,49 @@
 #include "../utility_sched_deadline.h"
 #include "../task.h"
 #include "../utility_memory.h"
+#include "../utility_file.h"
+#include "../utility_shm_channel.h"
+#include "../utility_supervisor.h"
+#include "../utility_arrival.h"
+#include "../utility_request_trace.h"
+#include "../utility_bwi.h"
+#include "../utility_payload.h"
+#include "../utility_program_options.h"
+
+/* The shm channel of a server is named after its port */
+#define SHM_CHANNEL_NAME_FMT "/bwi-client_server-%d"
+#define BATCH_SIZE_MAX 64
+/* A server acknowledges entering or leaving SCHED_FIFO upon SIGUSR1 by
+   sending this signal back to the sender of SIGUSR1 */
+#define SCHED_FIFO_ACK_SIGNAL SIGRTMIN
+#define SCHED_FIFO_ACK_TIMEOUT_MS 500
+/* The largest UDP payload that IPv4 can carry */
+#define UDP_MSG_SIZE_MAX 65507
+
+/* The round-trip time of a request */
+struct request_latency {
+  int job; /* The n-th job of the client task starting from 1 */
+  int request; /* The request index in the job's batch starting from 0 */
+  unsigned long long ns;
+  unsigned long long latency_ns; /* From the intended release in open loop */
+};
 
 struct client_prog_prms {
   pthread_t main_thread;
   cpu_busyloop *prologue_busyloop;
-  void *request;
+  void *request; /* batch_size requests of len bytes each */
   void *response;
   size_t len;
+  size_t match_len; /* The leading bytes telling apart the responses */
+  int batch_size;
+  size_t payload_size; /* 0 if the requests carry no payload */
+  payload_region *payloads; /* Non-NULL if the payloads are not copied */
+  struct timespec *t_sent; /* Sending time of each request in the batch */
   cpu_busyloop *epilogue_busyloop;
   int *client_socket_ptr;
+  shm_channel *client_channel;
   int server_pid;
+  bwi *bwi; /* Non-NULL if BWI is used */
   int nth_iteration;
   int stopping_iteration;
   int ftrace_iteration;
@@ -57,8 +92,15 @@ struct client_prog_prms {
   relative_time ftrace_response_time;
   relative_time period;
   int ftrace_response_time_hit;
+  struct request_latency *rtt; /* The round-trip time of each request */
+  unsigned long rtt_capacity;
+  unsigned long rtt_count;
+  arrival_process *arrivals; /* Non-NULL in open-loop mode */
+  unsigned long long t_intended_ns; /* The intended release of the job */
+  request_trace *trace; /* Non-NULL if the requests are traced */
 };
 static void client_prog(void *args);
+static int open_loop_release(void *args);
 
 struct client_thread_prms {
   int wcet_ms;
@@ -107,6 +149,11 @@ static void *client_thread(void *args)
   }
   /* END: Use CBS server */
 
+  if (supervisor_notify_ready() != 0) {
+    log_error("Cannot notify the driver of the readiness");
+    return &prms->rc;
+  }
+
   /* Wait for starting signal */
   {
     int signo;
@@ -127,13 +174,21 @@ static void *client_thread(void *args)
                         to_utility_time_dyn(1, s),
                         &prms->client_prog_args->next_release);
 
+    /* The arrivals of an open-loop client start at the first release
+       of a periodic one */
+    prms->client_prog_args->t_intended_ns
+      = ((t_now.tv_sec + 1) * 1000000000ULL + t_now.tv_nsec
+         + prms->offset_ms * 1000000ULL);
+
     int rc = task_create("client",
                          to_utility_time_dyn(prms->wcet_ms, ms),
                          to_utility_time_dyn(prms->period_ms, ms),
                          to_utility_time_dyn(prms->period_ms, ms),
                          &prms->client_prog_args->next_release,
                          to_utility_time_dyn(prms->offset_ms, ms),
-                         NULL, NULL,
+                         (prms->client_prog_args->arrivals == NULL
+                          ? NULL : open_loop_release),
+                         prms->client_prog_args,
                          prms->stats_file_path, prms->ringbuf_slot_count, 1,
                          prms->job_stats_overhead,
                          prms->task_overhead,
@@ -163,12 +218,29 @@ static void *client_thread(void *args)
   return &prms->rc;
 }
 
-static void send_recv(int comm_socket, const void *data, size_t data_len,
+static ssize_t send_msg(int comm_socket, shm_channel *comm_channel,
+                        const void *data, size_t data_len)
+{
+  return (comm_channel == NULL
+          ? send(comm_socket, data, data_len, 0)
+          : shm_channel_send(comm_channel, data, data_len));
+}
+
+static ssize_t recv_msg(int comm_socket, shm_channel *comm_channel,
+                        void *buffer, size_t buf_len)
+{
+  return (comm_channel == NULL
+          ? recv(comm_socket, buffer, buf_len, 0)
+          : shm_channel_recv(comm_channel, buffer, buf_len));
+}
+
+static void send_recv(int comm_socket, shm_channel *comm_channel,
+                      const void *data, size_t data_len,
                       void *buffer, size_t buf_len,
                       ssize_t *byte_sent, ssize_t *byte_rcvd,
                       int *send_errno, int *recv_errno)
 {
-  *byte_sent = send(comm_socket, data, data_len, 0);
+  *byte_sent = send_msg(comm_socket, comm_channel, data, data_len);
   if (*byte_sent == -1) {
     *send_errno = errno;
   } else {
@@ -183,7 +255,7 @@ static void send_recv(int comm_socket, const void *data, size_t data_len,
 
   memset(buffer, 0, buf_len);
 
-  *byte_rcvd = recv(comm_socket, buffer, buf_len, 0);
+  *byte_rcvd = recv_msg(comm_socket, comm_channel, buffer, buf_len);
   if (*byte_rcvd == -1) {
     *recv_errno = errno;
   } else {
@@ -191,37 +263,57 @@ static void send_recv(int comm_socket, const void *data, size_t data_len,
   }
 }
 
+/* Ask the server to enter or leave SCHED_FIFO and wait for its
+   acknowledgement */
+static void toggle_server_sched_fifo(int server_pid, const char *action)
+{
+  struct timespec timeout = {
+    .tv_sec = 0,
+    .tv_nsec = SCHED_FIFO_ACK_TIMEOUT_MS * 1000000L,
+  };
+  sigset_t ack_signal;
+  siginfo_t ack;
+  int rc;
+
+  sigemptyset(&ack_signal);
+  sigaddset(&ack_signal, SCHED_FIFO_ACK_SIGNAL);
+
+  if (kill(server_pid, SIGUSR1) != 0) {
+    fatal_error("Cannot signal the server to %s SCHED_FIFO", action);
+  }
+  do {
+    rc = sigtimedwait(&ack_signal, &ack, &timeout);
+  } while ((rc == -1 && errno == EINTR)
+           || (rc != -1 && ack.si_pid != server_pid));
+  if (rc == -1) {
+    fatal_error("Server does not %s SCHED_FIFO after %d ms",
+                action, SCHED_FIFO_ACK_TIMEOUT_MS);
+  }
+}
+
 struct send_recv_overhead_measurement_prms {
   int rc;
   int server_pid;
   int comm_socket;
+  shm_channel *comm_channel;
   const void *request;
   void *response;
   size_t len;
+  int batch_size;
   relative_time *overhead;
 };
 static void *send_recv_overhead_measurement_thread(void *args)
 {
   struct send_recv_overhead_measurement_prms *prms = args;
   struct timespec t1, t2;
-  ssize_t byte_sent, byte_rcvd;
-  int send_errno, recv_errno;
-  int counter;
+  ssize_t byte_sent = 0, byte_rcvd = 0;
+  int send_errno = 0, recv_errno = 0;
+  int i;
+  const char *request = prms->request;
 
   memset(prms->response, 0, prms->len);
 
-  if (kill(prms->server_pid, SIGUSR1) != 0) {
-    fatal_error("Cannot signal the server to enter SCHED_FIFO");
-  }
-  counter = 500;
-  while (sched_getscheduler(prms->server_pid) != SCHED_FIFO
-         && counter != 0) {
-    usleep(1000);
-    counter--;
-  }
-  if (counter == 0) {
-    fatal_error("Server does not enter SCHED_FIFO after 500 ms");
-  }
+  toggle_server_sched_fifo(prms->server_pid, "enter");
 
   if (sched_fifo_enter_max(NULL) != 0) {
     fatal_error("Fail to become highest SCHED_FIFO thread to measure"
@@ -232,26 +324,23 @@ static void *send_recv_overhead_measurement_thread(void *args)
     fatal_error("Cannot record starting time");
   }
 
-  send_recv(prms->comm_socket, prms->request, prms->len,
-            prms->response, prms->len,
-            &byte_sent, &byte_rcvd, &send_errno, &recv_errno);
+  /* The whole batch is served one request after another */
+  for (i = 0; i < prms->batch_size; i++) {
+    request = (const char *) prms->request + i * prms->len;
+    send_recv(prms->comm_socket, prms->comm_channel, request, prms->len,
+              prms->response, prms->len,
+              &byte_sent, &byte_rcvd, &send_errno, &recv_errno);
+    if (byte_sent != prms->len || byte_rcvd != prms->len
+        || memcmp(request, prms->response, prms->len) != 0) {
+      break;
+    }
+  }
 
   if (clock_gettime(CLOCK_MONOTONIC, &t2) != 0) {
     fatal_error("Cannot record finishing time");
   }
 
-  if (kill(prms->server_pid, SIGUSR1) != 0) {
-    fatal_error("Cannot signal the server to leave SCHED_FIFO");
-  }
-  counter = 500;
-  while (sched_getscheduler(prms->server_pid) == SCHED_FIFO
-         && counter != 0) {
-    usleep(1000);
-    counter--;
-  }
-  if (counter == 0) {
-    fatal_error("Server does not leave SCHED_FIFO after 500 ms");
-  }
+  toggle_server_sched_fifo(prms->server_pid, "leave");
 
   prms->overhead = utility_time_sub_dyn_gc(timespec_to_utility_time_dyn(&t2),
                                            timespec_to_utility_time_dyn(&t1));
@@ -268,7 +357,7 @@ static void *send_recv_overhead_measurement_thread(void *args)
     fatal_syserror("Cannot retrieve server response");
   } else if (byte_rcvd != prms->len) {
     fatal_error("Server response is corrupted");
-  } else if (memcmp(prms->request, prms->response, prms->len) != 0) {
+  } else if (memcmp(request, prms->response, prms->len) != 0) {
     fatal_error("Request & server response do not match");
   }
 
@@ -278,17 +367,21 @@ static void *send_recv_overhead_measurement_thread(void *args)
 
 static relative_time *measure_send_recv_overhead(int server_pid,
                                                  int comm_socket,
+                                                 shm_channel *comm_channel,
                                                  const void *request,
                                                  void *response,
-                                                 size_t len)
+                                                 size_t len,
+                                                 int batch_size)
 {
   pthread_t measurement_thread;
   struct send_recv_overhead_measurement_prms args = {
     .server_pid = server_pid,
     .comm_socket = comm_socket,
+    .comm_channel = comm_channel,
     .request = request,
     .response = response,
     .len = len,
+    .batch_size = batch_size,
   };
 
   if (pthread_create(&measurement_thread, NULL,
@@ -302,41 +395,132 @@ static relative_time *measure_send_recv_overhead(int server_pid,
   return args.overhead;
 }
 
+/* Sleep until the next intended release regardless of whether the
+   previous job has completed so that a slow server cannot slow the
+   arrivals down (i.e., no coordinated omission). A job released late
+   is measured from its intended release. */
+static int open_loop_release(void *args)
+{
+  struct client_prog_prms *prms = args;
+  unsigned long long interarrival_ns;
+  struct timespec t_intended;
+
+  if (arrival_next(prms->arrivals, &interarrival_ns) != 0) {
+    /* No more arrival until task_stop() cancels this thread */
+    while (1) {
+      pause();
+    }
+  }
+  prms->t_intended_ns += interarrival_ns;
+
+  t_intended.tv_sec = prms->t_intended_ns / 1000000000ULL;
+  t_intended.tv_nsec = prms->t_intended_ns % 1000000000ULL;
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t_intended, NULL)
+         == EINTR);
+
+  timespec_to_utility_time(&t_intended, &prms->next_release);
+
+  return 0;
+}
+
 static void client_prog(void *args)
 {
   struct client_prog_prms *prms = args;
-  int bwi_key;
-  int send_errno, recv_errno;
-  ssize_t byte_sent, byte_rcvd;
+  int send_errno = 0, recv_errno = 0;
+  ssize_t byte_sent = 0, byte_rcvd = 0;
+  int sent, rcvd, truncated = 0, corrupted = 0, mismatched = 0;
+  uint64_t answered = 0; /* Bit i is set once request i is answered */
 
   ++prms->nth_iteration;
 
   keep_cpu_busy(prms->prologue_busyloop);
 
+  /* Produce the payloads */
+  if (prms->payload_size != 0) {
+    for (sent = 0; sent < prms->batch_size; sent++) {
+      memset((prms->payloads != NULL
+              ? payload_region_slot(prms->payloads, sent)
+              : (char *) prms->request + sent * prms->len + prms->match_len),
+             prms->nth_iteration, prms->payload_size);
+    }
+  }
+  /* END: Produce the payloads */
+
   /* BWI */
   if (prms->nth_iteration == prms->ftrace_iteration) {
     fprintf(prms->ftrace_file, "1");
   }
-  if (prms->server_pid != -1) {
-    if (syscall(344, prms->server_pid, &bwi_key) != 0) {
-      fatal_syserror("Cannot perform BWI");
-    }
-  }  
+  /* The requests are sent without BWI if it cannot be given */
+  if (prms->bwi != NULL && bwi_give(prms->bwi, prms->server_pid) == -2) {
+    fatal_error("Cannot perform BWI");
+  }
   /* END: BWI */
 
-  memset(prms->response, 0, prms->len);
-
+  /* Keep the whole batch outstanding before collecting the responses,
+     which a server having several workers may return in any order */
   pthread_sigmask(SIG_UNBLOCK, &prms->send_recv_interrupt_mask, NULL);
-  send_recv(*prms->client_socket_ptr, prms->request, prms->len,
-            prms->response, prms->len, &byte_sent, &byte_rcvd,
-            &send_errno, &recv_errno);
+  for (sent = 0; sent < prms->batch_size; sent++) {
+    request_trace_id *id = (request_trace_id *) ((char *) prms->request
+                                                 + sent * prms->len);
+    id->job = prms->nth_iteration;
+    clock_gettime(CLOCK_MONOTONIC, &prms->t_sent[sent]);
+    request_trace_add(prms->trace, 0, REQUEST_TRACE_SEND, &prms->t_sent[sent],
+                      id, prms->len);
+    byte_sent = send_msg(*prms->client_socket_ptr, prms->client_channel,
+                         id, prms->len);
+    if (byte_sent == -1) {
+      send_errno = errno;
+      break;
+    } else if (byte_sent != prms->len) {
+      truncated++;
+    }
+  }
+  for (rcvd = 0; rcvd < sent; rcvd++) {
+    struct timespec t_rcvd;
+
+    memset(prms->response, 0, prms->match_len);
+    byte_rcvd = recv_msg(*prms->client_socket_ptr, prms->client_channel,
+                         prms->response, prms->len);
+    clock_gettime(CLOCK_MONOTONIC, &t_rcvd);
+    if (byte_rcvd == -1) {
+      recv_errno = errno;
+      break;
+    } else if (byte_rcvd != prms->len) {
+      corrupted++;
+      continue;
+    }
+
+    int i;
+    for (i = 0; i < sent; i++) {
+      if (!(answered & (1ULL << i))
+          && memcmp((char *) prms->request + i * prms->len,
+                    prms->response, prms->match_len) == 0) {
+        break;
+      }
+    }
+    if (i == sent) {
+      mismatched++;
+      continue;
+    }
+    answered |= 1ULL << i;
+    request_trace_add(prms->trace, 0, REQUEST_TRACE_RESPONSE, &t_rcvd,
+                      prms->response, byte_rcvd);
+
+    if (prms->rtt_count < prms->rtt_capacity) {
+      struct request_latency *rtt = &prms->rtt[prms->rtt_count++];
+      rtt->job = prms->nth_iteration;
+      rtt->request = i;
+      rtt->ns = ((t_rcvd.tv_sec - prms->t_sent[i].tv_sec) * 1000000000ULL
+                 + t_rcvd.tv_nsec - prms->t_sent[i].tv_nsec);
+      rtt->latency_ns = (t_rcvd.tv_sec * 1000000000ULL + t_rcvd.tv_nsec
+                         - prms->t_intended_ns);
+    }
+  }
   pthread_sigmask(SIG_BLOCK, &prms->send_recv_interrupt_mask, NULL);
 
   /* BWI revocation */
-  if (prms->server_pid != -1) {
-    if (syscall(345, bwi_key) != 0) {
-      fatal_syserror("Cannot revoke BWI");
-    }
+  if (prms->bwi != NULL && bwi_revoke(prms->bwi) != 0) {
+    fatal_error("Cannot revoke BWI");
   }
   if (prms->nth_iteration == prms->ftrace_iteration_limit) {
     fprintf(prms->ftrace_file, "0");
@@ -360,7 +544,9 @@ static void client_prog(void *args)
       prms->ftrace_response_time_hit = prms->nth_iteration;
     }
 
-    utility_time_inc(&prms->next_release, &prms->period);
+    if (prms->arrivals == NULL) {
+      utility_time_inc(&prms->next_release, &prms->period);
+    }
   }  
   /* END: Stop tracing when too large response time detected */
 
@@ -369,8 +555,9 @@ static void client_prog(void *args)
     if (errno != EINTR) {
       fatal_syserror("Cannot send request");
     }
-  } else if (byte_sent != prms->len) {
-    log_error("Sent request is truncated");
+  }
+  if (truncated != 0) {
+    log_error("%d sent request(s) are truncated", truncated);
   }
 
   if (byte_rcvd == -1) {
@@ -379,10 +566,12 @@ static void client_prog(void *args)
       fatal_syserror("Cannot retrieve server response @ iteration %d",
                      prms->nth_iteration);
     }
-  } else if (byte_rcvd != prms->len) {
-    log_error("Server response is corrupted");
-  } else if (memcmp(prms->request, prms->response, prms->len) != 0) {
-    log_error("Request & server response do not match");
+  }
+  if (corrupted != 0) {
+    log_error("%d server response(s) are corrupted", corrupted);
+  }
+  if (mismatched != 0) {
+    log_error("%d request(s) & server response(s) do not match", mismatched);
   }
 
   if (prms->nth_iteration == prms->stopping_iteration) {
@@ -390,9 +579,135 @@ static void client_prog(void *args)
   }
 }
 
+static int compare_ns(const void *a, const void *b)
+{
+  unsigned long long x = *(const unsigned long long *) a;
+  unsigned long long y = *(const unsigned long long *) b;
+
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/* Return the smallest time that is not exceeded by the given fraction
+   (in units of 1/10000) of the sorted times */
+static unsigned long long ns_percentile(const unsigned long long *ns,
+                                        unsigned long count,
+                                        unsigned long fraction)
+{
+  unsigned long long rank = ((unsigned long long) count * fraction
+                             + 9999) / 10000;
+  return ns[rank == 0 ? 0 : rank - 1];
+}
+
+/* Write the RTTs in the order of the jobs to be joined with the job
+   statistics */
+static void log_rtt(const struct request_latency *rtt,
+                    unsigned long rtt_count, int open_loop,
+                    const char *log_path)
+{
+  FILE *log_file = utility_file_open_for_writing(log_path);
+  if (log_file == NULL) {
+    log_error("Cannot open request log file %s", log_path);
+    return;
+  }
+  fprintf(log_file, "# Job\tRequest\tRTT in ns%s\n",
+          open_loop ? "\tLatency in ns" : "");
+  unsigned long i;
+  for (i = 0; i < rtt_count; i++) {
+    fprintf(log_file, "%d\t%d\t%llu", rtt[i].job, rtt[i].request,
+            rtt[i].ns);
+    if (open_loop) {
+      fprintf(log_file, "\t%llu", rtt[i].latency_ns);
+    }
+    fprintf(log_file, "\n");
+  }
+  utility_file_close(log_file, log_path);
+}
+
+/* Print the distribution of the given times, which are sorted in
+   place, under the given name and, if cdf_path is not NULL, store
+   their CDF */
+static void report_distribution(const char *name, unsigned long long *ns,
+                                unsigned long count, const char *cdf_path)
+{
+  if (count == 0) {
+    printf("%s: no complete request\n", name);
+    return;
+  }
+
+  qsort(ns, count, sizeof(*ns), compare_ns);
+
+  printf("%s (ns): n=%lu min=%llu p50=%llu p90=%llu p99=%llu"
+         " p99.9=%llu max=%llu\n", name, count, ns[0],
+         ns_percentile(ns, count, 5000),
+         ns_percentile(ns, count, 9000),
+         ns_percentile(ns, count, 9900),
+         ns_percentile(ns, count, 9990),
+         ns[count - 1]);
+
+  if (cdf_path == NULL) {
+    return;
+  }
+
+  FILE *cdf_file = utility_file_open_for_writing(cdf_path);
+  if (cdf_file == NULL) {
+    log_error("Cannot open CDF file %s", cdf_path);
+    return;
+  }
+  fprintf(cdf_file, "# %s in ns\tCumulative probability\n", name);
+  unsigned long i;
+  for (i = 0; i < count; i++) {
+    if (i + 1 < count && ns[i + 1] == ns[i]) {
+      continue;
+    }
+    fprintf(cdf_file, "%llu\t%.6f\n", ns[i], (double) (i + 1) / count);
+  }
+  utility_file_close(cdf_file, cdf_path);
+}
+
+/* In open-loop mode, the CDF is that of the latencies since the RTTs
+   omit the time a late request has waited for its release */
+static void report_rtt(const char *transport, const struct request_latency *rtt,
+                       unsigned long rtt_count, int open_loop,
+                       const char *cdf_path)
+{
+  unsigned long long *ns = malloc(sizeof(*ns) * (rtt_count + 1));
+  char name[32];
+  unsigned long i;
+
+  if (ns == NULL) {
+    log_error("Insufficient memory to report %lu round-trip times",
+              rtt_count);
+    return;
+  }
+
+  for (i = 0; i < rtt_count; i++) {
+    ns[i] = rtt[i].ns;
+  }
+  snprintf(name, sizeof(name), "rtt_%s", transport);
+  report_distribution(name, ns, rtt_count, open_loop ? NULL : cdf_path);
+
+  if (open_loop) {
+    for (i = 0; i < rtt_count; i++) {
+      ns[i] = rtt[i].latency_ns;
+    }
+    snprintf(name, sizeof(name), "latency_%s", transport);
+    report_distribution(name, ns, rtt_count, cdf_path);
+  }
+
+  free(ns);
+}
+
 static int client_socket = -1;
+static shm_channel *client_channel = NULL;
+static payload_region *client_payloads = NULL;
 static void cleanup(void)
 {
+  if (client_payloads != NULL) {
+    payload_region_destroy(client_payloads);
+  }
+  if (client_channel != NULL) {
+    shm_channel_close(client_channel);
+  }
   if (client_socket != -1) {
     if (close(client_socket) == -1) {
       log_syserror("Cannot close client socket");
@@ -424,6 +739,17 @@ MAIN_BEGIN("client", "stderr", NULL)
     log_syserror("Cannot register fn cleanup at exit");
   }
 
+  /* Acknowledgements are only received using sigtimedwait */
+  {
+    sigset_t ack_signal;
+    sigemptyset(&ack_signal);
+    sigaddset(&ack_signal, SCHED_FIFO_ACK_SIGNAL);
+    if (sigprocmask(SIG_BLOCK, &ack_signal, NULL) != 0) {
+      fatal_syserror("Cannot block SCHED_FIFO acknowledgement signal");
+    }
+  }
+  /* END: Acknowledgements are only received using sigtimedwait */
+
   /* SIGUSR2 is just used to interrupt fn recv to avoid getting stuck */
   {
     struct sigaction act = {
@@ -457,12 +783,71 @@ MAIN_BEGIN("client", "stderr", NULL)
   int iteration_limit = -1;
   int duration_ms = -1;
   const char *stats_file_path = NULL;
+  const char *rtt_cdf_path = NULL;
+  const char *request_log_path = NULL;
+  const char *arrival_spec = NULL;
+  unsigned long long arrival_seed = 1;
+  int arrival_seed_given = 0;
+  const char *trace_path = NULL;
+  enum bwi_backend bwi_backend = BWI_BACKEND_AUTO;
+  int bwi_backend_given = 0;
+  int use_shm = 0;
+  int batch_size = 1;
+  long payload_size = 0;
+  int zero_copy = 0;
   {
     int optchar;
     opterr = 0;
-    while ((optchar = getopt(argc, argv, ":hl:v:s:i:r:1:2:3:t:p:q:x:bd:"))
-           != -1) {
+    while ((optchar = getopt(argc, argv, ":h" CLIENT_OPTSTRING)) != -1) {
       switch (optchar) {
+      case 'u':
+        payload_size = atol(optarg);
+        if (payload_size <= 0) {
+          fatal_error("PAYLOAD_SIZE must be at least 1 (-h for help)");
+        }
+        break;
+      case 'z':
+        zero_copy = 1;
+        break;
+      case 'm':
+        if (strcasecmp("shm", optarg) == 0) {
+          use_shm = 1;
+        } else if (strcasecmp("udp", optarg) == 0) {
+          use_shm = 0;
+        } else {
+          fatal_error("TRANSPORT must be either UDP or SHM (-h for help)");
+        }
+        break;
+      case 'o':
+        rtt_cdf_path = optarg;
+        break;
+      case 'g':
+        request_log_path = optarg;
+        break;
+      case 'a':
+        arrival_spec = optarg;
+        break;
+      case 'j':
+        trace_path = optarg;
+        break;
+      case 'n':
+        if (bwi_backend_parse(optarg, &bwi_backend) != 0) {
+          fatal_error("BWI_BACKEND must be either auto, legacy, emulated"
+                      " or none (-h for help)");
+        }
+        bwi_backend_given = 1;
+        break;
+      case 'e':
+        arrival_seed = strtoull(optarg, NULL, 0);
+        arrival_seed_given = 1;
+        break;
+      case 'k':
+        batch_size = atoi(optarg);
+        if (batch_size < 1 || batch_size > BATCH_SIZE_MAX) {
+          fatal_error("BATCH_SIZE must be between 1 and %d (-h for help)",
+                      BATCH_SIZE_MAX);
+        }
+        break;
       case 'd':
         offset_ms = atoi(optarg);
         if (offset_ms < 0) {
@@ -538,10 +923,20 @@ MAIN_BEGIN("client", "stderr", NULL)
         printf("Usage: %s -1 PROLOGUE_DURATION -2 EXPECTED_SERVICE_TIME\n"
                "       -3 EPILOGUE_DURATION -t PERIOD -p SERVER_PORT\n"
                "       -s STATS_FILE_PATH -v SERVER_PID -x DURATION\n"
-               "       [-i ITERATION] [-b] [-r NTH_ITERATION [-l LIMIT]]\n"
-               "       [-q BUDGET] [-d OFFSET]\n"
+               "       [-i ITERATION] [-b [-n BWI_BACKEND]]\n"
+               "       [-r NTH_ITERATION [-l LIMIT]]\n"
+               "       [-q BUDGET] [-d OFFSET] [-m TRANSPORT] [-o RTT_CDF_PATH]\n"
+               "       [-k BATCH_SIZE] [-g REQUEST_LOG_PATH]\n"
+               "       [-a ARRIVAL [-e SEED]] [-j TRACE_PATH]\n"
+               "       [-u PAYLOAD_SIZE [-z]]\n"
                "\n"
                "This client periodically sends a message to a local UDP port.\n"
+               "When this program exits, the distribution of the round-trip\n"
+               "times of the requests is printed in stdout in the format:\n"
+               "rtt_TRANSPORT (ns): n=N min=MIN p50=P50 p90=P90 p99=P99\n"
+               "p99.9=P999 max=MAX\n"
+               "In open-loop mode (-a), the distribution of the latencies is\n"
+               "additionally printed in the same format as latency_TRANSPORT.\n"
                "In each period, the client will do processing for the given\n"
                "prologue duration before sending a request to the server.\n"
                "After sending the request, this client will block waiting\n"
@@ -575,7 +970,18 @@ MAIN_BEGIN("client", "stderr", NULL)
                "-i ITERATION is the number of prologue-service-epilogue\n"
                "   cycles to be performed before this client exits.\n"
                "-b is specified when this client should give its bandwidth\n"
-               "   to the server (the kernel must support BWI syscalls).\n"
+               "   to the server while waiting for the responses.\n"
+               "-n BWI_BACKEND is the mechanism used by -b: legacy (syscalls\n"
+               "   344 and 345 of the patched SCHED_DEADLINE kernel),\n"
+               "   emulated (scheduling the server using the SCHED_DEADLINE\n"
+               "   parameters of this client through sched_setattr) or none\n"
+               "   (the baseline doing nothing). If -n is not specified,\n"
+               "   BWI_BACKEND will be set to auto, which selects legacy on\n"
+               "   the patched kernel and emulated otherwise. The overhead of\n"
+               "   giving and revoking the bandwidth is printed in stdout when\n"
+               "   this program exits in the format:\n"
+               "   bwi_OPERATION_BACKEND (ns): n=N refused=R mean=MEAN max=MAX\n"
+               "   where R is the number of times the kernel refuses BWI.\n"
                "-r NTH_ITERATION is used to start ftrace at the beginning of\n"
                "   the n-th period if n > 0, and to stop ftrace at the end of\n"
                "   the epilogue in that period unless LIMIT is given in which\n"
@@ -597,8 +1003,65 @@ MAIN_BEGIN("client", "stderr", NULL)
                "   EPILOGUE_DURATION.\n"
                "-d OFFSET is the time to delay the first arrival of the\n"
                "   client job after the client task is started. If -d is\n"
-               "   not specified, OFFSET will be set to 0.",
-               prog_name);
+               "   not specified, OFFSET will be set to 0.\n"
+               "-m TRANSPORT is either UDP (the default) or SHM. When SHM\n"
+               "   is given, the request is sent through the shared memory\n"
+               "   channel of the server named after SERVER_PORT, which the\n"
+               "   server must have created using the same option.\n"
+               "-o RTT_CDF_PATH is the path to the file to store the CDF of\n"
+               "   the round-trip times as a gnuplot data file whose first\n"
+               "   column is the round-trip time in nanosecond and whose\n"
+               "   second column is the cumulative probability.\n"
+               "-k BATCH_SIZE is the number of requests, at most 64, that\n"
+               "   are sent back-to-back in each period before collecting\n"
+               "   their responses so that BATCH_SIZE requests are\n"
+               "   outstanding at once. EXPECTED_SERVICE_TIME then covers\n"
+               "   the whole batch. If -k is not specified, BATCH_SIZE will\n"
+               "   be set to 1.\n"
+               "-g REQUEST_LOG_PATH is the path to the file to store the\n"
+               "   round-trip time of each request in nanosecond together\n"
+               "   with its job number, which matches that in\n"
+               "   STATS_FILE_PATH, and its index in the batch. In open-loop\n"
+               "   mode, the latency is stored in an additional column.\n"
+               "-a ARRIVAL turns this client into an open-loop load\n"
+               "   generator releasing a job at each arrival of the given\n"
+               "   process instead of periodically. The arrivals do not wait\n"
+               "   for the completion of the previous job, and the latency\n"
+               "   of a request is measured from the intended release of its\n"
+               "   job so that the time a late job spends waiting for the\n"
+               "   previous one is not omitted. PERIOD is then only the CBS\n"
+               "   period and the relative deadline, and RTT_CDF_PATH stores\n"
+               "   the CDF of the latencies. ARRIVAL is one of:\n"
+               "   poisson:MEAN\n"
+               "   mmpp:MEAN_1:SOJOURN_1,MEAN_2:SOJOURN_2[,...]\n"
+               "   trace:PATH\n"
+               "   where MEAN is a mean inter-arrival time, SOJOURN is the\n"
+               "   mean time spent in a state of the Markov-modulated\n"
+               "   Poisson process (bursty arrivals), both in microsecond,\n"
+               "   and PATH is a file listing one arrival time per line in\n"
+               "   microsecond since the first release.\n"
+               "-e SEED seeds the arrival process so that the same SEED gives\n"
+               "   the same arrivals. If -e is not specified, SEED will be\n"
+               "   set to 1.\n"
+               "-j TRACE_PATH is the path to the file to store the time at\n"
+               "   which each request is sent and its response is received.\n"
+               "   Each request carries its job number and batch index so\n"
+               "   that the traces of this client and of the servers can be\n"
+               "   merged using merge_request_traces to break the round-trip\n"
+               "   time of each job down into the time spent in each hop.\n"
+               "-u PAYLOAD_SIZE is the size in byte of the payload that\n"
+               "   this client fills in and attaches to each request. The\n"
+               "   payload is copied into the request, which the server\n"
+               "   sends back as the response, so that a payload larger\n"
+               "   than %d bytes needs SHM as the TRANSPORT. The server\n"
+               "   must be given a PAYLOAD_SIZE_MAX at least as large.\n"
+               "-z passes the payload by reference: each payload is filled\n"
+               "   in place in a shared memory region of this client, and\n"
+               "   only its descriptor is sent, which the server resolves\n"
+               "   to read the payload in place.\n",
+               prog_name,
+               UDP_MSG_SIZE_MAX - (int) (sizeof(request_trace_id)
+                                         + sizeof(payload_desc)));
         return EXIT_SUCCESS;
       case '?':
         fatal_error("Unrecognized option character -%c", optopt);
@@ -647,6 +1110,15 @@ MAIN_BEGIN("client", "stderr", NULL)
   if (server_pid == -1) {
     fatal_error("-v must be specified (-h for help)");
   }
+  if (bwi_backend_given && !use_bwi) {
+    fatal_error("-n must only be used when -b is set (-h for help)");
+  }
+  if (arrival_seed_given && arrival_spec == NULL) {
+    fatal_error("-e must only be used when -a is set (-h for help)");
+  }
+  if (zero_copy && payload_size == 0) {
+    fatal_error("-z must only be used when -u is set (-h for help)");
+  }
   if (ftrace_iteration == -1 && limit != -1) {
     fatal_error("-l must only be used when -r is set (-h for help)");
   } else if (ftrace_iteration == 0 && limit == -1) {
@@ -659,6 +1131,19 @@ MAIN_BEGIN("client", "stderr", NULL)
     iteration_limit = ftrace_iteration + limit - 1;
   }
 
+  /* Prepare arrivals */
+  arrival_process *arrivals = NULL;
+  unsigned long job_capacity = duration_ms / period_ms;
+  if (arrival_spec != NULL) {
+    if (arrival_create(arrival_spec, arrival_seed, &arrivals) != 0) {
+      fatal_error("Invalid ARRIVAL (-h for help)");
+    }
+    /* Leave room for the fluctuation of a random process */
+    job_capacity = 2 * arrival_expected_count(arrivals,
+                                              duration_ms * 1000000ULL) + 64;
+  }
+  /* END: Prepare arrivals */
+
   /* Prepare for tracing */
   if (ftrace_iteration != -1) {
     ftrace_file = utility_file_open_for_writing(ftrace_path);
@@ -677,7 +1162,7 @@ MAIN_BEGIN("client", "stderr", NULL)
   /* END: Prepare for tracing */
 
   /* Prepare UDP connection */
-  {
+  if (!use_shm) {
     client_socket = socket(AF_INET, SOCK_DGRAM, 0);
     if (client_socket == -1) {
       fatal_syserror("Cannot create client UDP socket");
@@ -690,9 +1175,94 @@ MAIN_BEGIN("client", "stderr", NULL)
   }
   /* END: Prepare UDP connection */
 
+  /* Prepare shm channel */
+  if (use_shm) {
+    char name[64];
+
+    int rc, counter = 500;
+
+    /* The server may still be creating its channel */
+    snprintf(name, sizeof(name), SHM_CHANNEL_NAME_FMT, server_port);
+    while ((rc = shm_channel_open(name, &client_channel)) == -1
+           && counter != 0) {
+      usleep(1000);
+      counter--;
+    }
+    if (rc == -1) {
+      fatal_error("Server %d does not serve shm channel %s after 500 ms or is"
+                  " already serving another client", server_pid, name);
+    } else if (rc != 0) {
+      fatal_error("Cannot open shm channel %s", name);
+    }
+
+    /* Otherwise, the client and the server may block each other on
+       full rings */
+    if (batch_size > shm_channel_slot_count(client_channel)) {
+      fatal_error("BATCH_SIZE cannot exceed %u when TRANSPORT is SHM",
+                  shm_channel_slot_count(client_channel));
+    }
+  }
+  /* END: Prepare shm channel */
+
+  /* Prepare requests */
+  /* Each request carries its ID, which also tells apart the
+     responses of the requests in a batch, followed by the descriptor
+     of its payload, if any, and by the payload itself unless it is
+     passed by reference */
+  char *message_buf, *response_buf;
+  size_t message_len = sizeof(request_trace_id);
+  size_t match_len = message_len;
+  struct timespec t_sent[BATCH_SIZE_MAX];
+  if (payload_size != 0) {
+    match_len += sizeof(payload_desc);
+    message_len = match_len + (zero_copy ? 0 : payload_size);
+    if (zero_copy && payload_region_create(batch_size, payload_size,
+                                           &client_payloads) != 0) {
+      fatal_error("Cannot create the payload region");
+    }
+  }
+  if (use_shm && message_len > shm_channel_msg_size_max(client_channel)) {
+    fatal_error("A request of %zu bytes exceeds the PAYLOAD_SIZE_MAX of"
+                " server %d", message_len, server_pid);
+  } else if (!use_shm && message_len > UDP_MSG_SIZE_MAX) {
+    fatal_error("A request of %zu bytes cannot be sent through UDP; use SHM"
+                " as the TRANSPORT or -z (-h for help)", message_len);
+  }
+  /* Allocated and touched here since the memory is locked */
+  message_buf = calloc(batch_size, message_len);
+  response_buf = calloc(1, message_len);
+  if (message_buf == NULL || response_buf == NULL) {
+    fatal_error("Insufficient memory for %d requests of %zu bytes",
+                batch_size, message_len);
+  }
+  memset(message_buf, 0, batch_size * message_len);
+  memset(response_buf, 0, message_len);
+  {
+    int i;
+    for (i = 0; i < batch_size; i++) {
+      request_trace_id *id = (request_trace_id *) (message_buf
+                                                   + i * message_len);
+      id->magic = REQUEST_TRACE_ID_MAGIC;
+      id->client = getpid();
+      id->job = 0; /* Set by each job */
+      id->request = i;
+
+      if (payload_size != 0) {
+        payload_desc *desc = (payload_desc *) (id + 1);
+        if (zero_copy) {
+          payload_region_describe(client_payloads, i, payload_size, desc);
+        } else {
+          desc->magic = PAYLOAD_DESC_MAGIC;
+          desc->owner = 0;
+          desc->offset = 0;
+          desc->size = payload_size;
+        }
+      }
+    }
+  }
+  /* END: Prepare requests */
+
   /* Measure overhead */
-  char message_buf[] = "Hello!";
-  char response_buf[sizeof(message_buf)];
   relative_time *job_stats_overhead;
   relative_time *task_overhead;
   relative_time *overhead = to_utility_time_dyn(0, ms);
@@ -701,7 +1271,7 @@ MAIN_BEGIN("client", "stderr", NULL)
     char t_str[32];
 
     /* Job statistics overhead */
-    if (job_statistics_overhead(0, &job_stats_overhead) != 0) {
+    if (job_statistics_overhead(experiment_cpu, &job_stats_overhead) != 0) {
       fatal_error("Cannot obtain job statistics overhead");
     }
     utility_time_set_gc_manual(job_stats_overhead);
@@ -710,7 +1280,8 @@ MAIN_BEGIN("client", "stderr", NULL)
     /* END: Job statistics overhead */    
 
     /* Task overhead */
-    if (finish_to_start_overhead(0, 0, &task_overhead) != 0) {
+    if (finish_to_start_overhead(experiment_cpu, arrivals != NULL,
+                                 &task_overhead) != 0) {
       fatal_error("Cannot obtain finish to start overhead");
     }
     utility_time_set_gc_manual(task_overhead);
@@ -721,8 +1292,9 @@ MAIN_BEGIN("client", "stderr", NULL)
     /* Communication overhead */
     relative_time *comm_overhead, *comm_real;
     comm_overhead = measure_send_recv_overhead(server_pid, client_socket,
+                                               client_channel,
                                                message_buf, response_buf,
-                                               sizeof(message_buf));
+                                               message_len, batch_size);
     comm_real = to_utility_time_dyn(expected_waiting_ms, ms);
     comm_overhead = utility_time_sub_dyn_gc(comm_overhead, comm_real);
     to_string(comm_overhead, t_str, sizeof(t_str));
@@ -758,7 +1330,7 @@ MAIN_BEGIN("client", "stderr", NULL)
                   );
     }
 
-    rc = create_cpu_busyloop(0, prologue,
+    rc = create_cpu_busyloop(experiment_cpu, prologue,
                              to_utility_time_dyn(search_tolerance_us, us),
                              search_passes,
                              &prologue_busyloop);
@@ -771,7 +1343,7 @@ MAIN_BEGIN("client", "stderr", NULL)
       fatal_error("Cannot create prologue busyloop");
     }
 
-    rc = create_cpu_busyloop(0, epilogue,
+    rc = create_cpu_busyloop(experiment_cpu, epilogue,
                              to_utility_time_dyn(search_tolerance_us, us),
                              search_passes,
                              &epilogue_busyloop);
@@ -794,17 +1366,48 @@ MAIN_BEGIN("client", "stderr", NULL)
     .prologue_busyloop = prologue_busyloop,
     .request = message_buf,
     .response = response_buf,
-    .len = sizeof(message_buf),
+    .len = message_len,
+    .match_len = match_len,
+    .batch_size = batch_size,
+    .payload_size = payload_size,
+    .payloads = client_payloads,
+    .t_sent = t_sent,
     .epilogue_busyloop = epilogue_busyloop,
     .client_socket_ptr = &client_socket,
-    .server_pid = use_bwi ? server_pid : -1,
+    .client_channel = client_channel,
+    .server_pid = server_pid,
+    .bwi = NULL,
     .nth_iteration = 0,
     .stopping_iteration = stopping_iteration,
     .ftrace_iteration = ftrace_iteration,
     .ftrace_iteration_limit = iteration_limit,
     .ftrace_file = ftrace_file,
     .ftrace_response_time_hit = 0,
+    .rtt_capacity = job_capacity * batch_size,
+    .rtt_count = 0,
+    .arrivals = arrivals,
+    .trace = NULL,
   };
+  /* Allocated and touched here since the memory is locked */
+  client_prog_args.rtt = calloc(client_prog_args.rtt_capacity,
+                                sizeof(*client_prog_args.rtt));
+  if (client_prog_args.rtt == NULL) {
+    fatal_error("Insufficient memory to record %lu round-trip times",
+                client_prog_args.rtt_capacity);
+  }
+  memset(client_prog_args.rtt, 0,
+         client_prog_args.rtt_capacity * sizeof(*client_prog_args.rtt));
+  if (trace_path != NULL) {
+    /* Each request is sent and answered once */
+    if (request_trace_create(trace_path, 0,
+                             2 * client_prog_args.rtt_capacity,
+                             &client_prog_args.trace) != 0) {
+      fatal_error("Cannot create request trace %s", trace_path);
+    }
+  }
+  if (use_bwi && bwi_create(bwi_backend, &client_prog_args.bwi) != 0) {
+    fatal_error("Cannot create BWI handle");
+  }
   sigemptyset(&client_prog_args.send_recv_interrupt_mask);
   sigaddset(&client_prog_args.send_recv_interrupt_mask, SIGUSR2);
   utility_time_init(&client_prog_args.next_release);
@@ -841,7 +1444,7 @@ MAIN_BEGIN("client", "stderr", NULL)
     .job_stats_overhead = job_stats_overhead,
     .task_overhead = task_overhead,
     .client_task = NULL,
-    .ringbuf_slot_count = duration_ms / period_ms,
+    .ringbuf_slot_count = job_capacity,
   };
   if ((errno = pthread_create(&client_tid, NULL,
                               client_thread, &client_thread_args)) != 0) {
@@ -864,11 +1467,15 @@ MAIN_BEGIN("client", "stderr", NULL)
   pthread_kill(client_tid, SIGUSR2);
   /* END: Ensure that client_task does not get stuck at fn recv */
 
-  if ((errno = pthread_join(client_tid, NULL)) != 0) {
+  void *client_thread_rc;
+  if ((errno = pthread_join(client_tid, &client_thread_rc)) != 0) {
     fatal_syserror("Cannot join client thread");
   }
 
-  if (client_thread_args.rc != EXIT_SUCCESS) {
+  /* task_stop() cancels an open-loop client waiting for an arrival
+     after its statistics have been flushed */
+  if (client_thread_rc != PTHREAD_CANCELED
+      && client_thread_args.rc != EXIT_SUCCESS) {
     fatal_error("Cannot execute client thread successfully");
   }
   /* END: Launching client task */
@@ -883,12 +1490,40 @@ MAIN_BEGIN("client", "stderr", NULL)
   if (ftrace_file != NULL) {
     utility_file_close(ftrace_file, ftrace_path);
   }
+  if (arrivals != NULL) {
+    arrival_destroy(arrivals);
+  }
+  if (client_prog_args.trace != NULL
+      && request_trace_destroy(client_prog_args.trace) != 0) {
+    log_error("Cannot store request trace %s", trace_path);
+  }
   /* END: Clean-up */
 
   if (client_prog_args.ftrace_response_time_hit != 0) {
     printf("Job #%d\n", client_prog_args.ftrace_response_time_hit);
   }
 
+  if (request_log_path != NULL) {
+    log_rtt(client_prog_args.rtt, client_prog_args.rtt_count,
+            arrival_spec != NULL, request_log_path);
+  }
+  report_rtt(use_shm ? "shm" : "udp", client_prog_args.rtt,
+             client_prog_args.rtt_count, arrival_spec != NULL, rtt_cdf_path);
+  free(client_prog_args.rtt);
+  free(response_buf);
+  free(message_buf);
+
+  if (client_prog_args.bwi != NULL) {
+    int op;
+    for (op = 0; op < BWI_OPERATION_COUNT; op++) {
+      bwi_overhead overhead;
+      bwi_get_overhead(client_prog_args.bwi, op, &overhead);
+      bwi_overhead_print(stdout, bwi_get_backend(client_prog_args.bwi), op,
+                         &overhead);
+    }
+    bwi_destroy(client_prog_args.bwi);
+  }
+
   return EXIT_SUCCESS;
 
 } MAIN_END
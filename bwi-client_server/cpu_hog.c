@@ -20,6 +20,7 @@
 #include <signal.h>
 #include "../utility_experimentation.h"
 #include "../utility_log.h"
+#include "../utility_supervisor.h"
 
 static volatile int terminated = 0;
 static void sighand(int signo)
@@ -38,6 +39,10 @@ MAIN_BEGIN("cpu_hog", "stderr", NULL)
     fatal_syserror("Cannot install SIGTERM handler");
   }
 
+  if (supervisor_notify_ready() != 0) {
+    fatal_error("Cannot notify the driver of the readiness");
+  }
+
   /* Hog the CPU */
   while (!terminated)
     ;
@@ -16,7 +16,12 @@
  *****************************************************************************/
 
 #include <limits.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
 #include <sys/wait.h>
+#include <sys/stat.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -27,8 +32,17 @@
 #include "../utility_experimentation.h"
 #include "../utility_log.h"
 #include "../utility_sched_deadline.h"
-#include "../utility_subprocess.h"
 #include "../utility_file.h"
+#include "../utility_supervisor.h"
+#include "../utility_program_options.h"
+#include "../utility_parallel.h"
+
+/* The maximum time for a program to calibrate its busy loops and to
+   notify its readiness */
+#define READY_TIMEOUT_MS 60000
+/* The maximum time for a program to terminate after SIGTERM before
+   being killed */
+#define STOP_TIMEOUT_MS 5000
 
 struct proc {
   struct proc *next;
@@ -105,58 +119,60 @@ static void procs_free(struct proc_head *head)
   head->last = NULL;
 }
 
-static int procs_kill_and_wait(struct proc_head *head, int signal)
+static int procs_kill(supervisor *sv, struct proc_head *head, int signal)
 {
   struct proc *itr;
   int rc = 0;
-  char pid_buffer[32];
 
   foreach_proc(itr, head) {
     if (itr->proc_id == -1) {
       continue;
     }
 
-    snprintf(pid_buffer, sizeof(pid_buffer), "%d", itr->proc_id);
-    rc += kill_and_wait_proc_fn(itr->proc_id, signal, pid_buffer);
+    rc += supervisor_kill(sv, itr->proc_id, signal);
   }
 
   return rc ? -1 : 0;
 }
 
-static int procs_kill(struct proc_head *head, int signal)
+/* Send SIGTERM to the processes in the given NULL-terminated list of
+   heads and wait for all of them to terminate within STOP_TIMEOUT_MS
+   returning 0 if all of them exit successfully or -1 otherwise */
+static int procs_stop(supervisor *sv, struct proc_head *const *heads)
 {
   struct proc *itr;
-  int rc = 0;
-  char pid_buffer[32];
+  pid_t *proc_ids;
+  int i, proc_count = 0, rc = 0;
 
-  foreach_proc(itr, head) {
-    if (itr->proc_id == -1) {
-      continue;
+  for (i = 0; heads[i] != NULL; i++) {
+    foreach_proc(itr, heads[i]) {
+      proc_count++;
     }
-
-    snprintf(pid_buffer, sizeof(pid_buffer), "%d", itr->proc_id);
-    rc += kill_proc_fn(itr->proc_id, signal, pid_buffer);
+  }
+  if (proc_count == 0) {
+    return 0;
   }
 
-  return rc ? -1 : 0;
-}
-
-static int procs_wait(struct proc_head *head)
-{
-  struct proc *itr;
-  int rc = 0;
-  char pid_buffer[32];
+  proc_ids = malloc(sizeof(*proc_ids) * proc_count);
+  if (proc_ids == NULL) {
+    log_error("No memory to stop the processes");
+    return -1;
+  }
 
-  foreach_proc(itr, head) {
-    if (itr->proc_id == -1) {
-      continue;
+  proc_count = 0;
+  for (i = 0; heads[i] != NULL; i++) {
+    rc = (procs_kill(sv, heads[i], SIGTERM) != 0) ? -1 : rc;
+    foreach_proc(itr, heads[i]) {
+      if (itr->proc_id != -1) {
+        proc_ids[proc_count++] = itr->proc_id;
+      }
     }
-
-    snprintf(pid_buffer, sizeof(pid_buffer), "%d", itr->proc_id);
-    rc += wait_proc_fn(itr->proc_id, pid_buffer);
   }
+  rc = (supervisor_wait_exit(sv, proc_ids, proc_count, STOP_TIMEOUT_MS) != 0
+        ? -1 : rc);
 
-  return rc ? -1 : 0;
+  free(proc_ids);
+  return rc;
 }
 
 static void procs_print_args(const struct proc_head *head)
@@ -191,7 +207,7 @@ static void procs_print_argv(const struct proc_head *head)
 
 static char *find_argv_to_adjust(int target_optchar, struct proc *itr);
 
-static int procs_create(struct proc_head *head)
+static int procs_create(supervisor *sv, struct proc_head *head)
 {
   struct proc *itr;
 
@@ -206,17 +222,17 @@ static int procs_create(struct proc_head *head)
     }
     /* END: Adjust server_client -v subserver_pid */
 
-    itr->proc_id = fork();
+    itr->proc_id = supervisor_spawn(sv, itr->argv);
     if (itr->proc_id == -1) {
-      log_syserror("Cannot fork");
-      return -1;
-    } else if (itr->proc_id == 0) {
-      execv(itr->argv[0], itr->argv);
-      log_syserror("Cannot exec");
       return -1;
     }
 
-    sleep(1);
+    /* Wait for the busy loop calibration before creating the next
+       program so that the calibrations do not disturb each other */
+    if (supervisor_wait_ready(sv, itr->proc_id, READY_TIMEOUT_MS) != 0) {
+      log_error("%s is not ready", itr->argv[0]);
+      return -1;
+    }
   }
 
   return 0;
@@ -330,6 +346,26 @@ static const char *const program_ids[] = {
   "server", "client", "cpu_hog", "cpu_hog_cbs", "hrt_cbs", "server_hog",
   "server_client", NULL
 };
+/* The port offset between two CPUs in the sweep mode */
+#define SWEEP_PORT_STRIDE 10
+/* The options of each program whose argument is a UDP port */
+static const char *const program_port_optchars[] = {
+  "ps", "p", NULL, NULL, NULL, "p", "ps",
+};
+/* The getopt() option strings of the programs without -h */
+static const char *const program_optstrings[] = {
+  SERVER_OPTSTRING, CLIENT_OPTSTRING, "", CPU_HOG_CBS_OPTSTRING,
+  HRT_CBS_OPTSTRING, SERVER_HOG_OPTSTRING, SERVER_OPTSTRING,
+};
+/* The options that the programs require excluding those given by the
+   driver (i.e., -x of CLIENT and HRT_CBS and -v of SERVER_CLIENT and
+   of CLIENT following a SERVER) */
+static const char *const program_required_optchars[] = {
+  SERVER_REQUIRED_OPTCHARS, CLIENT_REQUIRED_OPTCHARS, "",
+  CPU_HOG_CBS_REQUIRED_OPTCHARS, HRT_CBS_REQUIRED_OPTCHARS,
+  SERVER_HOG_REQUIRED_OPTCHARS, SERVER_REQUIRED_OPTCHARS "s",
+};
+#define PROGRAM_COUNT (sizeof(program_optstrings) / sizeof(*program_optstrings))
 static PROC_HEAD(server_procs);
 static PROC_HEAD(client_procs);
 static PROC_HEAD(cpu_hog_procs);
@@ -337,207 +373,630 @@ static PROC_HEAD(cpu_hog_cbs_procs);
 static PROC_HEAD(hrt_cbs_procs);
 static PROC_HEAD(server_hog_procs);
 
+static supervisor *driver_supervisor = NULL;
+
 static void terminate_driver(void)
 {
-  procs_kill_and_wait(&server_procs, SIGKILL);
+  if (driver_supervisor != NULL) {
+    supervisor_destroy(driver_supervisor); /* Kill the remaining ones */
+    driver_supervisor = NULL;
+  }
   procs_free(&server_procs);
-  procs_kill_and_wait(&client_procs, SIGKILL);
   procs_free(&client_procs);
-  procs_kill_and_wait(&cpu_hog_procs, SIGKILL);
   procs_free(&cpu_hog_procs);
-  procs_kill_and_wait(&cpu_hog_cbs_procs, SIGKILL);
   procs_free(&cpu_hog_cbs_procs);
-  procs_kill_and_wait(&hrt_cbs_procs, SIGKILL);
   procs_free(&hrt_cbs_procs);
-  procs_kill_and_wait(&server_hog_procs, SIGKILL);
   procs_free(&server_hog_procs);
 }
 
-struct parse_config_file_prms
+/* Return a malloc'd copy of line in which the argument of every
+   option listed in port_optchars, given either as "-p PORT" or as
+   "-pPORT", is increased by port_offset, or NULL if there is no
+   memory */
+static char *offset_ports(const char *line, const char *port_optchars,
+                          int port_offset)
+{
+  size_t buflen = strlen(line) + 1;
+  /* A port of at least one character grows to at most 11 characters */
+  size_t res_size = buflen + (buflen / 2 + 1) * 11;
+  size_t res_len = 0;
+  char *buffer = malloc(buflen);
+  char *res = malloc(res_size);
+  int is_port_next = 0;
+
+  if (buffer == NULL || res == NULL) {
+    free(buffer);
+    free(res);
+    return NULL;
+  }
+  memcpy(buffer, line, buflen);
+  res[0] = '\0';
+
+  char *tok = strtok(buffer, delimiter);
+  while (tok != NULL) {
+    const char *sep = (res_len == 0) ? "" : " ";
+    if (is_port_next) {
+      res_len += snprintf(res + res_len, res_size - res_len, "%s%d",
+                          sep, atoi(tok) + port_offset);
+      is_port_next = 0;
+    } else if (tok[0] == '-' && tok[1] != '\0'
+               && strchr(port_optchars, tok[1]) != NULL) {
+      if (tok[2] == '\0') {
+        res_len += snprintf(res + res_len, res_size - res_len, "%s%s",
+                            sep, tok);
+        is_port_next = 1;
+      } else {
+        res_len += snprintf(res + res_len, res_size - res_len, "%s-%c%d",
+                            sep, tok[1], atoi(&tok[2]) + port_offset);
+      }
+    } else {
+      res_len += snprintf(res + res_len, res_size - res_len, "%s%s",
+                          sep, tok);
+    }
+
+    tok = strtok(NULL, delimiter);
+  }
+
+  free(buffer);
+  return res;
+}
+
+struct create_proc_prms
 {
   struct proc *preceding_server;
   unsigned long *duration_ms;
   int *ftrace_start;
   int *ftrace_stop;
+  int port_offset;
 };
-static int parse_config_file(const char *line, void *args)
+/* Add a proc running the given program with the given arguments to
+   its list returning 0 if successful or -1 otherwise */
+static int create_proc(struct create_proc_prms *prms, int i,
+                       const char *remaining_line)
 {
-  struct parse_config_file_prms *prms = (struct parse_config_file_prms *) args;
-  char *token;
-  size_t buflen = strlen(line) + 1;
-  char *buffer = malloc(buflen);
-  if (buffer == NULL) {
-    log_error("Not enough memory to allocate buffer\n");
+  char *offset_line = NULL;
+  size_t args_buflen;
+  struct proc *p = proc_new();
+  if (p == NULL) {
+    log_error("Not enough memory to allocate proc node");
     return -1;
   }
-  memcpy(buffer, line, buflen);
-  buffer[buflen - 1] = '\0';
 
-  token = strtok(buffer, delimiter);
-  if (token == NULL || token[0] == '#')
-    goto out;
-
-  int i;
-  for (i = 0; program_ids[i] != NULL; i++) {
-    if (strcasecmp(token, program_ids[i]) == 0) {
-      char *remaining_line;
-      size_t args_buflen;
-      struct proc *p = proc_new();
-      if (p == NULL) {
-        log_error("Not enough memory to allocate proc node");
-        goto error;
-      }
-
-      switch (i) {
-      case SERVER_CLIENT:
-        if (prms->preceding_server == NULL) {
-          log_error("SERVER_CLIENT must be preceeded by at least one SERVER");
-          goto error;
-        }
-        p->subserver_pid = &prms->preceding_server->proc_id;
-        /* No break; SERVER_CLIENT is treated as a SERVER */
-      case SERVER:
-        procs_add(&server_procs, p);
-        prms->preceding_server = p;
-        break;
-      case CLIENT:
-        procs_add(&client_procs, p);
-        if (prms->preceding_server != NULL) {
-          p->server_pid = &prms->preceding_server->proc_id;
-        }
-        p->duration_ms = prms->duration_ms;
-        p->ftrace_start = prms->ftrace_start;
-        p->ftrace_stop = prms->ftrace_stop;
-        break;
-      case CPU_HOG:
-        procs_add(&cpu_hog_procs, p);
-        break;
-      case CPU_HOG_CBS:
-        procs_add(&cpu_hog_cbs_procs, p);
-        break;
-      case HRT_CBS:
-        procs_add(&hrt_cbs_procs, p);
-        p->duration_ms = prms->duration_ms;
-        break;
-      case SERVER_HOG:
-        procs_add(&server_hog_procs, p);
-        break;
-      }
+  switch (i) {
+  case SERVER_CLIENT:
+    if (prms->preceding_server == NULL) {
+      log_error("SERVER_CLIENT must be preceeded by at least one SERVER");
+      proc_free(p);
+      return -1;
+    }
+    p->subserver_pid = &prms->preceding_server->proc_id;
+    /* No break; SERVER_CLIENT is treated as a SERVER */
+  case SERVER:
+    procs_add(&server_procs, p);
+    prms->preceding_server = p;
+    break;
+  case CLIENT:
+    procs_add(&client_procs, p);
+    if (prms->preceding_server != NULL) {
+      p->server_pid = &prms->preceding_server->proc_id;
+    }
+    p->duration_ms = prms->duration_ms;
+    p->ftrace_start = prms->ftrace_start;
+    p->ftrace_stop = prms->ftrace_stop;
+    break;
+  case CPU_HOG:
+    procs_add(&cpu_hog_procs, p);
+    break;
+  case CPU_HOG_CBS:
+    procs_add(&cpu_hog_cbs_procs, p);
+    break;
+  case HRT_CBS:
+    procs_add(&hrt_cbs_procs, p);
+    p->duration_ms = prms->duration_ms;
+    break;
+  case SERVER_HOG:
+    procs_add(&server_hog_procs, p);
+    break;
+  }
 
 #define SNPRINTF_ARGS(fmt_add, ...)                                     \
-      "./%s %s" fmt_add, (i == SERVER_CLIENT                            \
-                          ? program_ids[SERVER]                         \
-                          : program_ids[i]), remaining_line, ## __VA_ARGS__
-
-      remaining_line = token + strlen(token) + 1;
-      if (remaining_line >= buffer + buflen) { /* No remaining part */
-        remaining_line = "";
-      }
+  "./%s %s" fmt_add, (i == SERVER_CLIENT                                \
+                      ? program_ids[SERVER]                             \
+                      : program_ids[i]), remaining_line, ## __VA_ARGS__
+
+  if (prms->port_offset != 0 && program_port_optchars[i] != NULL) {
+    offset_line = offset_ports(remaining_line, program_port_optchars[i],
+                               prms->port_offset);
+    if (offset_line == NULL) {
+      log_error("Not enough memory to offset the ports");
+      goto error;
+    }
+    remaining_line = offset_line;
+  }
 
-      if (i == CLIENT) {
-        if (prms->preceding_server == NULL) {
-          if (prms->ftrace_start != NULL && prms->ftrace_stop != NULL) {
-            args_buflen = snprintf(NULL, 0,
-                                   SNPRINTF_ARGS(" -x %lu -r %d -l %d",
-                                                 ULONG_MAX, INT_MAX,
-                                                 INT_MAX)) + 1;
-          } else {
-            args_buflen = snprintf(NULL, 0,
-                                   SNPRINTF_ARGS(" -x %lu", ULONG_MAX)) + 1;
-          }
-        } else {
-          if (prms->ftrace_start != NULL && prms->ftrace_stop != NULL) {
-            args_buflen = snprintf(NULL, 0,
-                                   SNPRINTF_ARGS(" -v %d -x %lu -r %d -l %d",
-                                                 INT_MAX, ULONG_MAX,
-                                                 INT_MAX, INT_MAX)) + 1;
-          } else {
-            args_buflen = snprintf(NULL, 0,
-                                   SNPRINTF_ARGS(" -v %d -x %lu",
-                                                 INT_MAX, ULONG_MAX)) + 1;
-          }
-        }
-      } else if (i == HRT_CBS) {
+  if (i == CLIENT) {
+    if (prms->preceding_server == NULL) {
+      if (prms->ftrace_start != NULL && prms->ftrace_stop != NULL) {
+        args_buflen = snprintf(NULL, 0,
+                               SNPRINTF_ARGS(" -x %lu -r %d -l %d",
+                                             ULONG_MAX, INT_MAX,
+                                             INT_MAX)) + 1;
+      } else {
         args_buflen = snprintf(NULL, 0,
                                SNPRINTF_ARGS(" -x %lu", ULONG_MAX)) + 1;
-      } else if (i == SERVER_CLIENT) {
+      }
+    } else {
+      if (prms->ftrace_start != NULL && prms->ftrace_stop != NULL) {
         args_buflen = snprintf(NULL, 0,
-                               SNPRINTF_ARGS(" -v %d", INT_MAX)) + 1;
+                               SNPRINTF_ARGS(" -v %d -x %lu -r %d -l %d",
+                                             INT_MAX, ULONG_MAX,
+                                             INT_MAX, INT_MAX)) + 1;
       } else {
-        args_buflen = snprintf(NULL, 0, SNPRINTF_ARGS("")) + 1;
+        args_buflen = snprintf(NULL, 0,
+                               SNPRINTF_ARGS(" -v %d -x %lu",
+                                             INT_MAX, ULONG_MAX)) + 1;
       }
+    }
+  } else if (i == HRT_CBS) {
+    args_buflen = snprintf(NULL, 0,
+                           SNPRINTF_ARGS(" -x %lu", ULONG_MAX)) + 1;
+  } else if (i == SERVER_CLIENT) {
+    args_buflen = snprintf(NULL, 0,
+                           SNPRINTF_ARGS(" -v %d", INT_MAX)) + 1;
+  } else {
+    args_buflen = snprintf(NULL, 0, SNPRINTF_ARGS("")) + 1;
+  }
 
-      p->args = malloc(args_buflen);
-      if (p->args == NULL) {
-        log_error("Not enough memory to allocate proc args");
-        goto error;
-      }
+  p->args = malloc(args_buflen);
+  if (p->args == NULL) {
+    log_error("Not enough memory to allocate proc args");
+    goto error;
+  }
 
-      if (i == CLIENT) {
-        if (prms->preceding_server == NULL) {
-          if (prms->ftrace_start != NULL && prms->ftrace_stop != NULL) {
-            args_buflen = snprintf(p->args, args_buflen,
-                                   SNPRINTF_ARGS(" -x %lu -r %d -l %d",
-                                                 ULONG_MAX, INT_MAX,
-                                                 INT_MAX)) + 1;
-          } else {
-            args_buflen = snprintf(p->args, args_buflen,
-                                   SNPRINTF_ARGS(" -x %lu", ULONG_MAX)) + 1;
-          }
-        } else {
-          if (prms->ftrace_start != NULL && prms->ftrace_stop != NULL) {
-            args_buflen = snprintf(p->args, args_buflen,
-                                   SNPRINTF_ARGS(" -v %d -x %lu -r %d -l %d",
-                                                 INT_MAX, ULONG_MAX,
-                                                 INT_MAX, INT_MAX)) + 1;
-          } else {
-            args_buflen = snprintf(p->args, args_buflen,
-                                   SNPRINTF_ARGS(" -v %d -x %lu",
-                                                 INT_MAX, ULONG_MAX)) + 1;
-          }
-        }
-      } else if (i == HRT_CBS) {
+  if (i == CLIENT) {
+    if (prms->preceding_server == NULL) {
+      if (prms->ftrace_start != NULL && prms->ftrace_stop != NULL) {
+        args_buflen = snprintf(p->args, args_buflen,
+                               SNPRINTF_ARGS(" -x %lu -r %d -l %d",
+                                             ULONG_MAX, INT_MAX,
+                                             INT_MAX)) + 1;
+      } else {
         args_buflen = snprintf(p->args, args_buflen,
                                SNPRINTF_ARGS(" -x %lu", ULONG_MAX)) + 1;
-      } else if (i == SERVER_CLIENT) {
+      }
+    } else {
+      if (prms->ftrace_start != NULL && prms->ftrace_stop != NULL) {
         args_buflen = snprintf(p->args, args_buflen,
-                               SNPRINTF_ARGS(" -v %d", INT_MAX)) + 1;
+                               SNPRINTF_ARGS(" -v %d -x %lu -r %d -l %d",
+                                             INT_MAX, ULONG_MAX,
+                                             INT_MAX, INT_MAX)) + 1;
       } else {
-        args_buflen = snprintf(p->args, args_buflen, SNPRINTF_ARGS("")) + 1;
+        args_buflen = snprintf(p->args, args_buflen,
+                               SNPRINTF_ARGS(" -v %d -x %lu",
+                                             INT_MAX, ULONG_MAX)) + 1;
       }
+    }
+  } else if (i == HRT_CBS) {
+    args_buflen = snprintf(p->args, args_buflen,
+                           SNPRINTF_ARGS(" -x %lu", ULONG_MAX)) + 1;
+  } else if (i == SERVER_CLIENT) {
+    args_buflen = snprintf(p->args, args_buflen,
+                           SNPRINTF_ARGS(" -v %d", INT_MAX)) + 1;
+  } else {
+    args_buflen = snprintf(p->args, args_buflen, SNPRINTF_ARGS("")) + 1;
+  }
 #undef SNPRINTF_ARGS
 
+  free(offset_line);
+  return 0;
+
+ error:
+  free(offset_line);
+  return -1;
+}
+
+/* Plan section */
+/* A plan is a config file that has been validated and stored as a
+   single block of memory in a plan file so that loading it takes a
+   single read and only a consistency check instead of revalidating
+   every line. The block consists of a plan_header, header.proc_count
+   plan_proc structures in the order of the config file, and the
+   NUL-terminated argument lines of the programs. Only the validated
+   text is cached: the argument lines are still split when the
+   programs are created and parsed by the programs themselves, and the
+   reservations and durations in them are not recorded as fields. */
+#define PLAN_MAGIC "BWIPLAN"
+#define PLAN_VERSION 1
+
+struct plan_header
+{
+  char magic[sizeof(PLAN_MAGIC)];
+  uint32_t version;
+  uint32_t size; /* Of the whole plan in bytes */
+  uint32_t proc_count;
+  uint32_t duration_ms; /* 0 if not recorded */
+  uint32_t budget_period_ms; /* 0 if not recorded */
+};
+
+struct plan_proc
+{
+  uint32_t program; /* The index of program_ids */
+  uint32_t args_offset; /* From the start of the plan */
+};
+
+static inline struct plan_proc *plan_procs(struct plan_header *plan)
+{
+  return (struct plan_proc *) (plan + 1);
+}
+
+struct plan_builder
+{
+  struct plan_proc *procs; /* args_offset is from the start of args */
+  uint32_t proc_count;
+  char *args;
+  size_t args_len;
+  int has_server; /* A SERVER or SERVER_CLIENT has been added */
+};
+
+/* Check the arguments of a program against its options the way
+   getopt() would do before the program is created returning 0 if
+   they are valid or -1 otherwise */
+static int validate_args(int program, const char *args, int has_server)
+{
+  const char *optstring = program_optstrings[program];
+  const char *required;
+  char seen[UCHAR_MAX + 1];
+  char *optchar;
+  int rc = 0;
+  char *buffer = strdup(args);
+  if (buffer == NULL) {
+    log_error("Not enough memory to validate the arguments");
+    return -1;
+  }
+  memset(seen, 0, sizeof(seen));
+
+  char *tok = strtok(buffer, delimiter);
+  while (tok != NULL && rc == 0) {
+    if (tok[0] != '-' || tok[1] == '\0') {
+      log_error("%s takes no non-option argument '%s'",
+                program_ids[program], tok);
+      rc = -1;
+      break;
+    }
+
+    /* Several options without argument can be grouped like -zR */
+    for (optchar = &tok[1]; *optchar != '\0'; optchar++) {
+      const char *spec = strchr(optstring, *optchar);
+      if (*optchar == ':' || spec == NULL) {
+        log_error("%s has no option -%c", program_ids[program], *optchar);
+        rc = -1;
+        break;
+      }
+      seen[(unsigned char) *optchar] = 1;
+
+      if (spec[1] == ':') {
+        if (optchar[1] == '\0' && strtok(NULL, delimiter) == NULL) {
+          log_error("Option -%c of %s needs an argument",
+                    *optchar, program_ids[program]);
+          rc = -1;
+        }
+        break;
+      }
+    }
+
+    tok = strtok(NULL, delimiter);
+  }
+  free(buffer);
+
+  if (rc != 0) {
+    return rc;
+  }
+
+  for (required = program_required_optchars[program]; *required != '\0';
+       required++) {
+    if (!seen[(unsigned char) *required]) {
+      log_error("Option -%c of %s must be specified",
+                *required, program_ids[program]);
+      rc = -1;
+    }
+  }
+  if (program == CLIENT && !has_server && !seen['v']) {
+    log_error("Option -v of client must be specified when no server"
+              " precedes it");
+    rc = -1;
+  }
+
+  return rc;
+}
+
+/* Validate a line of a config file and add it to the plan being built
+   returning 0 if successful or -1 otherwise */
+static int plan_add_line(char *line, struct plan_builder *builder)
+{
+  size_t line_len = strlen(line);
+  char *token = strtok(line, delimiter);
+  const char *remaining_line;
+  int i;
+
+  if (token == NULL || token[0] == '#') {
+    return 0;
+  }
+
+  for (i = 0; program_ids[i] != NULL; i++) {
+    if (strcasecmp(token, program_ids[i]) == 0) {
       break;
     }
   }
   if (program_ids[i] == NULL) {
     log_error("Unrecognized program ID '%s'", token);
-    goto error;
+    return -1;
+  }
+  if (i == SERVER_CLIENT && !builder->has_server) {
+    log_error("SERVER_CLIENT must be preceeded by at least one SERVER");
+    return -1;
+  }
+
+  remaining_line = token + strlen(token) + 1;
+  if (remaining_line > line + line_len) { /* No remaining part */
+    remaining_line = "";
+  }
+  if (validate_args(i, remaining_line, builder->has_server) != 0) {
+    return -1;
+  }
+  if (i == SERVER || i == SERVER_CLIENT) {
+    builder->has_server = 1;
+  }
+
+  /* Append */
+  size_t args_len = strlen(remaining_line) + 1;
+  struct plan_proc *procs = realloc(builder->procs,
+                                    (sizeof(*procs)
+                                     * (builder->proc_count + 1)));
+  if (procs == NULL) {
+    log_error("Not enough memory to add a program to the plan");
+    return -1;
+  }
+  builder->procs = procs;
+  char *args = realloc(builder->args, builder->args_len + args_len);
+  if (args == NULL) {
+    log_error("Not enough memory to add a program to the plan");
+    return -1;
+  }
+  builder->args = args;
+
+  procs[builder->proc_count].program = i;
+  procs[builder->proc_count].args_offset = builder->args_len;
+  builder->proc_count++;
+  memcpy(&args[builder->args_len], remaining_line, args_len);
+  builder->args_len += args_len;
+  /* END: Append */
+
+  return 0;
+}
+
+/* Compile the given content of a config file into a malloc'd plan
+   returning 0 if successful or -1 otherwise */
+static int plan_compile(char *text, const char *path,
+                        struct plan_header **res)
+{
+  struct plan_builder builder;
+  struct plan_header *plan;
+  char *line = text, *next_line;
+  int line_no = 1, rc = -1;
+  uint32_t i;
+
+  memset(&builder, 0, sizeof(builder));
+  while (line != NULL) {
+    next_line = strchr(line, '\n');
+    if (next_line != NULL) {
+      *next_line++ = '\0';
+    }
+    if (plan_add_line(line, &builder) != 0) {
+      log_error("Invalid line %d of %s", line_no, path);
+      goto out;
+    }
+    line = next_line;
+    line_no++;
+  }
+
+  size_t procs_size = sizeof(*builder.procs) * builder.proc_count;
+  size_t size = sizeof(*plan) + procs_size + builder.args_len;
+  if (size > UINT32_MAX) {
+    log_error("%s is too large", path);
+    goto out;
+  }
+  plan = malloc(size);
+  if (plan == NULL) {
+    log_error("Not enough memory to compile %s", path);
+    goto out;
+  }
+
+  memset(plan, 0, sizeof(*plan));
+  memcpy(plan->magic, PLAN_MAGIC, sizeof(plan->magic));
+  plan->version = PLAN_VERSION;
+  plan->size = size;
+  plan->proc_count = builder.proc_count;
+  memcpy(plan_procs(plan), builder.procs, procs_size);
+  for (i = 0; i < plan->proc_count; i++) {
+    plan_procs(plan)[i].args_offset += sizeof(*plan) + procs_size;
+  }
+  if (builder.args_len != 0) {
+    memcpy((char *) plan + sizeof(*plan) + procs_size, builder.args,
+           builder.args_len);
   }
 
+  *res = plan;
+  rc = 0;
+
  out:
-  free(buffer);
+  free(builder.procs);
+  free(builder.args);
+  return rc;
+}
+
+/* Check that the given plan of the given size can be used safely
+   returning 0 if it can or -1 otherwise */
+static int plan_check(struct plan_header *plan, size_t size, const char *path)
+{
+  size_t args_start;
+  uint32_t i;
+
+  if (plan->version != PLAN_VERSION) {
+    log_error("%s is compiled by another version of this driver;"
+              " recompile it", path);
+    return -1;
+  }
+  if (plan->size != size) {
+    log_error("%s is truncated", path);
+    return -1;
+  }
+  if (plan->proc_count > ((size - sizeof(*plan))
+                          / sizeof(struct plan_proc))) {
+    log_error("%s is corrupted", path);
+    return -1;
+  }
+
+  args_start = sizeof(*plan) + sizeof(struct plan_proc) * plan->proc_count;
+  if (plan->proc_count != 0 && ((char *) plan)[size - 1] != '\0') {
+    log_error("%s is corrupted", path);
+    return -1;
+  }
+  for (i = 0; i < plan->proc_count; i++) {
+    const struct plan_proc *proc = &plan_procs(plan)[i];
+    if (proc->program >= PROGRAM_COUNT
+        || proc->args_offset < args_start || proc->args_offset >= size) {
+      log_error("%s is corrupted", path);
+      return -1;
+    }
+  }
+
   return 0;
+}
 
- error:
+/* Load a malloc'd plan from either a config file or a plan file
+   returning 0 if successful or -1 otherwise */
+static int plan_load(const char *path, struct plan_header **res)
+{
+  struct stat file_stat;
+  size_t size;
+  char *buffer;
+  FILE *file = utility_file_open_for_reading_bin(path);
+  if (file == NULL) {
+    return -1;
+  }
+
+  if (fstat(fileno(file), &file_stat) != 0) {
+    log_syserror("Cannot get the size of %s", path);
+    utility_file_close(file, path);
+    return -1;
+  }
+  size = file_stat.st_size;
+  buffer = malloc(size + 1);
+  if (buffer == NULL) {
+    log_error("Not enough memory to read %s", path);
+    utility_file_close(file, path);
+    return -1;
+  }
+  if (size != 0) {
+    size_t len = size;
+    if (utility_file_read_bin(file, buffer, &len) != 0) {
+      log_error("Cannot completely read %s", path);
+      free(buffer);
+      utility_file_close(file, path);
+      return -1;
+    }
+  }
+  utility_file_close(file, path);
+
+  if (size >= sizeof(struct plan_header)
+      && memcmp(buffer, PLAN_MAGIC, sizeof(PLAN_MAGIC)) == 0) {
+    if (plan_check((struct plan_header *) buffer, size, path) != 0) {
+      free(buffer);
+      return -1;
+    }
+    *res = (struct plan_header *) buffer;
+    return 0;
+  }
+
+  buffer[size] = '\0';
+  int rc = plan_compile(buffer, path, res);
   free(buffer);
-  return -1;
+  return rc;
 }
 
+static int plan_save(const struct plan_header *plan, const char *path)
+{
+  FILE *file = utility_file_open_for_writing_bin(path);
+  if (file == NULL) {
+    return -1;
+  }
+
+  if (fwrite(plan, plan->size, 1, file) != 1) {
+    log_syserror("Cannot write %s", path);
+    utility_file_close(file, path);
+    return -1;
+  }
+
+  return utility_file_close(file, path);
+}
+
+static int plan_create_procs(struct plan_header *plan,
+                             struct create_proc_prms *prms)
+{
+  uint32_t i;
+
+  for (i = 0; i < plan->proc_count; i++) {
+    const struct plan_proc *proc = &plan_procs(plan)[i];
+    if (create_proc(prms, proc->program,
+                    (char *) plan + proc->args_offset) != 0) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+/* END: Plan section */
+
 /* END: Procs management section */
 
 /* Command line args section */
 static const char *config_path = NULL;
+static const char *plan_path = NULL;
 static unsigned long int experiment_duration_ms = -1;
 static int cbs_budget_period_ms = -1;
 static int ftrace_start = -1;
 static int ftrace_stop = -1;
-static int parse_cmd_line_args(int argc, char **argv)
+static int port_offset = 0;
+static const char *sweep_cpu_list = NULL;
+
+/* Parse a duration like 60s or 60ms into duration_ms returning 0 if
+   successful or -1 otherwise */
+static int parse_duration(const char *str, unsigned long *duration_ms)
 {
   char *duration_unit;
+
+  *duration_ms = strtoul(str, &duration_unit, 10);
+  if (*duration_ms == 0) {
+    log_error("Experiment duration must be greater than 0 (-h for help)");
+    return -1;
+  }
+
+  if (strcasecmp(duration_unit, "s") == 0) {
+    *duration_ms *= 1000;
+  } else if (strcasecmp(duration_unit, "ms") != 0) {
+    log_error("Experimentation duration must be directly followed by"
+              " either 's' or 'ms' (-h for help)");
+    return -1;
+  }
+
+  return 0;
+}
+
+static int parse_cmd_line_args(int argc, char **argv)
+{
   int optchar;
   opterr = 0;
-  while ((optchar = getopt(argc, argv, ":hr:l:t:f:p:")) != -1) {
+  while ((optchar = getopt(argc, argv, ":hr:l:t:f:w:p:o:c:")) != -1) {
     switch (optchar) {
     case 'r':
       ftrace_start = atoi(optarg);
@@ -563,34 +1022,46 @@ static int parse_cmd_line_args(int argc, char **argv)
     case 'f':
       config_path = optarg;
       break;
-    case 't':
-      experiment_duration_ms = strtoul(optarg, &duration_unit, 10);
-      if (experiment_duration_ms <= 0) {
-        log_error("Experiment duration must be greater than 0 (-h for help)");
+    case 'w':
+      plan_path = optarg;
+      break;
+    case 'o':
+      port_offset = atoi(optarg);
+      if (port_offset < 0) {
+        log_error("-o must be at least 0 (-h for help)");
         return -1;
       }
-
-      if (strcasecmp(duration_unit, "s") == 0) {
-        experiment_duration_ms *= 1000;
-      } else if (strcasecmp(duration_unit, "ms") != 0) {
-        log_error("Experimentation duration must be directly followed by"
-                  " either 's' or 'ms' (-h for help)");
+      break;
+    case 'c':
+      sweep_cpu_list = optarg;
+      break;
+    case 't':
+      if (parse_duration(optarg, &experiment_duration_ms) != 0) {
         return -1;
       }
       break;
     case 'h':
       printf("Usage: %1$s -t DURATION -p BUDGET_PERIOD -f CONFIG_FILE\n"
              "       [-r CLIENT_TRACING_START -l CLIENT_TRACING_LIMIT]\n"
+             "       [-o PORT_OFFSET]\n"
+             "   or: %1$s -t DURATION -p BUDGET_PERIOD -c CPU_LIST\n"
+             "       [-o PORT_OFFSET] CONFIG_FILE[:DURATION]...\n"
+             "   or: %1$s [-t DURATION] [-p BUDGET_PERIOD] -f CONFIG_FILE\n"
+             "       -w PLAN_FILE\n"
              "\n"
              "This is the experiment driver that will create the necessary\n"
-             "programs in the proper order and timing allowing them to\n"
-             "calibrate their busy loops properly, signal them to start at\n"
+             "programs in the proper order, each once the previous one has\n"
+             "calibrated its busy loops and is ready, signal them to start at\n"
              "approximately the same time, and terminate them after a\n"
              "specified duration has elapsed.\n"
              "This driver read a configuration file to create the desired\n"
              "programs having the desired parameters.\n"
              "SIGINT can be used to terminate this program graciously at any\n"
              "time.\n"
+             "The second form is the sweep mode that runs the experiments of\n"
+             "the given config files concurrently, each on its own CPU.\n"
+             "The third form compiles a config file into a plan file that\n"
+             "can be used in place of the config file in the other forms.\n"
              "\n"
              "-r CLIENT_TRACING_START is used to start ftrace at the"
              "   beginning of the n-th period if n > 0, and to stop ftrace at\n"
@@ -634,9 +1105,38 @@ static int parse_cmd_line_args(int argc, char **argv)
              "   nested blocking chain."
              "   Also special for CLIENT and HRT_CBS program ID is that -x\n"
              "   will be forced to have the DURATION value specified to the\n"
-             "   driver using -t",
-             prog_name);
-      return EXIT_SUCCESS;
+             "   driver using -t\n"
+             "   CONFIG_FILE can also be a plan file (see -w).\n"
+             "-w PLAN_FILE makes this driver validate CONFIG_FILE against\n"
+             "   the options of each program and write the result as a\n"
+             "   binary plan to PLAN_FILE without running the experiment.\n"
+             "   DURATION and BUDGET_PERIOD, if given, are recorded in the\n"
+             "   plan so that -t and -p can be omitted when using the plan;\n"
+             "   otherwise, they must be given when using the plan. A plan\n"
+             "   is loaded with a single read without any parsing, which\n"
+             "   makes a large sweep start faster. Since every config file\n"
+             "   is validated before any program is created, an invalid\n"
+             "   config file never starts an experiment.\n"
+             "-o PORT_OFFSET is added to every UDP port given in the config\n"
+             "   file (i.e., -p and -s of SERVER and SERVER_CLIENT and -p of\n"
+             "   CLIENT and SERVER_HOG). This is 0 by default.\n"
+             "-c CPU_LIST enables the sweep mode. CPU_LIST is a comma-\n"
+             "   separated list of CPU IDs and ranges like 1-15,17 of the\n"
+             "   CPUs to run the experiments on; these CPUs should be\n"
+             "   isolated from the rest of the system. Each experiment is\n"
+             "   run by a separate instance of this driver whose programs\n"
+             "   are all bound to one CPU of the list and whose stdout and\n"
+             "   stderr are written to CONFIG_FILE with its .cfg extension\n"
+             "   replaced by .log. The experiments are packed onto the CPUs\n"
+             "   longest first, and the experiment running on the n-th CPU\n"
+             "   of the list (counting from 0) gets PORT_OFFSET + n * %2$d\n"
+             "   as its port offset so that concurrent experiments do not\n"
+             "   collide; thus, the ports in one config file must span less\n"
+             "   than %2$d numbers. The config files must name different\n"
+             "   stats files. A config file directly followed by :DURATION\n"
+             "   overrides -t for that experiment",
+             prog_name, SWEEP_PORT_STRIDE);
+      exit(EXIT_SUCCESS);
     case '?':
       log_error("Unrecognized option -%c (-h for help)", optopt);
       return -1;
@@ -649,16 +1149,25 @@ static int parse_cmd_line_args(int argc, char **argv)
     }
   }
 
-  if (experiment_duration_ms == -1) {
-    log_error("-t must be specified (-h for help)");
+  if (sweep_cpu_list == NULL && config_path == NULL) {
+    log_error("-f must be specified (-h for help)");
     return -1;
   }
-  if (cbs_budget_period_ms == -1) {
-    log_error("-p must be specified (-h for help)");
+  if (sweep_cpu_list != NULL && config_path != NULL) {
+    log_error("-f cannot be used with -c (-h for help)");
     return -1;
   }
-  if (config_path == NULL) {
-    log_error("-f must be specified (-h for help)");
+  if (sweep_cpu_list != NULL && plan_path != NULL) {
+    log_error("-w cannot be used with -c (-h for help)");
+    return -1;
+  }
+  if (sweep_cpu_list != NULL && optind == argc) {
+    log_error("-c needs at least one config file (-h for help)");
+    return -1;
+  }
+  if (sweep_cpu_list != NULL && ftrace_start != -1) {
+    log_error("-r and -l cannot be used with -c because ftrace is"
+              " system-wide (-h for help)");
     return -1;
   }
   if ((ftrace_start != -1 && ftrace_stop == -1)
@@ -671,9 +1180,184 @@ static int parse_cmd_line_args(int argc, char **argv)
 }
 /* END: Command line args section */
 
+/* Sweep section */
+struct sweep_run {
+  const char *config_path;
+  unsigned long duration_ms;
+};
+
+/* Prepare a run from a command line argument CONFIG_FILE[:DURATION]
+   returning 0 if successful or -1 otherwise */
+static int sweep_run_init(char *arg, struct sweep_run *sweep_run,
+                          struct parallel_run *run)
+{
+  char *duration = strrchr(arg, ':');
+  struct plan_header *plan;
+
+  sweep_run->duration_ms = experiment_duration_ms;
+  if (duration != NULL) {
+    *duration = '\0';
+    if (parse_duration(duration + 1, &sweep_run->duration_ms) != 0) {
+      return -1;
+    }
+  }
+  sweep_run->config_path = arg;
+
+  /* Reject an invalid config file before any experiment is started */
+  if (plan_load(sweep_run->config_path, &plan) != 0) {
+    return -1;
+  }
+  if (sweep_run->duration_ms == -1) {
+    if (plan->duration_ms == 0) {
+      log_error("%s needs a duration (-h for help)", sweep_run->config_path);
+      free(plan);
+      return -1;
+    }
+    sweep_run->duration_ms = plan->duration_ms;
+  }
+  if (cbs_budget_period_ms == -1 && plan->budget_period_ms == 0) {
+    log_error("-p must be specified for %s (-h for help)",
+              sweep_run->config_path);
+    free(plan);
+    return -1;
+  }
+
+  run->name = sweep_run->config_path;
+  /* Each program takes about a second to calibrate its busy loops
+     before notifying its readiness */
+  run->cost = sweep_run->duration_ms + plan->proc_count * 1000;
+  run->args = sweep_run;
+
+  free(plan);
+  return 0;
+}
+
+static void sweep_run_exec(const struct parallel_run *run, int cpu, int slot)
+{
+  const struct sweep_run *sweep_run = run->args;
+  char cpu_str[16], duration[32], budget_period[16], offset[16];
+  snprintf(cpu_str, sizeof(cpu_str), "%d", cpu);
+  snprintf(duration, sizeof(duration), "%lums", sweep_run->duration_ms);
+  snprintf(budget_period, sizeof(budget_period), "%d", cbs_budget_period_ms);
+  snprintf(offset, sizeof(offset), "%d",
+           port_offset + slot * SWEEP_PORT_STRIDE);
+
+  /* Redirect the output of the experiment to its own log file */
+  {
+    size_t path_len = strlen(sweep_run->config_path);
+    char *log_path = malloc(path_len + sizeof(".log"));
+    if (log_path == NULL) {
+      log_error("Not enough memory to allocate the log path");
+      _exit(EXIT_FAILURE);
+    }
+    memcpy(log_path, sweep_run->config_path, path_len + 1);
+    if (path_len > 4 && strcmp(&log_path[path_len - 4], ".cfg") == 0) {
+      path_len -= 4;
+    } else if (path_len > 5
+               && strcmp(&log_path[path_len - 5], ".plan") == 0) {
+      path_len -= 5;
+    }
+    strcpy(&log_path[path_len], ".log");
+
+    int log_fd = open(log_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (log_fd == -1) {
+      log_syserror("Cannot open %s", log_path);
+      _exit(EXIT_FAILURE);
+    }
+    if (dup2(log_fd, STDOUT_FILENO) == -1
+        || dup2(log_fd, STDERR_FILENO) == -1) {
+      log_syserror("Cannot redirect the output to %s", log_path);
+      _exit(EXIT_FAILURE);
+    }
+    close(log_fd);
+    free(log_path);
+  }
+  /* END: Redirect the output of the experiment to its own log file */
+
+  /* All programs of the experiment inherit the CPU */
+  if (setenv(EXPERIMENT_CPU_ENV, cpu_str, 1) != 0) {
+    log_syserror("Cannot set %s", EXPERIMENT_CPU_ENV);
+    _exit(EXIT_FAILURE);
+  }
+
+  char *argv[] = {
+    (char *) prog_name, "-t", duration, "-o", offset,
+    "-f", (char *) sweep_run->config_path, "-p", budget_period, NULL
+  };
+  if (cbs_budget_period_ms == -1) { /* Recorded in the plan */
+    argv[7] = NULL;
+  }
+  execv("/proc/self/exe", argv);
+  log_syserror("Cannot exec");
+  _exit(EXIT_FAILURE);
+}
+
+/* Run the experiments on the CPUs longest first using list scheduling
+   so that a CPU picks the next longest experiment as soon as its
+   current experiment finishes. Return EXIT_SUCCESS if every
+   experiment succeeds or EXIT_FAILURE otherwise. */
+static int sweep(int argc, char **argv)
+{
+  int rc = EXIT_FAILURE;
+  unsigned long sequential_ms = 0;
+  struct timespec t_start, t_end;
+  struct sweep_run *sweep_runs;
+  struct parallel_run *runs;
+  int *cpus, cpu_count;
+  int i;
+
+  if (parallel_parse_cpu_list(sweep_cpu_list, &cpus, &cpu_count) != 0) {
+    return EXIT_FAILURE;
+  }
+
+  /* Prepare the runs */
+  sweep_runs = malloc(sizeof(*sweep_runs) * argc);
+  runs = malloc(sizeof(*runs) * argc);
+  if (sweep_runs == NULL || runs == NULL) {
+    log_error("Not enough memory to allocate the runs");
+    goto out;
+  }
+  for (i = 0; i < argc; i++) {
+    if (sweep_run_init(argv[i], &sweep_runs[i], &runs[i]) != 0) {
+      goto out;
+    }
+    int j;
+    for (j = 0; j < i; j++) {
+      if (strcmp(sweep_runs[j].config_path, argv[i]) == 0) {
+        log_error("%s is given more than once", argv[i]);
+        goto out;
+      }
+    }
+    sequential_ms += runs[i].cost;
+  }
+  /* END: Prepare the runs */
+
+  clock_gettime(CLOCK_MONOTONIC, &t_start);
+  if (parallel_schedule(runs, argc, cpus, cpu_count, sweep_run_exec,
+                        stdout) == 0) {
+    rc = EXIT_SUCCESS;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t_end);
+
+  printf("Sweep of %d experiments on %d CPUs took %.1f s"
+         " (about %.1f s sequentially)\n", argc, cpu_count,
+         ((t_end.tv_sec - t_start.tv_sec)
+          + (t_end.tv_nsec - t_start.tv_nsec) / 1e9),
+         sequential_ms / 1000.0);
+
+ out:
+  free(runs);
+  free(sweep_runs);
+  free(cpus);
+  return rc;
+}
+/* END: Sweep section */
+
+/* Once the experiment processes exist, SIGINT is received by the
+   supervisor instead */
 static void sighandler(int signo)
 {
-  terminate_driver();
+  parallel_terminate();
   _exit(EXIT_FAILURE);
 }
 
@@ -688,30 +1372,75 @@ MAIN_BEGIN("bwi-client_server", "stderr", NULL)
   sigaction(SIGINT, &sigact, NULL);
 
   /* Parse command line arguments */
-  if (parse_cmd_line_args(argc, argv) == -1) {
+  int arg_idx = parse_cmd_line_args(argc, argv);
+  if (arg_idx == -1) {
     goto error;
   }  
   /* END: Parse command line arguments */
 
-  /* Parse config file */
+  if (sweep_cpu_list != NULL) {
+    return sweep(argc - arg_idx, argv + arg_idx);
+  }
+
+  /* Load plan */
   {
-    FILE *config_file = utility_file_open_for_reading(config_path);
-    if (config_file == NULL) {
+    struct plan_header *plan;
+    if (plan_load(config_path, &plan) != 0) {
+      goto error;
+    }
+
+    if (plan_path != NULL) {
+      if (experiment_duration_ms != -1) {
+        if (experiment_duration_ms > UINT32_MAX) {
+          log_error("-t is too long to be recorded in a plan");
+          free(plan);
+          goto error;
+        }
+        plan->duration_ms = experiment_duration_ms;
+      }
+      if (cbs_budget_period_ms != -1) {
+        plan->budget_period_ms = cbs_budget_period_ms;
+      }
+      rc = (plan_save(plan, plan_path) != 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+      free(plan);
+      return rc;
+    }
+
+    if (experiment_duration_ms == -1) {
+      experiment_duration_ms = plan->duration_ms;
+    }
+    if (cbs_budget_period_ms == -1) {
+      cbs_budget_period_ms = plan->budget_period_ms;
+    }
+    if (experiment_duration_ms == 0) {
+      log_error("-t must be specified (-h for help)");
+      free(plan);
       goto error;
     }
-    struct parse_config_file_prms args = {
+    if (cbs_budget_period_ms == 0) {
+      log_error("-p must be specified (-h for help)");
+      free(plan);
+      goto error;
+    }
+
+    struct create_proc_prms args = {
       .preceding_server = NULL,
       .duration_ms = &experiment_duration_ms,
       .ftrace_start = ftrace_start == -1 ? NULL : &ftrace_start,
       .ftrace_stop = ftrace_stop == -1 ? NULL : &ftrace_stop,
+      .port_offset = port_offset,
     };
-    if (utility_file_read(config_file, 1024, parse_config_file, &args) != 0) {
-      log_error("Cannot completely parse the config file");
+    if (plan_create_procs(plan, &args) != 0) {
+      free(plan);
       goto error;
     }
-    utility_file_close(config_file, config_path);
+    free(plan);
+  }
+  /* END: Load plan */
+
+  if (supervisor_create(&driver_supervisor) != 0) {
+    goto error;
   }
-  /* END: Parse config file */
 
   /* Create processes */
   if (procs_make_argv(&hrt_cbs_procs) != 0)
@@ -725,20 +1454,20 @@ MAIN_BEGIN("bwi-client_server", "stderr", NULL)
   if (procs_make_argv(&server_procs) != 0)
     goto error;
 
-  if (procs_create(&server_procs) != 0)
+  if (procs_create(driver_supervisor, &server_procs) != 0)
     goto error;
   if (procs_make_argv(&client_procs) != 0)
     goto error;
 
-  if (procs_create(&client_procs) != 0)
+  if (procs_create(driver_supervisor, &client_procs) != 0)
     goto error;
-  if (procs_create(&hrt_cbs_procs) != 0)
+  if (procs_create(driver_supervisor, &hrt_cbs_procs) != 0)
     goto error;
-  if (procs_create(&cpu_hog_cbs_procs) != 0)
+  if (procs_create(driver_supervisor, &cpu_hog_cbs_procs) != 0)
     goto error;
-  if (procs_create(&cpu_hog_procs) != 0)
+  if (procs_create(driver_supervisor, &cpu_hog_procs) != 0)
     goto error;
-  if (procs_create(&server_hog_procs) != 0)
+  if (procs_create(driver_supervisor, &server_hog_procs) != 0)
     goto error;
   /* END: Create processes */
 
@@ -752,43 +1481,44 @@ MAIN_BEGIN("bwi-client_server", "stderr", NULL)
   /* END: Enter SCHED_DEADLINE */
 
   /* Start processes */
-  rc = (procs_kill(&hrt_cbs_procs, SIGUSR1) != 0) ? EXIT_FAILURE : rc;
-  rc = (procs_kill(&cpu_hog_cbs_procs, SIGUSR1) != 0) ? EXIT_FAILURE : rc;
-  rc = (procs_kill(&client_procs, SIGUSR1) != 0) ? EXIT_FAILURE : rc;
+  rc = (procs_kill(driver_supervisor, &hrt_cbs_procs, SIGUSR1) != 0
+        ? EXIT_FAILURE : rc);
+  rc = (procs_kill(driver_supervisor, &cpu_hog_cbs_procs, SIGUSR1) != 0
+        ? EXIT_FAILURE : rc);
+  rc = (procs_kill(driver_supervisor, &client_procs, SIGUSR1) != 0
+        ? EXIT_FAILURE : rc);
   /* END: Start processes */
 
   /* Sleep for the duration of the experiment */
-  usleep(experiment_duration_ms * 1000);
+  switch (supervisor_sleep(driver_supervisor, experiment_duration_ms)) {
+  case 0:
+    break;
+  case -1:
+    if (supervisor_interrupted(driver_supervisor)) {
+      log_error("Interrupted; stopping the experiment");
+    }
+    rc = EXIT_FAILURE;
+    break;
+  default:
+    goto error;
+  }
   /* END: Sleep for the duration of the experiment */
 
   /* Stop processes */
-  rc = (procs_kill(&client_procs, SIGTERM) != 0) ? EXIT_FAILURE : rc;
-  rc = (procs_kill(&cpu_hog_cbs_procs, SIGTERM) != 0) ? EXIT_FAILURE : rc;
-  rc = (procs_kill(&hrt_cbs_procs, SIGTERM) != 0) ? EXIT_FAILURE : rc;
-  rc = (procs_kill(&cpu_hog_procs, SIGTERM) != 0) ? EXIT_FAILURE : rc;
-  rc = (procs_kill(&server_hog_procs, SIGTERM) != 0) ? EXIT_FAILURE : rc;
-  sleep(1);
-  rc = (procs_kill(&server_procs, SIGTERM) != 0) ? EXIT_FAILURE : rc;
-  /* END: Stop processes */
-
-  /* Collect processes */
-  procs_wait(&client_procs);
-  procs_wait(&cpu_hog_cbs_procs);
-  procs_wait(&hrt_cbs_procs);
-  procs_wait(&cpu_hog_procs);
-  procs_wait(&server_hog_procs);
-  procs_wait(&server_procs);
-  /* END: Collect processes */
+  {
+    /* The servers must outlive the processes using them */
+    struct proc_head *const users[] = {
+      &client_procs, &cpu_hog_cbs_procs, &hrt_cbs_procs, &cpu_hog_procs,
+      &server_hog_procs, NULL
+    };
+    struct proc_head *const servers[] = {&server_procs, NULL};
 
-  /* Unnecessary clean-up since we're quitting anyway */
-  procs_free(&server_procs);
-  procs_free(&client_procs);
-  procs_free(&cpu_hog_procs);
-  procs_free(&server_hog_procs);
-  procs_free(&cpu_hog_cbs_procs);
-  procs_free(&hrt_cbs_procs);
-  /* END: Unnecessary clean-up since we're quitting anyway */
+    rc = (procs_stop(driver_supervisor, users) != 0) ? EXIT_FAILURE : rc;
+    rc = (procs_stop(driver_supervisor, servers) != 0) ? EXIT_FAILURE : rc;
+  }
+  /* END: Stop processes */
 
+  terminate_driver();
   return rc;
 
  error:
@@ -0,0 +1,475 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include "../utility_log.h"
+#include "../utility_request_trace.h"
+
+#define HOP_COUNT_MAX 16
+
+enum component {
+  TRANSIT, QUEUEING, PROCESSING, DOWNSTREAM, RETURN, COMPONENT_COUNT,
+};
+static const char *const component_names[] = {
+  "transit", "queueing", "processing", "downstream", "return",
+};
+
+struct source {
+  const char *path;
+  unsigned pid;
+  unsigned port;
+};
+
+struct event {
+  request_trace_record record;
+  unsigned source;
+};
+
+/* The events of a request in a server */
+struct hop {
+  unsigned source;
+  unsigned seen; /* Bit i is set if event i is seen */
+  unsigned long long t[REQUEST_TRACE_EVENT_COUNT];
+};
+
+/* The path of a request from its client through the servers */
+struct request_path {
+  request_trace_id id;
+  unsigned long long t_send;
+  unsigned long long t_response;
+  int hop_count;
+  struct hop hops[HOP_COUNT_MAX];
+  unsigned long long components[HOP_COUNT_MAX][COMPONENT_COUNT];
+};
+
+/* The components of all critical paths at a hop */
+struct hop_stats {
+  unsigned port;
+  unsigned long count;
+  unsigned long capacity;
+  unsigned long long *components[COMPONENT_COUNT];
+};
+
+static struct source *sources;
+static unsigned source_count;
+
+static int compare_events(const void *a, const void *b)
+{
+  const request_trace_record *x = &((const struct event *) a)->record;
+  const request_trace_record *y = &((const struct event *) b)->record;
+
+  if (x->id.client != y->id.client) {
+    return x->id.client < y->id.client ? -1 : 1;
+  }
+  if (x->id.job != y->id.job) {
+    return x->id.job < y->id.job ? -1 : 1;
+  }
+  if (x->id.request != y->id.request) {
+    return x->id.request < y->id.request ? -1 : 1;
+  }
+  if (x->t_ns != y->t_ns) {
+    return x->t_ns < y->t_ns ? -1 : 1;
+  }
+  return x->event < y->event ? -1 : (x->event > y->event ? 1 : 0);
+}
+
+static int compare_hops(const void *a, const void *b)
+{
+  unsigned long long x = ((const struct hop *) a)->t[REQUEST_TRACE_RECEIVE];
+  unsigned long long y = ((const struct hop *) b)->t[REQUEST_TRACE_RECEIVE];
+
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static int compare_ns(const void *a, const void *b)
+{
+  unsigned long long x = *(const unsigned long long *) a;
+  unsigned long long y = *(const unsigned long long *) b;
+
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static int same_request(const request_trace_id *x, const request_trace_id *y)
+{
+  return (x->client == y->client && x->job == y->job
+          && x->request == y->request);
+}
+
+static int same_job(const request_trace_id *x, const request_trace_id *y)
+{
+  return x->client == y->client && x->job == y->job;
+}
+
+static void load_traces(char **paths, unsigned path_count,
+                        struct event **res, unsigned long *res_count)
+{
+  struct event *events = NULL;
+  unsigned long event_count = 0;
+  unsigned i;
+
+  sources = malloc(sizeof(*sources) * path_count);
+  if (sources == NULL) {
+    fatal_error("Insufficient memory to read %u traces", path_count);
+  }
+  source_count = path_count;
+
+  for (i = 0; i < path_count; i++) {
+    request_trace_header header;
+    request_trace_record *records;
+    unsigned long j;
+
+    if (request_trace_read(paths[i], &header, &records) != 0) {
+      fatal_error("Cannot read request trace %s", paths[i]);
+    }
+    if (header.dropped_count != 0) {
+      log_error("%s misses %llu events because its ring was full", paths[i],
+                (unsigned long long) header.dropped_count);
+    }
+    sources[i].path = paths[i];
+    sources[i].pid = header.pid;
+    sources[i].port = header.port;
+
+    events = realloc(events, (sizeof(*events)
+                              * (event_count + header.record_count + 1)));
+    if (events == NULL) {
+      fatal_error("Insufficient memory to merge %s", paths[i]);
+    }
+    for (j = 0; j < header.record_count; j++) {
+      events[event_count].record = records[j];
+      events[event_count].source = i;
+      event_count++;
+    }
+    free(records);
+  }
+
+  qsort(events, event_count, sizeof(*events), compare_events);
+
+  *res = events;
+  *res_count = event_count;
+}
+
+static void print_events(const struct event *events, unsigned long count)
+{
+  unsigned long i;
+
+  printf("# Client\tJob\tRequest\tTime in ns\tPort\tThread\tEvent\n");
+  for (i = 0; i < count; i++) {
+    const request_trace_record *r = &events[i].record;
+    printf("%u\t%u\t%u\t%llu\t%u\t%u\t%s\n", r->id.client, r->id.job,
+           r->id.request, (unsigned long long) r->t_ns,
+           sources[events[i].source].port, r->thread,
+           request_trace_event_name(r->event));
+  }
+}
+
+/* Return 0 if the path of the request is complete or -1 otherwise */
+static int build_request_path(const struct event *events, unsigned long count,
+                              struct request_path *path)
+{
+  const unsigned server_mask = ((1 << REQUEST_TRACE_RECEIVE)
+                                | (1 << REQUEST_TRACE_START)
+                                | (1 << REQUEST_TRACE_REPLY));
+  const unsigned forward_mask = ((1 << REQUEST_TRACE_FORWARD)
+                                 | (1 << REQUEST_TRACE_FORWARDED));
+  unsigned long i;
+  int k, client_seen = 0;
+
+  memset(path, 0, sizeof(*path));
+  path->id = events[0].record.id;
+
+  for (i = 0; i < count; i++) {
+    const request_trace_record *r = &events[i].record;
+    struct hop *hop;
+
+    if (sources[events[i].source].port == 0) {
+      if (r->event == REQUEST_TRACE_SEND) {
+        path->t_send = r->t_ns;
+        client_seen |= 1;
+      } else if (r->event == REQUEST_TRACE_RESPONSE) {
+        path->t_response = r->t_ns;
+        client_seen |= 2;
+      }
+      continue;
+    }
+
+    for (k = 0; k < path->hop_count; k++) {
+      if (path->hops[k].source == events[i].source) {
+        break;
+      }
+    }
+    if (k == path->hop_count) {
+      if (k == HOP_COUNT_MAX) {
+        log_error("Request %u of job %u of client %u has more than %d hops",
+                  r->id.request, r->id.job, r->id.client, HOP_COUNT_MAX);
+        return -1;
+      }
+      path->hop_count++;
+      path->hops[k].source = events[i].source;
+    }
+    hop = &path->hops[k];
+    if (r->event < REQUEST_TRACE_EVENT_COUNT && !(hop->seen & (1 << r->event))) {
+      hop->seen |= 1 << r->event;
+      hop->t[r->event] = r->t_ns;
+    }
+  }
+
+  if (client_seen != 3) {
+    return -1;
+  }
+  qsort(path->hops, path->hop_count, sizeof(path->hops[0]), compare_hops);
+
+  for (k = 0; k < path->hop_count; k++) {
+    struct hop *hop = &path->hops[k];
+    unsigned long long *c = path->components[k];
+    unsigned long long t_upstream_send, t_upstream_rcvd;
+
+    if ((hop->seen & server_mask) != server_mask
+        || ((hop->seen & forward_mask) != 0
+            && (hop->seen & forward_mask) != forward_mask)) {
+      return -1;
+    }
+    if (k == 0) {
+      t_upstream_send = path->t_send;
+      t_upstream_rcvd = path->t_response;
+    } else {
+      if ((path->hops[k - 1].seen & forward_mask) != forward_mask) {
+        return -1;
+      }
+      t_upstream_send = path->hops[k - 1].t[REQUEST_TRACE_FORWARD];
+      t_upstream_rcvd = path->hops[k - 1].t[REQUEST_TRACE_FORWARDED];
+    }
+
+    c[TRANSIT] = hop->t[REQUEST_TRACE_RECEIVE] - t_upstream_send;
+    c[QUEUEING] = (hop->t[REQUEST_TRACE_START]
+                   - hop->t[REQUEST_TRACE_RECEIVE]);
+    if (hop->seen & forward_mask) {
+      c[PROCESSING] = (hop->t[REQUEST_TRACE_FORWARD]
+                       - hop->t[REQUEST_TRACE_START]
+                       + hop->t[REQUEST_TRACE_REPLY]
+                       - hop->t[REQUEST_TRACE_FORWARDED]);
+      c[DOWNSTREAM] = (hop->t[REQUEST_TRACE_FORWARDED]
+                       - hop->t[REQUEST_TRACE_FORWARD]);
+    } else {
+      c[PROCESSING] = (hop->t[REQUEST_TRACE_REPLY]
+                       - hop->t[REQUEST_TRACE_START]);
+      c[DOWNSTREAM] = 0;
+    }
+    c[RETURN] = t_upstream_rcvd - hop->t[REQUEST_TRACE_REPLY];
+  }
+
+  return 0;
+}
+
+static void add_hop_stats(struct hop_stats *stats, unsigned port,
+                          const unsigned long long *components)
+{
+  int i;
+
+  if (stats->count == stats->capacity) {
+    stats->capacity = stats->capacity == 0 ? 1024 : stats->capacity * 2;
+    for (i = 0; i < COMPONENT_COUNT; i++) {
+      stats->components[i] = realloc(stats->components[i],
+                                     (sizeof(*stats->components[i])
+                                      * stats->capacity));
+      if (stats->components[i] == NULL) {
+        fatal_error("Insufficient memory to summarize the critical paths");
+      }
+    }
+  }
+  if (stats->count == 0) {
+    stats->port = port;
+  }
+  for (i = 0; i < COMPONENT_COUNT; i++) {
+    stats->components[i][stats->count] = components[i];
+  }
+  stats->count++;
+}
+
+static unsigned long long percentile(const unsigned long long *ns,
+                                     unsigned long count,
+                                     unsigned long fraction)
+{
+  unsigned long long rank = ((unsigned long long) count * fraction
+                             + 9999) / 10000;
+  return ns[rank == 0 ? 0 : rank - 1];
+}
+
+static void print_hop_stats(int nth, struct hop_stats *stats)
+{
+  int i;
+
+  for (i = 0; i < COMPONENT_COUNT; i++) {
+    unsigned long long *ns = stats->components[i];
+    unsigned long long sum = 0;
+    unsigned long j;
+
+    qsort(ns, stats->count, sizeof(*ns), compare_ns);
+    for (j = 0; j < stats->count; j++) {
+      sum += ns[j];
+    }
+    printf("# Hop %d (port %u) %s (ns): n=%lu mean=%llu p50=%llu p99=%llu"
+           " max=%llu\n", nth, stats->port, component_names[i], stats->count,
+           sum / stats->count, percentile(ns, stats->count, 5000),
+           percentile(ns, stats->count, 9900), ns[stats->count - 1]);
+  }
+}
+
+/* Print the critical path of each job, which is that of its request
+   whose response is received last */
+static void print_critical_paths(const struct event *events,
+                                 unsigned long count)
+{
+  struct hop_stats hop_stats[HOP_COUNT_MAX];
+  struct request_path path, critical;
+  unsigned long i, j, job_count = 0, incomplete_count = 0;
+  int k, critical_found = 0;
+
+  memset(hop_stats, 0, sizeof(hop_stats));
+
+  printf("# Client\tJob\tRequest\tEnd-to-end in ns\tHop\tPort"
+         "\tTransit in ns\tQueueing in ns\tProcessing in ns"
+         "\tDownstream in ns\tReturn in ns\n");
+
+  for (i = 0; i < count; i = j) {
+    for (j = i + 1;
+         j < count && same_request(&events[i].record.id,
+                                   &events[j].record.id);
+         j++);
+
+    if (build_request_path(events + i, j - i, &path) != 0) {
+      incomplete_count++;
+    } else if (!critical_found || path.t_response > critical.t_response) {
+      critical = path;
+      critical_found = 1;
+    }
+
+    /* Print the critical path once all requests of the job are seen */
+    if (j < count && same_job(&events[i].record.id, &events[j].record.id)) {
+      continue;
+    }
+    if (!critical_found) {
+      continue;
+    }
+    for (k = 0; k < critical.hop_count; k++) {
+      const unsigned long long *c = critical.components[k];
+      unsigned port = sources[critical.hops[k].source].port;
+
+      printf("%u\t%u\t%u\t%llu\t%d\t%u\t%llu\t%llu\t%llu\t%llu\t%llu\n",
+             critical.id.client, critical.id.job, critical.id.request,
+             critical.t_response - critical.t_send, k + 1, port,
+             c[TRANSIT], c[QUEUEING], c[PROCESSING], c[DOWNSTREAM], c[RETURN]);
+      add_hop_stats(&hop_stats[k], port, c);
+    }
+    job_count++;
+    critical_found = 0;
+  }
+
+  printf("# %lu job(s) with %lu incomplete request(s)\n",
+         job_count, incomplete_count);
+  for (k = 0; k < HOP_COUNT_MAX && hop_stats[k].count != 0; k++) {
+    print_hop_stats(k + 1, &hop_stats[k]);
+  }
+  for (k = 0; k < HOP_COUNT_MAX; k++) {
+    for (i = 0; i < COMPONENT_COUNT; i++) {
+      free(hop_stats[k].components[i]);
+    }
+  }
+}
+
+const char prog_name[] = "merge_request_traces";
+FILE *log_stream;
+
+int main(int argc, char **argv, char **envp)
+{
+  log_stream = stderr;
+
+  int raw = 0;
+  {
+    int optchar;
+    opterr = 0;
+    while ((optchar = getopt(argc, argv, ":hr")) != -1) {
+      switch (optchar) {
+      case 'r':
+        raw = 1;
+        break;
+      case 'h':
+        printf("Usage: %s [-r] TRACE_FILE...\n"
+               "\n"
+               "This program merges the request traces produced using\n"
+               "option -j of the client and of the servers in a blocking\n"
+               "chain to reconstruct the critical path of each client job,\n"
+               "which is the path of the request of the job whose response\n"
+               "is received last. The path is printed as one line per hop\n"
+               "in the order of the servers from the client in the format:\n"
+               "CLIENT JOB REQUEST END_TO_END HOP PORT TRANSIT QUEUEING\n"
+               "PROCESSING DOWNSTREAM RETURN\n"
+               "where, in nanosecond:\n"
+               "- END_TO_END is the round-trip time of the request.\n"
+               "- TRANSIT is the time from the sending of the request by\n"
+               "  the client or the previous server to its retrieval.\n"
+               "- QUEUEING is the time from the retrieval to the start of\n"
+               "  the processing, which includes the waiting for the\n"
+               "  preceding requests and for a worker.\n"
+               "- PROCESSING is the time spent by the server on the request\n"
+               "  before forwarding it to the subserver and after getting\n"
+               "  the response of the subserver.\n"
+               "- DOWNSTREAM is the time from the forwarding to the\n"
+               "  response of the subserver, which the line of the next hop\n"
+               "  breaks down in turn.\n"
+               "- RETURN is the time from the reply of the server to its\n"
+               "  receipt by the client or the previous server.\n"
+               "The components of a hop add up to END_TO_END for the first\n"
+               "hop and to DOWNSTREAM of the previous hop for the others.\n"
+               "A summary of each component at each hop is printed at the\n"
+               "end as comment lines.\n"
+               "\n"
+               "-r prints every event of every request in the order of\n"
+               "   the requests and then of the time instead.\n",
+               prog_name);
+        return EXIT_SUCCESS;
+      case '?':
+        fatal_error("Unrecognized option character -%c", optopt);
+      case ':':
+        fatal_error("Option -%c needs an argument", optopt);
+      default:
+        fatal_error("Unexpected return value of fn getopt");
+      }
+    }
+  }
+  if (argv[optind] == NULL) {
+    fatal_error("TRACE_FILE must be specified (-h for help)");
+  }
+
+  struct event *events;
+  unsigned long event_count;
+  load_traces(argv + optind, argc - optind, &events, &event_count);
+
+  if (raw) {
+    print_events(events, event_count);
+  } else {
+    print_critical_paths(events, event_count);
+  }
+
+  free(events);
+  free(sources);
+
+  return EXIT_SUCCESS;
+}
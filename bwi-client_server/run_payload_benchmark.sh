@@ -0,0 +1,68 @@
+#!/bin/bash
+
+# Measure the round-trip time of a request carrying a payload of
+# increasing size that is either copied through UDP (up to 60 KB),
+# copied through the shm channel or passed by reference (zero-copy).
+# The median and the 99th percentile of each run are tabulated in
+# payload_benchmark.txt as a gnuplot data file.
+
+sizes="1024 4096 16384 61440 262144 1048576 4194304"
+udp_size_max=61440
+
+name=payload_benchmark
+cfg=${name}.cfg
+out=${name}.out
+table=${name}.txt
+
+set -e
+
+# $1 the payload size
+# $2 the mode: copy-udp, copy-shm or zerocopy
+function write_cfg {
+    case $2 in
+        copy-udp)
+            server_opts="-u $1"
+            client_opts="-u $1"
+            ;;
+        copy-shm)
+            server_opts="-m shm -u $1"
+            client_opts="-m shm -u $1"
+            ;;
+        zerocopy)
+            server_opts=""
+            client_opts="-u $1 -z"
+            ;;
+    esac
+    cat > $cfg <<EOF
+SERVER -d 1 -p 7777 $server_opts
+CLIENT -1 10 -2 2 -3 10 -q 40 -t 60 -p 7777 -s ${name}.bin $client_opts
+EOF
+}
+
+# $1 the percentile name (e.g., p50)
+function rtt_percentile {
+    sed -n 's%^rtt_[a-z]* (ns):.* '$1'=\([0-9]*\) .*%\1%p' $out
+}
+
+printf '# Payload size in byte' > $table
+for mode in copy-udp copy-shm zerocopy; do
+    printf '\t%s p50 in ns\t%s p99 in ns' $mode $mode >> $table
+done
+printf '\n' >> $table
+
+for size in $sizes; do
+    printf '%d' $size >> $table
+    for mode in copy-udp copy-shm zerocopy; do
+        if [ $mode = copy-udp -a $size -gt $udp_size_max ]; then
+            printf '\t-\t-' >> $table
+            continue
+        fi
+        write_cfg $size $mode
+        sudo ./main -t 60s -p 20 -f $cfg > $out
+        printf '\t%s\t%s' `rtt_percentile p50` `rtt_percentile p99` >> $table
+    done
+    printf '\n' >> $table
+done
+
+rm -f $cfg $out
+cat $table
@@ -1,7 +1,7 @@
 #!/bin/bash
 
-if [ $# -ne 1 ]; then
-    echo "Usage: `basename $0` {soft|hard}" >&2
+if [ $# -ne 1 -a $# -ne 2 ]; then
+    echo "Usage: `basename $0` {soft|hard} [CPU_LIST]" >&2
     exit 1
 fi
 
@@ -11,12 +11,39 @@ if [ $1 = "soft" ]; then
 elif [ $1 = "hard" ]; then
     out_name=${name}_hard
 else
-    echo "Usage: `basename $0` {soft|hard}" >&2
+    echo "Usage: `basename $0` {soft|hard} [CPU_LIST]" >&2
     exit 1
 fi
+cpu_list=$2
 
 set -e
 
+# $1 the evaluation number
+# $2 the name of the evaluation
+# $3 the name of the output
+function convert_results {
+    ../read_task_stats_file -c gnuplot ${2}.bin > ./${3}.txt
+    if [ $1 -ne 1 ]; then
+	../read_task_stats_file -c gnuplot ${2}_hrt.bin > ./${3}_hrt.txt
+    fi
+}
+
+if [ -n "$cpu_list" ]; then
+    cfgs=
+    for ((i = 1; i <= 8; i++)); do
+	cfgs="$cfgs ${name}_${i}_BWI_no.cfg ${name}_${i}_BWI_yes.cfg"
+    done
+
+    echo "All evaluations on CPUs $cpu_list"
+    sudo ./main -t 60s -p 20 -c $cpu_list $cfgs
+
+    for ((i = 1; i <= 8; i++)); do
+	convert_results $i ${name}_${i}_BWI_no ${out_name}_${i}_BWI_no
+	convert_results $i ${name}_${i}_BWI_yes ${out_name}_${i}_BWI_yes
+    done
+    exit 0
+fi
+
 for ((i = 1; i <= 8; i++)); do
     name_bwi_no=${name}_${i}_BWI_no
     name_bwi_yes=${name}_${i}_BWI_yes
@@ -25,23 +52,13 @@ for ((i = 1; i <= 8; i++)); do
 
     echo "Evaluation $i: No BWI"
     sudo ./main -t 60s -p 20 -f ${name_bwi_no}.cfg
-    ../read_task_stats_file -c gnuplot ${name_bwi_no}.bin \
-	> ./${out_name_bwi_no}.txt
-    if [ $i -ne 1 ]; then
-	../read_task_stats_file -c gnuplot ${name_bwi_no}_hrt.bin \
-	    > ./${out_name_bwi_no}_hrt.txt
-    fi
+    convert_results $i $name_bwi_no $out_name_bwi_no
 
     sleep 5
 
     echo "Evaluation $i: BWI"
     sudo ./main -t 60s -p 20 -f ${name_bwi_yes}.cfg
-    ../read_task_stats_file -c gnuplot ${name_bwi_yes}.bin \
-	> ./${out_name_bwi_yes}.txt
-    if [ $i -ne 1 ]; then
-	../read_task_stats_file -c gnuplot ${name_bwi_yes}_hrt.bin \
-	    > ./${out_name_bwi_yes}_hrt.txt
-    fi
+    convert_results $i $name_bwi_yes $out_name_bwi_yes
 
     sleep 5
 done
@@ -15,6 +15,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
  *****************************************************************************/
 
+#define _GNU_SOURCE
+
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -24,6 +26,9 @@
 #include <stdlib.h>
 #include <signal.h>
 #include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include <semaphore.h>
 #include "../utility_experimentation.h"
 #include "../utility_log.h"
 #include "../utility_cpu.h"
@@ -31,13 +36,76 @@
 #include "../utility_sched.h"
 #include "../utility_sched_fifo.h"
 #include "../utility_sched_deadline.h"
+#include "../utility_shm_channel.h"
+#include "../utility_lockfree_queue.h"
+#include "../utility_supervisor.h"
+#include "../utility_request_trace.h"
+#include "../utility_bwi.h"
+#include "../utility_payload.h"
+#include "../utility_program_options.h"
+
+/* The shm channel of a server is named after its port */
+#define SHM_CHANNEL_NAME_FMT "/bwi-client_server-%d"
+#define SHM_CHANNEL_SLOT_COUNT 16
+#define REQUEST_SIZE_MAX 1024
+#define BATCH_SIZE_MAX 64
+#define WORKER_COUNT_MAX 64
+/* The number of requests that can be waiting for or being served by
+   the workers, which must be a power of two */
+#define WORKER_REQUEST_COUNT 256
+/* A server acknowledges entering or leaving SCHED_FIFO upon SIGUSR1 by
+   sending this signal back to the sender of SIGUSR1 */
+#define SCHED_FIFO_ACK_SIGNAL SIGRTMIN
+#define SCHED_FIFO_ACK_TIMEOUT_MS 500
+/* The maximum number of request events that can be traced */
+#define TRACE_RECORD_COUNT (1UL << 18)
+/* The largest UDP payload that IPv4 can carry */
+#define UDP_MSG_SIZE_MAX 65507
 
 static volatile int terminated = 0;
 static int old_scheduler_set = 0;
 static struct scheduler old_scheduler;
 static int subserver_pid = -1;
+/* Thread 0 is the main thread and thread n is the n-th worker */
+static request_trace *trace = NULL;
+/* The BWI handle of the main thread to give its bandwidth to the
+   subserver */
+static bwi *subserver_bwi = NULL;
+/* The payload regions of the clients mapped by the main thread */
+static payload_map *payloads = NULL;
+/* REQUEST_SIZE_MAX extended by PAYLOAD_SIZE_MAX */
+static size_t request_size_max = REQUEST_SIZE_MAX;
 
-static void sighand(int signo)
+/* Ask the subserver to enter or leave SCHED_FIFO and wait for its
+   acknowledgement */
+static void toggle_subserver_sched_fifo(const char *action)
+{
+  struct timespec timeout = {
+    .tv_sec = 0,
+    .tv_nsec = SCHED_FIFO_ACK_TIMEOUT_MS * 1000000L,
+  };
+  sigset_t ack_signal;
+  siginfo_t ack;
+  int rc;
+
+  sigemptyset(&ack_signal);
+  sigaddset(&ack_signal, SCHED_FIFO_ACK_SIGNAL);
+
+  if (kill(subserver_pid, SIGUSR1) != 0) {
+    fatal_error("Cannot signal subserver %d to %s SCHED_FIFO",
+                subserver_pid, action);
+  }
+  do {
+    rc = sigtimedwait(&ack_signal, &ack, &timeout);
+  } while ((rc == -1 && errno == EINTR)
+           || (rc != -1 && ack.si_pid != subserver_pid));
+  if (rc == -1) {
+    fatal_error("Subserver %d does not %s SCHED_FIFO after %d ms",
+                subserver_pid, action, SCHED_FIFO_ACK_TIMEOUT_MS);
+  }
+}
+
+static void sighand(int signo, siginfo_t *info, void *context)
 {
   if (signo == SIGTERM) {
     terminated = 1;
@@ -47,21 +115,7 @@ static void sighand(int signo)
 
       /* Signal subserver as necessary */
       if (subserver_pid != -1) {
-        int counter;
-        if (kill(subserver_pid, SIGUSR1) != 0) {
-          fatal_error("Cannot signal subserver %d to leave SCHED_FIFO",
-                      subserver_pid);
-        }
-        counter = 500;
-        while (sched_getscheduler(subserver_pid) == SCHED_FIFO
-               && counter != 0) {
-          usleep(1000);
-          counter--;
-        }
-        if (counter == 0) {
-          fatal_error("Subserver %d does not leave SCHED_FIFO after 500 ms",
-                      subserver_pid);
-        }
+        toggle_subserver_sched_fifo("leave");
       }
       /* END: Signal subserver as necessary */
 
@@ -69,6 +123,7 @@ static void sighand(int signo)
       if (sched_fifo_leave(&old_scheduler) == 0) {
         log_verbose("SCHED_FIFO is turned off\n");
         old_scheduler_set = 0;  
+        kill(info->si_pid, SCHED_FIFO_ACK_SIGNAL);
       } else {
         log_error("Cannot leave SCHED_FIFO");
       }      
@@ -76,22 +131,7 @@ static void sighand(int signo)
     } else {
       /* Signal subserver as necessary */
       if (subserver_pid != -1) {
-        int counter;
-
-        if (kill(subserver_pid, SIGUSR1) != 0) {
-          fatal_error("Cannot signal subserver %d to enter SCHED_FIFO",
-                      subserver_pid);
-        }
-        counter = 500;
-        while (sched_getscheduler(subserver_pid) != SCHED_FIFO
-               && counter != 0) {
-          usleep(1000);
-          counter--;
-        }
-        if (counter == 0) {
-          fatal_error("Subserver %d does not enter SCHED_FIFO after 500 ms",
-                      subserver_pid);
-        }
+        toggle_subserver_sched_fifo("enter");
       }      
       /* END: Signal subserver as necessary */
 
@@ -99,6 +139,7 @@ static void sighand(int signo)
       if (sched_fifo_enter_max(&old_scheduler) == 0) {
         log_verbose("SCHED_FIFO is turned on\n");
         old_scheduler_set = 1;
+        kill(info->si_pid, SCHED_FIFO_ACK_SIGNAL);
       } else {
         log_error("Cannot enter SCHED_FIFO");
       }      
@@ -107,10 +148,53 @@ static void sighand(int signo)
   }
 }
 
+/* A request passed from the dispatcher to a worker */
+struct request {
+  struct sockaddr_in src_addr;
+  ssize_t len;
+  char *buffer; /* request_size_max bytes */
+};
+
+struct worker {
+  pthread_t tid;
+  int nth; /* The n-th worker starting from 1 */
+  int subserver_socket; /* Each worker has its own subserver connection */
+  bwi *subserver_bwi; /* Each worker gives its own bandwidth */
+  payload_map *payloads; /* Each worker maps the payload regions itself */
+  const cpu_busyloop *busyloop;
+  int subserver_port;
+  int cbs_budget_ms;
+  int cbs_period_ms;
+};
+
 static int server_socket = -1;
 static int subserver_socket = -1;
+static shm_channel *server_channel = NULL;
+static shm_channel *subserver_channel = NULL;
+static struct worker *workers = NULL;
+static int worker_count = 0;
+static struct request *request_pool = NULL;
+static lockfree_queue *free_requests = NULL;
+static lockfree_queue *pending_requests = NULL;
+static sem_t free_request_count;
+static sem_t pending_request_count;
 static void cleanup(void)
 {
+  if (workers != NULL) {
+    int i;
+    for (i = 0; i < worker_count; i++) {
+      if (workers[i].subserver_socket != -1
+          && close(workers[i].subserver_socket) == -1) {
+        log_syserror("Cannot close worker %d subserver socket", i + 1);
+      }
+    }
+  }
+  if (server_channel != NULL) {
+    shm_channel_close(server_channel);
+  }
+  if (subserver_channel != NULL) {
+    shm_channel_close(subserver_channel);
+  }
   if (server_socket != -1) {
     if (close(server_socket) == -1) {
       log_syserror("Cannot close server socket");
@@ -123,12 +207,15 @@ static void cleanup(void)
   }
 }
 
-static void send_recv(int comm_socket, const void *data, size_t data_len,
+static void send_recv(int comm_socket, shm_channel *comm_channel,
+                      const void *data, size_t data_len,
                       void *buffer, size_t buf_len,
                       ssize_t *byte_sent, ssize_t *byte_rcvd,
                       int *send_errno, int *recv_errno)
 {
-  *byte_sent = send(comm_socket, data, data_len, 0);
+  *byte_sent = (comm_channel == NULL
+                ? send(comm_socket, data, data_len, 0)
+                : shm_channel_send(comm_channel, data, data_len));
   if (*byte_sent == -1) {
     *send_errno = errno;
   } else {
@@ -143,7 +230,9 @@ static void send_recv(int comm_socket, const void *data, size_t data_len,
 
   memset(buffer, 0, buf_len);
 
-  *byte_rcvd = recv(comm_socket, buffer, buf_len, 0);
+  *byte_rcvd = (comm_channel == NULL
+                ? recv(comm_socket, buffer, buf_len, 0)
+                : shm_channel_recv(comm_channel, buffer, buf_len));
   if (*byte_rcvd == -1) {
     *recv_errno = errno;
   } else {
@@ -151,33 +240,69 @@ static void send_recv(int comm_socket, const void *data, size_t data_len,
   }
 }
 
-static int subserver_send_recv(int subserver_pid, int subserver_socket,
+/* Read the payload of a request like a server computing on it would.
+   A request is the request_trace_id of the client followed by the
+   payload_desc of its payload, if any, and by the payload itself
+   unless it is passed by reference. */
+static void serve_payload(payload_map *m, const char *request, ssize_t len)
+{
+  size_t header_len = sizeof(request_trace_id) + sizeof(payload_desc);
+  volatile uint64_t checksum;
+  payload_desc desc;
+  void *payload;
+
+  if (len < header_len) {
+    return;
+  }
+  memcpy(&desc, request + sizeof(request_trace_id), sizeof(desc));
+  if (desc.magic != PAYLOAD_DESC_MAGIC) {
+    return;
+  }
+
+  if (desc.owner == 0) {
+    if (desc.size > len - header_len) {
+      log_error("Payload of %llu bytes is truncated",
+                (unsigned long long) desc.size);
+      return;
+    }
+    payload = (char *) request + header_len;
+  } else if (payload_map_resolve(m, &desc, &payload) != 0) {
+    log_error("Cannot resolve the payload of client %u", desc.owner);
+    return;
+  }
+
+  checksum = payload_checksum(payload, desc.size);
+  (void) checksum;
+}
+
+static int subserver_send_recv(bwi *b, int subserver_socket,
+                               shm_channel *subserver_channel,
                                void *buffer, size_t buffer_size,
-                               ssize_t *packet_size)
+                               ssize_t *packet_size, unsigned thread)
 {
-  int send_errno, recv_errno, bwi_key, bwi_active = 0;
+  int send_errno, recv_errno;
   ssize_t byte_sent, byte_rcvd;
 
-  /* BWI */
-  if (subserver_pid != -1) {
-    if (syscall(344, subserver_pid, &bwi_key) != 0) {
-      if (errno != EAGAIN) {
-        log_syserror("Cannot perform BWI");
-      }
-    } else {
-      bwi_active = 1;
-    }
-  }  
+  request_trace_add(trace, thread, REQUEST_TRACE_FORWARD, NULL,
+                    buffer, *packet_size);
+
+  /* BWI; the request is forwarded without BWI if it cannot be given */
+  if (b != NULL) {
+    bwi_give(b, subserver_pid);
+  }
   /* END: BWI */
 
-  send_recv(subserver_socket, buffer, *packet_size, buffer, buffer_size,
+  send_recv(subserver_socket, subserver_channel,
+            buffer, *packet_size, buffer, buffer_size,
             &byte_sent, &byte_rcvd, &send_errno, &recv_errno);
+  if (byte_rcvd > 0) {
+    request_trace_add(trace, thread, REQUEST_TRACE_FORWARDED, NULL,
+                      buffer, byte_rcvd);
+  }
 
   /* BWI revocation */
-  if (subserver_pid != -1 && bwi_active) {
-    if (syscall(345, bwi_key) != 0) {
-      log_syserror("Cannot revoke BWI");
-    }
+  if (b != NULL) {
+    bwi_revoke(b);
   }
   /* END: BWI revocation */
 
@@ -204,14 +329,185 @@ static int subserver_send_recv(int subserver_pid, int subserver_socket,
   return 0;
 }
 
+static void *worker_thread(void *args)
+{
+  struct worker *w = args;
+  struct request *r;
+
+  /* Block all signals so that they are handled by the dispatcher */
+  {
+    sigset_t blocked_signals;
+    sigfillset(&blocked_signals);
+    if ((errno = pthread_sigmask(SIG_BLOCK, &blocked_signals, NULL)) != 0) {
+      fatal_syserror("Cannot block all signals in worker %d", w->nth);
+    }
+  }
+  /* END: Block all signals so that they are handled by the dispatcher */
+
+  /* Use CBS if requested */
+  if (w->cbs_budget_ms != -1 && w->cbs_period_ms != -1) {
+    if (sched_deadline_enter(to_utility_time_dyn(w->cbs_budget_ms, ms),
+                             to_utility_time_dyn(w->cbs_period_ms, ms),
+                             NULL) != 0) {
+      fatal_error("Worker %d cannot use CBS (privilege may be insufficient)",
+                  w->nth);
+    }
+  }
+  /* END: Use CBS if requested */
+
+  while (1) {
+    while (sem_wait(&pending_request_count) != 0) {
+      if (errno != EINTR) {
+        fatal_syserror("Worker %d cannot wait for a request", w->nth);
+      }
+    }
+    /* The dispatcher wakes a worker up without any request to stop it */
+    if (lockfree_queue_pop(pending_requests, (void **) &r) != 0) {
+      break;
+    }
+    request_trace_add(trace, w->nth, REQUEST_TRACE_DEQUEUE, NULL,
+                      r->buffer, r->len);
+
+    request_trace_add(trace, w->nth, REQUEST_TRACE_START, NULL,
+                      r->buffer, r->len);
+    serve_payload(w->payloads, r->buffer, r->len);
+    keep_cpu_busy(w->busyloop);
+
+    /* Send & receive the request to & from the subserver as necessary */
+    ssize_t packet_size = r->len;
+    int forwarded = 1;
+    if (w->subserver_port != -1) {
+      forwarded = (subserver_send_recv(w->subserver_bwi, w->subserver_socket,
+                                       NULL, r->buffer, request_size_max,
+                                       &packet_size, w->nth) == 0);
+    }
+    /* END: Send & receive the request to & from the subserver as necessary */
+
+    /* Send back a response */
+    if (forwarded) {
+      /* The reply time is taken before sending because the receiver
+         may preempt this worker right away */
+      struct timespec t_sent;
+      if (trace != NULL) {
+        clock_gettime(CLOCK_MONOTONIC, &t_sent);
+      }
+      ssize_t response_size = sendto(server_socket, r->buffer, packet_size, 0,
+                                     (struct sockaddr *) &r->src_addr,
+                                     sizeof(r->src_addr));
+      if (response_size == -1) {
+        log_syserror("Worker %d cannot send back response", w->nth);
+      } else if (response_size != packet_size) {
+        log_error("Response sent by worker %d is truncated", w->nth);
+      } else {
+        request_trace_add(trace, w->nth, REQUEST_TRACE_REPLY, &t_sent,
+                          r->buffer, packet_size);
+      }
+    }
+    /* END: Send back a response */
+
+    if (lockfree_queue_push(free_requests, r) != 0) {
+      fatal_error("Worker %d cannot release request (bug)", w->nth);
+    }
+    sem_post(&free_request_count);
+  }
+
+  return NULL;
+}
+
+/* Retrieve up to batch_size requests using one recvmmsg call and
+   queue them for the workers */
+static void dispatch_requests(int batch_size)
+{
+  struct mmsghdr msgs[BATCH_SIZE_MAX];
+  struct iovec iovecs[BATCH_SIZE_MAX];
+  struct request *requests[BATCH_SIZE_MAX];
+  int request_count, received_count, i;
+
+  /* Wait for a free request only when all are being served */
+  if (sem_wait(&free_request_count) != 0) {
+    if (errno != EINTR) {
+      log_syserror("Cannot wait for a free request");
+    }
+    return;
+  }
+  request_count = 1;
+  while (request_count < batch_size && sem_trywait(&free_request_count) == 0) {
+    request_count++;
+  }
+  for (i = 0; i < request_count; i++) {
+    if (lockfree_queue_pop(free_requests, (void **) &requests[i]) != 0) {
+      fatal_error("Cannot obtain free request (bug)");
+    }
+    iovecs[i].iov_base = requests[i]->buffer;
+    iovecs[i].iov_len = request_size_max;
+    memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+    msgs[i].msg_hdr.msg_name = &requests[i]->src_addr;
+    msgs[i].msg_hdr.msg_namelen = sizeof(requests[i]->src_addr);
+    msgs[i].msg_hdr.msg_iov = &iovecs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  received_count = recvmmsg(server_socket, msgs, request_count,
+                            MSG_WAITFORONE, NULL);
+  if (received_count == -1) {
+    if (errno != EINTR) {
+      log_syserror("Cannot retrieve incoming messages");
+    }
+    received_count = 0;
+  }
+  if (trace != NULL) {
+    struct timespec t_rcvd;
+    clock_gettime(CLOCK_MONOTONIC, &t_rcvd);
+    for (i = 0; i < received_count; i++) {
+      request_trace_add(trace, 0, REQUEST_TRACE_RECEIVE, &t_rcvd,
+                        requests[i]->buffer, msgs[i].msg_len);
+    }
+  }
+
+  for (i = 0; i < request_count; i++) {
+    lockfree_queue *q = free_requests;
+    sem_t *q_count = &free_request_count;
+
+    if (i < received_count) {
+      if (msgs[i].msg_hdr.msg_namelen != sizeof(struct sockaddr_in)) {
+        log_error("Sender address is not IPv4; cannot response");
+      } else {
+        if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+          log_error("Incoming request is truncated to %zu bytes",
+                    request_size_max);
+        }
+        requests[i]->len = msgs[i].msg_len;
+        q = pending_requests;
+        q_count = &pending_request_count;
+      }
+    }
+
+    if (lockfree_queue_push(q, requests[i]) != 0) {
+      fatal_error("Cannot queue request (bug)");
+    }
+    sem_post(q_count);
+  }
+}
+
 MAIN_BEGIN("server", "stderr", NULL)
 {
   if (atexit(cleanup) == -1) {
     fatal_syserror("Cannot register fn cleanup at exit");
   }
 
+  /* Acknowledgements are only received using sigtimedwait */
+  {
+    sigset_t ack_signal;
+    sigemptyset(&ack_signal);
+    sigaddset(&ack_signal, SCHED_FIFO_ACK_SIGNAL);
+    if (sigprocmask(SIG_BLOCK, &ack_signal, NULL) != 0) {
+      fatal_syserror("Cannot block SCHED_FIFO acknowledgement signal");
+    }
+  }
+
   struct sigaction sighandler = {
-    .sa_handler = sighand,
+    .sa_sigaction = sighand,
+    .sa_flags = SA_SIGINFO,
   };
   if (sigaction(SIGTERM, &sighandler, NULL) != 0) {
     fatal_syserror("Cannot install SIGTERM handler");
@@ -237,11 +533,56 @@ MAIN_BEGIN("server", "stderr", NULL)
   int cbs_budget_ms = -1;
   int cbs_period_ms = -1;
   int subserver_port = -1;
+  int use_shm = 0;
+  int batch_size = 1;
+  int requested_worker_count = 0;
+  const char *trace_path = NULL;
+  enum bwi_backend bwi_backend = BWI_BACKEND_AUTO;
+  long payload_size_max = 0;
   {
     int optchar;
     opterr = 0;
-    while ((optchar = getopt(argc, argv, ":hd:p:q:t:s:v:")) != -1) {
+    while ((optchar = getopt(argc, argv, ":h" SERVER_OPTSTRING)) != -1) {
       switch (optchar) {
+      case 'u':
+        payload_size_max = atol(optarg);
+        if (payload_size_max <= 0) {
+          fatal_error("PAYLOAD_SIZE_MAX must be at least 1 (-h for help)");
+        }
+        break;
+      case 'n':
+        if (bwi_backend_parse(optarg, &bwi_backend) != 0) {
+          fatal_error("BWI_BACKEND must be either auto, legacy, emulated"
+                      " or none (-h for help)");
+        }
+        break;
+      case 'j':
+        trace_path = optarg;
+        break;
+      case 'w':
+        requested_worker_count = atoi(optarg);
+        if (requested_worker_count < 1
+            || requested_worker_count > WORKER_COUNT_MAX) {
+          fatal_error("WORKER_COUNT must be between 1 and %d (-h for help)",
+                      WORKER_COUNT_MAX);
+        }
+        break;
+      case 'k':
+        batch_size = atoi(optarg);
+        if (batch_size < 1 || batch_size > BATCH_SIZE_MAX) {
+          fatal_error("BATCH_SIZE must be between 1 and %d (-h for help)",
+                      BATCH_SIZE_MAX);
+        }
+        break;
+      case 'm':
+        if (strcasecmp("shm", optarg) == 0) {
+          use_shm = 1;
+        } else if (strcasecmp("udp", optarg) == 0) {
+          use_shm = 0;
+        } else {
+          fatal_error("TRANSPORT must be either UDP or SHM (-h for help)");
+        }
+        break;
       case 'd':
         processing_duration_ms = atoi(optarg);
         if (processing_duration_ms < 0) {
@@ -284,7 +625,9 @@ MAIN_BEGIN("server", "stderr", NULL)
       case 'h':
         printf("Usage: %s -d SERVING_DURATION -p PORT\n"
                "       [-s SUBSERVER_PORT -v SUBSERVER_PID]\n"
-               "       [-q CBS_BUDGET -t CBS_PERIOD]\n"
+               "       [-q CBS_BUDGET -t CBS_PERIOD] [-m TRANSPORT] [-k BATCH_SIZE]\n"
+               "       [-w WORKER_COUNT] [-j TRACE_PATH] [-n BWI_BACKEND]\n"
+               "       [-u PAYLOAD_SIZE_MAX]\n"
                "\n"
                "This server listens on a local UDP port. Upon receiving a UDP\n"
                "packet at the port, this server will run for the specified\n"
@@ -298,6 +641,8 @@ MAIN_BEGIN("server", "stderr", NULL)
                "SIGTERM should be used to graciously terminate this program.\n"
                "Optionally, this server can be run using a CBS by specifying\n"
                "both the CBS budget and period.\n"
+               "Instead of UDP, the requests can be exchanged through shared\n"
+               "memory to exclude the network stack from the measurement.\n"
                "\n"
                "-d SERVING_DURATION is the duration in millisecond by which\n"
                "   this server will keep the CPU busy after receiving\n"
@@ -314,8 +659,50 @@ MAIN_BEGIN("server", "stderr", NULL)
                "-q CBS_BUDGET is the budget in millisecond of the CBS that\n"
                "   runs this server.\n"
                "-t CBS_PERIOD is the period in millisecond of the CBS that\n"
-               "   runs this server.\n",
-               prog_name);
+               "   runs this server.\n"
+               "-m TRANSPORT is either UDP (the default) or SHM. When SHM\n"
+               "   is given, PORT (and SUBSERVER_PORT) only names the shared\n"
+               "   memory channel that exactly one client at a time can use\n"
+               "   (and the subserver must use SHM as well).\n"
+               "-k BATCH_SIZE is the maximum number of UDP requests, at\n"
+               "   most 64, that are retrieved using one recvmmsg call and\n"
+               "   whose responses are sent back using one sendmmsg call.\n"
+               "   The requests are served one after another in the order\n"
+               "   of their arrival. If -k is not specified, BATCH_SIZE will\n"
+               "   be set to 1.\n"
+               "-w WORKER_COUNT is the number of worker threads, at most 64,\n"
+               "   that serve the UDP requests queued by the main thread,\n"
+               "   which becomes a dispatcher. If the CBS budget and period\n"
+               "   are given, each worker runs in its own CBS having them\n"
+               "   while the dispatcher does not use any CBS. Each worker\n"
+               "   performs its own BWI on the subserver through its own\n"
+               "   connection to the subserver. If -w is not specified,\n"
+               "   the main thread serves the requests by itself.\n"
+               "-j TRACE_PATH is the path to the file to store the time at\n"
+               "   which each client request is received, dequeued by the\n"
+               "   thread serving it, started, forwarded to the subserver,\n"
+               "   answered by the subserver and replied. At most %lu\n"
+               "   events are stored. The traces of the client and of all\n"
+               "   servers can be merged using merge_request_traces.\n"
+               "-n BWI_BACKEND is the mechanism used to give the bandwidth\n"
+               "   of the thread serving a request to the subserver: legacy\n"
+               "   (syscalls 344 and 345 of the patched SCHED_DEADLINE\n"
+               "   kernel), emulated (scheduling the subserver using the\n"
+               "   SCHED_DEADLINE parameters of the thread through\n"
+               "   sched_setattr) or none. If -n is not specified, BWI_BACKEND\n"
+               "   will be set to auto, which selects legacy on the patched\n"
+               "   kernel and emulated otherwise. The overhead of giving and\n"
+               "   revoking the bandwidth is printed when this server exits.\n"
+               "-u PAYLOAD_SIZE_MAX is the size in byte of the largest\n"
+               "   payload that a client copies into a request (see option\n"
+               "   -u of the client). A payload passed by reference is\n"
+               "   read in place regardless of its size. Before keeping the\n"
+               "   CPU busy, this server reads the whole payload of each\n"
+               "   request, which the subserver reads again if -s is given.\n"
+               "A request longer than 1024 bytes plus PAYLOAD_SIZE_MAX is\n"
+               "truncated. If TRANSPORT is UDP, the sum cannot exceed %d\n"
+               "bytes.\n",
+               prog_name, TRACE_RECORD_COUNT, UDP_MSG_SIZE_MAX);
         return EXIT_SUCCESS;
       case '?':
         fatal_error("Unrecognized option character -%c", optopt);
@@ -345,17 +732,27 @@ MAIN_BEGIN("server", "stderr", NULL)
                   " (-h for help)");
     }
   }
+  if (requested_worker_count != 0 && use_shm) {
+    fatal_error("WORKER_COUNT cannot be used when TRANSPORT is SHM because"
+                " an SHM channel only supports a single producer"
+                " (-h for help)");
+  }
   if (subserver_port != -1 && subserver_pid == -1) {
     fatal_error("SUBSERVER_PID must be specified together with SUBSERVER_PORT"
                 " (-h for help)");
   }
+  request_size_max += payload_size_max;
+  if (!use_shm && request_size_max > UDP_MSG_SIZE_MAX) {
+    fatal_error("PAYLOAD_SIZE_MAX cannot exceed %d when TRANSPORT is UDP"
+                " (-h for help)", UDP_MSG_SIZE_MAX - REQUEST_SIZE_MAX);
+  }
 
   /* Prepare server busyloop */
   cpu_busyloop *server_busyloop = NULL;
   {
     int search_tolerance_us = 100;
     int search_passes = 10;
-    int rc = create_cpu_busyloop(0,
+    int rc = create_cpu_busyloop(experiment_cpu,
                                  to_utility_time_dyn(processing_duration_ms,
                                                      ms),
                                  to_utility_time_dyn(search_tolerance_us, us),
@@ -373,7 +770,7 @@ MAIN_BEGIN("server", "stderr", NULL)
   /* END: Prepare server busyloop */
 
   /* Prepare UDP connection */
-  {
+  if (!use_shm) {
     server_socket = socket(AF_INET, SOCK_DGRAM, 0);
     if (server_socket == -1) {
       fatal_syserror("Cannot create server UDP socket");
@@ -387,7 +784,7 @@ MAIN_BEGIN("server", "stderr", NULL)
   /* END: Prepare UDP connection */
 
   /* Prepare UDP connection to subserver as necessary */
-  if (subserver_port != -1) {
+  if (!use_shm && subserver_port != -1) {
     subserver_socket = socket(AF_INET, SOCK_DGRAM, 0);
     if (subserver_socket == -1) {
       fatal_syserror("Cannot create subserver %d UDP socket", subserver_pid);
@@ -401,8 +798,123 @@ MAIN_BEGIN("server", "stderr", NULL)
   }
   /* END: Prepare UDP connection to subserver as necessary */
 
+  /* Prepare shm channels as necessary */
+  if (use_shm) {
+    char name[64];
+
+    snprintf(name, sizeof(name), SHM_CHANNEL_NAME_FMT, server_port);
+    if (shm_channel_create(name, SHM_CHANNEL_SLOT_COUNT,
+                           request_size_max, &server_channel) != 0) {
+      fatal_error("Cannot create shm channel %s", name);
+    }
+
+    if (subserver_port != -1) {
+      snprintf(name, sizeof(name), SHM_CHANNEL_NAME_FMT, subserver_port);
+      switch (shm_channel_open(name, &subserver_channel)) {
+      case 0:
+        break;
+      case -1:
+        fatal_error("Subserver %d does not serve shm channel %s or is"
+                    " already serving another client", subserver_pid, name);
+      default:
+        fatal_error("Cannot open shm channel %s to subserver %d",
+                    name, subserver_pid);
+      }
+    }
+  }
+  /* END: Prepare shm channels as necessary */
+
+  /* Prepare BWI as necessary */
+  if (subserver_pid != -1 && requested_worker_count == 0) {
+    if (bwi_create(bwi_backend, &subserver_bwi) != 0) {
+      fatal_error("Cannot create BWI handle");
+    }
+  }
+  /* END: Prepare BWI as necessary */
+
+  /* Prepare payload mapping */
+  if (requested_worker_count == 0 && payload_map_create(&payloads) != 0) {
+    fatal_error("Cannot create payload map");
+  }
+  /* END: Prepare payload mapping */
+
+  /* Prepare request tracing as necessary */
+  if (trace_path != NULL) {
+    if (request_trace_create(trace_path, server_port, TRACE_RECORD_COUNT,
+                             &trace) != 0) {
+      fatal_error("Cannot create request trace %s", trace_path);
+    }
+  }
+  /* END: Prepare request tracing as necessary */
+
+  /* Start workers as necessary */
+  if (requested_worker_count != 0) {
+    int i;
+
+    request_pool = malloc(WORKER_REQUEST_COUNT * sizeof(*request_pool));
+    workers = malloc(requested_worker_count * sizeof(*workers));
+    if (request_pool == NULL || workers == NULL) {
+      fatal_error("Insufficient memory to start %d workers",
+                  requested_worker_count);
+    }
+    if (lockfree_queue_create(WORKER_REQUEST_COUNT, &free_requests) != 0
+        || lockfree_queue_create(WORKER_REQUEST_COUNT,
+                                 &pending_requests) != 0) {
+      fatal_error("Cannot create worker request queues");
+    }
+    for (i = 0; i < WORKER_REQUEST_COUNT; i++) {
+      request_pool[i].buffer = malloc(request_size_max);
+      if (request_pool[i].buffer == NULL) {
+        fatal_error("Insufficient memory for %d requests of %zu bytes",
+                    WORKER_REQUEST_COUNT, request_size_max);
+      }
+      lockfree_queue_push(free_requests, &request_pool[i]);
+    }
+    if (sem_init(&free_request_count, 0, WORKER_REQUEST_COUNT) != 0
+        || sem_init(&pending_request_count, 0, 0) != 0) {
+      fatal_syserror("Cannot initialize worker request counters");
+    }
+
+    for (i = 0; i < requested_worker_count; i++) {
+      struct worker *w = &workers[i];
+
+      w->nth = i + 1;
+      w->busyloop = server_busyloop;
+      w->subserver_port = subserver_port;
+      w->cbs_budget_ms = cbs_budget_ms;
+      w->cbs_period_ms = cbs_period_ms;
+      w->subserver_socket = -1;
+      w->subserver_bwi = NULL;
+      if (payload_map_create(&w->payloads) != 0) {
+        fatal_error("Cannot create worker %d payload map", w->nth);
+      }
+      worker_count++;
+
+      if (subserver_port != -1) {
+        if (bwi_create(bwi_backend, &w->subserver_bwi) != 0) {
+          fatal_error("Cannot create worker %d BWI handle", w->nth);
+        }
+        w->subserver_socket = socket(AF_INET, SOCK_DGRAM, 0);
+        if (w->subserver_socket == -1) {
+          fatal_syserror("Cannot create worker %d UDP socket to subserver %d",
+                         w->nth, subserver_pid);
+        }
+        if (connect(w->subserver_socket, (struct sockaddr *) &subserver_addr,
+                    sizeof(subserver_addr)) == -1) {
+          fatal_syserror("Cannot set default destination of worker %d to"
+                         " subserver %d address", w->nth, subserver_pid);
+        }
+      }
+
+      if ((errno = pthread_create(&w->tid, NULL, worker_thread, w)) != 0) {
+        fatal_syserror("Cannot create worker %d", w->nth);
+      }
+    }
+  }
+  /* END: Start workers as necessary */
+
   /* Use CBS if requested */
-  if (cbs_budget_ms != -1 && cbs_period_ms != -1) {
+  if (worker_count == 0 && cbs_budget_ms != -1 && cbs_period_ms != -1) {
     if (sched_deadline_enter(to_utility_time_dyn(cbs_budget_ms, ms),
                              to_utility_time_dyn(cbs_period_ms, ms),
                              NULL) != 0) {
@@ -411,55 +923,244 @@ MAIN_BEGIN("server", "stderr", NULL)
   }
   /* END: Use CBS if requested */
 
-  /* Serve incoming client UDP packet */
+  if (supervisor_notify_ready() != 0) {
+    fatal_error("Cannot notify the driver of the readiness");
+  }
+
+  /* Serve incoming client request */
+  struct mmsghdr msgs[BATCH_SIZE_MAX];
+  struct iovec iovecs[BATCH_SIZE_MAX];
+  struct sockaddr_in src_addrs[BATCH_SIZE_MAX];
+  char *buffers[BATCH_SIZE_MAX];
+  if (worker_count == 0) {
+    int i;
+    for (i = 0; i < batch_size; i++) {
+      buffers[i] = malloc(request_size_max);
+      if (buffers[i] == NULL) {
+        fatal_error("Insufficient memory for %d requests of %zu bytes",
+                    batch_size, request_size_max);
+      }
+    }
+  }
   while (!terminated) {
-    struct sockaddr_in src_addr;
-    socklen_t src_addr_len = sizeof(src_addr);
-    char buffer[(1 << 16) - 1];
-    ssize_t packet_size, response_size;
+    int request_count, response_count, i;
 
-    memset(buffer, 0, sizeof(buffer));
+    if (worker_count != 0) {
+      dispatch_requests(batch_size);
+      continue;
+    }
 
-    /* Accept incoming request */
-    packet_size = recvfrom(server_socket, buffer, sizeof(buffer), 0,
-                           (struct sockaddr *) &src_addr, &src_addr_len);
-    if (packet_size == -1) {
-      if (errno != EINTR) {
-        log_syserror("Cannot retrieve incoming UDP message");
+    /* Accept incoming requests */
+    if (server_channel != NULL) {
+      ssize_t packet_size = shm_channel_recv(server_channel, buffers[0],
+                                             request_size_max);
+      if (packet_size == -1) {
+        if (errno != EINTR) {
+          log_syserror("Cannot retrieve incoming message");
+        }
+        continue;
+      }
+      iovecs[0].iov_base = buffers[0];
+      memset(&msgs[0].msg_hdr, 0, sizeof(msgs[0].msg_hdr));
+      msgs[0].msg_hdr.msg_iov = &iovecs[0];
+      msgs[0].msg_hdr.msg_iovlen = 1;
+      msgs[0].msg_len = packet_size;
+      request_count = 1;
+    } else {
+      for (i = 0; i < batch_size; i++) {
+        iovecs[i].iov_base = buffers[i];
+        iovecs[i].iov_len = request_size_max;
+        memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+        msgs[i].msg_hdr.msg_name = &src_addrs[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(src_addrs[i]);
+        msgs[i].msg_hdr.msg_iov = &iovecs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+      }
+      /* Block for the first request and take whatever else is queued */
+      request_count = recvmmsg(server_socket, msgs, batch_size,
+                               MSG_WAITFORONE, NULL);
+      if (request_count == -1) {
+        if (errno != EINTR) {
+          log_syserror("Cannot retrieve incoming messages");
+        }
+        continue;
       }
-      continue;
     }
-    if (src_addr_len != sizeof(struct sockaddr_in)) {
-      log_error("Sender address is not IPv4; cannot response");
-      continue;
+    if (trace != NULL) {
+      struct timespec t_rcvd;
+      clock_gettime(CLOCK_MONOTONIC, &t_rcvd);
+      for (i = 0; i < request_count; i++) {
+        request_trace_add(trace, 0, REQUEST_TRACE_RECEIVE, &t_rcvd,
+                          buffers[i], msgs[i].msg_len);
+      }
     }
-    /* END: Accept incoming request */
+    /* END: Accept incoming requests */
 
-    keep_cpu_busy(server_busyloop);
+    response_count = 0;
+    for (i = 0; i < request_count; i++) {
+      ssize_t packet_size = msgs[i].msg_len;
 
-    /* Send & receive the request to & from the subserver as necessary */
-    if (subserver_port != -1) {
-      if (subserver_send_recv(subserver_pid, subserver_socket,
-                              buffer, sizeof(buffer), &packet_size) != 0) {
+      if (server_channel == NULL
+          && msgs[i].msg_hdr.msg_namelen != sizeof(struct sockaddr_in)) {
+        log_error("Sender address is not IPv4; cannot response");
         continue;
       }
-    }
-    /* END: Send & receive the request to & from the subserver as necessary */
+      if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+        log_error("Incoming request is truncated to %zu bytes",
+                  request_size_max);
+      }
+      request_trace_add(trace, 0, REQUEST_TRACE_DEQUEUE, NULL,
+                        buffers[i], packet_size);
 
-    /* Send back a response */
-    response_size = sendto(server_socket, buffer, packet_size, 0,
-                           (struct sockaddr *) &src_addr, src_addr_len);
-    if (response_size == -1) {
-      log_syserror("Cannot send back response");
-      continue;
+      request_trace_add(trace, 0, REQUEST_TRACE_START, NULL,
+                        buffers[i], packet_size);
+      serve_payload(payloads, buffers[i], packet_size);
+      keep_cpu_busy(server_busyloop);
+
+      /* Send & receive the request to & from the subserver as necessary */
+      if (subserver_port != -1) {
+        if (subserver_send_recv(subserver_bwi, subserver_socket,
+                                subserver_channel,
+                                buffers[i], request_size_max,
+                                &packet_size, 0) != 0) {
+          continue;
+        }
+      }
+      /* END: Send & receive the request to & from the subserver as necessary */
+
+      /* Queue the response keeping the order of the requests */
+      iovecs[i].iov_len = packet_size;
+      if (response_count != i) {
+        msgs[response_count] = msgs[i];
+      }
+      msgs[response_count].msg_hdr.msg_controllen = 0;
+      msgs[response_count].msg_hdr.msg_flags = 0;
+      response_count++;
     }
-    if (response_size != packet_size) {
-      log_error("Sent response is truncated");
-      continue;
+
+    /* Send back the responses; the reply time is taken before sending
+       because the receiver may preempt this server right away */
+    if (server_channel != NULL) {
+      for (i = 0; i < response_count; i++) {
+        struct iovec *response = msgs[i].msg_hdr.msg_iov;
+        struct timespec t_sent;
+        if (trace != NULL) {
+          clock_gettime(CLOCK_MONOTONIC, &t_sent);
+        }
+        ssize_t response_size = shm_channel_send(server_channel,
+                                                 response->iov_base,
+                                                 response->iov_len);
+        if (response_size == -1) {
+          log_syserror("Cannot send back response");
+        } else if (response_size != response->iov_len) {
+          log_error("Sent response is truncated");
+        } else {
+          request_trace_add(trace, 0, REQUEST_TRACE_REPLY, &t_sent,
+                            response->iov_base, response_size);
+        }
+      }
+    } else {
+      i = 0;
+      while (i < response_count) {
+        struct timespec t_sent;
+        if (trace != NULL) {
+          clock_gettime(CLOCK_MONOTONIC, &t_sent);
+        }
+        int sent_count = sendmmsg(server_socket, msgs + i, response_count - i,
+                                  0);
+        if (sent_count == -1) {
+          log_syserror("Cannot send back %d response(s)", response_count - i);
+          break;
+        }
+        for (; sent_count > 0; sent_count--, i++) {
+          if (msgs[i].msg_len != msgs[i].msg_hdr.msg_iov->iov_len) {
+            log_error("Sent response is truncated");
+          } else {
+            request_trace_add(trace, 0, REQUEST_TRACE_REPLY, &t_sent,
+                              msgs[i].msg_hdr.msg_iov->iov_base,
+                              msgs[i].msg_len);
+          }
+        }
+      }
     }
-    /* END: Send back a response */
+    /* END: Send back the responses */
   }  
-  /* END: Serve incoming client UDP packet */
+  if (worker_count == 0) {
+    int i;
+    for (i = 0; i < batch_size; i++) {
+      free(buffers[i]);
+    }
+  }
+  /* END: Serve incoming client request */
+
+  /* Stop workers as necessary */
+  if (worker_count != 0) {
+    int i;
+
+    for (i = 0; i < worker_count; i++) {
+      /* Wake up a worker still waiting for its terminated subserver */
+      if (workers[i].subserver_socket != -1) {
+        shutdown(workers[i].subserver_socket, SHUT_RDWR);
+      }
+      sem_post(&pending_request_count);
+    }
+    for (i = 0; i < worker_count; i++) {
+      if ((errno = pthread_join(workers[i].tid, NULL)) != 0) {
+        log_syserror("Cannot join worker %d", workers[i].nth);
+      }
+    }
+    lockfree_queue_destroy(pending_requests);
+    lockfree_queue_destroy(free_requests);
+    sem_destroy(&pending_request_count);
+    sem_destroy(&free_request_count);
+    for (i = 0; i < WORKER_REQUEST_COUNT; i++) {
+      free(request_pool[i].buffer);
+    }
+    free(request_pool);
+    for (i = 0; i < worker_count; i++) {
+      payload_map_destroy(workers[i].payloads);
+    }
+  }
+  /* END: Stop workers as necessary */
+
+  /* Report BWI overhead as necessary */
+  if (subserver_pid != -1) {
+    bwi_overhead overheads[BWI_OPERATION_COUNT];
+    enum bwi_backend backend = BWI_BACKEND_NONE;
+    int op, i;
+
+    memset(overheads, 0, sizeof(overheads));
+    for (op = 0; op < BWI_OPERATION_COUNT; op++) {
+      bwi_overhead overhead;
+      if (subserver_bwi != NULL) {
+        backend = bwi_get_backend(subserver_bwi);
+        bwi_get_overhead(subserver_bwi, op, &overhead);
+        bwi_overhead_merge(&overheads[op], &overhead);
+      }
+      for (i = 0; i < worker_count; i++) {
+        backend = bwi_get_backend(workers[i].subserver_bwi);
+        bwi_get_overhead(workers[i].subserver_bwi, op, &overhead);
+        bwi_overhead_merge(&overheads[op], &overhead);
+      }
+      bwi_overhead_print(stdout, backend, op, &overheads[op]);
+    }
+
+    if (subserver_bwi != NULL) {
+      bwi_destroy(subserver_bwi);
+    }
+    for (i = 0; i < worker_count; i++) {
+      bwi_destroy(workers[i].subserver_bwi);
+    }
+  }
+  /* END: Report BWI overhead as necessary */
+
+  if (trace != NULL && request_trace_destroy(trace) != 0) {
+    log_error("Cannot store request trace %s", trace_path);
+  }
+
+  if (payloads != NULL) {
+    payload_map_destroy(payloads);
+  }
 
   destroy_cpu_busyloop(server_busyloop);
 
@@ -31,6 +31,8 @@
 #include <signal.h>
 #include "../utility_experimentation.h"
 #include "../utility_log.h"
+#include "../utility_supervisor.h"
+#include "../utility_program_options.h"
 
 static void send_recv(int comm_socket, const void *data, size_t data_len,
                       void *buffer, size_t buf_len,
@@ -99,7 +101,7 @@ MAIN_BEGIN("client", "stderr", NULL)
   {
     int optchar;
     opterr = 0;
-    while ((optchar = getopt(argc, argv, ":hp:")) != -1) {
+    while ((optchar = getopt(argc, argv, ":h" SERVER_HOG_OPTSTRING)) != -1) {
       switch (optchar) {
       case 'p':
         server_port = atoi(optarg);
@@ -147,6 +149,10 @@ MAIN_BEGIN("client", "stderr", NULL)
   }
   /* END: Prepare UDP connection */
 
+  if (supervisor_notify_ready() != 0) {
+    fatal_error("Cannot notify the driver of the readiness");
+  }
+
   char message_buf[] = "Hello! I am server hogger!";
   char response_buf[sizeof(message_buf)];
   while (!terminated) {
@@ -27,6 +27,8 @@
 #include "utility_time.h"
 #include "utility_cpu.h"
 #include "utility_memory.h"
+#include "utility_supervisor.h"
+#include "utility_program_options.h"
 
 static inline void print_stats(const absolute_time *t1_abs, int chunk_counter,
                                int silent)
@@ -201,7 +203,7 @@ MAIN_BEGIN("cpu_hog_cbs", "stderr", NULL)
   {
     int optchar;
     opterr = 0;
-    while ((optchar = getopt(argc, argv, ":hze:b:q:t:s:")) != -1) {
+    while ((optchar = getopt(argc, argv, ":h" CPU_HOG_CBS_OPTSTRING)) != -1) {
       switch (optchar) {
       case 'e':
         exec_time_ms = atoi(optarg);
@@ -294,7 +296,7 @@ MAIN_BEGIN("cpu_hog_cbs", "stderr", NULL)
   {
     int search_tolerance_us = 100;
     int search_passes = 10;
-    int rc = create_cpu_busyloop(0,
+    int rc = create_cpu_busyloop(experiment_cpu,
                                  to_utility_time_dyn(exec_time_ms, ms),
                                  to_utility_time_dyn(search_tolerance_us, us),
                                  search_passes,
@@ -323,6 +325,10 @@ MAIN_BEGIN("cpu_hog_cbs", "stderr", NULL)
                   );
     }
 
+    if (supervisor_notify_ready() != 0) {
+      fatal_error("Cannot notify the driver of the readiness");
+    }
+
     sigsuspend(&start_signal);
 
     memory_preallocate_stack(1024);
@@ -26,6 +26,7 @@
 #include "../utility_time.h"
 #include "../utility_sched_deadline.h"
 #include "../utility_memory.h"
+#include "../utility_sched_analysis.h"
 
 MAIN_BEGIN("earliest_deadline_first", "stderr", NULL)
 {
@@ -99,6 +100,50 @@ MAIN_BEGIN("earliest_deadline_first", "stderr", NULL)
 
 #undef set_manual_gc
 
+  /* Check the schedulability of the task set */
+  sched_analysis_taskset *taskset = sched_analysis_taskset_create();
+  if (taskset == NULL) {
+    fatal_error("Cannot create the task set to analyze");
+  }
+
+#define add_to_taskset(id) do {                                         \
+    if (sched_analysis_taskset_add(taskset,                             \
+                                   utility_time_to_utility_time_dyn     \
+                                   (tau_ ## id ## _wcet),               \
+                                   utility_time_to_utility_time_dyn     \
+                                   (tau_ ## id ## _period),             \
+                                   utility_time_to_utility_time_dyn     \
+                                   (tau_ ## id ## _deadline)) != 0) {   \
+      fatal_error("Cannot add Tau_" #id " to the task set to analyze"); \
+    }                                                                   \
+  } while (0)
+
+  add_to_taskset(1);
+  add_to_taskset(2);
+  add_to_taskset(3);
+
+#undef add_to_taskset
+
+  if (!sched_analysis_edf(taskset)) {
+    sched_analysis_taskset_destroy(taskset);
+    fatal_error("The task set is not schedulable under EDF");
+  }
+  switch (sched_analysis_deadline_admissible(taskset, 1)) {
+  case 1:
+    break;
+  case 0:
+    sched_analysis_taskset_destroy(taskset);
+    fatal_error("SCHED_DEADLINE admission control will reject the task set");
+  default:
+    log_error("Cannot check SCHED_DEADLINE admission control beforehand");
+    break;
+  }
+  if (sched_analysis_fp(taskset, SCHED_ANALYSIS_RM) == 0) {
+    printf("The task set is schedulable under EDF but not under RM\n");
+  }
+  sched_analysis_taskset_destroy(taskset);
+  /* END: Check the schedulability of the task set */
+
   int exit_code = EXIT_FAILURE;
   int rc = 0;
   relative_time *job_stats_overhead = NULL;
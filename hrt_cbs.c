@@ -33,12 +33,16 @@
 #include "utility_sched_deadline.h"
 #include "task.h"
 #include "utility_memory.h"
+#include "utility_supervisor.h"
+#include "utility_program_options.h"
 
 struct periodic_task_thread_prms {
   int wcet_ms;
   int deadline_ms;
   int budget_ms;
   int period_ms;
+  int cbs_deadline_ms;
+  unsigned int cbs_flags;
   const char *task_name;
   const char *stats_file_path;
   struct busyloop_exact_args busyloop_exact_args;
@@ -69,12 +73,17 @@ static void *periodic_task_thread(void *args)
 
   /* Use CBS server */
   {
-    int rc = sched_deadline_enter(to_utility_time_dyn(prms->budget_ms, ms),
-                                  to_utility_time_dyn(prms->period_ms, ms),
-                                  NULL);
+    int rc = sched_deadline_enter_ex(to_utility_time_dyn(prms->budget_ms, ms),
+                                     to_utility_time_dyn(prms->cbs_deadline_ms,
+                                                         ms),
+                                     to_utility_time_dyn(prms->period_ms, ms),
+                                     prms->cbs_flags, NULL);
     if (rc == -1) {
       log_error("Insufficient privilege to use SCHED_DEADLINE");
       return &prms->rc;
+    } else if (rc == -3) {
+      log_error("SCHED_DEADLINE admission control rejects the CBS");
+      return &prms->rc;
     } else if (rc != 0) {
       log_error("Cannot enter SCHED_DEADLINE");
       return &prms->rc;
@@ -82,6 +91,11 @@ static void *periodic_task_thread(void *args)
   }
   /* END: Use CBS server */
 
+  if (supervisor_notify_ready() != 0) {
+    log_error("Cannot notify the driver of the readiness");
+    return &prms->rc;
+  }
+
   /* Wait for starting signal */
   {
     int signo;
@@ -158,11 +172,13 @@ MAIN_BEGIN("hrt_cbs", "stderr", NULL)
   int budget_ms = -1;
   int deadline_ms = -1;
   int period_ms = -1;
+  int cbs_deadline_ms = -1;
+  unsigned int cbs_flags = 0;
   int duration_ms = -1;
   {
     int optchar;
     opterr = 0;
-    while ((optchar = getopt(argc, argv, ":hn:s:c:d:q:t:x:")) != -1) {
+    while ((optchar = getopt(argc, argv, ":h" HRT_CBS_OPTSTRING)) != -1) {
       switch (optchar) {
       case 'n':
         task_name = optarg;
@@ -200,9 +216,18 @@ MAIN_BEGIN("hrt_cbs", "stderr", NULL)
           fatal_error("DEADLINE must be at least 1 ms (-h for help)");
         }
         break;
+      case 'D':
+        cbs_deadline_ms = atoi(optarg);
+        if (cbs_deadline_ms <= 0) {
+          fatal_error("CBS_DEADLINE must be at least 1 ms (-h for help)");
+        }
+        break;
+      case 'R':
+        cbs_flags |= SCHED_FLAG_RECLAIM;
+        break;
       case 'h':
         printf("Usage: %s -n NAME -s STATS_FILE -c WCET -q BUDGET -t PERIOD\n"
-               "       -x DURATION [-d DEADLINE]"
+               "       -x DURATION [-d DEADLINE] [-D CBS_DEADLINE] [-R]"
                "\n"
                "A HRT CBS is a CBS that never postpones its deadline because\n"
                "it serves a periodic task that obeys the stated WCET and\n"
@@ -219,6 +244,11 @@ MAIN_BEGIN("hrt_cbs", "stderr", NULL)
                "   deadline of the task is equal to the CBS period.\n"
                "-q BUDGET is the CBS budget in millisecond.\n"
                "-t PERIOD is the CBS period in millisecond.\n"
+               "-D CBS_DEADLINE is the relative deadline of the CBS in\n"
+               "   millisecond. If this is omitted, the relative deadline\n"
+               "   of the CBS is equal to the CBS period.\n"
+               "-R lets the CBS reclaim unused bandwidth\n"
+               "   (SCHED_FLAG_RECLAIM, mainline kernels only).\n"
                "-x DURATION in ms will be divided by PERIOD to determine the\n"
                "   number of slots in the job statistics ring buffer\n",
                prog_name);
@@ -273,6 +303,12 @@ MAIN_BEGIN("hrt_cbs", "stderr", NULL)
     fatal_error("Budget must be less than or equal to the period"
                 " (-h for help)");
   }
+  if (cbs_deadline_ms == -1) {
+    cbs_deadline_ms = period_ms;
+  } else if (budget_ms > cbs_deadline_ms || cbs_deadline_ms > period_ms) {
+    fatal_error("CBS deadline must be between the budget and the period"
+                " (-h for help)");
+  }
 
   /* Measure overhead */
   relative_time *job_stats_overhead;
@@ -283,7 +319,7 @@ MAIN_BEGIN("hrt_cbs", "stderr", NULL)
     char t_str[32];
 
     /* Job statistics overhead */
-    if (job_statistics_overhead(0, &job_stats_overhead) != 0) {
+    if (job_statistics_overhead(experiment_cpu, &job_stats_overhead) != 0) {
       fatal_error("Cannot obtain job statistics overhead");
     }
     utility_time_set_gc_manual(job_stats_overhead);
@@ -292,7 +328,7 @@ MAIN_BEGIN("hrt_cbs", "stderr", NULL)
     /* END: Job statistics overhead */    
 
     /* Task overhead */
-    if (finish_to_start_overhead(0, 0, &task_overhead) != 0) {
+    if (finish_to_start_overhead(experiment_cpu, 0, &task_overhead) != 0) {
       fatal_error("Cannot obtain finish to start overhead");
     }
     utility_time_set_gc_manual(task_overhead);
@@ -314,7 +350,7 @@ MAIN_BEGIN("hrt_cbs", "stderr", NULL)
     int search_passes = 10;
     relative_time *real_wcet
       = utility_time_sub_dyn_gc(to_utility_time_dyn(wcet_ms, ms), overhead);
-    int rc = create_cpu_busyloop(0,
+    int rc = create_cpu_busyloop(experiment_cpu,
                                  real_wcet,
                                  to_utility_time_dyn(search_tolerance_us, us),
                                  search_passes,
@@ -349,6 +385,8 @@ MAIN_BEGIN("hrt_cbs", "stderr", NULL)
     .deadline_ms = deadline_ms,
     .budget_ms = budget_ms,
     .period_ms = period_ms,
+    .cbs_deadline_ms = cbs_deadline_ms,
+    .cbs_flags = cbs_flags,
     .busyloop_exact_args = {
       .busyloop_obj = wcet_busyloop,
     },
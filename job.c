@@ -15,6 +15,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
  *****************************************************************************/
 
+#define _GNU_SOURCE /* sched_getcpu(), RUSAGE_THREAD */
+
 #include "job.h"
 
 /* CLOCK_MONOTONIC must be used because function job->run_program may
@@ -22,48 +24,186 @@
    will not give the right timing information. */
 #define CLOCK_TYPE CLOCK_MONOTONIC
 
+/* Sample the CPU and the context switch counts at the start of a
+   job. The counts are turned into the ones of the job by
+   cpu_statistics_end(). */
+static inline int cpu_statistics_begin(job_cpu_statistics *stats)
+{
+  struct rusage usage;
+
+  stats->cpu_begin = sched_getcpu();
+  if (getrusage(RUSAGE_THREAD, &usage) != 0) {
+    return -1;
+  }
+  stats->voluntary_switches = usage.ru_nvcsw;
+  stats->involuntary_switches = usage.ru_nivcsw;
+
+  return 0;
+}
+
+/* Sample the CPU and the context switch counts at the finish of a
+   job whose start has been sampled by cpu_statistics_begin(). */
+static inline int cpu_statistics_end(job_cpu_statistics *stats)
+{
+  struct rusage usage;
+  int rc = getrusage(RUSAGE_THREAD, &usage);
+
+  if (rc == 0) {
+    stats->voluntary_switches = usage.ru_nvcsw - stats->voluntary_switches;
+    stats->involuntary_switches = (usage.ru_nivcsw
+                                   - stats->involuntary_switches);
+  }
+  stats->cpu_end = sched_getcpu();
+
+  return rc;
+}
+
 /* The following code section must be the same in function job_start
    and in function overhead_measurement used by function
-   job_statistics_overhead. */
-#define common_code_section(rc, logging_enabled,        \
-                            job, t_begin, t_end)        \
-  if (logging_enabled)                                  \
-    rc -= clock_gettime(CLOCK_TYPE, t_begin);           \
-  job->run_program(job->args);                          \
-  if (logging_enabled)                                  \
-    rc -= clock_gettime(CLOCK_TYPE, t_end)
+   job_statistics_overhead. The CPU statistics are sampled only if
+   cpu_stats is not NULL. */
+#define common_code_section(rc, logging_enabled, cpu_stats,    \
+                            job, t_begin, t_end)                \
+  if (logging_enabled) {                                        \
+    rc -= clock_gettime(CLOCK_TYPE, t_begin);                   \
+    if (cpu_stats != NULL)                                      \
+      rc -= cpu_statistics_begin(cpu_stats);                    \
+  }                                                             \
+  job->run_program(job->args);                                  \
+  if (logging_enabled) {                                        \
+    if (cpu_stats != NULL)                                      \
+      rc -= cpu_statistics_end(cpu_stats);                      \
+    rc -= clock_gettime(CLOCK_TYPE, t_end);                     \
+  }
+
+/* Return the slot in which the next job statistics is to be
+   recorded or dummy if the ring buffer is full and must not
+   overrun. The slot of the CPU statistics is stored in cpu_stats
+   unless the returned slot is dummy, in which case cpu_stats is
+   untouched, or unless the CPU statistics are not recorded, in which
+   case cpu_stats is set to NULL. */
+static inline job_statistics *next_slot(jobstats_ringbuf *stats_log,
+                                        job_statistics *dummy,
+                                        job_cpu_statistics **cpu_stats)
+{
+  job_statistics *stats = dummy;
+
+  if (stats_log->next == stats_log->slot_count) {
+    if (!stats_log->overrun) {
+      stats_log->overrun = 1;
+    }
+    if (!stats_log->overrun_disabled) {
+      stats_log->next = 0;
+      stats_log->overrun_count++;
+      stats = &stats_log->ringbuf[stats_log->next++];
+    }
+  } else {
+    stats = &stats_log->ringbuf[stats_log->next++];
+  }
+
+  stats_log->write_count++;
+
+  if (stats_log->cpu_ringbuf == NULL) {
+    *cpu_stats = NULL;
+  } else if (stats != dummy) {
+    *cpu_stats = &stats_log->cpu_ringbuf[stats_log->next - 1];
+  }
+
+  return stats;
+}
 
 int job_start(jobstats_ringbuf *stats_log, struct job *job)
 {
   job_statistics dummy;
   job_statistics *stats = &dummy;
+  job_cpu_statistics cpu_dummy;
+  job_cpu_statistics *cpu_stats = &cpu_dummy;
   int rc = 0;
 
   /* Log the job statistics (this is the biggest unaccountable overhead) */
   if (stats_log != NULL) {
-    if (stats_log->next == stats_log->slot_count) {
-      if (!stats_log->overrun) {
-        stats_log->overrun = 1;
-      }
-      if (!stats_log->overrun_disabled) {
-        stats_log->next = 0;
-        stats_log->overrun_count++;
-        stats = &stats_log->ringbuf[stats_log->next++];
-      }
-    } else {
-      stats = &stats_log->ringbuf[stats_log->next++];
-    }
-
-    stats_log->write_count++;
+    stats = next_slot(stats_log, &dummy, &cpu_stats);
   }
   /* End of logging the job statistics */
 
-  common_code_section(rc, stats_log != NULL, job,
+  common_code_section(rc, stats_log != NULL, cpu_stats, job,
                       &stats->t_begin, &stats->t_end);
 
   return rc;
 }
 
+int job_skip(jobstats_ringbuf *stats_log)
+{
+  job_statistics dummy;
+  job_statistics *stats;
+  job_cpu_statistics cpu_dummy;
+  job_cpu_statistics *cpu_stats = &cpu_dummy;
+
+  if (stats_log == NULL) {
+    return 0;
+  }
+
+  struct timespec t_now;
+  if (clock_gettime(CLOCK_TYPE, &t_now) != 0) {
+    return -1;
+  }
+  stats = next_slot(stats_log, &dummy, &cpu_stats);
+  stats->t_begin = stats->t_end = t_now;
+
+  if (cpu_stats != NULL) {
+    cpu_stats->cpu_begin = cpu_stats->cpu_end = sched_getcpu();
+    cpu_stats->voluntary_switches = cpu_stats->involuntary_switches = 0;
+  }
+
+  return 0;
+}
+
+void job_record(jobstats_ringbuf *stats_log, const struct timespec *t_begin,
+                const struct timespec *t_end)
+{
+  job_statistics dummy;
+  job_statistics *stats;
+  job_cpu_statistics cpu_dummy;
+  job_cpu_statistics *cpu_stats = &cpu_dummy;
+
+  if (stats_log == NULL) {
+    return;
+  }
+
+  stats = next_slot(stats_log, &dummy, &cpu_stats);
+  stats->t_begin = *t_begin;
+  stats->t_end = *t_end;
+
+  if (cpu_stats != NULL) {
+    cpu_stats->cpu_begin = cpu_stats->cpu_end = -1;
+    cpu_stats->voluntary_switches = cpu_stats->involuntary_switches = 0;
+  }
+}
+
+int jobstats_ringbuf_finish_last(jobstats_ringbuf *stats_log)
+{
+  int rc = 0;
+
+  if (stats_log == NULL || stats_log->write_count == 0
+      || (stats_log->overrun_disabled
+          && stats_log->write_count > stats_log->slot_count)) {
+    return 0; /* The last job has not been recorded */
+  }
+
+  if (stats_log->cpu_ringbuf != NULL) {
+    rc -= cpu_statistics_end(&stats_log->cpu_ringbuf[stats_log->next - 1]);
+  }
+
+  struct timespec t_end;
+  if (clock_gettime(CLOCK_TYPE, &t_end) == 0) {
+    stats_log->ringbuf[stats_log->next - 1].t_end = t_end;
+  } else {
+    rc--;
+  }
+
+  return (rc == 0 ? 0 : -1);
+}
+
 int job_statistics_read(FILE *stats_log, job_statistics *stats)
 {
   job_statistics result;
@@ -98,14 +238,16 @@ struct overhead_measurement_parameters
 {
   relative_time *result;
   int which_cpu;
+  int record_cpu;
   int exit_status;
 };
 static __attribute__((noinline,optimize(0)))
 int overhead_measurement(struct job *probing_job,
+                         job_cpu_statistics *cpu_stats,
                          struct timespec *t_begin, struct timespec *t_end)
 {
   int rc = 0;
-  common_code_section(rc, 1, probing_job, t_begin, t_end);
+  common_code_section(rc, 1, cpu_stats, probing_job, t_begin, t_end);
   return rc;
 }
 static void *overhead_measurement_thread(void *args)
@@ -143,7 +285,10 @@ static void *overhead_measurement_thread(void *args)
 
   /* Do measurement */
   struct timespec t_begin, t_end;
-  if (overhead_measurement(&probing_job, &t_begin, &t_end) != 0) {
+  job_cpu_statistics cpu_stats;
+  if (overhead_measurement(&probing_job,
+                           params->record_cpu ? &cpu_stats : NULL,
+                           &t_begin, &t_end) != 0) {
     log_error("Fail to get either t_begin or t_end or both");
     goto out;
   }
@@ -159,12 +304,19 @@ static void *overhead_measurement_thread(void *args)
 }
 
 int job_statistics_overhead(int which_cpu, relative_time **result)
+{
+  return job_statistics_overhead_ex(which_cpu, 0, result);
+}
+
+int job_statistics_overhead_ex(int which_cpu, int record_cpu,
+                               relative_time **result)
 {
   *result = NULL;
 
   pthread_t measurement_thread;
   struct overhead_measurement_parameters params = {
     .which_cpu = which_cpu,
+    .record_cpu = record_cpu,
   };
   if ((errno = pthread_create(&measurement_thread, NULL,
                               overhead_measurement_thread,
@@ -193,8 +345,37 @@ absolute_time *job_statistics_time_finish(const job_statistics *stats)
   return timespec_to_utility_time_dyn(&stats->t_end);
 }
 
+int job_cpu_statistics_cpu_begin(const job_cpu_statistics *stats)
+{
+  return stats->cpu_begin;
+}
+
+int job_cpu_statistics_cpu_end(const job_cpu_statistics *stats)
+{
+  return stats->cpu_end;
+}
+
+unsigned long
+job_cpu_statistics_voluntary_switches(const job_cpu_statistics *stats)
+{
+  return stats->voluntary_switches;
+}
+
+unsigned long
+job_cpu_statistics_involuntary_switches(const job_cpu_statistics *stats)
+{
+  return stats->involuntary_switches;
+}
+
 jobstats_ringbuf *jobstats_ringbuf_create(unsigned long slot_count,
                                           int disable_overrun)
+{
+  return jobstats_ringbuf_create_ex(slot_count, disable_overrun, 0);
+}
+
+jobstats_ringbuf *jobstats_ringbuf_create_ex(unsigned long slot_count,
+                                             int disable_overrun,
+                                             int record_cpu)
 {
   if (slot_count == 0) {
     return NULL;
@@ -213,6 +394,16 @@ jobstats_ringbuf *jobstats_ringbuf_create(unsigned long slot_count,
   }
   memset(res->ringbuf, 0, sizeof(*res->ringbuf) * slot_count);
 
+  if (record_cpu) {
+    res->cpu_ringbuf = malloc(sizeof(*res->cpu_ringbuf) * slot_count);
+    if (res->cpu_ringbuf == NULL) {
+      free(res->ringbuf);
+      free(res);
+      return NULL;
+    }
+    memset(res->cpu_ringbuf, 0, sizeof(*res->cpu_ringbuf) * slot_count);
+  }
+
   res->slot_count = slot_count;
   res->overrun_disabled = !!disable_overrun;
 
@@ -221,11 +412,15 @@ jobstats_ringbuf *jobstats_ringbuf_create(unsigned long slot_count,
 
 void jobstats_ringbuf_destroy(jobstats_ringbuf *ringbuf)
 {
+  free(ringbuf->cpu_ringbuf);
   free(ringbuf->ringbuf);
   free(ringbuf);
 }
 
-int jobstats_ringbuf_save(const jobstats_ringbuf *ringbuf, FILE *record_file)
+/* Save the slots of the given array of slot_size-byte slots
+   parallel to the ring buffer from the oldest one. */
+static int save_slots(const jobstats_ringbuf *ringbuf, const void *slots,
+                      size_t slot_size, FILE *record_file)
 {
   unsigned long i, end;
 
@@ -249,8 +444,8 @@ int jobstats_ringbuf_save(const jobstats_ringbuf *ringbuf, FILE *record_file)
   do {
     i %= ringbuf->slot_count;
 
-    if (fwrite(&ringbuf->ringbuf[i], sizeof(*ringbuf->ringbuf), 1, record_file)
-        == 0) {
+    if (fwrite((const char *) slots + i * slot_size, slot_size, 1,
+               record_file) == 0) {
       log_syserror("Cannot write job statistics at ring buffer slot #%lu", i);
       return -1;
     }
@@ -261,6 +456,28 @@ int jobstats_ringbuf_save(const jobstats_ringbuf *ringbuf, FILE *record_file)
   return 0;
 }
 
+int jobstats_ringbuf_save(const jobstats_ringbuf *ringbuf, FILE *record_file)
+{
+  return save_slots(ringbuf, ringbuf->ringbuf, sizeof(*ringbuf->ringbuf),
+                    record_file);
+}
+
+int jobstats_ringbuf_save_cpu(const jobstats_ringbuf *ringbuf,
+                              FILE *record_file)
+{
+  if (ringbuf->cpu_ringbuf == NULL) {
+    return 0;
+  }
+
+  return save_slots(ringbuf, ringbuf->cpu_ringbuf,
+                    sizeof(*ringbuf->cpu_ringbuf), record_file);
+}
+
+int jobstats_ringbuf_cpu_recorded(const jobstats_ringbuf *ringbuf)
+{
+  return ringbuf->cpu_ringbuf != NULL;
+}
+
 int jobstats_ringbuf_overrun(const jobstats_ringbuf *ringbuf)
 {
   return (ringbuf->overrun_disabled
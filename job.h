@@ -34,6 +34,12 @@
  * determine the expected release time of the oldest job). The test
  * unit provides complete usage example.
  *
+ * Once the affinity of a task is not locked to a single CPU, the job
+ * statistics alone cannot tell where a job has run. Hence, a ring
+ * buffer can additionally record the CPU at which each job starts and
+ * finishes and the number of context switches that the job has
+ * suffered (c.f., jobstats_ringbuf_create_ex()).
+ *
  * @author Tadeus Prastowo <eus@member.fsf.org>
  */
 
@@ -41,12 +47,14 @@
 #define JOB_H
 
 #include <sched.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <errno.h>
 #include <time.h>
 #include <string.h>
 #include <stdlib.h>
 #include <pthread.h>
+#include <sys/resource.h>
 #include "utility_log.h"
 #include "utility_time.h"
 #include "utility_file.h"
@@ -78,6 +86,22 @@ extern "C" {
     struct timespec t_end; /* The finishing time (f_{i,j}) of the job */
   } job_statistics;
 
+  /**
+   * The CPU statistics of a particular job of a real-time task, which
+   * are recorded only if requested (c.f.,
+   * jobstats_ringbuf_create_ex()). This is an opaque type; do not
+   * manipulate any of its instances directly.
+   */
+  typedef struct __attribute__((packed))
+  {
+    int32_t cpu_begin; /* The CPU at the start time or -1 if unknown */
+    int32_t cpu_end; /* The CPU at the finishing time or -1 if unknown */
+    uint32_t voluntary_switches; /* The voluntary context switches
+                                    of the job (e.g., blocking) */
+    uint32_t involuntary_switches; /* The involuntary context switches
+                                      of the job (i.e., preemptions) */
+  } job_cpu_statistics;
+
   /**
    * Following the idea of Linux ftrace, job statistics are logged to
    * ring buffer to avoid expensive disk writing cost. The user of
@@ -88,6 +112,9 @@ extern "C" {
   typedef struct
   {
     job_statistics *ringbuf; /* The ring buffer as an array */
+    job_cpu_statistics *cpu_ringbuf; /* The CPU statistics of the job
+                                        in the same slot of ringbuf or
+                                        NULL if they are not recorded */
     unsigned long slot_count; /* The number of slots in the ring
                                  buffer array */
     unsigned long next; /* The next slot in the ring buffer to write to */
@@ -173,6 +200,12 @@ extern "C" {
    * for a particular collection of job statistics. An example of such
    * an analysis can be found in the unit test.
    *
+   * If the ring buffer records the CPU statistics, the CPU and the
+   * context switch counts of the calling thread are also sampled
+   * right after the starting time and right before the finishing
+   * time. The sampling is then part of the overhead returned by
+   * job_statistics_overhead_ex().
+   *
    * @param stats_log a pointer to the jobstats_ringbuf object to which the
    * statistics of each job is to be logged. Set this to NULL to
    * disable job statistics logging that can reduce the amount of
@@ -187,6 +220,33 @@ extern "C" {
    * statistics are still written to stats_log.
    */
   int job_start(jobstats_ringbuf *stats_log, struct job *job);
+
+  /**
+   * Record a job that is not run because its release is skipped so
+   * that the release positions of the jobs that follow are
+   * preserved. Both the starting time and the finishing time of the
+   * job are set to the current time.
+   *
+   * @param stats_log like that of job_start().
+   *
+   * @return zero if there is no error or -1 if the current time
+   * cannot be obtained.
+   */
+  int job_skip(jobstats_ringbuf *stats_log);
+
+  /**
+   * Record a job that is not run by the caller, such as a simulated
+   * job, with the given starting time and finishing time so that the
+   * ring buffer can be saved like one filled by job_start(). If the
+   * CPU statistics are recorded, both CPUs are set to -1 (unknown)
+   * without any context switch.
+   *
+   * @param stats_log like that of job_start().
+   * @param t_begin a pointer to the starting time of the job.
+   * @param t_end a pointer to the finishing time of the job.
+   */
+  void job_record(jobstats_ringbuf *stats_log, const struct timespec *t_begin,
+                  const struct timespec *t_end);
   /** @} End of collection of job execution functions */
 
   /* IV */
@@ -240,6 +300,15 @@ extern "C" {
    */
   int job_statistics_overhead(int which_cpu, relative_time **result);
 
+  /**
+   * Work just like job_statistics_overhead() but if record_cpu is
+   * non-zero, the measured overhead includes the sampling of the CPU
+   * statistics done by job_start() when the ring buffer records them
+   * (c.f., jobstats_ringbuf_create_ex()).
+   */
+  int job_statistics_overhead_ex(int which_cpu, int record_cpu,
+                                 relative_time **result);
+
   /**
    * @return the starting time of this particular job as a
    * utility_time object fits for automatic garbage collection.
@@ -251,6 +320,32 @@ extern "C" {
    * utility_time object fits for automatic garbage collection.
    */
   absolute_time *job_statistics_time_finish(const job_statistics *stats);
+
+  /**
+   * @return the CPU at which the job started or -1 if it is unknown.
+   */
+  int job_cpu_statistics_cpu_begin(const job_cpu_statistics *stats);
+
+  /**
+   * @return the CPU at which the job finished or -1 if it is unknown.
+   * A job whose finishing CPU differs from its starting CPU has
+   * migrated at least once. The converse does not hold because the
+   * job may have migrated back to its starting CPU.
+   */
+  int job_cpu_statistics_cpu_end(const job_cpu_statistics *stats);
+
+  /**
+   * @return the number of times the job has given up the CPU by
+   * itself (e.g., to block on a lock or to sleep).
+   */
+  unsigned long
+  job_cpu_statistics_voluntary_switches(const job_cpu_statistics *stats);
+
+  /**
+   * @return the number of times the job has been preempted.
+   */
+  unsigned long
+  job_cpu_statistics_involuntary_switches(const job_cpu_statistics *stats);
   /** @} End of collection of job statistics functions */
 
   /* V */
@@ -275,6 +370,18 @@ extern "C" {
   jobstats_ringbuf *jobstats_ringbuf_create(unsigned long slot_count,
                                             int disable_overrun);
 
+  /**
+   * Work just like jobstats_ringbuf_create() but if record_cpu is
+   * non-zero, the ring buffer also records the CPU statistics of each
+   * job using sched_getcpu() and getrusage(RUSAGE_THREAD). Since the
+   * latter is a system call, the recording increases the overhead of
+   * job_start(), which should then be measured using
+   * job_statistics_overhead_ex().
+   */
+  jobstats_ringbuf *jobstats_ringbuf_create_ex(unsigned long slot_count,
+                                               int disable_overrun,
+                                               int record_cpu);
+
   /**
    * Destroy a job statistics ring buffer object. An already destroyed
    * ring buffer must not be passed to this function again.
@@ -297,6 +404,38 @@ extern "C" {
    */
   int jobstats_ringbuf_save(const jobstats_ringbuf *ringbuf, FILE *record_file);
 
+  /**
+   * Save the CPU statistics of a job statistics ring buffer to a file
+   * in the same order as jobstats_ringbuf_save() does so that the
+   * n-th saved job_cpu_statistics object belongs to the n-th saved
+   * job_statistics object.
+   *
+   * @return like that of jobstats_ringbuf_save(). Nothing is saved
+   * if the ring buffer does not record the CPU statistics.
+   */
+  int jobstats_ringbuf_save_cpu(const jobstats_ringbuf *ringbuf,
+                                FILE *record_file);
+
+  /**
+   * @return non-zero if the ring buffer records the CPU statistics.
+   */
+  int jobstats_ringbuf_cpu_recorded(const jobstats_ringbuf *ringbuf);
+
+  /**
+   * Record the current time as the finishing time of the job most
+   * recently recorded by job_start(), and the current CPU and context
+   * switch counts as well if the CPU statistics are recorded. This is
+   * used when the job is aborted before job_start() can record the
+   * finishing time.
+   *
+   * @param stats_log a pointer to the ring buffer object or NULL if
+   * job statistics logging is disabled.
+   *
+   * @return zero if there is no error or -1 if the current time or
+   * the context switch counts cannot be obtained.
+   */
+  int jobstats_ringbuf_finish_last(jobstats_ringbuf *stats_log);
+
   /**
    * Test if a job statistics ring buffer object has overrun.
    *
@@ -39,6 +39,15 @@ static void cleanup(void)
   }
 }
 
+static void sleeping_program(void *args)
+{
+  struct timespec t = {
+    .tv_sec = 0,
+    .tv_nsec = 1000000,
+  };
+  gracious_assert(clock_nanosleep(CLOCK_MONOTONIC, 0, &t, NULL) == 0);
+}
+
 MAIN_UNIT_TEST_BEGIN("job_test", "stderr", NULL, cleanup)
 {
   require_valgrind_indicator();
@@ -469,6 +478,56 @@ MAIN_UNIT_TEST_BEGIN("job_test", "stderr", NULL, cleanup)
   destroy_ringbuf(make_ring_name(wrap_4, disabled));
 
 #undef destroy_ringbuf
+  /* End of clean-up */
+
+  /* Record the CPU statistics of the jobs */
+  jobstats_ringbuf *cpu_ring = jobstats_ringbuf_create_ex(2, 0, 1);
+  gracious_assert(cpu_ring != NULL);
+  gracious_assert(jobstats_ringbuf_cpu_recorded(cpu_ring));
+
+  struct job sleeping_job = {
+    .run_program = sleeping_program,
+    .args = NULL,
+  };
+  gracious_assert(job_start(cpu_ring, &sleeping_job) == 0);
+  gracious_assert(job_start(cpu_ring, &sleeping_job) == 0);
+  gracious_assert(job_skip(cpu_ring) == 0);
+
+  FILE *cpu_stream = tmpfile();
+  gracious_assert(cpu_stream != NULL);
+  gracious_assert(jobstats_ringbuf_save(cpu_ring, cpu_stream) == 0);
+  gracious_assert(jobstats_ringbuf_save_cpu(cpu_ring, cpu_stream) == 0);
+  jobstats_ringbuf_destroy(cpu_ring);
+  rewind(cpu_stream);
+
+  job_statistics saved_jobs[2];
+  job_cpu_statistics saved_cpus[2];
+  gracious_assert(fread(saved_jobs, sizeof(saved_jobs), 1, cpu_stream) == 1);
+  gracious_assert(fread(saved_cpus, sizeof(saved_cpus), 1, cpu_stream) == 1);
+  gracious_assert(fgetc(cpu_stream) == EOF);
+  fclose(cpu_stream);
+
+  /* The oldest one is the second sleeping job */
+  gracious_assert(job_cpu_statistics_cpu_begin(&saved_cpus[0]) >= 0);
+  gracious_assert(job_cpu_statistics_cpu_begin(&saved_cpus[0])
+                  == job_cpu_statistics_cpu_end(&saved_cpus[0]));
+  gracious_assert(job_cpu_statistics_voluntary_switches(&saved_cpus[0]) >= 1);
+
+  /* The skipped job has not run */
+  gracious_assert(job_cpu_statistics_cpu_begin(&saved_cpus[1])
+                  == job_cpu_statistics_cpu_begin(&saved_cpus[0]));
+  gracious_assert(job_cpu_statistics_cpu_end(&saved_cpus[1])
+                  == job_cpu_statistics_cpu_begin(&saved_cpus[1]));
+  gracious_assert(job_cpu_statistics_voluntary_switches(&saved_cpus[1]) == 0);
+  gracious_assert(job_cpu_statistics_involuntary_switches(&saved_cpus[1])
+                  == 0);
+
+  relative_time *cpu_stats_overhead;
+  gracious_assert(job_statistics_overhead_ex(0, 1, &cpu_stats_overhead) == 0);
+  gracious_assert(to_string(cpu_stats_overhead, abs_t, abs_t_len) == 0);
+  log_verbose("Job stats overhead with CPU statistics = %s\n", abs_t);
+  utility_time_gc(cpu_stats_overhead);
+  /* End of recording the CPU statistics of the jobs */
 
   return EXIT_SUCCESS;
 
@@ -0,0 +1,1172 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#define _GNU_SOURCE /* cpu_set_t, etc. */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/wait.h>
+#include "../utility_experimentation.h"
+#include "../task.h"
+#include "../utility_log.h"
+#include "../utility_time.h"
+#include "../utility_file.h"
+#include "../utility_cpu.h"
+#include "../utility_cpu_topology.h"
+#include "../utility_sched_fifo.h"
+#include "../utility_sched_deadline.h"
+#include "../utility_memory.h"
+#include "../utility_taskset.h"
+
+#define NS_PER_S 1000000000ULL
+#define BUSYLOOP_TOLERANCE_US 100
+#define BUSYLOOP_SEARCH_PASSES 10
+#define RT_RUNTIME_PATH "/proc/sys/kernel/sched_rt_runtime_us"
+#define RT_PERIOD_PATH "/proc/sys/kernel/sched_rt_period_us"
+
+/* How the CPUs are shared by the tasks */
+enum mode {
+  MODE_PARTITIONED, /* A cluster for every CPU */
+  MODE_CLUSTERED, /* A cluster for every group of CPUs at cluster_level */
+  MODE_GLOBAL, /* One cluster of all CPUs */
+  MODE_COUNT,
+};
+
+static const char *mode_names[MODE_COUNT] = {
+  "partitioned", "clustered", "global",
+};
+
+/* Command line args section */
+static const char *cpu_list = NULL;
+static int mode_enabled[MODE_COUNT] = {1, 1, 1};
+static enum cpu_topology_level cluster_level = CPU_TOPOLOGY_CACHE;
+
+static int parse_modes(const char *list)
+{
+  char *copy = strdup(list), *saveptr, *name;
+  int i;
+
+  if (copy == NULL) {
+    log_error("Not enough memory to parse the modes");
+    return -1;
+  }
+
+  memset(mode_enabled, 0, sizeof(mode_enabled));
+  for (name = strtok_r(copy, ",", &saveptr); name != NULL;
+       name = strtok_r(NULL, ",", &saveptr)) {
+    for (i = 0; i < MODE_COUNT && strcmp(name, mode_names[i]) != 0; i++) {
+    }
+    if (i == MODE_COUNT) {
+      log_error("Unknown mode '%s' (-h for help)", name);
+      free(copy);
+      return -1;
+    }
+    mode_enabled[i] = 1;
+  }
+  free(copy);
+
+  return 0;
+}
+
+static int parse_cmd_line_args(int argc, char **argv)
+{
+  int optchar;
+  opterr = 0;
+  while ((optchar = getopt(argc, argv, ":hc:m:l:")) != -1) {
+    switch (optchar) {
+    case 'c':
+      cpu_list = optarg;
+      break;
+    case 'm':
+      if (parse_modes(optarg) != 0) {
+        return -1;
+      }
+      break;
+    case 'l':
+      if (strcmp(optarg, "core") == 0) {
+        cluster_level = CPU_TOPOLOGY_CORE;
+      } else if (strcmp(optarg, "cache") == 0) {
+        cluster_level = CPU_TOPOLOGY_CACHE;
+      } else if (strcmp(optarg, "package") == 0) {
+        cluster_level = CPU_TOPOLOGY_PACKAGE;
+      } else {
+        log_error("Unknown cluster level '%s' (-h for help)", optarg);
+        return -1;
+      }
+      break;
+    case 'h':
+      printf("Usage: %s [-c CPU_LIST] [-m MODE[,MODE]...]"
+             " [-l core|cache|package]\n"
+             "       TASKSET_FILE\n"
+             "\n"
+             "This runs the task set described in TASKSET_FILE (see\n"
+             "utility_taskset.h for the format) as SCHED_DEADLINE tasks\n"
+             "on the given CPUs once for every mode and compares the\n"
+             "response times and the CPU migrations of the jobs. The\n"
+             "statistics of task NAME in mode MODE, including the CPUs of\n"
+             "its jobs, is written to TASKSET_FILE_MODE_NAME_stats.bin\n"
+             "where TASKSET_FILE has its .ts extension, if any, removed.\n"
+             "\n"
+             "-c CPU_LIST is a comma-separated list of CPUs and CPU ranges\n"
+             "   like 1,3-5 (default: all online CPUs).\n"
+             "-m MODE is partitioned (EDF on every CPU), clustered (global\n"
+             "   EDF on every cluster of CPUs) or global (global EDF on all\n"
+             "   CPUs) (default: all of them).\n"
+             "-l gives the CPUs sharing a core, a last-level cache or a\n"
+             "   package as the clusters of the clustered mode (default:\n"
+             "   cache).\n",
+             prog_name);
+      return -1;
+    case ':':
+      log_error("Option -%c needs an argument (-h for help)", optopt);
+      return -1;
+    case '?':
+      log_error("Unrecognized option -%c (-h for help)", optopt);
+      return -1;
+    default:
+      log_error("Unexpected return value of fn getopt");
+      return -1;
+    }
+  }
+
+  if (optind != argc - 1) {
+    log_error("Exactly one task set file must be given (-h for help)");
+    return -1;
+  }
+
+  return optind;
+}
+/* END: Command line args section */
+
+/* Return the dynamically allocated path of the given task set file
+   whose .ts extension, if any, is replaced by the given suffix or
+   NULL if there is insufficient memory */
+static char *make_path(const char *taskset_path, const char *suffix)
+{
+  size_t path_len = strlen(taskset_path);
+  char *path;
+
+  if (path_len > 3 && strcmp(&taskset_path[path_len - 3], ".ts") == 0) {
+    path_len -= 3;
+  }
+  path = malloc(path_len + strlen(suffix) + 1);
+  if (path == NULL) {
+    log_error("Not enough memory to allocate a path");
+    return NULL;
+  }
+  memcpy(path, taskset_path, path_len);
+  strcpy(&path[path_len], suffix);
+
+  return path;
+}
+
+/* Return the dynamically allocated path of the statistics file of
+   the given task in the given mode or NULL if there is insufficient
+   memory */
+static char *make_stats_path(const char *taskset_path, const char *mode_name,
+                             const char *task_name)
+{
+  char *suffix, *path;
+
+  suffix = malloc(strlen(mode_name) + strlen(task_name)
+                  + sizeof("___stats.bin"));
+  if (suffix == NULL) {
+    log_error("Not enough memory to allocate a path");
+    return NULL;
+  }
+  sprintf(suffix, "_%s_%s_stats.bin", mode_name, task_name);
+  path = make_path(taskset_path, suffix);
+  free(suffix);
+
+  return path;
+}
+
+static unsigned long long to_ns(const relative_time *t)
+{
+  struct timespec t_spec;
+
+  to_timespec(t, &t_spec);
+  return t_spec.tv_sec * NS_PER_S + t_spec.tv_nsec;
+}
+
+static unsigned long long timespec_ns(const struct timespec *t)
+{
+  return t->tv_sec * NS_PER_S + t->tv_nsec;
+}
+
+/* Return the fraction of a CPU that the kernel admits to
+   SCHED_DEADLINE tasks */
+static double dl_bandwidth_limit(void)
+{
+  FILE *file;
+  long runtime = 950000, period = 1000000;
+
+  file = fopen(RT_RUNTIME_PATH, "r");
+  if (file != NULL) {
+    if (fscanf(file, "%ld", &runtime) != 1) {
+      runtime = 950000;
+    }
+    fclose(file);
+  }
+  file = fopen(RT_PERIOD_PATH, "r");
+  if (file != NULL) {
+    if (fscanf(file, "%ld", &period) != 1 || period <= 0) {
+      period = 1000000;
+    }
+    fclose(file);
+  }
+
+  return runtime < 0 ? 1.0 : (double) runtime / period;
+}
+
+/* CPU frequency section */
+static cpu_freq_governor **cpu_govs = NULL;
+static int cpu_gov_count = 0;
+
+/* Fix the frequency of the given CPUs other than the experiment CPU,
+   whose frequency is fixed by MAIN_BEGIN(), to the maximum */
+static int fix_cpu_freqs(const cpu_set_t *cpus, int experiment_cpu)
+{
+  int cpu;
+
+  cpu_govs = malloc(sizeof(*cpu_govs) * CPU_COUNT(cpus));
+  if (cpu_govs == NULL) {
+    log_error("Not enough memory to allocate the CPU governors");
+    return -1;
+  }
+
+  for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (!CPU_ISSET(cpu, cpus) || cpu == experiment_cpu) {
+      continue;
+    }
+    cpu_govs[cpu_gov_count] = cpu_freq_get_governor(cpu);
+    if (cpu_govs[cpu_gov_count] == NULL) {
+      log_error("Cannot get the governor of CPU %d", cpu);
+      return -1;
+    }
+    cpu_gov_count++;
+    if (cpu_freq_set_max(cpu) != 0) {
+      log_error("Cannot set CPU %d to its maximum frequency", cpu);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+static void restore_cpu_freqs(void)
+{
+  int i;
+
+  for (i = 0; i < cpu_gov_count; i++) {
+    if (cpu_freq_restore_governor(cpu_govs[i]) != 0) {
+      log_error("You must restore the CPU freq governor yourself");
+    }
+  }
+  if (cpu_govs != NULL) {
+    free(cpu_govs);
+  }
+}
+/* END: CPU frequency section */
+
+/* Task section */
+struct task_run
+{
+  const struct taskset_task *desc;
+  double utilization;
+  cpu_busyloop *busyloop; /* NULL under kernel=sleep */
+  struct timespec sleep;
+  unsigned long long period_ns;
+  unsigned long job_capacity;
+  /* The following are set for each mode */
+  unsigned cluster;
+  const cpu_set_t *cpus;
+  task *tau;
+  pthread_t thread;
+  int thread_created;
+  int rc;
+};
+
+static void task_run_prog(void *args)
+{
+  struct task_run *run = args;
+
+  if (run->busyloop != NULL) {
+    keep_cpu_busy(run->busyloop);
+  } else {
+    clock_nanosleep(CLOCK_MONOTONIC, 0, &run->sleep, NULL);
+  }
+}
+
+static void *task_thread(void *args)
+{
+  struct task_run *run = args;
+  const struct taskset_task *t = run->desc;
+
+  /* SCHED_DEADLINE needs the affinity to span the root domain */
+  if ((errno = pthread_setaffinity_np(pthread_self(), sizeof(*run->cpus),
+                                      run->cpus)) != 0) {
+    log_syserror("Task %s cannot move to its cluster", t->name);
+    run->rc = -2;
+    goto out;
+  }
+
+  run->rc = sched_deadline_enter_ex(&t->wcet, &t->deadline, &t->period, 0,
+                                    NULL);
+  if (run->rc == -3) {
+    log_error("The kernel rejects the bandwidth of task %s", t->name);
+    goto out;
+  } else if (run->rc != 0) {
+    log_error("Task %s cannot become SCHED_DEADLINE thread", t->name);
+    goto out;
+  }
+
+  memory_preallocate_stack(1024);
+
+  if (task_start(run->tau) != 0) {
+    log_error("Task %s does not complete successfully", t->name);
+    run->rc = -2;
+    goto out;
+  }
+
+  run->rc = 0;
+
+ out:
+  return &run->rc;
+}
+/* END: Task section */
+
+/* Cluster section */
+struct cluster
+{
+  cpu_set_t cpus;
+  double load;
+  unsigned task_count;
+  cpuset_partition *part; /* NULL if not needed */
+  pid_t proc_id;
+};
+
+/* Run the tasks of the given cluster in the calling child process
+   until t_stop returning EXIT_SUCCESS if successful or EXIT_FAILURE
+   otherwise */
+static int run_cluster(const char *taskset_path, const char *mode_name,
+                       struct cluster *c, unsigned cluster_idx,
+                       struct task_run *runs, unsigned task_count,
+                       const struct timespec *t_release,
+                       const struct timespec *t_stop,
+                       const relative_time *job_stats_overhead,
+                       const relative_time *task_overhead)
+{
+  int exit_code = EXIT_FAILURE;
+  unsigned i;
+  int rc;
+
+  if (c->part != NULL && cpuset_partition_join(c->part) != 0) {
+    log_error("Cannot join the cpuset partition of cluster %u", cluster_idx);
+    return EXIT_FAILURE;
+  }
+  if (sched_setaffinity(0, sizeof(c->cpus), &c->cpus) != 0) {
+    log_syserror("Cannot move to cluster %u", cluster_idx);
+    return EXIT_FAILURE;
+  }
+
+  if (memory_lock() != 0) {
+    log_error("Cannot lock current and future memory");
+    return EXIT_FAILURE;
+  }
+  memory_preallocate_stack(1024);
+
+  /* Create the tasks */
+  for (i = 0; i < task_count; i++) {
+    struct task_run *run = &runs[i];
+    const struct taskset_task *t = run->desc;
+    char *stats_path;
+
+    if (run->cluster != cluster_idx) {
+      continue;
+    }
+
+    stats_path = make_stats_path(taskset_path, mode_name, t->name);
+    if (stats_path == NULL) {
+      goto error;
+    }
+
+    rc = task_create(t->name, &t->wcet, &t->period, &t->deadline,
+                     timespec_to_utility_time_dyn(t_release), &t->offset,
+                     NULL, NULL, stats_path, run->job_capacity,
+                     TASK_RINGBUF_DISABLE_OVERRUN | TASK_RINGBUF_RECORD_CPU,
+                     job_stats_overhead, task_overhead,
+                     task_run_prog, run, &run->tau);
+    if (rc == -2) {
+      log_error("Cannot open %s", stats_path);
+      free(stats_path);
+      goto error;
+    } else if (rc != 0) {
+      log_error("Cannot create %s", t->name);
+      free(stats_path);
+      goto error;
+    }
+    free(stats_path);
+
+    if (task_set_fast_stop(run->tau) != 0) {
+      log_error("Cannot enable the fast stop of %s", t->name);
+      goto error;
+    }
+  }
+  /* END: Create the tasks */
+
+  /* Be task manager */
+  if (sched_fifo_enter_max(NULL) != 0) {
+    log_error("Cannot become task manager");
+    goto error;
+  }
+  /* END: Be task manager */
+
+  /* Create task threads */
+  for (i = 0; i < task_count; i++) {
+    if (runs[i].cluster != cluster_idx) {
+      continue;
+    }
+    if ((errno = pthread_create(&runs[i].thread, NULL, task_thread,
+                                &runs[i])) != 0) {
+      log_syserror("Cannot create task thread of %s", runs[i].desc->name);
+      goto stop;
+    }
+    runs[i].thread_created = 1;
+  }
+  /* END: Create task threads */
+
+  /* Wait for stopping time */
+  if (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, t_stop, NULL) != 0) {
+    log_syserror("Task manager fails to wait for the stopping time");
+    goto stop;
+  }
+  /* END: Wait for stopping time */
+
+  exit_code = EXIT_SUCCESS;
+
+ stop:
+  /* Stop the tasks */
+  for (i = 0; i < task_count; i++) {
+    if (runs[i].thread_created) {
+      task_stop(runs[i].tau);
+    }
+  }
+  /* END: Stop the tasks */
+
+  /* Join task threads and check task return statuses */
+  for (i = 0; i < task_count; i++) {
+    if (!runs[i].thread_created) {
+      continue;
+    }
+    if ((errno = pthread_join(runs[i].thread, NULL)) != 0) {
+      log_syserror("Cannot join %s thread", runs[i].desc->name);
+      exit_code = EXIT_FAILURE;
+    } else if (runs[i].rc != 0) {
+      log_error("Task %s does not return successfully (rc = %d)",
+                runs[i].desc->name, runs[i].rc);
+      exit_code = EXIT_FAILURE;
+    }
+  }
+  /* END: Join task threads and check task return statuses */
+
+ error:
+  for (i = 0; i < task_count; i++) {
+    if (runs[i].tau != NULL) {
+      task_destroy(runs[i].tau);
+    }
+  }
+
+  return exit_code;
+}
+
+static int run_cmp(const void *a, const void *b)
+{
+  const struct task_run *run_a = *(struct task_run **) a;
+  const struct task_run *run_b = *(struct task_run **) b;
+
+  if (run_a->utilization > run_b->utilization) {
+    return -1;
+  } else if (run_a->utilization < run_b->utilization) {
+    return 1;
+  }
+  return 0;
+}
+
+/* Assign the tasks to the clusters using first-fit decreasing
+   utilization up to the bandwidth admitted by the kernel returning 0
+   if successful or -1 if some task does not fit */
+static int assign_tasks(struct task_run *runs, unsigned task_count,
+                        struct cluster *clusters, unsigned cluster_count,
+                        double bandwidth_limit)
+{
+  struct task_run **sorted = malloc(sizeof(*sorted) * task_count);
+  unsigned i, j;
+
+  if (sorted == NULL) {
+    log_error("Not enough memory to assign the tasks");
+    return -1;
+  }
+  for (i = 0; i < task_count; i++) {
+    sorted[i] = &runs[i];
+  }
+  qsort(sorted, task_count, sizeof(*sorted), run_cmp);
+
+  for (i = 0; i < task_count; i++) {
+    for (j = 0; j < cluster_count; j++) {
+      if (clusters[j].load + sorted[i]->utilization
+          <= CPU_COUNT(&clusters[j].cpus) * bandwidth_limit + 1e-9) {
+        break;
+      }
+    }
+    if (j == cluster_count) {
+      printf("Task %s (U = %.3f) fits in no cluster\n", sorted[i]->desc->name,
+             sorted[i]->utilization);
+      free(sorted);
+      return -1;
+    }
+    sorted[i]->cluster = j;
+    sorted[i]->cpus = &clusters[j].cpus;
+    clusters[j].load += sorted[i]->utilization;
+    clusters[j].task_count++;
+  }
+
+  free(sorted);
+  return 0;
+}
+/* END: Cluster section */
+
+/* Result section */
+struct mode_result
+{
+  int done;
+  unsigned cluster_count;
+  unsigned long job_count;
+  unsigned long late_count;
+  unsigned long migration_count;
+  double p99; /* Of the response times normalized by the deadlines */
+  double p999;
+  double max;
+};
+
+static int double_cmp(const void *a, const void *b)
+{
+  double x = *(const double *) a, y = *(const double *) b;
+
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/* Return the p-quantile of the given sorted values */
+static double quantile(const double *values, unsigned long count, double p)
+{
+  unsigned long idx = (unsigned long) (p * count + 0.999999);
+
+  if (count == 0) {
+    return 0;
+  }
+  return values[idx == 0 ? 0 : (idx > count ? count : idx) - 1];
+}
+
+/* The jobs of a task read from its statistics file */
+struct job_reader
+{
+  unsigned long long t_first_release_ns;
+  unsigned long long period_ns;
+  unsigned long nth_job; /* The release position of the next job */
+  unsigned long job_count;
+  unsigned long capacity;
+  unsigned long long *response_ns; /* Of the jobs in the order read */
+  unsigned long migration_count;
+  int prev_cpu; /* The CPU at which the previous job finished */
+};
+
+static int read_task(task *tau, void *args)
+{
+  struct job_reader *prms = args;
+  struct timespec t_0, offset, period;
+
+  to_timespec_gc(task_statistics_t0(tau), &t_0);
+  to_timespec_gc(task_statistics_offset(tau), &offset);
+  to_timespec_gc(task_statistics_period(tau), &period);
+  prms->t_first_release_ns = timespec_ns(&t_0) + timespec_ns(&offset);
+  prms->period_ns = timespec_ns(&period);
+  prms->nth_job = task_statistics_oldest_job_pos(tau);
+
+  return 0;
+}
+
+static int read_job(job_statistics *stats, void *args)
+{
+  struct job_reader *prms = args;
+  struct timespec t_finish;
+
+  if (prms->job_count == prms->capacity) {
+    log_error("The statistics file has more jobs than expected");
+    return -1;
+  }
+
+  to_timespec_gc(job_statistics_time_finish(stats), &t_finish);
+  prms->response_ns[prms->job_count++]
+    = (timespec_ns(&t_finish) - prms->t_first_release_ns
+       - (prms->nth_job - 1) * prms->period_ns);
+  prms->nth_job++;
+
+  return 0;
+}
+
+/* Count a migration between the previous job and this one as well as
+   one within this job */
+static int read_job_cpu(job_cpu_statistics *stats, void *args)
+{
+  struct job_reader *prms = args;
+  int cpu_begin = job_cpu_statistics_cpu_begin(stats);
+  int cpu_end = job_cpu_statistics_cpu_end(stats);
+
+  prms->migration_count += ((prms->prev_cpu != -1
+                             && prms->prev_cpu != cpu_begin)
+                            + (cpu_begin != cpu_end));
+  prms->prev_cpu = cpu_end;
+
+  return 0;
+}
+
+/* Read the statistics file of the given task in the given mode
+   returning 0 if successful or -1 otherwise */
+static int read_jobs(const char *taskset_path, const char *mode_name,
+                     const struct task_run *run, struct job_reader *reader)
+{
+  const struct task_statistics_callbacks callbacks = {
+    .task_statistics_fn = read_task,
+    .task_statistics_fn_args = reader,
+    .job_statistics_fn = read_job,
+    .job_statistics_fn_args = reader,
+    .job_cpu_statistics_fn = read_job_cpu,
+    .job_cpu_statistics_fn_args = reader,
+  };
+  char *stats_path;
+  FILE *stats_file;
+  int rc;
+
+  stats_path = make_stats_path(taskset_path, mode_name, run->desc->name);
+  if (stats_path == NULL) {
+    return -1;
+  }
+  stats_file = utility_file_open_for_reading_bin(stats_path);
+  if (stats_file == NULL) {
+    log_error("Cannot open task stat file '%s'", stats_path);
+    free(stats_path);
+    return -1;
+  }
+  rc = task_statistics_read_full(stats_file, &callbacks);
+  utility_file_close(stats_file, stats_path);
+  if (rc != 0) {
+    log_error("Cannot read task stat file '%s'", stats_path);
+    free(stats_path);
+    return -1;
+  }
+  free(stats_path);
+
+  return 0;
+}
+
+/* Print the response times and the migrations of the jobs of every
+   task as recorded in its statistics file, and summarize the mode
+   returning 0 if successful or -1 otherwise */
+static int report_mode(const char *taskset_path, const char *mode_name,
+                       struct task_run *runs, unsigned task_count,
+                       struct mode_result *result)
+{
+  unsigned long total_capacity = 0, max_capacity = 0, pos;
+  double *all_normalized, *normalized;
+  unsigned long long *response_ns;
+  unsigned i;
+
+  for (i = 0; i < task_count; i++) {
+    total_capacity += runs[i].job_capacity;
+    if (runs[i].job_capacity > max_capacity) {
+      max_capacity = runs[i].job_capacity;
+    }
+  }
+  all_normalized = malloc(sizeof(*all_normalized) * (total_capacity + 1));
+  normalized = malloc(sizeof(*normalized) * (max_capacity + 1));
+  response_ns = malloc(sizeof(*response_ns) * (max_capacity + 1));
+  if (all_normalized == NULL || normalized == NULL || response_ns == NULL) {
+    log_error("Not enough memory to summarize the mode");
+    goto error;
+  }
+
+  printf("%-31s %7s %7s %8s %14s %14s %10s\n", "task", "cluster", "jobs",
+         "late", "p99_response", "max_response", "migrations");
+  for (i = 0; i < task_count; i++) {
+    const struct task_run *run = &runs[i];
+    unsigned long long deadline_ns = to_ns(&run->desc->deadline);
+    unsigned long late_count = 0;
+    struct job_reader reader = {
+      .job_count = 0,
+      .capacity = run->job_capacity,
+      .response_ns = response_ns,
+      .migration_count = 0,
+      .prev_cpu = -1,
+    };
+
+    if (read_jobs(taskset_path, mode_name, run, &reader) != 0) {
+      goto error;
+    }
+
+    for (pos = 0; pos < reader.job_count; pos++) {
+      normalized[pos] = (double) response_ns[pos] / deadline_ns;
+      all_normalized[result->job_count + pos] = normalized[pos];
+      if (response_ns[pos] > deadline_ns) {
+        late_count++;
+      }
+    }
+
+    qsort(normalized, reader.job_count, sizeof(*normalized), double_cmp);
+    printf("%-31s %7u %7lu %8lu %14.9f %14.9f %10lu\n", run->desc->name,
+           run->cluster, reader.job_count, late_count,
+           quantile(normalized, reader.job_count, 0.99) * deadline_ns
+           / NS_PER_S,
+           quantile(normalized, reader.job_count, 1) * deadline_ns / NS_PER_S,
+           reader.migration_count);
+
+    result->job_count += reader.job_count;
+    result->late_count += late_count;
+    result->migration_count += reader.migration_count;
+  }
+
+  qsort(all_normalized, result->job_count, sizeof(*all_normalized),
+        double_cmp);
+  result->p99 = quantile(all_normalized, result->job_count, 0.99);
+  result->p999 = quantile(all_normalized, result->job_count, 0.999);
+  result->max = quantile(all_normalized, result->job_count, 1);
+  result->done = 1;
+
+  free(response_ns);
+  free(normalized);
+  free(all_normalized);
+  return 0;
+
+ error:
+  if (response_ns != NULL) {
+    free(response_ns);
+  }
+  if (normalized != NULL) {
+    free(normalized);
+  }
+  if (all_normalized != NULL) {
+    free(all_normalized);
+  }
+  return -1;
+}
+/* END: Result section */
+
+/* Run the tasks in the given mode returning 0 if successful, 1 if
+   the tasks cannot be run in the mode, or -1 otherwise */
+static int run_mode(const char *taskset_path, const taskset_desc *ts,
+                    enum mode mode, const cpu_topology *topo,
+                    const cpu_set_t *cpus, struct task_run *runs,
+                    unsigned task_count,
+                    const relative_time *job_stats_overhead,
+                    const relative_time *task_overhead,
+                    struct mode_result *result)
+{
+  static const enum cpu_topology_level levels[MODE_COUNT] = {
+    CPU_TOPOLOGY_CPU, CPU_TOPOLOGY_CACHE, CPU_TOPOLOGY_SYSTEM,
+  };
+  enum cpu_topology_level level = (mode == MODE_CLUSTERED
+                                   ? cluster_level : levels[mode]);
+  cpu_set_t *cluster_cpus = NULL;
+  struct cluster *clusters = NULL;
+  unsigned cluster_count = 0;
+  int rc = -1;
+  unsigned i;
+
+  printf("\n=== Mode %s ===\n", mode_names[mode]);
+
+  if (cpu_topology_clusters(topo, level, cpus, &cluster_cpus, &cluster_count)
+      != 0) {
+    log_error("Cannot make the clusters");
+    return -1;
+  }
+  clusters = calloc(cluster_count, sizeof(*clusters));
+  if (clusters == NULL) {
+    log_error("Not enough memory to allocate the clusters");
+    goto out;
+  }
+  for (i = 0; i < cluster_count; i++) {
+    clusters[i].cpus = cluster_cpus[i];
+    clusters[i].proc_id = -1;
+  }
+  result->cluster_count = cluster_count;
+
+  if (assign_tasks(runs, task_count, clusters, cluster_count,
+                   dl_bandwidth_limit()) != 0) {
+    printf("The task set cannot be run %s\n", mode_names[mode]);
+    rc = 1;
+    goto out;
+  }
+
+  for (i = 0; i < cluster_count; i++) {
+    char cpu_str[256];
+    unsigned j;
+
+    cpu_list_format(&clusters[i].cpus, cpu_str, sizeof(cpu_str));
+    printf("Cluster %u (CPUs %s, U = %.3f):", i, cpu_str, clusters[i].load);
+    for (j = 0; j < task_count; j++) {
+      if (runs[j].cluster == i) {
+        printf(" %s", runs[j].desc->name);
+      }
+    }
+    printf("\n");
+  }
+
+  /* Make every cluster a root domain of its own */
+  if (cluster_count > 1
+      || !CPU_EQUAL(&clusters[0].cpus, cpu_topology_online(topo))) {
+    for (i = 0; i < cluster_count; i++) {
+      char name[64];
+
+      if (clusters[i].task_count == 0) {
+        continue;
+      }
+      snprintf(name, sizeof(name), "multicore_EDF.%d.%u", (int) getpid(), i);
+      switch (cpuset_partition_create(name, &clusters[i].cpus,
+                                      &clusters[i].part)) {
+      case 0:
+        break;
+      case -1:
+        log_error("Insufficient privilege to create cpuset partitions");
+        goto out;
+      case -3:
+        log_error("No cgroup v2 hierarchy has the cpuset controller to make"
+                  " the cpuset partitions of the clusters");
+        rc = 1;
+        goto out;
+      default:
+        log_error("Cannot create the cpuset partition of cluster %u", i);
+        goto out;
+      }
+    }
+  }
+  /* END: Make every cluster a root domain of its own */
+
+  /* Calculate the absolute starting & ending time */
+  struct timespec t_now, t_release, t_stop;
+  if (clock_gettime(CLOCK_MONOTONIC, &t_now) != 0) {
+    log_syserror("Cannot get t_now");
+    goto out;
+  }
+  to_timespec_gc(utility_time_add_dyn_gc(timespec_to_utility_time_dyn(&t_now),
+                                         utility_time_to_utility_time_dyn
+                                         (taskset_start(ts))),
+                 &t_release);
+  to_timespec_gc(utility_time_add_dyn_gc(timespec_to_utility_time_dyn(&t_now),
+                                         utility_time_to_utility_time_dyn
+                                         (taskset_stop(ts))),
+                 &t_stop);
+  /* END: Calculate the absolute starting & ending time */
+
+  /* Run every cluster in its own process */
+  fflush(stdout);
+  rc = 0;
+  for (i = 0; i < cluster_count; i++) {
+    if (clusters[i].task_count == 0) {
+      continue;
+    }
+    clusters[i].proc_id = fork();
+    if (clusters[i].proc_id == -1) {
+      log_syserror("Cannot fork the process of cluster %u", i);
+      rc = -1;
+      break;
+    } else if (clusters[i].proc_id == 0) {
+      int exit_code = run_cluster(taskset_path, mode_names[mode],
+                                  &clusters[i], i, runs, task_count,
+                                  &t_release, &t_stop, job_stats_overhead,
+                                  task_overhead);
+      /* Leave the CPU governors to the parent */
+      fflush(stdout);
+      fflush(log_stream);
+      _exit(exit_code);
+    }
+  }
+
+  for (i = 0; i < cluster_count; i++) {
+    int status;
+    pid_t proc_id;
+
+    if (clusters[i].proc_id <= 0) {
+      continue;
+    }
+    if (rc != 0) {
+      kill(clusters[i].proc_id, SIGKILL);
+    }
+    while ((proc_id = waitpid(clusters[i].proc_id, &status, 0)) == -1
+           && errno == EINTR) {
+    }
+    if (proc_id == -1) {
+      log_syserror("Cannot wait for the process of cluster %u", i);
+      rc = -1;
+    } else if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+      log_error("The process of cluster %u fails", i);
+      rc = -1;
+    }
+  }
+  /* END: Run every cluster in its own process */
+
+  if (rc == 0) {
+    rc = report_mode(taskset_path, mode_names[mode], runs, task_count,
+                     result);
+  }
+
+ out:
+  if (clusters != NULL) {
+    for (i = 0; i < cluster_count; i++) {
+      if (clusters[i].part != NULL) {
+        cpuset_partition_destroy(clusters[i].part);
+      }
+    }
+    free(clusters);
+  }
+  if (cluster_cpus != NULL) {
+    free(cluster_cpus);
+  }
+
+  return rc;
+}
+
+/* Run the given task set in every enabled mode on the given CPUs
+   returning EXIT_SUCCESS if successful or EXIT_FAILURE otherwise */
+static int run_taskset(const char *taskset_path, const cpu_topology *topo,
+                       const cpu_set_t *cpus, int experiment_cpu)
+{
+  taskset_desc *ts = NULL;
+  unsigned task_count = 0;
+  struct task_run *runs = NULL;
+  relative_time *job_stats_overhead = NULL;
+  relative_time *task_overhead = NULL;
+  relative_time *overhead = NULL;
+  relative_time *busyloop_tolerance = NULL;
+  struct mode_result results[MODE_COUNT];
+  int exit_code = EXIT_FAILURE;
+  char t_str[32];
+  unsigned i;
+  int m;
+
+  memset(results, 0, sizeof(results));
+
+  if (taskset_load(taskset_path, &ts) != 0) {
+    return EXIT_FAILURE;
+  }
+  task_count = taskset_task_count(ts);
+
+  if (taskset_resource_count(ts) != 0) {
+    log_error("%s has resources, which cannot be shared across clusters",
+              taskset_path);
+    goto error;
+  }
+  if (taskset_has_cpu_binding(ts)) {
+    log_error("%s binds a task to a CPU, which conflicts with the modes",
+              taskset_path);
+    goto error;
+  }
+
+  runs = calloc(task_count, sizeof(*runs));
+  if (runs == NULL) {
+    log_error("Not enough memory to run the task set");
+    goto error;
+  }
+
+  /* Determining overheads */
+  if (job_statistics_overhead_ex(experiment_cpu, 1, &job_stats_overhead)
+      != 0) {
+    log_error("Cannot obtain job statistics overhead");
+    goto error;
+  }
+  utility_time_set_gc_manual(job_stats_overhead);
+  to_string(job_stats_overhead, t_str, sizeof(t_str));
+  printf("job_stats_overhead: %s\n", t_str);
+
+  if (finish_to_start_overhead(experiment_cpu, 0, &task_overhead) != 0) {
+    log_error("Cannot obtain finish to start overhead");
+    goto error;
+  }
+  utility_time_set_gc_manual(task_overhead);
+  to_string(task_overhead, t_str, sizeof(t_str));
+  printf("     task_overhead: %s\n", t_str);
+
+  overhead = utility_time_add_dyn_gc(job_stats_overhead, task_overhead);
+  utility_time_set_gc_manual(overhead);
+  /* END: Determining overheads */
+
+  /* Create needed busyloops */
+  busyloop_tolerance = to_utility_time_dyn(BUSYLOOP_TOLERANCE_US, us);
+  utility_time_set_gc_manual(busyloop_tolerance);
+  for (i = 0; i < task_count; i++) {
+    struct task_run *run = &runs[i];
+    const struct taskset_task *t = taskset_task(ts, i);
+    relative_time length;
+    int rc;
+
+    run->desc = t;
+    run->period_ns = to_ns(&t->period);
+    run->utilization = (double) to_ns(&t->wcet) / run->period_ns;
+    /* Including the job that would be run by task_stop() without the
+       fast stop */
+    run->job_capacity = ((to_ns(taskset_stop(ts)) - to_ns(taskset_start(ts)))
+                         / run->period_ns + 2);
+    if (t->policy != TASKSET_POLICY_DEADLINE) {
+      printf("Task %s is run as SCHED_DEADLINE\n", t->name);
+    }
+
+    if (t->kernel == TASKSET_KERNEL_SLEEP) {
+      to_timespec(&t->wcet, &run->sleep);
+      continue;
+    }
+
+    if (utility_time_le(&t->wcet, overhead)) {
+      log_error("%s C is too small", t->name);
+      goto error;
+    }
+    utility_time_init(&length);
+    utility_time_sub(&t->wcet, overhead, &length);
+    rc = create_cpu_busyloop(experiment_cpu,
+                             utility_time_to_utility_time_dyn(&length),
+                             busyloop_tolerance, BUSYLOOP_SEARCH_PASSES,
+                             &run->busyloop);
+    if (rc == -2) {
+      log_error("%s C is too small to create busyloop", t->name);
+      goto error;
+    } else if (rc == -4) {
+      log_error("%s C is too big to create busyloop", t->name);
+      goto error;
+    } else if (rc != 0) {
+      log_error("Cannot create busyloop for %s", t->name);
+      goto error;
+    }
+  }
+  /* END: Create needed busyloops */
+
+  exit_code = EXIT_SUCCESS;
+  for (m = 0; m < MODE_COUNT; m++) {
+    if (!mode_enabled[m]) {
+      continue;
+    }
+    if (run_mode(taskset_path, ts, m, topo, cpus, runs, task_count,
+                 job_stats_overhead, task_overhead, &results[m]) == -1) {
+      exit_code = EXIT_FAILURE;
+    }
+  }
+
+  /* Compare the modes */
+  {
+    char cpu_str[256];
+
+    cpu_list_format(cpus, cpu_str, sizeof(cpu_str));
+    printf("\nTask set %s on CPUs %s (response times R normalized by the"
+           " deadlines D)\n", taskset_path, cpu_str);
+  }
+  printf("%-11s %8s %8s %8s %10s %10s %10s %10s\n", "mode", "clusters",
+         "jobs", "late", "p99_R/D", "p99.9_R/D", "max_R/D", "migrations");
+  for (m = 0; m < MODE_COUNT; m++) {
+    const struct mode_result *r = &results[m];
+    if (!mode_enabled[m]) {
+      continue;
+    }
+    if (!r->done) {
+      printf("%-11s %8s\n", mode_names[m], "not run");
+      continue;
+    }
+    printf("%-11s %8u %8lu %8lu %10.3f %10.3f %10.3f %10lu\n", mode_names[m],
+           r->cluster_count, r->job_count, r->late_count, r->p99, r->p999,
+           r->max, r->migration_count);
+  }
+  /* END: Compare the modes */
+
+ error:
+  /* Clean-up */
+  if (runs != NULL) {
+    for (i = 0; i < task_count; i++) {
+      if (runs[i].busyloop != NULL) {
+        destroy_cpu_busyloop(runs[i].busyloop);
+      }
+    }
+    free(runs);
+  }
+
+  if (busyloop_tolerance != NULL) {
+    utility_time_gc(busyloop_tolerance);
+  }
+  if (overhead != NULL) {
+    utility_time_gc(overhead);
+  }
+  if (task_overhead != NULL) {
+    utility_time_gc(task_overhead);
+  }
+  if (job_stats_overhead != NULL) {
+    utility_time_gc(job_stats_overhead);
+  }
+
+  taskset_destroy(ts);
+
+  return exit_code;
+}
+
+MAIN_BEGIN("multicore_EDF", "stderr", NULL)
+{
+  cpu_topology *topo;
+  cpu_set_t cpus;
+  int exit_code;
+
+  int arg_idx = parse_cmd_line_args(argc, argv);
+  if (arg_idx == -1) {
+    return EXIT_FAILURE;
+  }
+
+  if (cpu_topology_load(NULL, &topo) != 0) {
+    fatal_error("Cannot read the CPU topology");
+  }
+  if (cpu_list == NULL) {
+    cpus = *cpu_topology_online(topo);
+  } else if (cpu_list_parse(cpu_list, &cpus) != 0) {
+    fatal_error("Invalid CPU list '%s' (-h for help)", cpu_list);
+  } else {
+    cpu_set_t online_cpus;
+    CPU_AND(&online_cpus, &cpus, cpu_topology_online(topo));
+    if (!CPU_EQUAL(&online_cpus, &cpus) || CPU_COUNT(&cpus) == 0) {
+      fatal_error("CPU list '%s' has no or offline CPUs", cpu_list);
+    }
+  }
+
+  if (fix_cpu_freqs(&cpus, experiment_cpu) != 0) {
+    restore_cpu_freqs();
+    fatal_error("Cannot fix the frequencies of the CPUs");
+  }
+
+  exit_code = run_taskset(argv[arg_idx], topo, &cpus, experiment_cpu);
+
+  restore_cpu_freqs();
+  cpu_topology_destroy(topo);
+
+  return exit_code;
+
+} MAIN_END
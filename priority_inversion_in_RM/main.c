@@ -15,45 +15,81 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
  *****************************************************************************/
 
-#define _GNU_SOURCE /* To use PTHREAD_PRIO_NONE and friends */
-
 #include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include <pthread.h>
 #include <signal.h>
 #include <time.h>
 #include "../utility_log.h"
+#include "../utility_lock.h"
 #include "../utility_experimentation.h"
 #include "../utility_time.h"
 #include "../task.h"
 #include "../utility_memory.h"
 
+#define R1_SAMPLE_CAPACITY 16
+
 struct tau_prog_prms
 {
-  pthread_mutex_t *R1;
+  rt_lock *R1;
+  lockfree_object *R1_lockfree; /* Used instead of R1 if not NULL */
   cpu_busyloop *busyloop_10;
   cpu_busyloop *busyloop_30;
   cpu_busyloop *busyloop_500;
   int exit_code;
 };
 
-static void tau_1_prog(void *args)
+static void update_R1(void *value, void *args)
 {
-  struct tau_prog_prms *prms = args;
-  prms->exit_code = -1;
+  keep_cpu_busy(args);
+  ++*(uint64_t *) value;
+}
 
-  keep_cpu_busy(prms->busyloop_10);
+/**
+ * Execute the critical section of R1 for the duration of the given
+ * busyloop.
+ *
+ * @return 0 if successful or -1 otherwise.
+ */
+static int use_R1(const char *name, struct tau_prog_prms *prms,
+                  cpu_busyloop *busyloop)
+{
+  if (prms->R1_lockfree != NULL) {
+    if (lockfree_object_update(prms->R1_lockfree, update_R1, busyloop) != 0) {
+      log_error("%s cannot update R1", name);
+      return -1;
+    }
+    return 0;
+  }
 
-  if ((errno = pthread_mutex_lock(prms->R1)) != 0) {
-    log_syserror("Tau_3 cannot lock R1");
-    return;
+  task_block_begin();
+  if (rt_lock_acquire(prms->R1) != 0) {
+    log_error("%s cannot lock R1", name);
+    return -1;
   }
+  task_block_end(1);
+
+  keep_cpu_busy(busyloop);
+
+  if (rt_lock_release(prms->R1) != 0) {
+    log_error("%s cannot unlock R1", name);
+    return -1;
+  }
+
+  return 0;
+}
+
+static void tau_1_prog(void *args)
+{
+  struct tau_prog_prms *prms = args;
+  prms->exit_code = -1;
 
   keep_cpu_busy(prms->busyloop_10);
 
-  if ((errno = pthread_mutex_unlock(prms->R1)) != 0) {
-    log_syserror("Tau_3 cannot unlock R1");
+  if (use_R1("Tau_1", prms, prms->busyloop_10) != 0) {
     return;
   }
 
@@ -77,15 +113,7 @@ static void tau_3_prog(void *args)
 
   keep_cpu_busy(prms->busyloop_10);
 
-  if ((errno = pthread_mutex_lock(prms->R1)) != 0) {
-    log_syserror("Tau_3 cannot lock R1");
-    return;
-  }
-
-  keep_cpu_busy(prms->busyloop_30);
-
-  if ((errno = pthread_mutex_unlock(prms->R1)) != 0) {
-    log_syserror("Tau_3 cannot unlock R1");
+  if (use_R1("Tau_3", prms, prms->busyloop_30) != 0) {
     return;
   }
 
@@ -102,7 +130,7 @@ struct one_time_release_prms
   sigset_t mask;
 };
 
-static void one_time_release(void *args)
+static int one_time_release(void *args)
 {
   struct one_time_release_prms *prms = args;
 
@@ -116,6 +144,8 @@ static void one_time_release(void *args)
       log_syserror("Task %s cannot wait for the release time", prms->name);
     }
   }
+
+  return 0;
 }
 
 struct task_thread_prms {
@@ -163,15 +193,26 @@ MAIN_BEGIN("priority_inversion_in_RM", "stderr", NULL)
     fatal_error("Cannot lock current and future memory");
   }
 
-  int mutex_protocol = PTHREAD_PRIO_NONE;
+  enum rt_lock_protocol R1_protocol = RT_LOCK_NONE;
+  int use_lockfree = 0;
 
   if (argc != 2) {
-    fatal_error("Usage: %s USE_PRIORITY_INHERITANCE\n"
-                "Replace USE_PRIORITY_INHERITANCE with 0 to not use PI.\n"
-                "Replace it with a non-zero to use PI.", argv[0]);
+    fatal_error("Usage: %s PROTOCOL\n"
+                "Replace PROTOCOL with none (or 0), inherit (or 1),"
+                " protect, srp or lockfree\n"
+                "to protect R1 with no protocol, priority inheritance,"
+                " immediate priority\n"
+                "ceiling, Stack Resource Policy or lock-free updates,"
+                " respectively.", argv[0]);
   }
-  if (atoi(argv[1]) != 0) {
-    mutex_protocol = PTHREAD_PRIO_INHERIT;
+  if (strcmp(argv[1], "0") == 0) {
+    R1_protocol = RT_LOCK_NONE;
+  } else if (strcmp(argv[1], "1") == 0) {
+    R1_protocol = RT_LOCK_INHERIT;
+  } else if (strcmp(argv[1], "lockfree") == 0) {
+    use_lockfree = 1;
+  } else if (rt_lock_protocol_parse(argv[1], &R1_protocol) != 0) {
+    fatal_error("Unknown protocol %s", argv[1]);
   }
 
   /* Tuneable parameters */
@@ -190,7 +231,8 @@ MAIN_BEGIN("priority_inversion_in_RM", "stderr", NULL)
   task *tau_1 = NULL;
   task *tau_2 = NULL;
   task *tau_3 = NULL;
-  int R1_initialized = 0;
+  rt_lock *R1 = NULL;
+  lockfree_object *R1_lockfree = NULL;
 
   /* Determining overheads */
   relative_time *job_stats_overhead = NULL;
@@ -249,25 +291,34 @@ MAIN_BEGIN("priority_inversion_in_RM", "stderr", NULL)
   /* END: Create needed busyloop objects */
 
   /* Create the shared resource object */
-  pthread_mutex_t R1;
-  {
-    pthread_mutexattr_t R1_attr;
-    pthread_mutexattr_init(&R1_attr);
-    if ((errno = pthread_mutexattr_setprotocol(&R1_attr, mutex_protocol))
+  if (use_lockfree) {
+    uint64_t R1_value = 0;
+    if (lockfree_object_create(sizeof(R1_value), &R1_value, 2,
+                               R1_SAMPLE_CAPACITY, &R1_lockfree) != 0) {
+      log_error("Cannot create lock-free R1");
+      goto error;
+    }
+  } else {
+    /* Tau_1 has the highest priority among the users of R1 */
+    int R1_ceiling;
+    if (sched_fifo_prio(1, &R1_ceiling) != 0) {
+      log_error("Cannot determine the priority ceiling of R1");
+      goto error;
+    }
+    if (rt_lock_create(R1_protocol, R1_ceiling, R1_SAMPLE_CAPACITY, &R1)
         != 0) {
-        log_syserror("Cannot set R1 protocol to plain mutex");
-        goto error;
-      }
-    pthread_mutex_init(&R1, &R1_attr);
-    R1_initialized = 1;
-    pthread_mutexattr_destroy(&R1_attr);
+      log_error("Cannot create R1 using protocol %s",
+                rt_lock_protocol_name(R1_protocol));
+      goto error;
+    }
   }
   /* END: Create the shared resource object */
 
   /* Create task parameter objects */
 #define create_task_prog_prms(id)                       \
   struct tau_prog_prms tau_ ## id ## _prog_prms = {     \
-    .R1 = &R1,                                          \
+    .R1 = R1,                                           \
+    .R1_lockfree = R1_lockfree,                         \
     .busyloop_10 = busyloop_10,                         \
     .busyloop_30 = busyloop_30,                         \
     .busyloop_500 = busyloop_500,                       \
@@ -372,6 +423,10 @@ MAIN_BEGIN("priority_inversion_in_RM", "stderr", NULL)
       log_error("Cannot create Tau_" #id);                              \
       goto error;                                                       \
     }                                                                   \
+    if (task_set_blocking_recorder(tau_ ## id, 4) != 0) {               \
+      log_error("Cannot record the blocking of Tau_" #id);              \
+      goto error;                                                       \
+    }                                                                   \
   } while (0)
 
   create_task(1);
@@ -473,6 +528,20 @@ MAIN_BEGIN("priority_inversion_in_RM", "stderr", NULL)
 #undef check_rc
   /* END: Check task return statuses */
 
+  /* Report the blocking on R1 */
+  {
+    const lock_sample *samples;
+    unsigned long count, lost_count;
+
+    if (R1_lockfree != NULL) {
+      count = lockfree_object_get_samples(R1_lockfree, &samples, &lost_count);
+    } else {
+      count = rt_lock_get_samples(R1, &samples, &lost_count);
+    }
+    lock_samples_print(stdout, "R1", samples, count);
+  }
+  /* END: Report the blocking on R1 */
+
   exit_code = EXIT_SUCCESS;
 
  error:
@@ -486,8 +555,11 @@ MAIN_BEGIN("priority_inversion_in_RM", "stderr", NULL)
     task_destroy(tau_1);
   }
 
-  if (R1_initialized && (errno = pthread_mutex_destroy(&R1)) != 0) {
-    log_syserror("Cannot destroy R1");
+  if (R1_lockfree != NULL) {
+    lockfree_object_destroy(R1_lockfree);
+  }
+  if (R1 != NULL) {
+    rt_lock_destroy(R1);
   }
 
   if (busyloop_500 != NULL) {
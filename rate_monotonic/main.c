@@ -26,6 +26,7 @@
 #include "../utility_time.h"
 #include "../utility_sched_fifo.h"
 #include "../utility_memory.h"
+#include "../utility_sched_analysis.h"
 
 MAIN_BEGIN("rate_monotonic", "stderr", NULL)
 {
@@ -73,6 +74,47 @@ MAIN_BEGIN("rate_monotonic", "stderr", NULL)
 
 #undef make_period
 
+  /* Check the schedulability of the task set */
+  sched_analysis_taskset *taskset = sched_analysis_taskset_create();
+  if (taskset == NULL) {
+    fatal_error("Cannot create the task set to analyze");
+  }
+
+#define add_to_taskset(id) do {                                         \
+    if (sched_analysis_taskset_add(taskset,                             \
+                                   utility_time_to_utility_time_dyn     \
+                                   (tau_ ## id ## _wcet),               \
+                                   utility_time_to_utility_time_dyn     \
+                                   (tau_ ## id ## _period),             \
+                                   utility_time_to_utility_time_dyn     \
+                                   (tau_ ## id ## _period)) != 0) {     \
+      fatal_error("Cannot add Tau_" #id " to the task set to analyze"); \
+    }                                                                   \
+  } while (0)
+
+  add_to_taskset(1);
+  add_to_taskset(2);
+  add_to_taskset(3);
+  add_to_taskset(4);
+
+#undef add_to_taskset
+
+  if (sched_analysis_fp(taskset, SCHED_ANALYSIS_RM) != 1) {
+    sched_analysis_taskset_destroy(taskset);
+    fatal_error("The task set is not schedulable under RM");
+  }
+
+  unsigned tau_idx;
+  for (tau_idx = 0; tau_idx < sched_analysis_taskset_size(taskset);
+       tau_idx++) {
+    char r_str[32];
+    to_string_gc(sched_analysis_response_time(taskset, tau_idx),
+                 r_str, sizeof(r_str));
+    printf("  Tau_%u response time: %s\n", tau_idx + 1, r_str);
+  }
+  sched_analysis_taskset_destroy(taskset);
+  /* END: Check the schedulability of the task set */
+
 #define make_slot_count(id)                                             \
   unsigned long tau_ ## id ## _slot_count                               \
     = (second_to_stop - second_to_start) * 1000 / tau_ ## id ## _period_ms
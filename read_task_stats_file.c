@@ -203,6 +203,14 @@ static void print_utility_time(FILE *report,
   free(t_str);
 }
 
+/* The jobs of a mode of the task */
+struct mode_summary
+{
+  unsigned long job_count;
+  unsigned late_count;
+  unsigned long long max_response_time; /* In nanosecond. */
+};
+
 struct task_stats
 {
   FILE *report;
@@ -215,6 +223,32 @@ struct task_stats
   unsigned late_count;
   int suppress_printout;
   int first_time;
+  int first_overrun;
+
+  /* The blocking of the job whose blocking records are being summed */
+  unsigned long blocking_job_pos; /* Zero if there is no such job. */
+  unsigned long blocking_count;
+  relative_time blocking_total;
+  relative_time blocking_max;
+
+  /* The CPU statistics of the jobs */
+  int first_cpu; /* Zero if CPU statistics have been read. */
+  unsigned long cpu_job_pos;
+  unsigned long migrated_count;
+  unsigned long preempted_count;
+  unsigned long long preemption_count;
+
+  /* The mode changes of the task */
+  task_mode_statistics *modes;
+  unsigned long mode_count;
+  struct mode_summary *mode_summaries; /* The initial mode followed by
+                                          those in modes. */
+  unsigned long mode_idx; /* The mode of the current job, zero being
+                             the initial one. */
+  relative_time mode_release; /* The release of the first job of the
+                                 current mode relative to t_0. */
+  unsigned long mode_job_pos; /* The position of the first job of the
+                                 current mode. */
 
   struct response_time_list *response_times;
 };
@@ -255,10 +289,43 @@ static int print_task_stats(task *tau, void *args)
   utility_time_to_utility_time_gc(task_statistics_offset(tau),
                                   &prms->offset);
   prms->nth_job = task_statistics_oldest_job_pos(tau);
-  
+  prms->cpu_job_pos = prms->nth_job;
+
+  prms->mode_idx = 0;
+  utility_time_to_utility_time(&prms->offset, &prms->mode_release);
+  prms->mode_job_pos = 1;
+
   return 0;
 }
 
+/* Switch to the last applied mode whose first job is not after the
+   current job */
+static void enter_job_mode(struct task_stats *prms)
+{
+  unsigned long i;
+
+  for (i = prms->mode_idx; i < prms->mode_count; i++) {
+    const task_mode_statistics *mode = &prms->modes[i];
+
+    if (task_mode_statistics_job_pos(mode) > prms->nth_job) {
+      break;
+    }
+    if (task_mode_statistics_status(mode) != TASK_MODE_APPLIED) {
+      continue;
+    }
+
+    prms->mode_idx = i + 1;
+    prms->mode_job_pos = task_mode_statistics_job_pos(mode);
+    utility_time_to_utility_time_gc(task_mode_statistics_period(mode),
+                                    &prms->period);
+    utility_time_to_utility_time_gc(task_mode_statistics_deadline(mode),
+                                    &prms->deadline);
+    absolute_time *t_release = task_mode_statistics_time_release(mode);
+    utility_time_sub(t_release, &prms->t_0, &prms->mode_release);
+    utility_time_gc(t_release);
+  }
+}
+
 static int print_job_stats(job_statistics *stats, void *args)
 {
   struct task_stats *prms = args;
@@ -275,10 +342,13 @@ static int print_job_stats(job_statistics *stats, void *args)
   }
 
   /* Start time */
-  absolute_time *t_release
-    = utility_time_add_dyn_gc(&prms->offset,
-                              utility_time_mul_dyn(&prms->period,
-                                                   prms->nth_job - 1));
+  enter_job_mode(prms);
+  relative_time *mode_offset = utility_time_mul_dyn(&prms->period,
+                                                    prms->nth_job
+                                                    - prms->mode_job_pos);
+  absolute_time *t_release = utility_time_add_dyn(&prms->mode_release,
+                                                  mode_offset);
+  utility_time_gc(mode_offset);
   char *t_str;
   if (!prms->suppress_printout) {
     t_str = to_string_dyn(t_release);
@@ -395,11 +465,22 @@ static int print_job_stats(job_statistics *stats, void *args)
 
   struct timespec response_time_duration;
   to_timespec(response_time, &response_time_duration);
-  prms->response_times = insert_response_time((response_time_duration.tv_sec
-                                               * 1000000000ULL)
-                                              + response_time_duration.tv_nsec,
+  unsigned long long response_time_ns = (response_time_duration.tv_sec
+                                         * 1000000000ULL
+                                         + response_time_duration.tv_nsec);
+  prms->response_times = insert_response_time(response_time_ns,
                                               prms->response_times);
 
+  if (prms->mode_summaries != NULL) {
+    struct mode_summary *summary = &prms->mode_summaries[prms->mode_idx];
+
+    summary->job_count++;
+    summary->late_count += is_late;
+    if (response_time_ns > summary->max_response_time) {
+      summary->max_response_time = response_time_ns;
+    }
+  }
+
   if (!prms->suppress_printout) {
     t_str = to_string_dyn_gc(response_time);
     fprintf(prms->report, "%15s", t_str);
@@ -419,6 +500,242 @@ static int print_job_stats(job_statistics *stats, void *args)
   return 0;
 }
 
+static const char *overrun_kind_name(enum task_overrun_kind kind)
+{
+  switch (kind) {
+  case TASK_OVERRUN_DEADLINE:
+    return "deadline";
+  case TASK_OVERRUN_BUDGET:
+    return "budget";
+  case TASK_OVERRUN_DL_RUNTIME:
+    return "dl_runtime";
+  default:
+    return "-";
+  }
+}
+
+static const char *overrun_action_name(enum task_overrun_action action)
+{
+  switch (action) {
+  case TASK_OVERRUN_CONTINUE:
+    return "continue";
+  case TASK_OVERRUN_SKIP:
+    return "skip";
+  case TASK_OVERRUN_ABORT:
+    return "abort";
+  case TASK_OVERRUN_SKIPPED:
+    return "skipped";
+  default:
+    return "unknown";
+  }
+}
+
+static int print_overrun_stats(task_overrun_statistics *stats, void *args)
+{
+  struct task_stats *prms = args;
+
+  if (prms->suppress_printout) {
+    return 0;
+  }
+
+  if (prms->first_overrun) {
+    fprintf(prms->report, "Overrun events:\n%5s%15s%15s%15s\n",
+            "#job", "kind", "action", "detection");
+    prms->first_overrun = 0;
+  }
+
+  absolute_time *t_detection = task_overrun_statistics_time(stats);
+  char *t_str = to_string_dyn_gc(utility_time_sub_dyn(t_detection,
+                                                      &prms->t_0));
+  utility_time_gc(t_detection);
+  fprintf(prms->report, "%5lu%15s%15s%15s\n",
+          task_overrun_statistics_job_pos(stats),
+          overrun_kind_name(task_overrun_statistics_kind(stats)),
+          overrun_action_name(task_overrun_statistics_action(stats)),
+          t_str);
+  free(t_str);
+
+  return 0;
+}
+
+/* Print the blocking summed so far, which belongs to a single job */
+static void print_job_blocking(struct task_stats *prms)
+{
+  if (prms->blocking_job_pos == 0) {
+    return;
+  }
+
+  char *total_str = to_string_dyn(&prms->blocking_total);
+  char *max_str = to_string_dyn(&prms->blocking_max);
+  fprintf(prms->report, "%5lu%15lu%15s%15s\n", prms->blocking_job_pos,
+          prms->blocking_count, total_str, max_str);
+  free(max_str);
+  free(total_str);
+}
+
+static int print_blocking_stats(task_blocking_statistics *stats, void *args)
+{
+  struct task_stats *prms = args;
+
+  if (prms->suppress_printout) {
+    return 0;
+  }
+
+  unsigned long job_pos = task_blocking_statistics_job_pos(stats);
+  if (prms->blocking_job_pos == 0) {
+    fprintf(prms->report, "Blocking per job:\n%5s%15s%15s%15s\n",
+            "#job", "count", "total", "max");
+  }
+  if (job_pos != prms->blocking_job_pos) {
+    print_job_blocking(prms);
+    prms->blocking_job_pos = job_pos;
+    prms->blocking_count = 0;
+    to_utility_time(0, ns, &prms->blocking_total);
+    to_utility_time(0, ns, &prms->blocking_max);
+  }
+
+  relative_time *duration
+    = utility_time_sub_dyn_gc(task_blocking_statistics_time_end(stats),
+                              task_blocking_statistics_time_begin(stats));
+  prms->blocking_count++;
+  utility_time_inc(&prms->blocking_total, duration);
+  if (utility_time_gt(duration, &prms->blocking_max)) {
+    utility_time_to_utility_time(duration, &prms->blocking_max);
+  }
+  utility_time_gc(duration);
+
+  return 0;
+}
+
+static int print_job_cpu_stats(job_cpu_statistics *stats, void *args)
+{
+  struct task_stats *prms = args;
+
+  if (prms->first_cpu && !prms->suppress_printout) {
+    fprintf(prms->report, "CPU per job:\n%5s%15s%15s%15s%15s\n",
+            "#job", "cpu_begin", "cpu_end", "voluntary", "involuntary");
+  }
+  prms->first_cpu = 0;
+
+  int migrated = (job_cpu_statistics_cpu_begin(stats)
+                  != job_cpu_statistics_cpu_end(stats));
+  unsigned long preemptions = job_cpu_statistics_involuntary_switches(stats);
+
+  prms->migrated_count += migrated;
+  prms->preempted_count += (preemptions != 0);
+  prms->preemption_count += preemptions;
+
+  if (!prms->suppress_printout) {
+    fprintf(prms->report, "%5lu%15d%15d%15lu%15lu%s\n", prms->cpu_job_pos,
+            job_cpu_statistics_cpu_begin(stats),
+            job_cpu_statistics_cpu_end(stats),
+            job_cpu_statistics_voluntary_switches(stats), preemptions,
+            migrated ? " MIGRATED" : "");
+  }
+
+  prms->cpu_job_pos++;
+
+  return 0;
+}
+
+static int skip_task_stats(task *tau, void *args)
+{
+  return 0;
+}
+
+static int skip_job_stats(job_statistics *stats, void *args)
+{
+  return 0;
+}
+
+static int collect_mode_stats(task_mode_statistics *stats, void *args)
+{
+  struct task_stats *prms = args;
+
+  task_mode_statistics *modes = realloc(prms->modes,
+                                        (sizeof(*modes)
+                                         * (prms->mode_count + 1)));
+  if (modes == NULL) {
+    log_error("Insufficient memory to collect mode changes");
+    return -1;
+  }
+  modes[prms->mode_count++] = *stats;
+  prms->modes = modes;
+
+  return 0;
+}
+
+static const char *mode_status_name(enum task_mode_status status)
+{
+  switch (status) {
+  case TASK_MODE_APPLIED:
+    return "applied";
+  case TASK_MODE_REJECTED:
+    return "rejected";
+  default:
+    return "unknown";
+  }
+}
+
+/* Print a relative time in a column of a table */
+static void print_time_column(FILE *report, relative_time *t)
+{
+  char *t_str = to_string_dyn_gc(t);
+  fprintf(report, "%15s", t_str);
+  free(t_str);
+}
+
+static void print_mode_changes(struct task_stats *prms)
+{
+  unsigned long i;
+
+  fprintf(prms->report, "Mode changes:\n%5s%15s%15s%15s%15s%15s%15s%15s\n",
+          "#job", "status", "request", "apply_delay", "release_delay",
+          "wcet", "period", "deadline");
+  for (i = 0; i < prms->mode_count; i++) {
+    const task_mode_statistics *mode = &prms->modes[i];
+    absolute_time *t_request = task_mode_statistics_time_request(mode);
+    absolute_time *t_apply = task_mode_statistics_time_apply(mode);
+    absolute_time *t_release = task_mode_statistics_time_release(mode);
+
+    fprintf(prms->report, "%5lu%15s", task_mode_statistics_job_pos(mode),
+            mode_status_name(task_mode_statistics_status(mode)));
+    print_time_column(prms->report, utility_time_sub_dyn(t_request,
+                                                         &prms->t_0));
+    print_time_column(prms->report, utility_time_sub_dyn(t_apply, t_request));
+    print_time_column(prms->report, utility_time_sub_dyn(t_release,
+                                                         t_request));
+    utility_time_gc(t_request);
+    utility_time_gc(t_apply);
+    utility_time_gc(t_release);
+    print_time_column(prms->report, task_mode_statistics_wcet(mode));
+    print_time_column(prms->report, task_mode_statistics_period(mode));
+    print_time_column(prms->report, task_mode_statistics_deadline(mode));
+    fprintf(prms->report, "\n");
+  }
+
+  fprintf(prms->report, "Jobs per mode:\n%5s%15s%15s%15s%15s\n",
+          "#mode", "first_job", "job_count", "late_count", "max_response");
+  for (i = 0; i <= prms->mode_count; i++) {
+    const struct mode_summary *summary = &prms->mode_summaries[i];
+
+    if (i != 0 && (task_mode_statistics_status(&prms->modes[i - 1])
+                   != TASK_MODE_APPLIED)) {
+      continue;
+    }
+
+    relative_time max_response;
+    utility_time_init(&max_response);
+    to_utility_time(summary->max_response_time, ns, &max_response);
+
+    fprintf(prms->report, "%5lu%15lu%15lu%15u", i,
+            i == 0 ? 1 : task_mode_statistics_job_pos(&prms->modes[i - 1]),
+            summary->job_count, summary->late_count);
+    print_time_column(prms->report, &max_response);
+    fprintf(prms->report, "\n");
+  }
+}
+
 const char prog_name[] = "read_task_stats_file";
 FILE *log_stream;
 
@@ -485,17 +802,80 @@ int main(int argc, char **argv, char **envp)
     .response_times = NULL,
     .suppress_printout = (cdf_fmt != NO_CDF),
     .first_time = 1,
+    .first_overrun = 1,
+    .blocking_job_pos = 0,
     .total_job_count = 0,
+    .first_cpu = 1,
+    .migrated_count = 0,
+    .preempted_count = 0,
+    .preemption_count = 0,
+    .modes = NULL,
+    .mode_count = 0,
+    .mode_summaries = NULL,
   };
   utility_time_init(&stats_prms.period);
   utility_time_init(&stats_prms.deadline);
   utility_time_init(&stats_prms.t_0);
   utility_time_init(&stats_prms.offset);
-
-  if (task_statistics_read(stats_file, print_task_stats, &stats_prms,
-                           print_job_stats, &stats_prms) != 0) {
+  utility_time_init(&stats_prms.blocking_total);
+  utility_time_init(&stats_prms.blocking_max);
+  utility_time_init(&stats_prms.mode_release);
+
+  /* Collect the mode changes that determine the releases of the jobs */
+  const struct task_statistics_callbacks mode_callbacks = {
+    .task_statistics_fn = skip_task_stats,
+    .job_statistics_fn = skip_job_stats,
+    .mode_statistics_fn = collect_mode_stats,
+    .mode_statistics_fn_args = &stats_prms,
+  };
+  if (task_statistics_read_full(stats_file, &mode_callbacks) != 0) {
     fatal_error("Cannot read task stat file '%s'", argv[1]);
   }
+  if (fseek(stats_file, 0, SEEK_SET) != 0) {
+    fatal_syserror("Cannot rewind task stat file '%s'", argv[1]);
+  }
+  if (stats_prms.mode_count != 0) {
+    stats_prms.mode_summaries = calloc(stats_prms.mode_count + 1,
+                                       sizeof(*stats_prms.mode_summaries));
+    if (stats_prms.mode_summaries == NULL) {
+      fatal_error("Insufficient memory to summarize the modes");
+    }
+  }
+  /* END: Collect the mode changes that determine the releases of the jobs */
+
+  unsigned long lost_blocking_count;
+  const struct task_statistics_callbacks print_callbacks = {
+    .task_statistics_fn = print_task_stats,
+    .task_statistics_fn_args = &stats_prms,
+    .job_statistics_fn = print_job_stats,
+    .job_statistics_fn_args = &stats_prms,
+    .overrun_statistics_fn = print_overrun_stats,
+    .overrun_statistics_fn_args = &stats_prms,
+    .blocking_statistics_fn = print_blocking_stats,
+    .blocking_statistics_fn_args = &stats_prms,
+    .lost_blocking_count = &lost_blocking_count,
+    .job_cpu_statistics_fn = print_job_cpu_stats,
+    .job_cpu_statistics_fn_args = &stats_prms,
+  };
+  if (task_statistics_read_full(stats_file, &print_callbacks) != 0) {
+    fatal_error("Cannot read task stat file '%s'", argv[1]);
+  }
+
+  print_job_blocking(&stats_prms);
+  if (!stats_prms.suppress_printout && lost_blocking_count != 0) {
+    fprintf(stats_prms.report, "Lost blocking record count: %lu\n",
+            lost_blocking_count);
+  }
+  if (!stats_prms.suppress_printout && !stats_prms.first_cpu) {
+    fprintf(stats_prms.report, "Migrated job count: %lu of %lu\n",
+            stats_prms.migrated_count, stats_prms.total_job_count);
+    fprintf(stats_prms.report, "Preempted job count: %lu of %lu"
+            " (%llu preemptions)\n", stats_prms.preempted_count,
+            stats_prms.total_job_count, stats_prms.preemption_count);
+  }
+  if (!stats_prms.suppress_printout && stats_prms.mode_count != 0) {
+    print_mode_changes(&stats_prms);
+  }
 
   utility_file_close(stats_file, argv[1]);
 
@@ -504,6 +884,8 @@ int main(int argc, char **argv, char **envp)
                           stats_prms.report, cdf_fmt);
 
   free_response_time_list(stats_prms.response_times);
+  free(stats_prms.mode_summaries);
+  free(stats_prms.modes);
 
   return EXIT_SUCCESS;
 }
@@ -15,8 +15,320 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
  *****************************************************************************/
 
+#define _GNU_SOURCE /* SCHED_RESET_ON_FORK */
+
 #include "task.h"
 
+struct task_watchdog
+{
+  unsigned kinds; /* The enabled enum task_overrun_kind OR-ed together. */
+  task_overrun_handler handler; /* NULL means TASK_OVERRUN_CONTINUE. */
+  void *handler_args; /* The argument to be passed to handler. */
+
+  timer_t deadline_timer; /* Valid iff deadline_timer_created. */
+  int deadline_timer_created;
+  timer_t budget_timer; /* Valid iff budget_timer_created. */
+  int budget_timer_created;
+  absolute_time t; /* Scratch paper to calculate the absolute deadline. */
+
+  volatile sig_atomic_t in_job; /* Non-zero while the job is running. */
+  unsigned long job_pos; /* The release position of the current job. */
+  unsigned long skip_count; /* The number of releases to skip. */
+  sigjmp_buf abort_point; /* Where to go when the job is aborted. */
+
+  task_overrun_statistics *events; /* The overrun records. */
+  unsigned long event_slot_count; /* The capacity of events. */
+  unsigned long event_count; /* The number of overrun records. */
+  unsigned long lost_event_count; /* The number of unrecorded overruns. */
+};
+
+struct task_blocking
+{
+  task_blocking_statistics *records; /* The ring buffer of blocking records. */
+  unsigned long slot_count; /* The capacity of records. */
+  unsigned long next; /* The next slot in records to write to. */
+  unsigned long write_count; /* The number of blocking records written. */
+  struct timespec t_begin; /* When the current blocking has started. */
+};
+
+struct task_mode
+{
+  /* The request written by the controller thread while pending is
+     zero and read by the task thread while pending is non-zero */
+  int pending; /* Non-zero if the request has not been applied. */
+  struct timespec t_request; /* When the request has been made. */
+  relative_time wcet; /* The requested WCET. */
+  relative_time period; /* The requested period. */
+  relative_time deadline; /* The requested deadline. */
+  /* END: The request */
+
+  unsigned long job_pos; /* The release position of the last job. */
+  task_mode_statistics *records; /* The mode change records. */
+  unsigned long slot_count; /* The capacity of records. */
+  unsigned long record_count; /* The number of mode change records. */
+  unsigned long lost_record_count; /* The number of unrecorded changes. */
+};
+
+struct task_fast_stop
+{
+  int fd; /* The eventfd signalled by task_stop(). */
+  struct timespec t_request; /* When task_stop() has been called. */
+  struct timespec t_stopped; /* When task_start() has returned. */
+  int stopped; /* Non-zero if t_stopped is valid. */
+};
+
+/* The task whose job is being run by the calling thread */
+static __thread task *watchdog_task = NULL;
+
+/* The task whose blocking is recorded for the calling thread */
+static __thread task *blocking_task = NULL;
+
+static void record_overrun(struct task_watchdog *w,
+                           enum task_overrun_kind kind,
+                           enum task_overrun_action action)
+{
+  if (w->event_count == w->event_slot_count) {
+    w->lost_event_count++;
+    return;
+  }
+
+  struct timespec t_detection;
+  clock_gettime(CLOCK_MONOTONIC, &t_detection);
+
+  task_overrun_statistics *event = &w->events[w->event_count++];
+  event->job_pos = w->job_pos;
+  event->kind = kind;
+  event->action = action;
+  event->t_detection = t_detection;
+}
+
+static void watchdog_signal_handler(int signo, siginfo_t *info, void *context)
+{
+  int saved_errno = errno;
+  task *tau = watchdog_task;
+
+  if (tau == NULL || !tau->watchdog->in_job) {
+    goto out; /* Either a stray signal or the job has just finished */
+  }
+
+  struct task_watchdog *w = tau->watchdog;
+  enum task_overrun_kind kind = (signo == SIGXCPU
+                                 ? TASK_OVERRUN_DL_RUNTIME
+                                 : info->si_value.sival_int);
+  if (!(w->kinds & kind)) {
+    goto out;
+  }
+
+  enum task_overrun_action action = TASK_OVERRUN_CONTINUE;
+  if (w->handler != NULL) {
+    action = w->handler(tau, kind, w->job_pos, w->handler_args);
+  }
+  record_overrun(w, kind, action);
+
+  switch (action) {
+  case TASK_OVERRUN_SKIP:
+    w->skip_count++;
+    break;
+  case TASK_OVERRUN_ABORT:
+    w->in_job = 0;
+    errno = saved_errno;
+    siglongjmp(w->abort_point, 1);
+  default:
+    break;
+  }
+
+ out:
+  errno = saved_errno;
+}
+
+static inline int arm_timer(timer_t timer, int flags, const struct timespec *t)
+{
+  struct itimerspec its = {
+    .it_interval = {0, 0},
+    .it_value = *t,
+  };
+  return timer_settime(timer, flags, &its, NULL);
+}
+
+static inline int disarm_timer(timer_t timer)
+{
+  static const struct itimerspec its;
+  return timer_settime(timer, 0, &its, NULL);
+}
+
+/* Run the current job of the task under the supervision of the
+   overrun watchdog. The absolute release time of a periodic task is
+   still in tau->next_release_time. The abort point is set before
+   in_job and in_job before the timers are armed so that a timer that
+   expires right away (e.g., a job released after its deadline) is
+   neither dropped as stray nor jumps to a stale abort point. */
+static int watchdog_job_start(task *tau)
+{
+  struct task_watchdog *w = tau->watchdog;
+  struct timespec t;
+  volatile int rc = 0;
+  unsigned long write_count = 0;
+
+  w->job_pos++;
+
+  if (w->skip_count > 0) {
+    w->skip_count--;
+    record_overrun(w, 0, TASK_OVERRUN_SKIPPED);
+    return job_skip(tau->stats_ringbuf);
+  }
+
+  if (tau->stats_ringbuf != NULL) {
+    write_count = jobstats_ringbuf_write_count(tau->stats_ringbuf);
+  }
+
+  if (sigsetjmp(w->abort_point, 1) == 0) {
+    w->in_job = 1;
+
+    if (w->deadline_timer_created) {
+      if (tau->aperiodic) {
+        to_timespec(&tau->deadline, &t);
+        rc -= arm_timer(w->deadline_timer, 0, &t);
+      } else {
+        timespec_to_utility_time(&tau->next_release_time, &w->t);
+        utility_time_inc(&w->t, &tau->deadline);
+        to_timespec(&w->t, &t);
+        rc -= arm_timer(w->deadline_timer, TIMER_ABSTIME, &t);
+      }
+    }
+    if (w->budget_timer_created) {
+      to_timespec(&tau->wcet, &t);
+      rc -= arm_timer(w->budget_timer, 0, &t);
+    }
+
+    rc -= job_start(tau->stats_ringbuf, &tau->job);
+  } else if (tau->stats_ringbuf != NULL
+             && jobstats_ringbuf_write_count(tau->stats_ringbuf)
+             == write_count) {
+    /* Aborted before the job took its slot */
+    rc -= job_skip(tau->stats_ringbuf);
+  } else {
+    rc -= jobstats_ringbuf_finish_last(tau->stats_ringbuf);
+  }
+
+  if (w->deadline_timer_created) {
+    rc -= disarm_timer(w->deadline_timer);
+  }
+  if (w->budget_timer_created) {
+    rc -= disarm_timer(w->budget_timer);
+  }
+  w->in_job = 0;
+
+  return rc;
+}
+
+/* Update the SCHED_DEADLINE reservation of the calling thread, if
+   any, to the requested mode. Return 0 if successful or if the thread
+   is not scheduled using SCHED_DEADLINE, or -1 otherwise. */
+static int mode_reservation_update(const struct task_mode *m)
+{
+  int policy = sched_getscheduler(0);
+  if (policy == -1) {
+    log_syserror("Cannot get the scheduling policy of the task thread");
+    return -1;
+  }
+  if ((policy & ~SCHED_RESET_ON_FORK) != SCHED_DEADLINE) {
+    return 0;
+  }
+
+  struct sched_param_ex param_ex;
+  if (sched_getparam_ex(0, &param_ex) != 0) {
+    log_syserror("Cannot get the SCHED_DEADLINE reservation of the task");
+    return -1;
+  }
+  to_timespec(&m->wcet, &param_ex.sched_runtime);
+  to_timespec(&m->deadline, &param_ex.sched_deadline);
+  to_timespec(&m->period, &param_ex.sched_period);
+
+  if (sched_setscheduler_ex(0, &param_ex) != 0) {
+    if (errno == EBUSY) {
+      log_error("Admission control rejects SCHED_DEADLINE bandwidth %f",
+                sched_deadline_bandwidth(&param_ex));
+    } else {
+      log_syserror("Cannot update the SCHED_DEADLINE reservation of the task");
+    }
+    return -1;
+  }
+
+  return 0;
+}
+
+/* Apply the pending mode change, if any, after the current job has
+   finished. The absolute release time of the next job of a periodic
+   task is already in tau->next_release_time. */
+static void mode_boundary(task *tau)
+{
+  struct task_mode *m = tau->mode;
+
+  m->job_pos++;
+
+  if (!__atomic_load_n(&m->pending, __ATOMIC_ACQUIRE)) {
+    return;
+  }
+
+  struct timespec t_apply;
+  clock_gettime(CLOCK_MONOTONIC, &t_apply);
+
+  enum task_mode_status status = TASK_MODE_REJECTED;
+  if (mode_reservation_update(m) == 0) {
+    utility_time_to_utility_time(&m->wcet, &tau->wcet);
+    utility_time_to_utility_time(&m->period, &tau->period);
+    utility_time_to_utility_time(&m->deadline, &tau->deadline);
+    status = TASK_MODE_APPLIED;
+  }
+
+  if (m->record_count == m->slot_count) {
+    m->lost_record_count++;
+  } else {
+    struct timespec wcet, period, deadline;
+    to_timespec(&m->wcet, &wcet);
+    to_timespec(&m->period, &period);
+    to_timespec(&m->deadline, &deadline);
+
+    task_mode_statistics *record = &m->records[m->record_count++];
+    record->job_pos = m->job_pos + 1;
+    record->status = status;
+    record->t_request = m->t_request;
+    record->t_apply = t_apply;
+    record->t_release = (tau->aperiodic ? t_apply : tau->next_release_time);
+    record->wcet = wcet;
+    record->period = period;
+    record->deadline = deadline;
+  }
+
+  __atomic_store_n(&m->pending, 0, __ATOMIC_RELEASE);
+}
+
+/* Wait until the absolute release time of the next job of a periodic
+   task or until the task is stopped. Return 0 at the release time, -1
+   if the task is stopped or the error number in case of error. */
+static int release_wait(task *tau)
+{
+  while (!__atomic_load_n(&tau->stopped, __ATOMIC_ACQUIRE)) {
+    if (syscall(SYS_futex, &tau->stopped,
+                FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG, 0,
+                &tau->next_release_time, NULL, FUTEX_BITSET_MATCH_ANY) == 0) {
+      continue; /* Either woken by task_stop() or spuriously */
+    }
+
+    switch (errno) {
+    case ETIMEDOUT:
+      return 0;
+    case EAGAIN:
+    case EINTR:
+      break;
+    default:
+      return errno;
+    }
+  }
+
+  return -1;
+}
+
 /* Start of timing sensitive code */
 
 /* CLOCK_MONOTONIC must be used because function run_program may be
@@ -35,17 +347,30 @@
 #define task_start_periodic(tau)                                        \
   do {                                                                  \
     /* Harness the sleeping period to provide starting offset as well. */ \
-    rc -= clock_nanosleep(CLOCK_TYPE, TIMER_ABSTIME,                    \
-                          &tau->next_release_time, NULL);               \
+    int sleep_rc;                                                       \
+    if (tau->fast_stop == NULL) {                                       \
+      while ((sleep_rc = clock_nanosleep(CLOCK_TYPE, TIMER_ABSTIME,     \
+                                         &tau->next_release_time,       \
+                                         NULL)) == EINTR);              \
+    } else if ((sleep_rc = release_wait(tau)) == -1) {                  \
+      break; /* Stopped before the release */                           \
+    }                                                                   \
+    rc -= sleep_rc;                                                     \
     /* End of harnessing the sleeping period to provide starting offset. */ \
                                                                         \
-    rc -= job_start(tau->stats_ringbuf, &tau->job);                     \
+    rc -= (tau->watchdog == NULL                                        \
+           ? job_start(tau->stats_ringbuf, &tau->job)                   \
+           : watchdog_job_start(tau));                                  \
                                                                         \
     /* Calculate the next release time */                               \
     timespec_to_utility_time(&tau->next_release_time, &tau->t);         \
     utility_time_inc(&tau->t, &tau->period);                            \
     to_timespec(&tau->t, &tau->next_release_time);                      \
     /* End of calculating the next release time */                      \
+                                                                        \
+    if (tau->mode != NULL) {                                            \
+      mode_boundary(tau);                                               \
+    }                                                                   \
   } while (rc == 0                                                      \
            && !tau->stopped) /* To have a consistent overhead, the
                                 conditions should be ordered from the
@@ -70,16 +395,51 @@
  */
 #define task_start_aperiodic(tau)                                       \
   do {                                                                  \
+    int release_rc;                                                     \
     tau->inside_aperiodic_release = 1;                                  \
-    tau->aperiodic_release(tau->args); /* Wait for the aperiodic event */ \
+    /* Wait for the aperiodic event */                                  \
+    release_rc = tau->aperiodic_release(tau->args);                     \
     tau->inside_aperiodic_release = 0;                                  \
-    rc -= job_start(tau->stats_ringbuf, &tau->job);                     \
+    if (release_rc != 0) {                                              \
+      break; /* No more aperiodic event */                              \
+    }                                                                   \
+    if (tau->fast_stop != NULL && tau->stopped) {                       \
+      break; /* Stopped while waiting for the aperiodic event */        \
+    }                                                                   \
+    rc -= (tau->watchdog == NULL                                        \
+           ? job_start(tau->stats_ringbuf, &tau->job)                   \
+           : watchdog_job_start(tau));                                  \
+                                                                        \
+    if (tau->mode != NULL) {                                            \
+      mode_boundary(tau);                                               \
+    }                                                                   \
   } while (rc == 0                                                      \
            && !tau->stopped); /* To have a consistent overhead, the
                                  conditions should be ordered from the
                                  most rare to the most likely to
                                  happen */
 
+/* Write the CPU statistics of the jobs if the ring buffer records
+   them. Return 0 if successful or -1 otherwise. */
+static int write_cpu_records(FILE *stats_log, const jobstats_ringbuf *jobs)
+{
+  if (!jobstats_ringbuf_cpu_recorded(jobs)) {
+    return 0;
+  }
+
+  task_statistics_cpu preamble = {
+    .magic = TASK_STATISTICS_CPU_MAGIC,
+    .record_count = (jobstats_ringbuf_write_count(jobs)
+                     - jobstats_ringbuf_lost_count(jobs)),
+  };
+  if (fwrite(&preamble, sizeof(preamble), 1, stats_log) != 1) {
+    log_syserror("Cannot log task CPU parameters");
+    return -1;
+  }
+
+  return jobstats_ringbuf_save_cpu(jobs, stats_log);
+}
+
 static void flush_stats_ringbuf(void *args)
 {
   task *tau = args;
@@ -111,12 +471,230 @@ static void flush_stats_ringbuf(void *args)
 
   tau->fail_to_close_stats_log -= jobstats_ringbuf_save(tau->stats_ringbuf,
                                                         tau->stats_log);
+  tau->fail_to_close_stats_log -= write_cpu_records(tau->stats_log,
+                                                    tau->stats_ringbuf);
 
  out:
   jobstats_ringbuf_destroy(tau->stats_ringbuf);
   tau->stats_ringbuf = NULL;
 }
 
+static void flush_overrun_events(void *args)
+{
+  task *tau = args;
+  struct task_watchdog *w = tau->watchdog;
+
+  if (w == NULL || tau->stats_log == NULL) {
+    return;
+  }
+
+  task_statistics_overrun preamble = {
+    .magic = TASK_STATISTICS_OVERRUN_MAGIC,
+    .event_count = w->event_count,
+    .lost_event_count = w->lost_event_count,
+  };
+  if (fwrite(&preamble, sizeof(preamble), 1, tau->stats_log) != 1) {
+    log_syserror("Cannot log task overrun parameters");
+    tau->fail_to_close_stats_log++;
+    return;
+  }
+
+  if (w->event_count != 0
+      && fwrite(w->events, sizeof(*w->events), w->event_count,
+                tau->stats_log) != w->event_count) {
+    log_syserror("Cannot log task overrun records");
+    tau->fail_to_close_stats_log++;
+  }
+}
+
+static void flush_blocking_records(void *args)
+{
+  task *tau = args;
+  struct task_blocking *b = tau->blocking;
+
+  if (b == NULL || tau->stats_log == NULL) {
+    return;
+  }
+
+  unsigned long record_count = (b->write_count < b->slot_count
+                                ? b->write_count : b->slot_count);
+  task_statistics_blocking preamble = {
+    .magic = TASK_STATISTICS_BLOCKING_MAGIC,
+    .record_count = record_count,
+    .lost_record_count = b->write_count - record_count,
+  };
+  if (fwrite(&preamble, sizeof(preamble), 1, tau->stats_log) != 1) {
+    log_syserror("Cannot log task blocking parameters");
+    tau->fail_to_close_stats_log++;
+    return;
+  }
+
+  /* Save the records from the oldest one */
+  unsigned long oldest = (b->write_count > b->slot_count ? b->next : 0);
+  unsigned long older_count = record_count - oldest;
+  if ((older_count != 0
+       && fwrite(b->records + oldest, sizeof(*b->records), older_count,
+                 tau->stats_log) != older_count)
+      || (oldest != 0
+          && fwrite(b->records, sizeof(*b->records), oldest,
+                    tau->stats_log) != oldest)) {
+    log_syserror("Cannot log task blocking records");
+    tau->fail_to_close_stats_log++;
+  }
+}
+
+static void flush_mode_records(void *args)
+{
+  task *tau = args;
+  struct task_mode *m = tau->mode;
+
+  if (m == NULL || tau->stats_log == NULL) {
+    return;
+  }
+
+  task_statistics_mode preamble = {
+    .magic = TASK_STATISTICS_MODE_MAGIC,
+    .record_count = m->record_count,
+    .lost_record_count = m->lost_record_count,
+  };
+  if (fwrite(&preamble, sizeof(preamble), 1, tau->stats_log) != 1) {
+    log_syserror("Cannot log task mode change parameters");
+    tau->fail_to_close_stats_log++;
+    return;
+  }
+
+  if (m->record_count != 0
+      && fwrite(m->records, sizeof(*m->records), m->record_count,
+                tau->stats_log) != m->record_count) {
+    log_syserror("Cannot log task mode change records");
+    tau->fail_to_close_stats_log++;
+  }
+}
+
+static void blocking_stop(void *args)
+{
+  blocking_task = NULL;
+}
+
+void task_block_begin(void)
+{
+  task *tau = blocking_task;
+
+  if (tau != NULL) {
+    clock_gettime(CLOCK_TYPE, &tau->blocking->t_begin);
+  }
+}
+
+void task_block_end(unsigned point)
+{
+  task *tau = blocking_task;
+  struct timespec t_end;
+
+  if (tau == NULL) {
+    return;
+  }
+  clock_gettime(CLOCK_TYPE, &t_end);
+
+  struct task_blocking *b = tau->blocking;
+  task_blocking_statistics *record = &b->records[b->next];
+  record->job_pos = jobstats_ringbuf_write_count(tau->stats_ringbuf);
+  record->point = point;
+  record->t_begin = b->t_begin;
+  record->t_end = t_end;
+
+  if (++b->next == b->slot_count) {
+    b->next = 0;
+  }
+  b->write_count++;
+}
+
+static int create_watchdog_timer(clockid_t clock, enum task_overrun_kind kind,
+                                 timer_t *timer)
+{
+  struct sigevent sev = {
+    .sigev_notify = SIGEV_THREAD_ID,
+    .sigev_signo = TASK_WATCHDOG_SIGNAL,
+    .sigev_value.sival_int = kind,
+  };
+  sev._sigev_un._tid = syscall(SYS_gettid);
+
+  if (timer_create(clock, &sev, timer) != 0) {
+    log_syserror("Cannot create overrun watchdog timer");
+    return -1;
+  }
+
+  return 0;
+}
+
+/* Prepare the watchdog to monitor the jobs run by the calling thread */
+static int watchdog_start(task *tau)
+{
+  struct task_watchdog *w = tau->watchdog;
+
+  if (w == NULL) {
+    return 0;
+  }
+
+  w->in_job = 0;
+  w->job_pos = 0;
+  w->skip_count = 0;
+
+  if ((w->kinds & TASK_OVERRUN_DEADLINE)
+      && !(w->deadline_timer_created
+           = (create_watchdog_timer(CLOCK_TYPE, TASK_OVERRUN_DEADLINE,
+                                    &w->deadline_timer) == 0))) {
+    return -1;
+  }
+  if ((w->kinds & TASK_OVERRUN_BUDGET)
+      && !(w->budget_timer_created
+           = (create_watchdog_timer(CLOCK_THREAD_CPUTIME_ID,
+                                    TASK_OVERRUN_BUDGET,
+                                    &w->budget_timer) == 0))) {
+    return -1;
+  }
+
+  watchdog_task = tau;
+
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, TASK_WATCHDOG_SIGNAL);
+  if (w->kinds & TASK_OVERRUN_DL_RUNTIME) {
+    sigaddset(&signals, SIGXCPU);
+  }
+  if ((errno = pthread_sigmask(SIG_UNBLOCK, &signals, NULL)) != 0) {
+    log_syserror("Cannot unblock overrun watchdog signals");
+    return -1;
+  }
+
+  return 0;
+}
+
+static void watchdog_stop(void *args)
+{
+  task *tau = args;
+  struct task_watchdog *w = tau->watchdog;
+
+  if (w == NULL) {
+    return;
+  }
+
+  w->in_job = 0;
+  watchdog_task = NULL;
+
+  if (w->deadline_timer_created) {
+    if (timer_delete(w->deadline_timer) != 0) {
+      log_syserror("Cannot delete overrun watchdog deadline timer");
+    }
+    w->deadline_timer_created = 0;
+  }
+  if (w->budget_timer_created) {
+    if (timer_delete(w->budget_timer) != 0) {
+      log_syserror("Cannot delete overrun watchdog budget timer");
+    }
+    w->budget_timer_created = 0;
+  }
+}
+
 static void close_logging_file(void *args)
 {
   task *tau = args;
@@ -138,24 +716,49 @@ int task_start(task *tau)
 
   tau->thread_id = pthread_self();
   pthread_cleanup_push(close_logging_file, tau);
+  pthread_cleanup_push(flush_mode_records, tau);
+  pthread_cleanup_push(flush_blocking_records, tau);
+  pthread_cleanup_push(flush_overrun_events, tau);
   pthread_cleanup_push(flush_stats_ringbuf, tau);
+  pthread_cleanup_push(watchdog_stop, tau);
+  pthread_cleanup_push(blocking_stop, tau);
 
-  if (tau->aperiodic) {
+  blocking_task = (tau->blocking == NULL ? NULL : tau);
+  if (tau->mode != NULL) {
+    tau->mode->job_pos = 0;
+  }
+
+  if (watchdog_start(tau) != 0) {
+    log_error("Cannot start the overrun watchdog");
+    rc = -1;
+  } else if (tau->aperiodic) {
     task_start_aperiodic(tau);
+    tau->aperiodic_release_ended = 1;
   } else {
     task_start_periodic(tau);
   }
 
+  pthread_cleanup_pop(1);
+  pthread_cleanup_pop(1);
+  pthread_cleanup_pop(1);
+  pthread_cleanup_pop(1);
+  pthread_cleanup_pop(1);
   pthread_cleanup_pop(1);
   pthread_cleanup_pop(1);
   rc -= tau->fail_to_close_stats_log;
 
+  if (tau->fast_stop != NULL && tau->stopped) {
+    clock_gettime(CLOCK_TYPE, &tau->fast_stop->t_stopped);
+    tau->fast_stop->stopped = 1;
+  }
+
   return rc;
 }
 
 static __attribute__((noinline,optimize(0)))
-void aperiodic_release_empty(void *args)
+int aperiodic_release_empty(void *args)
 {
+  return 0;
 }
 static __attribute__((noinline,optimize(0)))
 void run_program_stop_task(void *args)
@@ -214,6 +817,10 @@ static void *overhead_measurement_thread(void *args)
   /** Anticipate early bailout **/
   tau.stats_log = NULL;
   tau.stats_ringbuf = NULL;
+  tau.watchdog = NULL;
+  tau.blocking = NULL;
+  tau.mode = NULL;
+  tau.fast_stop = NULL;
   /** End of anticipating early bailout **/
 
   tau.stopped = 0;
@@ -223,6 +830,7 @@ static void *overhead_measurement_thread(void *args)
   tau.aperiodic_release = (params->aperiodic ? aperiodic_release_empty : NULL);
   tau.args = NULL;
   tau.inside_aperiodic_release = 0;
+  tau.aperiodic_release_ended = 0;
 
   tau.job.run_program = run_program_stop_task;
   tau.job.args = &tau;
@@ -364,11 +972,11 @@ int task_create(const char *name,
                 const relative_time *deadline,
                 const absolute_time *t_0,
                 const relative_time *offset,
-                void (*aperiodic_release)(void *args),
+                int (*aperiodic_release)(void *args),
                 void *aperiodic_release_args,
                 const char *stats_file_path,
                 unsigned long ringbuffer_size,
-                int ringbuffer_disable_overrun,
+                int ringbuffer_flags,
                 const relative_time *job_statistics_overhead,
                 const relative_time *finish_to_start_overhead,
                 void (*task_program)(void *args),
@@ -377,9 +985,23 @@ int task_create(const char *name,
 {
   int rc = -1;
   task *result = NULL;
+  task_statistics *task_stats = NULL;
+
+  if (ringbuffer_flags & ~(TASK_RINGBUF_DISABLE_OVERRUN
+                           | TASK_RINGBUF_RECORD_CPU)) {
+    log_error("Unknown ring buffer flags 0x%x", ringbuffer_flags);
+    utility_time_gc_auto(wcet);
+    utility_time_gc_auto(period);
+    utility_time_gc_auto(deadline);
+    utility_time_gc_auto(t_0);
+    utility_time_gc_auto(offset);
+    utility_time_gc_auto(job_statistics_overhead);
+    utility_time_gc_auto(finish_to_start_overhead);
+    *res = NULL;
+    return -1;
+  }
 
   /* Create task_statistics object */
-  task_statistics *task_stats = NULL;
   size_t task_stats_len = sizeof(*task_stats) + (strlen(name) + 1);
   task_stats = malloc(task_stats_len);
   if (task_stats == NULL) {
@@ -410,6 +1032,11 @@ int task_create(const char *name,
   result->stopped = 0;
   utility_time_init(&result->t);
   result->inside_aperiodic_release = 0;
+  result->aperiodic_release_ended = 0;
+  result->watchdog = NULL;
+  result->blocking = NULL;
+  result->mode = NULL;
+  result->fast_stop = NULL;
 
   result->disable_job_statistics = !ringbuffer_size;
   task_stats->job_statistics_disabled = !ringbuffer_size;
@@ -454,8 +1081,11 @@ int task_create(const char *name,
   if (result->disable_job_statistics) {
     result->stats_ringbuf = NULL;
   } else {
-    result->stats_ringbuf = jobstats_ringbuf_create(ringbuffer_size,
-                                                    ringbuffer_disable_overrun);
+    result->stats_ringbuf
+      = jobstats_ringbuf_create_ex(ringbuffer_size,
+                                   (ringbuffer_flags
+                                    & TASK_RINGBUF_DISABLE_OVERRUN),
+                                   ringbuffer_flags & TASK_RINGBUF_RECORD_CPU);
     if (result->stats_ringbuf == NULL) {
       log_error("Not enough memory to create ring buffer of size %lu",
                 ringbuffer_size);
@@ -556,16 +1186,234 @@ void task_destroy(task *tau)
   if (tau->stats_ringbuf != NULL) {
     jobstats_ringbuf_destroy(tau->stats_ringbuf);
   }
+  if (tau->watchdog != NULL) {
+    free(tau->watchdog->events);
+    free(tau->watchdog);
+  }
+  if (tau->blocking != NULL) {
+    free(tau->blocking->records);
+    free(tau->blocking);
+  }
+  if (tau->mode != NULL) {
+    free(tau->mode->records);
+    free(tau->mode);
+  }
+  if (tau->fast_stop != NULL) {
+    if (close(tau->fast_stop->fd) != 0) {
+      log_syserror("Cannot close the fast stop eventfd");
+    }
+    free(tau->fast_stop);
+  }
 
   free(tau);
 }
 
+int task_set_overrun_watchdog(task *tau, unsigned kinds,
+                              unsigned long event_slot_count,
+                              task_overrun_handler handler,
+                              void *handler_args)
+{
+  const unsigned all_kinds = (TASK_OVERRUN_DEADLINE | TASK_OVERRUN_BUDGET
+                              | TASK_OVERRUN_DL_RUNTIME);
+
+  if (kinds == 0 || (kinds & ~all_kinds) || event_slot_count == 0
+      || tau->watchdog != NULL) {
+    return -1;
+  }
+
+  struct task_watchdog *w = malloc(sizeof(*w));
+  if (w == NULL) {
+    log_error("No memory to create overrun watchdog");
+    return -2;
+  }
+  w->events = malloc(sizeof(*w->events) * event_slot_count);
+  if (w->events == NULL) {
+    log_error("No memory to store %lu overrun records", event_slot_count);
+    free(w);
+    return -2;
+  }
+
+  w->kinds = kinds;
+  w->handler = handler;
+  w->handler_args = handler_args;
+  w->deadline_timer_created = 0;
+  w->budget_timer_created = 0;
+  utility_time_init(&w->t);
+  w->in_job = 0;
+  w->job_pos = 0;
+  w->skip_count = 0;
+  w->event_slot_count = event_slot_count;
+  w->event_count = 0;
+  w->lost_event_count = 0;
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_sigaction = watchdog_signal_handler;
+  sa.sa_flags = SA_SIGINFO;
+  sigemptyset(&sa.sa_mask);
+  sigaddset(&sa.sa_mask, TASK_WATCHDOG_SIGNAL);
+  sigaddset(&sa.sa_mask, SIGXCPU);
+  if (sigaction(TASK_WATCHDOG_SIGNAL, &sa, NULL) != 0) {
+    log_syserror("Cannot install overrun watchdog signal handler");
+    goto error;
+  }
+  if ((kinds & TASK_OVERRUN_DL_RUNTIME) && sigaction(SIGXCPU, &sa, NULL) != 0) {
+    log_syserror("Cannot install SIGXCPU handler");
+    goto error;
+  }
+
+  tau->watchdog = w;
+  return 0;
+
+ error:
+  free(w->events);
+  free(w);
+  return -2;
+}
+
+int task_set_blocking_recorder(task *tau, unsigned long slot_count)
+{
+  if (slot_count == 0 || tau->disable_job_statistics
+      || tau->blocking != NULL) {
+    return -1;
+  }
+
+  struct task_blocking *b = malloc(sizeof(*b));
+  if (b == NULL) {
+    log_error("No memory to create blocking recorder");
+    return -2;
+  }
+  b->records = malloc(sizeof(*b->records) * slot_count);
+  if (b->records == NULL) {
+    log_error("No memory to store %lu blocking records", slot_count);
+    free(b);
+    return -2;
+  }
+  /* Prefault the ring buffer so that no job takes the page faults */
+  memset(b->records, 0, sizeof(*b->records) * slot_count);
+
+  b->slot_count = slot_count;
+  b->next = 0;
+  b->write_count = 0;
+
+  tau->blocking = b;
+  return 0;
+}
+
+int task_set_mode_change(task *tau, unsigned long slot_count)
+{
+  if (slot_count == 0 || tau->mode != NULL) {
+    return -1;
+  }
+
+  struct task_mode *m = malloc(sizeof(*m));
+  if (m == NULL) {
+    log_error("No memory to create mode change state");
+    return -2;
+  }
+  m->records = malloc(sizeof(*m->records) * slot_count);
+  if (m->records == NULL) {
+    log_error("No memory to store %lu mode change records", slot_count);
+    free(m);
+    return -2;
+  }
+  /* Prefault the records so that no job boundary takes the page faults */
+  memset(m->records, 0, sizeof(*m->records) * slot_count);
+
+  m->pending = 0;
+  utility_time_init(&m->wcet);
+  utility_time_init(&m->period);
+  utility_time_init(&m->deadline);
+  m->job_pos = 0;
+  m->slot_count = slot_count;
+  m->record_count = 0;
+  m->lost_record_count = 0;
+
+  tau->mode = m;
+  return 0;
+}
+
+int task_set_fast_stop(task *tau)
+{
+  if (tau->fast_stop != NULL) {
+    return -1;
+  }
+
+  struct task_fast_stop *f = malloc(sizeof(*f));
+  if (f == NULL) {
+    log_error("No memory to create fast stop state");
+    return -2;
+  }
+  f->fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (f->fd == -1) {
+    log_syserror("Cannot create the fast stop eventfd");
+    free(f);
+    return -2;
+  }
+  f->stopped = 0;
+
+  tau->fast_stop = f;
+  return 0;
+}
+
+int task_change_mode(task *tau, const relative_time *wcet,
+                     const relative_time *period,
+                     const relative_time *deadline)
+{
+  struct task_mode *m = tau->mode;
+  int rc = -1;
+
+  if (m == NULL || __atomic_load_n(&m->pending, __ATOMIC_ACQUIRE)) {
+    goto out;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &m->t_request);
+  utility_time_to_utility_time(wcet, &m->wcet);
+  utility_time_to_utility_time(period, &m->period);
+  utility_time_to_utility_time(deadline, &m->deadline);
+  __atomic_store_n(&m->pending, 1, __ATOMIC_RELEASE);
+  rc = 0;
+
+ out:
+  utility_time_gc_auto(wcet);
+  utility_time_gc_auto(period);
+  utility_time_gc_auto(deadline);
+  return rc;
+}
+
+/* Wake the task thread whose fast stop is enabled */
+static void fast_stop_signal(task *tau)
+{
+  struct task_fast_stop *f = tau->fast_stop;
+
+  clock_gettime(CLOCK_TYPE, &f->t_request);
+  __atomic_store_n(&tau->stopped, 1, __ATOMIC_RELEASE);
+
+  if (syscall(SYS_futex, &tau->stopped, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, 1,
+              NULL, NULL, 0) == -1) {
+    log_syserror("Cannot wake the task thread");
+  }
+
+  uint64_t one = 1;
+  if (write(f->fd, &one, sizeof(one)) != sizeof(one)) {
+    log_syserror("Cannot signal the fast stop eventfd");
+  }
+}
+
 void task_stop(task *tau)
 {
+  if (tau->fast_stop != NULL) {
+    fast_stop_signal(tau);
+    return;
+  }
+
   tau->stopped = 1;
 
   if (tau->aperiodic) {
-    while (!tau->inside_aperiodic_release) {
+    /* A task whose jobs are always pending (e.g., an overloaded
+       open-loop client) may instead see that it is stopped after a
+       job and return by itself */
+    while (!tau->inside_aperiodic_release && !tau->aperiodic_release_ended) {
       struct timespec t;
       to_timespec(&tau->wcet, &t);
       if (clock_nanosleep(CLOCK_TYPE, 0, &t, NULL) != 0) {
@@ -574,22 +1422,295 @@ void task_stop(task *tau)
       }
     }
 
-    if ((errno = pthread_cancel(tau->thread_id)) != 0) {
+    if (!tau->aperiodic_release_ended
+        && (errno = pthread_cancel(tau->thread_id)) != 0) {
       log_syserror("Cannot cancel thread %u", (unsigned) tau->thread_id);
     }
   }
 }
 
+int task_stop_fd(const task *tau)
+{
+  return (tau->fast_stop == NULL ? -1 : tau->fast_stop->fd);
+}
+
+relative_time *task_stop_latency(const task *tau)
+{
+  const struct task_fast_stop *f = tau->fast_stop;
+
+  if (f == NULL || !f->stopped) {
+    return NULL;
+  }
+
+  return utility_time_sub_dyn_gc(timespec_to_utility_time_dyn(&f->t_stopped),
+                                 timespec_to_utility_time_dyn(&f->t_request));
+}
+
+int task_statistics_write(FILE *stats_log, const char *name,
+                          const relative_time *wcet,
+                          const relative_time *period,
+                          const relative_time *deadline,
+                          const absolute_time *t_0,
+                          const relative_time *offset,
+                          const relative_time *job_statistics_overhead,
+                          const relative_time *finish_to_start_overhead,
+                          const jobstats_ringbuf *jobs)
+{
+  size_t task_stats_len = sizeof(task_statistics) + strlen(name);
+  task_statistics *task_stats = malloc(task_stats_len + 1);
+  int rc = -1;
+
+  if (task_stats == NULL) {
+    log_error("Cannot create task statistics object");
+    return -1;
+  }
+
+  task_stats->byte_order = host_byte_order();
+  task_stats->sizeof_struct_timespec_tv_sec
+    = sizeof(((struct timespec *) 0)->tv_sec);
+  task_stats->sizeof_struct_timespec_tv_nsec
+    = sizeof(((struct timespec *) 0)->tv_nsec);
+  task_stats->sizeof_unsigned_long
+    = sizeof((unsigned long *) 0);
+  task_stats->aperiodic = 0;
+  task_stats->job_statistics_disabled = (jobs == NULL);
+  task_stats->name_len = strlen(name);
+  strcpy(task_stats->name, name);
+
+#define arg_to_task_stats(arg)                  \
+  do {                                          \
+    struct timespec t;                          \
+    to_timespec_gc(arg, &t);                    \
+    task_stats->arg.tv_sec = t.tv_sec;          \
+    task_stats->arg.tv_nsec = t.tv_nsec;        \
+  } while (0)
+
+  arg_to_task_stats(wcet);
+  arg_to_task_stats(period);
+  arg_to_task_stats(deadline);
+  arg_to_task_stats(t_0);
+  arg_to_task_stats(offset);
+  arg_to_task_stats(job_statistics_overhead);
+  arg_to_task_stats(finish_to_start_overhead);
+
+#undef arg_to_task_stats
+
+  if (fwrite(task_stats, task_stats_len, 1, stats_log) != 1) {
+    log_syserror("Cannot log task parameters");
+    goto out;
+  }
+
+  if (jobs != NULL) {
+    task_statistics_ringbuf preamble = {
+      .oldest_job_pos = jobstats_ringbuf_oldest_pos(jobs),
+      .lost_job_count = jobstats_ringbuf_lost_count(jobs),
+      .write_count = jobstats_ringbuf_write_count(jobs),
+    };
+    if (fwrite(&preamble, sizeof(preamble), 1, stats_log) != 1) {
+      log_syserror("Cannot log task ringbuf parameters");
+      goto out;
+    }
+    if (jobstats_ringbuf_save(jobs, stats_log) != 0
+        || write_cpu_records(stats_log, jobs) != 0) {
+      goto out;
+    }
+  }
+
+  rc = 0;
+
+ out:
+  free(task_stats);
+  return rc;
+}
+
 int task_statistics_read(FILE *stats_log,
                          int (*task_statistics_fn)(task *tau, void *args),
                          void *task_statistics_fn_args,
                          int (*job_statistics_fn)(job_statistics *stats,
                                                   void *args),
                          void *job_statistics_fn_args)
+{
+  return task_statistics_read_ex(stats_log,
+                                 task_statistics_fn, task_statistics_fn_args,
+                                 job_statistics_fn, job_statistics_fn_args,
+                                 NULL, NULL);
+}
+
+/* Return 0 if the given number of bytes can be read into buf or -2
+   otherwise. */
+static int stats_log_read(FILE *stats_log, void *buf, size_t size)
+{
+  if (fread(buf, size, 1, stats_log) != 1) {
+    if (ferror(stats_log)) {
+      log_syserror("Cannot read task stats log stream");
+    } else {
+      log_error("Corrupted task stats log");
+    }
+    return -2;
+  }
+
+  return 0;
+}
+
+/* Return 0 if the overrun records whose magic number has been read
+   have been processed, -1 if overrun_statistics_fn returns non-zero
+   or -2 in case of error. */
+static int overrun_statistics_read(FILE *stats_log,
+                                   int (*overrun_statistics_fn)
+                                   (task_overrun_statistics *stats,
+                                    void *args),
+                                   void *overrun_statistics_fn_args)
+{
+  task_statistics_overrun preamble;
+  if (stats_log_read(stats_log, (char *) &preamble + sizeof(preamble.magic),
+                     sizeof(preamble) - sizeof(preamble.magic)) != 0) {
+    return -2;
+  }
+
+  unsigned long i;
+  for (i = 0; i < preamble.event_count; i++) {
+    task_overrun_statistics stats;
+    if (stats_log_read(stats_log, &stats, sizeof(stats)) != 0) {
+      return -2;
+    }
+
+    if (overrun_statistics_fn != NULL
+        && overrun_statistics_fn(&stats, overrun_statistics_fn_args) != 0) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+/* Return 0 if the blocking records whose magic number has been read
+   have been processed, -1 if blocking_statistics_fn returns non-zero
+   or -2 in case of error. */
+static int blocking_statistics_read(FILE *stats_log,
+                                    int (*blocking_statistics_fn)
+                                    (task_blocking_statistics *stats,
+                                     void *args),
+                                    void *blocking_statistics_fn_args,
+                                    unsigned long *lost_blocking_count)
+{
+  task_statistics_blocking preamble;
+  if (stats_log_read(stats_log, (char *) &preamble + sizeof(preamble.magic),
+                     sizeof(preamble) - sizeof(preamble.magic)) != 0) {
+    return -2;
+  }
+  if (lost_blocking_count != NULL) {
+    *lost_blocking_count = preamble.lost_record_count;
+  }
+
+  unsigned long i;
+  for (i = 0; i < preamble.record_count; i++) {
+    task_blocking_statistics stats;
+    if (stats_log_read(stats_log, &stats, sizeof(stats)) != 0) {
+      return -2;
+    }
+
+    if (blocking_statistics_fn != NULL
+        && blocking_statistics_fn(&stats, blocking_statistics_fn_args) != 0) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+/* Return 0 if the CPU statistics whose magic number has been read
+   have been processed, -1 if job_cpu_statistics_fn returns non-zero
+   or -2 in case of error. */
+static int cpu_statistics_read(FILE *stats_log,
+                               int (*job_cpu_statistics_fn)
+                               (job_cpu_statistics *stats, void *args),
+                               void *job_cpu_statistics_fn_args)
+{
+  task_statistics_cpu preamble;
+  if (stats_log_read(stats_log, (char *) &preamble + sizeof(preamble.magic),
+                     sizeof(preamble) - sizeof(preamble.magic)) != 0) {
+    return -2;
+  }
+
+  unsigned long i;
+  for (i = 0; i < preamble.record_count; i++) {
+    job_cpu_statistics stats;
+    if (stats_log_read(stats_log, &stats, sizeof(stats)) != 0) {
+      return -2;
+    }
+
+    if (job_cpu_statistics_fn != NULL
+        && job_cpu_statistics_fn(&stats, job_cpu_statistics_fn_args) != 0) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+/* Return 0 if the mode change records whose magic number has been
+   read have been processed, -1 if mode_statistics_fn returns non-zero
+   or -2 in case of error. */
+static int mode_statistics_read(FILE *stats_log,
+                                int (*mode_statistics_fn)
+                                (task_mode_statistics *stats, void *args),
+                                void *mode_statistics_fn_args)
+{
+  task_statistics_mode preamble;
+  if (stats_log_read(stats_log, (char *) &preamble + sizeof(preamble.magic),
+                     sizeof(preamble) - sizeof(preamble.magic)) != 0) {
+    return -2;
+  }
+
+  unsigned long i;
+  for (i = 0; i < preamble.record_count; i++) {
+    task_mode_statistics stats;
+    if (stats_log_read(stats_log, &stats, sizeof(stats)) != 0) {
+      return -2;
+    }
+
+    if (mode_statistics_fn != NULL
+        && mode_statistics_fn(&stats, mode_statistics_fn_args) != 0) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+int task_statistics_read_ex(FILE *stats_log,
+                            int (*task_statistics_fn)(task *tau, void *args),
+                            void *task_statistics_fn_args,
+                            int (*job_statistics_fn)(job_statistics *stats,
+                                                     void *args),
+                            void *job_statistics_fn_args,
+                            int (*overrun_statistics_fn)
+                            (task_overrun_statistics *stats, void *args),
+                            void *overrun_statistics_fn_args)
+{
+  const struct task_statistics_callbacks callbacks = {
+    .task_statistics_fn = task_statistics_fn,
+    .task_statistics_fn_args = task_statistics_fn_args,
+    .job_statistics_fn = job_statistics_fn,
+    .job_statistics_fn_args = job_statistics_fn_args,
+    .overrun_statistics_fn = overrun_statistics_fn,
+    .overrun_statistics_fn_args = overrun_statistics_fn_args,
+  };
+
+  return task_statistics_read_full(stats_log, &callbacks);
+}
+
+int task_statistics_read_full(FILE *stats_log,
+                              const struct task_statistics_callbacks
+                              *callbacks)
 {
   int exit_code = -3;
   char *task_name = NULL;
 
+  if (callbacks->lost_blocking_count != NULL) {
+    *callbacks->lost_blocking_count = 0;
+  }
+
   if (feof(stats_log)) {
     exit_code = -4;
     goto out;
@@ -684,6 +1805,10 @@ int task_statistics_read(FILE *stats_log,
 
   /* Populate task ring buffer params from task_statistics_ringbuf */
   tau.stats_ringbuf = NULL;
+  tau.watchdog = NULL;
+  tau.blocking = NULL;
+  tau.mode = NULL;
+  tau.fast_stop = NULL;
   if (tau.disable_job_statistics) {
     /* Set the following to a definite value although they are
        meaningless when job statistics logging is disabled. */
@@ -710,7 +1835,8 @@ int task_statistics_read(FILE *stats_log,
   /* END: Populate task ring buffer params from task_statistics_ringbuf */
 
   /* Let task parameters be processed */
-  if (task_statistics_fn(&tau, task_statistics_fn_args) != 0) {
+  if (callbacks->task_statistics_fn(&tau,
+                                    callbacks->task_statistics_fn_args) != 0) {
     exit_code = -1;
     goto out;
   }
@@ -720,9 +1846,13 @@ int task_statistics_read(FILE *stats_log,
   if (!tau.disable_job_statistics) {
     int rc = 0;
     job_statistics job_stats;
+    unsigned long job_count = tau.write_count - tau.lost_job_count;
 
-    while ((rc = job_statistics_read(stats_log, &job_stats)) == 0) {
-      if (job_statistics_fn(&job_stats, job_statistics_fn_args) != 0)
+    while (job_count-- > 0
+           && (rc = job_statistics_read(stats_log, &job_stats)) == 0) {
+      if (callbacks->job_statistics_fn(&job_stats,
+                                       callbacks->job_statistics_fn_args)
+          != 0)
         {
           exit_code = -2;
           goto out;
@@ -730,8 +1860,10 @@ int task_statistics_read(FILE *stats_log,
     }
 
     switch (rc) {
+    case 0:
+      break;
     case -1:
-      exit_code = 0;
+      exit_code = 0; /* The task was not stopped properly */
       goto out;
     default:
       log_error("Cannot read the next job timings");
@@ -740,6 +1872,86 @@ int task_statistics_read(FILE *stats_log,
   }
   /* END: Read each job recorded timings */
 
+  /* Read the CPU, overrun, blocking and mode change records if any */
+  for (;;) {
+    uint32_t magic;
+    byte_read = fread(&magic, 1, sizeof(magic), stats_log);
+    if (byte_read != sizeof(magic)) {
+      if (ferror(stats_log)) {
+        log_syserror("Cannot read task stats log stream");
+      } else if (byte_read == 0) {
+        exit_code = 0; /* No more records */
+      } else {
+        log_error("Corrupted task stats log");
+      }
+      goto out;
+    }
+
+    switch (magic) {
+    case TASK_STATISTICS_OVERRUN_MAGIC:
+      switch (overrun_statistics_read(stats_log,
+                                      callbacks->overrun_statistics_fn,
+                                      callbacks->overrun_statistics_fn_args)) {
+      case 0:
+        break;
+      case -1:
+        exit_code = -5;
+        goto out;
+      default:
+        log_error("Cannot read the overrun records");
+        goto out;
+      }
+      break;
+    case TASK_STATISTICS_BLOCKING_MAGIC:
+      switch (blocking_statistics_read(stats_log,
+                                       callbacks->blocking_statistics_fn,
+                                       callbacks->blocking_statistics_fn_args,
+                                       callbacks->lost_blocking_count)) {
+      case 0:
+        break;
+      case -1:
+        exit_code = -6;
+        goto out;
+      default:
+        log_error("Cannot read the blocking records");
+        goto out;
+      }
+      break;
+    case TASK_STATISTICS_CPU_MAGIC:
+      switch (cpu_statistics_read(stats_log,
+                                  callbacks->job_cpu_statistics_fn,
+                                  callbacks->job_cpu_statistics_fn_args)) {
+      case 0:
+        break;
+      case -1:
+        exit_code = -7;
+        goto out;
+      default:
+        log_error("Cannot read the CPU records");
+        goto out;
+      }
+      break;
+    case TASK_STATISTICS_MODE_MAGIC:
+      switch (mode_statistics_read(stats_log,
+                                   callbacks->mode_statistics_fn,
+                                   callbacks->mode_statistics_fn_args)) {
+      case 0:
+        break;
+      case -1:
+        exit_code = -8;
+        goto out;
+      default:
+        log_error("Cannot read the mode change records");
+        goto out;
+      }
+      break;
+    default:
+      log_error("Corrupted task stats log");
+      goto out;
+    }
+  }
+  /* END: Read the CPU, overrun, blocking and mode change records if any */
+
  out:
   if (task_name != NULL) {
     free(task_name);
@@ -811,3 +2023,104 @@ int task_statistics_job_statistics_disabled(const task *tau)
 {
   return tau->disable_job_statistics;
 }
+
+unsigned long task_overrun_statistics_job_pos(const task_overrun_statistics
+                                              *stats)
+{
+  return stats->job_pos;
+}
+
+enum task_overrun_kind
+task_overrun_statistics_kind(const task_overrun_statistics *stats)
+{
+  return stats->kind;
+}
+
+enum task_overrun_action
+task_overrun_statistics_action(const task_overrun_statistics *stats)
+{
+  return stats->action;
+}
+
+absolute_time *task_overrun_statistics_time(const task_overrun_statistics
+                                            *stats)
+{
+  struct timespec t_detection = stats->t_detection;
+  return timespec_to_utility_time_dyn(&t_detection);
+}
+
+unsigned long task_blocking_statistics_job_pos(const task_blocking_statistics
+                                               *stats)
+{
+  return stats->job_pos;
+}
+
+unsigned task_blocking_statistics_point(const task_blocking_statistics *stats)
+{
+  return stats->point;
+}
+
+absolute_time *
+task_blocking_statistics_time_begin(const task_blocking_statistics *stats)
+{
+  struct timespec t_begin = stats->t_begin;
+  return timespec_to_utility_time_dyn(&t_begin);
+}
+
+absolute_time *
+task_blocking_statistics_time_end(const task_blocking_statistics *stats)
+{
+  struct timespec t_end = stats->t_end;
+  return timespec_to_utility_time_dyn(&t_end);
+}
+
+unsigned long task_mode_statistics_job_pos(const task_mode_statistics *stats)
+{
+  return stats->job_pos;
+}
+
+enum task_mode_status
+task_mode_statistics_status(const task_mode_statistics *stats)
+{
+  return stats->status;
+}
+
+absolute_time *
+task_mode_statistics_time_request(const task_mode_statistics *stats)
+{
+  struct timespec t_request = stats->t_request;
+  return timespec_to_utility_time_dyn(&t_request);
+}
+
+absolute_time *
+task_mode_statistics_time_apply(const task_mode_statistics *stats)
+{
+  struct timespec t_apply = stats->t_apply;
+  return timespec_to_utility_time_dyn(&t_apply);
+}
+
+absolute_time *
+task_mode_statistics_time_release(const task_mode_statistics *stats)
+{
+  struct timespec t_release = stats->t_release;
+  return timespec_to_utility_time_dyn(&t_release);
+}
+
+relative_time *task_mode_statistics_wcet(const task_mode_statistics *stats)
+{
+  struct timespec wcet = stats->wcet;
+  return timespec_to_utility_time_dyn(&wcet);
+}
+
+relative_time *task_mode_statistics_period(const task_mode_statistics *stats)
+{
+  struct timespec period = stats->period;
+  return timespec_to_utility_time_dyn(&period);
+}
+
+relative_time *task_mode_statistics_deadline(const task_mode_statistics
+                                             *stats)
+{
+  struct timespec deadline = stats->deadline;
+  return timespec_to_utility_time_dyn(&deadline);
+}
@@ -49,6 +49,38 @@
  * create a thread that will invoke function task_start() and schedule
  * the thread according to the scheduling algorithm.
  *
+ * Optionally, a task can have an overrun watchdog (c.f.,
+ * task_set_overrun_watchdog()) that detects a job overrunning its
+ * deadline or its WCET while the job is still running. Each detected
+ * overrun is recorded in the task statistics and can be handled by a
+ * user callback that decides whether the job continues, the next
+ * release is skipped or the job is aborted.
+ *
+ * Optionally, a task can also record the time its jobs spend blocked
+ * (c.f., task_set_blocking_recorder()). The job program brackets each
+ * blocking point, such as the acquisition of a lock, with
+ * task_block_begin() and task_block_end(), and the resulting blocking
+ * records are saved into the task statistics as well.
+ *
+ * Optionally, a task whose affinity is not locked to a single CPU can
+ * record the CPU at which each job starts and finishes and the
+ * context switches suffered by each job (c.f.,
+ * TASK_RINGBUF_RECORD_CPU) to tell the migrations and the
+ * preemptions of the job.
+ *
+ * Optionally, a task can accept mode changes (c.f.,
+ * task_set_mode_change()) that update its WCET, period and deadline
+ * while it is running. A mode change requested by another thread
+ * using task_change_mode() takes effect at the next job boundary
+ * (also updating the SCHED_DEADLINE reservation of the task thread,
+ * if any), and the request, application and first release times of
+ * each mode change are saved into the task statistics so that the
+ * jobs can be analyzed per mode.
+ *
+ * Optionally, a task can be stopped quickly (c.f.,
+ * task_set_fast_stop()) so that tearing down an experiment does not
+ * take up to one period per task.
+ *
  * @author Tadeus Prastowo <eus@member.fsf.org>
  */
 
@@ -60,9 +92,15 @@
 #include <stdio.h>
 #include <signal.h>
 #include <pthread.h>
+#include <setjmp.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <linux/futex.h>
 #include "utility_time.h"
 #include "utility_cpu.h"
 #include "utility_file.h"
+#include "utility_sched_deadline.h"
 #include "job.h"
 
 #ifdef __cplusplus
@@ -70,6 +108,18 @@ extern "C" {
 #endif
 
   /* I. Main data structures */
+  /** The overrun watchdog of a task (c.f., task_set_overrun_watchdog()). */
+  struct task_watchdog;
+
+  /** The blocking recorder of a task (c.f., task_set_blocking_recorder()). */
+  struct task_blocking;
+
+  /** The mode change state of a task (c.f., task_set_mode_change()). */
+  struct task_mode;
+
+  /** The fast stop state of a task (c.f., task_set_fast_stop()). */
+  struct task_fast_stop;
+
   /**
    * The Liu & Layland's real-time task model.
    * This is an opaque type; do not manipulate any of its instances directly.
@@ -105,18 +155,22 @@ extern "C" {
                         calculate the next release time. */
 
     int aperiodic; /* This is non-zero iff aperiodic_release is not NULL. */
-    void (*aperiodic_release)(void *args); /* If this is set
-                                              (non-NULL), the job will
-                                              only be released
-                                              everytime this function
-                                              returns. Otherwise, this
-                                              task will run
-                                              periodically. */
+    int (*aperiodic_release)(void *args); /* If this is set
+                                             (non-NULL), the job will
+                                             only be released
+                                             everytime this function
+                                             returns zero. Otherwise,
+                                             this task will run
+                                             periodically. */
     void *args; /* Arguments to be passed to aperiodic_release
                    callback function. */
     int inside_aperiodic_release; /* Non-zero means that the task is
                                      still inside function
                                      aperiodic_release. */
+    int aperiodic_release_ended; /* Non-zero means that the task has
+                                    seen that it is stopped after a
+                                    job and will not call function
+                                    aperiodic_release anymore. */
 
     struct job job; /* The job of this task. */
 
@@ -143,8 +197,82 @@ extern "C" {
                                               of a job. This is
                                               not included in
                                               finish_to_start_overhead. */
+    struct task_watchdog *watchdog; /* NULL if overrun detection is
+                                       disabled. */
+    struct task_blocking *blocking; /* NULL if blocking recording is
+                                       disabled. */
+    struct task_mode *mode; /* NULL if mode changes are disabled. */
+    struct task_fast_stop *fast_stop; /* NULL if fast stop is disabled. */
   } task;
 
+  /**
+   * The kinds of overrun that can be detected by the overrun watchdog
+   * of a task. They can be OR-ed together to select more than one.
+   */
+  enum task_overrun_kind {
+    TASK_OVERRUN_DEADLINE = 1, /**< The job has not finished by its
+                                  absolute deadline. This is detected
+                                  using a CLOCK_MONOTONIC POSIX
+                                  timer. */
+    TASK_OVERRUN_BUDGET = 2, /**< The job has consumed more CPU time
+                                than the WCET of the task. This is
+                                detected using a POSIX timer on the
+                                CPU-time clock of the task thread,
+                                which the kernel may only check at
+                                every scheduler tick. */
+    TASK_OVERRUN_DL_RUNTIME = 4, /**< The SCHED_DEADLINE runtime of the
+                                    task thread has been exhausted.
+                                    This is detected using the SIGXCPU
+                                    signal sent by the kernel when the
+                                    task thread has entered
+                                    SCHED_DEADLINE with
+                                    SCHED_FLAG_DL_OVERRUN (c.f.,
+                                    sched_deadline_enter_ex()). */
+  };
+
+  /**
+   * The actions that can be taken upon an overrun.
+   */
+  enum task_overrun_action {
+    TASK_OVERRUN_CONTINUE, /**< Let the job continue. */
+    TASK_OVERRUN_SKIP, /**< Let the job continue but skip the next
+                          release so that the task can catch up. */
+    TASK_OVERRUN_ABORT, /**< Abort the job immediately. */
+    TASK_OVERRUN_SKIPPED, /**< Only found in the task statistics to
+                             signify that the release has been
+                             skipped due to an earlier
+                             TASK_OVERRUN_SKIP. */
+  };
+
+  /**
+   * The callback function that handles an overrun. It is called in
+   * the context of a signal handler executed by the task thread, and
+   * therefore, it must only call async-signal-safe functions.
+   *
+   * @param tau a pointer to the task whose job overruns.
+   * @param kind the kind of the detected overrun.
+   * @param job_pos the release position of the job starting from one.
+   * @param args the handler_args passed to task_set_overrun_watchdog().
+   *
+   * @return the action to be taken, which is either
+   * TASK_OVERRUN_CONTINUE, TASK_OVERRUN_SKIP or TASK_OVERRUN_ABORT.
+   */
+  typedef enum task_overrun_action
+  (*task_overrun_handler)(task *tau, enum task_overrun_kind kind,
+                          unsigned long job_pos, void *args);
+
+  /**
+   * The record of an overrun detected by the overrun watchdog.
+   * This is an opaque type; do not manipulate any of its instances directly.
+   */
+  typedef struct __attribute__((packed))
+  {
+    unsigned long job_pos; /* The release position of the job. */
+    uint8_t kind; /* enum task_overrun_kind */
+    uint8_t action; /* enum task_overrun_action */
+    struct timespec t_detection; /* The time the overrun is detected. */
+  } task_overrun_statistics;
+
   /**
    * The statistics of a real-time task.
    * This is an opaque type; do not manipulate any of its instances directly.
@@ -211,8 +339,145 @@ extern "C" {
     unsigned long lost_job_count; /**< The number of job lost due to overrun. */
     unsigned long write_count; /**< Total number of job statistics data. */
   } task_statistics_ringbuf;
+
+  /**
+   * The preamble of the overrun records that follow the job
+   * statistics in the task statistics file when the overrun watchdog
+   * is enabled. This is an opaque type; do not manipulate any of its
+   * instances directly.
+   */
+  typedef struct __attribute__((packed))
+  {
+    uint32_t magic; /**< Always TASK_STATISTICS_OVERRUN_MAGIC. */
+    unsigned long event_count; /**< The number of overrun records. */
+    unsigned long lost_event_count; /**< The number of overruns that
+                                       cannot be recorded. */
+  } task_statistics_overrun;
+
+  /** The magic number that starts task_statistics_overrun. */
+#define TASK_STATISTICS_OVERRUN_MAGIC 0x4E52564FU /* "OVRN" */
+
+  /**
+   * The record of a blocking point passed by a job (c.f.,
+   * task_block_end()).
+   * This is an opaque type; do not manipulate any of its instances directly.
+   */
+  typedef struct __attribute__((packed))
+  {
+    unsigned long job_pos; /* The release position of the job. */
+    uint32_t point; /* The blocking point given by the job program. */
+    struct timespec t_begin; /* The time the job starts to block. */
+    struct timespec t_end; /* The time the job stops to block. */
+  } task_blocking_statistics;
+
+  /**
+   * The preamble of the blocking records that follow the overrun
+   * records (if any) in the task statistics file when the blocking
+   * recorder is enabled. This is an opaque type; do not manipulate
+   * any of its instances directly.
+   */
+  typedef struct __attribute__((packed))
+  {
+    uint32_t magic; /**< Always TASK_STATISTICS_BLOCKING_MAGIC. */
+    unsigned long record_count; /**< The number of blocking records. */
+    unsigned long lost_record_count; /**< The number of the oldest
+                                        blocking records that have
+                                        been overwritten. */
+  } task_statistics_blocking;
+
+  /** The magic number that starts task_statistics_blocking. */
+#define TASK_STATISTICS_BLOCKING_MAGIC 0x4B434C42U /* "BLCK" */
+
+  /**
+   * The preamble of the CPU statistics of the jobs that follow the
+   * job statistics in the task statistics file when the task records
+   * them (c.f., TASK_RINGBUF_RECORD_CPU). This is an opaque type; do
+   * not manipulate any of its instances directly.
+   */
+  typedef struct __attribute__((packed))
+  {
+    uint32_t magic; /**< Always TASK_STATISTICS_CPU_MAGIC. */
+    unsigned long record_count; /**< The number of job_cpu_statistics
+                                   objects, which is that of the
+                                   job_statistics objects. */
+  } task_statistics_cpu;
+
+  /** The magic number that starts task_statistics_cpu. */
+#define TASK_STATISTICS_CPU_MAGIC 0x5550434AU /* "JCPU" */
+
+  /**
+   * The outcomes of a mode change (c.f., task_change_mode()).
+   */
+  enum task_mode_status {
+    TASK_MODE_APPLIED, /**< The task has switched to the new mode. */
+    TASK_MODE_REJECTED, /**< The SCHED_DEADLINE reservation of the
+                           task thread cannot be updated to the new
+                           mode (e.g., the admission control rejects
+                           the new bandwidth), and so the task keeps
+                           its old mode. */
+  };
+
+  /**
+   * The record of a mode change of a task (c.f., task_change_mode()).
+   * This is an opaque type; do not manipulate any of its instances directly.
+   */
+  typedef struct __attribute__((packed))
+  {
+    unsigned long job_pos; /* The release position of the first job
+                              of the new mode. */
+    uint8_t status; /* enum task_mode_status */
+    struct timespec t_request; /* The time the mode change is requested. */
+    struct timespec t_apply; /* The time the mode change is applied. */
+    struct timespec t_release; /* The release time of the first job of
+                                  the new mode, which is t_apply for
+                                  an aperiodic task. */
+    struct timespec wcet; /* The WCET of the new mode. */
+    struct timespec period; /* The period of the new mode. */
+    struct timespec deadline; /* The deadline of the new mode. */
+  } task_mode_statistics;
+
+  /**
+   * The preamble of the mode change records that follow the blocking
+   * records (if any) in the task statistics file when mode changes
+   * are enabled. This is an opaque type; do not manipulate any of its
+   * instances directly.
+   */
+  typedef struct __attribute__((packed))
+  {
+    uint32_t magic; /**< Always TASK_STATISTICS_MODE_MAGIC. */
+    unsigned long record_count; /**< The number of mode change records. */
+    unsigned long lost_record_count; /**< The number of mode changes
+                                        that cannot be recorded. */
+  } task_statistics_mode;
+
+  /** The magic number that starts task_statistics_mode. */
+#define TASK_STATISTICS_MODE_MAGIC 0x45444F4DU /* "MODE" */
+
+  /**
+   * The flags of the ring buffer of the job statistics of a task
+   * (c.f., task_create()). They can be OR-ed together.
+   */
+  enum task_ringbuf_flag {
+    TASK_RINGBUF_DISABLE_OVERRUN = 1, /**< Once the ring buffer is
+                                         full, additional job
+                                         statistics are not
+                                         saved. Otherwise, the ring
+                                         buffer will overwrite the
+                                         saved job statistics starting
+                                         from the oldest one. */
+    TASK_RINGBUF_RECORD_CPU = 2, /**< Record the CPU statistics of each
+                                    job as well (c.f.,
+                                    jobstats_ringbuf_create_ex()). The
+                                    job_statistics_overhead passed to
+                                    task_create() should then be
+                                    measured using
+                                    job_statistics_overhead_ex(). */
+  };
   /* End of main data structures */
 
+  /** The signal used by the POSIX timers of the overrun watchdog. */
+#define TASK_WATCHDOG_SIGNAL (SIGRTMIN + 1)
+
   /* II */
   /**
    * @name Collection of task maintenance functions.
@@ -253,15 +518,19 @@ extern "C" {
    * released. The utility_time object is garbage collected
    * automatically if it is possible.
    * @param aperiodic_release if this is set, then the task will
-   * release one job whenever function aperiodic_release
-   * returns. Since function aperiodic_release can block waiting for
-   * an event, the function must be ready to be killed at any time
-   * when the task set is shut down. The task itself will not be
-   * killed when executing its task program because the task program
-   * has a definite WCET and so it is reasonable to wait for the
-   * completion. Whenever this function returns, the task program will
-   * always be executed once. If this is not set, then the task will
-   * release a stream of jobs.
+   * release one job whenever function aperiodic_release returns
+   * zero. Since function aperiodic_release can block waiting for an
+   * event, the function must be ready to be killed at any time when
+   * the task set is shut down. The task itself will not be killed
+   * when executing its task program because the task program has a
+   * definite WCET and so it is reasonable to wait for the
+   * completion. Whenever this function returns zero, the task program
+   * will always be executed once. Whenever this function returns
+   * non-zero (e.g., its event source fails), the task releases no
+   * more job and task_start() returns. To release jobs when file
+   * descriptors become ready, pass release_sources_wait() of
+   * utility_release.h together with its ::release_sources object. If
+   * this is not set, then the task will release a stream of jobs.
    * @param aperiodic_release_args a pointer to the arguments to be
    * passed to function aperiodic_release.
    * @param stats_file_path a pointer to a NULL-terminated string
@@ -271,10 +540,9 @@ extern "C" {
    * buffer will be able to store without overrunning. Setting this to
    * zero will disable the sampling and logging of job start times and
    * finishing times reducing the finish-to-start overhead.
-   * @param ringbuffer_disable_overrun if non-zero, once the ring
-   * buffer is full, additional job statistics are not
-   * saved. Otherwise, the ring buffer will overwrite the saved job
-   * statistics starting from the oldest one.
+   * @param ringbuffer_flags zero or an OR-ed combination of
+   * ::task_ringbuf_flag. For example, passing 1 only disables the
+   * overrun of the ring buffer.
    * @param job_statistics_overhead the result of running
    * job_statistics_overhead(). The utility_time object is garbage
    * collected automatically if it is possible. This overhead is
@@ -295,8 +563,9 @@ extern "C" {
    *
    * @return zero if the initialization is successful, -1 in case of
    * hard error that requires the investigation of the output of the
-   * logging facility to fix the error, or -2 if stats_file_path
-   * cannot be opened successfully for writing.
+   * logging facility to fix the error (e.g., an unknown flag in
+   * ringbuffer_flags), or -2 if stats_file_path cannot be opened
+   * successfully for writing.
    */
   int task_create(const char *name,
                   const relative_time *wcet,
@@ -304,11 +573,11 @@ extern "C" {
                   const relative_time *deadline,
                   const absolute_time *t_0,
                   const relative_time *offset,
-                  void (*aperiodic_release)(void *args),
+                  int (*aperiodic_release)(void *args),
                   void *aperiodic_release_args,
                   const char *stats_file_path,
                   unsigned long ringbuffer_size,
-                  int ringbuffer_disable_overrun,
+                  int ringbuffer_flags,
                   const relative_time *job_statistics_overhead,
                   const relative_time *finish_to_start_overhead,
                   void (*task_program)(void *args),
@@ -321,6 +590,107 @@ extern "C" {
    * function.
    */
   void task_destroy(task *tau);
+
+  /**
+   * Enable the overrun watchdog of a task that has not been
+   * started. Once enabled, each job of the task is monitored for the
+   * selected kinds of overrun. When an overrun is detected, the
+   * overrun is recorded and handler is called to decide the action
+   * to take. The overrun records are saved into the task statistics
+   * file after the job statistics when the task is stopped, and can
+   * be read using task_statistics_read_ex().
+   *
+   * The overrun is signalled to the task thread using
+   * TASK_WATCHDOG_SIGNAL (and SIGXCPU for TASK_OVERRUN_DL_RUNTIME)
+   * whose handler is installed process-wide by this function. If the
+   * job may be aborted, the task program must only call
+   * async-signal-safe functions because the abortion is done by
+   * jumping out of the signal handler.
+   *
+   * @param tau a pointer to the task whose jobs are to be monitored.
+   * @param kinds one or more of enum task_overrun_kind OR-ed together.
+   * @param event_slot_count the number of overrun records that can be
+   * stored. Overruns detected after the storage is full are still
+   * handled but not recorded.
+   * @param handler the callback function to decide the action to
+   * take upon an overrun. If this is NULL, the action is always
+   * TASK_OVERRUN_CONTINUE.
+   * @param handler_args a pointer to the object that will be passed
+   * to handler.
+   *
+   * @return zero if the watchdog is enabled, -1 if kinds is invalid,
+   * event_slot_count is zero or the watchdog is already enabled, or
+   * -2 in case of hard error that requires the investigation of the
+   * output of the logging facility to fix the error.
+   */
+  int task_set_overrun_watchdog(task *tau, unsigned kinds,
+                                unsigned long event_slot_count,
+                                task_overrun_handler handler,
+                                void *handler_args);
+
+  /**
+   * Enable the blocking recorder of a task that has not been started
+   * and whose job statistics are not disabled. Once enabled, every
+   * task_block_end() called by a job of the task stores a blocking
+   * record in a ring buffer that overwrites the oldest record when
+   * full. The ring buffer is saved into the task statistics file
+   * after the overrun records when the task is stopped, and can be
+   * read using task_statistics_read_full().
+   *
+   * @param tau a pointer to the task whose blocking times are to be
+   * recorded.
+   * @param slot_count the number of blocking records that the ring
+   * buffer can store.
+   *
+   * @return zero if the recorder is enabled, -1 if slot_count is
+   * zero, the job statistics are disabled or the recorder is already
+   * enabled, or -2 if there is no memory for the ring buffer.
+   */
+  int task_set_blocking_recorder(task *tau, unsigned long slot_count);
+
+  /**
+   * Enable the mode changes of a task that has not been started (c.f.,
+   * task_change_mode()). The mode change records are saved into the
+   * task statistics file after the blocking records when the task is
+   * stopped, and can be read using task_statistics_read_full(). The
+   * task parameters in the task statistics file remain those of the
+   * initial mode.
+   *
+   * @param tau a pointer to the task whose mode can be changed.
+   * @param slot_count the number of mode change records that can be
+   * stored. Mode changes requested after the storage is full are
+   * still applied but not recorded.
+   *
+   * @return zero if the mode changes are enabled, -1 if slot_count is
+   * zero or the mode changes are already enabled, or -2 if there is
+   * no memory for the records.
+   */
+  int task_set_mode_change(task *tau, unsigned long slot_count);
+
+  /**
+   * Enable the fast stop of a task that has not been started. Once
+   * enabled, task_stop() wakes the task thread immediately instead of
+   * letting a periodic task release one more job or polling an
+   * aperiodic task until it can be cancelled. The task thread then
+   * returns from task_start() after writing the task statistics as
+   * usual, and the time from task_stop() until then can be obtained
+   * using task_stop_latency().
+   *
+   * The function aperiodic_release of an aperiodic task whose fast
+   * stop is enabled is never cancelled. Instead, it must also wait
+   * for the file descriptor returned by task_stop_fd() to become
+   * readable (e.g., using poll()) and return once it is readable, in
+   * which case the task program is not executed whatever the
+   * function returns.
+   *
+   * @param tau a pointer to the task whose fast stop is to be enabled.
+   *
+   * @return zero if the fast stop is enabled, -1 if it is already
+   * enabled, or -2 in case of hard error that requires the
+   * investigation of the output of the logging facility to fix the
+   * error.
+   */
+  int task_set_fast_stop(task *tau);
   /** @} End of collection of task maintenance functions. */
 
   /* III */
@@ -359,8 +729,8 @@ extern "C" {
    * ms and function job_statistics_overhead returns 2 us while
    * function finish_to_start_overhead returns 100 us, then the WCET
    * of the task program should be approximately (50 - 0.002 - 0.100)
-   * ms. Remember that each time function aperiodic_release returns,
-   * the task program will always be run once.
+   * ms. Remember that each time function aperiodic_release returns
+   * zero, the task program will always be run once.
    *
    * @param tau a pointer to the task to be started.
    *
@@ -380,9 +750,100 @@ extern "C" {
    * that is going to be stopped or by the thread that is going to
    * stop itself.
    *
+   * If the fast stop of the task is enabled (c.f.,
+   * task_set_fast_stop()), a periodic task waiting for its next
+   * release or an aperiodic task waiting in aperiodic_release is
+   * woken up and does not release the next job. Otherwise, a periodic
+   * task still releases its next job, and this function waits for
+   * the job of an aperiodic task to complete before cancelling the
+   * task thread.
+   *
    * @param tau a pointer to the task to be stopped.
    */
   void task_stop(task *tau);
+
+  /**
+   * @return the file descriptor that becomes readable once task_stop()
+   * is called for a task whose fast stop is enabled, or -1 if the fast
+   * stop is not enabled. The file descriptor must not be read or
+   * closed.
+   */
+  int task_stop_fd(const task *tau);
+
+  /**
+   * Obtain the stop latency of a task whose fast stop is enabled,
+   * which is the duration from the call of task_stop() until the task
+   * thread returns from task_start() after writing the task
+   * statistics. The latency is bounded by the remaining execution of
+   * the job running when task_stop() is called plus the time to write
+   * the task statistics.
+   *
+   * @param tau a pointer to the task whose task_start() has returned.
+   *
+   * @return the stop latency as a utility_time object fits for
+   * automatic garbage collection, or NULL if the fast stop is not
+   * enabled or the task has not returned from task_start() after
+   * task_stop() is called.
+   */
+  relative_time *task_stop_latency(const task *tau);
+
+  /**
+   * Mark that the job of the task run by the calling thread starts to
+   * block (e.g., right before acquiring a lock). This does nothing if
+   * the calling thread is not running a task whose blocking recorder
+   * is enabled, and therefore, a job program can be instrumented
+   * unconditionally. Blocking points must not be nested.
+   */
+  void task_block_begin(void);
+
+  /**
+   * Mark that the job that has called task_block_begin() stops to
+   * block (e.g., right after acquiring the lock) and record the
+   * blocking. Like task_block_begin(), this does nothing if the
+   * recorder is not enabled. The overhead of a pair of
+   * task_block_begin() and task_block_end() is that of two
+   * clock_gettime() calls.
+   *
+   * @param point the identifier of the blocking point (e.g., the
+   * number of the lock) to be stored in the record.
+   */
+  void task_block_end(unsigned point);
+
+  /**
+   * Request a running task whose mode changes are enabled (c.f.,
+   * task_set_mode_change()) to switch to a new mode. This is meant to
+   * be called by a controller thread other than the task thread, and
+   * only one thread may request the mode changes of a task.
+   *
+   * The request is applied by the task thread at the next job
+   * boundary: once the current job has finished, the WCET and the
+   * deadline of the new mode apply from the next release onwards. In
+   * a periodic task, the next release still takes place one old
+   * period after the release of the current job, and the new period
+   * separates the subsequent releases. If the task thread is
+   * scheduled using SCHED_DEADLINE, its reservation is updated to
+   * have the WCET of the new mode as the runtime and the deadline and
+   * the period of the new mode. If the reservation cannot be updated,
+   * the task keeps its old mode. Either way, the outcome is recorded
+   * with the time of the request, the time of the application and
+   * the release time of the first job of the new mode. A request that
+   * is still pending when the task is stopped is discarded.
+   *
+   * All utility_time objects whose addresses are passed as the
+   * arguments are garbage collected automatically if it is possible.
+   *
+   * @param tau a pointer to the task whose mode is to be changed.
+   * @param wcet a pointer to the WCET of the new mode.
+   * @param period a pointer to the period of the new mode.
+   * @param deadline a pointer to the relative deadline of the new mode.
+   *
+   * @return zero if the request has been made, or -1 if the mode
+   * changes of the task are not enabled or the previous request has
+   * not been applied yet.
+   */
+  int task_change_mode(task *tau, const relative_time *wcet,
+                       const relative_time *period,
+                       const relative_time *deadline);
   /** @} End of collection of task execution functions */
 
   /* IV */
@@ -391,6 +852,34 @@ extern "C" {
    * @{
    */
 
+  /**
+   * Serialize (write) the statistics of a periodic task that is not
+   * run using task_start(), such as a simulated task, in the same
+   * format as that written by a task created using task_create() so
+   * that it can be read using task_statistics_read().
+   *
+   * @param stats_log a pointer to the binary FILE object to write to.
+   * @param jobs a pointer to the ring buffer of the job statistics
+   * (c.f., job_record()) or NULL if job statistics logging is
+   * disabled. Its CPU statistics are written as well if it records
+   * them. The other parameters are like those of task_create(),
+   * and so, they are garbage collected if automatic garbage
+   * collection is permitted.
+   *
+   * @return zero if successful, or -1 if there is insufficient memory
+   * or an I/O error (the error itself is @ref utility_log.h "logged"
+   * directly).
+   */
+  int task_statistics_write(FILE *stats_log, const char *name,
+                            const relative_time *wcet,
+                            const relative_time *period,
+                            const relative_time *deadline,
+                            const absolute_time *t_0,
+                            const relative_time *offset,
+                            const relative_time *job_statistics_overhead,
+                            const relative_time *finish_to_start_overhead,
+                            const jobstats_ringbuf *jobs);
+
   /**
    * Deserialize (read) the task_statistics object from the given
    * file. The callback task_statistics_fn is first called to process
@@ -430,6 +919,201 @@ extern "C" {
                                                     void *args),
                            void *job_statistics_fn_args);
 
+  /**
+   * Work just like task_statistics_read() but after all jobs have
+   * been processed, the callback overrun_statistics_fn is called for
+   * each overrun recorded by the overrun watchdog (c.f.,
+   * task_set_overrun_watchdog()).
+   *
+   * @param overrun_statistics_fn the callback function to process
+   * each overrun. The callback can stop the deserializing process by
+   * returning a non-zero value. This can be NULL to skip the overrun
+   * records.
+   * @param overrun_statistics_fn_args the argument to be passed to the
+   * callback function overrun_statistics_fn.
+   *
+   * @return like that of task_statistics_read() plus -5 if
+   * overrun_statistics_fn returns a non-zero value.
+   */
+  int task_statistics_read_ex(FILE *stats_log,
+                              int (*task_statistics_fn)(task *tau,
+                                                        void *args),
+                              void *task_statistics_fn_args,
+                              int (*job_statistics_fn)(job_statistics *stats,
+                                                       void *args),
+                              void *job_statistics_fn_args,
+                              int (*overrun_statistics_fn)
+                              (task_overrun_statistics *stats, void *args),
+                              void *overrun_statistics_fn_args);
+
+  /**
+   * The callbacks of task_statistics_read_full(). Every callback can
+   * stop the deserializing process by returning a non-zero value and
+   * must not free any of its arguments except for its args. Except
+   * for task_statistics_fn and job_statistics_fn, a callback can be
+   * NULL to skip the corresponding records.
+   */
+  struct task_statistics_callbacks
+  {
+    /** Called like in task_statistics_read(). */
+    int (*task_statistics_fn)(task *tau, void *args);
+    void *task_statistics_fn_args;
+    /** Called like in task_statistics_read(). */
+    int (*job_statistics_fn)(job_statistics *stats, void *args);
+    void *job_statistics_fn_args;
+    /** Called like in task_statistics_read_ex(). */
+    int (*overrun_statistics_fn)(task_overrun_statistics *stats, void *args);
+    void *overrun_statistics_fn_args;
+    /** Called for each blocking record in the order of the blocking
+        (c.f., task_set_blocking_recorder()). */
+    int (*blocking_statistics_fn)(task_blocking_statistics *stats,
+                                  void *args);
+    void *blocking_statistics_fn_args;
+    /** If not NULL, a pointer to the object to store the number of
+        blocking records that have been overwritten before the task
+        was stopped, which is zero if the blocking recorder was not
+        enabled. */
+    unsigned long *lost_blocking_count;
+    /** Called for each job whose CPU statistics have been recorded
+        (c.f., TASK_RINGBUF_RECORD_CPU) in the order of the calls of
+        job_statistics_fn. Hence, the first call is for the job at
+        task_statistics_oldest_job_pos(). */
+    int (*job_cpu_statistics_fn)(job_cpu_statistics *stats, void *args);
+    void *job_cpu_statistics_fn_args;
+    /** Called for each mode change in the order of the requests
+        (c.f., task_change_mode()). */
+    int (*mode_statistics_fn)(task_mode_statistics *stats, void *args);
+    void *mode_statistics_fn_args;
+  };
+
+  /**
+   * Work just like task_statistics_read_ex() but all records of the
+   * task can be processed using the given callbacks. After all jobs
+   * have been processed, the callbacks for the overrun, blocking, CPU
+   * and mode change records are called in the order of the records in
+   * the file.
+   *
+   * @param stats_log a pointer to the FILE object containing a
+   * serialized task statistics object.
+   * @param callbacks a pointer to the callbacks, whose unused members
+   * should be zero-initialized.
+   *
+   * @return like that of task_statistics_read_ex() plus -6 if
+   * blocking_statistics_fn returns a non-zero value, -7 if
+   * job_cpu_statistics_fn returns a non-zero value or -8 if
+   * mode_statistics_fn returns a non-zero value.
+   */
+  int task_statistics_read_full(FILE *stats_log,
+                                const struct task_statistics_callbacks
+                                *callbacks);
+
+  /**
+   * @return the release position of the job starting from one.
+   */
+  unsigned long task_overrun_statistics_job_pos(const task_overrun_statistics
+                                                *stats);
+
+  /**
+   * @return the kind of the overrun.
+   */
+  enum task_overrun_kind
+  task_overrun_statistics_kind(const task_overrun_statistics *stats);
+
+  /**
+   * @return the action taken upon the overrun or TASK_OVERRUN_SKIPPED
+   * if the release has been skipped.
+   */
+  enum task_overrun_action
+  task_overrun_statistics_action(const task_overrun_statistics *stats);
+
+  /**
+   * @return the time at which the overrun was detected or the
+   * release was skipped as a utility_time object fits for automatic
+   * garbage collection.
+   */
+  absolute_time *task_overrun_statistics_time(const task_overrun_statistics
+                                              *stats);
+
+  /**
+   * @return the release position of the blocked job starting from one.
+   */
+  unsigned long task_blocking_statistics_job_pos(const task_blocking_statistics
+                                                 *stats);
+
+  /**
+   * @return the blocking point passed to task_block_end().
+   */
+  unsigned task_blocking_statistics_point(const task_blocking_statistics
+                                          *stats);
+
+  /**
+   * @return the time at which the job started to block as a
+   * utility_time object fits for automatic garbage collection.
+   */
+  absolute_time *
+  task_blocking_statistics_time_begin(const task_blocking_statistics *stats);
+
+  /**
+   * @return the time at which the job stopped to block as a
+   * utility_time object fits for automatic garbage collection.
+   */
+  absolute_time *
+  task_blocking_statistics_time_end(const task_blocking_statistics *stats);
+
+  /**
+   * @return the release position of the first job of the new mode
+   * starting from one.
+   */
+  unsigned long task_mode_statistics_job_pos(const task_mode_statistics
+                                             *stats);
+
+  /**
+   * @return the outcome of the mode change.
+   */
+  enum task_mode_status
+  task_mode_statistics_status(const task_mode_statistics *stats);
+
+  /**
+   * @return the time at which the mode change was requested as a
+   * utility_time object fits for automatic garbage collection.
+   */
+  absolute_time *
+  task_mode_statistics_time_request(const task_mode_statistics *stats);
+
+  /**
+   * @return the time at which the mode change was applied as a
+   * utility_time object fits for automatic garbage collection.
+   */
+  absolute_time *
+  task_mode_statistics_time_apply(const task_mode_statistics *stats);
+
+  /**
+   * @return the release time of the first job of the new mode as a
+   * utility_time object fits for automatic garbage collection.
+   */
+  absolute_time *
+  task_mode_statistics_time_release(const task_mode_statistics *stats);
+
+  /**
+   * @return the WCET of the new mode as a utility_time object fits
+   * for automatic garbage collection.
+   */
+  relative_time *task_mode_statistics_wcet(const task_mode_statistics *stats);
+
+  /**
+   * @return the period of the new mode as a utility_time object fits
+   * for automatic garbage collection.
+   */
+  relative_time *task_mode_statistics_period(const task_mode_statistics
+                                             *stats);
+
+  /**
+   * @return the deadline of the new mode as a utility_time object fits
+   * for automatic garbage collection.
+   */
+  relative_time *task_mode_statistics_deadline(const task_mode_statistics
+                                               *stats);
+
   /**
    * @return the name of the task.
    */
@@ -19,6 +19,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 #include "utility_testcase.h"
 #include "utility_log.h"
 #include "utility_cpu.h"
@@ -28,6 +30,7 @@
 #include "job.h"
 #include "task.h"
 #include "utility_memory.h"
+#include "utility_release.h"
 
 static char tmp_file_name[] = "task_test_XXXXXX";
 static cpu_freq_governor *used_gov = NULL;
@@ -75,9 +78,18 @@ void *task_thread(void *args)
 
   return &params->exit_status;
 }
+struct mode_change
+{
+  struct timespec t_request; /* Absolute time */
+  unsigned wcet_ms;
+  unsigned period_ms;
+  unsigned deadline_ms;
+};
 struct task_manager_params
 {
   task *tau;
+  const struct mode_change *mode_changes; /* Requested in order */
+  unsigned mode_change_count;
   struct timespec stopping_time; /* Absolute time */
   int exit_status;
 };
@@ -99,6 +111,28 @@ void *task_manager_thread(void *args)
                                  &tau_params) == 0);
   /* END: Create a task thread */
 
+  /* Change the mode of the task thread */
+  unsigned i;
+  for (i = 0; i < params->mode_change_count; i++) {
+    const struct mode_change *change = &params->mode_changes[i];
+
+    gracious_assert(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+                                    &change->t_request, NULL) == 0);
+    gracious_assert(task_change_mode(params->tau,
+                                     to_utility_time_dyn(change->wcet_ms, ms),
+                                     to_utility_time_dyn(change->period_ms, ms),
+                                     to_utility_time_dyn(change->deadline_ms,
+                                                         ms)) == 0);
+
+    /** The request is pending until the next job boundary **/
+    gracious_assert(task_change_mode(params->tau,
+                                     to_utility_time_dyn(change->wcet_ms, ms),
+                                     to_utility_time_dyn(change->period_ms, ms),
+                                     to_utility_time_dyn(change->deadline_ms,
+                                                         ms)) == -1);
+  }
+  /* END: Change the mode of the task thread */
+
   /* Wait for the time to stop the task thread */
   gracious_assert(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
                                   &params->stopping_time, NULL) == 0);  
@@ -854,6 +888,1058 @@ static void testcase_2_aperiodic_task(FILE *report,
   /* End of subtracting the aperiodic overhead from the given job duration */
 }
 
+struct overrunning_program_args
+{
+  unsigned long nth_job;
+  unsigned long overrunning_job_1;
+  unsigned long overrunning_job_2;
+  struct timespec normal_duration;
+  struct timespec overrunning_duration;
+};
+static void overrunning_program(void *args)
+{
+  struct overrunning_program_args *prms = args;
+  const struct timespec *duration = &prms->normal_duration;
+  struct timespec t_begin, t_now;
+
+  prms->nth_job++;
+  if (prms->nth_job == prms->overrunning_job_1
+      || prms->nth_job == prms->overrunning_job_2) {
+    duration = &prms->overrunning_duration;
+  }
+
+  /* Only async-signal-safe functions are used since the job can be aborted */
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t_begin);
+  do {
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t_now);
+  } while ((t_now.tv_sec - t_begin.tv_sec) * 1000000000LL
+           + (t_now.tv_nsec - t_begin.tv_nsec)
+           < duration->tv_sec * 1000000000LL + duration->tv_nsec);
+}
+static enum task_overrun_action overrun_handler(task *tau,
+                                                enum task_overrun_kind kind,
+                                                unsigned long job_pos,
+                                                void *args)
+{
+  const struct overrunning_program_args *prms = args;
+
+  if (job_pos == prms->overrunning_job_1) {
+    return TASK_OVERRUN_ABORT;
+  } else if (kind == TASK_OVERRUN_BUDGET) {
+    return TASK_OVERRUN_SKIP;
+  } else {
+    return TASK_OVERRUN_CONTINUE;
+  }
+}
+static void testcase_4_periodic_task_overrun_watchdog(void)
+{
+  const unsigned long job_count = 10;
+
+  struct overrunning_program_args program_args = {
+    .nth_job = 0,
+    .overrunning_job_1 = 3,
+    .overrunning_job_2 = 6,
+  };
+  to_timespec_gc(to_utility_time_dyn(2, ms), &program_args.normal_duration);
+  to_timespec_gc(to_utility_time_dyn(30, ms),
+                 &program_args.overrunning_duration);
+
+  /* Create periodic task with WCET < deadline < period */
+  /** The budget overrun is detected before the deadline overrun
+      even if the CPU-time clock is only checked every 10 ms tick **/
+  struct timespec t_now;
+  gracious_assert(clock_gettime(CLOCK_MONOTONIC, &t_now) == 0);
+
+  absolute_time *t_0 = timespec_to_utility_time_dyn(&t_now);
+  t_0 = utility_time_add_dyn_gc(t_0, to_utility_time_dyn(100, ms));
+  utility_time_set_gc_manual(t_0);
+
+  relative_time *task_period = to_utility_time_dyn(40, ms);
+  utility_time_set_gc_manual(task_period);
+
+  task *periodic_task = NULL;
+  gracious_assert(task_create("testcase_4_periodic_task_overrun_watchdog",
+                              to_utility_time_dyn(3, ms),
+                              task_period,
+                              to_utility_time_dyn(20, ms),
+                              t_0,
+                              to_utility_time_dyn(0, s),
+                              NULL, NULL,
+                              tmp_file_name,
+                              job_count + 1,
+                              1,
+                              to_utility_time_dyn(0, s),
+                              to_utility_time_dyn(0, s),
+                              overrunning_program,
+                              &program_args,
+                              &periodic_task) == 0);
+  /* END: Create periodic task with WCET < deadline < period */
+
+  /* Enable the overrun watchdog */
+  gracious_assert(task_set_overrun_watchdog(periodic_task, 0, 8, NULL, NULL)
+                  == -1);
+  gracious_assert(task_set_overrun_watchdog(periodic_task,
+                                            TASK_OVERRUN_DEADLINE
+                                            | TASK_OVERRUN_BUDGET, 8,
+                                            overrun_handler, &program_args)
+                  == 0);
+  gracious_assert(task_set_overrun_watchdog(periodic_task,
+                                            TASK_OVERRUN_DEADLINE, 8,
+                                            NULL, NULL) == -1);
+  /* END: Enable the overrun watchdog */
+
+  /* Run task until the last job is released */
+  /** The task stops after the job released after the stopping time **/
+  struct task_manager_params params = {
+    .tau = periodic_task,
+  };
+  to_timespec_gc(utility_time_add_dyn_gc(utility_time_mul_dyn(task_period,
+                                                              job_count - 2),
+                                         to_utility_time_dyn(30, ms)),
+                 &params.stopping_time);
+  to_timespec_gc(utility_time_add_dyn_gc(timespec_to_utility_time_dyn
+                                         (&params.stopping_time), t_0),
+                 &params.stopping_time);
+
+  pthread_t task_manager_tid;
+  gracious_assert(pthread_create(&task_manager_tid, NULL,
+                                 task_manager_thread, &params) == 0);
+  gracious_assert(pthread_join(task_manager_tid, NULL) == 0);
+  gracious_assert(params.exit_status == 0);
+  /* END: Run task until the last job is released */
+
+  /* Check the recorded jobs and overruns */
+  struct overrun_checker_params
+  {
+    unsigned long nth_job;
+    unsigned long nth_overrun;
+    relative_time exec_time[10];
+  } checker_params = {
+    .nth_job = 0,
+    .nth_overrun = 0,
+  };
+  int task_stats_checker(task *tau, void *args)
+  {
+    gracious_assert(task_statistics_write_count(tau) == job_count);
+    gracious_assert(task_statistics_lost_job_count(tau) == 0);
+    return 0;
+  }
+  int job_stats_checker(job_statistics *stats, void *args)
+  {
+    struct overrun_checker_params *prms = args;
+    relative_time *exec_time = &prms->exec_time[prms->nth_job++];
+    utility_time_init(exec_time);
+    utility_time_sub_gc(job_statistics_time_finish(stats),
+                        job_statistics_time_start(stats), exec_time);
+    return 0;
+  }
+  int overrun_stats_checker(task_overrun_statistics *stats, void *args)
+  {
+    struct overrun_checker_params *prms = args;
+    static const struct {
+      unsigned long job_pos;
+      enum task_overrun_kind kind;
+      enum task_overrun_action action;
+    } expected[] = {
+      {3, TASK_OVERRUN_BUDGET, TASK_OVERRUN_ABORT},
+      {6, TASK_OVERRUN_BUDGET, TASK_OVERRUN_SKIP},
+      {6, TASK_OVERRUN_DEADLINE, TASK_OVERRUN_CONTINUE},
+      {7, 0, TASK_OVERRUN_SKIPPED},
+    };
+
+    gracious_assert(prms->nth_overrun < sizeof(expected) / sizeof(*expected));
+    gracious_assert(task_overrun_statistics_job_pos(stats)
+                    == expected[prms->nth_overrun].job_pos);
+    gracious_assert(task_overrun_statistics_kind(stats)
+                    == expected[prms->nth_overrun].kind);
+    gracious_assert(task_overrun_statistics_action(stats)
+                    == expected[prms->nth_overrun].action);
+    utility_time_gc(task_overrun_statistics_time(stats));
+    prms->nth_overrun++;
+    return 0;
+  }
+
+  FILE *stats_file = utility_file_open_for_reading_bin(tmp_file_name);
+  gracious_assert(stats_file != NULL);
+  gracious_assert(task_statistics_read_ex(stats_file,
+                                          task_stats_checker, NULL,
+                                          job_stats_checker, &checker_params,
+                                          overrun_stats_checker,
+                                          &checker_params) == 0);
+  gracious_assert(checker_params.nth_job == job_count);
+  gracious_assert(checker_params.nth_overrun == 4);
+
+  /** The aborted job stops at its budget and the skipped one never runs **/
+  gracious_assert(utility_time_lt_gc_t2(&checker_params.exec_time[2],
+                                        to_utility_time_dyn(20, ms)));
+  gracious_assert(utility_time_gt_gc_t2(&checker_params.exec_time[5],
+                                        to_utility_time_dyn(29, ms)));
+  gracious_assert(utility_time_eq_gc_t2(&checker_params.exec_time[6],
+                                        to_utility_time_dyn(0, s)));
+  gracious_assert(program_args.nth_job == job_count - 1);
+
+  /** Task statistics without the callback skips the overrun records **/
+  gracious_assert(fseek(stats_file, 0, SEEK_SET) == 0);
+  checker_params.nth_job = 0;
+  gracious_assert(task_statistics_read(stats_file,
+                                       task_stats_checker, NULL,
+                                       job_stats_checker, &checker_params)
+                  == 0);
+  gracious_assert(checker_params.nth_job == job_count);
+  /* END: Check the recorded jobs and overruns */
+
+  /* Clean-up */
+  gracious_assert(utility_file_close(stats_file, tmp_file_name) == 0);
+  utility_time_gc(t_0);
+  utility_time_gc(task_period);
+  task_destroy(periodic_task);
+  /* END: Clean-up */
+}
+
+#define BLOCKING_OVERHEAD_SAMPLE_COUNT 1000
+struct blocking_program_args
+{
+  unsigned long nth_job;
+  struct timespec blocking_duration;
+  relative_time *overhead; /* The duration of all begin-end pairs. */
+};
+static void blocking_program(void *args)
+{
+  struct blocking_program_args *prms = args;
+  unsigned point;
+
+  if (prms->nth_job++ == 0) {
+    struct timespec t_begin, t_end;
+    int i;
+    gracious_assert(clock_gettime(CLOCK_MONOTONIC, &t_begin) == 0);
+    for (i = 0; i < BLOCKING_OVERHEAD_SAMPLE_COUNT; i++) {
+      task_block_begin();
+      task_block_end(100);
+    }
+    gracious_assert(clock_gettime(CLOCK_MONOTONIC, &t_end) == 0);
+    prms->overhead
+      = utility_time_sub_dyn_gc(timespec_to_utility_time_dyn(&t_end),
+                                timespec_to_utility_time_dyn(&t_begin));
+    utility_time_set_gc_manual(prms->overhead);
+  }
+
+  for (point = 0; point < 2; point++) {
+    task_block_begin();
+    gracious_assert(clock_nanosleep(CLOCK_MONOTONIC, 0,
+                                    &prms->blocking_duration, NULL) == 0);
+    task_block_end(point);
+  }
+}
+static void testcase_5_periodic_task_blocking_recorder(void)
+{
+  const unsigned long job_count = 5;
+  const unsigned long slot_count = 4;
+
+  struct blocking_program_args program_args = {
+    .nth_job = 0,
+    .overhead = NULL,
+  };
+  to_timespec_gc(to_utility_time_dyn(1, ms), &program_args.blocking_duration);
+
+  /* Blocking outside a task is not recorded */
+  task_block_begin();
+  task_block_end(0);
+
+  /* Create periodic task */
+  struct timespec t_now;
+  gracious_assert(clock_gettime(CLOCK_MONOTONIC, &t_now) == 0);
+
+  absolute_time *t_0 = timespec_to_utility_time_dyn(&t_now);
+  t_0 = utility_time_add_dyn_gc(t_0, to_utility_time_dyn(100, ms));
+  utility_time_set_gc_manual(t_0);
+
+  relative_time *task_period = to_utility_time_dyn(40, ms);
+  utility_time_set_gc_manual(task_period);
+
+  task *periodic_task = NULL;
+  gracious_assert(task_create("testcase_5_periodic_task_blocking_recorder",
+                              to_utility_time_dyn(10, ms),
+                              task_period,
+                              to_utility_time_dyn(20, ms),
+                              t_0,
+                              to_utility_time_dyn(0, s),
+                              NULL, NULL,
+                              tmp_file_name,
+                              job_count + 1,
+                              1,
+                              to_utility_time_dyn(0, s),
+                              to_utility_time_dyn(0, s),
+                              blocking_program,
+                              &program_args,
+                              &periodic_task) == 0);
+  /* END: Create periodic task */
+
+  /* Enable the blocking recorder */
+  gracious_assert(task_set_blocking_recorder(periodic_task, 0) == -1);
+  gracious_assert(task_set_blocking_recorder(periodic_task, slot_count) == 0);
+  gracious_assert(task_set_blocking_recorder(periodic_task, slot_count) == -1);
+  /* END: Enable the blocking recorder */
+
+  /* Run task until the last job is released */
+  struct task_manager_params params = {
+    .tau = periodic_task,
+  };
+  to_timespec_gc(utility_time_add_dyn_gc(utility_time_mul_dyn(task_period,
+                                                              job_count - 2),
+                                         to_utility_time_dyn(30, ms)),
+                 &params.stopping_time);
+  to_timespec_gc(utility_time_add_dyn_gc(timespec_to_utility_time_dyn
+                                         (&params.stopping_time), t_0),
+                 &params.stopping_time);
+
+  pthread_t task_manager_tid;
+  gracious_assert(pthread_create(&task_manager_tid, NULL,
+                                 task_manager_thread, &params) == 0);
+  gracious_assert(pthread_join(task_manager_tid, NULL) == 0);
+  gracious_assert(params.exit_status == 0);
+  /* END: Run task until the last job is released */
+
+  /* Check the recorded blocking of the last two jobs */
+  struct blocking_checker_params
+  {
+    unsigned long nth_job;
+    unsigned long nth_record;
+  } checker_params = {
+    .nth_job = 0,
+    .nth_record = 0,
+  };
+  int task_stats_checker(task *tau, void *args)
+  {
+    gracious_assert(task_statistics_write_count(tau) == job_count);
+    return 0;
+  }
+  int job_stats_checker(job_statistics *stats, void *args)
+  {
+    struct blocking_checker_params *prms = args;
+    utility_time_gc(job_statistics_time_start(stats));
+    utility_time_gc(job_statistics_time_finish(stats));
+    prms->nth_job++;
+    return 0;
+  }
+  int blocking_stats_checker(task_blocking_statistics *stats, void *args)
+  {
+    struct blocking_checker_params *prms = args;
+    int point = prms->nth_record % 2;
+
+    gracious_assert(prms->nth_record < slot_count);
+    gracious_assert(task_blocking_statistics_job_pos(stats)
+                    == job_count - 1 + prms->nth_record / 2);
+    gracious_assert(task_blocking_statistics_point(stats) == point);
+    gracious_assert(utility_time_ge_gc
+                    (utility_time_sub_dyn_gc
+                     (task_blocking_statistics_time_end(stats),
+                      task_blocking_statistics_time_begin(stats)),
+                     to_utility_time_dyn(1, ms)));
+    prms->nth_record++;
+    return 0;
+  }
+
+  FILE *stats_file = utility_file_open_for_reading_bin(tmp_file_name);
+  gracious_assert(stats_file != NULL);
+  unsigned long lost_blocking_count;
+  const struct task_statistics_callbacks callbacks = {
+    .task_statistics_fn = task_stats_checker,
+    .job_statistics_fn = job_stats_checker,
+    .job_statistics_fn_args = &checker_params,
+    .blocking_statistics_fn = blocking_stats_checker,
+    .blocking_statistics_fn_args = &checker_params,
+    .lost_blocking_count = &lost_blocking_count,
+  };
+  gracious_assert(task_statistics_read_full(stats_file, &callbacks) == 0);
+  gracious_assert(checker_params.nth_job == job_count);
+  gracious_assert(checker_params.nth_record == slot_count);
+  gracious_assert(lost_blocking_count
+                  == BLOCKING_OVERHEAD_SAMPLE_COUNT + 2 * job_count
+                  - slot_count);
+
+  /** The overhead is small enough to leave the instrumentation enabled **/
+  log_verbose_utility_time(program_args.overhead,
+                           "Overhead of 1000 blocking begin-end pairs");
+  gracious_assert(utility_time_lt_gc_t2(program_args.overhead,
+                                        utility_time_mul_dyn_gc
+                                        (to_utility_time_dyn(5, us),
+                                         BLOCKING_OVERHEAD_SAMPLE_COUNT)));
+
+  /** Task statistics without the callback skips the blocking records **/
+  gracious_assert(fseek(stats_file, 0, SEEK_SET) == 0);
+  checker_params.nth_job = 0;
+  gracious_assert(task_statistics_read(stats_file,
+                                       task_stats_checker, NULL,
+                                       job_stats_checker, &checker_params)
+                  == 0);
+  gracious_assert(checker_params.nth_job == job_count);
+  /* END: Check the recorded blocking of the last two jobs */
+
+  /* Clean-up */
+  gracious_assert(utility_file_close(stats_file, tmp_file_name) == 0);
+  utility_time_gc(program_args.overhead);
+  utility_time_gc(t_0);
+  utility_time_gc(task_period);
+  task_destroy(periodic_task);
+  /* END: Clean-up */
+}
+#undef BLOCKING_OVERHEAD_SAMPLE_COUNT
+
+static void sleeping_program(void *args)
+{
+  gracious_assert(clock_nanosleep(CLOCK_MONOTONIC, 0, args, NULL) == 0);
+}
+static void testcase_6_periodic_task_cpu_statistics(void)
+{
+  const unsigned long job_count = 5;
+  const unsigned long slot_count = 3;
+
+  struct timespec sleeping_duration;
+  to_timespec_gc(to_utility_time_dyn(1, ms), &sleeping_duration);
+
+  /* Create periodic task */
+  struct timespec t_now;
+  gracious_assert(clock_gettime(CLOCK_MONOTONIC, &t_now) == 0);
+
+  absolute_time *t_0 = timespec_to_utility_time_dyn(&t_now);
+  t_0 = utility_time_add_dyn_gc(t_0, to_utility_time_dyn(100, ms));
+  utility_time_set_gc_manual(t_0);
+
+  relative_time *task_period = to_utility_time_dyn(40, ms);
+  utility_time_set_gc_manual(task_period);
+
+  relative_time *job_overhead;
+  gracious_assert(job_statistics_overhead_ex(0, 1, &job_overhead) == 0);
+  utility_time_set_gc_manual(job_overhead);
+  log_verbose_utility_time(job_overhead,
+                           "Job statistics overhead with CPU statistics");
+
+  task *periodic_task = NULL;
+  gracious_assert(task_create("testcase_6_periodic_task_cpu_statistics",
+                              to_utility_time_dyn(10, ms),
+                              task_period,
+                              to_utility_time_dyn(20, ms),
+                              t_0,
+                              to_utility_time_dyn(0, s),
+                              NULL, NULL,
+                              tmp_file_name,
+                              slot_count,
+                              4,
+                              job_overhead,
+                              to_utility_time_dyn(0, s),
+                              sleeping_program,
+                              &sleeping_duration,
+                              &periodic_task) == -1);
+  gracious_assert(periodic_task == NULL);
+  gracious_assert(task_create("testcase_6_periodic_task_cpu_statistics",
+                              to_utility_time_dyn(10, ms),
+                              task_period,
+                              to_utility_time_dyn(20, ms),
+                              t_0,
+                              to_utility_time_dyn(0, s),
+                              NULL, NULL,
+                              tmp_file_name,
+                              slot_count,
+                              TASK_RINGBUF_RECORD_CPU,
+                              job_overhead,
+                              to_utility_time_dyn(0, s),
+                              sleeping_program,
+                              &sleeping_duration,
+                              &periodic_task) == 0);
+  /* END: Create periodic task */
+
+  /* Run task until the last job is released */
+  struct task_manager_params params = {
+    .tau = periodic_task,
+  };
+  to_timespec_gc(utility_time_add_dyn_gc(utility_time_mul_dyn(task_period,
+                                                              job_count - 2),
+                                         to_utility_time_dyn(30, ms)),
+                 &params.stopping_time);
+  to_timespec_gc(utility_time_add_dyn_gc(timespec_to_utility_time_dyn
+                                         (&params.stopping_time), t_0),
+                 &params.stopping_time);
+
+  pthread_t task_manager_tid;
+  gracious_assert(pthread_create(&task_manager_tid, NULL,
+                                 task_manager_thread, &params) == 0);
+  gracious_assert(pthread_join(task_manager_tid, NULL) == 0);
+  gracious_assert(params.exit_status == 0);
+  /* END: Run task until the last job is released */
+
+  /* Check the CPU statistics of the jobs kept in the ring buffer */
+  struct cpu_checker_params
+  {
+    unsigned long nth_job;
+    unsigned long nth_record;
+  } checker_params = {
+    .nth_job = 0,
+    .nth_record = 0,
+  };
+  int task_stats_checker(task *tau, void *args)
+  {
+    gracious_assert(task_statistics_write_count(tau) == job_count);
+    gracious_assert(task_statistics_oldest_job_pos(tau)
+                    == job_count - slot_count + 1);
+    return 0;
+  }
+  int job_stats_checker(job_statistics *stats, void *args)
+  {
+    struct cpu_checker_params *prms = args;
+    utility_time_gc(job_statistics_time_start(stats));
+    utility_time_gc(job_statistics_time_finish(stats));
+    prms->nth_job++;
+    return 0;
+  }
+  int cpu_stats_checker(job_cpu_statistics *stats, void *args)
+  {
+    struct cpu_checker_params *prms = args;
+
+    gracious_assert(prms->nth_record < prms->nth_job);
+    gracious_assert(job_cpu_statistics_cpu_begin(stats) == 0);
+    gracious_assert(job_cpu_statistics_cpu_end(stats) == 0);
+    gracious_assert(job_cpu_statistics_voluntary_switches(stats) >= 1);
+    prms->nth_record++;
+    return 0;
+  }
+
+  FILE *stats_file = utility_file_open_for_reading_bin(tmp_file_name);
+  gracious_assert(stats_file != NULL);
+  const struct task_statistics_callbacks callbacks = {
+    .task_statistics_fn = task_stats_checker,
+    .job_statistics_fn = job_stats_checker,
+    .job_statistics_fn_args = &checker_params,
+    .job_cpu_statistics_fn = cpu_stats_checker,
+    .job_cpu_statistics_fn_args = &checker_params,
+  };
+  gracious_assert(task_statistics_read_full(stats_file, &callbacks) == 0);
+  gracious_assert(checker_params.nth_job == slot_count);
+  gracious_assert(checker_params.nth_record == slot_count);
+
+  /** Task statistics without the callback skips the CPU records **/
+  gracious_assert(fseek(stats_file, 0, SEEK_SET) == 0);
+  checker_params.nth_job = 0;
+  gracious_assert(task_statistics_read(stats_file,
+                                       task_stats_checker, NULL,
+                                       job_stats_checker, &checker_params)
+                  == 0);
+  gracious_assert(checker_params.nth_job == slot_count);
+  /* END: Check the CPU statistics of the jobs kept in the ring buffer */
+
+  /* Clean-up */
+  gracious_assert(utility_file_close(stats_file, tmp_file_name) == 0);
+  utility_time_gc(t_0);
+  utility_time_gc(task_period);
+  utility_time_gc(job_overhead);
+  task_destroy(periodic_task);
+  /* END: Clean-up */
+}
+
+static void testcase_7_periodic_task_mode_change(void)
+{
+  /* The releases relative to t_0 when the period is changed from 40
+     ms to 20 ms after the first job boundary following 50 ms and back
+     to 40 ms after the first job boundary following 150 ms */
+  static const unsigned release_ms[] = {0, 40, 80, 120, 140, 160, 180, 220,
+                                        260};
+  const unsigned long job_count = sizeof(release_ms) / sizeof(*release_ms);
+
+  struct timespec sleeping_duration;
+  to_timespec_gc(to_utility_time_dyn(1, ms), &sleeping_duration);
+
+  /* Create periodic task */
+  struct timespec t_now;
+  gracious_assert(clock_gettime(CLOCK_MONOTONIC, &t_now) == 0);
+
+  absolute_time *t_0 = timespec_to_utility_time_dyn(&t_now);
+  t_0 = utility_time_add_dyn_gc(t_0, to_utility_time_dyn(100, ms));
+  utility_time_set_gc_manual(t_0);
+
+  task *periodic_task = NULL;
+  gracious_assert(task_create("testcase_7_periodic_task_mode_change",
+                              to_utility_time_dyn(10, ms),
+                              to_utility_time_dyn(40, ms),
+                              to_utility_time_dyn(20, ms),
+                              t_0,
+                              to_utility_time_dyn(0, s),
+                              NULL, NULL,
+                              tmp_file_name,
+                              job_count,
+                              1,
+                              to_utility_time_dyn(0, s),
+                              to_utility_time_dyn(0, s),
+                              sleeping_program,
+                              &sleeping_duration,
+                              &periodic_task) == 0);
+  /* END: Create periodic task */
+
+  /* Enable the mode changes */
+  gracious_assert(task_change_mode(periodic_task,
+                                   to_utility_time_dyn(5, ms),
+                                   to_utility_time_dyn(20, ms),
+                                   to_utility_time_dyn(10, ms)) == -1);
+  gracious_assert(task_set_mode_change(periodic_task, 0) == -1);
+  gracious_assert(task_set_mode_change(periodic_task, 2) == 0);
+  gracious_assert(task_set_mode_change(periodic_task, 2) == -1);
+  /* END: Enable the mode changes */
+
+  /* Run task while changing its mode twice */
+  struct mode_change mode_changes[] = {
+    {.wcet_ms = 5, .period_ms = 20, .deadline_ms = 10},
+    {.wcet_ms = 10, .period_ms = 40, .deadline_ms = 20},
+  };
+  to_timespec_gc(utility_time_add_dyn_gc(to_utility_time_dyn(50, ms), t_0),
+                 &mode_changes[0].t_request);
+  to_timespec_gc(utility_time_add_dyn_gc(to_utility_time_dyn(150, ms), t_0),
+                 &mode_changes[1].t_request);
+
+  struct task_manager_params params = {
+    .tau = periodic_task,
+    .mode_changes = mode_changes,
+    .mode_change_count = sizeof(mode_changes) / sizeof(*mode_changes),
+  };
+  to_timespec_gc(utility_time_add_dyn_gc(to_utility_time_dyn(230, ms), t_0),
+                 &params.stopping_time);
+
+  pthread_t task_manager_tid;
+  gracious_assert(pthread_create(&task_manager_tid, NULL,
+                                 task_manager_thread, &params) == 0);
+  gracious_assert(pthread_join(task_manager_tid, NULL) == 0);
+  gracious_assert(params.exit_status == 0);
+  /* END: Run task while changing its mode twice */
+
+  /* Check the releases of the jobs and the mode change records */
+  struct mode_checker_params
+  {
+    unsigned long nth_job;
+    unsigned long nth_record;
+    const unsigned *release_ms;
+    absolute_time *t_0;
+    const struct mode_change *mode_changes;
+  } checker_params = {
+    .nth_job = 0,
+    .nth_record = 0,
+    .release_ms = release_ms,
+    .t_0 = t_0,
+    .mode_changes = mode_changes,
+  };
+  int task_stats_checker(task *tau, void *args)
+  {
+    gracious_assert(task_statistics_write_count(tau) == job_count);
+    gracious_assert(utility_time_eq_gc(task_statistics_period(tau),
+                                       to_utility_time_dyn(40, ms)));
+    return 0;
+  }
+  int job_stats_checker(job_statistics *stats, void *args)
+  {
+    struct mode_checker_params *prms = args;
+    absolute_time *t_release
+      = utility_time_add_dyn_gc(to_utility_time_dyn(prms->release_ms
+                                                    [prms->nth_job], ms),
+                                prms->t_0);
+    utility_time_set_gc_manual(t_release);
+
+    gracious_assert(utility_time_le_gc(t_release,
+                                       job_statistics_time_start(stats)));
+    gracious_assert(utility_time_lt_gc(job_statistics_time_start(stats),
+                                       utility_time_add_dyn_gc
+                                       (t_release,
+                                        to_utility_time_dyn(10, ms))));
+    utility_time_gc(job_statistics_time_finish(stats));
+    utility_time_gc(t_release);
+    prms->nth_job++;
+    return 0;
+  }
+  int mode_stats_checker(task_mode_statistics *stats, void *args)
+  {
+    struct mode_checker_params *prms = args;
+    const struct mode_change *change = &prms->mode_changes[prms->nth_record];
+    const unsigned long first_job_pos = (prms->nth_record == 0 ? 4 : 7);
+    absolute_time *t_request
+      = timespec_to_utility_time_dyn(&change->t_request);
+    utility_time_set_gc_manual(t_request);
+
+    gracious_assert(task_mode_statistics_job_pos(stats) == first_job_pos);
+    gracious_assert(task_mode_statistics_status(stats) == TASK_MODE_APPLIED);
+    gracious_assert(utility_time_le_gc_t2
+                    (t_request, task_mode_statistics_time_request(stats)));
+    gracious_assert(utility_time_le_gc
+                    (task_mode_statistics_time_request(stats),
+                     task_mode_statistics_time_apply(stats)));
+
+    /** The mode is applied once the job released next has finished **/
+    gracious_assert(utility_time_le_gc
+                    (utility_time_add_dyn_gc
+                     (to_utility_time_dyn(prms->release_ms[first_job_pos - 2],
+                                          ms),
+                      prms->t_0),
+                     task_mode_statistics_time_apply(stats)));
+    gracious_assert(utility_time_eq_gc
+                    (task_mode_statistics_time_release(stats),
+                     utility_time_add_dyn_gc
+                     (to_utility_time_dyn(prms->release_ms[first_job_pos - 1],
+                                          ms),
+                      prms->t_0)));
+
+    gracious_assert(utility_time_eq_gc(task_mode_statistics_wcet(stats),
+                                       to_utility_time_dyn(change->wcet_ms,
+                                                           ms)));
+    gracious_assert(utility_time_eq_gc(task_mode_statistics_period(stats),
+                                       to_utility_time_dyn(change->period_ms,
+                                                           ms)));
+    gracious_assert(utility_time_eq_gc(task_mode_statistics_deadline(stats),
+                                       to_utility_time_dyn(change->deadline_ms,
+                                                           ms)));
+    utility_time_gc(t_request);
+    prms->nth_record++;
+    return 0;
+  }
+
+  FILE *stats_file = utility_file_open_for_reading_bin(tmp_file_name);
+  gracious_assert(stats_file != NULL);
+  const struct task_statistics_callbacks callbacks = {
+    .task_statistics_fn = task_stats_checker,
+    .job_statistics_fn = job_stats_checker,
+    .job_statistics_fn_args = &checker_params,
+    .mode_statistics_fn = mode_stats_checker,
+    .mode_statistics_fn_args = &checker_params,
+  };
+  gracious_assert(task_statistics_read_full(stats_file, &callbacks) == 0);
+  gracious_assert(checker_params.nth_job == job_count);
+  gracious_assert(checker_params.nth_record == 2);
+
+  /** Task statistics without the callback skips the mode records **/
+  gracious_assert(fseek(stats_file, 0, SEEK_SET) == 0);
+  checker_params.nth_job = 0;
+  gracious_assert(task_statistics_read(stats_file,
+                                       task_stats_checker, NULL,
+                                       job_stats_checker, &checker_params)
+                  == 0);
+  gracious_assert(checker_params.nth_job == job_count);
+  /* END: Check the releases of the jobs and the mode change records */
+
+  /* Clean-up */
+  gracious_assert(utility_file_close(stats_file, tmp_file_name) == 0);
+  utility_time_gc(t_0);
+  task_destroy(periodic_task);
+  /* END: Clean-up */
+}
+
+struct stop_fd_release_args
+{
+  task *tau;
+  int timeout_ms; /* The interarrival time of the aperiodic events. */
+};
+static int stop_fd_release(void *args)
+{
+  struct stop_fd_release_args *prms = args;
+  struct pollfd stop_fd = {
+    .fd = task_stop_fd(prms->tau),
+    .events = POLLIN,
+  };
+
+  gracious_assert(poll(&stop_fd, 1, prms->timeout_ms) != -1);
+  return 0;
+}
+static void testcase_8_task_fast_stop(void)
+{
+  const unsigned long job_count = 4;
+
+  struct timespec sleeping_duration;
+  to_timespec_gc(to_utility_time_dyn(1, ms), &sleeping_duration);
+
+  int task_stats_checker(task *tau, void *args)
+  {
+    *((unsigned long *) args) = task_statistics_write_count(tau);
+    return 0;
+  }
+  int job_stats_checker(job_statistics *stats, void *args)
+  {
+    utility_time_gc(job_statistics_time_start(stats));
+    utility_time_gc(job_statistics_time_finish(stats));
+    return 0;
+  }
+  unsigned long read_write_count(void)
+  {
+    unsigned long write_count;
+    FILE *stats_file = utility_file_open_for_reading_bin(tmp_file_name);
+    gracious_assert(stats_file != NULL);
+    gracious_assert(task_statistics_read(stats_file,
+                                         task_stats_checker, &write_count,
+                                         job_stats_checker, NULL) == 0);
+    gracious_assert(utility_file_close(stats_file, tmp_file_name) == 0);
+    return write_count;
+  }
+
+  /* Create periodic task */
+  struct timespec t_now;
+  gracious_assert(clock_gettime(CLOCK_MONOTONIC, &t_now) == 0);
+
+  absolute_time *t_0 = timespec_to_utility_time_dyn(&t_now);
+  t_0 = utility_time_add_dyn_gc(t_0, to_utility_time_dyn(100, ms));
+  utility_time_set_gc_manual(t_0);
+
+  relative_time *task_period = to_utility_time_dyn(40, ms);
+  utility_time_set_gc_manual(task_period);
+
+  task *periodic_task = NULL;
+  gracious_assert(task_create("testcase_8_task_fast_stop",
+                              to_utility_time_dyn(10, ms),
+                              task_period,
+                              to_utility_time_dyn(20, ms),
+                              t_0,
+                              to_utility_time_dyn(0, s),
+                              NULL, NULL,
+                              tmp_file_name,
+                              job_count + 1,
+                              1,
+                              to_utility_time_dyn(0, s),
+                              to_utility_time_dyn(0, s),
+                              sleeping_program,
+                              &sleeping_duration,
+                              &periodic_task) == 0);
+  gracious_assert(task_stop_fd(periodic_task) == -1);
+  gracious_assert(task_set_fast_stop(periodic_task) == 0);
+  gracious_assert(task_set_fast_stop(periodic_task) == -1);
+  gracious_assert(task_stop_fd(periodic_task) != -1);
+  gracious_assert(task_stop_latency(periodic_task) == NULL);
+  /* END: Create periodic task */
+
+  /* Stop the task midway between two releases */
+  struct task_manager_params params = {
+    .tau = periodic_task,
+  };
+  to_timespec_gc(utility_time_add_dyn_gc(utility_time_mul_dyn(task_period,
+                                                              job_count - 1),
+                                         to_utility_time_dyn(20, ms)),
+                 &params.stopping_time);
+  to_timespec_gc(utility_time_add_dyn_gc(timespec_to_utility_time_dyn
+                                         (&params.stopping_time), t_0),
+                 &params.stopping_time);
+
+  pthread_t task_manager_tid;
+  gracious_assert(pthread_create(&task_manager_tid, NULL,
+                                 task_manager_thread, &params) == 0);
+  gracious_assert(pthread_join(task_manager_tid, NULL) == 0);
+  gracious_assert(params.exit_status == 0);
+  /* END: Stop the task midway between two releases */
+
+  /* The next job is not released and the task stops immediately */
+  gracious_assert(read_write_count() == job_count);
+
+  relative_time *latency = task_stop_latency(periodic_task);
+  gracious_assert(latency != NULL);
+  log_verbose_utility_time(latency, "Periodic task stop latency");
+  gracious_assert(utility_time_lt_gc(latency, to_utility_time_dyn(5, ms)));
+  /* END: The next job is not released and the task stops immediately */
+
+  task_destroy(periodic_task);
+
+  /* Create aperiodic task */
+  struct stop_fd_release_args release_args = {
+    .timeout_ms = 30,
+  };
+
+  task *aperiodic_task = NULL;
+  gracious_assert(task_create("testcase_8_task_fast_stop",
+                              to_utility_time_dyn(10, ms),
+                              to_utility_time_dyn(30, ms),
+                              to_utility_time_dyn(20, ms),
+                              to_utility_time_dyn(0, s),
+                              to_utility_time_dyn(0, s),
+                              stop_fd_release, &release_args,
+                              tmp_file_name,
+                              job_count + 1,
+                              1,
+                              to_utility_time_dyn(0, s),
+                              to_utility_time_dyn(0, s),
+                              sleeping_program,
+                              &sleeping_duration,
+                              &aperiodic_task) == 0);
+  gracious_assert(task_set_fast_stop(aperiodic_task) == 0);
+  release_args.tau = aperiodic_task;
+  /* END: Create aperiodic task */
+
+  /* Stop the task while it waits for the next aperiodic event */
+  params.tau = aperiodic_task;
+  gracious_assert(clock_gettime(CLOCK_MONOTONIC, &t_now) == 0);
+  to_timespec_gc(utility_time_add_dyn_gc(timespec_to_utility_time_dyn(&t_now),
+                                         to_utility_time_dyn
+                                         (release_args.timeout_ms
+                                          * (job_count - 1) + 15, ms)),
+                 &params.stopping_time);
+
+  gracious_assert(pthread_create(&task_manager_tid, NULL,
+                                 task_manager_thread, &params) == 0);
+  gracious_assert(pthread_join(task_manager_tid, NULL) == 0);
+  gracious_assert(params.exit_status == 0);
+  /* END: Stop the task while it waits for the next aperiodic event */
+
+  /* The task is not cancelled and the task statistics are written */
+  gracious_assert(read_write_count() == job_count - 1);
+
+  latency = task_stop_latency(aperiodic_task);
+  gracious_assert(latency != NULL);
+  log_verbose_utility_time(latency, "Aperiodic task stop latency");
+  gracious_assert(utility_time_lt_gc(latency, to_utility_time_dyn(5, ms)));
+  /* END: The task is not cancelled and the task statistics are written */
+
+  /* Clean-up */
+  utility_time_gc(t_0);
+  utility_time_gc(task_period);
+  task_destroy(aperiodic_task);
+  /* END: Clean-up */
+}
+
+static void testcase_9_task_release_sources(void)
+{
+  const unsigned long job_count = 3;
+
+  struct timespec sleeping_duration;
+  to_timespec_gc(to_utility_time_dyn(1, ms), &sleeping_duration);
+
+  int task_stats_checker(task *tau, void *args)
+  {
+    *((unsigned long *) args) = task_statistics_write_count(tau);
+    return 0;
+  }
+  int job_stats_checker(job_statistics *stats, void *args)
+  {
+    utility_time_gc(job_statistics_time_start(stats));
+    utility_time_gc(job_statistics_time_finish(stats));
+    return 0;
+  }
+
+  /* Create aperiodic task released by an eventfd */
+  int event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  gracious_assert(event_fd != -1);
+
+  release_sources *sources = NULL;
+  gracious_assert(release_sources_create(to_utility_time_dyn(10, ms),
+                                         &sources) == 0);
+  gracious_assert(release_sources_add(sources, event_fd,
+                                      RELEASE_SOURCE_COUNTER) == 0);
+
+  task *aperiodic_task = NULL;
+  gracious_assert(task_create("testcase_9_task_release_sources",
+                              to_utility_time_dyn(5, ms),
+                              to_utility_time_dyn(10, ms),
+                              to_utility_time_dyn(10, ms),
+                              to_utility_time_dyn(0, s),
+                              to_utility_time_dyn(0, s),
+                              release_sources_wait, sources,
+                              tmp_file_name,
+                              job_count + 1,
+                              1,
+                              to_utility_time_dyn(0, s),
+                              to_utility_time_dyn(0, s),
+                              sleeping_program,
+                              &sleeping_duration,
+                              &aperiodic_task) == 0);
+  gracious_assert(task_set_fast_stop(aperiodic_task) == 0);
+  gracious_assert(release_sources_add(sources, task_stop_fd(aperiodic_task),
+                                      RELEASE_SOURCE_STOP) == 0);
+  /* END: Create aperiodic task released by an eventfd */
+
+  /* Release the jobs at once and stop the task after they complete */
+  uint64_t event_count = job_count;
+  gracious_assert(write(event_fd, &event_count, sizeof(event_count))
+                  == sizeof(event_count));
+
+  struct task_manager_params params = {
+    .tau = aperiodic_task,
+  };
+  struct timespec t_now;
+  gracious_assert(clock_gettime(CLOCK_MONOTONIC, &t_now) == 0);
+  to_timespec_gc(utility_time_add_dyn_gc(timespec_to_utility_time_dyn(&t_now),
+                                         to_utility_time_dyn(100, ms)),
+                 &params.stopping_time);
+
+  pthread_t task_manager_tid;
+  gracious_assert(pthread_create(&task_manager_tid, NULL,
+                                 task_manager_thread, &params) == 0);
+  gracious_assert(pthread_join(task_manager_tid, NULL) == 0);
+  gracious_assert(params.exit_status == 0);
+  /* END: Release the jobs at once and stop the task after they complete */
+
+  /* The releases are spaced and the stop source ends the task */
+  unsigned long write_count;
+  FILE *stats_file = utility_file_open_for_reading_bin(tmp_file_name);
+  gracious_assert(stats_file != NULL);
+  gracious_assert(task_statistics_read(stats_file,
+                                       task_stats_checker, &write_count,
+                                       job_stats_checker, NULL) == 0);
+  gracious_assert(utility_file_close(stats_file, tmp_file_name) == 0);
+  gracious_assert(write_count == job_count);
+  gracious_assert(release_sources_deferred_count(sources) == job_count - 1);
+  gracious_assert(release_sources_last(sources) == 1);
+
+  relative_time *latency = task_stop_latency(aperiodic_task);
+  gracious_assert(latency != NULL);
+  log_verbose_utility_time(latency, "Aperiodic task stop latency");
+  gracious_assert(utility_time_lt_gc(latency, to_utility_time_dyn(5, ms)));
+  /* END: The releases are spaced and the stop source ends the task */
+
+  task_destroy(aperiodic_task);
+  release_sources_destroy(sources);
+
+  /* Create aperiodic task released by a pipe without fast stop */
+  int pipe_fd[2];
+  gracious_assert(pipe(pipe_fd) == 0);
+
+  gracious_assert(release_sources_create(NULL, &sources) == 0);
+  gracious_assert(release_sources_add(sources, pipe_fd[0],
+                                      RELEASE_SOURCE_READABLE) == 0);
+
+  gracious_assert(task_create("testcase_9_task_release_sources",
+                              to_utility_time_dyn(5, ms),
+                              to_utility_time_dyn(10, ms),
+                              to_utility_time_dyn(10, ms),
+                              to_utility_time_dyn(0, s),
+                              to_utility_time_dyn(0, s),
+                              release_sources_wait, sources,
+                              tmp_file_name,
+                              job_count + 1,
+                              1,
+                              to_utility_time_dyn(0, s),
+                              to_utility_time_dyn(0, s),
+                              sleeping_program,
+                              &sleeping_duration,
+                              &aperiodic_task) == 0);
+  /* END: Create aperiodic task released by a pipe without fast stop */
+
+  /* Close the pipe while the task waits for its first release */
+  struct task_params tau_params = {
+    .tau = aperiodic_task,
+  };
+  pthread_t task_thread_tid;
+  gracious_assert(pthread_create(&task_thread_tid, NULL, task_thread,
+                                 &tau_params) == 0);
+  gracious_assert(usleep(20000) == 0);
+  gracious_assert(close(pipe_fd[1]) == 0);
+  gracious_assert(pthread_join(task_thread_tid, NULL) == 0);
+  gracious_assert(tau_params.exit_status == 0);
+  /* END: Close the pipe while the task waits for its first release */
+
+  /* The task ends by itself without releasing any job */
+  stats_file = utility_file_open_for_reading_bin(tmp_file_name);
+  gracious_assert(stats_file != NULL);
+  gracious_assert(task_statistics_read(stats_file,
+                                       task_stats_checker, &write_count,
+                                       job_stats_checker, NULL) == 0);
+  gracious_assert(utility_file_close(stats_file, tmp_file_name) == 0);
+  gracious_assert(write_count == 0);
+  gracious_assert(release_sources_last(sources) == -1);
+  /* END: The task ends by itself without releasing any job */
+
+  /* Clean-up */
+  task_destroy(aperiodic_task);
+  release_sources_destroy(sources);
+  close(pipe_fd[0]);
+  close(event_fd);
+  /* END: Clean-up */
+}
+
 static relative_time *job_stats_overhead(void)
 {
   relative_time *job_stats_overhead;
@@ -864,6 +1950,141 @@ static relative_time *job_stats_overhead(void)
   return job_stats_overhead;
 }
 
+static void testcase_10_periodic_task_late_release(void)
+{
+  const unsigned long job_count = 3;
+
+  struct overrunning_program_args program_args = {
+    .nth_job = 0,
+    .overrunning_job_1 = 1,
+    .overrunning_job_2 = 0,
+  };
+  to_timespec_gc(to_utility_time_dyn(2, ms), &program_args.normal_duration);
+  to_timespec_gc(to_utility_time_dyn(2, ms),
+                 &program_args.overrunning_duration);
+
+  /* Create periodic task whose first job is released past its deadline */
+  struct timespec t_now;
+  gracious_assert(clock_gettime(CLOCK_MONOTONIC, &t_now) == 0);
+
+  absolute_time *t_0 = timespec_to_utility_time_dyn(&t_now);
+  t_0 = utility_time_sub_dyn_gc(t_0, to_utility_time_dyn(50, ms));
+  utility_time_set_gc_manual(t_0);
+
+  relative_time *task_period = to_utility_time_dyn(40, ms);
+  utility_time_set_gc_manual(task_period);
+
+  task *periodic_task = NULL;
+  gracious_assert(task_create("testcase_10_periodic_task_late_release",
+                              to_utility_time_dyn(3, ms),
+                              task_period,
+                              to_utility_time_dyn(20, ms),
+                              t_0,
+                              to_utility_time_dyn(0, s),
+                              NULL, NULL,
+                              tmp_file_name,
+                              job_count + 1,
+                              1,
+                              to_utility_time_dyn(0, s),
+                              to_utility_time_dyn(0, s),
+                              overrunning_program,
+                              &program_args,
+                              &periodic_task) == 0);
+  gracious_assert(task_set_overrun_watchdog(periodic_task,
+                                            TASK_OVERRUN_DEADLINE, 8,
+                                            overrun_handler, &program_args)
+                  == 0);
+  /* END: Create periodic task whose first job is released past its deadline */
+
+  /* Run task until the last job is released */
+  struct task_manager_params params = {
+    .tau = periodic_task,
+  };
+  to_timespec_gc(utility_time_add_dyn_gc(utility_time_add_dyn(t_0,
+                                                              task_period),
+                                         to_utility_time_dyn(30, ms)),
+                 &params.stopping_time);
+
+  pthread_t task_manager_tid;
+  gracious_assert(pthread_create(&task_manager_tid, NULL,
+                                 task_manager_thread, &params) == 0);
+  gracious_assert(pthread_join(task_manager_tid, NULL) == 0);
+  gracious_assert(params.exit_status == 0);
+  /* END: Run task until the last job is released */
+
+  /* Check the recorded jobs and overruns */
+  /** The deadline timer of the first job expires as soon as it is
+      armed, and yet the overrun is neither lost nor mistaken for a
+      stray signal **/
+  struct late_release_checker_params
+  {
+    unsigned long write_count;
+    unsigned long nth_job;
+    unsigned long nth_overrun;
+    relative_time exec_time[3];
+  } checker_params = {
+    .nth_job = 0,
+    .nth_overrun = 0,
+  };
+  int task_stats_checker(task *tau, void *args)
+  {
+    struct late_release_checker_params *prms = args;
+    prms->write_count = task_statistics_write_count(tau);
+    return 0;
+  }
+  int job_stats_checker(job_statistics *stats, void *args)
+  {
+    struct late_release_checker_params *prms = args;
+    relative_time *exec_time = &prms->exec_time[prms->nth_job++];
+    utility_time_init(exec_time);
+    utility_time_sub_gc(job_statistics_time_finish(stats),
+                        job_statistics_time_start(stats), exec_time);
+    return 0;
+  }
+  int overrun_stats_checker(task_overrun_statistics *stats, void *args)
+  {
+    struct late_release_checker_params *prms = args;
+
+    gracious_assert(prms->nth_overrun == 0);
+    gracious_assert(task_overrun_statistics_job_pos(stats) == 1);
+    gracious_assert(task_overrun_statistics_kind(stats)
+                    == TASK_OVERRUN_DEADLINE);
+    gracious_assert(task_overrun_statistics_action(stats)
+                    == TASK_OVERRUN_ABORT);
+    utility_time_gc(task_overrun_statistics_time(stats));
+    prms->nth_overrun++;
+    return 0;
+  }
+
+  FILE *stats_file = utility_file_open_for_reading_bin(tmp_file_name);
+  gracious_assert(stats_file != NULL);
+  gracious_assert(task_statistics_read_ex(stats_file,
+                                          task_stats_checker, &checker_params,
+                                          job_stats_checker, &checker_params,
+                                          overrun_stats_checker,
+                                          &checker_params) == 0);
+  gracious_assert(checker_params.write_count == job_count);
+  gracious_assert(checker_params.nth_job == job_count);
+  gracious_assert(checker_params.nth_overrun == 1);
+
+  /** The late job is aborted right away while the others complete **/
+  gracious_assert(utility_time_lt_gc_t2(&checker_params.exec_time[0],
+                                        to_utility_time_dyn(1, ms)));
+  gracious_assert(utility_time_gt_gc_t2(&checker_params.exec_time[1],
+                                        to_utility_time_dyn(1, ms)));
+  gracious_assert(utility_time_gt_gc_t2(&checker_params.exec_time[2],
+                                        to_utility_time_dyn(1, ms)));
+  gracious_assert(program_args.nth_job >= job_count - 1);
+  /* END: Check the recorded jobs and overruns */
+
+  /* Clean-up */
+  gracious_assert(utility_file_close(stats_file, tmp_file_name) == 0);
+  utility_time_gc(t_0);
+  utility_time_gc(task_period);
+  task_destroy(periodic_task);
+  /* END: Clean-up */
+}
+
 MAIN_UNIT_TEST_BEGIN("task_test", "stderr", NULL, cleanup)
 {
   /* Lock memory and preallocate stack */
@@ -952,6 +2173,27 @@ MAIN_UNIT_TEST_BEGIN("task_test", "stderr", NULL, cleanup)
                                            overhead_approximation_scaling,
                                            job_overhead, sample_count, error);
 
+  /* Testcase 4: Periodic task, overrun watchdog enabled */
+  testcase_4_periodic_task_overrun_watchdog();
+
+  /* Testcase 5: Periodic task, blocking recorder enabled */
+  testcase_5_periodic_task_blocking_recorder();
+
+  /* Testcase 6: Periodic task, CPU statistics recorded */
+  testcase_6_periodic_task_cpu_statistics();
+
+  /* Testcase 7: Periodic task, mode changed while running */
+  testcase_7_periodic_task_mode_change();
+
+  /* Testcase 8: Periodic and aperiodic tasks, fast stop enabled */
+  testcase_8_task_fast_stop();
+
+  /* Testcase 9: Aperiodic tasks released by file descriptors */
+  testcase_9_task_release_sources();
+
+  /* Testcase 10: Periodic task, first job released past its deadline */
+  testcase_10_periodic_task_late_release();
+
   /* Clean-up */
   utility_time_gc(error);
   gracious_assert(utility_file_close(report, report_path) == 0);
@@ -0,0 +1,9 @@
+# The task set of the experiment component earliest_deadline_first
+# whose tasks are served by SCHED_DEADLINE. Beware that the total
+# bandwidth of 0.95 is the default SCHED_DEADLINE bandwidth limit.
+START 2s
+STOP 2405ms
+
+TASK tau_1 C=1ms T=4ms D=2ms policy=deadline
+TASK tau_2 C=2ms T=5ms D=5ms policy=deadline
+TASK tau_3 C=3ms T=10ms D=7ms policy=deadline
@@ -0,0 +1,792 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include "../utility_experimentation.h"
+#include "../task.h"
+#include "../utility_log.h"
+#include "../utility_time.h"
+#include "../utility_cpu.h"
+#include "../utility_sched_fifo.h"
+#include "../utility_sched_deadline.h"
+#include "../utility_memory.h"
+#include "../utility_lock.h"
+#include "../utility_taskset.h"
+#include "../utility_parallel.h"
+
+#define LOCK_SAMPLE_CAPACITY 4096
+#define BUSYLOOP_TOLERANCE_US 100
+#define BUSYLOOP_SEARCH_PASSES 10
+
+/* Command line args section */
+static int force = 0;
+static const char *parallel_cpu_list = NULL;
+
+static int parse_cmd_line_args(int argc, char **argv)
+{
+  int optchar;
+  opterr = 0;
+  while ((optchar = getopt(argc, argv, ":hfc:")) != -1) {
+    switch (optchar) {
+    case 'f':
+      force = 1;
+      break;
+    case 'c':
+      parallel_cpu_list = optarg;
+      break;
+    case 'h':
+      printf("Usage: %1$s [-f] TASKSET_FILE\n"
+             "   or: %1$s [-f] -c CPU_LIST TASKSET_FILE...\n"
+             "\n"
+             "This runs the task set described in TASKSET_FILE (see\n"
+             "utility_taskset.h for the format) on the experiment CPU\n"
+             "after checking its schedulability. The statistics of task\n"
+             "NAME is written to TASKSET_FILE_NAME_stats.bin where\n"
+             "TASKSET_FILE has its .ts extension, if any, removed.\n"
+             "The second form runs the given task sets concurrently, each\n"
+             "on its own CPU taken from CPU_LIST, writing the output of\n"
+             "each to TASKSET_FILE.log with its .ts extension removed.\n"
+             "\n"
+             "-f runs a task set that is not schedulable or cannot be\n"
+             "   analyzed instead of refusing to run it.\n"
+             "-c CPU_LIST enables the second form. CPU_LIST is a comma-\n"
+             "   separated list of CPUs and CPU ranges like 1,3-5.\n",
+             prog_name);
+      return -1;
+    case ':':
+      log_error("Option -%c needs an argument (-h for help)", optopt);
+      return -1;
+    case '?':
+      log_error("Unrecognized option -%c (-h for help)", optopt);
+      return -1;
+    default:
+      log_error("Unexpected return value of fn getopt");
+      return -1;
+    }
+  }
+
+  if (parallel_cpu_list == NULL && optind != argc - 1) {
+    log_error("Exactly one task set file must be given (-h for help)");
+    return -1;
+  }
+  if (parallel_cpu_list != NULL && optind == argc) {
+    log_error("-c needs at least one task set file (-h for help)");
+    return -1;
+  }
+
+  return optind;
+}
+/* END: Command line args section */
+
+/* Return the dynamically allocated path of the given task set file
+   whose .ts extension, if any, is replaced by the given suffix or
+   NULL if there is insufficient memory */
+static char *make_path(const char *taskset_path, const char *suffix)
+{
+  size_t path_len = strlen(taskset_path);
+  char *path;
+
+  if (path_len > 3 && strcmp(&taskset_path[path_len - 3], ".ts") == 0) {
+    path_len -= 3;
+  }
+  path = malloc(path_len + strlen(suffix) + 1);
+  if (path == NULL) {
+    log_error("Not enough memory to allocate a path");
+    return NULL;
+  }
+  memcpy(path, taskset_path, path_len);
+  strcpy(&path[path_len], suffix);
+
+  return path;
+}
+
+static unsigned long long to_ns(const relative_time *t)
+{
+  struct timespec t_spec;
+
+  to_timespec(t, &t_spec);
+  return t_spec.tv_sec * 1000000000ULL + t_spec.tv_nsec;
+}
+
+/* Parallel section */
+/* Reject an invalid task set file before any task set is started
+   returning 0 if successful or -1 otherwise */
+static int parallel_run_init(const char *taskset_path,
+                             struct parallel_run *run)
+{
+  taskset_desc *ts;
+
+  if (taskset_load(taskset_path, &ts) != 0) {
+    return -1;
+  }
+  if (taskset_has_cpu_binding(ts)) {
+    log_error("%s binds a task to a CPU, which conflicts with -c",
+              taskset_path);
+    taskset_destroy(ts);
+    return -1;
+  }
+
+  run->name = taskset_path;
+  run->cost = to_ns(taskset_stop(ts));
+  run->args = NULL;
+
+  taskset_destroy(ts);
+  return 0;
+}
+
+static void parallel_run_exec(const struct parallel_run *run, int cpu,
+                              int slot)
+{
+  /* Redirect the output of the task set to its own log file */
+  {
+    char *log_path = make_path(run->name, ".log");
+    if (log_path == NULL) {
+      _exit(EXIT_FAILURE);
+    }
+
+    int log_fd = open(log_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (log_fd == -1) {
+      log_syserror("Cannot open %s", log_path);
+      _exit(EXIT_FAILURE);
+    }
+    if (dup2(log_fd, STDOUT_FILENO) == -1
+        || dup2(log_fd, STDERR_FILENO) == -1) {
+      log_syserror("Cannot redirect the output to %s", log_path);
+      _exit(EXIT_FAILURE);
+    }
+    close(log_fd);
+    free(log_path);
+  }
+  /* END: Redirect the output of the task set to its own log file */
+
+  char cpu_str[16];
+  snprintf(cpu_str, sizeof(cpu_str), "%d", cpu);
+  if (setenv(EXPERIMENT_CPU_ENV, cpu_str, 1) != 0) {
+    log_syserror("Cannot set %s", EXPERIMENT_CPU_ENV);
+    _exit(EXIT_FAILURE);
+  }
+
+  char *argv[] = {
+    (char *) prog_name, "-f", (char *) run->name, NULL
+  };
+  if (!force) {
+    argv[1] = argv[2];
+    argv[2] = NULL;
+  }
+  execv("/proc/self/exe", argv);
+  log_syserror("Cannot exec");
+  _exit(EXIT_FAILURE);
+}
+
+/* Run the task sets on the CPUs longest first using list scheduling
+   like the sweep mode of bwi-client_server. Return EXIT_SUCCESS if
+   every task set runs successfully or EXIT_FAILURE otherwise. */
+static int run_parallel(int argc, char **argv)
+{
+  struct parallel_run *runs;
+  int *cpus, cpu_count;
+  int rc = EXIT_FAILURE;
+  int i;
+
+  if (parallel_parse_cpu_list(parallel_cpu_list, &cpus, &cpu_count) != 0) {
+    return EXIT_FAILURE;
+  }
+
+  runs = malloc(sizeof(*runs) * argc);
+  if (runs == NULL) {
+    log_error("Not enough memory to allocate the runs");
+    goto out;
+  }
+  for (i = 0; i < argc; i++) {
+    if (parallel_run_init(argv[i], &runs[i]) != 0) {
+      goto out;
+    }
+  }
+
+  if (parallel_schedule(runs, argc, cpus, cpu_count, parallel_run_exec,
+                        stdout) == 0) {
+    rc = EXIT_SUCCESS;
+  }
+
+ out:
+  free(runs);
+  free(cpus);
+  return rc;
+}
+/* END: Parallel section */
+
+/* Task section */
+/* A part of the program of a job */
+struct segment
+{
+  relative_time length;
+  cpu_busyloop *busyloop; /* NULL under kernel=sleep */
+  struct timespec sleep;
+  int resource; /* -1 outside any critical section */
+};
+
+struct task_run
+{
+  const struct taskset_task *desc;
+  int cpu;
+  int sched_fifo_prio;
+  unsigned segment_count;
+  struct segment segments[2 * TASKSET_CS_MAX + 1];
+  rt_lock **locks;
+  int job_failed;
+  task *tau;
+  pthread_t thread;
+  int thread_created;
+  int rc;
+};
+
+static void add_segment(struct task_run *run, const relative_time *length,
+                        int resource)
+{
+  struct segment *seg = &run->segments[run->segment_count++];
+
+  utility_time_init(&seg->length);
+  utility_time_to_utility_time(length, &seg->length);
+  seg->busyloop = NULL;
+  seg->resource = resource;
+}
+
+/* Split the program of a job into the parts outside and inside the
+   critical sections */
+static void make_segments(struct task_run *run)
+{
+  const struct taskset_task *t = run->desc;
+  relative_time cursor, gap;
+  unsigned i;
+
+  utility_time_init(&cursor);
+  utility_time_init(&gap);
+  run->segment_count = 0;
+
+  for (i = 0; i < t->cs_count; i++) {
+    utility_time_sub(&t->cs[i].start, &cursor, &gap);
+    if (utility_time_gt_gc_t2(&gap, to_utility_time_dyn(0, ns))) {
+      add_segment(run, &gap, -1);
+    }
+    add_segment(run, &t->cs[i].length, t->cs[i].resource);
+    utility_time_add(&t->cs[i].start, &t->cs[i].length, &cursor);
+  }
+
+  utility_time_sub(&t->wcet, &cursor, &gap);
+  if (utility_time_gt_gc_t2(&gap, to_utility_time_dyn(0, ns))) {
+    add_segment(run, &gap, -1);
+  }
+}
+
+/* Create the busyloops of the segments or the sleeping times under
+   kernel=sleep. The overhead is taken from the longest segment
+   outside the critical sections, if any. Return 0 if successful or -1
+   otherwise. */
+static int prepare_segments(struct task_run *run,
+                            const relative_time *overhead,
+                            const relative_time *busyloop_tolerance)
+{
+  struct segment *longest = NULL;
+  unsigned i;
+
+  make_segments(run);
+
+  if (run->desc->kernel == TASKSET_KERNEL_SLEEP) {
+    for (i = 0; i < run->segment_count; i++) {
+      to_timespec(&run->segments[i].length, &run->segments[i].sleep);
+    }
+    return 0;
+  }
+
+  for (i = 0; i < run->segment_count; i++) {
+    struct segment *seg = &run->segments[i];
+    if (longest == NULL
+        || (longest->resource != -1 && seg->resource == -1)
+        || ((longest->resource == -1) == (seg->resource == -1)
+            && utility_time_gt(&seg->length, &longest->length))) {
+      longest = seg;
+    }
+  }
+  if (utility_time_le(&longest->length, overhead)) {
+    log_error("%s C is too small", run->desc->name);
+    return -1;
+  }
+  utility_time_sub(&longest->length, overhead, &longest->length);
+
+  for (i = 0; i < run->segment_count; i++) {
+    struct segment *seg = &run->segments[i];
+    int rc = create_cpu_busyloop(run->cpu,
+                                 utility_time_to_utility_time_dyn
+                                 (&seg->length),
+                                 busyloop_tolerance, BUSYLOOP_SEARCH_PASSES,
+                                 &seg->busyloop);
+    if (rc == -2) {
+      log_error("%s segment %u is too small to create busyloop",
+                run->desc->name, i + 1);
+      return -1;
+    } else if (rc == -4) {
+      log_error("%s segment %u is too big to create busyloop",
+                run->desc->name, i + 1);
+      return -1;
+    } else if (rc != 0) {
+      log_error("Cannot create busyloop for %s", run->desc->name);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+static void destroy_segments(struct task_run *run)
+{
+  unsigned i;
+
+  for (i = 0; i < run->segment_count; i++) {
+    if (run->segments[i].busyloop != NULL) {
+      destroy_cpu_busyloop(run->segments[i].busyloop);
+    }
+  }
+}
+
+static void task_run_prog(void *args)
+{
+  struct task_run *run = args;
+  unsigned i;
+
+  for (i = 0; i < run->segment_count; i++) {
+    const struct segment *seg = &run->segments[i];
+
+    if (seg->resource != -1) {
+      task_block_begin();
+      if (rt_lock_acquire(run->locks[seg->resource]) != 0) {
+        run->job_failed = 1;
+        return;
+      }
+      task_block_end(seg->resource + 1);
+    }
+
+    if (seg->busyloop != NULL) {
+      keep_cpu_busy(seg->busyloop);
+    } else {
+      clock_nanosleep(CLOCK_MONOTONIC, 0, &seg->sleep, NULL);
+    }
+
+    if (seg->resource != -1
+        && rt_lock_release(run->locks[seg->resource]) != 0) {
+      run->job_failed = 1;
+      return;
+    }
+  }
+}
+
+static void *task_thread(void *args)
+{
+  struct task_run *run = args;
+  const struct taskset_task *t = run->desc;
+
+  if (lock_me_to_cpu(run->cpu) != 0) {
+    log_error("Task %s cannot move to CPU %d", t->name, run->cpu);
+    run->rc = -2;
+    goto out;
+  }
+
+  if (t->policy == TASKSET_POLICY_FIFO) {
+    run->rc = sched_fifo_enter(run->sched_fifo_prio, NULL);
+  } else {
+    run->rc = sched_deadline_enter_ex(&t->wcet, &t->deadline, &t->period, 0,
+                                      NULL);
+  }
+  if (run->rc != 0) {
+    log_error("Task %s cannot become %s thread", t->name,
+              t->policy == TASKSET_POLICY_FIFO
+              ? "SCHED_FIFO" : "SCHED_DEADLINE");
+    goto out;
+  }
+
+  memory_preallocate_stack(1024);
+
+  if (task_start(run->tau) != 0) {
+    log_error("Task %s does not complete successfully", t->name);
+    run->rc = -2;
+    goto out;
+  }
+
+  run->rc = (run->job_failed ? -2 : 0);
+  if (run->job_failed) {
+    log_error("Task %s fails to use its resources", t->name);
+  }
+
+ out:
+  return &run->rc;
+}
+/* END: Task section */
+
+/* Run the given task set on the given experiment CPU returning
+   EXIT_SUCCESS if successful or EXIT_FAILURE otherwise */
+static int run_taskset(const char *taskset_path, int experiment_cpu)
+{
+  taskset_desc *ts = NULL;
+  unsigned task_count = 0, resource_count = 0;
+  struct task_run *runs = NULL;
+  rt_lock **locks = NULL;
+  relative_time *job_stats_overhead = NULL;
+  relative_time *task_overhead = NULL;
+  relative_time *overhead = NULL;
+  relative_time *busyloop_tolerance = NULL;
+  int exit_code = EXIT_FAILURE;
+  char t_str[32];
+  unsigned i;
+  int rc;
+
+  if (taskset_load(taskset_path, &ts) != 0) {
+    return EXIT_FAILURE;
+  }
+  task_count = taskset_task_count(ts);
+  resource_count = taskset_resource_count(ts);
+
+  /* Check the schedulability of the task set */
+  printf("Task set %s on CPU %d\n", taskset_path, experiment_cpu);
+  switch (taskset_analyze(ts, experiment_cpu, stdout)) {
+  case 1:
+    break;
+  case 0:
+    if (!force) {
+      log_error("The task set is not schedulable (-f to run it anyway)");
+      goto error;
+    }
+    printf("The task set is not schedulable\n");
+    break;
+  case -1:
+    if (!force) {
+      log_error("The task set cannot be analyzed (-f to run it anyway)");
+      goto error;
+    }
+    printf("The task set cannot be analyzed\n");
+    break;
+  default:
+    log_error("Cannot analyze the task set");
+    goto error;
+  }
+  /* END: Check the schedulability of the task set */
+
+  runs = calloc(task_count, sizeof(*runs));
+  locks = calloc(resource_count + 1, sizeof(*locks));
+  if (runs == NULL || locks == NULL) {
+    log_error("Not enough memory to run the task set");
+    goto error;
+  }
+
+  /* Determining overheads */
+  if (job_statistics_overhead(experiment_cpu, &job_stats_overhead) != 0) {
+    log_error("Cannot obtain job statistics overhead");
+    goto error;
+  }
+  utility_time_set_gc_manual(job_stats_overhead);
+  to_string(job_stats_overhead, t_str, sizeof(t_str));
+  printf("job_stats_overhead: %s\n", t_str);
+
+  if (finish_to_start_overhead(experiment_cpu, 0, &task_overhead) != 0) {
+    log_error("Cannot obtain finish to start overhead");
+    goto error;
+  }
+  utility_time_set_gc_manual(task_overhead);
+  to_string(task_overhead, t_str, sizeof(t_str));
+  printf("     task_overhead: %s\n", t_str);
+
+  overhead = utility_time_add_dyn_gc(job_stats_overhead, task_overhead);
+  utility_time_set_gc_manual(overhead);
+  /* END: Determining overheads */
+
+  /* Create the resources */
+  for (i = 0; i < resource_count; i++) {
+    const struct taskset_resource *r = taskset_resource(ts, i);
+    int ceiling;
+
+    if (sched_fifo_prio(r->ceiling_level == 0 ? 1 : r->ceiling_level,
+                        &ceiling) != 0) {
+      log_error("Cannot determine the ceiling of %s", r->name);
+      goto error;
+    }
+    if (rt_lock_create(r->protocol, ceiling, LOCK_SAMPLE_CAPACITY, &locks[i])
+        != 0) {
+      log_error("Cannot create resource %s", r->name);
+      goto error;
+    }
+  }
+  /* END: Create the resources */
+
+  /* Create needed busyloops */
+  busyloop_tolerance = to_utility_time_dyn(BUSYLOOP_TOLERANCE_US, us);
+  utility_time_set_gc_manual(busyloop_tolerance);
+  for (i = 0; i < task_count; i++) {
+    struct task_run *run = &runs[i];
+
+    run->desc = taskset_task(ts, i);
+    run->cpu = (run->desc->cpu == -1 ? experiment_cpu : run->desc->cpu);
+    run->locks = locks;
+    if (run->desc->policy == TASKSET_POLICY_FIFO
+        && sched_fifo_prio(run->desc->prio_level, &run->sched_fifo_prio)
+        != 0) {
+      log_error("Cannot set SCHED_FIFO priority of %s", run->desc->name);
+      goto error;
+    }
+    if (prepare_segments(run, overhead, busyloop_tolerance) != 0) {
+      goto error;
+    }
+  }
+  /* END: Create needed busyloops */
+
+  /* Calculate the absolute starting & ending time */
+  struct timespec t_now;
+  if (clock_gettime(CLOCK_MONOTONIC, &t_now) != 0) {
+    log_syserror("Cannot get t_now");
+    goto error;
+  }
+
+  struct timespec t_release;
+  to_timespec_gc(utility_time_add_dyn_gc(timespec_to_utility_time_dyn(&t_now),
+                                         utility_time_to_utility_time_dyn
+                                         (taskset_start(ts))),
+                 &t_release);
+
+  struct timespec t_stop;
+  to_timespec_gc(utility_time_add_dyn_gc(timespec_to_utility_time_dyn(&t_now),
+                                         utility_time_to_utility_time_dyn
+                                         (taskset_stop(ts))),
+                 &t_stop);
+  /* END: Calculate the absolute starting & ending time */
+
+  /* Create the tasks */
+  for (i = 0; i < task_count; i++) {
+    struct task_run *run = &runs[i];
+    const struct taskset_task *t = run->desc;
+    /* Including the job that would be run by task_stop() without the
+       fast stop */
+    unsigned long slot_count = ((to_ns(taskset_stop(ts))
+                                 - to_ns(taskset_start(ts)))
+                                / to_ns(&t->period) + 2);
+    char *suffix = malloc(strlen(t->name) + sizeof("__stats.bin"));
+    char *stats_path;
+
+    if (suffix == NULL) {
+      log_error("Not enough memory to allocate a path");
+      goto error;
+    }
+    sprintf(suffix, "_%s_stats.bin", t->name);
+    stats_path = make_path(taskset_path, suffix);
+    free(suffix);
+    if (stats_path == NULL) {
+      goto error;
+    }
+
+    rc = task_create(t->name, &t->wcet, &t->period, &t->deadline,
+                     timespec_to_utility_time_dyn(&t_release), &t->offset,
+                     NULL, NULL, stats_path, slot_count, 1,
+                     job_stats_overhead, task_overhead,
+                     task_run_prog, run, &run->tau);
+    if (rc == -2) {
+      log_error("Cannot open %s", stats_path);
+      free(stats_path);
+      goto error;
+    } else if (rc != 0) {
+      log_error("Cannot create %s", t->name);
+      free(stats_path);
+      goto error;
+    }
+    free(stats_path);
+
+    if (t->cs_count > 0
+        && task_set_blocking_recorder(run->tau, slot_count) != 0) {
+      log_error("Cannot record the blocking times of %s", t->name);
+      goto error;
+    }
+
+    if (task_set_fast_stop(run->tau) != 0) {
+      log_error("Cannot enable the fast stop of %s", t->name);
+      goto error;
+    }
+  }
+  /* END: Create the tasks */
+
+  /* Be task manager */
+  if (sched_fifo_enter_max(NULL) != 0) {
+    log_error("Cannot become task manager");
+    goto error;
+  }
+  /* END: Be task manager */
+
+  /* Create task threads */
+  for (i = 0; i < task_count; i++) {
+    if ((errno = pthread_create(&runs[i].thread, NULL, task_thread,
+                                &runs[i])) != 0) {
+      log_syserror("Cannot create task thread of %s", runs[i].desc->name);
+      goto stop;
+    }
+    runs[i].thread_created = 1;
+  }
+  /* END: Create task threads */
+
+  /* Wait for stopping time */
+  if (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t_stop, NULL) != 0) {
+    log_syserror("Task manager fails to wait for the stopping time");
+    goto stop;
+  }
+  /* END: Wait for stopping time */
+
+  exit_code = EXIT_SUCCESS;
+
+ stop:
+  /* Stop the tasks */
+  for (i = 0; i < task_count; i++) {
+    if (runs[i].thread_created) {
+      task_stop(runs[i].tau);
+    }
+  }
+  /* END: Stop the tasks */
+
+  /* Join task threads and check task return statuses */
+  for (i = 0; i < task_count; i++) {
+    if (!runs[i].thread_created) {
+      continue;
+    }
+    if ((errno = pthread_join(runs[i].thread, NULL)) != 0) {
+      log_syserror("Cannot join %s thread", runs[i].desc->name);
+      exit_code = EXIT_FAILURE;
+    } else if (runs[i].rc != 0) {
+      log_error("Task %s does not return successfully (rc = %d)",
+                runs[i].desc->name, runs[i].rc);
+      exit_code = EXIT_FAILURE;
+    }
+    runs[i].thread_created = 0;
+  }
+  /* END: Join task threads and check task return statuses */
+
+  /* Report the worst stop latency */
+  {
+    relative_time worst_latency;
+    const char *worst_task = NULL;
+
+    utility_time_init(&worst_latency);
+    for (i = 0; i < task_count; i++) {
+      relative_time *latency = task_stop_latency(runs[i].tau);
+
+      if (latency == NULL) {
+        continue;
+      }
+      if (worst_task == NULL || utility_time_gt(latency, &worst_latency)) {
+        utility_time_to_utility_time(latency, &worst_latency);
+        worst_task = runs[i].desc->name;
+      }
+      utility_time_gc(latency);
+    }
+
+    if (worst_task != NULL) {
+      to_string(&worst_latency, t_str, sizeof(t_str));
+      printf("Worst stop latency: %s (%s)\n", t_str, worst_task);
+    }
+  }
+  /* END: Report the worst stop latency */
+
+  /* Report the resources */
+  for (i = 0; i < resource_count; i++) {
+    const lock_sample *samples;
+    unsigned long lost_count;
+    unsigned long count = rt_lock_get_samples(locks[i], &samples,
+                                              &lost_count);
+
+    lock_samples_print(stdout, taskset_resource(ts, i)->name, samples,
+                       count);
+    if (lost_count != 0) {
+      printf("%s: %lu samples are lost\n", taskset_resource(ts, i)->name,
+             lost_count);
+    }
+  }
+  /* END: Report the resources */
+
+ error:
+  /* Clean-up */
+  if (runs != NULL) {
+    for (i = task_count; i-- > 0;) {
+      if (runs[i].tau != NULL) {
+        task_destroy(runs[i].tau);
+      }
+      destroy_segments(&runs[i]);
+    }
+    free(runs);
+  }
+
+  if (locks != NULL) {
+    for (i = resource_count; i-- > 0;) {
+      if (locks[i] != NULL) {
+        rt_lock_destroy(locks[i]);
+      }
+    }
+    free(locks);
+  }
+
+  if (busyloop_tolerance != NULL) {
+    utility_time_gc(busyloop_tolerance);
+  }
+  if (overhead != NULL) {
+    utility_time_gc(overhead);
+  }
+  if (task_overhead != NULL) {
+    utility_time_gc(task_overhead);
+  }
+  if (job_stats_overhead != NULL) {
+    utility_time_gc(job_stats_overhead);
+  }
+
+  taskset_destroy(ts);
+
+  return exit_code;
+}
+
+MAIN_BEGIN("taskset_runner", "stderr", NULL)
+{
+  int arg_idx = parse_cmd_line_args(argc, argv);
+  if (arg_idx == -1) {
+    return EXIT_FAILURE;
+  }
+
+  if (parallel_cpu_list != NULL) {
+    return run_parallel(argc - arg_idx, argv + arg_idx);
+  }
+
+  switch (memory_lock()) {
+  case 0:
+    break;
+  case -1:
+    fatal_error("Cannot lock current and future memory due to memory limit");
+  case -2:
+    fatal_error("Insufficient privilege to lock current and future memory");
+  default:
+    fatal_error("Cannot lock current and future memory");
+  }
+
+  memory_preallocate_stack(1024);
+
+  return run_taskset(argv[arg_idx], experiment_cpu);
+
+} MAIN_END
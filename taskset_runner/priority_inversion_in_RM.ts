@@ -0,0 +1,15 @@
+# The scenario of the experiment component priority_inversion_in_RM:
+# each task releases a single job, tau_3 locks R1 before tau_1 needs
+# it, and tau_2 preempts tau_3 while tau_1 waits for R1. Change the
+# protocol of R1 (none, inherit, protect or srp) to see its effect
+# on the blocking time of tau_1. Since the analysis ignores the
+# blocking, it accepts the task set even though tau_1 misses its
+# deadline under the none protocol.
+START 3s
+STOP 3900ms
+
+RESOURCE R1 inherit
+
+TASK tau_1 C=30ms T=1s D=50ms offset=20ms cs=R1@10ms+10ms
+TASK tau_2 C=500ms T=1s D=530ms offset=40ms
+TASK tau_3 C=50ms T=1s D=580ms cs=R1@10ms+30ms
@@ -0,0 +1,10 @@
+# The task set of the experiment component rate_monotonic. Every
+# deadline is implicit so that the deadline monotonic priority levels
+# are the rate monotonic ones.
+START 3s
+STOP 13s
+
+TASK tau_1 C=2ms T=10ms
+TASK tau_2 C=3ms T=15ms
+TASK tau_3 C=6ms T=26ms
+TASK tau_4 C=6ms T=36ms
@@ -0,0 +1,8 @@
+# Two SCHED_DEADLINE tasks sharing a CPU. Simulate it as
+# ./main -x hog=3 cbs_isolation.ts to see that the overrun of hog does
+# not make victim miss its deadlines, and then with -s edf added to see
+# what happens without the budget enforcement of SCHED_DEADLINE.
+STOP 4s
+
+TASK hog    C=20ms T=100ms policy=deadline
+TASK victim C=50ms T=80ms  policy=deadline
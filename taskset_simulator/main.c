@@ -0,0 +1,418 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "../task.h"
+#include "../utility_log.h"
+#include "../utility_time.h"
+#include "../utility_file.h"
+#include "../utility_taskset.h"
+#include "../utility_simulator.h"
+
+#define NS_PER_S 1000000000ULL
+#define MAX_OVERRUNS 16
+
+/* How the policies of the task set file are simulated */
+enum sim_mode {
+  MODE_FILE, /* fifo as SIMULATOR_FP, deadline as SIMULATOR_CBS */
+  MODE_EDF,
+  MODE_CBS,
+  MODE_RM,
+  MODE_DM,
+};
+
+struct overrun {
+  const char *name;
+  double factor;
+};
+
+/* Command line args section */
+static enum sim_mode mode = MODE_FILE;
+static unsigned long long overhead_ns = 0;
+static int measure_overhead = 0;
+static struct overrun overruns[MAX_OVERRUNS];
+static unsigned overrun_count = 0;
+static const char *trace_path = NULL;
+static unsigned default_cpu = 0;
+
+static int parse_cmd_line_args(int argc, char **argv)
+{
+  int optchar;
+  char c;
+  opterr = 0;
+  while ((optchar = getopt(argc, argv, ":hs:o:mx:t:c:")) != -1) {
+    switch (optchar) {
+    case 's':
+      if (strcmp(optarg, "file") == 0) {
+        mode = MODE_FILE;
+      } else if (strcmp(optarg, "edf") == 0) {
+        mode = MODE_EDF;
+      } else if (strcmp(optarg, "cbs") == 0) {
+        mode = MODE_CBS;
+      } else if (strcmp(optarg, "rm") == 0) {
+        mode = MODE_RM;
+      } else if (strcmp(optarg, "dm") == 0) {
+        mode = MODE_DM;
+      } else {
+        log_error("Unknown policy '%s' (-h for help)", optarg);
+        return -1;
+      }
+      break;
+    case 'o':
+      if (sscanf(optarg, "%llu%c", &overhead_ns, &c) != 1) {
+        log_error("Invalid overhead '%s'", optarg);
+        return -1;
+      }
+      break;
+    case 'm':
+      measure_overhead = 1;
+      break;
+    case 'x': {
+      char *eq = strchr(optarg, '=');
+      if (overrun_count == MAX_OVERRUNS) {
+        log_error("At most %d tasks can overrun", MAX_OVERRUNS);
+        return -1;
+      }
+      if (eq == NULL || eq == optarg
+          || sscanf(eq + 1, "%lf%c", &overruns[overrun_count].factor, &c) != 1
+          || overruns[overrun_count].factor <= 0) {
+        log_error("Invalid overrun '%s'", optarg);
+        return -1;
+      }
+      *eq = '\0';
+      overruns[overrun_count++].name = optarg;
+      break;
+    }
+    case 't':
+      trace_path = optarg;
+      break;
+    case 'c':
+      if (sscanf(optarg, "%u%c", &default_cpu, &c) != 1) {
+        log_error("Invalid CPU '%s'", optarg);
+        return -1;
+      }
+      break;
+    case 'h':
+      printf("Usage: %s [-s POLICY] [-o OVERHEAD | -m] [-x TASK=FACTOR]...\n"
+             "          [-t TRACE_FILE] [-c CPU] TASKSET_FILE\n"
+             "\n"
+             "This simulates the task set described in TASKSET_FILE (see\n"
+             "utility_taskset.h for the format) and writes the statistics\n"
+             "of task NAME to TASKSET_FILE_NAME_sim_stats.bin where\n"
+             "TASKSET_FILE has its .ts extension, if any, removed.\n"
+             "\n"
+             "-s POLICY simulates all tasks using POLICY instead of the\n"
+             "   policies in the file (file, the default, simulates fifo\n"
+             "   tasks as SCHED_FIFO and deadline tasks as\n"
+             "   SCHED_DEADLINE). POLICY is one of file, edf (EDF without\n"
+             "   budget enforcement), cbs (SCHED_DEADLINE), rm and dm\n"
+             "   (SCHED_FIFO at rate- or deadline-monotonic priorities).\n"
+             "-o OVERHEAD is the time in ns that a CPU spends to dispatch\n"
+             "   a task (default 0).\n"
+             "-m measures OVERHEAD as the finish-to-start overhead of a\n"
+             "   task on CPU (needs the privilege to use SCHED_FIFO).\n"
+             "-x TASK=FACTOR runs every job of TASK for FACTOR times its\n"
+             "   WCET, e.g., 1.5 to overrun by 50%%.\n"
+             "-t TRACE_FILE writes the context switches in the format of\n"
+             "   the ftrace sched_switch plugin to be converted to a\n"
+             "   timeline using ../sched_switch.\n"
+             "-c CPU is the CPU of the tasks without cpu=CPU (default 0).\n",
+             prog_name);
+      return -1;
+    case ':':
+      log_error("Option -%c needs an argument (-h for help)", optopt);
+      return -1;
+    case '?':
+      log_error("Unrecognized option -%c (-h for help)", optopt);
+      return -1;
+    default:
+      log_error("Unexpected return value of fn getopt");
+      return -1;
+    }
+  }
+
+  if (optind != argc - 1) {
+    log_error("Exactly one task set file must be given (-h for help)");
+    return -1;
+  }
+
+  return optind;
+}
+/* END: Command line args section */
+
+/* Return the dynamically allocated path of the given task set file
+   whose .ts extension, if any, is replaced by the given suffix or
+   NULL if there is insufficient memory */
+static char *make_path(const char *taskset_path, const char *suffix)
+{
+  size_t path_len = strlen(taskset_path);
+  char *path;
+
+  if (path_len > 3 && strcmp(&taskset_path[path_len - 3], ".ts") == 0) {
+    path_len -= 3;
+  }
+  path = malloc(path_len + strlen(suffix) + 1);
+  if (path == NULL) {
+    log_error("Not enough memory to allocate a path");
+    return NULL;
+  }
+  memcpy(path, taskset_path, path_len);
+  strcpy(&path[path_len], suffix);
+
+  return path;
+}
+
+static unsigned long long to_ns(const relative_time *t)
+{
+  struct timespec t_spec;
+
+  to_timespec(t, &t_spec);
+  return t_spec.tv_sec * NS_PER_S + t_spec.tv_nsec;
+}
+
+static void print_ns(const char *label, unsigned long long t)
+{
+  printf("%s%llu.%09llu", label, t / NS_PER_S, t % NS_PER_S);
+}
+
+/* Return the priority level of the given task among the tasks of its
+   CPU ordered by their periods (RM) or their deadlines (DM) */
+static unsigned monotonic_level(const taskset_desc *ts, unsigned idx,
+                                const unsigned *cpus)
+{
+  const struct taskset_task *t = taskset_task(ts, idx);
+  unsigned long long key = to_ns(mode == MODE_RM ? &t->period : &t->deadline);
+  unsigned level = 1, i;
+
+  for (i = 0; i < taskset_task_count(ts); i++) {
+    const struct taskset_task *other = taskset_task(ts, i);
+    unsigned long long other_key = to_ns(mode == MODE_RM
+                                         ? &other->period : &other->deadline);
+    if (cpus[i] == cpus[idx]
+        && (other_key < key || (other_key == key && i < idx))) {
+      level++;
+    }
+  }
+
+  return level;
+}
+
+static int simulate(const char *taskset_path)
+{
+  taskset_desc *ts = NULL;
+  simulator *sim = NULL;
+  FILE *trace = NULL;
+  unsigned *cpus = NULL;
+  char **stats_paths = NULL;
+  unsigned task_count = 0, i, j;
+  struct timespec t_begin, t_end;
+  unsigned long long wall_ns, stop_ns;
+  int exit_code = EXIT_FAILURE;
+
+  if (taskset_load(taskset_path, &ts) != 0) {
+    return EXIT_FAILURE;
+  }
+  task_count = taskset_task_count(ts);
+  stop_ns = to_ns(taskset_stop(ts));
+
+  for (i = 0; i < overrun_count; i++) {
+    for (j = 0; j < task_count; j++) {
+      if (strcmp(taskset_task(ts, j)->name, overruns[i].name) == 0) {
+        break;
+      }
+    }
+    if (j == task_count) {
+      log_error("Task %s to overrun is not in the task set",
+                overruns[i].name);
+      goto error;
+    }
+  }
+
+  if (measure_overhead) {
+    relative_time *task_overhead;
+    if (finish_to_start_overhead(default_cpu, 0, &task_overhead) != 0) {
+      log_error("Cannot obtain finish to start overhead");
+      goto error;
+    }
+    overhead_ns = to_ns(task_overhead);
+    utility_time_gc(task_overhead);
+  }
+
+  if (trace_path != NULL) {
+    trace = fopen(trace_path, "w");
+    if (trace == NULL) {
+      log_syserror("Cannot open '%s' for writing", trace_path);
+      goto error;
+    }
+    fprintf(trace, "# tracer: sched_switch\n");
+  }
+
+  sim = simulator_create(overhead_ns, trace);
+  cpus = calloc(task_count, sizeof(*cpus));
+  stats_paths = calloc(task_count, sizeof(*stats_paths));
+  if (sim == NULL || cpus == NULL || stats_paths == NULL) {
+    log_error("Not enough memory to simulate the task set");
+    goto error;
+  }
+
+  if (taskset_resource_count(ts) != 0) {
+    printf("The critical sections are simulated as normal execution\n");
+  }
+  for (i = 0; i < task_count; i++) {
+    const struct taskset_task *t = taskset_task(ts, i);
+    cpus[i] = (t->cpu == -1 ? default_cpu : t->cpu);
+    if (t->kernel == TASKSET_KERNEL_SLEEP) {
+      printf("Task %s is simulated with a busyloop kernel\n", t->name);
+    }
+  }
+
+  /* Add the tasks */
+  for (i = 0; i < task_count; i++) {
+    const struct taskset_task *t = taskset_task(ts, i);
+    char *suffix = malloc(strlen(t->name) + sizeof("__sim_stats.bin"));
+    struct simulator_task desc = {
+      .name = t->name,
+      .wcet_ns = to_ns(&t->wcet),
+      .period_ns = to_ns(&t->period),
+      .deadline_ns = to_ns(&t->deadline),
+      .offset_ns = to_ns(&t->offset),
+      .prio_level = 0,
+      .cpu = cpus[i],
+    };
+
+    if (suffix == NULL) {
+      log_error("Not enough memory to allocate a path");
+      goto error;
+    }
+    sprintf(suffix, "_%s_sim_stats.bin", t->name);
+    stats_paths[i] = make_path(taskset_path, suffix);
+    free(suffix);
+    if (stats_paths[i] == NULL) {
+      goto error;
+    }
+    desc.stats_file_path = stats_paths[i];
+
+    desc.exec_ns = desc.wcet_ns;
+    for (j = 0; j < overrun_count; j++) {
+      if (strcmp(t->name, overruns[j].name) == 0) {
+        desc.exec_ns = desc.wcet_ns * overruns[j].factor;
+      }
+    }
+
+    switch (mode) {
+    case MODE_FILE:
+      if (t->policy == TASKSET_POLICY_FIFO) {
+        desc.policy = SIMULATOR_FP;
+        desc.prio_level = t->prio_level;
+      } else {
+        desc.policy = SIMULATOR_CBS;
+      }
+      break;
+    case MODE_EDF:
+      desc.policy = SIMULATOR_EDF;
+      break;
+    case MODE_CBS:
+      desc.policy = SIMULATOR_CBS;
+      break;
+    case MODE_RM:
+    case MODE_DM:
+      desc.policy = SIMULATOR_FP;
+      desc.prio_level = monotonic_level(ts, i, cpus);
+      break;
+    }
+
+    if (simulator_add(sim, &desc) < 0) {
+      log_error("Cannot simulate %s", t->name);
+      goto error;
+    }
+  }
+  /* END: Add the tasks */
+
+  clock_gettime(CLOCK_MONOTONIC, &t_begin);
+  switch (simulator_run(sim, to_ns(taskset_start(ts)), stop_ns)) {
+  case 0:
+    break;
+  case -2:
+    log_error("Cannot write some task statistics file");
+    goto error;
+  default:
+    log_error("Cannot simulate the task set");
+    goto error;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t_end);
+  wall_ns = ((t_end.tv_sec - t_begin.tv_sec) * NS_PER_S
+             + t_end.tv_nsec - t_begin.tv_nsec);
+
+  /* Report */
+  printf("Task set %s simulated", taskset_path);
+  print_ns(" with dispatch overhead ", overhead_ns);
+  printf("\n%-*s%6s%8s%8s%16s\n", TASKSET_NAME_MAX, "task", "cpu", "jobs",
+         "late", "max_response");
+  for (i = 0; i < task_count; i++) {
+    printf("%-*s%6u%8lu%8lu", TASKSET_NAME_MAX, taskset_task(ts, i)->name,
+           cpus[i], simulator_job_count(sim, i), simulator_late_count(sim, i));
+    print_ns("     ", simulator_max_response(sim, i));
+    printf("\n");
+  }
+  printf("%lu dispatches and %lu events", simulator_dispatch_count(sim),
+         simulator_event_count(sim));
+  print_ns(" in ", simulator_end(sim));
+  print_ns(" s of simulated time using ", wall_ns);
+  printf(" s (%.0fx real time)\n",
+         wall_ns == 0 ? 0 : (double) simulator_end(sim) / wall_ns);
+  /* END: Report */
+
+  exit_code = EXIT_SUCCESS;
+
+ error:
+  if (sim != NULL) {
+    simulator_destroy(sim);
+  }
+  if (trace != NULL && utility_file_close(trace, trace_path) != 0) {
+    exit_code = EXIT_FAILURE;
+  }
+  if (stats_paths != NULL) {
+    for (i = 0; i < task_count; i++) {
+      free(stats_paths[i]);
+    }
+    free(stats_paths);
+  }
+  free(cpus);
+  taskset_destroy(ts);
+
+  return exit_code;
+}
+
+const char prog_name[] = "taskset_simulator";
+FILE *log_stream;
+
+int main(int argc, char **argv, char **envp)
+{
+  log_stream = stderr;
+
+  int arg_idx = parse_cmd_line_args(argc, argv);
+  if (arg_idx == -1) {
+    return EXIT_FAILURE;
+  }
+
+  return simulate(argv[arg_idx]);
+}
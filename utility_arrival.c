@@ -0,0 +1,301 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include "utility_arrival.h"
+
+#define NS_PER_US 1000ULL
+
+enum arrival_kind {
+  ARRIVAL_MMPP, /* Poisson is an MMPP with a single state */
+  ARRIVAL_TRACE,
+};
+
+struct mmpp_state
+{
+  double mean_ns; /* Of the inter-arrival time */
+  double sojourn_ns; /* Of the time spent in the state */
+};
+
+struct arrival_process
+{
+  enum arrival_kind kind;
+  uint64_t rng_state;
+
+  /* MMPP */
+  struct mmpp_state *states;
+  unsigned state_count;
+  unsigned state;
+  double state_remaining_ns;
+
+  /* Trace */
+  unsigned long long *arrivals_ns;
+  unsigned long arrival_count;
+  unsigned long arrival_capacity;
+  unsigned long next_arrival;
+  unsigned long long prev_arrival_ns;
+};
+
+/* splitmix64 by Sebastiano Vigna */
+static uint64_t rng_next(arrival_process *ap)
+{
+  uint64_t z = (ap->rng_state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+/* Return a sample of the exponential distribution with the given mean */
+static double exponential(arrival_process *ap, double mean)
+{
+  /* Uniform in (0, 1] so that log() is finite */
+  double u = ((rng_next(ap) >> 11) + 1) * 0x1.0p-53;
+  return -mean * log(u);
+}
+
+/* Parse a positive number of microseconds into nanoseconds returning
+   the rest of str or NULL if str is invalid */
+static const char *parse_us(const char *str, double *ns)
+{
+  char *end;
+  unsigned long long us;
+
+  if (*str < '0' || *str > '9') {
+    return NULL;
+  }
+  errno = 0;
+  us = strtoull(str, &end, 10);
+  if (errno != 0 || us == 0) {
+    return NULL;
+  }
+
+  *ns = us * (double) NS_PER_US;
+  return end;
+}
+
+static int parse_mmpp(arrival_process *ap, const char *params, int is_poisson)
+{
+  const char *itr;
+  unsigned i;
+
+  ap->state_count = 1;
+  for (itr = params; *itr != '\0'; itr++) {
+    if (*itr == ',') {
+      ap->state_count++;
+    }
+  }
+  if (is_poisson && ap->state_count != 1) {
+    return -1;
+  }
+
+  ap->states = malloc(sizeof(*ap->states) * ap->state_count);
+  if (ap->states == NULL) {
+    log_error("Not enough memory for %u MMPP states", ap->state_count);
+    return -2;
+  }
+
+  itr = params;
+  for (i = 0; i < ap->state_count; i++) {
+    itr = parse_us(itr, &ap->states[i].mean_ns);
+    if (itr == NULL) {
+      return -1;
+    }
+
+    if (is_poisson) {
+      ap->states[i].sojourn_ns = INFINITY;
+    } else {
+      if (*itr != ':') {
+        return -1;
+      }
+      itr = parse_us(itr + 1, &ap->states[i].sojourn_ns);
+      if (itr == NULL) {
+        return -1;
+      }
+    }
+
+    if (*itr != (i + 1 == ap->state_count ? '\0' : ',')) {
+      return -1;
+    }
+    itr++;
+  }
+
+  ap->kind = ARRIVAL_MMPP;
+  ap->state = 0;
+  ap->state_remaining_ns = exponential(ap, ap->states[0].sojourn_ns);
+  return 0;
+}
+
+static int parse_trace_line(const char *line, void *args)
+{
+  arrival_process *ap = args;
+  unsigned long long us;
+  char *end;
+
+  line += strspn(line, " \t");
+  if (*line == '\0' || *line == '#') {
+    return 0;
+  }
+
+  errno = 0;
+  us = strtoull(line, &end, 10);
+  if (errno != 0 || end == line || end[strspn(end, " \t\r")] != '\0') {
+    log_error("Invalid arrival time '%s'", line);
+    return -1;
+  }
+  if (ap->arrival_count != 0
+      && us * NS_PER_US < ap->arrivals_ns[ap->arrival_count - 1]) {
+    log_error("Arrival time %llu precedes the previous one", us);
+    return -1;
+  }
+
+  if (ap->arrival_count == ap->arrival_capacity) {
+    unsigned long capacity = (ap->arrival_capacity == 0
+                              ? 1024 : ap->arrival_capacity * 2);
+    unsigned long long *arrivals_ns = realloc(ap->arrivals_ns,
+                                              (sizeof(*arrivals_ns)
+                                               * capacity));
+    if (arrivals_ns == NULL) {
+      log_error("Not enough memory for %lu arrival times", capacity);
+      return -1;
+    }
+    ap->arrivals_ns = arrivals_ns;
+    ap->arrival_capacity = capacity;
+  }
+  ap->arrivals_ns[ap->arrival_count++] = us * NS_PER_US;
+
+  return 0;
+}
+
+static int parse_trace(arrival_process *ap, const char *path)
+{
+  FILE *trace = utility_file_open_for_reading(path);
+  int rc;
+
+  if (trace == NULL) {
+    return -2;
+  }
+  rc = utility_file_read(trace, 64, parse_trace_line, ap);
+  utility_file_close(trace, path);
+
+  if (rc != 0) {
+    return rc;
+  }
+
+  ap->kind = ARRIVAL_TRACE;
+  return 0;
+}
+
+int arrival_create(const char *spec, uint64_t seed, arrival_process **res)
+{
+  arrival_process *ap = malloc(sizeof(*ap));
+  int rc;
+
+  if (ap == NULL) {
+    log_error("Not enough memory for an arrival process");
+    return -2;
+  }
+  memset(ap, 0, sizeof(*ap));
+  ap->rng_state = seed;
+
+  if (strncmp(spec, "poisson:", 8) == 0) {
+    rc = parse_mmpp(ap, spec + 8, 1);
+  } else if (strncmp(spec, "mmpp:", 5) == 0) {
+    rc = parse_mmpp(ap, spec + 5, 0);
+  } else if (strncmp(spec, "trace:", 6) == 0) {
+    rc = parse_trace(ap, spec + 6);
+  } else {
+    rc = -1;
+  }
+
+  if (rc != 0) {
+    if (rc == -1) {
+      log_error("Invalid arrival process '%s'", spec);
+    }
+    arrival_destroy(ap);
+    return rc;
+  }
+
+  *res = ap;
+  return 0;
+}
+
+void arrival_destroy(arrival_process *ap)
+{
+  free(ap->states);
+  free(ap->arrivals_ns);
+  free(ap);
+}
+
+int arrival_next(arrival_process *ap, unsigned long long *interarrival_ns)
+{
+  double t = 0;
+
+  if (ap->kind == ARRIVAL_TRACE) {
+    if (ap->next_arrival == ap->arrival_count) {
+      return -1;
+    }
+    *interarrival_ns = ap->arrivals_ns[ap->next_arrival] - ap->prev_arrival_ns;
+    ap->prev_arrival_ns = ap->arrivals_ns[ap->next_arrival++];
+    return 0;
+  }
+
+  /* Since the exponential distribution is memoryless, an arrival that
+     would fall after the end of the current state is simply redrawn
+     with the mean of the next state from the end of the current one */
+  while (1) {
+    double x = exponential(ap, ap->states[ap->state].mean_ns);
+    if (x < ap->state_remaining_ns) {
+      ap->state_remaining_ns -= x;
+      t += x;
+      break;
+    }
+    t += ap->state_remaining_ns;
+    ap->state = (ap->state + 1) % ap->state_count;
+    ap->state_remaining_ns = exponential(ap,
+                                         ap->states[ap->state].sojourn_ns);
+  }
+
+  *interarrival_ns = t + 0.5;
+  return 0;
+}
+
+unsigned long arrival_expected_count(const arrival_process *ap,
+                                     unsigned long long duration_ns)
+{
+  unsigned long i;
+
+  if (ap->kind == ARRIVAL_TRACE) {
+    for (i = 0; i < ap->arrival_count; i++) {
+      if (ap->arrivals_ns[i] > duration_ns) {
+        break;
+      }
+    }
+    return i;
+  }
+
+  if (ap->state_count == 1) {
+    return duration_ns / ap->states[0].mean_ns;
+  }
+
+  /* The long-run arrival rate is the expected number of arrivals in
+     a cycle through all states over the expected cycle length */
+  double cycle_arrivals = 0, cycle_ns = 0;
+  for (i = 0; i < ap->state_count; i++) {
+    cycle_arrivals += ap->states[i].sojourn_ns / ap->states[i].mean_ns;
+    cycle_ns += ap->states[i].sojourn_ns;
+  }
+  return duration_ns * (cycle_arrivals / cycle_ns);
+}
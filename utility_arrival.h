@@ -0,0 +1,117 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+/**
+ * @file utility_arrival.h
+ * @brief Arrival processes to release the jobs of an open-loop load
+ *        generator.
+ *
+ *        Unlike a periodic task, an open-loop load generator releases
+ *        its jobs at times that do not depend on the completion of
+ *        the previous jobs. The supported arrival processes are:
+ *        - Poisson: the inter-arrival times are exponentially
+ *          distributed.
+ *        - MMPP (Markov-modulated Poisson process): a Poisson process
+ *          whose mean inter-arrival time changes each time the
+ *          process moves to the next of its states, which happens
+ *          after an exponentially distributed sojourn time. This
+ *          models bursty traffic.
+ *        - Trace: the arrival times are read from a file recorded,
+ *          for example, from a production system.
+ *
+ *        The pseudo-random numbers are generated from a given seed so
+ *        that an experiment can be repeated with exactly the same
+ *        arrivals.
+ *
+ * @author Tadeus Prastowo <eus@member.fsf.org>
+ */
+
+#ifndef UTILITY_ARRIVAL
+#define UTILITY_ARRIVAL
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <errno.h>
+#include "utility_log.h"
+#include "utility_file.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /** An opaque data type of an arrival process. */
+  typedef struct arrival_process arrival_process;
+
+  /**
+   * Create an arrival process from its specification, which is one
+   * of the following:
+   * - poisson:MEAN
+   *   where MEAN is the mean inter-arrival time in microsecond.
+   * - mmpp:MEAN_1:SOJOURN_1,MEAN_2:SOJOURN_2[,MEAN_n:SOJOURN_n...]
+   *   where in state i, MEAN_i is the mean inter-arrival time and
+   *   SOJOURN_i is the mean time before moving to state i + 1 (or 1
+   *   after state n), both in microsecond. The process starts in
+   *   state 1.
+   * - trace:PATH
+   *   where PATH is a file listing one arrival time per line in
+   *   microsecond since the start in non-decreasing order. Blank
+   *   lines and lines starting with # are ignored.
+   *
+   * @param spec a pointer to the specification.
+   * @param seed the seed of the pseudo-random number generator.
+   * @param res a pointer to the location to store the created process.
+   *
+   * @return 0 if successful, -1 if the specification is invalid (the
+   * reason is @ref utility_log.h "logged"), or -2 in case of hard
+   * error that requires the investigation of the output of the
+   * logging facility to fix the error (e.g., the trace cannot be
+   * read).
+   */
+  int arrival_create(const char *spec, uint64_t seed, arrival_process **res);
+
+  /**
+   * Destroy an arrival process.
+   */
+  void arrival_destroy(arrival_process *ap);
+
+  /**
+   * Get the time between the previous arrival, or the start for the
+   * first arrival, and the next arrival.
+   *
+   * @param interarrival_ns a pointer to the location to store the
+   * time in nanosecond.
+   *
+   * @return 0 if successful or -1 if there is no more arrival (i.e.,
+   * the trace is exhausted).
+   */
+  int arrival_next(arrival_process *ap, unsigned long long *interarrival_ns);
+
+  /**
+   * @return the expected number of arrivals within the given
+   * duration since the start, which is exact for a trace.
+   */
+  unsigned long arrival_expected_count(const arrival_process *ap,
+                                       unsigned long long duration_ns);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UTILITY_ARRIVAL */
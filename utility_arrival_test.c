@@ -0,0 +1,157 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "utility_testcase.h"
+#include "utility_log.h"
+#include "utility_arrival.h"
+
+#define SAMPLE_COUNT 200000
+
+static char trace_path[] = "/tmp/utility_arrival_test.XXXXXX";
+static void cleanup(void)
+{
+  unlink(trace_path);
+}
+
+static void write_trace(const char *content)
+{
+  FILE *trace = fopen(trace_path, "w");
+  if (trace == NULL) {
+    fatal_error("Cannot open %s", trace_path);
+  }
+  fputs(content, trace);
+  fclose(trace);
+}
+
+/* Return the squared coefficient of variation of the inter-arrival
+   times whose mean is stored in *mean_ns */
+static double sample(arrival_process *ap, unsigned long count,
+                     double *mean_ns)
+{
+  double sum = 0, sum_sq = 0, mean;
+  unsigned long long x;
+  unsigned long i;
+
+  for (i = 0; i < count; i++) {
+    if (arrival_next(ap, &x) != 0) {
+      fatal_error("Arrival process is exhausted");
+    }
+    sum += x;
+    sum_sq += (double) x * x;
+  }
+
+  mean = sum / count;
+  *mean_ns = mean;
+  return (sum_sq / count - mean * mean) / (mean * mean);
+}
+
+MAIN_UNIT_TEST_BEGIN("utility_arrival_test", "stderr", NULL, cleanup)
+{
+  arrival_process *ap, *ap2;
+  unsigned long long x, y;
+  double mean_ns, cv_sq;
+  int fd, i;
+
+  fd = mkstemp(trace_path);
+  gracious_assert(fd != -1);
+  close(fd);
+
+  /* Testcase 1: invalid specifications */
+  {
+    const char *specs[] = {
+      "", "poisson", "poisson:", "poisson:0", "poisson:-5", "poisson:10x",
+      "poisson:10,20", "mmpp:10", "mmpp:10:", "mmpp:10:20,", "mmpp:10:20,30",
+      "mmpp:10:0", "uniform:10", NULL
+    };
+    for (i = 0; specs[i] != NULL; i++) {
+      gracious_assert(arrival_create(specs[i], 1, &ap) == -1);
+    }
+    gracious_assert(arrival_create("trace:/nonexistent/trace", 1, &ap) == -2);
+  }
+
+  /* Testcase 2: Poisson process */
+  gracious_assert(arrival_create("poisson:1000", 1, &ap) == 0);
+  cv_sq = sample(ap, SAMPLE_COUNT, &mean_ns);
+  gracious_assert(mean_ns > 980000 && mean_ns < 1020000);
+  gracious_assert(cv_sq > 0.95 && cv_sq < 1.05);
+  gracious_assert(arrival_expected_count(ap, 10000000000ULL) == 10000);
+  arrival_destroy(ap);
+
+  /* Testcase 3: the same seed gives the same arrivals */
+  gracious_assert(arrival_create("poisson:1000", 7, &ap) == 0);
+  gracious_assert(arrival_create("poisson:1000", 7, &ap2) == 0);
+  for (i = 0; i < 1000; i++) {
+    gracious_assert(arrival_next(ap, &x) == 0);
+    gracious_assert(arrival_next(ap2, &y) == 0);
+    gracious_assert(x == y);
+  }
+  arrival_destroy(ap2);
+  gracious_assert(arrival_create("poisson:1000", 8, &ap2) == 0);
+  gracious_assert(arrival_next(ap, &x) == 0);
+  gracious_assert(arrival_next(ap2, &y) == 0);
+  gracious_assert(x != y);
+  arrival_destroy(ap2);
+  arrival_destroy(ap);
+
+  /* Testcase 4: MMPP alternating between bursts and quiet periods */
+  gracious_assert(arrival_create("mmpp:100:10000,10000:10000", 1, &ap) == 0);
+  gracious_assert(arrival_expected_count(ap, 10000000000ULL) == 50500);
+  {
+    unsigned long count = 0;
+    unsigned long long t_ns = 0;
+    while (1) {
+      gracious_assert(arrival_next(ap, &x) == 0);
+      t_ns += x;
+      if (t_ns > 100000000000ULL) {
+        break;
+      }
+      count++;
+    }
+    gracious_assert(count > 505000 * 0.9 && count < 505000 * 1.1);
+  }
+  cv_sq = sample(ap, SAMPLE_COUNT, &mean_ns);
+  gracious_assert(cv_sq > 4); /* Much burstier than Poisson */
+  arrival_destroy(ap);
+
+  /* Testcase 5: trace */
+  write_trace("# Recorded arrivals\n0\n100\n\n100\n350\n");
+  {
+    char spec[64];
+    const unsigned long long expected_ns[] = {0, 100000, 0, 250000};
+    snprintf(spec, sizeof(spec), "trace:%s", trace_path);
+    gracious_assert(arrival_create(spec, 1, &ap) == 0);
+    gracious_assert(arrival_expected_count(ap, 200000) == 3);
+    gracious_assert(arrival_expected_count(ap, 1000000) == 4);
+    for (i = 0; i < 4; i++) {
+      gracious_assert(arrival_next(ap, &x) == 0);
+      gracious_assert(x == expected_ns[i]);
+    }
+    gracious_assert(arrival_next(ap, &x) == -1);
+    gracious_assert(arrival_next(ap, &x) == -1);
+    arrival_destroy(ap);
+
+    write_trace("100\n50\n");
+    gracious_assert(arrival_create(spec, 1, &ap) == -1);
+    write_trace("100\nabc\n");
+    gracious_assert(arrival_create(spec, 1, &ap) == -1);
+  }
+
+} MAIN_UNIT_TEST_END
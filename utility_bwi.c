@@ -0,0 +1,408 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#define _GNU_SOURCE /* For fn syscall */
+
+#include "utility_bwi.h"
+
+/* The system call numbers of the patched SCHED_DEADLINE kernel */
+#define SYS_bwi_give 344
+#define SYS_bwi_revoke 345
+
+struct emulated_server;
+
+struct bwi
+{
+  enum bwi_backend backend;
+  int active; /* Whether the bandwidth is being given */
+  pid_t server_pid;
+  int key; /* The key returned by the legacy syscall */
+  struct emulated_server *server; /* The server inheriting the emulation */
+  struct sched_param_ex param_ex; /* The parameters given to the server */
+  bwi *next_giver; /* The next handle giving to the same server */
+  bwi_overhead overheads[BWI_OPERATION_COUNT];
+};
+
+/* A server inheriting the bandwidth of one or more handles through
+   the emulation. The server is scheduled using the largest bandwidth
+   among its givers and its own parameters, and its own parameters
+   are restored only when the last giver revokes. */
+struct emulated_server
+{
+  pid_t server_pid;
+  struct scheduler server_sched; /* The server parameters to restore */
+  int boosted; /* Whether the server is using the parameters of a giver */
+  struct sched_param_ex applied; /* The giver parameters in use */
+  bwi *givers;
+  struct emulated_server *next;
+};
+
+static pthread_mutex_t emulated_servers_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct emulated_server *emulated_servers = NULL;
+
+static const char *const backend_names[] = {
+  "auto", "legacy", "emulated", "none",
+};
+static const char *const operation_names[] = {
+  "give", "revoke",
+};
+
+int bwi_backend_parse(const char *name, enum bwi_backend *res)
+{
+  int i;
+
+  for (i = 0; i < sizeof(backend_names) / sizeof(*backend_names); i++) {
+    if (strcasecmp(name, backend_names[i]) == 0) {
+      *res = i;
+      return 0;
+    }
+  }
+
+  return -1;
+}
+
+const char *bwi_backend_name(enum bwi_backend backend)
+{
+  if (backend >= sizeof(backend_names) / sizeof(*backend_names)) {
+    return "unknown";
+  }
+  return backend_names[backend];
+}
+
+int bwi_create(enum bwi_backend backend, bwi **res)
+{
+  bwi *b = calloc(1, sizeof(*b));
+
+  if (b == NULL) {
+    log_error("Not enough memory for a BWI handle");
+    return -2;
+  }
+
+  if (backend == BWI_BACKEND_AUTO) {
+    backend = (sched_deadline_abi() == SCHED_DEADLINE_ABI_LEGACY
+               ? BWI_BACKEND_LEGACY : BWI_BACKEND_EMULATED);
+  }
+  b->backend = backend;
+
+  *res = b;
+  return 0;
+}
+
+void bwi_destroy(bwi *b)
+{
+  bwi_revoke(b);
+  free(b);
+}
+
+enum bwi_backend bwi_get_backend(const bwi *b)
+{
+  return b->backend;
+}
+
+static struct emulated_server *emulated_server_get(pid_t server_pid)
+{
+  struct emulated_server *s;
+
+  for (s = emulated_servers; s != NULL; s = s->next) {
+    if (s->server_pid == server_pid) {
+      return s;
+    }
+  }
+
+  s = calloc(1, sizeof(*s));
+  if (s == NULL) {
+    log_error("Not enough memory to emulate BWI on server %d", server_pid);
+    return NULL;
+  }
+  s->server_pid = server_pid;
+
+  /* Save the server parameters */
+  struct scheduler *saved = &s->server_sched;
+  saved->policy = sched_getscheduler(server_pid);
+  if (saved->policy == -1
+      || sched_getparam(server_pid, &saved->param) != 0
+      || (saved->policy == SCHED_DEADLINE
+          && sched_getparam_ex(server_pid, &saved->param_ex) != 0)) {
+    log_syserror("Cannot save the scheduler of server %d", server_pid);
+    free(s);
+    return NULL;
+  }
+  /* END: Save the server parameters */
+
+  s->next = emulated_servers;
+  emulated_servers = s;
+
+  return s;
+}
+
+static void emulated_server_put(struct emulated_server *s)
+{
+  struct emulated_server **prev;
+
+  if (s->givers != NULL) {
+    return;
+  }
+
+  for (prev = &emulated_servers; *prev != s; prev = &(*prev)->next);
+  *prev = s->next;
+  free(s);
+}
+
+/* Schedule the server using the largest bandwidth among its givers
+   and its own parameters. A terminated server is not an error when
+   revoking. Return 0 if successful, -1 if the admission control
+   refuses the parameters of the giver, or -2 in case of hard error. */
+static int emulated_server_update(struct emulated_server *s, int revoking)
+{
+  struct scheduler *saved = &s->server_sched;
+  struct sched_param_ex *target = NULL;
+  bwi *giver;
+  int rc;
+
+  for (giver = s->givers; giver != NULL; giver = giver->next_giver) {
+    if (target == NULL
+        || (sched_deadline_bandwidth(&giver->param_ex)
+            > sched_deadline_bandwidth(target))) {
+      target = &giver->param_ex;
+    }
+  }
+  if (target != NULL && saved->policy == SCHED_DEADLINE
+      && (sched_deadline_bandwidth(&saved->param_ex)
+          >= sched_deadline_bandwidth(target))) {
+    target = NULL; /* The server is already fast enough */
+  }
+
+  if (target == NULL) {
+    if (!s->boosted) {
+      return 0;
+    }
+    s->boosted = 0;
+
+    if (saved->policy == SCHED_DEADLINE) {
+      rc = sched_setscheduler_ex(s->server_pid, &saved->param_ex);
+    } else {
+      rc = sched_setscheduler(s->server_pid, saved->policy, &saved->param);
+    }
+    if (rc != 0 && errno != ESRCH) { /* A terminated server needs nothing */
+      log_syserror("Cannot restore the scheduler of server %d",
+                   s->server_pid);
+      return -2;
+    }
+
+    return 0;
+  }
+
+  if (s->boosted && memcmp(&s->applied, target, sizeof(*target)) == 0) {
+    return 0;
+  }
+
+  if (sched_setscheduler_ex(s->server_pid, target) != 0) {
+    if (errno == EBUSY) {
+      return -1;
+    }
+    if (errno == ESRCH && revoking) {
+      return 0;
+    }
+    log_syserror("Cannot give bandwidth %f to server %d",
+                 sched_deadline_bandwidth(target), s->server_pid);
+    return -2;
+  }
+  s->boosted = 1;
+  s->applied = *target;
+
+  return 0;
+}
+
+/* Emulate BWI by scheduling the server using the parameters of the
+   caller */
+static int emulated_give(bwi *b, pid_t server_pid)
+{
+  struct emulated_server *s;
+  int rc;
+
+  b->server = NULL;
+
+  if (sched_getscheduler(0) != SCHED_DEADLINE) {
+    return -1; /* No bandwidth to give */
+  }
+  if (sched_getparam_ex(0, &b->param_ex) != 0) {
+    log_syserror("Cannot get the SCHED_DEADLINE parameters of the caller");
+    return -2;
+  }
+  b->param_ex.sched_flags &= ~SCHED_FLAG_RESET_ON_FORK;
+
+  pthread_mutex_lock(&emulated_servers_lock);
+
+  s = emulated_server_get(server_pid);
+  if (s == NULL) {
+    rc = -2;
+    goto out;
+  }
+
+  b->next_giver = s->givers;
+  s->givers = b;
+
+  rc = emulated_server_update(s, 0);
+  if (rc != 0) {
+    s->givers = b->next_giver;
+    emulated_server_put(s);
+    goto out;
+  }
+  b->server = s;
+
+ out:
+  pthread_mutex_unlock(&emulated_servers_lock);
+  return rc;
+}
+
+static int emulated_revoke(bwi *b)
+{
+  struct emulated_server *s = b->server;
+  bwi **prev;
+  int rc;
+
+  if (s == NULL) {
+    return 0;
+  }
+  b->server = NULL;
+
+  pthread_mutex_lock(&emulated_servers_lock);
+
+  for (prev = &s->givers; *prev != b; prev = &(*prev)->next_giver);
+  *prev = b->next_giver;
+
+  rc = emulated_server_update(s, 1);
+  if (rc == -1) {
+    log_error("Cannot give the remaining bandwidth to server %d",
+              s->server_pid);
+    rc = -2;
+  }
+  emulated_server_put(s);
+
+  pthread_mutex_unlock(&emulated_servers_lock);
+  return rc;
+}
+
+static void account(bwi *b, enum bwi_operation op, int rc,
+                    const struct timespec *t_begin)
+{
+  bwi_overhead *overhead = &b->overheads[op];
+  struct timespec t_end;
+  unsigned long long ns;
+
+  clock_gettime(CLOCK_MONOTONIC, &t_end);
+  ns = ((t_end.tv_sec - t_begin->tv_sec) * 1000000000ULL
+        + t_end.tv_nsec - t_begin->tv_nsec);
+
+  overhead->count++;
+  if (rc == -1) {
+    overhead->refused_count++;
+  }
+  overhead->total_ns += ns;
+  if (ns > overhead->max_ns) {
+    overhead->max_ns = ns;
+  }
+}
+
+int bwi_give(bwi *b, pid_t server_pid)
+{
+  struct timespec t_begin;
+  int rc = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &t_begin);
+
+  switch (b->backend) {
+  case BWI_BACKEND_LEGACY:
+    if (syscall(SYS_bwi_give, server_pid, &b->key) != 0) {
+      if (errno == EAGAIN) {
+        rc = -1;
+      } else {
+        log_syserror("Cannot perform BWI on server %d", server_pid);
+        rc = -2;
+      }
+    }
+    break;
+  case BWI_BACKEND_EMULATED:
+    rc = emulated_give(b, server_pid);
+    break;
+  default:
+    break;
+  }
+
+  if (rc == 0) {
+    b->active = 1;
+    b->server_pid = server_pid;
+  }
+
+  account(b, BWI_GIVE, rc, &t_begin);
+  return rc;
+}
+
+int bwi_revoke(bwi *b)
+{
+  struct timespec t_begin;
+  int rc = 0;
+
+  if (!b->active) {
+    return 0;
+  }
+  b->active = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &t_begin);
+
+  switch (b->backend) {
+  case BWI_BACKEND_LEGACY:
+    if (syscall(SYS_bwi_revoke, b->key) != 0) {
+      log_syserror("Cannot revoke BWI on server %d", b->server_pid);
+      rc = -2;
+    }
+    break;
+  case BWI_BACKEND_EMULATED:
+    rc = emulated_revoke(b);
+    break;
+  default:
+    break;
+  }
+
+  account(b, BWI_REVOKE, rc, &t_begin);
+  return rc;
+}
+
+void bwi_get_overhead(const bwi *b, enum bwi_operation op, bwi_overhead *res)
+{
+  *res = b->overheads[op];
+}
+
+void bwi_overhead_merge(bwi_overhead *into, const bwi_overhead *from)
+{
+  into->count += from->count;
+  into->refused_count += from->refused_count;
+  into->total_ns += from->total_ns;
+  if (from->max_ns > into->max_ns) {
+    into->max_ns = from->max_ns;
+  }
+}
+
+void bwi_overhead_print(FILE *stream, enum bwi_backend backend,
+                        enum bwi_operation op, const bwi_overhead *overhead)
+{
+  fprintf(stream, "bwi_%s_%s (ns): n=%lu refused=%lu mean=%llu max=%llu\n",
+          operation_names[op], bwi_backend_name(backend), overhead->count,
+          overhead->refused_count,
+          overhead->count == 0 ? 0 : overhead->total_ns / overhead->count,
+          overhead->max_ns);
+}
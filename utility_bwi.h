@@ -0,0 +1,185 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+/**
+ * @file utility_bwi.h
+ * @brief Bandwidth inheritance (BWI) through pluggable backends.
+ *
+ * A thread blocking on a server it has sent a request to gives its
+ * bandwidth to the server until the response arrives. The following
+ * backends are available:
+ * - legacy: syscalls 344 and 345 of the patched SCHED_DEADLINE
+ *   kernel, which move the CBS of the caller to the server.
+ * - emulated: the server is temporarily scheduled using the
+ *   SCHED_DEADLINE parameters of the caller, which must be a
+ *   SCHED_DEADLINE thread, through sched_setattr() of a mainline
+ *   kernel. The server keeps its own parameters if they already give
+ *   a larger bandwidth. Unlike the legacy backend, the caller keeps
+ *   its own bandwidth as well so that the admission control of the
+ *   kernel may refuse the inheritance. When several handles of the
+ *   same process give to the same server, the server is scheduled
+ *   using the largest bandwidth given and its own parameters are
+ *   restored only when the last handle revokes. Handles of different
+ *   processes are not tracked together.
+ * - none: nothing is done to serve as the baseline.
+ *
+ * The duration of every operation is measured so that the cost of
+ * each mechanism can be compared.
+ *
+ * @author Tadeus Prastowo <eus@member.fsf.org>
+ */
+
+#ifndef UTILITY_BWI
+#define UTILITY_BWI
+
+#include <stdio.h>
+#include <sys/types.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <time.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include "utility_sched.h"
+#include "utility_sched_deadline.h"
+#include "utility_log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /** The BWI backends. */
+  enum bwi_backend {
+    BWI_BACKEND_AUTO, /**< legacy if the running kernel has the legacy
+                         SCHED_DEADLINE ABI or emulated otherwise. */
+    BWI_BACKEND_LEGACY, /**< Syscalls 344 and 345. */
+    BWI_BACKEND_EMULATED, /**< sched_setattr() on behalf of the caller. */
+    BWI_BACKEND_NONE, /**< No inheritance. */
+  };
+
+  /** The measured BWI operations. */
+  enum bwi_operation {
+    BWI_GIVE,
+    BWI_REVOKE,
+    BWI_OPERATION_COUNT,
+  };
+
+  /** The overhead of a BWI operation. */
+  typedef struct
+  {
+    unsigned long count; /* The number of calls */
+    unsigned long refused_count; /* The calls refused by the kernel */
+    unsigned long long total_ns;
+    unsigned long long max_ns;
+  } bwi_overhead;
+
+  /**
+   * A BWI handle of a thread.
+   * This is an opaque type; do not manipulate any of its instances directly.
+   */
+  typedef struct bwi bwi;
+
+  /**
+   * Parse the name of a backend, which is one of auto, legacy,
+   * emulated and none ignoring the case.
+   *
+   * @return 0 if the name is valid or -1 otherwise.
+   */
+  int bwi_backend_parse(const char *name, enum bwi_backend *res);
+
+  /**
+   * @return a pointer to the name of the given backend.
+   */
+  const char *bwi_backend_name(enum bwi_backend backend);
+
+  /**
+   * Create a BWI handle to be used by one thread at a time.
+   *
+   * @param backend the backend, which is resolved right away if it is
+   * BWI_BACKEND_AUTO.
+   * @param res a pointer to the object to store the created handle.
+   *
+   * @return 0 if the handle is created or -2 in case of hard error that
+   * requires the investigation of the output of the logging facility
+   * to fix the error.
+   */
+  int bwi_create(enum bwi_backend backend, bwi **res);
+
+  /**
+   * Revoke the bandwidth still given, if any, and destroy the handle.
+   */
+  void bwi_destroy(bwi *b);
+
+  /**
+   * @return the resolved backend of the given handle.
+   */
+  enum bwi_backend bwi_get_backend(const bwi *b);
+
+  /**
+   * Give the bandwidth of the calling thread to the given server
+   * until bwi_revoke() is called.
+   *
+   * @param b a pointer to the handle of the calling thread, which
+   * must not be giving its bandwidth already.
+   * @param server_pid the PID of the server whose main thread is to
+   * inherit the bandwidth.
+   *
+   * @return 0 if the bandwidth is given, -1 if the bandwidth cannot be
+   * given at the moment (e.g., the server is already inheriting
+   * another bandwidth, the admission control rejects the emulation or
+   * the calling thread has no SCHED_DEADLINE bandwidth to emulate) so
+   * that the caller should proceed without BWI, or -2 in case of hard
+   * error that requires the investigation of the output of the
+   * logging facility to fix the error.
+   */
+  int bwi_give(bwi *b, pid_t server_pid);
+
+  /**
+   * Revoke the bandwidth given using bwi_give(). Nothing is done if
+   * no bandwidth is given.
+   *
+   * @return 0 if the bandwidth is revoked or -2 in case of hard error
+   * that requires the investigation of the output of the logging
+   * facility to fix the error.
+   */
+  int bwi_revoke(bwi *b);
+
+  /**
+   * Store the overhead of the given operation measured so far.
+   */
+  void bwi_get_overhead(const bwi *b, enum bwi_operation op,
+                        bwi_overhead *res);
+
+  /**
+   * Accumulate the overhead pointed to by from into that pointed to by
+   * into, e.g., to sum up the overheads of several threads.
+   */
+  void bwi_overhead_merge(bwi_overhead *into, const bwi_overhead *from);
+
+  /**
+   * Print the given overhead in the format:
+   * bwi_OPERATION_BACKEND (ns): n=N refused=R mean=MEAN max=MAX
+   */
+  void bwi_overhead_print(FILE *stream, enum bwi_backend backend,
+                          enum bwi_operation op,
+                          const bwi_overhead *overhead);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UTILITY_BWI */
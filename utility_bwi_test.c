@@ -0,0 +1,186 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include "utility_testcase.h"
+#include "utility_log.h"
+#include "utility_bwi.h"
+#include "utility_sched_deadline.h"
+#include "utility_time.h"
+
+static pid_t server_pid = -1;
+static void cleanup(void)
+{
+  if (server_pid != -1) {
+    kill(server_pid, SIGKILL);
+    waitpid(server_pid, NULL, 0);
+  }
+}
+
+MAIN_UNIT_TEST_BEGIN("utility_bwi_test", "stderr", NULL, cleanup)
+{
+  enum bwi_backend backend;
+  bwi_overhead overhead, total;
+  bwi *b;
+
+  /* Testcase 1: backend names */
+  gracious_assert(bwi_backend_parse("Emulated", &backend) == 0);
+  gracious_assert(backend == BWI_BACKEND_EMULATED);
+  gracious_assert(bwi_backend_parse("none", &backend) == 0);
+  gracious_assert(backend == BWI_BACKEND_NONE);
+  gracious_assert(bwi_backend_parse("syscall", &backend) == -1);
+  gracious_assert(strcmp(bwi_backend_name(BWI_BACKEND_LEGACY), "legacy") == 0);
+
+  /* Testcase 2: the no-op baseline */
+  gracious_assert(bwi_create(BWI_BACKEND_NONE, &b) == 0);
+  gracious_assert(bwi_get_backend(b) == BWI_BACKEND_NONE);
+  gracious_assert(bwi_revoke(b) == 0); /* Nothing given yet */
+  gracious_assert(bwi_give(b, getpid()) == 0);
+  gracious_assert(bwi_revoke(b) == 0);
+  gracious_assert(bwi_give(b, getpid()) == 0);
+  gracious_assert(bwi_revoke(b) == 0);
+  bwi_get_overhead(b, BWI_GIVE, &overhead);
+  gracious_assert(overhead.count == 2 && overhead.refused_count == 0);
+  gracious_assert(overhead.max_ns * 2 >= overhead.total_ns);
+  bwi_get_overhead(b, BWI_REVOKE, &overhead);
+  gracious_assert(overhead.count == 2);
+  memset(&total, 0, sizeof(total));
+  bwi_overhead_merge(&total, &overhead);
+  bwi_overhead_merge(&total, &overhead);
+  gracious_assert(total.count == 4 && total.max_ns == overhead.max_ns);
+  bwi_destroy(b);
+
+  if (under_valgrind() || sched_deadline_abi() != SCHED_DEADLINE_ABI_MAINLINE) {
+    /* Valgrind refuses to run fn syscall, and the emulation needs
+       sched_setattr */
+
+    return EXIT_SUCCESS;
+  }
+
+  /* Testcase 3: the emulation on a mainline kernel */
+  gracious_assert(bwi_create(BWI_BACKEND_AUTO, &b) == 0);
+  gracious_assert(bwi_get_backend(b) == BWI_BACKEND_EMULATED);
+
+  server_pid = fork();
+  gracious_assert(server_pid != -1);
+  if (server_pid == 0) {
+    while (1) {
+      pause();
+  }
+  }
+  gracious_assert(sched_getscheduler(server_pid) == SCHED_OTHER);
+
+  /* A caller without SCHED_DEADLINE bandwidth has nothing to give */
+  gracious_assert(bwi_give(b, server_pid) == -1);
+  gracious_assert(bwi_revoke(b) == 0);
+  bwi_get_overhead(b, BWI_GIVE, &overhead);
+  gracious_assert(overhead.count == 1 && overhead.refused_count == 1);
+  bwi_get_overhead(b, BWI_REVOKE, &overhead);
+  gracious_assert(overhead.count == 0);
+
+  struct scheduler old_sched;
+  gracious_assert(sched_deadline_enter(to_utility_time_dyn(10, ms),
+                                       to_utility_time_dyn(100, ms),
+                                       &old_sched) == 0);
+
+  /* The server inherits the parameters of the caller */
+  struct sched_param_ex param_ex;
+  gracious_assert(bwi_give(b, server_pid) == 0);
+  gracious_assert(sched_getscheduler(server_pid) == SCHED_DEADLINE);
+  gracious_assert(sched_getparam_ex(server_pid, &param_ex) == 0);
+  gracious_assert(param_ex.sched_runtime.tv_nsec == 10000000);
+  gracious_assert(param_ex.sched_deadline.tv_nsec == 100000000);
+  gracious_assert(bwi_revoke(b) == 0);
+  gracious_assert(sched_getscheduler(server_pid) == SCHED_OTHER);
+
+  /* A server having a larger bandwidth keeps its own parameters */
+  memset(&param_ex, 0, sizeof(param_ex));
+  param_ex.sched_runtime.tv_nsec = 50000000;
+  param_ex.sched_deadline.tv_nsec = 100000000;
+  param_ex.sched_period.tv_nsec = 100000000;
+  gracious_assert(sched_setscheduler_ex(server_pid, &param_ex) == 0);
+  gracious_assert(bwi_give(b, server_pid) == 0);
+  gracious_assert(sched_getparam_ex(server_pid, &param_ex) == 0);
+  gracious_assert(param_ex.sched_runtime.tv_nsec == 50000000);
+  gracious_assert(bwi_revoke(b) == 0);
+  gracious_assert(sched_getscheduler(server_pid) == SCHED_DEADLINE);
+  gracious_assert(sched_getparam_ex(server_pid, &param_ex) == 0);
+  gracious_assert(param_ex.sched_runtime.tv_nsec == 50000000);
+
+  /* Overlapping givers restore the server only after the last one */
+  /** Small bandwidths are used because some kernels never release the
+      bandwidth of a server leaving SCHED_DEADLINE before it has run **/
+  gracious_assert(sched_setscheduler(server_pid, SCHED_OTHER,
+                                     &old_sched.param) == 0);
+  struct sched_param_ex caller_param_ex;
+  gracious_assert(sched_getparam_ex(0, &caller_param_ex) == 0);
+  bwi *b1, *b2;
+  gracious_assert(bwi_create(BWI_BACKEND_EMULATED, &b1) == 0);
+  gracious_assert(bwi_create(BWI_BACKEND_EMULATED, &b2) == 0);
+  int order;
+  for (order = 0; order < 2; order++) {
+    bwi *first = (order == 0 ? b1 : b2);
+    bwi *second = (order == 0 ? b2 : b1);
+
+    caller_param_ex.sched_runtime.tv_nsec = 2000000;
+    gracious_assert(sched_setscheduler_ex(0, &caller_param_ex) == 0);
+    gracious_assert(bwi_give(b1, server_pid) == 0);
+    caller_param_ex.sched_runtime.tv_nsec = 4000000;
+    gracious_assert(sched_setscheduler_ex(0, &caller_param_ex) == 0);
+    gracious_assert(bwi_give(b2, server_pid) == 0);
+    gracious_assert(sched_getparam_ex(server_pid, &param_ex) == 0);
+    gracious_assert(param_ex.sched_runtime.tv_nsec == 4000000);
+
+    /** The server keeps the largest bandwidth still given **/
+    gracious_assert(bwi_revoke(first) == 0);
+    gracious_assert(sched_getscheduler(server_pid) == SCHED_DEADLINE);
+    gracious_assert(sched_getparam_ex(server_pid, &param_ex) == 0);
+    gracious_assert(param_ex.sched_runtime.tv_nsec
+                    == (first == b1 ? 4000000 : 2000000));
+
+    gracious_assert(bwi_revoke(second) == 0);
+    gracious_assert(sched_getscheduler(server_pid) == SCHED_OTHER);
+  }
+  bwi_destroy(b1);
+  bwi_destroy(b2);
+  caller_param_ex.sched_runtime.tv_nsec = 10000000;
+  gracious_assert(sched_setscheduler_ex(0, &caller_param_ex) == 0);
+
+  /* A nonexistent server is an error */
+  gracious_assert(kill(server_pid, SIGKILL) == 0);
+  gracious_assert(waitpid(server_pid, NULL, 0) == server_pid);
+  server_pid = -1;
+  gracious_assert(bwi_give(b, 1 << 30) == -2);
+
+  gracious_assert(sched_deadline_leave(&old_sched) == 0);
+
+  bwi_get_overhead(b, BWI_GIVE, &overhead);
+  gracious_assert(overhead.count == 4 && overhead.refused_count == 1);
+  bwi_get_overhead(b, BWI_REVOKE, &overhead);
+  gracious_assert(overhead.count == 2);
+  bwi_destroy(b);
+
+  return EXIT_SUCCESS;
+
+} MAIN_UNIT_TEST_END
@@ -364,8 +364,7 @@ utility_time *cpu_busyloop_duration(const cpu_busyloop *obj)
 
 void destroy_cpu_busyloop(cpu_busyloop *arg)
 {
-  utility_time_gc(&arg->duration);
-  free(arg);
+  free(arg); /* The duration is embedded and needs no gc */
 }
 
 #define BILLION 1000000000.0
@@ -440,9 +439,9 @@ static int busyloop_search(double duration, double search_tolerance,
       return -3;
     }
 
-    log_verbose("Pass %d of %d: %lu loops -> %.9f s [%.9f s, %.9f s]\n",
-                nth_pass, search_max_passes, *loop_count, actual_duration,
-                duration - search_tolerance, duration + search_tolerance);
+    log_debug("Pass %d of %d: %lu loops -> %.9f s [%.9f s, %.9f s]\n",
+              nth_pass, search_max_passes, *loop_count, actual_duration,
+              duration - search_tolerance, duration + search_tolerance);
 
     if (nth_pass == search_max_passes) {
       /* Do not modify loop_count */
@@ -604,32 +603,38 @@ int create_cpu_busyloop(int which_cpu, const utility_time *duration,
 
 int enter_UP_mode_freq_max(cpu_freq_governor **default_gov)
 {
-  if (enter_UP_mode() == -1) {
-    log_error("Cannot enter UP mode");
+  return enter_UP_mode_freq_max_on_cpu(0, default_gov);
+}
+
+int enter_UP_mode_freq_max_on_cpu(int which_cpu,
+                                  cpu_freq_governor **default_gov)
+{
+  if (lock_me_to_cpu(which_cpu) == -1) {
+    log_error("Cannot enter UP mode on CPU %d", which_cpu);
     *default_gov = NULL;
     return -2;
   }
 
   unsigned long long *freqs;
   ssize_t freqs_len;
-  freqs = cpu_freq_available(0, &freqs_len);
+  freqs = cpu_freq_available(which_cpu, &freqs_len);
   if (freqs_len <= 0) {
-    log_error("CPU 0 has no available frequency for selection");
+    log_error("CPU %d has no available frequency for selection", which_cpu);
     *default_gov = NULL;
     return -2;
   }
   unsigned long long max_freq = freqs[0];
   free(freqs);
 
-  *default_gov = cpu_freq_get_governor(0);
+  *default_gov = cpu_freq_get_governor(which_cpu);
   if (*default_gov == NULL) {
-    log_error("Cannot obtain the current governor of CPU 0");
+    log_error("Cannot obtain the current governor of CPU %d", which_cpu);
     *default_gov = NULL;
     return -2;
   }
 
   int rc = -2;
-  switch (cpu_freq_set(0, max_freq)) {
+  switch (cpu_freq_set(which_cpu, max_freq)) {
   case -2:
     rc = -1;
     /* No break since this must jump to label error */
@@ -641,7 +646,8 @@ int enter_UP_mode_freq_max(cpu_freq_governor **default_gov)
 
  error:
   if (rc != -1 && cpu_freq_restore_governor(*default_gov) != 0) {
-    log_error("You have to restore the governor of CPU 0 yourself");
+    log_error("You have to restore the governor of CPU %d yourself",
+              which_cpu);
     *default_gov = NULL;
     return -2;
   }
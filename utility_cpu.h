@@ -180,10 +180,10 @@ extern "C" {
   static inline void busyloop(unsigned long loop_count)
   {
     unsigned long i = 0;
-    asm("0:\n\t"
-        "addl $1, %0\n\t"
-        "cmpl %1, %0\n\t"
-        "jne 0b" : : "r" (i), "r" (loop_count));
+    asm volatile("0:\n\t"
+                 "add $1, %0\n\t"
+                 "cmp %1, %0\n\t"
+                 "jne 0b" : "+r" (i) : "r" (loop_count));
   }
 
   /* III */
@@ -341,6 +341,20 @@ extern "C" {
    * the error.
    */
   int enter_UP_mode_freq_max(cpu_freq_governor **default_gov);
+
+  /**
+   * Like enter_UP_mode_freq_max() but lock the caller to the given
+   * CPU and set the frequency of that CPU to the maximum. This lets
+   * independent experiments run concurrently on disjoint CPUs.
+   *
+   * @param which_cpu the ID of the CPU between 0 and get_last_cpu(),
+   * inclusive.
+   * @param default_gov see enter_UP_mode_freq_max().
+   *
+   * @return see enter_UP_mode_freq_max().
+   */
+  int enter_UP_mode_freq_max_on_cpu(int which_cpu,
+                                    cpu_freq_governor **default_gov);
   /** @} End of collection of functions to use a CPU in a certain way */
 
   /* IV */
@@ -724,6 +724,48 @@ MAIN_UNIT_TEST_BEGIN("utility_cpu_test", "stderr", NULL, cleanup)
   free(buffer1);
   free(freqs);
 
+  /* Testcase 12: check enter_UP_mode_freq_max_on_cpu() */
+  child_pid = fork();
+  if (child_pid == 0) {
+    int last_cpu_id = get_last_cpu();
+    gracious_assert(last_cpu_id != -1);
+
+    gracious_assert(enter_UP_mode_freq_max_on_cpu(last_cpu_id, &used_gov)
+                    == 0);
+    used_gov_in_use = 1;
+
+    struct sigaction signal_handler_data = {
+      .sa_handler = signal_handler,
+    };
+    gracious_assert (sigaction(SIGINT, &signal_handler_data, NULL) == 0);
+
+    ssize_t freqs_len = 0;
+    unsigned long long *freqs = cpu_freq_available(last_cpu_id, &freqs_len);
+    gracious_assert(freqs_len >= 1);
+    unsigned long long max_freq = freqs[0];
+    free(freqs);
+
+    /* See Testcase 8 for the robustness of this check */
+    gracious_assert(cpu_freq_get(last_cpu_id) == max_freq);
+
+    while (!stop_infinite_loop) {
+      gracious_assert(sched_getcpu() == last_cpu_id);
+    }
+
+    gracious_assert(cpu_freq_restore_governor(used_gov) == 0);
+    used_gov_in_use = 0;
+
+    return EXIT_SUCCESS;
+  } else {
+    gracious_assert(child_pid != -1);
+
+    check_that_locking_indeed_happens();
+
+    gracious_assert(kill(child_pid, SIGINT) == 0);
+    child_pid = 0;
+    check_subprocess_exit_status(EXIT_SUCCESS);
+  }
+
   return EXIT_SUCCESS;
 
 } MAIN_UNIT_TEST_END
@@ -0,0 +1,625 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#define _GNU_SOURCE /* cpu_set_t, CPU_*, etc. */
+
+#include "utility_cpu_topology.h"
+
+#define DEFAULT_SYSFS_CPU_DIR "/sys/devices/system/cpu"
+#define PROC_MOUNTS_PATH "/proc/mounts"
+
+/* CPU list section */
+int cpu_list_parse(const char *list, cpu_set_t *result)
+{
+  const char *itr = list;
+
+  CPU_ZERO(result);
+
+  while (*itr != '\0') {
+    char *end;
+    long first = strtol(itr, &end, 10), last;
+    if (end == itr) {
+      return -1;
+    }
+    last = first;
+    if (*end == '-') {
+      itr = end + 1;
+      last = strtol(itr, &end, 10);
+      if (end == itr) {
+        return -1;
+      }
+    }
+    if (first < 0 || last >= CPU_SETSIZE || first > last) {
+      return -1;
+    }
+
+    for (; first <= last; first++) {
+      CPU_SET(first, result);
+    }
+
+    if (*end == ',') {
+      end++;
+      if (*end == '\0') {
+        return -1;
+      }
+    } else if (*end != '\0') {
+      return -1;
+    }
+    itr = end;
+  }
+
+  return 0;
+}
+
+int cpu_list_format(const cpu_set_t *cpus, char *buffer, size_t buffer_len)
+{
+  size_t len = 0;
+  int cpu = 0;
+
+  if (buffer_len == 0) {
+    return -1;
+  }
+  buffer[0] = '\0';
+
+  while (cpu < CPU_SETSIZE) {
+    int last;
+    int rc;
+
+    if (!CPU_ISSET(cpu, cpus)) {
+      cpu++;
+      continue;
+    }
+    for (last = cpu; last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, cpus);
+         last++) {
+    }
+
+    if (last == cpu) {
+      rc = snprintf(&buffer[len], buffer_len - len, "%s%d",
+                    len == 0 ? "" : ",", cpu);
+    } else {
+      rc = snprintf(&buffer[len], buffer_len - len, "%s%d-%d",
+                    len == 0 ? "" : ",", cpu, last);
+    }
+    if ((size_t) rc >= buffer_len - len) {
+      buffer[0] = '\0';
+      return -1;
+    }
+    len += rc;
+    cpu = last + 1;
+  }
+
+  return 0;
+}
+/* END: CPU list section */
+
+/* Topology section */
+struct cpu_topology
+{
+  cpu_set_t online;
+  int cpu_count; /* The last online CPU plus one */
+  /* The CPUs sharing the core, the last-level cache and the package
+     of a CPU indexed by the CPU */
+  cpu_set_t *core;
+  cpu_set_t *cache;
+  cpu_set_t *package;
+};
+
+/* Read the first line of the given file into the dynamically
+   allocated buffer returning 0 if successful, -1 if the file does
+   not exist, or -2 in case of error (logged) */
+static int read_first_line(const char *path, char **buffer)
+{
+  size_t buffer_len = 0;
+  FILE *file;
+  int rc;
+
+  *buffer = NULL;
+  if (access(path, F_OK) != 0) {
+    return -1;
+  }
+
+  file = utility_file_open_for_reading(path);
+  if (file == NULL) {
+    return -2;
+  }
+  rc = utility_file_readln(file, buffer, &buffer_len, 64);
+  utility_file_close(file, path);
+
+  if (rc != 0) {
+    if (*buffer != NULL) {
+      free(*buffer);
+      *buffer = NULL;
+    }
+    if (rc == -1) {
+      log_error("%s is empty", path);
+    }
+    return -2;
+  }
+
+  return 0;
+}
+
+/* Read the CPU list in the given file. If the file does not exist,
+   the list is only the given CPU. Return 0 if successful or -1 in
+   case of error (logged). */
+static int read_cpu_list(const char *path, int cpu, cpu_set_t *result)
+{
+  char *buffer;
+
+  switch (read_first_line(path, &buffer)) {
+  case 0:
+    break;
+  case -1:
+    CPU_ZERO(result);
+    CPU_SET(cpu, result);
+    return 0;
+  default:
+    return -1;
+  }
+
+  if (cpu_list_parse(buffer, result) != 0) {
+    log_error("%s has an invalid CPU list '%s'", path, buffer);
+    free(buffer);
+    return -1;
+  }
+  free(buffer);
+
+  return 0;
+}
+
+/* Read the CPUs sharing the last-level data cache of the given CPU,
+   which is that of the highest level that is not an instruction
+   cache. Return 0 if successful or -1 in case of error (logged). */
+static int read_llc(const char *sysfs_cpu_dir, int cpu, cpu_set_t *result)
+{
+  char path[1024];
+  int best_level = 0;
+  int i;
+
+  CPU_ZERO(result);
+  CPU_SET(cpu, result);
+
+  for (i = 0; ; i++) {
+    char *level_str, *type_str;
+    int level;
+
+    snprintf(path, sizeof(path), "%s/cpu%d/cache/index%d/level",
+             sysfs_cpu_dir, cpu, i);
+    switch (read_first_line(path, &level_str)) {
+    case 0:
+      break;
+    case -1:
+      return 0;
+    default:
+      return -1;
+    }
+    level = atoi(level_str);
+    free(level_str);
+
+    snprintf(path, sizeof(path), "%s/cpu%d/cache/index%d/type",
+             sysfs_cpu_dir, cpu, i);
+    if (read_first_line(path, &type_str) != 0) {
+      log_error("Cannot read %s", path);
+      return -1;
+    }
+    if (strcmp(type_str, "Instruction") == 0 || level <= best_level) {
+      free(type_str);
+      continue;
+    }
+    free(type_str);
+
+    snprintf(path, sizeof(path), "%s/cpu%d/cache/index%d/shared_cpu_list",
+             sysfs_cpu_dir, cpu, i);
+    if (read_cpu_list(path, cpu, result) != 0) {
+      return -1;
+    }
+    best_level = level;
+  }
+}
+
+int cpu_topology_load(const char *sysfs_cpu_dir, cpu_topology **result)
+{
+  cpu_topology *topo;
+  char path[1024];
+  char *online;
+  int cpu;
+
+  *result = NULL;
+  if (sysfs_cpu_dir == NULL) {
+    sysfs_cpu_dir = DEFAULT_SYSFS_CPU_DIR;
+  }
+
+  topo = calloc(1, sizeof(*topo));
+  if (topo == NULL) {
+    return -2;
+  }
+
+  snprintf(path, sizeof(path), "%s/online", sysfs_cpu_dir);
+  if (read_first_line(path, &online) != 0) {
+    log_error("Cannot read %s", path);
+    free(topo);
+    return -1;
+  }
+  if (cpu_list_parse(online, &topo->online) != 0
+      || CPU_COUNT(&topo->online) == 0) {
+    log_error("%s has an invalid CPU list '%s'", path, online);
+    free(online);
+    free(topo);
+    return -1;
+  }
+  free(online);
+
+  for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (CPU_ISSET(cpu, &topo->online)) {
+      topo->cpu_count = cpu + 1;
+    }
+  }
+
+  topo->core = calloc(topo->cpu_count, sizeof(*topo->core));
+  topo->cache = calloc(topo->cpu_count, sizeof(*topo->cache));
+  topo->package = calloc(topo->cpu_count, sizeof(*topo->package));
+  if (topo->core == NULL || topo->cache == NULL || topo->package == NULL) {
+    cpu_topology_destroy(topo);
+    return -2;
+  }
+
+  for (cpu = 0; cpu < topo->cpu_count; cpu++) {
+    if (!CPU_ISSET(cpu, &topo->online)) {
+      continue;
+    }
+
+    snprintf(path, sizeof(path), "%s/cpu%d/topology/core_cpus_list",
+             sysfs_cpu_dir, cpu);
+    if (access(path, F_OK) != 0) {
+      /* Kernels older than 5.4 */
+      snprintf(path, sizeof(path), "%s/cpu%d/topology/thread_siblings_list",
+               sysfs_cpu_dir, cpu);
+    }
+    if (read_cpu_list(path, cpu, &topo->core[cpu]) != 0) {
+      goto error;
+    }
+
+    snprintf(path, sizeof(path), "%s/cpu%d/topology/package_cpus_list",
+             sysfs_cpu_dir, cpu);
+    if (access(path, F_OK) != 0) {
+      /* Kernels older than 5.4 */
+      snprintf(path, sizeof(path), "%s/cpu%d/topology/core_siblings_list",
+               sysfs_cpu_dir, cpu);
+    }
+    if (read_cpu_list(path, cpu, &topo->package[cpu]) != 0) {
+      goto error;
+    }
+
+    if (read_llc(sysfs_cpu_dir, cpu, &topo->cache[cpu]) != 0) {
+      goto error;
+    }
+  }
+
+  *result = topo;
+  return 0;
+
+ error:
+  cpu_topology_destroy(topo);
+  return -1;
+}
+
+void cpu_topology_destroy(cpu_topology *topo)
+{
+  if (topo->core != NULL) {
+    free(topo->core);
+  }
+  if (topo->cache != NULL) {
+    free(topo->cache);
+  }
+  if (topo->package != NULL) {
+    free(topo->package);
+  }
+  free(topo);
+}
+
+const cpu_set_t *cpu_topology_online(const cpu_topology *topo)
+{
+  return &topo->online;
+}
+
+int cpu_topology_clusters(const cpu_topology *topo,
+                          enum cpu_topology_level level,
+                          const cpu_set_t *within,
+                          cpu_set_t **clusters, unsigned *cluster_count)
+{
+  cpu_set_t remaining;
+  unsigned count = 0;
+  int cpu;
+
+  *clusters = NULL;
+  *cluster_count = 0;
+
+  CPU_AND(&remaining, within, &topo->online);
+  if (CPU_COUNT(&remaining) == 0) {
+    return -1;
+  }
+
+  /* There are at most as many clusters as CPUs */
+  *clusters = malloc(sizeof(**clusters) * CPU_COUNT(&remaining));
+  if (*clusters == NULL) {
+    return -2;
+  }
+
+  for (cpu = 0; cpu < topo->cpu_count; cpu++) {
+    cpu_set_t *cluster = &(*clusters)[count];
+
+    if (!CPU_ISSET(cpu, &remaining)) {
+      continue;
+    }
+
+    switch (level) {
+    case CPU_TOPOLOGY_CPU:
+      CPU_ZERO(cluster);
+      CPU_SET(cpu, cluster);
+      break;
+    case CPU_TOPOLOGY_CORE:
+      CPU_AND(cluster, &remaining, &topo->core[cpu]);
+      break;
+    case CPU_TOPOLOGY_CACHE:
+      CPU_AND(cluster, &remaining, &topo->cache[cpu]);
+      break;
+    case CPU_TOPOLOGY_PACKAGE:
+      CPU_AND(cluster, &remaining, &topo->package[cpu]);
+      break;
+    default:
+      *cluster = remaining;
+      break;
+    }
+    /* The sysfs lists of a CPU include the CPU itself but be safe */
+    CPU_SET(cpu, cluster);
+
+    CPU_XOR(&remaining, &remaining, cluster);
+    count++;
+  }
+
+  *cluster_count = count;
+  return 0;
+}
+/* END: Topology section */
+
+/* Cpuset partition section */
+struct cpuset_partition
+{
+  char *path; /* The directory of the cgroup */
+};
+
+/* Write the given string to the given cgroup file returning 0 if
+   successful, -1 if the caller has insufficient privilege, or -2
+   otherwise (logged) */
+static int write_cgroup_file(const char *path, const char *str)
+{
+  FILE *file = fopen(path, "w");
+  int rc = 0;
+
+  if (file == NULL) {
+    if (errno == EACCES || errno == EPERM) {
+      return -1;
+    }
+    log_syserror("Cannot open %s for writing", path);
+    return -2;
+  }
+
+  /* The kernel reports an invalid value when the buffer is flushed */
+  if (fputs(str, file) == EOF || fflush(file) != 0) {
+    if (errno == EACCES || errno == EPERM) {
+      rc = -1;
+    } else {
+      log_syserror("Cannot write '%s' to %s", str, path);
+      rc = -2;
+    }
+  }
+  if (fclose(file) != 0 && rc == 0) {
+    log_syserror("Cannot write '%s' to %s", str, path);
+    rc = -2;
+  }
+
+  return rc;
+}
+
+/* Find the mount point of the cgroup v2 hierarchy returning it as a
+   dynamically allocated string or NULL if there is none or in case
+   of error (logged) */
+static char *find_cgroup2_mount(void)
+{
+  FILE *mounts = utility_file_open_for_reading(PROC_MOUNTS_PATH);
+  char *buffer = NULL, *result = NULL;
+  size_t buffer_len = 0;
+
+  if (mounts == NULL) {
+    return NULL;
+  }
+
+  while (result == NULL
+         && utility_file_readln(mounts, &buffer, &buffer_len, 256) == 0) {
+    char *mount_point = strchr(buffer, ' '), *type;
+
+    if (mount_point == NULL) {
+      continue;
+    }
+    mount_point++;
+    type = strchr(mount_point, ' ');
+    if (type == NULL) {
+      continue;
+    }
+    *type++ = '\0';
+    if (strncmp(type, "cgroup2 ", sizeof("cgroup2 ") - 1) == 0) {
+      result = strdup(mount_point);
+      if (result == NULL) {
+        log_error("Not enough memory to allocate the cgroup2 mount point");
+        break;
+      }
+    }
+  }
+
+  if (buffer != NULL) {
+    free(buffer);
+  }
+  utility_file_close(mounts, PROC_MOUNTS_PATH);
+
+  return result;
+}
+
+int cpuset_partition_create(const char *name, const cpu_set_t *cpus,
+                            cpuset_partition **result)
+{
+  cpuset_partition *part = NULL;
+  char *mount_point = NULL, *buffer = NULL;
+  char path[1024], cpu_list[1024];
+  int rc;
+
+  *result = NULL;
+
+  if (cpu_list_format(cpus, cpu_list, sizeof(cpu_list)) != 0
+      || cpu_list[0] == '\0') {
+    log_error("Invalid CPUs for cpuset partition %s", name);
+    return -2;
+  }
+
+  /* Find the hierarchy having the cpuset controller */
+  mount_point = find_cgroup2_mount();
+  if (mount_point == NULL) {
+    return -3;
+  }
+
+  snprintf(path, sizeof(path), "%s/cgroup.controllers", mount_point);
+  if (read_first_line(path, &buffer) != 0) {
+    rc = -3;
+    goto error;
+  }
+  {
+    char *saveptr;
+    char *controller = strtok_r(buffer, " ", &saveptr);
+    while (controller != NULL && strcmp(controller, "cpuset") != 0) {
+      controller = strtok_r(NULL, " ", &saveptr);
+    }
+    if (controller == NULL) {
+      rc = -3;
+      goto error;
+    }
+  }
+  /* END: Find the hierarchy having the cpuset controller */
+
+  snprintf(path, sizeof(path), "%s/cgroup.subtree_control", mount_point);
+  rc = write_cgroup_file(path, "+cpuset");
+  if (rc != 0) {
+    goto error;
+  }
+
+  part = malloc(sizeof(*part));
+  if (part == NULL) {
+    log_error("Not enough memory to create cpuset partition %s", name);
+    rc = -2;
+    goto error;
+  }
+  part->path = malloc(strlen(mount_point) + strlen(name) + 2);
+  if (part->path == NULL) {
+    log_error("Not enough memory to create cpuset partition %s", name);
+    free(part);
+    part = NULL;
+    rc = -2;
+    goto error;
+  }
+  sprintf(part->path, "%s/%s", mount_point, name);
+
+  if (mkdir(part->path, 0755) != 0) {
+    if (errno == EACCES || errno == EPERM) {
+      rc = -1;
+    } else {
+      log_syserror("Cannot create cgroup %s", part->path);
+      rc = -2;
+    }
+    free(part->path);
+    free(part);
+    part = NULL;
+    goto error;
+  }
+
+  snprintf(path, sizeof(path), "%s/cpuset.cpus", part->path);
+  rc = write_cgroup_file(path, cpu_list);
+  if (rc != 0) {
+    goto error;
+  }
+
+  snprintf(path, sizeof(path), "%s/cpuset.cpus.partition", part->path);
+  rc = write_cgroup_file(path, "root");
+  if (rc != 0) {
+    goto error;
+  }
+
+  /* An invalid partition is only reported when read back */
+  free(buffer);
+  if (read_first_line(path, &buffer) != 0) {
+    log_error("Cannot read %s", path);
+    rc = -2;
+    goto error;
+  }
+  if (strcmp(buffer, "root") != 0) {
+    log_error("The kernel rejects cpuset partition %s of CPUs %s: %s",
+              name, cpu_list, buffer);
+    rc = -2;
+    goto error;
+  }
+
+  free(buffer);
+  free(mount_point);
+  *result = part;
+  return 0;
+
+ error:
+  if (part != NULL) {
+    cpuset_partition_destroy(part);
+  }
+  if (buffer != NULL) {
+    free(buffer);
+  }
+  free(mount_point);
+  return rc;
+}
+
+int cpuset_partition_join(const cpuset_partition *part)
+{
+  char path[1024], pid[32];
+
+  snprintf(path, sizeof(path), "%s/cgroup.procs", part->path);
+  snprintf(pid, sizeof(pid), "%d", (int) getpid());
+  if (write_cgroup_file(path, pid) != 0) {
+    log_error("Cannot move process %s into %s", pid, part->path);
+    return -1;
+  }
+
+  return 0;
+}
+
+int cpuset_partition_destroy(cpuset_partition *part)
+{
+  int rc = 0;
+
+  if (rmdir(part->path) != 0) {
+    log_syserror("Cannot remove cgroup %s", part->path);
+    rc = -1;
+  }
+  free(part->path);
+  free(part);
+
+  return rc;
+}
+/* END: Cpuset partition section */
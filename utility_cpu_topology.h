@@ -0,0 +1,212 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+/**
+ * @file utility_cpu_topology.h
+ * @brief The CPU topology of the system and the CPU sets built from
+ * it to schedule threads on a group of CPUs.
+ *
+ * The topology is read from the sysfs directory of the CPUs so that
+ * the online CPUs can be grouped into clusters of CPUs sharing a
+ * core (SMT siblings), a last-level cache or a package. A cluster
+ * can then be given to a group of threads as their affinity mask.
+ *
+ * A SCHED_DEADLINE thread, however, can only have an affinity mask
+ * that spans its whole root domain, which by default includes all
+ * online CPUs. To schedule SCHED_DEADLINE threads on a cluster, the
+ * cluster is made a root domain of its own by creating a cgroup v2
+ * cpuset partition (c.f., cpuset_partition_create()) that the
+ * process of the threads joins before entering SCHED_DEADLINE.
+ *
+ * All functions of this file need _GNU_SOURCE to be defined before
+ * the first include of the caller for the type cpu_set_t.
+ *
+ * @author Tadeus Prastowo <eus@member.fsf.org>
+ */
+
+#ifndef UTILITY_CPU_TOPOLOGY
+#define UTILITY_CPU_TOPOLOGY
+
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "utility_log.h"
+#include "utility_file.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /* I */
+  /**
+   * @name Collection of functions to deal with CPU lists.
+   * @{
+   */
+
+  /**
+   * Parse a CPU list like "0,2-5" as found in sysfs.
+   *
+   * @param list the comma-separated list of CPUs and CPU ranges.
+   * @param result a pointer to the CPU set to store the parsed list.
+   *
+   * @return zero if successful or -1 if the list is invalid or names
+   * a CPU not less than CPU_SETSIZE.
+   */
+  int cpu_list_parse(const char *list, cpu_set_t *result);
+
+  /**
+   * Format the given CPU set as a CPU list like "0,2-5" that can be
+   * parsed using cpu_list_parse().
+   *
+   * @return zero if successful or -1 if the buffer is too small, in
+   * which case the buffer contains an empty string.
+   */
+  int cpu_list_format(const cpu_set_t *cpus, char *buffer, size_t buffer_len);
+  /** @} End of collection of functions to deal with CPU lists */
+
+  /* II */
+  /**
+   * @name Collection of functions to deal with the CPU topology.
+   * @{
+   */
+
+  /** The CPU topology of the system. */
+  typedef struct cpu_topology cpu_topology;
+
+  /** The levels at which the CPUs are grouped into clusters. */
+  enum cpu_topology_level
+  {
+    CPU_TOPOLOGY_CPU, /**< Every CPU is a cluster of its own. */
+    CPU_TOPOLOGY_CORE, /**< The SMT siblings of a core. */
+    CPU_TOPOLOGY_CACHE, /**< The CPUs sharing a last-level cache. */
+    CPU_TOPOLOGY_PACKAGE, /**< The CPUs of a physical package. */
+    CPU_TOPOLOGY_SYSTEM, /**< All CPUs form one cluster. */
+  };
+
+  /**
+   * Read the topology of the online CPUs.
+   *
+   * @param sysfs_cpu_dir the directory having the online file and
+   * the cpuN subdirectories or NULL for "/sys/devices/system/cpu".
+   * If a CPU has no cache or topology information, it is assumed to
+   * have its own core, cache or package, respectively.
+   * @param result a pointer to the location to store the topology,
+   * which must be destroyed using cpu_topology_destroy(). The
+   * location is set to NULL if the return value is not zero.
+   *
+   * @return zero if successful, -1 if the topology cannot be read
+   * (the error is @ref utility_log.h "logged"), or -2 if there is
+   * insufficient memory.
+   */
+  int cpu_topology_load(const char *sysfs_cpu_dir, cpu_topology **result);
+
+  /**
+   * Destroy the given topology.
+   */
+  void cpu_topology_destroy(cpu_topology *topo);
+
+  /**
+   * @return a pointer to the set of the online CPUs that is valid
+   * until the topology is destroyed.
+   */
+  const cpu_set_t *cpu_topology_online(const cpu_topology *topo);
+
+  /**
+   * Group the online CPUs of the given CPU set into clusters at the
+   * given level. Two CPUs are in the same cluster if they share the
+   * core, the last-level cache or the package of the level, and
+   * the clusters are ordered by their lowest CPU.
+   *
+   * @param within the CPUs to group, which are intersected with the
+   * online CPUs.
+   * @param clusters a pointer to the location to store the
+   * dynamically allocated array of clusters, which the caller must
+   * free. The location is set to NULL if the return value is not
+   * zero.
+   * @param cluster_count a pointer to the location to store the
+   * number of clusters.
+   *
+   * @return zero if successful, -1 if no given CPU is online, or -2
+   * if there is insufficient memory.
+   */
+  int cpu_topology_clusters(const cpu_topology *topo,
+                            enum cpu_topology_level level,
+                            const cpu_set_t *within,
+                            cpu_set_t **clusters, unsigned *cluster_count);
+  /** @} End of collection of functions to deal with the CPU topology */
+
+  /* III */
+  /**
+   * @name Collection of functions to deal with cpuset partitions.
+   * @{
+   */
+
+  /** A cgroup v2 cpuset partition that forms a root domain. */
+  typedef struct cpuset_partition cpuset_partition;
+
+  /**
+   * Create a cgroup v2 cpuset partition of the given CPUs directly
+   * below the root cgroup. The CPUs are taken away from the root
+   * cgroup and the other partitions, and therefore, they must not be
+   * all the CPUs of the root cgroup nor belong to another partition.
+   *
+   * @param name the name of the cgroup to create.
+   * @param cpus the CPUs of the partition.
+   * @param result a pointer to the location to store the partition,
+   * which must be destroyed using cpuset_partition_destroy(). The
+   * location is set to NULL if the return value is not zero.
+   *
+   * @return zero if successful, -1 if the caller has insufficient
+   * privilege, -2 in case of hard error that requires the
+   * investigation of the output of the logging facility to fix the
+   * error (e.g., the kernel rejects the partition), or -3 if no
+   * cgroup v2 hierarchy has the cpuset controller.
+   */
+  int cpuset_partition_create(const char *name, const cpu_set_t *cpus,
+                              cpuset_partition **result);
+
+  /**
+   * Move the calling process with all of its threads into the given
+   * partition.
+   *
+   * @return zero if successful or -1 in case of hard error that
+   * requires the investigation of the output of the logging facility
+   * to fix the error.
+   */
+  int cpuset_partition_join(const cpuset_partition *part);
+
+  /**
+   * Remove the given partition returning its CPUs to the root
+   * cgroup. No process must be in the partition anymore.
+   *
+   * @return zero if successful or -1 if the cgroup cannot be removed
+   * (the error is @ref utility_log.h "logged"). Either way, the
+   * partition object is freed.
+   */
+  int cpuset_partition_destroy(cpuset_partition *part);
+  /** @} End of collection of functions to deal with cpuset partitions */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UTILITY_CPU_TOPOLOGY */
@@ -0,0 +1,232 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#define _GNU_SOURCE /* cpu_set_t, CPU_*, mkdtemp() */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "utility_testcase.h"
+#include "utility_log.h"
+#include "utility_cpu_topology.h"
+
+static char sysfs_dir[] = "/tmp/utility_cpu_topology_test.XXXXXX";
+
+static void remove_sysfs_dir(void)
+{
+  char cmd[sizeof(sysfs_dir) + 16];
+
+  snprintf(cmd, sizeof(cmd), "rm -rf %s", sysfs_dir);
+  if (system(cmd) != 0) {
+    log_error("Cannot remove %s", sysfs_dir);
+  }
+}
+
+static void write_file(const char *dir, const char *name, const char *content)
+{
+  char path[1024];
+  FILE *file;
+
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+  file = fopen(path, "w");
+  gracious_assert(file != NULL);
+  fprintf(file, "%s\n", content);
+  gracious_assert(fclose(file) == 0);
+}
+
+static void make_dir(const char *path)
+{
+  gracious_assert(mkdir(path, 0755) == 0);
+}
+
+static void add_cache(const char *cpu_dir, int idx, const char *level,
+                      const char *type, const char *shared_cpu_list)
+{
+  char path[1024];
+
+  snprintf(path, sizeof(path), "%s/cache/index%d", cpu_dir, idx);
+  make_dir(path);
+  write_file(path, "level", level);
+  write_file(path, "type", type);
+  write_file(path, "shared_cpu_list", shared_cpu_list);
+}
+
+/* A package of CPUs 0-7 having an L3 cache for each half and an SMT
+   core for each pair of CPUs, of which CPU 7 is offline. CPU 6 has
+   the sysfs files of kernels older than 5.4. */
+static void make_sysfs(void)
+{
+  static const char *core[] = {"0-1", "0-1", "2-3", "2-3", "4-5", "4-5", "6"};
+  static const char *l3[] = {"0-3", "0-3", "0-3", "0-3", "4-6", "4-6", "4-6"};
+  int cpu;
+
+  gracious_assert(mkdtemp(sysfs_dir) != NULL);
+  write_file(sysfs_dir, "online", "0-6");
+
+  for (cpu = 0; cpu < 7; cpu++) {
+    char cpu_dir[256], path[512];
+
+    snprintf(cpu_dir, sizeof(cpu_dir), "%s/cpu%d", sysfs_dir, cpu);
+    make_dir(cpu_dir);
+    snprintf(path, sizeof(path), "%s/topology", cpu_dir);
+    make_dir(path);
+    if (cpu == 6) {
+      write_file(path, "thread_siblings_list", core[cpu]);
+      write_file(path, "core_siblings_list", "0-6");
+    } else {
+      write_file(path, "core_cpus_list", core[cpu]);
+      write_file(path, "package_cpus_list", "0-6");
+    }
+
+    snprintf(path, sizeof(path), "%s/cache", cpu_dir);
+    make_dir(path);
+    add_cache(cpu_dir, 0, "1", "Data", core[cpu]);
+    add_cache(cpu_dir, 1, "1", "Instruction", core[cpu]);
+    add_cache(cpu_dir, 2, "2", "Unified", core[cpu]);
+    add_cache(cpu_dir, 3, "3", "Unified", l3[cpu]);
+  }
+}
+
+static void check_clusters(const cpu_topology *topo,
+                           enum cpu_topology_level level,
+                           const char *within_list,
+                           const char *expected)
+{
+  cpu_set_t within, *clusters;
+  unsigned cluster_count, i;
+  char result[256] = "", buffer[64];
+
+  gracious_assert(cpu_list_parse(within_list, &within) == 0);
+  gracious_assert(cpu_topology_clusters(topo, level, &within, &clusters,
+                                        &cluster_count) == 0);
+  for (i = 0; i < cluster_count; i++) {
+    gracious_assert(cpu_list_format(&clusters[i], buffer, sizeof(buffer))
+                    == 0);
+    if (i != 0) {
+      strcat(result, " ");
+    }
+    strcat(result, buffer);
+  }
+  free(clusters);
+
+  gracious_assert_msg(strcmp(result, expected) == 0,
+                      "Level %d within %s gives '%s' instead of '%s'",
+                      level, within_list, result, expected);
+}
+
+MAIN_UNIT_TEST_BEGIN("utility_cpu_topology_test", "stderr", NULL,
+                     remove_sysfs_dir)
+{
+  cpu_topology *topo;
+  cpu_set_t cpus;
+  char buffer[64];
+
+  /* Testcase 1: CPU lists */
+  gracious_assert(cpu_list_parse("0,2-5,7", &cpus) == 0);
+  gracious_assert(CPU_COUNT(&cpus) == 6);
+  gracious_assert(CPU_ISSET(0, &cpus) && !CPU_ISSET(1, &cpus)
+                  && CPU_ISSET(5, &cpus) && !CPU_ISSET(6, &cpus));
+  gracious_assert(cpu_list_format(&cpus, buffer, sizeof(buffer)) == 0);
+  gracious_assert(strcmp(buffer, "0,2-5,7") == 0);
+  gracious_assert(cpu_list_format(&cpus, buffer, 7) == -1);
+  gracious_assert(buffer[0] == '\0');
+
+  gracious_assert(cpu_list_parse("3-1", &cpus) == -1);
+  gracious_assert(cpu_list_parse("1,", &cpus) == -1);
+  gracious_assert(cpu_list_parse("1-", &cpus) == -1);
+  gracious_assert(cpu_list_parse("a", &cpus) == -1);
+  gracious_assert(cpu_list_parse("1 2", &cpus) == -1);
+  gracious_assert(cpu_list_parse("-1", &cpus) == -1);
+  gracious_assert(cpu_list_parse("100000", &cpus) == -1);
+  gracious_assert(cpu_list_parse("", &cpus) == 0);
+  gracious_assert(CPU_COUNT(&cpus) == 0);
+
+  /* Testcase 2: clusters of a fake topology */
+  make_sysfs();
+  gracious_assert(cpu_topology_load(sysfs_dir, &topo) == 0);
+  gracious_assert(cpu_list_format(cpu_topology_online(topo), buffer,
+                                  sizeof(buffer)) == 0);
+  gracious_assert(strcmp(buffer, "0-6") == 0);
+
+  check_clusters(topo, CPU_TOPOLOGY_CPU, "0-7", "0 1 2 3 4 5 6");
+  check_clusters(topo, CPU_TOPOLOGY_CORE, "0-7", "0-1 2-3 4-5 6");
+  check_clusters(topo, CPU_TOPOLOGY_CACHE, "0-7", "0-3 4-6");
+  check_clusters(topo, CPU_TOPOLOGY_PACKAGE, "0-7", "0-6");
+  check_clusters(topo, CPU_TOPOLOGY_SYSTEM, "0-7", "0-6");
+
+  check_clusters(topo, CPU_TOPOLOGY_CORE, "1-2,5", "1 2 5");
+  check_clusters(topo, CPU_TOPOLOGY_CACHE, "1-2,5", "1-2 5");
+  check_clusters(topo, CPU_TOPOLOGY_CACHE, "3-6", "3 4-6");
+  check_clusters(topo, CPU_TOPOLOGY_SYSTEM, "1-2,5", "1-2,5");
+
+  {
+    cpu_set_t *clusters;
+    unsigned cluster_count;
+
+    gracious_assert(cpu_list_parse("7", &cpus) == 0);
+    gracious_assert(cpu_topology_clusters(topo, CPU_TOPOLOGY_SYSTEM, &cpus,
+                                          &clusters, &cluster_count) == -1);
+    gracious_assert(clusters == NULL && cluster_count == 0);
+  }
+  cpu_topology_destroy(topo);
+
+  /* Testcase 3: missing and invalid information */
+  {
+    char path[1024];
+
+    /* CPU 0 falls back to its L2 cache */
+    snprintf(path, sizeof(path), "rm -r %s/cpu0/cache/index3", sysfs_dir);
+    gracious_assert(system(path) == 0);
+    gracious_assert(cpu_topology_load(sysfs_dir, &topo) == 0);
+    check_clusters(topo, CPU_TOPOLOGY_CACHE, "0-3", "0-1 2-3");
+    cpu_topology_destroy(topo);
+
+    write_file(sysfs_dir, "online", "0-x");
+    gracious_assert(cpu_topology_load(sysfs_dir, &topo) == -1);
+    gracious_assert(topo == NULL);
+
+    snprintf(path, sizeof(path), "%s/online", sysfs_dir);
+    gracious_assert(unlink(path) == 0);
+    gracious_assert(cpu_topology_load(sysfs_dir, &topo) == -1);
+    gracious_assert(topo == NULL);
+  }
+
+  /* Testcase 4: the topology of this machine */
+  {
+    cpu_set_t *clusters;
+    unsigned cluster_count;
+
+    gracious_assert(cpu_topology_load(NULL, &topo) == 0);
+    gracious_assert(CPU_COUNT(cpu_topology_online(topo)) > 0);
+    gracious_assert(cpu_topology_clusters(topo, CPU_TOPOLOGY_SYSTEM,
+                                          cpu_topology_online(topo),
+                                          &clusters, &cluster_count) == 0);
+    gracious_assert(cluster_count == 1);
+    gracious_assert(CPU_EQUAL(&clusters[0], cpu_topology_online(topo)));
+    free(clusters);
+
+    gracious_assert(cpu_topology_clusters(topo, CPU_TOPOLOGY_CPU,
+                                          cpu_topology_online(topo),
+                                          &clusters, &cluster_count) == 0);
+    gracious_assert(cluster_count == CPU_COUNT(cpu_topology_online(topo)));
+    free(clusters);
+    cpu_topology_destroy(topo);
+  }
+
+} MAIN_UNIT_TEST_END
@@ -30,9 +30,21 @@
 #include "utility_log.h"
 #include "utility_cpu.h"
 
+/**
+ * The name of the environment variable that, when set, holds the ID
+ * of the CPU that MAIN_BEGIN() uses instead of CPU 0. A driver
+ * running several independent experiments concurrently sets this
+ * variable to give each experiment its own CPU; all programs forked
+ * by an experiment inherit the variable and so run on the same CPU.
+ */
+#define EXPERIMENT_CPU_ENV "EXPERIMENT_CPU"
+
 /**
  * Conveniently begin the main function of an experimentation
- * utilizing only one CPU core with the maximum frequency.
+ * utilizing only one CPU core with the maximum frequency. The CPU is
+ * CPU 0 unless the environment variable named by EXPERIMENT_CPU_ENV
+ * says otherwise. Either way, the ID of the CPU is available in the
+ * variable experiment_cpu of type int.
  *
  * @param experiment_name the name of the experimentation program.
  * @param log_stream_path the path to the file used for logging. To
@@ -47,6 +59,7 @@
  */
 #define MAIN_BEGIN(experiment_name, log_stream_path, write_mode)        \
   static cpu_freq_governor *default_gov = NULL;                         \
+  static int experiment_cpu = 0;                                        \
   static void cleanup_restore_gov(void)                                 \
   {                                                                     \
     if (default_gov != NULL) {                                          \
@@ -82,7 +95,18 @@
       fatal_syserror("Cannot start experiment (fail to register"        \
                      " cleanup_restore_gov at exit)\n");                \
     }                                                                   \
-    if (enter_UP_mode_freq_max(&default_gov) != 0) {                    \
+    if (getenv(EXPERIMENT_CPU_ENV) != NULL) {                           \
+      char *experiment_cpu_end;                                         \
+      experiment_cpu = strtol(getenv(EXPERIMENT_CPU_ENV),               \
+                              &experiment_cpu_end, 10);                 \
+      if (*experiment_cpu_end != '\0' || experiment_cpu < 0             \
+          || experiment_cpu > get_last_cpu()) {                         \
+        fatal_error("Cannot start experiment (%s='%s' is not a CPU)",   \
+                    EXPERIMENT_CPU_ENV, getenv(EXPERIMENT_CPU_ENV));    \
+      }                                                                 \
+    }                                                                   \
+    if (enter_UP_mode_freq_max_on_cpu(experiment_cpu, &default_gov)     \
+        != 0) {                                                         \
       fatal_syserror("Cannot enter UP mode with maximum frequency");    \
     }
 
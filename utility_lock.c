@@ -0,0 +1,508 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#define _GNU_SOURCE /* For PTHREAD_PRIO_INHERIT and friends */
+
+#include "utility_lock.h"
+
+/* The state of a lockfree_object packs the index of the buffer
+   holding the current value with a version that changes at every
+   published update so that a stale state is never mistaken for the
+   current one */
+#define BUFFER_INDEX_BITS 16
+#define BUFFER_INDEX_MASK ((1ULL << BUFFER_INDEX_BITS) - 1)
+
+struct lock_samples
+{
+  lock_sample *samples;
+  unsigned long capacity;
+  unsigned long count; /* Including the lost ones */
+};
+
+struct rt_lock
+{
+  enum rt_lock_protocol protocol;
+  int ceiling;
+  pthread_mutex_t mutex; /* Unless the protocol is RT_LOCK_SRP */
+  int srp_held;
+  int srp_saved_prio; /* The priority of the holder before acquiring */
+  struct timespec t_request; /* When the holder requests the lock */
+  struct timespec t_entry; /* When the holder enters */
+  struct lock_samples samples;
+};
+
+struct lockfree_object
+{
+  size_t size;
+  char *buffers; /* updater_count + 1 buffers of size bytes each */
+  uint64_t state; /* (version << BUFFER_INDEX_BITS) | current buffer */
+  lockfree_queue *free_buffers;
+  struct lock_samples samples;
+};
+
+static const char *const protocol_names[] = {
+  "none", "inherit", "protect", "srp",
+};
+
+static int samples_init(struct lock_samples *s, unsigned long capacity)
+{
+  s->capacity = capacity;
+  s->count = 0;
+  s->samples = NULL;
+  if (capacity == 0) {
+    return 0;
+  }
+
+  s->samples = malloc(capacity * sizeof(*s->samples));
+  if (s->samples == NULL) {
+    log_error("Not enough memory for %lu lock samples", capacity);
+    return -2;
+  }
+  /* Touch the samples to avoid page faults while recording */
+  memset(s->samples, 0, capacity * sizeof(*s->samples));
+
+  return 0;
+}
+
+static inline unsigned long long elapsed_ns(const struct timespec *t_begin,
+                                            const struct timespec *t_end)
+{
+  return ((t_end->tv_sec - t_begin->tv_sec) * 1000000000ULL
+          + t_end->tv_nsec - t_begin->tv_nsec);
+}
+
+static void samples_record(struct lock_samples *s,
+                           const struct timespec *t_request,
+                           const struct timespec *t_entry,
+                           const struct timespec *t_exit)
+{
+  unsigned long nth = __atomic_fetch_add(&s->count, 1, __ATOMIC_RELAXED);
+
+  if (nth < s->capacity) {
+    s->samples[nth].wait_ns = elapsed_ns(t_request, t_entry);
+    s->samples[nth].hold_ns = elapsed_ns(t_entry, t_exit);
+  }
+}
+
+static unsigned long samples_get(const struct lock_samples *s,
+                                 const lock_sample **res,
+                                 unsigned long *lost_count)
+{
+  unsigned long count = __atomic_load_n(&s->count, __ATOMIC_ACQUIRE);
+
+  *res = s->samples;
+  if (count > s->capacity) {
+    *lost_count = count - s->capacity;
+    return s->capacity;
+  }
+  *lost_count = 0;
+  return count;
+}
+
+int rt_lock_protocol_parse(const char *name, enum rt_lock_protocol *res)
+{
+  int i;
+
+  for (i = 0; i < sizeof(protocol_names) / sizeof(*protocol_names); i++) {
+    if (strcasecmp(name, protocol_names[i]) == 0) {
+      *res = i;
+      return 0;
+    }
+  }
+
+  return -1;
+}
+
+const char *rt_lock_protocol_name(enum rt_lock_protocol protocol)
+{
+  if (protocol >= sizeof(protocol_names) / sizeof(*protocol_names)) {
+    return "unknown";
+  }
+  return protocol_names[protocol];
+}
+
+int rt_lock_create(enum rt_lock_protocol protocol, int ceiling,
+                   unsigned long sample_capacity, rt_lock **res)
+{
+  static const int mutex_protocols[] = {
+    [RT_LOCK_NONE] = PTHREAD_PRIO_NONE,
+    [RT_LOCK_INHERIT] = PTHREAD_PRIO_INHERIT,
+    [RT_LOCK_PROTECT] = PTHREAD_PRIO_PROTECT,
+  };
+  pthread_mutexattr_t attr;
+  rt_lock *l;
+
+  if ((protocol == RT_LOCK_PROTECT || protocol == RT_LOCK_SRP)
+      && (ceiling < sched_get_priority_min(SCHED_FIFO)
+          || ceiling > sched_get_priority_max(SCHED_FIFO))) {
+    return -1;
+  }
+
+  l = calloc(1, sizeof(*l));
+  if (l == NULL) {
+    log_error("Not enough memory for a lock");
+    return -2;
+  }
+  l->protocol = protocol;
+  l->ceiling = ceiling;
+  if (samples_init(&l->samples, sample_capacity) != 0) {
+    free(l);
+    return -2;
+  }
+
+  if (protocol != RT_LOCK_SRP) {
+    if ((errno = pthread_mutexattr_init(&attr)) != 0) {
+      log_syserror("Cannot initialize mutex attribute");
+      goto error;
+    }
+    if ((errno = pthread_mutexattr_setprotocol(&attr,
+                                               mutex_protocols[protocol]))
+        != 0) {
+      log_syserror("Cannot set mutex protocol to %s",
+                   rt_lock_protocol_name(protocol));
+      pthread_mutexattr_destroy(&attr);
+      goto error;
+    }
+    if (protocol == RT_LOCK_PROTECT
+        && (errno = pthread_mutexattr_setprioceiling(&attr, ceiling)) != 0) {
+      log_syserror("Cannot set mutex priority ceiling to %d", ceiling);
+      pthread_mutexattr_destroy(&attr);
+      goto error;
+    }
+    errno = pthread_mutex_init(&l->mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+    if (errno != 0) {
+      log_syserror("Cannot initialize mutex");
+      goto error;
+    }
+  }
+
+  *res = l;
+  return 0;
+
+ error:
+  free(l->samples.samples);
+  free(l);
+  return -2;
+}
+
+void rt_lock_destroy(rt_lock *l)
+{
+  if (l->protocol != RT_LOCK_SRP
+      && (errno = pthread_mutex_destroy(&l->mutex)) != 0) {
+    log_syserror("Cannot destroy mutex");
+  }
+  free(l->samples.samples);
+  free(l);
+}
+
+static int srp_acquire(rt_lock *l)
+{
+  struct sched_param param;
+  int policy;
+
+  if ((errno = pthread_getschedparam(pthread_self(), &policy, &param)) != 0) {
+    log_syserror("Cannot get the priority of the SRP lock requester");
+    return -2;
+  }
+  if (policy != SCHED_FIFO && policy != SCHED_RR) {
+    log_error("SRP needs a SCHED_FIFO or SCHED_RR thread");
+    return -2;
+  }
+
+  /* Keep out every job that may use the resource */
+  if (param.sched_priority < l->ceiling
+      && (errno = pthread_setschedprio(pthread_self(), l->ceiling)) != 0) {
+    log_syserror("Cannot raise the priority to the SRP ceiling %d",
+                 l->ceiling);
+    return -2;
+  }
+
+  /* The resource is always free on a uniprocessor; the holder may
+     only be running on another CPU otherwise */
+  while (__atomic_exchange_n(&l->srp_held, 1, __ATOMIC_ACQUIRE)) {
+    sched_yield();
+  }
+  l->srp_saved_prio = param.sched_priority;
+
+  return 0;
+}
+
+static int srp_release(rt_lock *l)
+{
+  int saved_prio = l->srp_saved_prio;
+
+  __atomic_store_n(&l->srp_held, 0, __ATOMIC_RELEASE);
+
+  /* pthread_setschedprio() keeps the caller at the head of the list
+     of its restored priority so that it is not preempted by a job
+     having the same priority */
+  if (saved_prio < l->ceiling
+      && (errno = pthread_setschedprio(pthread_self(), saved_prio)) != 0) {
+    log_syserror("Cannot restore the priority %d after SRP", saved_prio);
+    return -2;
+  }
+
+  return 0;
+}
+
+int rt_lock_acquire(rt_lock *l)
+{
+  struct timespec t_request;
+  int rc = 0;
+
+  if (l->samples.capacity != 0) {
+    clock_gettime(CLOCK_MONOTONIC, &t_request);
+  }
+
+  if (l->protocol == RT_LOCK_SRP) {
+    rc = srp_acquire(l);
+  } else if ((errno = pthread_mutex_lock(&l->mutex)) != 0) {
+    log_syserror("Cannot lock %s mutex", rt_lock_protocol_name(l->protocol));
+    rc = -2;
+  }
+  if (rc != 0) {
+    return rc;
+  }
+
+  if (l->samples.capacity != 0) {
+    l->t_request = t_request;
+    clock_gettime(CLOCK_MONOTONIC, &l->t_entry);
+  }
+
+  return 0;
+}
+
+int rt_lock_release(rt_lock *l)
+{
+  if (l->samples.capacity != 0) {
+    struct timespec t_exit;
+    clock_gettime(CLOCK_MONOTONIC, &t_exit);
+    samples_record(&l->samples, &l->t_request, &l->t_entry, &t_exit);
+  }
+
+  if (l->protocol == RT_LOCK_SRP) {
+    return srp_release(l);
+  }
+  if ((errno = pthread_mutex_unlock(&l->mutex)) != 0) {
+    log_syserror("Cannot unlock %s mutex",
+                 rt_lock_protocol_name(l->protocol));
+    return -2;
+  }
+
+  return 0;
+}
+
+unsigned long rt_lock_get_samples(const rt_lock *l, const lock_sample **res,
+                                  unsigned long *lost_count)
+{
+  return samples_get(&l->samples, res, lost_count);
+}
+
+static inline char *buffer_of(lockfree_object *o, uint64_t state)
+{
+  return o->buffers + (state & BUFFER_INDEX_MASK) * o->size;
+}
+
+int lockfree_object_create(size_t size, const void *initial,
+                           unsigned updater_count,
+                           unsigned long sample_capacity,
+                           lockfree_object **res)
+{
+  unsigned buffer_count = updater_count + 1;
+  unsigned queue_capacity = 1;
+  lockfree_object *o;
+  unsigned i;
+
+  if (size == 0 || updater_count == 0
+      || buffer_count > BUFFER_INDEX_MASK + 1) {
+    return -1;
+  }
+  while (queue_capacity < buffer_count) {
+    queue_capacity <<= 1;
+  }
+
+  o = calloc(1, sizeof(*o));
+  if (o == NULL) {
+    log_error("Not enough memory for a lock-free object");
+    return -2;
+  }
+  o->size = size;
+  o->buffers = calloc(buffer_count, size);
+  if (o->buffers == NULL) {
+    log_error("Not enough memory for %u copies of a lock-free object",
+              buffer_count);
+    goto error;
+  }
+  if (lockfree_queue_create(queue_capacity, &o->free_buffers) != 0) {
+    log_error("Cannot create the free buffers of a lock-free object");
+    goto error;
+  }
+  if (samples_init(&o->samples, sample_capacity) != 0) {
+    lockfree_queue_destroy(o->free_buffers);
+    goto error;
+  }
+
+  /* Buffer 0 holds the initial value */
+  memcpy(o->buffers, initial, size);
+  o->state = 0;
+  for (i = 1; i < buffer_count; i++) {
+    lockfree_queue_push(o->free_buffers, o->buffers + i * size);
+  }
+
+  *res = o;
+  return 0;
+
+ error:
+  free(o->buffers);
+  free(o);
+  return -2;
+}
+
+void lockfree_object_destroy(lockfree_object *o)
+{
+  lockfree_queue_destroy(o->free_buffers);
+  free(o->samples.samples);
+  free(o->buffers);
+  free(o);
+}
+
+/* Copy the current value and return the state it belongs to */
+static uint64_t snapshot(lockfree_object *o, void *res)
+{
+  uint64_t state;
+
+  do {
+    state = __atomic_load_n(&o->state, __ATOMIC_ACQUIRE);
+    memcpy(res, buffer_of(o, state), o->size);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    /* The buffer may have been recycled by an update while copying */
+  } while (__atomic_load_n(&o->state, __ATOMIC_RELAXED) != state);
+
+  return state;
+}
+
+void lockfree_object_read(lockfree_object *o, void *res)
+{
+  snapshot(o, res);
+}
+
+int lockfree_object_update(lockfree_object *o,
+                           void (*update)(void *value, void *args),
+                           void *args)
+{
+  struct timespec t_request, t_entry, t_exit;
+  uint64_t state, new_state;
+  char *copy;
+
+  if (o->samples.capacity != 0) {
+    clock_gettime(CLOCK_MONOTONIC, &t_request);
+  }
+
+  if (lockfree_queue_pop(o->free_buffers, (void **) &copy) != 0) {
+    log_error("Too many threads are updating a lock-free object");
+    return -2;
+  }
+  new_state = (copy - o->buffers) / o->size;
+
+  do {
+    if (o->samples.capacity != 0) {
+      clock_gettime(CLOCK_MONOTONIC, &t_entry);
+    }
+    state = snapshot(o, copy);
+    update(copy, args);
+    new_state = (((state >> BUFFER_INDEX_BITS) + 1) << BUFFER_INDEX_BITS
+                 | (new_state & BUFFER_INDEX_MASK));
+  } while (!__atomic_compare_exchange_n(&o->state, &state, new_state, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+  /* The replaced value can be reused once its readers notice the
+     change of the state */
+  lockfree_queue_push(o->free_buffers, buffer_of(o, state));
+
+  if (o->samples.capacity != 0) {
+    clock_gettime(CLOCK_MONOTONIC, &t_exit);
+    samples_record(&o->samples, &t_request, &t_entry, &t_exit);
+  }
+
+  return 0;
+}
+
+unsigned long lockfree_object_get_samples(const lockfree_object *o,
+                                          const lock_sample **res,
+                                          unsigned long *lost_count)
+{
+  return samples_get(&o->samples, res, lost_count);
+}
+
+static int compare_ns(const void *a, const void *b)
+{
+  unsigned long long x = *(const unsigned long long *) a;
+  unsigned long long y = *(const unsigned long long *) b;
+
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/* Return the smallest time that is not exceeded by the given fraction
+   (in units of 1/100) of the sorted times */
+static unsigned long long ns_percentile(const unsigned long long *ns,
+                                        unsigned long count,
+                                        unsigned fraction)
+{
+  unsigned long long rank = ((unsigned long long) count * fraction + 99) / 100;
+  return ns[rank == 0 ? 0 : rank - 1];
+}
+
+static void print_distribution(FILE *stream, const char *name,
+                               const char *kind, unsigned long long *ns,
+                               unsigned long count)
+{
+  if (count == 0) {
+    fprintf(stream, "%s_%s: no critical section\n", name, kind);
+    return;
+  }
+
+  qsort(ns, count, sizeof(*ns), compare_ns);
+  fprintf(stream, "%s_%s (ns): n=%lu min=%llu p50=%llu p90=%llu p99=%llu"
+          " max=%llu\n", name, kind, count, ns[0],
+          ns_percentile(ns, count, 50), ns_percentile(ns, count, 90),
+          ns_percentile(ns, count, 99), ns[count - 1]);
+}
+
+void lock_samples_print(FILE *stream, const char *name,
+                        const lock_sample *samples, unsigned long count)
+{
+  unsigned long long *ns = malloc(sizeof(*ns) * (count + 1));
+  unsigned long i;
+
+  if (ns == NULL) {
+    log_error("Insufficient memory to print %lu lock samples", count);
+    return;
+  }
+
+  for (i = 0; i < count; i++) {
+    ns[i] = samples[i].wait_ns;
+  }
+  print_distribution(stream, name, "wait", ns, count);
+
+  for (i = 0; i < count; i++) {
+    ns[i] = samples[i].hold_ns;
+  }
+  print_distribution(stream, name, "hold", ns, count);
+
+  free(ns);
+}
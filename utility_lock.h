@@ -0,0 +1,242 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+/**
+ * @file utility_lock.h
+ * @brief Real-time locking protocols and a lock-free alternative
+ * whose blocking times are measured.
+ *
+ * An rt_lock protects a shared resource using one of the following
+ * protocols:
+ * - none: a plain mutex, which suffers from unbounded priority
+ *   inversion.
+ * - inherit: a PTHREAD_PRIO_INHERIT mutex (priority inheritance).
+ * - protect: a PTHREAD_PRIO_PROTECT mutex whose holder runs at the
+ *   priority ceiling of the resource (immediate priority ceiling).
+ * - srp: the Stack Resource Policy implemented in user space for
+ *   SCHED_FIFO threads whose preemption levels are their
+ *   priorities. The holder raises its own priority to the ceiling of
+ *   the resource using pthread_setschedprio() so that no job that
+ *   may use the resource can preempt it; on a uniprocessor, the
+ *   resource is then always free when requested and the kernel is
+ *   only entered to change the priority. The priority is restored
+ *   upon release, which allows nesting as long as the resources are
+ *   released in the reverse order.
+ *
+ * Under protect and srp, a job is blocked by starting late rather
+ * than by waiting for the resource, which is visible in the job
+ * statistics instead.
+ *
+ * A lockfree_object is the lock-free alternative: a shared object
+ * that is updated by copying it, modifying the copy and publishing
+ * the copy using a single compare-and-swap. An update that loses the
+ * race against another update is retried so that no thread ever
+ * waits for a preempted one; the cost is paid by the retrying thread
+ * instead.
+ *
+ * Unless disabled, every critical section records a lock_sample
+ * consisting of the time spent to enter it (waiting for an rt_lock
+ * or retrying a lockfree_object update, including the protocol
+ * overhead) and the time spent inside it so that the distributions
+ * can be compared using lock_samples_print().
+ *
+ * @author Tadeus Prastowo <eus@member.fsf.org>
+ */
+
+#ifndef UTILITY_LOCK
+#define UTILITY_LOCK
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include "utility_log.h"
+#include "utility_lockfree_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /** The locking protocols of an rt_lock. */
+  enum rt_lock_protocol {
+    RT_LOCK_NONE, /**< A plain mutex. */
+    RT_LOCK_INHERIT, /**< Priority inheritance. */
+    RT_LOCK_PROTECT, /**< Immediate priority ceiling. */
+    RT_LOCK_SRP, /**< User-space Stack Resource Policy. */
+  };
+
+  /** The timing of one critical section. */
+  typedef struct
+  {
+    uint64_t wait_ns; /**< The time from the request to the entry. */
+    uint64_t hold_ns; /**< The time from the entry to the exit. */
+  } lock_sample;
+
+  /**
+   * A lock following a real-time locking protocol.
+   * This is an opaque type; do not manipulate any of its instances directly.
+   */
+  typedef struct rt_lock rt_lock;
+
+  /**
+   * A shared object updated without locking.
+   * This is an opaque type; do not manipulate any of its instances directly.
+   */
+  typedef struct lockfree_object lockfree_object;
+
+  /**
+   * @return 0 if the given case-insensitive name (none, inherit,
+   * protect or srp) is stored as a protocol in res or -1 otherwise.
+   */
+  int rt_lock_protocol_parse(const char *name, enum rt_lock_protocol *res);
+
+  /**
+   * @return the name of the given protocol.
+   */
+  const char *rt_lock_protocol_name(enum rt_lock_protocol protocol);
+
+  /**
+   * Create a lock.
+   *
+   * @param protocol the locking protocol.
+   * @param ceiling the SCHED_FIFO priority of the highest-priority
+   * thread using the lock, which is only used by RT_LOCK_PROTECT and
+   * RT_LOCK_SRP.
+   * @param sample_capacity the number of critical sections whose
+   * lock_sample is recorded, or 0 to record none and avoid the timing
+   * overhead.
+   * @param res a pointer to the object to store the created lock.
+   *
+   * @return 0 if the lock is created, -1 if the ceiling is not a
+   * SCHED_FIFO priority while it is used, or -2 in case of hard error
+   * that requires the investigation of the output of the logging
+   * facility to fix the error.
+   */
+  int rt_lock_create(enum rt_lock_protocol protocol, int ceiling,
+                     unsigned long sample_capacity, rt_lock **res);
+
+  /**
+   * Destroy a lock that is not held.
+   */
+  void rt_lock_destroy(rt_lock *l);
+
+  /**
+   * Enter the critical section protected by the lock. Under
+   * RT_LOCK_SRP, the caller must be a SCHED_FIFO or SCHED_RR thread
+   * whose priority does not exceed the ceiling.
+   *
+   * @return 0 if the lock is held or -2 in case of hard error that
+   * requires the investigation of the output of the logging facility
+   * to fix the error.
+   */
+  int rt_lock_acquire(rt_lock *l);
+
+  /**
+   * Leave the critical section entered using rt_lock_acquire().
+   *
+   * @return 0 if the lock is released or -2 in case of hard error
+   * that requires the investigation of the output of the logging
+   * facility to fix the error.
+   */
+  int rt_lock_release(rt_lock *l);
+
+  /**
+   * Obtain the samples recorded so far.
+   *
+   * @param res a pointer to the object to store the address of the
+   * samples in the order of the exit from the critical sections.
+   * @param lost_count a pointer to the object to store the number of
+   * samples that cannot be recorded because the capacity is exceeded.
+   *
+   * @return the number of samples.
+   */
+  unsigned long rt_lock_get_samples(const rt_lock *l, const lock_sample **res,
+                                    unsigned long *lost_count);
+
+  /**
+   * Create a shared object.
+   *
+   * @param size the size in bytes of the object.
+   * @param initial a pointer to the initial value of the object.
+   * @param updater_count the maximum number of threads updating the
+   * object at the same time.
+   * @param sample_capacity like that of rt_lock_create().
+   * @param res a pointer to the object to store the created object.
+   *
+   * @return 0 if the object is created, -1 if size or updater_count
+   * is zero, or -2 in case of hard error that requires the
+   * investigation of the output of the logging facility to fix the
+   * error.
+   */
+  int lockfree_object_create(size_t size, const void *initial,
+                             unsigned updater_count,
+                             unsigned long sample_capacity,
+                             lockfree_object **res);
+
+  /**
+   * Destroy an object that no thread is using anymore.
+   */
+  void lockfree_object_destroy(lockfree_object *o);
+
+  /**
+   * Copy a consistent snapshot of the object into res, which must be
+   * as large as the object.
+   */
+  void lockfree_object_read(lockfree_object *o, void *res);
+
+  /**
+   * Update the object by calling the given function on a private copy
+   * of the object and publishing the copy if no other update has been
+   * published in the meantime. Otherwise, the function is called
+   * again on a fresh copy. Since the function may be called several
+   * times, it must have no side effect other than on the copy.
+   *
+   * @return 0 if the update is published or -2 if more threads than
+   * the updater_count given to lockfree_object_create() are updating
+   * the object at the same time.
+   */
+  int lockfree_object_update(lockfree_object *o,
+                             void (*update)(void *value, void *args),
+                             void *args);
+
+  /**
+   * Like rt_lock_get_samples() where the waiting time of an update is
+   * the time spent in the attempts that lose the race.
+   */
+  unsigned long lockfree_object_get_samples(const lockfree_object *o,
+                                            const lock_sample **res,
+                                            unsigned long *lost_count);
+
+  /**
+   * Print the distributions of the waiting and holding times of the
+   * given samples in the format:
+   * NAME_wait (ns): n=N min=MIN p50=P50 p90=P90 p99=P99 max=MAX
+   * NAME_hold (ns): n=N min=MIN p50=P50 p90=P90 p99=P99 max=MAX
+   */
+  void lock_samples_print(FILE *stream, const char *name,
+                          const lock_sample *samples, unsigned long count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UTILITY_LOCK */
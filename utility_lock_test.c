@@ -0,0 +1,189 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include "utility_testcase.h"
+#include "utility_log.h"
+#include "utility_lock.h"
+#include "utility_sched_fifo.h"
+
+#define UPDATER_COUNT 4
+#define UPDATE_PER_THREAD 10000
+
+static rt_lock *shared_lock;
+static lockfree_object *shared_object;
+
+static void *contender(void *args)
+{
+  gracious_assert(rt_lock_acquire(shared_lock) == 0);
+  gracious_assert(rt_lock_release(shared_lock) == 0);
+  return NULL;
+}
+
+static void increment(void *value, void *args)
+{
+  ++*(uint64_t *) value;
+}
+
+static void *updater(void *args)
+{
+  int i;
+
+  for (i = 0; i < UPDATE_PER_THREAD; i++) {
+    gracious_assert(lockfree_object_update(shared_object, increment, NULL)
+                    == 0);
+    if (i % 1000 == 0) {
+      sched_yield();
+    }
+  }
+
+  return NULL;
+}
+
+static void nested_update(void *value, void *args)
+{
+  *(int *) args = lockfree_object_update(shared_object, increment, NULL);
+  increment(value, NULL);
+}
+
+MAIN_UNIT_TEST_BEGIN("utility_lock_test", "stderr", NULL, NULL)
+{
+  enum rt_lock_protocol protocol;
+  const lock_sample *samples;
+  unsigned long count, lost_count;
+  int prio, ceiling;
+
+  /* Testcase 1: protocol names */
+  gracious_assert(rt_lock_protocol_parse("SRP", &protocol) == 0);
+  gracious_assert(protocol == RT_LOCK_SRP);
+  gracious_assert(rt_lock_protocol_parse("protect", &protocol) == 0);
+  gracious_assert(protocol == RT_LOCK_PROTECT);
+  gracious_assert(rt_lock_protocol_parse("ceiling", &protocol) == -1);
+  gracious_assert(strcmp(rt_lock_protocol_name(RT_LOCK_INHERIT), "inherit")
+                  == 0);
+  gracious_assert(rt_lock_create(RT_LOCK_SRP, -1, 0, &shared_lock) == -1);
+  gracious_assert(rt_lock_create(RT_LOCK_PROTECT, 1000, 0, &shared_lock)
+                  == -1);
+
+  /* Testcase 2: the waiting time of a blocked thread */
+  {
+    pthread_t tid;
+    struct timespec t_hold = {0, 20000000};
+
+    gracious_assert(rt_lock_create(RT_LOCK_NONE, 0, 2, &shared_lock) == 0);
+    gracious_assert(rt_lock_acquire(shared_lock) == 0);
+    gracious_assert(pthread_create(&tid, NULL, contender, NULL) == 0);
+    nanosleep(&t_hold, NULL);
+    gracious_assert(rt_lock_release(shared_lock) == 0);
+    gracious_assert(pthread_join(tid, NULL) == 0);
+    gracious_assert(rt_lock_acquire(shared_lock) == 0);
+    gracious_assert(rt_lock_release(shared_lock) == 0);
+
+    count = rt_lock_get_samples(shared_lock, &samples, &lost_count);
+    gracious_assert(count == 2 && lost_count == 1);
+    gracious_assert(samples[0].wait_ns < 10000000);
+    gracious_assert(samples[0].hold_ns >= 20000000);
+    gracious_assert(samples[1].wait_ns >= 15000000);
+    gracious_assert(samples[1].hold_ns < 10000000);
+    rt_lock_destroy(shared_lock);
+  }
+
+  /* Testcase 3: the holder runs at the ceiling under protect and srp */
+  gracious_assert(sched_fifo_prio(2, &prio) == 0);
+  gracious_assert(sched_fifo_prio(1, &ceiling) == 0);
+  gracious_assert(sched_fifo_enter(prio, NULL) == 0);
+  for (protocol = RT_LOCK_NONE; protocol <= RT_LOCK_SRP; protocol++) {
+    struct sched_param param;
+    int expected = (protocol >= RT_LOCK_PROTECT ? ceiling : prio);
+
+    gracious_assert(rt_lock_create(protocol, ceiling, 4, &shared_lock) == 0);
+    gracious_assert(rt_lock_acquire(shared_lock) == 0);
+    gracious_assert(sched_getparam(0, &param) == 0);
+    gracious_assert_msg(param.sched_priority == expected, "%s",
+                        rt_lock_protocol_name(protocol));
+    gracious_assert(rt_lock_release(shared_lock) == 0);
+    gracious_assert(sched_getparam(0, &param) == 0);
+    gracious_assert(param.sched_priority == prio);
+
+    /* Nesting */
+    if (protocol == RT_LOCK_SRP) {
+      rt_lock *inner;
+      gracious_assert(rt_lock_create(RT_LOCK_SRP, prio, 0, &inner) == 0);
+      gracious_assert(rt_lock_acquire(shared_lock) == 0);
+      gracious_assert(rt_lock_acquire(inner) == 0);
+      gracious_assert(sched_getparam(0, &param) == 0);
+      gracious_assert(param.sched_priority == ceiling);
+      gracious_assert(rt_lock_release(inner) == 0);
+      gracious_assert(rt_lock_release(shared_lock) == 0);
+      gracious_assert(sched_getparam(0, &param) == 0);
+      gracious_assert(param.sched_priority == prio);
+      rt_lock_destroy(inner);
+    }
+
+    count = rt_lock_get_samples(shared_lock, &samples, &lost_count);
+    gracious_assert(count == (protocol == RT_LOCK_SRP ? 2 : 1));
+    gracious_assert(lost_count == 0);
+    rt_lock_destroy(shared_lock);
+  }
+
+  /* Testcase 4: concurrent lock-free updates */
+  {
+    pthread_t tids[UPDATER_COUNT];
+    uint64_t value = 7;
+    int i, rc = 0;
+
+    gracious_assert(lockfree_object_create(0, &value, 1, 0, &shared_object)
+                    == -1);
+    gracious_assert(lockfree_object_create(sizeof(value), &value, 0, 0,
+                                           &shared_object) == -1);
+    gracious_assert(lockfree_object_create(sizeof(value), &value,
+                                           UPDATER_COUNT,
+                                           UPDATER_COUNT * UPDATE_PER_THREAD,
+                                           &shared_object) == 0);
+    for (i = 0; i < UPDATER_COUNT; i++) {
+      gracious_assert(pthread_create(&tids[i], NULL, updater, NULL) == 0);
+    }
+    for (i = 0; i < UPDATER_COUNT; i++) {
+      gracious_assert(pthread_join(tids[i], NULL) == 0);
+    }
+    lockfree_object_read(shared_object, &value);
+    gracious_assert(value == 7 + UPDATER_COUNT * UPDATE_PER_THREAD);
+
+    count = lockfree_object_get_samples(shared_object, &samples, &lost_count);
+    gracious_assert(count == UPDATER_COUNT * UPDATE_PER_THREAD);
+    gracious_assert(lost_count == 0);
+    lock_samples_print(stderr, "lockfree_test", samples, count);
+
+    /* The buffers run out when the updaters are more than declared */
+    lockfree_object_destroy(shared_object);
+    gracious_assert(lockfree_object_create(sizeof(value), &value, 1, 0,
+                                           &shared_object) == 0);
+    gracious_assert(lockfree_object_update(shared_object, nested_update, &rc)
+                    == 0);
+    gracious_assert(rc == -2);
+    lockfree_object_read(shared_object, &value);
+    gracious_assert(value == 7 + UPDATER_COUNT * UPDATE_PER_THREAD + 1);
+    lockfree_object_destroy(shared_object);
+  }
+
+} MAIN_UNIT_TEST_END
@@ -0,0 +1,131 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include "utility_lockfree_queue.h"
+
+#define CACHE_LINE_SIZE 64
+
+/* A slot whose seq equals the enqueue position is free for the
+   producer of that position, and a slot whose seq equals the dequeue
+   position plus one is filled for the consumer of that position */
+struct cell
+{
+  uint64_t seq;
+  void *elem;
+};
+
+struct lockfree_queue
+{
+  uint64_t mask;
+  struct cell *cells;
+  /* Each position sits in its own cache line to avoid false sharing
+     between the producers and the consumers */
+  uint64_t enqueue_pos __attribute__((aligned(CACHE_LINE_SIZE)));
+  uint64_t dequeue_pos __attribute__((aligned(CACHE_LINE_SIZE)));
+};
+
+int lockfree_queue_create(unsigned capacity, lockfree_queue **res)
+{
+  lockfree_queue *q;
+  unsigned i;
+
+  if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+    return -1;
+  }
+
+  if (posix_memalign((void **) &q, CACHE_LINE_SIZE, sizeof(*q)) != 0) {
+    log_error("No memory to create lock-free queue");
+    return -2;
+  }
+  q->cells = malloc(capacity * sizeof(*q->cells));
+  if (q->cells == NULL) {
+    log_error("No memory to create %u lock-free queue slots", capacity);
+    free(q);
+    return -2;
+  }
+
+  q->mask = capacity - 1;
+  for (i = 0; i < capacity; i++) {
+    q->cells[i].seq = i;
+  }
+  q->enqueue_pos = 0;
+  q->dequeue_pos = 0;
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  *res = q;
+  return 0;
+}
+
+void lockfree_queue_destroy(lockfree_queue *q)
+{
+  free(q->cells);
+  free(q);
+}
+
+int lockfree_queue_push(lockfree_queue *q, void *elem)
+{
+  uint64_t pos = __atomic_load_n(&q->enqueue_pos, __ATOMIC_RELAXED);
+  struct cell *cell;
+
+  while (1) {
+    cell = &q->cells[pos & q->mask];
+    int64_t diff = ((int64_t) __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE)
+                    - (int64_t) pos);
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&q->enqueue_pos, &pos, pos + 1, 1,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return -1; /* The slot still holds the element of the previous lap */
+    } else {
+      pos = __atomic_load_n(&q->enqueue_pos, __ATOMIC_RELAXED);
+    }
+  }
+
+  cell->elem = elem;
+  __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+
+  return 0;
+}
+
+int lockfree_queue_pop(lockfree_queue *q, void **elem)
+{
+  uint64_t pos = __atomic_load_n(&q->dequeue_pos, __ATOMIC_RELAXED);
+  struct cell *cell;
+
+  while (1) {
+    cell = &q->cells[pos & q->mask];
+    int64_t diff = ((int64_t) __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE)
+                    - (int64_t) (pos + 1));
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&q->dequeue_pos, &pos, pos + 1, 1,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return -1; /* The slot has not been filled yet */
+    } else {
+      pos = __atomic_load_n(&q->dequeue_pos, __ATOMIC_RELAXED);
+    }
+  }
+
+  *elem = cell->elem;
+  __atomic_store_n(&cell->seq, pos + q->mask + 1, __ATOMIC_RELEASE);
+
+  return 0;
+}
@@ -0,0 +1,90 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+/**
+ * @file utility_lockfree_queue.h
+ * @brief A bounded FIFO queue of pointers that any number of threads
+ * can push to and pop from concurrently without locking.
+ *
+ * Each slot of the queue carries a sequence number that tells a
+ * producer whether the slot is free and a consumer whether the slot
+ * is filled. A thread claims a slot with a single compare-and-swap on
+ * the enqueue or dequeue position so that a preempted thread never
+ * blocks the other threads. The queue never blocks either: pushing to
+ * a full queue or popping from an empty queue fails immediately so
+ * that the caller decides whether to drop, retry or sleep, for
+ * example, on a POSIX semaphore counting the queued elements.
+ *
+ * @author Tadeus Prastowo <eus@member.fsf.org>
+ */
+
+#ifndef UTILITY_LOCKFREE_QUEUE
+#define UTILITY_LOCKFREE_QUEUE
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "utility_log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /**
+   * A lock-free queue.
+   * This is an opaque type; do not manipulate any of its instances directly.
+   */
+  typedef struct lockfree_queue lockfree_queue;
+
+  /**
+   * Create an empty queue.
+   *
+   * @param capacity the maximum number of elements in the queue,
+   * which must be a power of two.
+   * @param res a pointer to the object to store the created queue.
+   *
+   * @return 0 if the queue is created, -1 if capacity is not a power
+   * of two, or -2 if there is no memory.
+   */
+  int lockfree_queue_create(unsigned capacity, lockfree_queue **res);
+
+  /**
+   * Destroy a queue that no thread is using anymore. The elements
+   * remaining in the queue are not freed.
+   */
+  void lockfree_queue_destroy(lockfree_queue *q);
+
+  /**
+   * Append an element to the tail of the queue.
+   *
+   * @return 0 if the element is appended or -1 if the queue is full.
+   */
+  int lockfree_queue_push(lockfree_queue *q, void *elem);
+
+  /**
+   * Remove the element at the head of the queue.
+   *
+   * @param elem a pointer to the object to store the removed element.
+   *
+   * @return 0 if an element is removed or -1 if the queue is empty.
+   */
+  int lockfree_queue_pop(lockfree_queue *q, void **elem);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UTILITY_LOCKFREE_QUEUE */
@@ -0,0 +1,140 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include "utility_testcase.h"
+#include "utility_log.h"
+#include "utility_lockfree_queue.h"
+
+#define CAPACITY 8
+#define THREAD_COUNT 4
+#define ELEM_PER_PRODUCER 100000
+
+static lockfree_queue *shared_queue;
+static uint64_t consumed_sum[THREAD_COUNT];
+static unsigned consumed_count[THREAD_COUNT];
+static unsigned producers_done;
+
+/* Push the values 1 to ELEM_PER_PRODUCER tagged with the producer index */
+static void *producer(void *args)
+{
+  uintptr_t id = (uintptr_t) args;
+  uintptr_t i;
+
+  for (i = 1; i <= ELEM_PER_PRODUCER; i++) {
+    while (lockfree_queue_push(shared_queue, (void *) (i * THREAD_COUNT + id))
+           != 0) {
+      sched_yield();
+    }
+  }
+  __atomic_add_fetch(&producers_done, 1, __ATOMIC_RELEASE);
+
+  return NULL;
+}
+
+static void *consumer(void *args)
+{
+  uintptr_t id = (uintptr_t) args;
+  uintptr_t last_seen[THREAD_COUNT] = {0};
+  void *elem;
+
+  while (1) {
+    if (lockfree_queue_pop(shared_queue, &elem) != 0) {
+      if (__atomic_load_n(&producers_done, __ATOMIC_ACQUIRE) == THREAD_COUNT
+          && lockfree_queue_pop(shared_queue, &elem) != 0) {
+        break;
+      }
+      sched_yield();
+      continue;
+    }
+
+    uintptr_t value = (uintptr_t) elem;
+    uintptr_t producer_id = value % THREAD_COUNT;
+    /* Elements of one producer must come out in FIFO order */
+    if (value / THREAD_COUNT <= last_seen[producer_id]) {
+      return (void *) 1;
+    }
+    last_seen[producer_id] = value / THREAD_COUNT;
+    consumed_sum[id] += value / THREAD_COUNT;
+    consumed_count[id]++;
+  }
+
+  return NULL;
+}
+
+MAIN_UNIT_TEST_BEGIN("utility_lockfree_queue_test", "stderr", NULL, NULL)
+{
+  lockfree_queue *q;
+  void *elem;
+  uintptr_t i;
+
+  /* Testcase 1: invalid capacity */
+  gracious_assert(lockfree_queue_create(0, &q) == -1);
+  gracious_assert(lockfree_queue_create(6, &q) == -1);
+
+  /* Testcase 2: FIFO order, full and empty queue across several laps */
+  gracious_assert(lockfree_queue_create(CAPACITY, &q) == 0);
+  gracious_assert(lockfree_queue_pop(q, &elem) == -1);
+  for (i = 1; i <= CAPACITY * 3; i++) {
+    gracious_assert(lockfree_queue_push(q, (void *) i) == 0);
+    if (i % CAPACITY == 0) {
+      uintptr_t j;
+      gracious_assert(lockfree_queue_push(q, (void *) i) == -1);
+      for (j = i - CAPACITY + 1; j <= i; j++) {
+        gracious_assert(lockfree_queue_pop(q, &elem) == 0);
+        gracious_assert((uintptr_t) elem == j);
+      }
+      gracious_assert(lockfree_queue_pop(q, &elem) == -1);
+    }
+  }
+  gracious_assert(lockfree_queue_push(q, NULL) == 0);
+  gracious_assert(lockfree_queue_pop(q, &elem) == 0 && elem == NULL);
+  lockfree_queue_destroy(q);
+
+  /* Testcase 3: concurrent producers and consumers lose no element */
+  pthread_t producers[THREAD_COUNT], consumers[THREAD_COUNT];
+  void *consumer_rc;
+  uint64_t sum = 0;
+  unsigned count = 0;
+
+  gracious_assert(lockfree_queue_create(CAPACITY, &shared_queue) == 0);
+  for (i = 0; i < THREAD_COUNT; i++) {
+    gracious_assert(pthread_create(&consumers[i], NULL, consumer, (void *) i)
+                    == 0);
+    gracious_assert(pthread_create(&producers[i], NULL, producer, (void *) i)
+                    == 0);
+  }
+  for (i = 0; i < THREAD_COUNT; i++) {
+    gracious_assert(pthread_join(producers[i], NULL) == 0);
+  }
+  for (i = 0; i < THREAD_COUNT; i++) {
+    gracious_assert(pthread_join(consumers[i], &consumer_rc) == 0);
+    gracious_assert(consumer_rc == NULL);
+    sum += consumed_sum[i];
+    count += consumed_count[i];
+  }
+  gracious_assert(count == THREAD_COUNT * ELEM_PER_PRODUCER);
+  gracious_assert(sum == (THREAD_COUNT * (uint64_t) ELEM_PER_PRODUCER
+                          * (ELEM_PER_PRODUCER + 1) / 2));
+  gracious_assert(lockfree_queue_pop(shared_queue, &elem) == -1);
+  lockfree_queue_destroy(shared_queue);
+
+} MAIN_UNIT_TEST_END
@@ -0,0 +1,1002 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include "utility_log.h"
+
+#define LOG_RECORD_ARG_MAX 16
+#define LOG_RECORD_STR_MAX 256
+#define LOG_RING_SLOT_COUNT_DEFAULT 256
+#define LOG_FLUSH_PERIOD_NS_DEFAULT (10 * 1000 * 1000)
+#define LOG_MSG_MAX 1024
+
+/* The length modifier of a printf conversion specification */
+enum conv_length {
+  LEN_NONE,
+  LEN_HH,
+  LEN_H,
+  LEN_L,
+  LEN_LL,
+  LEN_J,
+  LEN_Z,
+  LEN_T,
+  LEN_BIG_L,
+};
+
+/* The kind of argument consumed by a printf conversion specification */
+enum conv_class {
+  CONV_LITERAL_PERCENT,
+  CONV_SIGNED,
+  CONV_UNSIGNED,
+  CONV_CHAR,
+  CONV_FLOAT,
+  CONV_STRING,
+  CONV_POINTER,
+  CONV_UNSUPPORTED,
+};
+
+/* The anatomy of "%[flags][width][.precision][length]conversion" */
+struct conv_spec {
+  const char *flags;
+  size_t flags_len;
+  int width_star;
+  const char *width;
+  size_t width_len;
+  int has_prec;
+  int prec_star;
+  const char *prec;
+  size_t prec_len;
+  enum conv_length length;
+  const char *length_str;
+  size_t length_len;
+  char conversion;
+  enum conv_class class;
+};
+
+union log_arg {
+  intmax_t i;
+  uintmax_t u;
+  long double d;
+  const void *p;
+  size_t str_offset;
+};
+
+struct log_record {
+  struct timespec t;
+  pthread_t tid;
+  const char *fmt;
+  const char *fn;
+  const char *file;
+  unsigned line;
+  unsigned char kind;
+  unsigned char preformatted;
+  unsigned char arg_count;
+  size_t str_len;
+  union log_arg args[LOG_RECORD_ARG_MAX];
+  char str[LOG_RECORD_STR_MAX];
+};
+
+/* A single-producer single-consumer ring buffer. The producer is the
+ * owning thread and the consumer is whoever holds registry_lock. */
+struct log_ring {
+  struct log_ring *next;
+  unsigned long slot_count;
+  unsigned long head; /* Only written by the producer */
+  unsigned long tail; /* Only written by the consumer */
+  unsigned long head_snapshot; /* Bounds a single drain */
+  unsigned long drop_count; /* Only written by the producer */
+  int orphaned; /* The owning thread has exited */
+  int detached; /* The backend was stopped while the owner was alive */
+  struct log_record *slots;
+};
+
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+static pthread_key_t ring_key;
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t formatter_wakeup;
+static struct log_ring *registry = NULL;
+static unsigned long registry_drop_count = 0; /* Of freed rings */
+static int async_on = 0;
+static unsigned long ring_slot_count = LOG_RING_SLOT_COUNT_DEFAULT;
+static struct timespec flush_period;
+static pthread_t formatter;
+static int formatter_stopped = 0;
+static int log_format = UTILITY_LOG_FORMAT_PLAIN;
+static char formatter_msg[LOG_MSG_MAX]; /* Protected by registry_lock */
+
+static void ring_destroy(struct log_ring *ring)
+{
+  free(ring->slots);
+  free(ring);
+}
+
+static void ring_key_destructor(void *args)
+{
+  struct log_ring *ring = args;
+
+  pthread_mutex_lock(&registry_lock);
+  if (ring->detached) {
+    ring_destroy(ring);
+  } else {
+    ring->orphaned = 1;
+  }
+  pthread_mutex_unlock(&registry_lock);
+}
+
+static void atfork_prepare(void)
+{
+  pthread_mutex_lock(&registry_lock);
+}
+
+static void atfork_parent(void)
+{
+  pthread_mutex_unlock(&registry_lock);
+}
+
+static void atfork_child(void)
+{
+  /* The formatter thread does not exist in the child */
+  struct log_ring *ring;
+  for (ring = registry; ring != NULL; ring = ring->next) {
+    ring->detached = 1;
+  }
+  registry = NULL;
+  __atomic_store_n(&async_on, 0, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&registry_lock);
+}
+
+static void init(void)
+{
+  if ((errno = pthread_key_create(&ring_key, ring_key_destructor)) != 0) {
+    fatal_syserror("Cannot create the key of per-thread log ring buffers");
+  }
+  if ((errno = pthread_atfork(atfork_prepare, atfork_parent, atfork_child))
+      != 0) {
+    fatal_syserror("Cannot register the fork handlers of async logging");
+  }
+
+  pthread_condattr_t attr;
+  if ((errno = pthread_condattr_init(&attr)) != 0) {
+    fatal_syserror("Cannot initialize the attribute of formatter wakeup");
+  }
+  if ((errno = pthread_condattr_setclock(&attr, CLOCK_MONOTONIC)) != 0) {
+    fatal_syserror("Cannot make formatter wakeup use CLOCK_MONOTONIC");
+  }
+  if ((errno = pthread_cond_init(&formatter_wakeup, &attr)) != 0) {
+    fatal_syserror("Cannot initialize formatter wakeup");
+  }
+  pthread_condattr_destroy(&attr);
+}
+
+/* Parse a conversion specification whose '%' is pointed by p and
+ * return the pointer to the character following the specification */
+static const char *parse_conversion(const char *p, struct conv_spec *spec)
+{
+  p++; /* Skip '%' */
+
+  spec->flags = p;
+  while (*p != '\0' && strchr("-+ #0'I", *p) != NULL) {
+    p++;
+  }
+  spec->flags_len = p - spec->flags;
+
+  spec->width_star = 0;
+  spec->width = p;
+  if (*p == '*') {
+    spec->width_star = 1;
+    p++;
+  } else {
+    while (*p >= '0' && *p <= '9') {
+      p++;
+    }
+  }
+  spec->width_len = p - spec->width;
+
+  spec->has_prec = 0;
+  spec->prec_star = 0;
+  spec->prec = p;
+  spec->prec_len = 0;
+  if (*p == '.') {
+    spec->has_prec = 1;
+    p++;
+    spec->prec = p;
+    if (*p == '*') {
+      spec->prec_star = 1;
+      p++;
+    } else {
+      while (*p >= '0' && *p <= '9') {
+        p++;
+      }
+    }
+    spec->prec_len = p - spec->prec;
+  }
+
+  spec->length_str = p;
+  spec->length = LEN_NONE;
+  switch (*p) {
+  case 'h':
+    p++;
+    if (*p == 'h') {
+      p++;
+      spec->length = LEN_HH;
+    } else {
+      spec->length = LEN_H;
+    }
+    break;
+  case 'l':
+    p++;
+    if (*p == 'l') {
+      p++;
+      spec->length = LEN_LL;
+    } else {
+      spec->length = LEN_L;
+    }
+    break;
+  case 'q':
+    p++;
+    spec->length = LEN_LL;
+    break;
+  case 'j':
+    p++;
+    spec->length = LEN_J;
+    break;
+  case 'z':
+    p++;
+    spec->length = LEN_Z;
+    break;
+  case 't':
+    p++;
+    spec->length = LEN_T;
+    break;
+  case 'L':
+    p++;
+    spec->length = LEN_BIG_L;
+    break;
+  }
+  spec->length_len = p - spec->length_str;
+
+  spec->conversion = *p;
+  switch (*p) {
+  case '%':
+    spec->class = CONV_LITERAL_PERCENT;
+    break;
+  case 'd':
+  case 'i':
+    spec->class = CONV_SIGNED;
+    break;
+  case 'o':
+  case 'u':
+  case 'x':
+  case 'X':
+    spec->class = CONV_UNSIGNED;
+    break;
+  case 'c':
+    spec->class = CONV_CHAR;
+    break;
+  case 'e':
+  case 'E':
+  case 'f':
+  case 'F':
+  case 'g':
+  case 'G':
+  case 'a':
+  case 'A':
+    spec->class = CONV_FLOAT;
+    break;
+  case 's':
+    spec->class = (spec->length == LEN_L ? CONV_UNSUPPORTED : CONV_STRING);
+    break;
+  case 'p':
+    spec->class = CONV_POINTER;
+    break;
+  default:
+    spec->class = CONV_UNSUPPORTED;
+    break;
+  }
+
+  if (*p != '\0') {
+    p++;
+  }
+
+  return p;
+}
+
+/* Copy the arguments into the record and return -1 if the arguments
+ * cannot be captured */
+static int capture_args(struct log_record *rec, const char *fmt, va_list ap)
+{
+  struct conv_spec spec;
+  const char *p = fmt;
+
+#define push_arg(field, value) do {                     \
+    if (rec->arg_count == LOG_RECORD_ARG_MAX) {         \
+      return -1;                                        \
+    }                                                   \
+    rec->args[rec->arg_count++].field = (value);        \
+  } while (0)
+
+  while ((p = strchr(p, '%')) != NULL) {
+    p = parse_conversion(p, &spec);
+
+    if (spec.class == CONV_LITERAL_PERCENT) {
+      continue;
+    }
+    if (spec.class == CONV_UNSUPPORTED) {
+      return -1;
+    }
+
+    if (spec.width_star) {
+      push_arg(i, va_arg(ap, int));
+    }
+    if (spec.prec_star) {
+      push_arg(i, va_arg(ap, int));
+    }
+
+    switch (spec.class) {
+    case CONV_SIGNED:
+      switch (spec.length) {
+      case LEN_L:
+        push_arg(i, va_arg(ap, long));
+        break;
+      case LEN_LL:
+        push_arg(i, va_arg(ap, long long));
+        break;
+      case LEN_J:
+        push_arg(i, va_arg(ap, intmax_t));
+        break;
+      case LEN_Z:
+        push_arg(i, va_arg(ap, ssize_t));
+        break;
+      case LEN_T:
+        push_arg(i, va_arg(ap, ptrdiff_t));
+        break;
+      default:
+        push_arg(i, va_arg(ap, int));
+        break;
+      }
+      break;
+    case CONV_UNSIGNED:
+      switch (spec.length) {
+      case LEN_L:
+        push_arg(u, va_arg(ap, unsigned long));
+        break;
+      case LEN_LL:
+        push_arg(u, va_arg(ap, unsigned long long));
+        break;
+      case LEN_J:
+        push_arg(u, va_arg(ap, uintmax_t));
+        break;
+      case LEN_Z:
+        push_arg(u, va_arg(ap, size_t));
+        break;
+      case LEN_T:
+        push_arg(u, va_arg(ap, ptrdiff_t));
+        break;
+      default:
+        push_arg(u, va_arg(ap, unsigned int));
+        break;
+      }
+      break;
+    case CONV_CHAR:
+      push_arg(i, va_arg(ap, int));
+      break;
+    case CONV_FLOAT:
+      if (spec.length == LEN_BIG_L) {
+        push_arg(d, va_arg(ap, long double));
+      } else {
+        push_arg(d, va_arg(ap, double));
+      }
+      break;
+    case CONV_POINTER:
+      push_arg(p, va_arg(ap, void *));
+      break;
+    case CONV_STRING:
+      {
+        const char *s = va_arg(ap, const char *);
+        if (s == NULL) {
+          s = "(null)";
+        }
+        size_t avail = LOG_RECORD_STR_MAX - rec->str_len;
+        if (avail == 0) {
+          return -1;
+        }
+        size_t len = strlen(s);
+        if (len > avail - 1) {
+          len = avail - 1;
+        }
+        memcpy(rec->str + rec->str_len, s, len);
+        rec->str[rec->str_len + len] = '\0';
+        push_arg(str_offset, rec->str_len);
+        rec->str_len += len + 1;
+      }
+      break;
+    default:
+      return -1;
+    }
+  }
+
+#undef push_arg
+
+  return 0;
+}
+
+static struct log_ring *ring_create(void)
+{
+  struct log_ring *ring = malloc(sizeof(*ring));
+  if (ring == NULL) {
+    return NULL;
+  }
+  memset(ring, 0, sizeof(*ring));
+
+  ring->slot_count = ring_slot_count;
+  ring->slots = malloc(sizeof(*ring->slots) * ring->slot_count);
+  if (ring->slots == NULL) {
+    free(ring);
+    return NULL;
+  }
+  /* Prefault the slots */
+  memset(ring->slots, 0, sizeof(*ring->slots) * ring->slot_count);
+
+  return ring;
+}
+
+/* Return the ring buffer of the calling thread or NULL if there is
+ * insufficient memory */
+static struct log_ring *my_ring(void)
+{
+  struct log_ring *ring = pthread_getspecific(ring_key);
+  if (ring != NULL && !ring->detached) {
+    return ring;
+  }
+
+  pthread_mutex_lock(&registry_lock);
+  if (ring != NULL) {
+    ring_destroy(ring);
+  }
+  ring = ring_create();
+  if (ring != NULL) {
+    ring->next = registry;
+    registry = ring;
+  }
+  pthread_setspecific(ring_key, ring);
+  pthread_mutex_unlock(&registry_lock);
+
+  return ring;
+}
+
+static const char *kind_prefix(enum utility_log_kind kind)
+{
+  switch (kind) {
+  case UTILITY_LOG_ERROR:
+    return "[ERROR] ";
+  case UTILITY_LOG_FATAL:
+    return "[FATAL] ";
+  default:
+    return "";
+  }
+}
+
+static const char *kind_name(enum utility_log_kind kind)
+{
+  switch (kind) {
+  case UTILITY_LOG_DEBUG:
+    return "debug";
+  case UTILITY_LOG_VERBOSE:
+    return "verbose";
+  case UTILITY_LOG_ERROR:
+    return "error";
+  default:
+    return "fatal";
+  }
+}
+
+/* Print the first len characters of s escaped as in a JSON string */
+static void print_escaped(FILE *stream, const char *s, size_t len)
+{
+  size_t i;
+  for (i = 0; i < len; i++) {
+    unsigned char c = s[i];
+    switch (c) {
+    case '"':
+      fputs("\\\"", stream);
+      break;
+    case '\\':
+      fputs("\\\\", stream);
+      break;
+    case '\n':
+      fputs("\\n", stream);
+      break;
+    case '\t':
+      fputs("\\t", stream);
+      break;
+    default:
+      if (c < 0x20) {
+        fprintf(stream, "\\u%04x", c);
+      } else {
+        putc(c, stream);
+      }
+      break;
+    }
+  }
+}
+
+/* Must be called with the logging stream locked */
+static void print_structured(FILE *stream, enum utility_log_format format,
+                             const struct timespec *t, pthread_t tid,
+                             enum utility_log_kind kind,
+                             const char *fn, const char *file, unsigned line,
+                             const char *msg)
+{
+  size_t msg_len = strlen(msg);
+  while (msg_len > 0 && msg[msg_len - 1] == '\n') {
+    msg_len--;
+  }
+
+  int json = (format == UTILITY_LOG_FORMAT_JSON);
+
+  fprintf(stream, json ? "{\"t\":%ld.%09ld,\"prog\":\"" : "t=%ld.%09ld prog=\"",
+          (long) t->tv_sec, t->tv_nsec);
+  print_escaped(stream, prog_name, strlen(prog_name));
+  fprintf(stream,
+          json
+          ? "\",\"pid\":%lu,\"tid\":%lu,\"level\":\"%s\",\"fn\":\""
+          : "\" pid=%lu tid=%lu level=%s fn=\"",
+          (unsigned long) getpid(), (unsigned long) tid, kind_name(kind));
+  print_escaped(stream, fn, strlen(fn));
+  fputs(json ? "\",\"file\":\"" : "\" file=\"", stream);
+  print_escaped(stream, file, strlen(file));
+  fprintf(stream, json ? "\",\"line\":%u,\"msg\":\"" : "\" line=%u msg=\"",
+          line);
+  print_escaped(stream, msg, msg_len);
+  fputs(json ? "\"}\n" : "\"\n", stream);
+}
+
+int utility_log_write(enum utility_log_kind kind,
+                      const char *fn, const char *file, unsigned line,
+                      const char *fmt, ...)
+{
+  int saved_errno = errno;
+  va_list ap;
+
+  if (kind == UTILITY_LOG_FATAL || !utility_log_async_is_on()) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    char msg[LOG_MSG_MAX];
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+
+    flockfile(log_stream);
+    enum utility_log_format format = utility_log_get_format();
+    if (format == UTILITY_LOG_FORMAT_PLAIN) {
+      fprintf(log_stream, "%s[%lu][%lu][%s@%s:%u]: %s%s",
+              prog_name,
+              (unsigned long) getpid(),
+              (unsigned long) pthread_self(),
+              fn, file, line, kind_prefix(kind), msg);
+    } else {
+      print_structured(log_stream, format, &t, pthread_self(), kind,
+                       fn, file, line, msg);
+    }
+    funlockfile(log_stream);
+
+    errno = saved_errno;
+    return 0;
+  }
+
+  struct log_ring *ring = my_ring();
+  if (ring == NULL) {
+    errno = saved_errno;
+    return -1;
+  }
+
+  unsigned long head = ring->head;
+  if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)
+      == ring->slot_count) {
+    __atomic_store_n(&ring->drop_count, ring->drop_count + 1,
+                     __ATOMIC_RELAXED);
+    errno = saved_errno;
+    return -1;
+  }
+
+  struct log_record *rec = &ring->slots[head % ring->slot_count];
+  clock_gettime(CLOCK_MONOTONIC, &rec->t);
+  rec->tid = pthread_self();
+  rec->fmt = fmt;
+  rec->fn = fn;
+  rec->file = file;
+  rec->line = line;
+  rec->kind = kind;
+  rec->preformatted = 0;
+  rec->arg_count = 0;
+  rec->str_len = 0;
+
+  va_list ap_fallback;
+  va_start(ap, fmt);
+  va_copy(ap_fallback, ap);
+  if (capture_args(rec, fmt, ap) != 0) {
+    rec->preformatted = 1;
+    vsnprintf(rec->str, sizeof(rec->str), fmt, ap_fallback);
+  }
+  va_end(ap_fallback);
+  va_end(ap);
+
+  __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+
+  errno = saved_errno;
+  return 0;
+}
+
+/* Print only the message of the record */
+static void record_print_msg(FILE *stream, const struct log_record *rec)
+{
+  if (rec->preformatted) {
+    fputs(rec->str, stream);
+    return;
+  }
+
+  struct conv_spec spec;
+  const char *p = rec->fmt;
+  unsigned arg_idx = 0;
+  while (*p != '\0') {
+    if (*p != '%') {
+      const char *end = strchr(p, '%');
+      if (end == NULL) {
+        fputs(p, stream);
+        break;
+      }
+      fwrite(p, 1, end - p, stream);
+      p = end;
+      continue;
+    }
+
+    p = parse_conversion(p, &spec);
+    if (spec.class == CONV_LITERAL_PERCENT) {
+      putc('%', stream);
+      continue;
+    }
+
+    /* Rebuild the conversion specification with any '*' resolved */
+    char spec_str[128];
+    int spec_len = snprintf(spec_str, sizeof(spec_str), "%%%.*s",
+                            (int) spec.flags_len, spec.flags);
+    if (spec.width_star) {
+      spec_len += snprintf(spec_str + spec_len, sizeof(spec_str) - spec_len,
+                           "%d", (int) rec->args[arg_idx++].i);
+    } else {
+      spec_len += snprintf(spec_str + spec_len, sizeof(spec_str) - spec_len,
+                           "%.*s", (int) spec.width_len, spec.width);
+    }
+    if (spec.prec_star) {
+      int prec = rec->args[arg_idx++].i;
+      if (prec >= 0) {
+        spec_len += snprintf(spec_str + spec_len,
+                             sizeof(spec_str) - spec_len, ".%d", prec);
+      }
+    } else if (spec.has_prec) {
+      spec_len += snprintf(spec_str + spec_len, sizeof(spec_str) - spec_len,
+                           ".%.*s", (int) spec.prec_len, spec.prec);
+    }
+    snprintf(spec_str + spec_len, sizeof(spec_str) - spec_len, "%.*s%c",
+             (int) spec.length_len, spec.length_str, spec.conversion);
+
+    const union log_arg *arg = &rec->args[arg_idx++];
+    switch (spec.class) {
+    case CONV_SIGNED:
+      switch (spec.length) {
+      case LEN_L:
+        fprintf(stream, spec_str, (long) arg->i);
+        break;
+      case LEN_LL:
+        fprintf(stream, spec_str, (long long) arg->i);
+        break;
+      case LEN_J:
+        fprintf(stream, spec_str, arg->i);
+        break;
+      case LEN_Z:
+        fprintf(stream, spec_str, (ssize_t) arg->i);
+        break;
+      case LEN_T:
+        fprintf(stream, spec_str, (ptrdiff_t) arg->i);
+        break;
+      default:
+        fprintf(stream, spec_str, (int) arg->i);
+        break;
+      }
+      break;
+    case CONV_UNSIGNED:
+      switch (spec.length) {
+      case LEN_L:
+        fprintf(stream, spec_str, (unsigned long) arg->u);
+        break;
+      case LEN_LL:
+        fprintf(stream, spec_str, (unsigned long long) arg->u);
+        break;
+      case LEN_J:
+        fprintf(stream, spec_str, arg->u);
+        break;
+      case LEN_Z:
+        fprintf(stream, spec_str, (size_t) arg->u);
+        break;
+      case LEN_T:
+        fprintf(stream, spec_str, (ptrdiff_t) arg->u);
+        break;
+      default:
+        fprintf(stream, spec_str, (unsigned int) arg->u);
+        break;
+      }
+      break;
+    case CONV_CHAR:
+      fprintf(stream, spec_str, (int) arg->i);
+      break;
+    case CONV_FLOAT:
+      if (spec.length == LEN_BIG_L) {
+        fprintf(stream, spec_str, arg->d);
+      } else {
+        fprintf(stream, spec_str, (double) arg->d);
+      }
+      break;
+    case CONV_POINTER:
+      fprintf(stream, spec_str, arg->p);
+      break;
+    case CONV_STRING:
+      fprintf(stream, spec_str, rec->str + arg->str_offset);
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+/* Must be called with the logging stream and registry_lock locked */
+static void record_print(FILE *stream, const struct log_record *rec)
+{
+  enum utility_log_format format = utility_log_get_format();
+
+  if (format == UTILITY_LOG_FORMAT_PLAIN) {
+    fprintf(stream, "%s[%lu][%lu][%s@%s:%u]: %s",
+            prog_name,
+            (unsigned long) getpid(),
+            (unsigned long) rec->tid,
+            rec->fn, rec->file, rec->line, kind_prefix(rec->kind));
+    record_print_msg(stream, rec);
+    return;
+  }
+
+  const char *msg = rec->str;
+  if (!rec->preformatted) {
+    formatter_msg[0] = '\0';
+    FILE *msg_stream = fmemopen(formatter_msg, sizeof(formatter_msg) - 1, "w");
+    if (msg_stream != NULL) {
+      record_print_msg(msg_stream, rec);
+      fclose(msg_stream);
+    }
+    formatter_msg[sizeof(formatter_msg) - 1] = '\0';
+    msg = formatter_msg;
+  }
+  print_structured(stream, format, &rec->t, rec->tid, rec->kind,
+                   rec->fn, rec->file, rec->line, msg);
+}
+
+static int timespec_lt(const struct timespec *a, const struct timespec *b)
+{
+  return (a->tv_sec < b->tv_sec
+          || (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec));
+}
+
+/* Write all records pending at the time of invocation in timestamp
+ * order. Must be called with registry_lock held. */
+static void drain(void)
+{
+  struct log_ring *ring;
+  for (ring = registry; ring != NULL; ring = ring->next) {
+    ring->head_snapshot = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+  }
+
+  flockfile(log_stream);
+  while (1) {
+    struct log_ring *earliest = NULL;
+    for (ring = registry; ring != NULL; ring = ring->next) {
+      if (ring->head_snapshot == ring->tail) {
+        continue;
+      }
+      if (earliest == NULL
+          || timespec_lt(&ring->slots[ring->tail % ring->slot_count].t,
+                         &earliest->slots[earliest->tail
+                                          % earliest->slot_count].t)) {
+        earliest = ring;
+      }
+    }
+    if (earliest == NULL) {
+      break;
+    }
+
+    record_print(log_stream,
+                 &earliest->slots[earliest->tail % earliest->slot_count]);
+    __atomic_store_n(&earliest->tail, earliest->tail + 1, __ATOMIC_RELEASE);
+  }
+  funlockfile(log_stream);
+  fflush(log_stream);
+
+  /* Free the rings of exited threads */
+  struct log_ring **ptr = &registry;
+  while (*ptr != NULL) {
+    ring = *ptr;
+    if (ring->orphaned) {
+      *ptr = ring->next;
+      registry_drop_count += ring->drop_count;
+      ring_destroy(ring);
+    } else {
+      ptr = &ring->next;
+    }
+  }
+}
+
+static void *formatter_thread(void *args)
+{
+  struct timespec t_wakeup;
+  clock_gettime(CLOCK_MONOTONIC, &t_wakeup);
+
+  pthread_mutex_lock(&registry_lock);
+  while (!formatter_stopped) {
+    t_wakeup.tv_sec += flush_period.tv_sec;
+    t_wakeup.tv_nsec += flush_period.tv_nsec;
+    if (t_wakeup.tv_nsec >= 1000000000) {
+      t_wakeup.tv_sec++;
+      t_wakeup.tv_nsec -= 1000000000;
+    }
+    pthread_cond_timedwait(&formatter_wakeup, &registry_lock, &t_wakeup);
+
+    drain();
+  }
+  pthread_mutex_unlock(&registry_lock);
+
+  return NULL;
+}
+
+void utility_log_set_format(enum utility_log_format format)
+{
+  __atomic_store_n(&log_format, format, __ATOMIC_RELEASE);
+}
+
+enum utility_log_format utility_log_get_format(void)
+{
+  return __atomic_load_n(&log_format, __ATOMIC_ACQUIRE);
+}
+
+int utility_log_is_plain_sync(void)
+{
+  return (!utility_log_async_is_on()
+          && utility_log_get_format() == UTILITY_LOG_FORMAT_PLAIN);
+}
+
+int utility_log_async_is_on(void)
+{
+  return __atomic_load_n(&async_on, __ATOMIC_ACQUIRE);
+}
+
+int utility_log_async_start(unsigned long slot_count,
+                            const struct timespec *period)
+{
+  pthread_once(&init_once, init);
+
+  if (utility_log_async_is_on()) {
+    return -1;
+  }
+
+  ring_slot_count = (slot_count == 0 ? LOG_RING_SLOT_COUNT_DEFAULT
+                     : slot_count);
+  if (period == NULL) {
+    flush_period.tv_sec = 0;
+    flush_period.tv_nsec = LOG_FLUSH_PERIOD_NS_DEFAULT;
+  } else {
+    flush_period = *period;
+  }
+  registry_drop_count = 0;
+  formatter_stopped = 0;
+
+  if ((errno = pthread_create(&formatter, NULL, formatter_thread, NULL))
+      != 0) {
+    log_syserror("Cannot create the log formatting thread");
+    return -2;
+  }
+
+  __atomic_store_n(&async_on, 1, __ATOMIC_RELEASE);
+
+  return 0;
+}
+
+int utility_log_async_stop(void)
+{
+  if (!utility_log_async_is_on()) {
+    return -1;
+  }
+
+  __atomic_store_n(&async_on, 0, __ATOMIC_RELEASE);
+  pthread_mutex_lock(&registry_lock);
+  formatter_stopped = 1;
+  pthread_cond_signal(&formatter_wakeup);
+  pthread_mutex_unlock(&registry_lock);
+  if ((errno = pthread_join(formatter, NULL)) != 0) {
+    log_syserror("Cannot join the log formatting thread");
+  }
+
+  pthread_mutex_lock(&registry_lock);
+  drain();
+
+  unsigned long dropped = registry_drop_count;
+  struct log_ring *mine = pthread_getspecific(ring_key);
+  struct log_ring *ring = registry;
+  while (ring != NULL) {
+    struct log_ring *next = ring->next;
+    dropped += ring->drop_count;
+    if (ring == mine) {
+      ring_destroy(ring);
+      pthread_setspecific(ring_key, NULL);
+    } else {
+      ring->detached = 1;
+    }
+    ring = next;
+  }
+  registry = NULL;
+  registry_drop_count = dropped;
+  pthread_mutex_unlock(&registry_lock);
+
+  if (dropped != 0) {
+    log_error("%lu log records were dropped due to full ring buffers",
+              dropped);
+  }
+
+  return 0;
+}
+
+int utility_log_async_thread_init(void)
+{
+  if (!utility_log_async_is_on()) {
+    return -1;
+  }
+
+  if (my_ring() == NULL) {
+    return -2;
+  }
+
+  return 0;
+}
+
+void utility_log_async_flush(void)
+{
+  if (!utility_log_async_is_on()) {
+    return;
+  }
+
+  pthread_mutex_lock(&registry_lock);
+  drain();
+  pthread_mutex_unlock(&registry_lock);
+}
+
+unsigned long utility_log_async_dropped_count(void)
+{
+  pthread_mutex_lock(&registry_lock);
+  unsigned long dropped = registry_drop_count;
+  struct log_ring *ring;
+  for (ring = registry; ring != NULL; ring = ring->next) {
+    dropped += __atomic_load_n(&ring->drop_count, __ATOMIC_RELAXED);
+  }
+  pthread_mutex_unlock(&registry_lock);
+
+  return dropped;
+}
@@ -31,17 +31,41 @@
  *
  * User is responsible for opening the logging stream as well as
  * closing it to avoid any loss of log message.
+ *
+ * By default, a log message is formatted and written by the logging
+ * thread itself while holding the lock of the logging stream. Since
+ * doing so inside an RT thread introduces an unbounded delay, an
+ * asynchronous backend can be turned on with utility_log_async_start().
+ * While the asynchronous backend is on, log_verbose(), log_error() and
+ * log_syserror() only copy the format string pointer, the arguments,
+ * a CLOCK_MONOTONIC timestamp and the thread ID into a lock-free ring
+ * buffer owned by the logging thread. A background thread then
+ * formats the records of all threads in timestamp order and writes
+ * them to the logging stream using the same format as above.
+ * fatal_error() and fatal_syserror() always write synchronously after
+ * flushing the pending records so that no message is lost when the
+ * program exits.
+ *
+ * For machine ingestion, utility_log_set_format() switches to a
+ * structured output format carrying a CLOCK_MONOTONIC timestamp. To
+ * remove the cost of less important messages entirely, see the
+ * compile-time log levels.
  */
 
 #ifndef UTILITY_LOG_H
 #define UTILITY_LOG_H
 
+#include <sys/types.h>
 #include <errno.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
 #include <unistd.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
 
 /**
  * @name Collection of functions that should not be used in normal circumstances
@@ -96,6 +120,50 @@
 /** @} End of collection of functions that should not be used in
     normal circumstances */
 
+/**
+ * @name Compile-time log levels
+ *
+ * Define UTILITY_LOG_LEVEL before including this header (e.g., by
+ * invoking `make LOG_LEVEL=UTILITY_LOG_LEVEL_ERROR') to compile out
+ * the logging functions whose level is above the defined one. A
+ * compiled-out logging function evaluates neither its message nor
+ * its arguments. The message and the arguments are still type
+ * checked. fatal_error() and fatal_syserror() are never compiled out.
+ * @{
+ */
+#define UTILITY_LOG_LEVEL_FATAL 0 /**< Only fatal messages. */
+#define UTILITY_LOG_LEVEL_ERROR 1 /**< Also log_error() and log_syserror(). */
+#define UTILITY_LOG_LEVEL_VERBOSE 2 /**< Also log_verbose(). */
+#define UTILITY_LOG_LEVEL_DEBUG 3 /**< Also log_debug(). */
+
+#ifndef UTILITY_LOG_LEVEL
+/** All logging functions are compiled in by default. */
+#define UTILITY_LOG_LEVEL UTILITY_LOG_LEVEL_DEBUG
+#endif
+/** @} End of compile-time log levels */
+
+/* The replacement of a compiled-out logging function */
+#define log_discard(msg, ...)				\
+  do {							\
+    if (0) {						\
+      fprintf(log_stream, msg , ## __VA_ARGS__);	\
+    }							\
+  } while (0)
+
+/* Common function to both log_verbose() and log_debug() */
+#define log_verbose_core(kind, msg, ...)			\
+  do {								\
+    if (utility_log_is_plain_sync()) {				\
+      flockfile(log_stream);					\
+      log_hdr(log_stream);					\
+      fprintf(log_stream, msg , ## __VA_ARGS__);		\
+      funlockfile(log_stream);					\
+    } else {							\
+      utility_log_write(kind, __FUNCTION__, __FILE__, __LINE__,	\
+			msg , ## __VA_ARGS__);			\
+    }								\
+  } while (0)
+
 /**
  * Log the given message as it is to the logging stream. This is a
  * wrapper over printf-like function and so accepts things like
@@ -107,13 +175,26 @@
  *
  * @hideinitializer
  */
-#define log_verbose(msg, ...)			\
-  do {						\
-    flockfile(log_stream);			\
-    log_hdr(log_stream);			\
-    fprintf(log_stream, msg , ## __VA_ARGS__);	\
-    funlockfile(log_stream);			\
-  } while (0)
+#if UTILITY_LOG_LEVEL >= UTILITY_LOG_LEVEL_VERBOSE
+#define log_verbose(msg, ...)					\
+  log_verbose_core(UTILITY_LOG_VERBOSE, msg, ## __VA_ARGS__)
+#else
+#define log_verbose(msg, ...) log_discard(msg, ## __VA_ARGS__)
+#endif
+
+/**
+ * Work just like log_verbose() but is meant for high-volume messages
+ * like those produced in every iteration of a loop so that they can
+ * be compiled out separately from the other verbose messages.
+ *
+ * @hideinitializer
+ */
+#if UTILITY_LOG_LEVEL >= UTILITY_LOG_LEVEL_DEBUG
+#define log_debug(msg, ...)					\
+  log_verbose_core(UTILITY_LOG_DEBUG, msg, ## __VA_ARGS__)
+#else
+#define log_debug(msg, ...) log_discard(msg, ## __VA_ARGS__)
+#endif
 
 /* Common function to both log_error() and fatal_error() */
 #define log_error_core(hdr, msg, ...)			\
@@ -124,6 +205,18 @@
     funlockfile(log_stream);				\
   } while (0)
 
+/* Common function to both log_error() and fatal_error() that is aware
+ * of the asynchronous backend and the output format */
+#define log_error_dispatch(kind, hdr, msg, ...)			\
+  do {								\
+    if (utility_log_is_plain_sync()) {				\
+      log_error_core(hdr, msg, ## __VA_ARGS__);			\
+    } else {							\
+      utility_log_write(kind, __FUNCTION__, __FILE__, __LINE__,	\
+			msg "\n" , ## __VA_ARGS__);		\
+    }								\
+  } while (0)
+
 /**
  * Log the given message by appending a newline at the end of the
  * message to the logging stream. This is a wrapper over printf-like
@@ -137,7 +230,12 @@
  *
  * @hideinitializer
  */
-#define log_error(msg, ...) log_error_core(log_hdr_error, msg, ## __VA_ARGS__)
+#if UTILITY_LOG_LEVEL >= UTILITY_LOG_LEVEL_ERROR
+#define log_error(msg, ...)						\
+  log_error_dispatch(UTILITY_LOG_ERROR, log_hdr_error, msg, ## __VA_ARGS__)
+#else
+#define log_error(msg, ...) log_discard(msg, ## __VA_ARGS__)
+#endif
 
 /**
  * Work just like log_error() but exit the program with function
@@ -147,11 +245,13 @@
  *
  * @hideinitializer
  */
-#define fatal_error(msg, ...)				\
-  do {							\
-    log_error_core(log_hdr_fatal, msg, ## __VA_ARGS__);	\
-    fflush(log_stream);					\
-    exit(EXIT_FAILURE);					\
+#define fatal_error(msg, ...)						\
+  do {									\
+    utility_log_async_flush();						\
+    log_error_dispatch(UTILITY_LOG_FATAL, log_hdr_fatal,		\
+		       msg, ## __VA_ARGS__);				\
+    fflush(log_stream);							\
+    exit(EXIT_FAILURE);							\
   } while (0)
 
 #define log_syserror_core(hdr, msg, ...)				\
@@ -163,6 +263,16 @@
     funlockfile(log_stream);						\
   } while (0)
 
+#define log_syserror_dispatch(kind, hdr, msg, ...)			\
+  do {									\
+    if (utility_log_is_plain_sync()) {					\
+      log_syserror_core(hdr, msg, ## __VA_ARGS__);			\
+    } else {								\
+      utility_log_write(kind, __FUNCTION__, __FILE__, __LINE__,		\
+			msg " (%s)\n" , ## __VA_ARGS__, strerror(errno));	\
+    }									\
+  } while (0)
+
 /**
  * Log the given message by appending the result of
  * <code>strerror(errno)</code> and a newline at the end of the
@@ -176,8 +286,13 @@
  *
  * @hideinitializer
  */
-#define log_syserror(msg, ...)				\
-  log_syserror_core(log_hdr_error, msg, ## __VA_ARGS__)
+#if UTILITY_LOG_LEVEL >= UTILITY_LOG_LEVEL_ERROR
+#define log_syserror(msg, ...)						\
+  log_syserror_dispatch(UTILITY_LOG_ERROR, log_hdr_error,		\
+			msg, ## __VA_ARGS__)
+#else
+#define log_syserror(msg, ...) log_discard(msg, ## __VA_ARGS__)
+#endif
 
 /**
  * This works just like log_syserror() but exit the program with
@@ -189,7 +304,9 @@
  */
 #define fatal_syserror(msg, ...)					\
   do {									\
-    log_syserror_core(log_hdr_fatal, msg , ## __VA_ARGS__);		\
+    utility_log_async_flush();						\
+    log_syserror_dispatch(UTILITY_LOG_FATAL, log_hdr_fatal,		\
+			  msg, ## __VA_ARGS__);				\
     fflush(log_stream);							\
     exit(EXIT_FAILURE);							\
   } while (0)
@@ -209,6 +326,162 @@ extern "C" {
    */
   extern FILE *log_stream;
 
+  /**
+   * The kinds of log messages.
+   */
+  enum utility_log_kind {
+    UTILITY_LOG_DEBUG, /**< Written by log_debug(). */
+    UTILITY_LOG_VERBOSE, /**< Written by log_verbose(). */
+    UTILITY_LOG_ERROR, /**< Written by log_error() and log_syserror(). */
+    UTILITY_LOG_FATAL, /**< Written by fatal_error() and fatal_syserror(). */
+  };
+
+  /**
+   * The output formats of log messages.
+   */
+  enum utility_log_format {
+    /** The format described in @ref utility_log.h (the default). */
+    UTILITY_LOG_FORMAT_PLAIN,
+    /**
+     * One JSON object per line:
+     * @code
+     * {"t":T,"prog":"P","pid":PID,"tid":TID,"level":"L","fn":"F","file":"S","line":N,"msg":"M"}
+     * @endcode
+     */
+    UTILITY_LOG_FORMAT_JSON,
+    /**
+     * One line of space-separated key=value pairs:
+     * @code
+     * t=T prog="P" pid=PID tid=TID level=L fn="F" file="S" line=N msg="M"
+     * @endcode
+     */
+    UTILITY_LOG_FORMAT_KEY_VALUE,
+  };
+
+  /**
+   * @name Collection of structured output functions
+   * @{
+   */
+
+  /**
+   * Set the output format of subsequent log messages. In a structured
+   * format, T is the CLOCK_MONOTONIC time in seconds at which the
+   * message is logged, L is one of debug, verbose, error and fatal,
+   * the trailing newlines of the message are removed, and any double
+   * quote, backslash and control character in a string is escaped as
+   * in JSON.
+   *
+   * @param format the desired output format.
+   */
+  void utility_log_set_format(enum utility_log_format format);
+
+  /**
+   * @return the current output format.
+   */
+  enum utility_log_format utility_log_get_format(void);
+
+  /**
+   * @return non-zero if the logging functions format and write the
+   * plain format by themselves (i.e., neither the asynchronous backend
+   * nor a structured format is in use).
+   */
+  int utility_log_is_plain_sync(void);
+
+  /**
+   * Log a message using the asynchronous backend if it is on and the
+   * message is not fatal, or in the current output format
+   * otherwise. This should not be used directly; use the logging
+   * macros instead.
+   *
+   * The format string, the function name and the file name must stay
+   * valid until the record is formatted (i.e., they should be string
+   * literals). A string argument resolving a %s conversion is copied
+   * and truncated if it does not fit into the record. Conversions
+   * that cannot be captured as arguments (e.g., %n and %m) cause the
+   * message to be formatted by the calling thread instead.
+   *
+   * @return zero if the message is written or -1 if it is dropped.
+   */
+  int utility_log_write(enum utility_log_kind kind,
+			const char *fn, const char *file, unsigned line,
+			const char *fmt, ...)
+    __attribute__((format(printf, 5, 6)));
+
+  /** @} End of collection of structured output functions */
+
+  /**
+   * @name Collection of asynchronous logging backend functions
+   * @{
+   */
+
+  /**
+   * Turn on the asynchronous logging backend. This creates the
+   * background formatting thread. The calling thread is not required
+   * to be the main thread, but only one asynchronous backend can be on
+   * at a time in a process. A child process created with fork() falls
+   * back to the synchronous backend.
+   *
+   * The background formatting thread is a normal thread. If RT
+   * threads monopolize the CPU, the ring buffers may fill up, and any
+   * record that does not fit is dropped and counted instead of
+   * blocking the logging thread (c.f.,
+   * utility_log_async_dropped_count()).
+   *
+   * @param slot_count the number of log records that the ring buffer
+   * of each logging thread can hold. Pass zero to use the default of
+   * 256 records.
+   * @param flush_period the time the background thread sleeps between
+   * two successive passes of formatting pending records. Pass NULL to
+   * use the default of 10 ms.
+   *
+   * @return zero if the backend is turned on, -1 if it is already on,
+   * or -2 in case of hard error that requires the investigation of
+   * the output of the logging facility to fix the error.
+   */
+  int utility_log_async_start(unsigned long slot_count,
+			      const struct timespec *flush_period);
+
+  /**
+   * Turn off the asynchronous logging backend after writing all
+   * pending records to the logging stream and reporting the number of
+   * dropped records, if any. A record written by another thread while
+   * this function is being executed may be lost. Afterwards, the
+   * logging functions become synchronous again.
+   *
+   * @return zero if the backend is turned off or -1 if it was not on.
+   */
+  int utility_log_async_stop(void);
+
+  /**
+   * Allocate the ring buffer of the calling thread in advance. A
+   * thread that logs asynchronously for the first time allocates its
+   * ring buffer with malloc(). So, an RT thread should call this
+   * before entering its time-critical section.
+   *
+   * @return zero if the ring buffer is available, -1 if the backend
+   * is not on, or -2 if there is insufficient memory.
+   */
+  int utility_log_async_thread_init(void);
+
+  /**
+   * Write all pending records to the logging stream. This is a no-op
+   * if the asynchronous backend is not on.
+   */
+  void utility_log_async_flush(void);
+
+  /**
+   * @return the number of records dropped since the asynchronous
+   * backend was last turned on because of full ring buffers.
+   */
+  unsigned long utility_log_async_dropped_count(void);
+
+  /**
+   * @return non-zero if the asynchronous backend is on.
+   */
+  int utility_log_async_is_on(void);
+
+  /** @} End of collection of asynchronous logging backend functions */
+
 #ifdef __cplusplus
 }
 #endif
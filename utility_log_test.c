@@ -127,7 +127,7 @@ MAIN_UNIT_TEST_BEGIN("utility_log_test", "stderr", NULL, cleanup)
     if (id == -1) {				\
       skip_line_section(']');			\
     } else {					\
-      cmp_token(rc, "%u", (unsigned int) id);	\
+      cmp_token(rc, "%lu", (unsigned long) id);	\
     }						\
     gracious_assert(*ptr++ == ']');		\
   } while (0)
@@ -373,6 +373,252 @@ MAIN_UNIT_TEST_BEGIN("utility_log_test", "stderr", NULL, cleanup)
     end_subprocess_log_inspection();
   }
 
+  /* Testcase 3: asynchronous logging from within a process */
+  child_pid = fork();
+  if (child_pid == 0) {
+    setup_subprocess_log_stream();
+
+    if (utility_log_async_start(0, NULL) != 0) {
+      fatal_error("Cannot start asynchronous logging");
+    }
+    gracious_assert(utility_log_async_start(0, NULL) == -1);
+
+    log_verbose("log_verbose %d %s %5.2f %lu %c %*d %%\n",
+                -7, "str", 3.14159, 42UL, 'x', 4, 9);
+    log_error("log_error");
+    errno = ENAMETOOLONG;
+    log_syserror("log_syserror");
+    errno = ENOEXEC;
+    fatal_syserror("fatal_syserror");
+
+    return EXIT_SUCCESS;
+  } else if (child_pid == -1) {
+    fatal_syserror("Cannot create subprocess for testcase 3");
+  } else {
+    begin_subprocess_log_inspection(EXIT_FAILURE);
+
+    assert_line("log_verbose -7 str  3.14 42 x    9 %%\n");
+    assert_line("[ERROR] log_error\n");
+    assert_line("[ERROR] log_syserror (%s)\n", strerror(ENAMETOOLONG));
+    assert_line("[FATAL] fatal_syserror (%s)\n", strerror(ENOEXEC));
+    gracious_assert(fgets(buffer, sizeof(buffer), log_file) == NULL);
+
+    end_subprocess_log_inspection();
+  }
+
+  /* Testcase 4: asynchronous logging from within threads */
+  child_pid = fork();
+  if (child_pid == 0) {
+    setup_subprocess_log_stream();
+
+    struct {
+      pthread_t thread;
+      int exit_status;
+    } thread_data[2];
+    int thread_data_count = sizeof(thread_data) / sizeof(*thread_data);
+
+    if (green_light_initialized) {
+      if (pthread_barrier_destroy(&green_light) != 0) {
+	fatal_syserror("Cannot destroy thread's green light");
+      }
+    }
+    if (pthread_barrier_init(&green_light, NULL, thread_data_count + 1) != 0) {
+      fatal_syserror("Cannot initialize thread's green light");
+    }
+
+    if (utility_log_async_start(0, NULL) != 0) {
+      fatal_error("Cannot start asynchronous logging");
+    }
+
+    int idx;
+    for (idx = 0; idx < thread_data_count; idx++) {
+      if (pthread_create(&thread_data[idx].thread, NULL,
+  			 run_thread, &thread_data[idx].exit_status) != 0) {
+  	fatal_syserror("Cannot create thread #%d", idx);
+      }
+    }
+
+    int rc = pthread_barrier_wait(&green_light);
+    if (rc != 0 && rc != PTHREAD_BARRIER_SERIAL_THREAD) {
+      errno = rc;
+      fatal_syserror("Cannot turn on the thread's green light");
+    }
+
+    for (idx = 0; idx < thread_data_count; idx++) {
+      if (pthread_join(thread_data[idx].thread, NULL) != 0) {
+  	fatal_syserror("Cannot join thread #%d", idx);
+      }
+    }
+
+    gracious_assert(utility_log_async_dropped_count() == 0);
+    if (utility_log_async_stop() != 0) {
+      fatal_error("Cannot stop asynchronous logging");
+    }
+    gracious_assert(utility_log_async_stop() == -1);
+    pthread_barrier_destroy(&green_light);
+
+    for (idx = 0; idx < thread_data_count; idx++) {
+      if (thread_data[idx].exit_status != EXIT_SUCCESS) {
+	fatal_error("Thread #%d fails", idx);
+      }
+    }
+
+    if (fclose(log_stream) != 0) {
+      return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+  } else if (child_pid == -1) {
+    fatal_syserror("Cannot create subprocess for testcase 4");
+  } else {
+    begin_subprocess_log_inspection(EXIT_SUCCESS);
+
+    const int line_count = 6;
+    char buffer_interleaved[line_count][1024];
+
+    int line_idx;
+    for (line_idx = 0; line_idx < line_count; line_idx++) {
+      get_next_line(buffer_interleaved[line_idx], 1024);
+    }
+
+    int idx;
+    for (idx = 0; idx < 2; idx++) {
+      assert_line_interleaved(line_count, -1, "log_verbose\n");
+      assert_line_interleaved(line_count, -1, "[ERROR] log_error\n");
+      assert_line_interleaved(line_count, -1,
+			      "[ERROR] log_syserror (%s)\n",
+			      strerror(ENAMETOOLONG));
+    }
+    gracious_assert(fgets(buffer, sizeof(buffer), log_file) == NULL);
+
+    end_subprocess_log_inspection();
+  }
+
+  /* Testcase 5: asynchronous logging drops records instead of blocking */
+  child_pid = fork();
+  if (child_pid == 0) {
+    setup_subprocess_log_stream();
+
+    struct timespec flush_period = {
+      .tv_sec = 3600,
+      .tv_nsec = 0,
+    };
+    if (utility_log_async_start(2, &flush_period) != 0) {
+      fatal_error("Cannot start asynchronous logging");
+    }
+
+    int i;
+    for (i = 0; i < 4; i++) {
+      log_verbose("log_verbose %d\n", i);
+    }
+    gracious_assert(utility_log_async_dropped_count() == 2);
+
+    utility_log_async_flush();
+    log_verbose("log_verbose %d\n", i);
+
+    /* Stopping must not wait for the flush period */
+    if (utility_log_async_stop() != 0) {
+      fatal_error("Cannot stop asynchronous logging");
+    }
+
+    return EXIT_SUCCESS;
+  } else if (child_pid == -1) {
+    fatal_syserror("Cannot create subprocess for testcase 5");
+  } else {
+    begin_subprocess_log_inspection(EXIT_SUCCESS);
+
+    assert_line("log_verbose 0\n");
+    assert_line("log_verbose 1\n");
+    assert_line("log_verbose 4\n");
+
+    int rc = 0;
+    get_next_line(buffer, sizeof(buffer));
+    test_line(rc, buffer, child_pid, -1,
+	      "utility_log_async_stop", "utility_log.c", -1,
+	      "[ERROR] 2 log records were dropped due to full ring buffers\n");
+    gracious_assert(rc == 0);
+    gracious_assert(fgets(buffer, sizeof(buffer), log_file) == NULL);
+
+    end_subprocess_log_inspection();
+  }
+
+  /* Testcase 6: structured output formats */
+  child_pid = fork();
+  if (child_pid == 0) {
+    setup_subprocess_log_stream();
+
+    utility_log_set_format(UTILITY_LOG_FORMAT_JSON);
+    gracious_assert(!utility_log_is_plain_sync());
+    log_verbose("json \"quoted\"\\\ttab\n");
+    log_debug("json debug %d\n", 1);
+
+    utility_log_set_format(UTILITY_LOG_FORMAT_KEY_VALUE);
+    if (utility_log_async_start(0, NULL) != 0) {
+      fatal_error("Cannot start asynchronous logging");
+    }
+    errno = ENAMETOOLONG;
+    log_syserror("kv %s", "str");
+    if (utility_log_async_stop() != 0) {
+      fatal_error("Cannot stop asynchronous logging");
+    }
+
+    utility_log_set_format(UTILITY_LOG_FORMAT_PLAIN);
+    gracious_assert(utility_log_is_plain_sync());
+    errno = ENOEXEC;
+    fatal_syserror("fatal_syserror");
+
+    return EXIT_SUCCESS;
+  } else if (child_pid == -1) {
+    fatal_syserror("Cannot create subprocess for testcase 6");
+  } else {
+    begin_subprocess_log_inspection(EXIT_FAILURE);
+
+#define skip_number() do {					\
+      gracious_assert(*ptr >= '0' && *ptr <= '9');		\
+      while ((*ptr >= '0' && *ptr <= '9') || *ptr == '.') {	\
+	ptr++;							\
+      }								\
+    } while (0)
+#define assert_structured_line(t_key, pid_key, tid_key,		\
+			       prefix, suffix, ...)			\
+    do {								\
+      int rc = 0;							\
+      char *ptr = buffer;						\
+      get_next_line(buffer, sizeof(buffer));				\
+      cmp_token(rc, t_key);						\
+      skip_number();							\
+      cmp_token(rc, prefix pid_key "%u", (unsigned int) child_pid);	\
+      cmp_token(rc, tid_key);						\
+      skip_number();							\
+      cmp_token(rc, suffix);						\
+      skip_number();							\
+      cmp_token(rc, __VA_ARGS__);					\
+      gracious_assert(rc == 0);						\
+    } while (0)
+
+    assert_structured_line("{\"t\":", ",\"pid\":", ",\"tid\":",
+			   ",\"prog\":\"utility_log_test\"",
+			   ",\"level\":\"verbose\",\"fn\":\"main\","
+			   "\"file\":\"utility_log_test.c\",\"line\":",
+			   ",\"msg\":\"json \\\"quoted\\\"\\\\\\ttab\"}\n");
+    assert_structured_line("{\"t\":", ",\"pid\":", ",\"tid\":",
+			   ",\"prog\":\"utility_log_test\"",
+			   ",\"level\":\"debug\",\"fn\":\"main\","
+			   "\"file\":\"utility_log_test.c\",\"line\":",
+			   ",\"msg\":\"json debug 1\"}\n");
+    assert_structured_line("t=", " pid=", " tid=",
+			   " prog=\"utility_log_test\"",
+			   " level=error fn=\"main\""
+			   " file=\"utility_log_test.c\" line=",
+			   " msg=\"kv str (%s)\"\n", strerror(ENAMETOOLONG));
+    assert_line("[FATAL] fatal_syserror (%s)\n", strerror(ENOEXEC));
+    gracious_assert(fgets(buffer, sizeof(buffer), log_file) == NULL);
+
+#undef assert_structured_line
+#undef skip_number
+
+    end_subprocess_log_inspection();
+  }
+
   return EXIT_SUCCESS;
 
 } MAIN_UNIT_TEST_END
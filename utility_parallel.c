@@ -0,0 +1,252 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include "utility_parallel.h"
+
+struct run_state
+{
+  pid_t proc_id; /* -1 if the run is not running */
+  int slot; /* The index of the CPU in the CPU list */
+  struct timespec t_start;
+};
+
+/* The runs of the ongoing parallel_schedule() for parallel_terminate() */
+static struct run_state *volatile run_states = NULL;
+static volatile int run_state_count = 0;
+
+int parallel_parse_cpu_list(const char *list, int **cpus, int *cpu_count)
+{
+  int last_cpu = get_last_cpu();
+  const char *itr = list;
+  int *result, count = 0;
+
+  if (last_cpu == -1) {
+    log_error("Cannot get the number of CPUs");
+    return -1;
+  }
+  result = malloc(sizeof(*result) * (last_cpu + 1));
+  if (result == NULL) {
+    log_error("Not enough memory to allocate the CPU list");
+    return -1;
+  }
+
+  while (*itr != '\0') {
+    char *end;
+    long first = strtol(itr, &end, 10), last;
+    if (end == itr) {
+      goto invalid;
+    }
+    last = first;
+    if (*end == '-') {
+      itr = end + 1;
+      last = strtol(itr, &end, 10);
+      if (end == itr) {
+        goto invalid;
+      }
+    }
+    if (first < 0 || last > last_cpu || first > last) {
+      log_error("CPU range %ld-%ld is outside 0-%d", first, last, last_cpu);
+      goto error;
+    }
+
+    for (; first <= last; first++) {
+      int i;
+      for (i = 0; i < count; i++) {
+        if (result[i] == first) {
+          log_error("CPU %ld is listed more than once", first);
+          goto error;
+        }
+      }
+      result[count++] = first;
+    }
+
+    if (*end == ',') {
+      end++;
+    } else if (*end != '\0') {
+      goto invalid;
+    }
+    itr = end;
+  }
+
+  if (count == 0) {
+    goto invalid;
+  }
+
+  *cpus = result;
+  *cpu_count = count;
+  return 0;
+
+ invalid:
+  log_error("Invalid CPU list '%s'", list);
+ error:
+  free(result);
+  return -1;
+}
+
+static int run_cmp(const void *a, const void *b)
+{
+  const struct parallel_run *run_a = a, *run_b = b;
+
+  if (run_a->cost > run_b->cost) {
+    return -1;
+  } else if (run_a->cost < run_b->cost) {
+    return 1;
+  }
+  return 0;
+}
+
+static double elapsed_s(const struct timespec *t_start)
+{
+  struct timespec t_now;
+
+  clock_gettime(CLOCK_MONOTONIC, &t_now);
+  return ((t_now.tv_sec - t_start->tv_sec)
+          + (t_now.tv_nsec - t_start->tv_nsec) / 1e9);
+}
+
+static int run_start(const struct parallel_run *run, struct run_state *state,
+                     const int *cpus, int slot, parallel_exec exec)
+{
+  state->slot = slot;
+  if (clock_gettime(CLOCK_MONOTONIC, &state->t_start) != 0) {
+    log_syserror("Cannot get the start time of %s", run->name);
+    return -1;
+  }
+
+  state->proc_id = fork();
+  if (state->proc_id == -1) {
+    log_syserror("Cannot fork");
+    return -1;
+  } else if (state->proc_id != 0) {
+    return 0;
+  }
+
+  exec(run, cpus[slot], slot);
+  _exit(EXIT_FAILURE);
+}
+
+void parallel_terminate(void)
+{
+  struct run_state *states = run_states;
+  int count = run_state_count;
+  int i;
+
+  for (i = 0; i < count; i++) {
+    if (states[i].proc_id != -1) {
+      kill(states[i].proc_id, SIGINT);
+    }
+  }
+  for (i = 0; i < count; i++) {
+    if (states[i].proc_id != -1) {
+      waitpid(states[i].proc_id, NULL, 0);
+      states[i].proc_id = -1;
+    }
+  }
+}
+
+int parallel_schedule(struct parallel_run *runs, int run_count,
+                      const int *cpus, int cpu_count, parallel_exec exec,
+                      FILE *progress)
+{
+  int rc = 0;
+  int next_run = 0, running_count = 0;
+  struct run_state *states;
+  int *slot_busy;
+  int i;
+
+  qsort(runs, run_count, sizeof(*runs), run_cmp);
+
+  states = malloc(sizeof(*states) * run_count);
+  slot_busy = calloc(cpu_count, sizeof(*slot_busy));
+  if ((run_count != 0 && states == NULL) || slot_busy == NULL) {
+    log_error("Not enough memory to allocate the run states");
+    free(states);
+    free(slot_busy);
+    return -2;
+  }
+  for (i = 0; i < run_count; i++) {
+    states[i].proc_id = -1;
+  }
+  run_states = states;
+  run_state_count = run_count;
+
+  while (next_run < run_count || running_count > 0) {
+    int slot, status;
+    pid_t proc_id;
+
+    for (slot = 0; slot < cpu_count && next_run < run_count; slot++) {
+      if (slot_busy[slot]) {
+        continue;
+      }
+      if (run_start(&runs[next_run], &states[next_run], cpus, slot,
+                    exec) != 0) {
+        rc = -2;
+        goto out;
+      }
+      if (progress != NULL) {
+        fprintf(progress, "CPU %d: %s started\n", cpus[slot],
+                runs[next_run].name);
+        fflush(progress);
+      }
+      slot_busy[slot] = 1;
+      next_run++;
+      running_count++;
+    }
+
+    proc_id = wait(&status);
+    if (proc_id == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      log_syserror("Cannot wait for the runs");
+      rc = -2;
+      goto out;
+    }
+
+    for (i = 0; i < run_count; i++) {
+      struct run_state *state = &states[i];
+      if (state->proc_id != proc_id) {
+        continue;
+      }
+
+      int success = WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+      if (progress != NULL) {
+        fprintf(progress, "CPU %d: %s %s after %.1f s\n", cpus[state->slot],
+                runs[i].name, success ? "finished" : "FAILED",
+                elapsed_s(&state->t_start));
+        fflush(progress);
+      }
+      if (!success) {
+        rc = -1;
+      }
+      state->proc_id = -1;
+      slot_busy[state->slot] = 0;
+      running_count--;
+      break;
+    }
+  }
+
+ out:
+  if (rc == -2) {
+    parallel_terminate();
+  }
+  run_state_count = 0;
+  run_states = NULL;
+  free(states);
+  free(slot_busy);
+  return rc;
+}
@@ -0,0 +1,119 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+/**
+ * @file utility_parallel.h
+ * @brief Running independent experiments in parallel on a list of
+ * CPUs.
+ *
+ * Every run is a child process pinned by its exec function to the CPU
+ * it is given. The runs are started longest first using list
+ * scheduling so that a CPU picks the next longest run as soon as its
+ * current run finishes, which keeps the makespan close to that of the
+ * longest run when there are enough CPUs.
+ *
+ * @author Tadeus Prastowo <eus@member.fsf.org>
+ */
+
+#ifndef UTILITY_PARALLEL
+#define UTILITY_PARALLEL
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include "utility_log.h"
+#include "utility_cpu.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /** A run to be scheduled by parallel_schedule(). */
+  struct parallel_run
+  {
+    const char *name; /**< The name used to report the progress. */
+    unsigned long long cost; /**< The estimated duration in any unit
+                                that orders the runs longest first. */
+    void *args; /**< The arguments of the exec function. */
+  };
+
+  /**
+   * The function executed by the child process of a run, which must
+   * exec the run or call _exit(). The child exits with EXIT_FAILURE
+   * if the function returns.
+   *
+   * @param run a pointer to the run.
+   * @param cpu the CPU to run on.
+   * @param slot the index of the CPU in the CPU list (e.g., to give
+   * the runs disjoint port ranges).
+   */
+  typedef void (*parallel_exec)(const struct parallel_run *run, int cpu,
+                                int slot);
+
+  /**
+   * Parse a CPU list like 1-3,5 into a malloc'd array of distinct
+   * CPUs in the order of the list.
+   *
+   * @param list the CPU list.
+   * @param cpus a pointer to the object to store the array, which
+   * must be freed by the caller.
+   * @param cpu_count a pointer to the object to store the number of
+   * CPUs in the array.
+   *
+   * @return 0 if successful or -1 if the list is invalid or in case of
+   * error, which is logged.
+   */
+  int parallel_parse_cpu_list(const char *list, int **cpus, int *cpu_count);
+
+  /**
+   * Run the given runs on the given CPUs longest first, one run per
+   * CPU at a time, and report the start and the end of every run to
+   * progress, if not NULL, as "CPU N: NAME started" and "CPU N: NAME
+   * finished|FAILED after S s".
+   *
+   * @param runs the runs, which are sorted longest first in place.
+   * @param run_count the number of runs.
+   * @param cpus the CPUs.
+   * @param cpu_count the number of CPUs.
+   * @param exec the function executed by the child process of each run.
+   * @param progress the stream to report the progress or NULL.
+   *
+   * @return 0 if every run exits with EXIT_SUCCESS, -1 if some run
+   * fails, or -2 in case of hard error that requires the investigation
+   * of the output of the logging facility to fix the error, in which
+   * case the running runs are terminated.
+   */
+  int parallel_schedule(struct parallel_run *runs, int run_count,
+                        const int *cpus, int cpu_count, parallel_exec exec,
+                        FILE *progress);
+
+  /**
+   * Send SIGINT to the running runs of parallel_schedule() and wait
+   * for them to exit. Only async-signal-safe functions are used so
+   * that this can be called from a signal handler.
+   */
+  void parallel_terminate(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UTILITY_PARALLEL */
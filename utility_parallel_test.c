@@ -0,0 +1,116 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "utility_testcase.h"
+#include "utility_log.h"
+#include "utility_cpu.h"
+#include "utility_parallel.h"
+
+static int report_fd = -1;
+
+/* Report the name of the run through the pipe and exit with the exit
+   status pointed to by the arguments of the run */
+static void exec_run(const struct parallel_run *run, int cpu, int slot)
+{
+  if (write(report_fd, run->name, 1) != 1) {
+    _exit(EXIT_FAILURE);
+  }
+  _exit(*((int *) run->args));
+}
+
+static void returning_exec(const struct parallel_run *run, int cpu, int slot)
+{
+}
+
+MAIN_UNIT_TEST_BEGIN("utility_parallel_test", "stderr", NULL, NULL)
+{
+  int last_cpu = get_last_cpu();
+  char list[32];
+  int *cpus, cpu_count;
+
+  gracious_assert(last_cpu != -1);
+
+  /* Testcase 1: CPU lists */
+  gracious_assert(parallel_parse_cpu_list("0", &cpus, &cpu_count) == 0);
+  gracious_assert(cpu_count == 1 && cpus[0] == 0);
+  free(cpus);
+  snprintf(list, sizeof(list), "0-%d", last_cpu);
+  gracious_assert(parallel_parse_cpu_list(list, &cpus, &cpu_count) == 0);
+  gracious_assert(cpu_count == last_cpu + 1 && cpus[last_cpu] == last_cpu);
+  free(cpus);
+  if (last_cpu > 0) {
+    gracious_assert(parallel_parse_cpu_list("1,0", &cpus, &cpu_count) == 0);
+    gracious_assert(cpu_count == 2 && cpus[0] == 1 && cpus[1] == 0);
+    free(cpus);
+  }
+  gracious_assert(parallel_parse_cpu_list("", &cpus, &cpu_count) == -1);
+  gracious_assert(parallel_parse_cpu_list("x", &cpus, &cpu_count) == -1);
+  gracious_assert(parallel_parse_cpu_list("0-", &cpus, &cpu_count) == -1);
+  gracious_assert(parallel_parse_cpu_list("0;1", &cpus, &cpu_count) == -1);
+  gracious_assert(parallel_parse_cpu_list("0,0", &cpus, &cpu_count) == -1);
+  gracious_assert(parallel_parse_cpu_list("1-0", &cpus, &cpu_count) == -1);
+  snprintf(list, sizeof(list), "0-%d", last_cpu + 1);
+  gracious_assert(parallel_parse_cpu_list(list, &cpus, &cpu_count) == -1);
+
+  /* Testcase 2: one CPU runs the runs longest first */
+  int pipe_fds[2];
+  gracious_assert(pipe(pipe_fds) == 0);
+  report_fd = pipe_fds[1];
+
+  int success = EXIT_SUCCESS, failure = EXIT_FAILURE;
+  struct parallel_run runs[] = {
+    {"a", 1, &success},
+    {"b", 3, &success},
+    {"c", 2, &success},
+  };
+  int run_count = sizeof(runs) / sizeof(*runs);
+  int one_cpu[] = {0};
+  char order[4];
+
+  gracious_assert(parallel_schedule(runs, run_count, one_cpu, 1, exec_run,
+                                    NULL) == 0);
+  gracious_assert(read(pipe_fds[0], order, 3) == 3);
+  gracious_assert(memcmp(order, "bca", 3) == 0);
+  gracious_assert(strcmp(runs[0].name, "b") == 0);
+  gracious_assert(strcmp(runs[2].name, "a") == 0);
+
+  /* Testcase 3: a failing run does not stop the others */
+  runs[1].args = &failure;
+  int two_slots[] = {0, 0};
+  gracious_assert(parallel_schedule(runs, run_count, two_slots, 2, exec_run,
+                                    NULL) == -1);
+  gracious_assert(read(pipe_fds[0], order, 3) == 3);
+
+  /* Testcase 4: an exec function that returns fails the run */
+  gracious_assert(parallel_schedule(runs, 1, one_cpu, 1, returning_exec,
+                                    NULL) == -1);
+
+  /* Testcase 5: nothing to run */
+  gracious_assert(parallel_schedule(runs, 0, one_cpu, 1, exec_run,
+                                    NULL) == 0);
+  parallel_terminate();
+
+  close(pipe_fds[0]);
+  close(pipe_fds[1]);
+
+  return EXIT_SUCCESS;
+
+} MAIN_UNIT_TEST_END
@@ -0,0 +1,252 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include "utility_payload.h"
+
+/* The maximum number of regions mapped by a receiver thread, beyond
+   which the least recently mapped region is unmapped */
+#define MAPPED_REGION_COUNT_MAX 16
+
+struct payload_region
+{
+  char name[32];
+  pid_t owner;
+  size_t slot_size;
+  size_t map_len;
+  char *base;
+};
+
+struct mapped_region
+{
+  pid_t owner; /* 0 if the entry is free */
+  size_t map_len;
+  char *base;
+};
+
+struct payload_map
+{
+  unsigned next_victim;
+  struct mapped_region regions[MAPPED_REGION_COUNT_MAX];
+};
+
+int payload_region_create(unsigned slot_count, size_t slot_size,
+                          payload_region **res)
+{
+  payload_region *r;
+  int fd;
+
+  if (slot_count == 0 || slot_size == 0) {
+    return -1;
+  }
+
+  r = malloc(sizeof(*r));
+  if (r == NULL) {
+    log_error("Not enough memory for a payload region");
+    return -2;
+  }
+  r->owner = getpid();
+  r->slot_size = slot_size;
+  r->map_len = slot_size * slot_count;
+  snprintf(r->name, sizeof(r->name), PAYLOAD_REGION_NAME_FMT, r->owner);
+
+  /* Replace any stale region of a dead process having the same PID */
+  if (shm_unlink(r->name) != 0 && errno != ENOENT) {
+    log_syserror("Cannot remove stale payload region %s", r->name);
+    goto error;
+  }
+  fd = shm_open(r->name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+  if (fd == -1) {
+    log_syserror("Cannot create payload region %s", r->name);
+    goto error;
+  }
+  if (ftruncate(fd, r->map_len) != 0) {
+    log_syserror("Cannot size payload region %s", r->name);
+    close(fd);
+    shm_unlink(r->name);
+    goto error;
+  }
+  r->base = mmap(NULL, r->map_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (r->base == MAP_FAILED) {
+    log_syserror("Cannot map payload region %s", r->name);
+    close(fd);
+    shm_unlink(r->name);
+    goto error;
+  }
+  if (close(fd) != 0) {
+    log_syserror("Cannot close payload region %s descriptor", r->name);
+  }
+
+  /* Touch the region to avoid page faults while filling the slots */
+  memset(r->base, 0, r->map_len);
+
+  *res = r;
+  return 0;
+
+ error:
+  free(r);
+  return -2;
+}
+
+void payload_region_destroy(payload_region *r)
+{
+  if (shm_unlink(r->name) != 0) {
+    log_syserror("Cannot remove payload region %s", r->name);
+  }
+  if (munmap(r->base, r->map_len) != 0) {
+    log_syserror("Cannot unmap payload region %s", r->name);
+  }
+  free(r);
+}
+
+void *payload_region_slot(payload_region *r, unsigned nth)
+{
+  return r->base + nth * r->slot_size;
+}
+
+void payload_region_describe(const payload_region *r, unsigned nth,
+                             size_t size, payload_desc *desc)
+{
+  desc->magic = PAYLOAD_DESC_MAGIC;
+  desc->owner = r->owner;
+  desc->offset = nth * r->slot_size;
+  desc->size = size;
+}
+
+int payload_map_create(payload_map **res)
+{
+  payload_map *m = calloc(1, sizeof(*m));
+
+  if (m == NULL) {
+    log_error("Not enough memory for a payload map");
+    return -2;
+  }
+
+  *res = m;
+  return 0;
+}
+
+static void unmap_region(struct mapped_region *mr)
+{
+  if (mr->owner != 0 && munmap(mr->base, mr->map_len) != 0) {
+    log_syserror("Cannot unmap payload region of %d", mr->owner);
+  }
+  mr->owner = 0;
+}
+
+void payload_map_destroy(payload_map *m)
+{
+  int i;
+
+  for (i = 0; i < MAPPED_REGION_COUNT_MAX; i++) {
+    unmap_region(&m->regions[i]);
+  }
+  free(m);
+}
+
+static int map_region(pid_t owner, struct mapped_region *mr)
+{
+  char name[32];
+  struct stat region_stat;
+  int fd;
+
+  snprintf(name, sizeof(name), PAYLOAD_REGION_NAME_FMT, owner);
+  fd = shm_open(name, O_RDWR, 0);
+  if (fd == -1) {
+    if (errno == ENOENT) {
+      return -1;
+    }
+    log_syserror("Cannot open payload region %s", name);
+    return -2;
+  }
+  if (fstat(fd, &region_stat) != 0) {
+    log_syserror("Cannot get the size of payload region %s", name);
+    close(fd);
+    return -2;
+  }
+  if (region_stat.st_size == 0) {
+    close(fd); /* The owner is still creating the region */
+    return -1;
+  }
+
+  mr->map_len = region_stat.st_size;
+  mr->base = mmap(NULL, mr->map_len, PROT_READ | PROT_WRITE, MAP_SHARED,
+                  fd, 0);
+  close(fd);
+  if (mr->base == MAP_FAILED) {
+    log_syserror("Cannot map payload region %s", name);
+    return -2;
+  }
+  mr->owner = owner;
+
+  return 0;
+}
+
+int payload_map_resolve(payload_map *m, const payload_desc *desc, void **res)
+{
+  struct mapped_region *mr = NULL;
+  int i, rc;
+
+  for (i = 0; i < MAPPED_REGION_COUNT_MAX; i++) {
+    if (m->regions[i].owner == desc->owner) {
+      mr = &m->regions[i];
+      break;
+    }
+  }
+
+  if (mr == NULL) {
+    for (i = 0; i < MAPPED_REGION_COUNT_MAX; i++) {
+      if (m->regions[i].owner == 0) {
+        mr = &m->regions[i];
+        break;
+      }
+    }
+    if (mr == NULL) {
+      mr = &m->regions[m->next_victim];
+      m->next_victim = (m->next_victim + 1) % MAPPED_REGION_COUNT_MAX;
+      unmap_region(mr);
+    }
+    if ((rc = map_region(desc->owner, mr)) != 0) {
+      return rc;
+    }
+  }
+
+  if (desc->offset > mr->map_len || desc->size > mr->map_len - desc->offset) {
+    return -1;
+  }
+
+  *res = mr->base + desc->offset;
+  return 0;
+}
+
+uint64_t payload_checksum(const void *payload, size_t size)
+{
+  const char *p = payload;
+  uint64_t sum = 0, word;
+  size_t i;
+
+  for (i = 0; i + sizeof(word) <= size; i += sizeof(word)) {
+    memcpy(&word, p + i, sizeof(word));
+    sum += word;
+  }
+  if (i < size) {
+    word = 0;
+    memcpy(&word, p + i, size - i);
+    sum += word;
+  }
+
+  return sum;
+}
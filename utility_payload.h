@@ -0,0 +1,157 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+/**
+ * @file utility_payload.h
+ * @brief Passing large payloads between processes on the same host by
+ * reference.
+ *
+ * The owner of the payloads creates a region of fixed-size slots in
+ * a POSIX shared memory object named after its PID and sends a
+ * payload_desc in place of the payload itself. A receiver resolves
+ * the descriptor to a pointer into the region, which is mapped upon
+ * the first descriptor of the owner and kept mapped afterward, so
+ * that the payload is never copied.
+ *
+ * A descriptor whose owner is 0 tells that the payload follows the
+ * descriptor in the same message (i.e., the payload is copied).
+ *
+ * @author Tadeus Prastowo <eus@member.fsf.org>
+ */
+
+#ifndef UTILITY_PAYLOAD
+#define UTILITY_PAYLOAD
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <stdio.h>
+#include "utility_log.h"
+
+/** The value of payload_desc.magic identifying a descriptor. */
+#define PAYLOAD_DESC_MAGIC 0x42574950U
+/** The format of the name of the region of an owner PID. */
+#define PAYLOAD_REGION_NAME_FMT "/utility_payload-%u"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /** The descriptor of a payload. */
+  typedef struct
+  {
+    uint32_t magic; /* PAYLOAD_DESC_MAGIC */
+    uint32_t owner; /* The PID of the owner of the region or 0 if the
+                       payload follows this descriptor */
+    uint64_t offset; /* The offset of the payload in the region */
+    uint64_t size; /* The size of the payload in bytes */
+  } __attribute__((packed)) payload_desc;
+
+  /**
+   * A region of payload slots owned by the caller.
+   * This is an opaque type; do not manipulate any of its instances directly.
+   */
+  typedef struct payload_region payload_region;
+
+  /**
+   * The regions of other processes mapped by a receiver thread.
+   * This is an opaque type; do not manipulate any of its instances directly.
+   */
+  typedef struct payload_map payload_map;
+
+  /**
+   * Create the region of the calling process replacing any stale
+   * region having the same name. The region is touched right away so
+   * that no page fault happens while filling the slots.
+   *
+   * @param slot_count the number of slots.
+   * @param slot_size the size in bytes of a slot.
+   * @param res a pointer to the object to store the created region.
+   *
+   * @return 0 if the region is created, -1 if slot_count or slot_size
+   * is zero, or -2 in case of hard error that requires the
+   * investigation of the output of the logging facility to fix the
+   * error.
+   */
+  int payload_region_create(unsigned slot_count, size_t slot_size,
+                            payload_region **res);
+
+  /**
+   * Unmap the region and remove its name.
+   */
+  void payload_region_destroy(payload_region *r);
+
+  /**
+   * @return a pointer to the n-th slot of the region starting from 0.
+   */
+  void *payload_region_slot(payload_region *r, unsigned nth);
+
+  /**
+   * Describe a payload of the given size in the n-th slot of the
+   * region, which must not exceed the slot size.
+   */
+  void payload_region_describe(const payload_region *r, unsigned nth,
+                               size_t size, payload_desc *desc);
+
+  /**
+   * Create an empty set of mapped regions to be used by one thread.
+   *
+   * @return 0 if the set is created or -2 in case of hard error that
+   * requires the investigation of the output of the logging facility
+   * to fix the error.
+   */
+  int payload_map_create(payload_map **res);
+
+  /**
+   * Unmap all regions mapped using the given set and destroy the set.
+   */
+  void payload_map_destroy(payload_map *m);
+
+  /**
+   * Resolve the descriptor of a payload in the region of another
+   * process, mapping the region as necessary.
+   *
+   * @param m a pointer to the set of mapped regions of the caller.
+   * @param desc a pointer to the descriptor whose owner is not 0.
+   * @param res a pointer to the object to store the pointer to the
+   * payload.
+   *
+   * @return 0 if the payload is resolved, -1 if the region does not
+   * exist or the payload does not lie within the region, or -2 in
+   * case of hard error that requires the investigation of the output
+   * of the logging facility to fix the error.
+   */
+  int payload_map_resolve(payload_map *m, const payload_desc *desc,
+                          void **res);
+
+  /**
+   * @return the sum of the 64-bit words of the given payload, whose
+   * computation reads every byte of the payload.
+   */
+  uint64_t payload_checksum(const void *payload, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UTILITY_PAYLOAD */
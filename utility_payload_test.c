@@ -0,0 +1,106 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "utility_testcase.h"
+#include "utility_log.h"
+#include "utility_payload.h"
+
+#define SLOT_SIZE (64 * 1024)
+
+MAIN_UNIT_TEST_BEGIN("utility_payload_test", "stderr", NULL, NULL)
+{
+  payload_region *r;
+  payload_map *m;
+  payload_desc desc;
+  void *payload;
+  char *slot;
+  pid_t child;
+  int status;
+
+  /* Testcase 1: checksum */
+  {
+    uint64_t words[3] = {1, 2, 0x100000000ULL};
+    unsigned char tail[9] = {0, 0, 0, 0, 0, 0, 0, 0, 7};
+    gracious_assert(payload_checksum(words, sizeof(words))
+                    == 0x100000003ULL);
+    gracious_assert(payload_checksum(tail, sizeof(tail)) == 7);
+    gracious_assert(payload_checksum(tail, 0) == 0);
+  }
+
+  /* Testcase 2: invalid region */
+  gracious_assert(payload_region_create(0, SLOT_SIZE, &r) == -1);
+  gracious_assert(payload_region_create(2, 0, &r) == -1);
+
+  /* Testcase 3: another process reads and writes the payload in place */
+  gracious_assert(payload_region_create(2, SLOT_SIZE, &r) == 0);
+  slot = payload_region_slot(r, 1);
+  gracious_assert(slot == (char *) payload_region_slot(r, 0) + SLOT_SIZE);
+  memset(slot, 0x5a, SLOT_SIZE);
+  payload_region_describe(r, 1, SLOT_SIZE - 3, &desc);
+  gracious_assert(desc.magic == PAYLOAD_DESC_MAGIC);
+  gracious_assert(desc.owner == getpid());
+  gracious_assert(desc.offset == SLOT_SIZE);
+  gracious_assert(desc.size == SLOT_SIZE - 3);
+
+  child = fork();
+  gracious_assert(child != -1);
+  if (child == 0) {
+    int rc = EXIT_FAILURE;
+    if (payload_map_create(&m) == 0) {
+      if (payload_map_resolve(m, &desc, &payload) == 0
+          && (payload_checksum(payload, desc.size)
+              == payload_checksum(slot, desc.size))) {
+        memset(payload, 0xa5, desc.size);
+        rc = EXIT_SUCCESS;
+      }
+      payload_map_destroy(m);
+    }
+    _exit(rc);
+  }
+  gracious_assert(waitpid(child, &status, 0) == child);
+  gracious_assert(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS);
+  gracious_assert((unsigned char) slot[0] == 0xa5);
+  gracious_assert((unsigned char) slot[SLOT_SIZE - 4] == 0xa5);
+  gracious_assert((unsigned char) slot[SLOT_SIZE - 3] == 0x5a);
+
+  /* Testcase 4: invalid descriptors */
+  gracious_assert(payload_map_create(&m) == 0);
+  gracious_assert(payload_map_resolve(m, &desc, &payload) == 0);
+  desc.size = SLOT_SIZE + 1;
+  gracious_assert(payload_map_resolve(m, &desc, &payload) == -1);
+  desc.offset = ~0ULL;
+  desc.size = 2;
+  gracious_assert(payload_map_resolve(m, &desc, &payload) == -1);
+  desc.owner = 1 << 30;
+  desc.offset = 0;
+  gracious_assert(payload_map_resolve(m, &desc, &payload) == -1);
+  payload_map_destroy(m);
+
+  /* Testcase 5: the region is gone once destroyed */
+  payload_region_describe(r, 0, 1, &desc);
+  payload_region_destroy(r);
+  gracious_assert(payload_map_create(&m) == 0);
+  gracious_assert(payload_map_resolve(m, &desc, &payload) == -1);
+  payload_map_destroy(m);
+
+} MAIN_UNIT_TEST_END
@@ -0,0 +1,67 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+/**
+ * @file utility_program_options.h
+ * @brief The command-line options of the programs that a driver
+ * starts from a config file.
+ *
+ * Each program passes its option string to getopt() and a driver
+ * checks the arguments of the program against the same option string
+ * and the same required options before starting anything, so that an
+ * option added to a program is known to the driver at once. The
+ * option strings exclude -h and the leading ':' that the programs
+ * use to report a missing argument themselves.
+ *
+ * @author Tadeus Prastowo <eus@member.fsf.org>
+ */
+
+#ifndef UTILITY_PROGRAM_OPTIONS
+#define UTILITY_PROGRAM_OPTIONS
+
+/** The options of bwi-client_server/server. */
+#define SERVER_OPTSTRING "d:p:q:t:s:v:m:k:w:j:n:u:"
+/** The options that bwi-client_server/server requires. */
+#define SERVER_REQUIRED_OPTCHARS "dp"
+
+/** The options of bwi-client_server/client. */
+#define CLIENT_OPTSTRING "l:v:s:i:r:1:2:3:t:p:q:x:bd:m:o:k:g:a:e:j:n:u:z"
+/**
+ * The options that bwi-client_server/client requires excluding -x
+ * and -v, which a driver may give on behalf of the config file.
+ */
+#define CLIENT_REQUIRED_OPTCHARS "123tps"
+
+/** The options of cpu_hog_cbs. */
+#define CPU_HOG_CBS_OPTSTRING "ze:b:q:t:s:"
+/** The options that cpu_hog_cbs requires. */
+#define CPU_HOG_CBS_REQUIRED_OPTCHARS "ebqt"
+
+/** The options of hrt_cbs. */
+#define HRT_CBS_OPTSTRING "n:s:c:d:q:t:x:D:R"
+/**
+ * The options that hrt_cbs requires excluding -x, which a driver may
+ * give on behalf of the config file.
+ */
+#define HRT_CBS_REQUIRED_OPTCHARS "nscqt"
+
+/** The options of bwi-client_server/server_hog. */
+#define SERVER_HOG_OPTSTRING "p:"
+/** The options that bwi-client_server/server_hog requires. */
+#define SERVER_HOG_REQUIRED_OPTCHARS "p"
+
+#endif /* UTILITY_PROGRAM_OPTIONS */
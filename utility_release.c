@@ -0,0 +1,358 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include "utility_release.h"
+
+#define EVENT_COUNT_MAX 16
+#define GUARD_INDEX UINT32_MAX /* The epoll data of the guard timerfd */
+#define NS_PER_S 1000000000L
+
+struct release_source
+{
+  int fd;
+  enum release_source_kind kind;
+  unsigned long pending; /* Events received but not released yet */
+  int armed; /* The readable source is watched by the epoll instance */
+  int stopping; /* The stop source is readable */
+};
+
+struct release_sources
+{
+  int epoll_fd;
+  int guard_fd; /* Expires when the minimum inter-arrival time elapses */
+  struct release_source *sources;
+  unsigned source_count;
+
+  int sporadic;
+  struct timespec min_interarrival;
+  int released; /* Non-zero after the first release */
+  struct timespec t_release; /* Of the last release */
+
+  int last;
+  unsigned long deferred_count;
+};
+
+static void timespec_add(struct timespec *t, const struct timespec *dt)
+{
+  t->tv_sec += dt->tv_sec;
+  t->tv_nsec += dt->tv_nsec;
+  if (t->tv_nsec >= NS_PER_S) {
+    t->tv_sec++;
+    t->tv_nsec -= NS_PER_S;
+  }
+}
+
+static int timespec_lt(const struct timespec *t1, const struct timespec *t2)
+{
+  return (t1->tv_sec < t2->tv_sec
+          || (t1->tv_sec == t2->tv_sec && t1->tv_nsec < t2->tv_nsec));
+}
+
+int release_sources_create(const relative_time *min_interarrival,
+                           release_sources **res)
+{
+  release_sources *set = malloc(sizeof(*set));
+
+  if (set == NULL) {
+    log_error("No memory to create release sources");
+    if (min_interarrival != NULL) {
+      utility_time_gc_auto(min_interarrival);
+    }
+    return -2;
+  }
+  set->sources = NULL;
+  set->source_count = 0;
+  set->released = 0;
+  set->last = -1;
+  set->deferred_count = 0;
+
+  set->sporadic = 0;
+  set->min_interarrival.tv_sec = 0;
+  set->min_interarrival.tv_nsec = 0;
+  if (min_interarrival != NULL) {
+    to_timespec_gc(min_interarrival, &set->min_interarrival);
+    set->sporadic = (set->min_interarrival.tv_sec != 0
+                     || set->min_interarrival.tv_nsec != 0);
+  }
+
+  set->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (set->epoll_fd == -1) {
+    log_syserror("Cannot create epoll instance");
+    goto error_free_set;
+  }
+
+  set->guard_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+  if (set->guard_fd == -1) {
+    log_syserror("Cannot create guard timerfd");
+    goto error_close_epoll_fd;
+  }
+
+  struct epoll_event event = {
+    .events = EPOLLIN,
+    .data.u32 = GUARD_INDEX,
+  };
+  if (epoll_ctl(set->epoll_fd, EPOLL_CTL_ADD, set->guard_fd, &event) != 0) {
+    log_syserror("Cannot watch guard timerfd");
+    goto error_close_guard_fd;
+  }
+
+  *res = set;
+  return 0;
+
+ error_close_guard_fd:
+  close(set->guard_fd);
+ error_close_epoll_fd:
+  close(set->epoll_fd);
+ error_free_set:
+  free(set);
+  return -2;
+}
+
+void release_sources_destroy(release_sources *set)
+{
+  close(set->guard_fd);
+  close(set->epoll_fd);
+  free(set->sources);
+  free(set);
+}
+
+int release_sources_add(release_sources *set, int fd,
+                        enum release_source_kind kind)
+{
+  struct release_source *sources = realloc(set->sources,
+                                           ((set->source_count + 1)
+                                            * sizeof(*sources)));
+  if (sources == NULL) {
+    log_error("No memory to add release source");
+    return -2;
+  }
+  set->sources = sources;
+
+  struct epoll_event event = {
+    .events = (kind == RELEASE_SOURCE_READABLE
+               ? EPOLLIN | EPOLLONESHOT : EPOLLIN),
+    .data.u32 = set->source_count,
+  };
+  if (epoll_ctl(set->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+    if (errno == EBADF || errno == EPERM) {
+      log_syserror("Cannot watch release source %d", fd);
+      return -1;
+    }
+    log_syserror("Cannot add release source %d", fd);
+    return -2;
+  }
+
+  struct release_source *source = &set->sources[set->source_count++];
+  source->fd = fd;
+  source->kind = kind;
+  source->pending = 0;
+  source->armed = 1;
+  source->stopping = 0;
+
+  return 0;
+}
+
+/* Watch again a readable source whose released job has consumed the
+   data. Return 0 if successful or -1 otherwise. */
+static int rearm_source(release_sources *set, unsigned idx)
+{
+  struct release_source *source = &set->sources[idx];
+  struct epoll_event event = {
+    .events = EPOLLIN | EPOLLONESHOT,
+    .data.u32 = idx,
+  };
+
+  if (epoll_ctl(set->epoll_fd, EPOLL_CTL_MOD, source->fd, &event) != 0) {
+    log_syserror("Cannot watch again release source %d", source->fd);
+    return -1;
+  }
+  source->armed = 1;
+
+  return 0;
+}
+
+/* Account an event of the source. Return 0 if successful or -1
+   otherwise. */
+static int receive_event(release_sources *set, uint32_t idx,
+                         uint32_t events)
+{
+  if (idx == GUARD_INDEX) {
+    uint64_t expiration_count;
+    if (read(set->guard_fd, &expiration_count, sizeof(expiration_count)) == -1
+        && errno != EAGAIN) {
+      log_syserror("Cannot read guard timerfd");
+      return -1;
+    }
+    return 0;
+  }
+
+  struct release_source *source = &set->sources[idx];
+  if (source->kind == RELEASE_SOURCE_READABLE) {
+    source->armed = 0; /* Any event disarms the source */
+  }
+  if ((events & (EPOLLERR | EPOLLHUP)) && !(events & EPOLLIN)) {
+    log_error("Release source %d is hung up or in error", source->fd);
+    return -1;
+  }
+
+  switch (source->kind) {
+  case RELEASE_SOURCE_COUNTER: {
+    uint64_t event_count;
+    ssize_t rc = read(source->fd, &event_count, sizeof(event_count));
+    if (rc == sizeof(event_count)) {
+      source->pending += event_count;
+    } else if (rc != -1 || (errno != EAGAIN && errno != EINTR)) {
+      log_syserror("Cannot read the event count of release source %d",
+                   source->fd);
+      return -1;
+    }
+    break;
+  }
+  case RELEASE_SOURCE_READABLE:
+    source->pending++;
+    break;
+  case RELEASE_SOURCE_STOP:
+    source->stopping = 1;
+    break;
+  }
+
+  return 0;
+}
+
+/* Return the index of the stop source that is readable, or else the
+   index of the source having a pending release, or else -1. */
+static int next_source(const release_sources *set)
+{
+  int next = -1;
+  unsigned i;
+
+  for (i = 0; i < set->source_count; i++) {
+    if (set->sources[i].stopping) {
+      return i;
+    }
+    if (next == -1 && set->sources[i].pending != 0) {
+      next = i;
+    }
+  }
+
+  return next;
+}
+
+/* Return 0 if the release can happen now or 1 if the guard timerfd
+   is armed to expire when the minimum inter-arrival time elapses, or
+   -1 in case of error. */
+static int guard_release(release_sources *set, struct timespec *t_now)
+{
+  if (clock_gettime(CLOCK_MONOTONIC, t_now) != 0) {
+    log_syserror("Cannot get the release time");
+    return -1;
+  }
+
+  if (!set->sporadic || !set->released) {
+    return 0;
+  }
+
+  struct itimerspec guard = {
+    .it_value = set->t_release,
+  };
+  timespec_add(&guard.it_value, &set->min_interarrival);
+  if (!timespec_lt(t_now, &guard.it_value)) {
+    return 0;
+  }
+
+  if (timerfd_settime(set->guard_fd, TFD_TIMER_ABSTIME, &guard, NULL) != 0) {
+    log_syserror("Cannot arm guard timerfd");
+    return -1;
+  }
+
+  return 1;
+}
+
+int release_sources_wait(void *args)
+{
+  release_sources *set = args;
+  int deferred = 0;
+  unsigned i;
+
+  for (i = 0; i < set->source_count; i++) {
+    struct release_source *source = &set->sources[i];
+    if (source->kind == RELEASE_SOURCE_READABLE
+        && !source->armed && source->pending == 0
+        && rearm_source(set, i) != 0) {
+      goto error;
+    }
+  }
+
+  while (1) {
+    int next = next_source(set);
+
+    if (next != -1 && set->sources[next].stopping) {
+      set->last = next;
+      return -1;
+    }
+
+    if (next != -1) {
+      struct timespec t_now;
+      int rc = guard_release(set, &t_now);
+      if (rc == -1) {
+        goto error;
+      }
+      if (rc == 0) {
+        set->sources[next].pending--;
+        set->t_release = t_now;
+        set->released = 1;
+        set->last = next;
+        return 0;
+      }
+      if (!deferred) {
+        deferred = 1;
+        set->deferred_count++;
+      }
+    }
+
+    struct epoll_event events[EVENT_COUNT_MAX];
+    int event_count = epoll_wait(set->epoll_fd, events, EVENT_COUNT_MAX, -1);
+    if (event_count == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      log_syserror("Cannot wait for release sources");
+      goto error;
+    }
+
+    int j;
+    for (j = 0; j < event_count; j++) {
+      if (receive_event(set, events[j].data.u32, events[j].events) != 0) {
+        goto error;
+      }
+    }
+  }
+
+ error:
+  set->last = -1;
+  return -1;
+}
+
+int release_sources_last(const release_sources *set)
+{
+  return set->last;
+}
+
+unsigned long release_sources_deferred_count(const release_sources *set)
+{
+  return set->deferred_count;
+}
@@ -0,0 +1,169 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+/**
+ * @file utility_release.h
+ * @brief Event-driven releases of an aperiodic task through file
+ * descriptors.
+ *
+ * A set of release sources lets an aperiodic task release its jobs
+ * when file descriptors become ready instead of when a blocking
+ * callback returns. Every source is watched by a single epoll
+ * instance so that a task can be released by any number of sources
+ * (e.g., an eventfd written by another task, a timerfd driving a
+ * background load and a socket of a client) without a helper thread
+ * per source. Function release_sources_wait() has the signature of
+ * the aperiodic_release parameter of task_create() so that a set of
+ * release sources is plugged into a task by passing the set as the
+ * argument of the function.
+ *
+ * A set may enforce a minimum inter-arrival time between two
+ * consecutive releases to make the task sporadic. An event that
+ * arrives too early is deferred, not dropped, until the minimum
+ * inter-arrival time has elapsed and the number of deferred releases
+ * is counted so that an experiment can tell how often the arrivals
+ * violate the sporadic model.
+ *
+ * A stop source, typically the file descriptor returned by
+ * task_stop_fd() after task_set_fast_stop(), ends the releases as
+ * soon as it becomes readable so that the task thread ends by itself
+ * without being cancelled. The releases also end when a source is
+ * hung up (e.g., the writing end of a pipe is closed) or in error
+ * so that a broken source never releases a job.
+ *
+ * A set of release sources must be waited on by a single thread.
+ *
+ * @author Tadeus Prastowo <eus@member.fsf.org>
+ */
+
+#ifndef UTILITY_RELEASE
+#define UTILITY_RELEASE
+
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include "utility_log.h"
+#include "utility_time.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /**
+   * A set of release sources.
+   * This is an opaque type; do not manipulate any of its instances directly.
+   */
+  typedef struct release_sources release_sources;
+
+  /**
+   * The way a release source releases jobs.
+   */
+  enum release_source_kind {
+    RELEASE_SOURCE_COUNTER, /**< Reading the file descriptor gives a
+                               64-bit count of the events to release
+                               (e.g., an eventfd or a timerfd). The
+                               count is consumed by the set. */
+    RELEASE_SOURCE_READABLE, /**< The file descriptor releases one job
+                                whenever it becomes readable (e.g., a
+                                socket or a pipe). The data are
+                                consumed by the released job; the
+                                source is watched again only when the
+                                task waits for its next release. */
+    RELEASE_SOURCE_STOP, /**< The file descriptor releases no job;
+                            once it is readable, every wait ends the
+                            releases immediately (e.g., the file
+                            descriptor of task_stop_fd()). Nothing
+                            is consumed. */
+  };
+
+  /**
+   * Create an empty set of release sources.
+   *
+   * @param min_interarrival a pointer to the utility_time object
+   * specifying the minimum time between two consecutive releases or
+   * NULL. A NULL or zero time enforces no minimum. The utility_time
+   * object is garbage collected automatically if it is possible.
+   * @param res a pointer to the object to store the created set.
+   *
+   * @return 0 if the set is created or -2 in case of hard error that
+   * requires the investigation of the output of the logging facility
+   * to fix the error.
+   */
+  int release_sources_create(const relative_time *min_interarrival,
+                             release_sources **res);
+
+  /**
+   * Destroy a set of release sources. The file descriptors of the
+   * sources are not closed.
+   */
+  void release_sources_destroy(release_sources *set);
+
+  /**
+   * Add a release source to a set. The sources are numbered from zero
+   * in the order they are added. The file descriptor must stay open
+   * as long as the set is used.
+   *
+   * @param fd the file descriptor of the source.
+   * @param kind the way the source releases jobs.
+   *
+   * @return 0 if the source is added, -1 if the file descriptor
+   * cannot be watched (e.g., it is closed or is a regular file), or
+   * -2 in case of hard error that requires the investigation of the
+   * output of the logging facility to fix the error.
+   */
+  int release_sources_add(release_sources *set, int fd,
+                          enum release_source_kind kind);
+
+  /**
+   * Wait until a source releases a job or a stop source becomes
+   * readable. When several sources have pending releases, the source
+   * with the lowest number is released first. A stop source takes
+   * precedence over pending releases. Use
+   * release_sources_last() to know why the function returned.
+   *
+   * @param args a pointer to the ::release_sources object, which
+   * makes the function usable as the aperiodic_release parameter of
+   * task_create().
+   *
+   * @return 0 if a job is released, or -1 if a stop source is
+   * readable or a source is hung up or in error, in which case no
+   * job is released and the task should release no more job.
+   */
+  int release_sources_wait(void *args);
+
+  /**
+   * @return the number of the source that ended the last call to
+   * release_sources_wait() or -1 if no wait has ended or the last
+   * wait ended because of an error, which is logged.
+   */
+  int release_sources_last(const release_sources *set);
+
+  /**
+   * @return the number of releases that have been deferred to enforce
+   * the minimum inter-arrival time.
+   */
+  unsigned long release_sources_deferred_count(const release_sources *set);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UTILITY_RELEASE */
@@ -0,0 +1,163 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+#include "utility_testcase.h"
+#include "utility_log.h"
+#include "utility_time.h"
+#include "utility_release.h"
+
+static void write_events(int fd, uint64_t event_count)
+{
+  gracious_assert(write(fd, &event_count, sizeof(event_count))
+                  == sizeof(event_count));
+}
+
+static long elapsed_ms(const struct timespec *t_begin)
+{
+  struct timespec t_now;
+
+  gracious_assert(clock_gettime(CLOCK_MONOTONIC, &t_now) == 0);
+  return ((t_now.tv_sec - t_begin->tv_sec) * 1000
+          + (t_now.tv_nsec - t_begin->tv_nsec) / 1000000);
+}
+
+MAIN_UNIT_TEST_BEGIN("utility_release_test", "stderr", NULL, NULL)
+{
+  release_sources *set;
+  struct timespec t_begin;
+  int counter_fd, pipe_fd[2], stop_fd, timer_fd, pipe_hup_fd[2], status, i;
+  pid_t child;
+
+  counter_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  gracious_assert(counter_fd != -1);
+  gracious_assert(pipe(pipe_fd) == 0);
+  stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  gracious_assert(stop_fd != -1);
+
+  /* Testcase 1: sporadic releases of a counter source */
+  gracious_assert(release_sources_create(to_utility_time_dyn(20, ms), &set)
+                  == 0);
+  gracious_assert(release_sources_last(set) == -1);
+  gracious_assert(release_sources_add(set, counter_fd, RELEASE_SOURCE_COUNTER)
+                  == 0);
+  gracious_assert(release_sources_add(set, pipe_fd[0],
+                                      RELEASE_SOURCE_READABLE) == 0);
+  gracious_assert(release_sources_add(set, stop_fd, RELEASE_SOURCE_STOP)
+                  == 0);
+  gracious_assert(release_sources_add(set, -1, RELEASE_SOURCE_COUNTER) == -1);
+
+  write_events(counter_fd, 3);
+  gracious_assert(clock_gettime(CLOCK_MONOTONIC, &t_begin) == 0);
+  for (i = 0; i < 3; i++) {
+    gracious_assert(release_sources_wait(set) == 0);
+    gracious_assert(release_sources_last(set) == 0);
+  }
+  gracious_assert(elapsed_ms(&t_begin) >= 40);
+  gracious_assert(release_sources_deferred_count(set) == 2);
+
+  /* Testcase 2: a readable source is released once per readiness */
+  gracious_assert(write(pipe_fd[1], "a", 1) == 1);
+  gracious_assert(release_sources_wait(set) == 0);
+  gracious_assert(release_sources_last(set) == 1);
+  {
+    char c;
+    gracious_assert(read(pipe_fd[0], &c, 1) == 1 && c == 'a');
+  }
+
+  /* The lowest source is released first */
+  gracious_assert(write(pipe_fd[1], "b", 1) == 1);
+  write_events(counter_fd, 1);
+  {
+    char c;
+    gracious_assert(release_sources_wait(set) == 0);
+    gracious_assert(release_sources_last(set) == 0);
+    gracious_assert(release_sources_wait(set) == 0);
+    gracious_assert(release_sources_last(set) == 1);
+    gracious_assert(read(pipe_fd[0], &c, 1) == 1 && c == 'b');
+  }
+  gracious_assert(release_sources_deferred_count(set) == 5);
+
+  /* Testcase 3: a stop source takes precedence and is not consumed */
+  write_events(counter_fd, 1);
+  write_events(stop_fd, 1);
+  gracious_assert(clock_gettime(CLOCK_MONOTONIC, &t_begin) == 0);
+  for (i = 0; i < 3; i++) {
+    gracious_assert(release_sources_wait(set) == -1);
+    gracious_assert(release_sources_last(set) == 2);
+  }
+  gracious_assert(elapsed_ms(&t_begin) < 20);
+  release_sources_destroy(set);
+
+  /* Testcase 4: no minimum inter-arrival time with a timerfd */
+  timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+  gracious_assert(timer_fd != -1);
+  {
+    struct itimerspec timer = {
+      .it_value = {.tv_nsec = 5000000},
+      .it_interval = {.tv_nsec = 5000000},
+    };
+    gracious_assert(timerfd_settime(timer_fd, 0, &timer, NULL) == 0);
+  }
+
+  gracious_assert(release_sources_create(NULL, &set) == 0);
+  gracious_assert(release_sources_add(set, timer_fd, RELEASE_SOURCE_COUNTER)
+                  == 0);
+  gracious_assert(clock_gettime(CLOCK_MONOTONIC, &t_begin) == 0);
+  for (i = 0; i < 4; i++) {
+    gracious_assert(release_sources_wait(set) == 0);
+    gracious_assert(release_sources_last(set) == 0);
+  }
+  gracious_assert(elapsed_ms(&t_begin) >= 15);
+  gracious_assert(release_sources_deferred_count(set) == 0);
+  release_sources_destroy(set);
+
+  /* Testcase 5: a source hung up during the wait releases no job */
+  gracious_assert(release_sources_create(NULL, &set) == 0);
+  gracious_assert(pipe(pipe_hup_fd) == 0);
+  gracious_assert(release_sources_add(set, pipe_hup_fd[0],
+                                      RELEASE_SOURCE_READABLE) == 0);
+  child = fork();
+  gracious_assert(child != -1);
+  if (child == 0) {
+    /* Exiting closes the only writing end during the wait */
+    usleep(20000);
+    _exit(EXIT_SUCCESS);
+  }
+  close(pipe_hup_fd[1]);
+  gracious_assert(release_sources_wait(set) == -1);
+  gracious_assert(release_sources_last(set) == -1);
+  gracious_assert(release_sources_wait(set) == -1);
+  gracious_assert(waitpid(child, &status, 0) == child);
+  release_sources_destroy(set);
+  close(pipe_hup_fd[0]);
+
+  /* Clean-up */
+  close(timer_fd);
+  close(stop_fd);
+  close(pipe_fd[0]);
+  close(pipe_fd[1]);
+  close(counter_fd);
+
+} MAIN_UNIT_TEST_END
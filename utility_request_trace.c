@@ -0,0 +1,206 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include "utility_request_trace.h"
+
+struct request_trace
+{
+  FILE *file;
+  char *path;
+  unsigned port;
+  unsigned long capacity;
+  uint64_t next; /* The slot to be claimed by the next event */
+  request_trace_record *records;
+};
+
+static const char *const event_names[] = {
+  "send", "receive", "dequeue", "start", "forward", "forwarded", "reply",
+  "response",
+};
+
+int request_trace_create(const char *path, unsigned port,
+                         unsigned long capacity, request_trace **res)
+{
+  request_trace *rt = malloc(sizeof(*rt));
+
+  if (rt == NULL) {
+    log_error("Not enough memory for a request trace");
+    return -2;
+  }
+  rt->port = port;
+  rt->capacity = capacity;
+  rt->next = 0;
+
+  rt->records = malloc(sizeof(*rt->records) * (capacity == 0 ? 1 : capacity));
+  rt->path = strdup(path);
+  if (rt->records == NULL || rt->path == NULL) {
+    log_error("Not enough memory for %lu trace records", capacity);
+    goto error;
+  }
+  /* Touch the ring to avoid page faults while recording */
+  memset(rt->records, 0, sizeof(*rt->records) * capacity);
+
+  rt->file = utility_file_open_for_writing_bin(path);
+  if (rt->file == NULL) {
+    goto error;
+  }
+
+  *res = rt;
+  return 0;
+
+ error:
+  free(rt->path);
+  free(rt->records);
+  free(rt);
+  return -2;
+}
+
+int request_trace_destroy(request_trace *rt)
+{
+  request_trace_header header = {
+    .magic = REQUEST_TRACE_FILE_MAGIC,
+    .version = REQUEST_TRACE_FILE_VERSION,
+    .pid = getpid(),
+    .port = rt->port,
+    .record_count = rt->next < rt->capacity ? rt->next : rt->capacity,
+    .dropped_count = rt->next < rt->capacity ? 0 : rt->next - rt->capacity,
+  };
+  int rc = 0;
+
+  if (fwrite(&header, sizeof(header), 1, rt->file) != 1
+      || (fwrite(rt->records, sizeof(*rt->records), header.record_count,
+                 rt->file) != header.record_count)) {
+    log_syserror("Cannot write request trace %s", rt->path);
+    rc = -2;
+  }
+  if (utility_file_close(rt->file, rt->path) != 0) {
+    rc = -2;
+  }
+
+  free(rt->path);
+  free(rt->records);
+  free(rt);
+  return rc;
+}
+
+void request_trace_add(request_trace *rt, unsigned thread,
+                       enum request_trace_event event,
+                       const struct timespec *t,
+                       const void *payload, size_t len)
+{
+  request_trace_record *record;
+  request_trace_id id;
+  struct timespec t_now;
+  uint64_t pos;
+
+  if (rt == NULL || len < sizeof(id)) {
+    return;
+  }
+  memcpy(&id, payload, sizeof(id));
+  if (id.magic != REQUEST_TRACE_ID_MAGIC) {
+    return;
+  }
+
+  if (t == NULL) {
+    clock_gettime(CLOCK_MONOTONIC, &t_now);
+    t = &t_now;
+  }
+
+  /* A claimed slot beyond the capacity counts a dropped event */
+  pos = __atomic_fetch_add(&rt->next, 1, __ATOMIC_RELAXED);
+  if (pos >= rt->capacity) {
+    return;
+  }
+
+  record = &rt->records[pos];
+  record->t_ns = t->tv_sec * 1000000000ULL + t->tv_nsec;
+  record->id = id;
+  record->event = event;
+  record->thread = thread;
+}
+
+int request_trace_read(const char *path, request_trace_header *header,
+                       request_trace_record **records)
+{
+  FILE *file = utility_file_open_for_reading_bin(path);
+  request_trace_record *result = NULL;
+  size_t len;
+  int rc = -1;
+
+  if (file == NULL) {
+    return -2;
+  }
+
+  len = sizeof(*header);
+  switch (utility_file_read_bin(file, header, &len)) {
+  case 0:
+    break;
+  case -3:
+    rc = -2;
+    goto out;
+  default:
+    log_error("%s is too short to be a request trace", path);
+    goto out;
+  }
+  if (memcmp(header->magic, REQUEST_TRACE_FILE_MAGIC,
+             sizeof(header->magic)) != 0) {
+    log_error("%s is not a request trace", path);
+    goto out;
+  }
+  if (header->version != REQUEST_TRACE_FILE_VERSION) {
+    log_error("%s has unsupported version %u", path, header->version);
+    goto out;
+  }
+
+  result = malloc(sizeof(*result) * (header->record_count + 1));
+  if (result == NULL) {
+    log_error("Not enough memory to read %llu records of %s",
+              (unsigned long long) header->record_count, path);
+    rc = -2;
+    goto out;
+  }
+  len = sizeof(*result) * header->record_count;
+  if (len != 0) {
+    switch (utility_file_read_bin(file, result, &len)) {
+    case 0:
+      break;
+    case -3:
+      rc = -2;
+      goto out;
+    default:
+      log_error("%s is truncated", path);
+      goto out;
+    }
+  }
+
+  *records = result;
+  result = NULL;
+  rc = 0;
+
+ out:
+  free(result);
+  utility_file_close(file, path);
+  return rc;
+}
+
+const char *request_trace_event_name(enum request_trace_event event)
+{
+  if (event >= REQUEST_TRACE_EVENT_COUNT) {
+    return "unknown";
+  }
+  return event_names[event];
+}
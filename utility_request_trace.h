@@ -0,0 +1,186 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+/**
+ * @file utility_request_trace.h
+ * @brief Per-request event tracing across a chain of client and servers.
+ *
+ * A client tags each request with a request_trace_id at the start of
+ * the payload. Since a server forwards and echoes the payload as is,
+ * every process along the chain can record the events of the request
+ * (e.g., its reception, the start of its processing and its
+ * forwarding to a subserver) under the same ID. Merging the trace
+ * files of all processes then gives the time spent by each request in
+ * every hop.
+ *
+ * The records are appended to a bounded ring in memory that any
+ * number of threads of the process can write to concurrently: a
+ * thread claims a slot with a single atomic increment so that
+ * recording an event never blocks. Once the ring is full, the
+ * subsequent events are dropped and counted instead. The ring is
+ * written to the trace file when the trace is destroyed.
+ *
+ * @author Tadeus Prastowo <eus@member.fsf.org>
+ */
+
+#ifndef UTILITY_REQUEST_TRACE
+#define UTILITY_REQUEST_TRACE
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "utility_log.h"
+#include "utility_file.h"
+
+/** The value of request_trace_id.magic identifying a tagged payload. */
+#define REQUEST_TRACE_ID_MAGIC 0x42574952U
+/** The magic string at the start of a trace file. */
+#define REQUEST_TRACE_FILE_MAGIC "BWITRACE"
+/** The version of the trace file format. */
+#define REQUEST_TRACE_FILE_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /** The ID of a request at the start of its payload. */
+  typedef struct
+  {
+    uint32_t magic; /* REQUEST_TRACE_ID_MAGIC */
+    uint32_t client; /* The PID of the client */
+    uint32_t job; /* The n-th job of the client starting from 1 */
+    uint32_t request; /* The index of the request in the job's batch */
+  } __attribute__((packed)) request_trace_id;
+
+  /** The events of a request in the order of their occurrence. */
+  enum request_trace_event {
+    REQUEST_TRACE_SEND, /**< A client sends the request. */
+    REQUEST_TRACE_RECEIVE, /**< A server retrieves the request. */
+    REQUEST_TRACE_DEQUEUE, /**< A server thread takes the request to
+                              serve it. */
+    REQUEST_TRACE_START, /**< A server starts processing the request. */
+    REQUEST_TRACE_FORWARD, /**< A server forwards the request to its
+                              subserver. */
+    REQUEST_TRACE_FORWARDED, /**< A server gets the response of its
+                                subserver. */
+    REQUEST_TRACE_REPLY, /**< A server sends the response back. */
+    REQUEST_TRACE_RESPONSE, /**< A client receives the response. */
+    REQUEST_TRACE_EVENT_COUNT,
+  };
+
+  /** A trace record. */
+  typedef struct
+  {
+    uint64_t t_ns; /* CLOCK_MONOTONIC */
+    request_trace_id id;
+    uint8_t event; /* enum request_trace_event */
+    uint8_t thread; /* The n-th thread of the process starting from 0 */
+    uint16_t reserved;
+  } __attribute__((packed)) request_trace_record;
+
+  /** The header of a trace file, which is followed by the records. */
+  typedef struct
+  {
+    char magic[8]; /* REQUEST_TRACE_FILE_MAGIC without '\0' */
+    uint32_t version; /* REQUEST_TRACE_FILE_VERSION */
+    uint32_t pid; /* The PID of the traced process */
+    uint32_t port; /* The port of a server or 0 for a client */
+    uint32_t reserved;
+    uint64_t record_count;
+    uint64_t dropped_count; /* Events not recorded due to a full ring */
+  } __attribute__((packed)) request_trace_header;
+
+  /**
+   * A request trace.
+   * This is an opaque type; do not manipulate any of its instances directly.
+   */
+  typedef struct request_trace request_trace;
+
+  /**
+   * Create a trace whose ring is allocated and touched right away so
+   * that no page fault happens while recording.
+   *
+   * @param path a pointer to the path of the trace file, which is
+   * opened right away so that a wrong path is detected early.
+   * @param port the port of the traced server or 0 if the traced
+   * process is a client.
+   * @param capacity the maximum number of records in the ring.
+   * @param res a pointer to the object to store the created trace.
+   *
+   * @return 0 if the trace is created or -2 in case of hard error that
+   * requires the investigation of the output of the logging facility
+   * to fix the error.
+   */
+  int request_trace_create(const char *path, unsigned port,
+                           unsigned long capacity, request_trace **res);
+
+  /**
+   * Write the records to the trace file and destroy the trace. No
+   * thread must be recording any event anymore.
+   *
+   * @return 0 if the trace file is written successfully or -2 in case
+   * of hard error that requires the investigation of the output of
+   * the logging facility to fix the error.
+   */
+  int request_trace_destroy(request_trace *rt);
+
+  /**
+   * Record an event of the request whose payload is given. Nothing is
+   * recorded if the payload is not tagged with a request_trace_id.
+   *
+   * @param rt a pointer to the trace or NULL, in which case nothing is
+   * done so that the caller needs not check whether tracing is enabled.
+   * @param thread the n-th thread of the caller starting from 0.
+   * @param event the event.
+   * @param t a pointer to the time of the event obtained from
+   * CLOCK_MONOTONIC or NULL to use the current time.
+   * @param payload a pointer to the payload of the request.
+   * @param len the length of the payload.
+   */
+  void request_trace_add(request_trace *rt, unsigned thread,
+                         enum request_trace_event event,
+                         const struct timespec *t,
+                         const void *payload, size_t len);
+
+  /**
+   * Read a trace file.
+   *
+   * @param path a pointer to the path of the trace file.
+   * @param header a pointer to the object to store the header.
+   * @param records a pointer to the object to store the records,
+   * which must be freed using free() when they are no longer needed.
+   *
+   * @return 0 if the file is read successfully, -1 if the file is not
+   * a valid trace file (the reason is @ref utility_log.h "logged"), or
+   * -2 in case of hard error that requires the investigation of the
+   * output of the logging facility to fix the error.
+   */
+  int request_trace_read(const char *path, request_trace_header *header,
+                         request_trace_record **records);
+
+  /**
+   * @return a pointer to the name of the given event.
+   */
+  const char *request_trace_event_name(enum request_trace_event event);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UTILITY_REQUEST_TRACE */
@@ -0,0 +1,191 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "utility_testcase.h"
+#include "utility_log.h"
+#include "utility_request_trace.h"
+
+#define THREAD_COUNT 4
+#define EVENT_COUNT_PER_THREAD 20000
+
+static char trace_path[] = "/tmp/utility_request_trace_test.XXXXXX";
+static void cleanup(void)
+{
+  unlink(trace_path);
+}
+
+static request_trace *shared_trace;
+
+static void *recording_thread(void *args)
+{
+  unsigned nth = (unsigned long) args;
+  request_trace_id id = {
+    .magic = REQUEST_TRACE_ID_MAGIC,
+    .client = nth,
+  };
+  int i;
+
+  for (i = 0; i < EVENT_COUNT_PER_THREAD; i++) {
+    id.job = i;
+    request_trace_add(shared_trace, nth, REQUEST_TRACE_START, NULL,
+                      &id, sizeof(id));
+  }
+
+  return NULL;
+}
+
+MAIN_UNIT_TEST_BEGIN("utility_request_trace_test", "stderr", NULL, cleanup)
+{
+  request_trace *rt;
+  request_trace_header header;
+  request_trace_record *records;
+  int fd, i;
+
+  fd = mkstemp(trace_path);
+  gracious_assert(fd != -1);
+  close(fd);
+
+  /* Testcase 1: record the events of tagged payloads only */
+  {
+    struct {
+      request_trace_id id;
+      char data[8];
+    } payload = {
+      .id = {
+        .magic = REQUEST_TRACE_ID_MAGIC,
+        .client = 1234,
+        .job = 5,
+        .request = 2,
+      },
+      .data = "Hello",
+    };
+    struct timespec t = {.tv_sec = 3, .tv_nsec = 7};
+    char untagged[] = "Hello! I am server hogger!";
+
+    gracious_assert(request_trace_create(trace_path, 7777, 3, &rt) == 0);
+    request_trace_add(NULL, 0, REQUEST_TRACE_SEND, NULL,
+                      &payload, sizeof(payload));
+    request_trace_add(rt, 0, REQUEST_TRACE_RECEIVE, &t,
+                      &payload, sizeof(payload));
+    request_trace_add(rt, 0, REQUEST_TRACE_RECEIVE, NULL,
+                      untagged, sizeof(untagged));
+    request_trace_add(rt, 0, REQUEST_TRACE_RECEIVE, NULL,
+                      &payload, sizeof(payload.id) - 1);
+    request_trace_add(rt, 2, REQUEST_TRACE_REPLY, NULL,
+                      &payload, sizeof(payload));
+    /* The ring is full after the next one */
+    request_trace_add(rt, 1, REQUEST_TRACE_FORWARD, NULL,
+                      &payload, sizeof(payload));
+    request_trace_add(rt, 1, REQUEST_TRACE_FORWARDED, NULL,
+                      &payload, sizeof(payload));
+    request_trace_add(rt, 1, REQUEST_TRACE_FORWARDED, NULL,
+                      &payload, sizeof(payload));
+    gracious_assert(request_trace_destroy(rt) == 0);
+
+    gracious_assert(request_trace_read(trace_path, &header, &records) == 0);
+    gracious_assert(header.version == REQUEST_TRACE_FILE_VERSION);
+    gracious_assert(header.pid == getpid());
+    gracious_assert(header.port == 7777);
+    gracious_assert(header.record_count == 3);
+    gracious_assert(header.dropped_count == 2);
+    gracious_assert(records[0].t_ns == 3000000007ULL);
+    gracious_assert(records[0].event == REQUEST_TRACE_RECEIVE);
+    gracious_assert(records[0].thread == 0);
+    gracious_assert(records[0].id.client == 1234);
+    gracious_assert(records[0].id.job == 5);
+    gracious_assert(records[0].id.request == 2);
+    gracious_assert(records[1].event == REQUEST_TRACE_REPLY);
+    gracious_assert(records[1].thread == 2);
+    gracious_assert(records[1].t_ns > records[0].t_ns);
+    gracious_assert(records[2].event == REQUEST_TRACE_FORWARD);
+    gracious_assert(records[2].t_ns >= records[1].t_ns);
+    free(records);
+  }
+
+  /* Testcase 2: concurrent recording loses no event */
+  {
+    pthread_t tids[THREAD_COUNT];
+    unsigned seen[THREAD_COUNT] = {0};
+    unsigned long total = THREAD_COUNT * EVENT_COUNT_PER_THREAD;
+
+    gracious_assert(request_trace_create(trace_path, 0, total,
+                                         &shared_trace) == 0);
+    for (i = 0; i < THREAD_COUNT; i++) {
+      gracious_assert(pthread_create(&tids[i], NULL, recording_thread,
+                                     (void *) (unsigned long) i) == 0);
+    }
+    for (i = 0; i < THREAD_COUNT; i++) {
+      gracious_assert(pthread_join(tids[i], NULL) == 0);
+    }
+    gracious_assert(request_trace_destroy(shared_trace) == 0);
+
+    gracious_assert(request_trace_read(trace_path, &header, &records) == 0);
+    gracious_assert(header.port == 0);
+    gracious_assert(header.record_count == total);
+    gracious_assert(header.dropped_count == 0);
+    for (i = 0; i < total; i++) {
+      unsigned nth = records[i].id.client;
+      gracious_assert(nth < THREAD_COUNT && records[i].thread == nth);
+      /* Each thread records its events in order */
+      gracious_assert(records[i].id.job == seen[nth]);
+      seen[nth]++;
+    }
+    for (i = 0; i < THREAD_COUNT; i++) {
+      gracious_assert(seen[i] == EVENT_COUNT_PER_THREAD);
+    }
+    free(records);
+  }
+
+  /* Testcase 3: invalid trace files */
+  {
+    FILE *f = fopen(trace_path, "w");
+    gracious_assert(f != NULL);
+    fputs("BWITRACX and some more bytes to fill the header", f);
+    fclose(f);
+    gracious_assert(request_trace_read(trace_path, &header, &records) == -1);
+
+    f = fopen(trace_path, "w");
+    gracious_assert(f != NULL);
+    fputs("BWITRACE", f);
+    fclose(f);
+    gracious_assert(request_trace_read(trace_path, &header, &records) == -1);
+
+    gracious_assert(request_trace_create(trace_path, 1, 4, &rt) == 0);
+    gracious_assert(request_trace_destroy(rt) == 0);
+    gracious_assert(truncate(trace_path, sizeof(header) - 1) == 0);
+    gracious_assert(request_trace_read(trace_path, &header, &records) == -1);
+
+    gracious_assert(request_trace_read("/nonexistent/trace", &header,
+                                       &records) == -2);
+    gracious_assert(request_trace_create("/nonexistent/trace", 1, 4,
+                                         &rt) == -2);
+  }
+
+  /* Testcase 4: event names */
+  gracious_assert(strcmp(request_trace_event_name(REQUEST_TRACE_SEND),
+                         "send") == 0);
+  gracious_assert(strcmp(request_trace_event_name(REQUEST_TRACE_RESPONSE),
+                         "response") == 0);
+  gracious_assert(strcmp(request_trace_event_name(REQUEST_TRACE_EVENT_COUNT),
+                         "unknown") == 0);
+
+} MAIN_UNIT_TEST_END
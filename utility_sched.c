@@ -46,10 +46,7 @@ int sched_restore(struct scheduler *sched)
 {
   if (sched->policy == SCHED_DEADLINE) {
     /* This code block pretty much requires Linux */
-    pid_t thread_id = syscall(SYS_gettid);
-
-    if (syscall(SYS_sched_setscheduler_ex, thread_id, SCHED_DEADLINE,
-                sizeof(sched->param_ex), &sched->param_ex) != 0) {
+    if (sched_setscheduler_ex(0, &sched->param_ex) != 0) {
       log_syserror("Cannot restore SCHED_DEADLINE scheduler");
       return -1;
     }
@@ -64,14 +61,104 @@ int sched_restore(struct scheduler *sched)
   return 0;
 }
 
+static enum sched_deadline_abi_type detected_abi;
+static pthread_once_t detected_abi_once = PTHREAD_ONCE_INIT;
+
+static void detect_abi(void)
+{
+  int saved_errno = errno;
+
+  struct utility_sched_attr attr;
+  if (syscall(SYS_sched_getattr, 0, &attr, sizeof(attr), 0) != 0
+      && errno == ENOSYS) {
+    detected_abi = SCHED_DEADLINE_ABI_LEGACY;
+  } else {
+    detected_abi = SCHED_DEADLINE_ABI_MAINLINE;
+  }
+
+  errno = saved_errno;
+}
+
+enum sched_deadline_abi_type sched_deadline_abi(void)
+{
+  pthread_once(&detected_abi_once, detect_abi);
+
+  return detected_abi;
+}
+
+static void ns_to_timespec(uint64_t ns, struct timespec *t)
+{
+  t->tv_sec = ns / 1000000000ULL;
+  t->tv_nsec = ns % 1000000000ULL;
+}
+
+static uint64_t timespec_to_ns(const struct timespec *t)
+{
+  return t->tv_sec * 1000000000ULL + t->tv_nsec;
+}
+
 int sched_getparam_ex(pid_t thread_id, struct sched_param_ex *param_ex)
 {
   if (thread_id == 0) {
     thread_id = syscall(SYS_gettid);
   }
 
-  if (syscall(SYS_sched_getparam_ex, thread_id, sizeof(*param_ex), param_ex)
-      != 0) {
+  if (sched_deadline_abi() == SCHED_DEADLINE_ABI_LEGACY) {
+    if (syscall(SYS_sched_getparam_ex, thread_id, sizeof(*param_ex),
+                param_ex) != 0) {
+      return -1;
+    }
+
+    return 0;
+  }
+
+  struct utility_sched_attr attr;
+  if (syscall(SYS_sched_getattr, thread_id, &attr, sizeof(attr), 0) != 0) {
+    return -1;
+  }
+
+  memset(param_ex, 0, sizeof(*param_ex));
+  param_ex->sched_priority = attr.sched_priority;
+  ns_to_timespec(attr.sched_runtime, &param_ex->sched_runtime);
+  ns_to_timespec(attr.sched_deadline, &param_ex->sched_deadline);
+  ns_to_timespec(attr.sched_period, &param_ex->sched_period);
+  param_ex->sched_flags = attr.sched_flags;
+
+  return 0;
+}
+
+int sched_setscheduler_ex(pid_t thread_id,
+                          const struct sched_param_ex *param_ex)
+{
+  if (thread_id == 0) {
+    thread_id = syscall(SYS_gettid);
+  }
+
+  if (sched_deadline_abi() == SCHED_DEADLINE_ABI_LEGACY) {
+    if (param_ex->sched_flags != 0) {
+      errno = EINVAL;
+      return -1;
+    }
+
+    struct sched_param_ex legacy_param_ex = *param_ex;
+    if (syscall(SYS_sched_setscheduler_ex, thread_id, SCHED_DEADLINE,
+                sizeof(legacy_param_ex), &legacy_param_ex) != 0) {
+      return -1;
+    }
+
+    return 0;
+  }
+
+  struct utility_sched_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.sched_policy = SCHED_DEADLINE;
+  attr.sched_flags = param_ex->sched_flags;
+  attr.sched_runtime = timespec_to_ns(&param_ex->sched_runtime);
+  attr.sched_deadline = timespec_to_ns(&param_ex->sched_deadline);
+  attr.sched_period = timespec_to_ns(&param_ex->sched_period);
+
+  if (syscall(SYS_sched_setattr, thread_id, &attr, 0) != 0) {
     return -1;
   }
 
@@ -26,7 +26,9 @@
 
 #include <sys/types.h>
 #include <sys/syscall.h>
+#include <stdint.h>
 #include <errno.h>
+#include <string.h>
 #include <sched.h>
 #include <pthread.h>
 #include <unistd.h>
@@ -40,8 +42,32 @@ extern "C" {
 #ifndef SCHED_DEADLINE
   /** SCHED_DEADLINE scheduling policy in the Linux kernel. */
   #define SCHED_DEADLINE 6
+#endif
+
+  /**
+   * @name SCHED_DEADLINE scheduling flags of the mainline ABI.
+   * @{
+   */
+#ifndef SCHED_FLAG_RESET_ON_FORK
+  /** Children do not inherit the privileged scheduling policy. */
+  #define SCHED_FLAG_RESET_ON_FORK 0x01
+#endif
+#ifndef SCHED_FLAG_RECLAIM
+  /** Reclaim the bandwidth left unused by the other threads (GRUB). */
+  #define SCHED_FLAG_RECLAIM 0x02
+#endif
+#ifndef SCHED_FLAG_DL_OVERRUN
+  /** Send SIGXCPU to the thread when it overruns its runtime. */
+  #define SCHED_FLAG_DL_OVERRUN 0x04
+#endif
+  /** @} End of SCHED_DEADLINE scheduling flags of the mainline ABI */
 
-  /** Extended scheduling parameter provided by SCHED_DEADLINE. */
+  /**
+   * Extended scheduling parameter provided by SCHED_DEADLINE. This is
+   * the structure of the out-of-tree SCHED_DEADLINE patch for Linux
+   * 2.6.36, which is also used to carry the parameters of the mainline
+   * ABI (c.f., sched_deadline_abi()).
+   */
   struct sched_param_ex {
     int sched_priority; /**< Static scheduling priority for SCHED_FIFO
                            and SCHED_RR (ignored by
@@ -51,13 +77,53 @@ extern "C" {
     struct timespec sched_period; /**< The task's period. */
     unsigned int sched_flags; /**< SCHED_DEADLINE scheduling flags. */
 
-    struct timespec curr_runtime; /**< The CBS's c_s. */
+    struct timespec curr_runtime; /**< The CBS's c_s (zero in the
+                                     mainline ABI). */
     struct timespec used_runtime; /**< Unused. */
-    struct timespec curr_deadline; /**< The CBS's d_{s,k}. */
+    struct timespec curr_deadline; /**< The CBS's d_{s,k} (zero in
+                                      the mainline ABI). */
+  };
+
+  /**
+   * The argument of the sched_setattr and sched_getattr system calls
+   * of the mainline SCHED_DEADLINE ABI (Linux 3.14 onwards).
+   */
+  struct utility_sched_attr {
+    uint32_t size; /**< The size of this structure. */
+    uint32_t sched_policy; /**< The scheduling policy. */
+    uint64_t sched_flags; /**< The SCHED_FLAG_* flags. */
+    int32_t sched_nice; /**< The nice value of SCHED_OTHER/SCHED_BATCH. */
+    uint32_t sched_priority; /**< The priority of SCHED_FIFO/SCHED_RR. */
+    uint64_t sched_runtime; /**< The runtime in nanoseconds. */
+    uint64_t sched_deadline; /**< The relative deadline in nanoseconds. */
+    uint64_t sched_period; /**< The period in nanoseconds. */
   };
-#endif
 
-  /* Linux system call numbers to communicate with SCHED_DEADLINE. */
+  /** The SCHED_DEADLINE ABIs that can be detected at runtime. */
+  enum sched_deadline_abi_type {
+    SCHED_DEADLINE_ABI_MAINLINE, /**< sched_setattr/sched_getattr. */
+    SCHED_DEADLINE_ABI_LEGACY, /**< The out-of-tree 2.6.36 patch. */
+  };
+
+  /* Linux system call numbers of the mainline SCHED_DEADLINE ABI. */
+  #ifndef SYS_sched_setattr
+  #if defined(__x86_64__)
+  #define SYS_sched_setattr 314
+  #define SYS_sched_getattr 315
+  #elif defined(__i386__)
+  #define SYS_sched_setattr 351
+  #define SYS_sched_getattr 352
+  #elif defined(__arm__)
+  #define SYS_sched_setattr 380
+  #define SYS_sched_getattr 381
+  #elif defined(__aarch64__)
+  #define SYS_sched_setattr 274
+  #define SYS_sched_getattr 275
+  #endif
+  #endif
+  /* End of Linux system call numbers of the mainline SCHED_DEADLINE ABI. */
+
+  /* Linux system call numbers of the legacy SCHED_DEADLINE patch. */
   #ifndef __NR_sched_setscheduler_ex
   #define __NR_sched_setscheduler_ex 341
   #endif
@@ -67,18 +133,6 @@ extern "C" {
 
   #ifndef __NR_sched_setparam_ex
   #define __NR_sched_setparam_ex 342
-  /**
-   * Retrieve the extended scheduling parameters of the given thread ID.
-   *
-   * @param thread_id the thread ID. Set this to zero to retrieve the
-   * extended scheduling parameters of the calling thread.
-   * @param param_ex a pointer to an extended scheduling parameters to
-   * store the result.
-   *
-   * @return zero if the operation is successful or -1 in case of
-   * error, and errno is set accordingly.
-   */
-  int sched_getparam_ex(pid_t thread_id, struct sched_param_ex *param_ex);
   #endif
   #ifndef SYS_sched_setparam_ex
   #define SYS_sched_setparam_ex __NR_sched_setparam_ex
@@ -90,7 +144,7 @@ extern "C" {
   #ifndef SYS_sched_getparam_ex
   #define SYS_sched_getparam_ex __NR_sched_getparam_ex
   #endif
-  /* End of Linux system call numbers to communicate with SCHED_DEADLINE. */
+  /* End of Linux system call numbers of the legacy SCHED_DEADLINE patch. */
 
   /** Wrapper over arguments to sched_setscheduler. */
   struct scheduler
@@ -132,6 +186,52 @@ extern "C" {
   int sched_restore(struct scheduler *sched_to_be_restored);
   /** @} End of collection of common functions */
 
+  /* III */
+  /**
+   * @name Collection of SCHED_DEADLINE ABI functions.
+   * @{
+   */
+
+  /**
+   * Detect the SCHED_DEADLINE ABI of the running kernel. The mainline
+   * ABI is detected by probing sched_getattr. The legacy ABI is
+   * assumed if sched_getattr does not exist. The detection is done
+   * only once.
+   *
+   * @return the detected ABI.
+   */
+  enum sched_deadline_abi_type sched_deadline_abi(void);
+
+  /**
+   * Retrieve the extended scheduling parameters of the given thread ID.
+   *
+   * @param thread_id the thread ID. Set this to zero to retrieve the
+   * extended scheduling parameters of the calling thread.
+   * @param param_ex a pointer to an extended scheduling parameters to
+   * store the result.
+   *
+   * @return zero if the operation is successful or -1 in case of
+   * error, and errno is set accordingly.
+   */
+  int sched_getparam_ex(pid_t thread_id, struct sched_param_ex *param_ex);
+
+  /**
+   * Schedule the given thread ID as a SCHED_DEADLINE thread with the
+   * given extended scheduling parameters using the detected ABI. The
+   * legacy ABI supports no flag.
+   *
+   * @param thread_id the thread ID. Set this to zero to schedule the
+   * calling thread.
+   * @param param_ex a pointer to the extended scheduling parameters.
+   *
+   * @return zero if the operation is successful or -1 in case of
+   * error, and errno is set accordingly (EINVAL if a flag is given to
+   * the legacy ABI).
+   */
+  int sched_setscheduler_ex(pid_t thread_id,
+                            const struct sched_param_ex *param_ex);
+  /** @} End of collection of SCHED_DEADLINE ABI functions */
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,766 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include "utility_sched_analysis.h"
+
+/* The tolerance of floating-point comparisons of the utilization */
+#define UTILIZATION_EPSILON 1e-9
+
+/* The fixed-point shift used by the kernel to represent bandwidth */
+#define KERNEL_BW_SHIFT 20
+
+#define NS_PER_S 1000000000ULL
+
+struct sched_analysis_task
+{
+  unsigned long long wcet;
+  unsigned long long period;
+  unsigned long long deadline;
+  unsigned long long response_time; /* Zero if unknown or unschedulable */
+};
+
+struct sched_analysis_taskset
+{
+  struct sched_analysis_task *tasks;
+  unsigned *order; /* Task indexes sorted in descending priority */
+  unsigned long long *scratch; /* New response times during admission */
+  unsigned count;
+  unsigned capacity;
+  double utilization;
+  double density;
+  int constrained; /* Non-zero if every task has D <= T */
+  int implicit; /* Non-zero if every task has D == T */
+  int fp_valid; /* Non-zero if order and response times are up-to-date */
+  enum sched_analysis_test fp_test;
+};
+
+/* I. Arithmetic helpers */
+static inline unsigned long long sat_add(unsigned long long a,
+                                         unsigned long long b)
+{
+  return (a > ULLONG_MAX - b) ? ULLONG_MAX : a + b;
+}
+
+static inline unsigned long long sat_mul(unsigned long long a,
+                                         unsigned long long b)
+{
+  return (a != 0 && b > ULLONG_MAX / a) ? ULLONG_MAX : a * b;
+}
+
+static inline unsigned long long ceil_div(unsigned long long a,
+                                          unsigned long long b)
+{
+  return a / b + (a % b != 0);
+}
+
+static unsigned long long gcd(unsigned long long a, unsigned long long b)
+{
+  while (b != 0) {
+    unsigned long long r = a % b;
+    a = b;
+    b = r;
+  }
+  return a;
+}
+
+static unsigned long long to_ns(const relative_time *t)
+{
+  struct timespec t_ts;
+  to_timespec(t, &t_ts);
+  return t_ts.tv_sec * NS_PER_S + t_ts.tv_nsec;
+}
+
+/* Garbage collect the task parameters taking care of the same object
+ * being passed more than once. */
+static void gc_task_params(const relative_time *wcet,
+                           const relative_time *period,
+                           const relative_time *deadline)
+{
+  utility_time_gc_auto(wcet);
+  if (period != wcet) {
+    utility_time_gc_auto(period);
+  }
+  if (deadline != wcet && deadline != period) {
+    utility_time_gc_auto(deadline);
+  }
+}
+/* End of arithmetic helpers */
+
+/* II. Task set management */
+sched_analysis_taskset *sched_analysis_taskset_create(void)
+{
+  sched_analysis_taskset *taskset = malloc(sizeof(*taskset));
+  if (taskset == NULL) {
+    log_syserror("Cannot allocate a task set");
+    return NULL;
+  }
+
+  memset(taskset, 0, sizeof(*taskset));
+  taskset->constrained = 1;
+  taskset->implicit = 1;
+
+  return taskset;
+}
+
+void sched_analysis_taskset_destroy(sched_analysis_taskset *taskset)
+{
+  if (taskset == NULL) {
+    return;
+  }
+
+  free(taskset->tasks);
+  free(taskset->order);
+  free(taskset->scratch);
+  free(taskset);
+}
+
+unsigned sched_analysis_taskset_size(const sched_analysis_taskset *taskset)
+{
+  return taskset->count;
+}
+
+static int reserve(sched_analysis_taskset *taskset, unsigned count)
+{
+  if (count <= taskset->capacity) {
+    return 0;
+  }
+
+  unsigned capacity = (taskset->capacity == 0 ? 8 : taskset->capacity * 2);
+  while (capacity < count) {
+    capacity *= 2;
+  }
+
+  struct sched_analysis_task *tasks
+    = realloc(taskset->tasks, capacity * sizeof(*tasks));
+  if (tasks == NULL) {
+    log_syserror("Cannot enlarge the task array");
+    return -1;
+  }
+  taskset->tasks = tasks;
+
+  unsigned *order = realloc(taskset->order, capacity * sizeof(*order));
+  if (order == NULL) {
+    log_syserror("Cannot enlarge the priority order array");
+    return -1;
+  }
+  taskset->order = order;
+
+  unsigned long long *scratch
+    = realloc(taskset->scratch, capacity * sizeof(*scratch));
+  if (scratch == NULL) {
+    log_syserror("Cannot enlarge the scratch array");
+    return -1;
+  }
+  taskset->scratch = scratch;
+
+  taskset->capacity = capacity;
+  return 0;
+}
+
+static int valid_task(unsigned long long wcet, unsigned long long period,
+                      unsigned long long deadline)
+{
+  if (wcet == 0 || period == 0 || deadline == 0) {
+    log_error("WCET, period and deadline must be positive");
+    return 0;
+  }
+  if (wcet > deadline) {
+    log_error("WCET %llu ns is greater than deadline %llu ns",
+              wcet, deadline);
+    return 0;
+  }
+  return 1;
+}
+
+static inline unsigned long long min_ull(unsigned long long a,
+                                         unsigned long long b)
+{
+  return a < b ? a : b;
+}
+
+/* The caller must have reserved the room for the task */
+static void append_task(sched_analysis_taskset *taskset,
+                        unsigned long long wcet, unsigned long long period,
+                        unsigned long long deadline)
+{
+  struct sched_analysis_task *task = &taskset->tasks[taskset->count++];
+  task->wcet = wcet;
+  task->period = period;
+  task->deadline = deadline;
+  task->response_time = 0;
+
+  taskset->utilization += (double) wcet / period;
+  taskset->density += (double) wcet / min_ull(deadline, period);
+  if (deadline > period) {
+    taskset->constrained = 0;
+  }
+  if (deadline != period) {
+    taskset->implicit = 0;
+  }
+}
+
+/* Recompute the aggregates after the removal of the last task */
+static void remove_last_task(sched_analysis_taskset *taskset)
+{
+  unsigned i;
+
+  taskset->count--;
+  taskset->utilization = 0;
+  taskset->density = 0;
+  taskset->constrained = 1;
+  taskset->implicit = 1;
+  for (i = 0; i < taskset->count; i++) {
+    const struct sched_analysis_task *task = &taskset->tasks[i];
+    taskset->utilization += (double) task->wcet / task->period;
+    taskset->density += ((double) task->wcet
+                         / min_ull(task->deadline, task->period));
+    if (task->deadline > task->period) {
+      taskset->constrained = 0;
+    }
+    if (task->deadline != task->period) {
+      taskset->implicit = 0;
+    }
+  }
+}
+
+int sched_analysis_taskset_add(sched_analysis_taskset *taskset,
+                               const relative_time *wcet,
+                               const relative_time *period,
+                               const relative_time *deadline)
+{
+  unsigned long long c = to_ns(wcet);
+  unsigned long long t = to_ns(period);
+  unsigned long long d = to_ns(deadline);
+  gc_task_params(wcet, period, deadline);
+
+  if (!valid_task(c, t, d)) {
+    return -1;
+  }
+  if (reserve(taskset, taskset->count + 1) != 0) {
+    return -2;
+  }
+
+  append_task(taskset, c, t, d);
+  taskset->fp_valid = 0;
+
+  return 0;
+}
+/* End of task set management */
+
+/* III. Sufficient tests */
+double sched_analysis_utilization(const sched_analysis_taskset *taskset)
+{
+  return taskset->utilization;
+}
+
+double sched_analysis_density(const sched_analysis_taskset *taskset)
+{
+  return taskset->density;
+}
+
+int sched_analysis_liu_layland(const sched_analysis_taskset *taskset)
+{
+  if (!taskset->implicit) {
+    return 0;
+  }
+  if (taskset->count == 0) {
+    return 1;
+  }
+
+  /* Solve x^n = 2 using Newton's method to avoid depending on libm */
+  double x = 2;
+  double prev_x;
+  unsigned n = taskset->count;
+  do {
+    double x_n_1 = 1;
+    unsigned i;
+    for (i = 1; i < n; i++) {
+      x_n_1 *= x;
+    }
+    prev_x = x;
+    x = x - (x_n_1 * x - 2) / (n * x_n_1);
+  } while (prev_x - x > 1e-12);
+
+  return taskset->utilization <= n * (x - 1) + UTILIZATION_EPSILON;
+}
+
+int sched_analysis_hyperbolic_bound(const sched_analysis_taskset *taskset)
+{
+  if (!taskset->implicit) {
+    return 0;
+  }
+
+  double product = 1;
+  unsigned i;
+  for (i = 0; i < taskset->count; i++) {
+    const struct sched_analysis_task *task = &taskset->tasks[i];
+    product *= (double) task->wcet / task->period + 1;
+  }
+
+  return product <= 2 + UTILIZATION_EPSILON;
+}
+/* End of sufficient tests */
+
+/* IV. Exact tests */
+/* The length of the synchronous busy period or ULLONG_MAX if it is
+ * longer than the hyperperiod (i.e., the task set is overloaded). */
+static unsigned long long busy_period(const sched_analysis_taskset *taskset)
+{
+  unsigned long long hyperperiod = 1;
+  unsigned long long w = 0;
+  unsigned i;
+
+  for (i = 0; i < taskset->count; i++) {
+    const struct sched_analysis_task *task = &taskset->tasks[i];
+    hyperperiod = sat_mul(hyperperiod / gcd(hyperperiod, task->period),
+                          task->period);
+    w = sat_add(w, task->wcet);
+  }
+
+  while (1) {
+    unsigned long long next_w = 0;
+    for (i = 0; i < taskset->count; i++) {
+      const struct sched_analysis_task *task = &taskset->tasks[i];
+      next_w = sat_add(next_w, sat_mul(ceil_div(w, task->period),
+                                       task->wcet));
+    }
+    if (next_w == w) {
+      return w;
+    }
+    if (next_w > hyperperiod) {
+      if (hyperperiod == ULLONG_MAX) {
+        log_error("The busy period is too long to analyze");
+      }
+      return ULLONG_MAX;
+    }
+    w = next_w;
+  }
+}
+
+/* The processor demand in the interval [0, t] */
+static unsigned long long demand(const sched_analysis_taskset *taskset,
+                                 unsigned long long t)
+{
+  unsigned long long h = 0;
+  unsigned i;
+
+  for (i = 0; i < taskset->count; i++) {
+    const struct sched_analysis_task *task = &taskset->tasks[i];
+    if (task->deadline <= t) {
+      h = sat_add(h, sat_mul((t - task->deadline) / task->period + 1,
+                             task->wcet));
+    }
+  }
+
+  return h;
+}
+
+/* The latest absolute deadline that is not later than t or zero if
+ * there is none */
+static unsigned long long latest_deadline(const sched_analysis_taskset
+                                          *taskset, unsigned long long t)
+{
+  unsigned long long latest = 0;
+  unsigned i;
+
+  for (i = 0; i < taskset->count; i++) {
+    const struct sched_analysis_task *task = &taskset->tasks[i];
+    if (task->deadline <= t) {
+      unsigned long long d = (((t - task->deadline) / task->period)
+                              * task->period + task->deadline);
+      if (d > latest) {
+        latest = d;
+      }
+    }
+  }
+
+  return latest;
+}
+
+int sched_analysis_edf(const sched_analysis_taskset *taskset)
+{
+  unsigned i;
+
+  if (taskset->count == 0) {
+    return 1;
+  }
+  if (taskset->utilization > 1 + UTILIZATION_EPSILON) {
+    return 0;
+  }
+  if (taskset->density <= 1 - UTILIZATION_EPSILON) {
+    return 1;
+  }
+
+  /* Bound the interval to check */
+  unsigned long long max_deadline = 0;
+  unsigned long long min_deadline = ULLONG_MAX;
+  double la = 0;
+  for (i = 0; i < taskset->count; i++) {
+    const struct sched_analysis_task *task = &taskset->tasks[i];
+    if (task->deadline > max_deadline) {
+      max_deadline = task->deadline;
+    }
+    if (task->deadline < min_deadline) {
+      min_deadline = task->deadline;
+    }
+    la += (((double) task->period - task->deadline)
+           * task->wcet / task->period);
+  }
+
+  unsigned long long l = busy_period(taskset);
+  if (l == ULLONG_MAX) {
+    return 0;
+  }
+  if (taskset->utilization < 1 - UTILIZATION_EPSILON) {
+    la /= 1 - taskset->utilization;
+    if (la < (double) l) {
+      unsigned long long la_ull = (unsigned long long) la + 1;
+      if (la_ull < max_deadline) {
+        la_ull = max_deadline;
+      }
+      if (la_ull < l) {
+        l = la_ull;
+      }
+    }
+  }
+  /* End of bounding the interval to check */
+
+  /* Quick Processor-demand Analysis */
+  unsigned long long t = latest_deadline(taskset, l);
+  unsigned long long h = demand(taskset, t);
+  while (h <= t && h > min_deadline) {
+    if (h < t) {
+      t = h;
+    } else {
+      t = latest_deadline(taskset, t - 1);
+    }
+    h = demand(taskset, t);
+  }
+  /* End of Quick Processor-demand Analysis */
+
+  return h <= min_deadline;
+}
+
+static inline unsigned long long priority_key(const struct sched_analysis_task
+                                              *task,
+                                              enum sched_analysis_test test)
+{
+  return (test == SCHED_ANALYSIS_RM ? task->period : task->deadline);
+}
+
+/* The position in the priority order at which a task with the given
+ * key is to be inserted; an existing task with an equal key keeps
+ * its higher priority */
+static unsigned priority_position(const sched_analysis_taskset *taskset,
+                                  unsigned long long key,
+                                  enum sched_analysis_test test)
+{
+  unsigned pos = taskset->count;
+  while (pos > 0
+         && priority_key(&taskset->tasks[taskset->order[pos - 1]], test) > key) {
+    pos--;
+  }
+  return pos;
+}
+
+/* Iterate the response time of the task at the given position in the
+ * priority order starting from the given seed that must not exceed
+ * the actual response time. Return zero if the deadline is missed. */
+static unsigned long long response_time(const sched_analysis_taskset *taskset,
+                                        const struct sched_analysis_task *task,
+                                        unsigned pos,
+                                        unsigned long long seed)
+{
+  unsigned long long r = seed;
+  unsigned i;
+
+  if (r < task->wcet) {
+    r = task->wcet;
+  }
+  while (r <= task->deadline) {
+    unsigned long long next_r = task->wcet;
+    for (i = 0; i < pos; i++) {
+      const struct sched_analysis_task *hp
+        = &taskset->tasks[taskset->order[i]];
+      next_r = sat_add(next_r, sat_mul(ceil_div(r, hp->period), hp->wcet));
+    }
+    if (next_r == r) {
+      return r;
+    }
+    r = next_r;
+  }
+
+  return 0;
+}
+
+int sched_analysis_fp(sched_analysis_taskset *taskset,
+                      enum sched_analysis_test test)
+{
+  unsigned i;
+  int schedulable = 1;
+
+  if (test != SCHED_ANALYSIS_RM && test != SCHED_ANALYSIS_DM) {
+    log_error("Test %d is not a fixed-priority test", test);
+    return -1;
+  }
+  if (!taskset->constrained) {
+    log_error("Response-time analysis requires D <= T");
+    return -1;
+  }
+
+  /* Stable insertion sort so that ties are broken by the order of
+   * addition */
+  for (i = 0; i < taskset->count; i++) {
+    unsigned long long key = priority_key(&taskset->tasks[i], test);
+    unsigned pos = i;
+    while (pos > 0
+           && (priority_key(&taskset->tasks[taskset->order[pos - 1]], test)
+               > key)) {
+      taskset->order[pos] = taskset->order[pos - 1];
+      pos--;
+    }
+    taskset->order[pos] = i;
+  }
+
+  for (i = 0; i < taskset->count; i++) {
+    struct sched_analysis_task *task = &taskset->tasks[taskset->order[i]];
+    task->response_time = response_time(taskset, task, i, 0);
+    if (task->response_time == 0) {
+      schedulable = 0;
+    }
+  }
+
+  taskset->fp_valid = 1;
+  taskset->fp_test = test;
+
+  return schedulable;
+}
+
+relative_time *sched_analysis_response_time(const sched_analysis_taskset
+                                            *taskset, unsigned idx)
+{
+  if (!taskset->fp_valid || idx >= taskset->count
+      || taskset->tasks[idx].response_time == 0) {
+    return NULL;
+  }
+
+  return to_utility_time_dyn(taskset->tasks[idx].response_time, ns);
+}
+
+static int admit_edf(sched_analysis_taskset *taskset,
+                     unsigned long long c, unsigned long long t,
+                     unsigned long long d)
+{
+  if (taskset->utilization + (double) c / t > 1 + UTILIZATION_EPSILON) {
+    return 0;
+  }
+
+  append_task(taskset, c, t, d);
+  taskset->fp_valid = 0;
+  if (!sched_analysis_edf(taskset)) {
+    remove_last_task(taskset);
+    return 0;
+  }
+
+  return 1;
+}
+
+static int admit_fp(sched_analysis_taskset *taskset,
+                    unsigned long long c, unsigned long long t,
+                    unsigned long long d, enum sched_analysis_test test)
+{
+  unsigned i;
+
+  if (d > t) {
+    log_error("Response-time analysis requires D <= T");
+    return -1;
+  }
+  if (taskset->utilization + (double) c / t > 1 + UTILIZATION_EPSILON) {
+    return 0;
+  }
+  if (!taskset->fp_valid || taskset->fp_test != test) {
+    int rc = sched_analysis_fp(taskset, test);
+    if (rc != 1) {
+      return rc;
+    }
+  } else {
+    for (i = 0; i < taskset->count; i++) {
+      if (taskset->tasks[i].response_time == 0) {
+        return 0;
+      }
+    }
+  }
+
+  /* Insert the new task into the priority order tentatively */
+  unsigned new_idx = taskset->count;
+  struct sched_analysis_task *new_task = &taskset->tasks[new_idx];
+  new_task->wcet = c;
+  new_task->period = t;
+  new_task->deadline = d;
+  unsigned pos = priority_position(taskset, priority_key(new_task, test),
+                                   test);
+  for (i = taskset->count; i > pos; i--) {
+    taskset->order[i] = taskset->order[i - 1];
+  }
+  taskset->order[pos] = new_idx;
+  /* End of inserting the new task tentatively */
+
+  /* Only the new task and those with lower priority are affected;
+   * the previous response times are lower bounds of the new ones */
+  int schedulable = 1;
+  for (i = pos; i <= taskset->count; i++) {
+    struct sched_analysis_task *task = &taskset->tasks[taskset->order[i]];
+    unsigned long long seed = (i == pos ? 0 : task->response_time);
+    taskset->scratch[i] = response_time(taskset, task, i, seed);
+    if (taskset->scratch[i] == 0) {
+      schedulable = 0;
+      break;
+    }
+  }
+
+  if (!schedulable) {
+    for (i = pos; i < taskset->count; i++) {
+      taskset->order[i] = taskset->order[i + 1];
+    }
+    return 0;
+  }
+
+  for (i = pos; i <= taskset->count; i++) {
+    taskset->tasks[taskset->order[i]].response_time = taskset->scratch[i];
+  }
+  append_task(taskset, c, t, d);
+  new_task->response_time = taskset->scratch[pos];
+
+  return 1;
+}
+
+int sched_analysis_admit(sched_analysis_taskset *taskset,
+                         const relative_time *wcet,
+                         const relative_time *period,
+                         const relative_time *deadline,
+                         enum sched_analysis_test test)
+{
+  unsigned long long c = to_ns(wcet);
+  unsigned long long t = to_ns(period);
+  unsigned long long d = to_ns(deadline);
+  gc_task_params(wcet, period, deadline);
+
+  if (!valid_task(c, t, d)) {
+    return -1;
+  }
+  if (reserve(taskset, taskset->count + 1) != 0) {
+    return -2;
+  }
+
+  switch (test) {
+  case SCHED_ANALYSIS_EDF:
+    return admit_edf(taskset, c, t, d);
+  case SCHED_ANALYSIS_RM:
+  case SCHED_ANALYSIS_DM:
+    return admit_fp(taskset, c, t, d, test);
+  }
+
+  log_error("Unknown schedulability test %d", test);
+  return -1;
+}
+/* End of exact tests */
+
+/* V. SCHED_DEADLINE admission control */
+static int read_proc_value(const char *path, long long *value)
+{
+  FILE *proc_file = utility_file_open_for_reading(path);
+  if (proc_file == NULL) {
+    return -1;
+  }
+
+  int rc = 0;
+  if (fscanf(proc_file, "%lld", value) != 1) {
+    log_error("Cannot read the value of %s", path);
+    rc = -1;
+  }
+
+  if (utility_file_close(proc_file, path) != 0) {
+    rc = -1;
+  }
+
+  return rc;
+}
+
+/* Obtain the bandwidth limit in the fixed-point representation of the
+ * kernel. Return 1 if there is no limit, 0 if there is, or -1 in
+ * case of error. */
+static int kernel_bandwidth_limit(unsigned long long *limit)
+{
+  static const char rt_runtime_path[] = "/proc/sys/kernel/sched_rt_runtime_us";
+  static const char rt_period_path[] = "/proc/sys/kernel/sched_rt_period_us";
+  long long rt_runtime_us, rt_period_us;
+
+  if (read_proc_value(rt_runtime_path, &rt_runtime_us) != 0
+      || read_proc_value(rt_period_path, &rt_period_us) != 0) {
+    return -1;
+  }
+
+  if (rt_runtime_us < 0) {
+    return 1;
+  }
+  if (rt_period_us <= 0) {
+    log_error("Invalid %s: %lld", rt_period_path, rt_period_us);
+    return -1;
+  }
+
+  *limit = ((unsigned long long) rt_runtime_us << KERNEL_BW_SHIFT)
+    / rt_period_us;
+  return 0;
+}
+
+double sched_analysis_deadline_bandwidth_limit(void)
+{
+  unsigned long long limit;
+
+  switch (kernel_bandwidth_limit(&limit)) {
+  case 0:
+    return (double) limit / (1 << KERNEL_BW_SHIFT);
+  case 1:
+    return 1.0;
+  default:
+    return -1.0;
+  }
+}
+
+int sched_analysis_deadline_admissible(const sched_analysis_taskset *taskset,
+                                       unsigned cpu_count)
+{
+  unsigned long long limit;
+  unsigned long long total_bw = 0;
+  unsigned i;
+
+  int rc = kernel_bandwidth_limit(&limit);
+  if (rc == -1) {
+    return -1;
+  }
+
+  for (i = 0; i < taskset->count; i++) {
+    const struct sched_analysis_task *task = &taskset->tasks[i];
+    if (task->deadline > task->period) {
+      return 0; /* sched_setattr() rejects such a reservation */
+    }
+    total_bw += (task->wcet << KERNEL_BW_SHIFT) / task->period;
+  }
+
+  return (rc == 1 || total_bw <= limit * cpu_count);
+}
+/* End of SCHED_DEADLINE admission control */
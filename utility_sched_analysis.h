@@ -0,0 +1,264 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+/**
+ * @file utility_sched_analysis.h
+ * @brief Various schedulability tests of a uniprocessor sporadic task
+ *        set to validate an experiment configuration before running
+ *        it.
+ *
+ *        Each task is characterized by its WCET C, its period (or
+ *        minimum inter-arrival time) T and its relative deadline D.
+ *        The tests are:
+ *        - utilization bounds (sufficient tests),
+ *        - the processor demand criterion of EDF using QPA (Quick
+ *          Processor-demand Analysis by Zhang and Burns), which is
+ *          exact for any relation between D and T,
+ *        - the response-time analysis of fixed-priority scheduling
+ *          by Audsley et al. using rate-monotonic or
+ *          deadline-monotonic priorities, which is exact for D <= T,
+ *        - the admission control of SCHED_DEADLINE.
+ *
+ *        A task can be admitted incrementally using
+ *        sched_analysis_admit() that reuses the result of the
+ *        previous analysis instead of analyzing the task set from
+ *        scratch.
+ *
+ *        All computations are done in nanoseconds using integer
+ *        arithmetic except for the utilization.
+ *
+ * @author Tadeus Prastowo <eus@member.fsf.org>
+ */
+
+#ifndef UTILITY_SCHED_ANALYSIS
+#define UTILITY_SCHED_ANALYSIS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "utility_log.h"
+#include "utility_time.h"
+#include "utility_file.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /* I. Main data structures */
+  /** An opaque data type of a task set to be analyzed. */
+  typedef struct sched_analysis_taskset sched_analysis_taskset;
+
+  /** The schedulability tests supported by sched_analysis_admit(). */
+  enum sched_analysis_test {
+    SCHED_ANALYSIS_EDF, /**< sched_analysis_edf(). */
+    SCHED_ANALYSIS_RM, /**< sched_analysis_fp() with RM priorities. */
+    SCHED_ANALYSIS_DM, /**< sched_analysis_fp() with DM priorities. */
+  };
+  /* End of main data structures */
+
+  /* II */
+  /**
+   * @name Collection of functions to build a task set.
+   * @{
+   */
+
+  /**
+   * Create an empty task set.
+   *
+   * @return a pointer to the task set object or NULL if there is
+   * insufficient memory.
+   */
+  sched_analysis_taskset *sched_analysis_taskset_create(void);
+
+  /**
+   * Destroy the given task set.
+   */
+  void sched_analysis_taskset_destroy(sched_analysis_taskset *taskset);
+
+  /**
+   * Add a task to the task set without any schedulability test.
+   *
+   * @param taskset a pointer to the task set.
+   * @param wcet a pointer to utility_time object specifying the WCET
+   * of the task. The utility_time object is garbage collected
+   * automatically if it is possible.
+   * @param period a pointer to utility_time object specifying the
+   * period of the task. The utility_time object is garbage collected
+   * automatically if it is possible.
+   * @param deadline a pointer to utility_time object specifying the
+   * relative deadline of the task. The utility_time object is garbage
+   * collected automatically if it is possible.
+   *
+   * @return zero if the task is added, -1 if the WCET or the period
+   * is zero or the WCET is greater than the deadline, or -2 if there
+   * is insufficient memory.
+   */
+  int sched_analysis_taskset_add(sched_analysis_taskset *taskset,
+                                 const relative_time *wcet,
+                                 const relative_time *period,
+                                 const relative_time *deadline);
+
+  /**
+   * @return the number of tasks in the task set.
+   */
+  unsigned sched_analysis_taskset_size(const sched_analysis_taskset *taskset);
+  /** @} End of collection of functions to build a task set */
+
+  /* III */
+  /**
+   * @name Collection of sufficient schedulability tests.
+   * @{
+   */
+
+  /**
+   * @return the total utilization sum(C / T) of the task set.
+   */
+  double sched_analysis_utilization(const sched_analysis_taskset *taskset);
+
+  /**
+   * @return the total density sum(C / min(D, T)) of the task set.
+   */
+  double sched_analysis_density(const sched_analysis_taskset *taskset);
+
+  /**
+   * @return non-zero if the total utilization is within the Liu and
+   * Layland bound n(2^(1/n) - 1) of RM for implicit deadlines, or
+   * zero otherwise or if some task has D < T.
+   */
+  int sched_analysis_liu_layland(const sched_analysis_taskset *taskset);
+
+  /**
+   * @return non-zero if the task set passes the hyperbolic bound
+   * prod(C / T + 1) <= 2 of RM for implicit deadlines by Bini et al.,
+   * or zero otherwise or if some task has D < T.
+   */
+  int sched_analysis_hyperbolic_bound(const sched_analysis_taskset *taskset);
+  /** @} End of collection of sufficient schedulability tests */
+
+  /* IV */
+  /**
+   * @name Collection of exact schedulability tests.
+   * @{
+   */
+
+  /**
+   * Test the schedulability of the task set under preemptive EDF
+   * using the processor demand criterion.
+   *
+   * @return non-zero if the task set is schedulable or zero
+   * otherwise.
+   */
+  int sched_analysis_edf(const sched_analysis_taskset *taskset);
+
+  /**
+   * Test the schedulability of the task set under preemptive
+   * fixed-priority scheduling using response-time analysis. The
+   * worst-case response times are kept in the task set (c.f.,
+   * sched_analysis_response_time()).
+   *
+   * @param taskset a pointer to the task set.
+   * @param test either SCHED_ANALYSIS_RM (the shorter the period, the
+   * higher the priority) or SCHED_ANALYSIS_DM (the shorter the
+   * deadline, the higher the priority). Ties are broken in favor of
+   * the task added earlier.
+   *
+   * @return 1 if the task set is schedulable, 0 if it is not, or -1
+   * if some task has D > T or the test is not a fixed-priority one.
+   */
+  int sched_analysis_fp(sched_analysis_taskset *taskset,
+                        enum sched_analysis_test test);
+
+  /**
+   * @param taskset a pointer to the task set.
+   * @param idx the position of the task in the order of addition
+   * starting from zero.
+   *
+   * @return the worst-case response time of the task as a utility_time
+   * object fits for automatic garbage collection as obtained by the
+   * last invocation of sched_analysis_fp() or sched_analysis_admit()
+   * with a fixed-priority test, or NULL if the task is not
+   * schedulable, the response time is not known or there is
+   * insufficient memory.
+   */
+  relative_time *sched_analysis_response_time(const sched_analysis_taskset
+                                              *taskset, unsigned idx);
+
+  /**
+   * Add a task to the task set only if the resulting task set is
+   * schedulable according to the given test. Under EDF, the
+   * utilization is checked first. Under RM or DM, only the new task
+   * and the tasks having lower priority than the new task are
+   * analyzed, and their response-time iterations start from the
+   * previously known response times.
+   *
+   * @param taskset a pointer to the task set.
+   * @param wcet like that of sched_analysis_taskset_add().
+   * @param period like that of sched_analysis_taskset_add().
+   * @param deadline like that of sched_analysis_taskset_add().
+   * @param test the schedulability test to use.
+   *
+   * @return 1 if the task is added, 0 if the task is rejected (the
+   * task set is unchanged), -1 if the task parameters are invalid or
+   * the task has D > T under RM or DM, or -2 if there is insufficient
+   * memory.
+   */
+  int sched_analysis_admit(sched_analysis_taskset *taskset,
+                           const relative_time *wcet,
+                           const relative_time *period,
+                           const relative_time *deadline,
+                           enum sched_analysis_test test);
+  /** @} End of collection of exact schedulability tests */
+
+  /* V */
+  /**
+   * @name Collection of SCHED_DEADLINE admission control functions.
+   * @{
+   */
+
+  /**
+   * @return the fraction of each CPU that SCHED_DEADLINE threads may
+   * reserve as configured in /proc/sys/kernel/sched_rt_runtime_us and
+   * /proc/sys/kernel/sched_rt_period_us (1.0 if unlimited), or a
+   * negative value in case of hard error that requires the
+   * investigation of the output of the logging facility to fix the
+   * error.
+   */
+  double sched_analysis_deadline_bandwidth_limit(void);
+
+  /**
+   * Test whether the SCHED_DEADLINE admission control of the kernel
+   * will accept the task set when each task is served by a CBS whose
+   * runtime, deadline and period are the WCET, the deadline and the
+   * period of the task.
+   *
+   * @param taskset a pointer to the task set.
+   * @param cpu_count the number of CPUs in the root domain of the
+   * threads (one in UP mode).
+   *
+   * @return 1 if the task set will be accepted, 0 if it will not, or
+   * -1 if the bandwidth limit cannot be obtained.
+   */
+  int sched_analysis_deadline_admissible(const sched_analysis_taskset
+                                         *taskset, unsigned cpu_count);
+  /** @} End of collection of SCHED_DEADLINE admission control functions */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UTILITY_SCHED_ANALYSIS */
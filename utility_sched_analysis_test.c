@@ -0,0 +1,236 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utility_testcase.h"
+#include "utility_log.h"
+#include "utility_time.h"
+#include "utility_sched_analysis.h"
+
+#define add_ms(taskset, c, t, d)                                        \
+  sched_analysis_taskset_add(taskset, to_utility_time_dyn(c, ms),       \
+                             to_utility_time_dyn(t, ms),                \
+                             to_utility_time_dyn(d, ms))
+
+#define admit_ms(taskset, c, t, d, test)                                \
+  sched_analysis_admit(taskset, to_utility_time_dyn(c, ms),             \
+                       to_utility_time_dyn(t, ms),                      \
+                       to_utility_time_dyn(d, ms), test)
+
+#define MAX_TASKS 6
+
+/* Brute-force processor demand check up to the hyperperiod plus the
+ * longest deadline */
+static int edf_brute_force(const unsigned long long *c,
+                           const unsigned long long *t,
+                           const unsigned long long *d, unsigned n)
+{
+  unsigned long long hyperperiod = 1, max_d = 0, x, gcd, a, b;
+  unsigned i;
+
+  for (i = 0; i < n; i++) {
+    for (a = hyperperiod, b = t[i]; b != 0; gcd = b, b = a % b, a = gcd);
+    hyperperiod = hyperperiod / a * t[i];
+    if (d[i] > max_d) {
+      max_d = d[i];
+    }
+  }
+
+  unsigned long long hyperperiod_demand = 0;
+  for (i = 0; i < n; i++) {
+    hyperperiod_demand += hyperperiod / t[i] * c[i];
+  }
+  if (hyperperiod_demand > hyperperiod) {
+    return 0;
+  }
+
+  for (x = 1; x <= hyperperiod + max_d; x++) {
+    unsigned long long h = 0;
+    for (i = 0; i < n; i++) {
+      if (d[i] <= x) {
+        h += ((x - d[i]) / t[i] + 1) * c[i];
+      }
+    }
+    if (h > x) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+static unsigned random_state = 2011;
+static unsigned next_random(unsigned bound)
+{
+  random_state = random_state * 1103515245 + 12345;
+  return (random_state >> 16) % bound;
+}
+
+MAIN_UNIT_TEST_BEGIN("utility_sched_analysis_test", "stderr", NULL, NULL)
+{
+  sched_analysis_taskset *taskset;
+  unsigned i;
+
+  /* Testcase 1: rate_monotonic task set schedulable only by RTA */
+  gracious_assert((taskset = sched_analysis_taskset_create()) != NULL);
+  gracious_assert(add_ms(taskset, 2, 10, 10) == 0);
+  gracious_assert(add_ms(taskset, 3, 15, 15) == 0);
+  gracious_assert(add_ms(taskset, 6, 26, 26) == 0);
+  gracious_assert(add_ms(taskset, 6, 36, 36) == 0);
+  gracious_assert(sched_analysis_taskset_size(taskset) == 4);
+  gracious_assert(sched_analysis_utilization(taskset) > 0.79
+                  && sched_analysis_utilization(taskset) < 0.80);
+  gracious_assert(!sched_analysis_liu_layland(taskset));
+  gracious_assert(!sched_analysis_hyperbolic_bound(taskset));
+  gracious_assert(sched_analysis_fp(taskset, SCHED_ANALYSIS_RM) == 1);
+  gracious_assert(utility_time_eq_gc(sched_analysis_response_time(taskset, 0),
+                                     to_utility_time_dyn(2, ms)));
+  gracious_assert(utility_time_eq_gc(sched_analysis_response_time(taskset, 1),
+                                     to_utility_time_dyn(5, ms)));
+  gracious_assert(utility_time_eq_gc(sched_analysis_response_time(taskset, 2),
+                                     to_utility_time_dyn(13, ms)));
+  gracious_assert(utility_time_eq_gc(sched_analysis_response_time(taskset, 3),
+                                     to_utility_time_dyn(24, ms)));
+  gracious_assert(sched_analysis_response_time(taskset, 4) == NULL);
+  gracious_assert(sched_analysis_edf(taskset));
+  sched_analysis_taskset_destroy(taskset);
+
+  /* Testcase 2: sufficient tests */
+  gracious_assert((taskset = sched_analysis_taskset_create()) != NULL);
+  gracious_assert(add_ms(taskset, 1, 4, 4) == 0);
+  gracious_assert(add_ms(taskset, 1, 5, 5) == 0);
+  gracious_assert(sched_analysis_liu_layland(taskset));
+  gracious_assert(sched_analysis_hyperbolic_bound(taskset));
+  gracious_assert(add_ms(taskset, 1, 10, 5) == 0);
+  gracious_assert(!sched_analysis_liu_layland(taskset));
+  gracious_assert(sched_analysis_density(taskset) > 0.64
+                  && sched_analysis_density(taskset) < 0.66);
+  sched_analysis_taskset_destroy(taskset);
+
+  /* Testcase 3: constrained deadlines schedulable only by EDF */
+  gracious_assert((taskset = sched_analysis_taskset_create()) != NULL);
+  gracious_assert(add_ms(taskset, 1, 4, 2) == 0);
+  gracious_assert(add_ms(taskset, 2, 5, 5) == 0);
+  gracious_assert(add_ms(taskset, 3, 10, 7) == 0);
+  gracious_assert(sched_analysis_density(taskset) > 1);
+  gracious_assert(sched_analysis_edf(taskset));
+  gracious_assert(sched_analysis_fp(taskset, SCHED_ANALYSIS_RM) == 0);
+  gracious_assert(sched_analysis_response_time(taskset, 2) == NULL);
+  gracious_assert(sched_analysis_fp(taskset, SCHED_ANALYSIS_DM) == 0);
+
+  /* Testcase 4: overload is rejected leaving the task set unchanged */
+  gracious_assert(admit_ms(taskset, 1, 10, 10, SCHED_ANALYSIS_EDF) == 0);
+  gracious_assert(sched_analysis_taskset_size(taskset) == 3);
+  gracious_assert(sched_analysis_utilization(taskset) < 0.96);
+  gracious_assert(admit_ms(taskset, 1, 20, 20, SCHED_ANALYSIS_EDF) == 1);
+  gracious_assert(sched_analysis_taskset_size(taskset) == 4);
+  gracious_assert(sched_analysis_edf(taskset));
+  sched_analysis_taskset_destroy(taskset);
+
+  /* Testcase 5: low utilization does not imply EDF schedulability */
+  gracious_assert((taskset = sched_analysis_taskset_create()) != NULL);
+  gracious_assert(add_ms(taskset, 2, 10, 2) == 0);
+  gracious_assert(admit_ms(taskset, 2, 10, 3, SCHED_ANALYSIS_EDF) == 0);
+  gracious_assert(add_ms(taskset, 2, 10, 3) == 0);
+  gracious_assert(sched_analysis_utilization(taskset) < 0.41);
+  gracious_assert(!sched_analysis_edf(taskset));
+  sched_analysis_taskset_destroy(taskset);
+
+  /* Testcase 6: invalid tasks */
+  gracious_assert((taskset = sched_analysis_taskset_create()) != NULL);
+  gracious_assert(add_ms(taskset, 3, 10, 2) == -1);
+  gracious_assert(add_ms(taskset, 0, 10, 2) == -1);
+  gracious_assert(admit_ms(taskset, 1, 10, 20, SCHED_ANALYSIS_RM) == -1);
+  gracious_assert(admit_ms(taskset, 1, 10, 20, SCHED_ANALYSIS_EDF) == 1);
+  gracious_assert(sched_analysis_fp(taskset, SCHED_ANALYSIS_DM) == -1);
+  sched_analysis_taskset_destroy(taskset);
+
+  /* Testcase 7: the incremental admission agrees with the analysis
+   * from scratch and with the brute-force demand check */
+  unsigned trial;
+  for (trial = 0; trial < 200; trial++) {
+    enum sched_analysis_test test = (trial % 3 == 0 ? SCHED_ANALYSIS_EDF
+                                     : (trial % 3 == 1 ? SCHED_ANALYSIS_RM
+                                        : SCHED_ANALYSIS_DM));
+    sched_analysis_taskset *incremental, *scratch;
+    unsigned long long c[MAX_TASKS], t[MAX_TASKS], d[MAX_TASKS];
+    unsigned n = 0;
+
+    gracious_assert((incremental = sched_analysis_taskset_create()) != NULL);
+    for (i = 0; i < MAX_TASKS; i++) {
+      unsigned long long new_t = 2 + next_random(12);
+      unsigned long long new_c = 1 + next_random(new_t / 2);
+      unsigned long long new_d = new_c + next_random(new_t - new_c + 1);
+      if (test == SCHED_ANALYSIS_EDF && next_random(2)) {
+        new_d += next_random(new_t);
+      }
+
+      gracious_assert((scratch = sched_analysis_taskset_create()) != NULL);
+      unsigned j;
+      for (j = 0; j < n; j++) {
+        gracious_assert(add_ms(scratch, c[j], t[j], d[j]) == 0);
+      }
+      gracious_assert(add_ms(scratch, new_c, new_t, new_d) == 0);
+      int expected = (test == SCHED_ANALYSIS_EDF
+                      ? sched_analysis_edf(scratch)
+                      : sched_analysis_fp(scratch, test));
+
+      int admitted = admit_ms(incremental, new_c, new_t, new_d, test);
+      gracious_assert(admitted == expected);
+
+      c[n] = new_c;
+      t[n] = new_t;
+      d[n] = new_d;
+      if (test == SCHED_ANALYSIS_EDF) {
+        gracious_assert(expected == edf_brute_force(c, t, d, n + 1));
+      }
+
+      if (admitted) {
+        n++;
+        if (test != SCHED_ANALYSIS_EDF) {
+          for (j = 0; j < n; j++) {
+            relative_time *r_scratch = sched_analysis_response_time(scratch,
+                                                                    j);
+            relative_time *r_incremental
+              = sched_analysis_response_time(incremental, j);
+            gracious_assert(r_scratch != NULL && r_incremental != NULL);
+            gracious_assert(utility_time_eq_gc(r_scratch, r_incremental));
+          }
+        }
+      }
+      gracious_assert(sched_analysis_taskset_size(incremental) == n);
+
+      sched_analysis_taskset_destroy(scratch);
+    }
+    sched_analysis_taskset_destroy(incremental);
+  }
+
+  /* Testcase 8: SCHED_DEADLINE admission control */
+  double limit = sched_analysis_deadline_bandwidth_limit();
+  gracious_assert(limit > 0 && limit <= 1);
+  gracious_assert((taskset = sched_analysis_taskset_create()) != NULL);
+  gracious_assert(add_ms(taskset, 25, 400, 200) == 0);
+  gracious_assert(sched_analysis_deadline_admissible(taskset, 1) == 1);
+  gracious_assert(add_ms(taskset, 97, 100, 100) == 0);
+  gracious_assert(sched_analysis_deadline_admissible(taskset, 1) == 0);
+  gracious_assert(sched_analysis_deadline_admissible(taskset, 2)
+                  == (limit * 2 >= sched_analysis_utilization(taskset)));
+  sched_analysis_taskset_destroy(taskset);
+
+} MAIN_UNIT_TEST_END
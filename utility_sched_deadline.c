@@ -22,6 +22,18 @@
 int sched_deadline_enter(const relative_time *wcet,
                          const relative_time *deadline,
                          struct scheduler *old_scheduler)
+{
+  int rc = sched_deadline_enter_ex(wcet, deadline, deadline, 0,
+                                   old_scheduler);
+
+  return (rc == -3 ? -2 : rc);
+}
+
+int sched_deadline_enter_ex(const relative_time *runtime,
+                            const relative_time *deadline,
+                            const relative_time *period,
+                            unsigned int flags,
+                            struct scheduler *old_scheduler)
 {
   /* Save the old scheduler */
   if (sched_save(old_scheduler) != 0) {
@@ -32,26 +44,32 @@ int sched_deadline_enter(const relative_time *wcet,
 
   /* Set SCHED_DEADLINE RT */
   struct sched_param_ex new_sched;
-  to_timespec(wcet, &new_sched.sched_runtime);
-  to_timespec(deadline, &new_sched.sched_period);
+  memset(&new_sched, 0, sizeof(new_sched));
+  to_timespec(runtime, &new_sched.sched_runtime);
   to_timespec(deadline, &new_sched.sched_deadline);
-  new_sched.sched_flags = 0;
+  to_timespec(period, &new_sched.sched_period);
+  new_sched.sched_flags = flags;
 
-  pid_t thread_id = syscall(SYS_gettid);
-
-  if (syscall(SYS_sched_setscheduler_ex, thread_id, SCHED_DEADLINE,
-              sizeof(new_sched), &new_sched) != 0) {
+  if (sched_setscheduler_ex(0, &new_sched) != 0) {
     if (errno == EPERM) {
       return -1;
     }
+    if (errno == EBUSY) {
+      log_error("Admission control rejects SCHED_DEADLINE bandwidth %f",
+                sched_deadline_bandwidth(&new_sched));
+      return -3;
+    }
     log_syserror("Cannot schedule using SCHED_DEADLINE with bandwidth %f",
                  sched_deadline_bandwidth(&new_sched));
     return -2;
   }
   /* End of setting SCHED_DEADLINE RT */
 
-  utility_time_gc_auto(wcet);
-  utility_time_gc_auto(deadline);
+  utility_time_gc_auto(runtime);
+  if (deadline != period) {
+    utility_time_gc_auto(deadline);
+  }
+  utility_time_gc_auto(period);
 
   return 0;
 }
@@ -66,8 +84,11 @@ double sched_deadline_bandwidth(struct sched_param_ex *param_ex)
 #define NS_IN_SEC 1000000000.0
   double bandwidth = (param_ex->sched_runtime.tv_sec * NS_IN_SEC
                       + param_ex->sched_runtime.tv_nsec);
-  bandwidth /= (param_ex->sched_deadline.tv_sec * NS_IN_SEC
-                + param_ex->sched_deadline.tv_nsec);
+  const struct timespec *period = &param_ex->sched_period;
+  if (period->tv_sec == 0 && period->tv_nsec == 0) {
+    period = &param_ex->sched_deadline;
+  }
+  bandwidth /= (period->tv_sec * NS_IN_SEC + period->tv_nsec);
 
   return bandwidth;
 #undef NS_IN_SEC
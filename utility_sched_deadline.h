@@ -18,12 +18,17 @@
 /**
  * @file utility_sched_deadline.h
  * @brief Various convenient functions to use SCHED_DEADLINE of
+ *        mainline Linux (3.14 onwards) or of
  *        git://gitorious.org/sched_deadline/linux-deadline.git.
  *
  *        SCHED_DEADLINE treats each thread as a CBS (Constant
  *        Bandwidth Server) and schedule the threads using EDF
  *        (Earliest Deadline First) scheduling algorithm.
  *
+ *        The ABI of the running kernel is detected at runtime (c.f.,
+ *        sched_deadline_abi()). Only the mainline ABI supports the
+ *        scheduling flags.
+ *
  * @author Tadeus Prastowo <eus@member.fsf.org>
  */
 
@@ -70,6 +75,40 @@ extern "C" {
                            const relative_time *deadline,
                            struct scheduler *old_scheduler);
 
+  /**
+   * Work just like sched_deadline_enter() but allow the runtime, the
+   * relative deadline and the period of the CBS to be specified
+   * independently along with the scheduling flags. The kernel
+   * requires runtime <= deadline <= period.
+   *
+   * @param runtime a pointer to utility_time object specifying the
+   * runtime (budget) of the CBS. The utility_time object is garbage
+   * collected automatically if it is possible.
+   * @param deadline a pointer to utility_time object specifying the
+   * relative deadline of the CBS. The utility_time object is garbage
+   * collected automatically if it is possible.
+   * @param period a pointer to utility_time object specifying the
+   * period of the CBS. The utility_time object is garbage collected
+   * automatically if it is possible.
+   * @param flags a bitwise OR of SCHED_FLAG_RECLAIM,
+   * SCHED_FLAG_DL_OVERRUN and SCHED_FLAG_RESET_ON_FORK or zero.
+   * @param old_scheduler if this is not NULL, the current scheduler
+   * is stored in the pointed location so that it can be restored
+   * using sched_leave().
+   *
+   * @return zero if there is no error and the thread is now a
+   * SCHED_DEADLINE thread having the specified parameters, -1 if the
+   * caller has no sufficient privilege to perform this operation, -2
+   * in case of hard error that requires the investigation of the
+   * output of the logging facility to fix the error, or -3 if the
+   * kernel admission control rejects the bandwidth.
+   */
+  int sched_deadline_enter_ex(const relative_time *runtime,
+                              const relative_time *deadline,
+                              const relative_time *period,
+                              unsigned int flags,
+                              struct scheduler *old_scheduler);
+
   /**
    * Restore the given scheduler.
    *
@@ -90,8 +129,9 @@ extern "C" {
    */
 
   /**
-   * @return the scheduling bandwidth of the given scheduling extended
-   * parameters.
+   * @return the scheduling bandwidth (runtime / period) of the given
+   * scheduling extended parameters. If the period is zero, the
+   * relative deadline is used as the period.
    */
   double sched_deadline_bandwidth(struct sched_param_ex *param_ex);
   /** @} End of collection of functions to work with SCHED_DEADLINE params. */
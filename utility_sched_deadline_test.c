@@ -24,6 +24,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <signal.h>
+#include <math.h>
 #include "utility_testcase.h"
 #include "utility_log.h"
 #include "utility_sched_fifo.h"
@@ -76,6 +77,40 @@ MAIN_UNIT_TEST_BEGIN("utility_sched_deadline_test", "stderr", NULL, NULL)
   gracious_assert(memcmp(&old_param, &expected_old_param,
                          sizeof(struct sched_param)) == 0);
 
+  /* Enter SCHED_DEADLINE with a constrained deadline */
+  if (sched_deadline_abi() == SCHED_DEADLINE_ABI_MAINLINE) {
+    relative_time *expected_period = to_utility_time_dyn(400, ms);
+    utility_time_set_gc_manual(expected_period);
+    gracious_assert(sched_deadline_enter_ex(expected_wcet, expected_dl,
+                                            expected_period,
+                                            SCHED_FLAG_RECLAIM, &old_sched)
+                    == 0);
+
+    gracious_assert(sched_getscheduler(0) == SCHED_DEADLINE);
+    gracious_assert(sched_getparam_ex(0, &new_param_ex) == 0);
+    wcet = timespec_to_utility_time_dyn(&new_param_ex.sched_runtime);
+    dl = timespec_to_utility_time_dyn(&new_param_ex.sched_deadline);
+    utility_time *period
+      = timespec_to_utility_time_dyn(&new_param_ex.sched_period);
+    gracious_assert(utility_time_eq_gc(wcet, expected_wcet));
+    gracious_assert(utility_time_eq_gc(dl, expected_dl));
+    gracious_assert(utility_time_eq_gc(period, expected_period));
+    gracious_assert(new_param_ex.sched_flags & SCHED_FLAG_RECLAIM);
+    gracious_assert(fabs(sched_deadline_bandwidth(&new_param_ex) - 0.0625)
+                    <= 1e-15);
+
+    gracious_assert(sched_deadline_leave(&old_sched) == 0);
+    gracious_assert(sched_getscheduler(0) == expected_old_policy);
+
+    /* Runtime greater than deadline is rejected */
+    gracious_assert(sched_deadline_enter_ex(expected_dl, expected_wcet,
+                                            expected_period, 0, NULL)
+                    == -2);
+    gracious_assert(sched_getscheduler(0) == expected_old_policy);
+
+    utility_time_gc(expected_period);
+  }
+
   /* Clean-up */
   utility_time_gc(expected_wcet);
   utility_time_gc(expected_dl);
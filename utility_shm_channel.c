@@ -0,0 +1,339 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include "utility_shm_channel.h"
+
+#define SHM_CHANNEL_MAGIC 0x4D484353U /* "SCHM" */
+#define CACHE_LINE_SIZE 64
+#define round_up(x, y) (((x) + (y) - 1) / (y) * (y))
+
+/* Each index is written by one process only and sits in its own
+   cache line to avoid false sharing between the two processes */
+struct shm_ring
+{
+  uint32_t head __attribute__((aligned(CACHE_LINE_SIZE))); /* Producer */
+  uint32_t consumer_waiting; /* Non-zero if the consumer sleeps on head */
+  uint32_t tail __attribute__((aligned(CACHE_LINE_SIZE))); /* Consumer */
+  uint32_t producer_waiting; /* Non-zero if the producer sleeps on tail */
+};
+
+/* The slots of the request ring followed by those of the response
+   ring start at the first cache line after this structure. Each slot
+   starts with a uint64_t holding the message size. */
+struct shm_channel_shared
+{
+  uint32_t magic; /* Written last once the channel is initialized */
+  uint32_t slot_count;
+  uint64_t msg_size_max;
+  uint64_t slot_size;
+  uint32_t client_attached;
+  struct shm_ring ring[2]; /* [0] carries requests, [1] carries responses */
+};
+
+struct shm_channel
+{
+  struct shm_channel_shared *shared;
+  size_t map_len;
+  char *name; /* NULL for a client endpoint */
+  struct shm_ring *tx;
+  char *tx_slots;
+  struct shm_ring *rx;
+  char *rx_slots;
+};
+
+static size_t slots_offset(void)
+{
+  return round_up(sizeof(struct shm_channel_shared), CACHE_LINE_SIZE);
+}
+
+static size_t map_len(uint32_t slot_count, uint64_t slot_size)
+{
+  return slots_offset() + 2 * slot_count * slot_size;
+}
+
+static void set_endpoint(shm_channel *ch, int is_server)
+{
+  char *slots = (char *) ch->shared + slots_offset();
+  size_t ring_len = ch->shared->slot_count * ch->shared->slot_size;
+
+  ch->tx = &ch->shared->ring[is_server ? 1 : 0];
+  ch->tx_slots = slots + (is_server ? ring_len : 0);
+  ch->rx = &ch->shared->ring[is_server ? 0 : 1];
+  ch->rx_slots = slots + (is_server ? 0 : ring_len);
+}
+
+int shm_channel_create(const char *name, unsigned slot_count,
+                       size_t msg_size_max, shm_channel **res)
+{
+  int fd = -1;
+  shm_channel *ch = NULL;
+
+  if (slot_count == 0 || (slot_count & (slot_count - 1)) != 0
+      || msg_size_max == 0
+      || msg_size_max > (SIZE_MAX / 4 - slots_offset()) / slot_count) {
+    return -1;
+  }
+
+  ch = malloc(sizeof(*ch));
+  if (ch == NULL) {
+    log_error("No memory to create shm channel endpoint");
+    return -2;
+  }
+  ch->shared = MAP_FAILED;
+  ch->name = malloc(strlen(name) + 1);
+  if (ch->name == NULL) {
+    log_error("No memory to store shm channel name");
+    goto error;
+  }
+  strcpy(ch->name, name);
+
+  uint64_t slot_size = round_up(sizeof(uint64_t) + msg_size_max,
+                                CACHE_LINE_SIZE);
+  ch->map_len = map_len(slot_count, slot_size);
+
+  /* Replace any stale channel whose server has died */
+  if (shm_unlink(name) != 0 && errno != ENOENT) {
+    log_syserror("Cannot remove stale shm channel %s", name);
+    goto error;
+  }
+  fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+  if (fd == -1) {
+    log_syserror("Cannot create shm channel %s", name);
+    goto error;
+  }
+  if (ftruncate(fd, ch->map_len) != 0) {
+    log_syserror("Cannot size shm channel %s", name);
+    goto error;
+  }
+  ch->shared = mmap(NULL, ch->map_len, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    fd, 0);
+  if (ch->shared == MAP_FAILED) {
+    log_syserror("Cannot map shm channel %s", name);
+    goto error;
+  }
+  if (close(fd) != 0) {
+    log_syserror("Cannot close shm channel %s descriptor", name);
+  }
+  fd = -1;
+
+  /* The object is zero-filled by ftruncate */
+  ch->shared->slot_count = slot_count;
+  ch->shared->msg_size_max = msg_size_max;
+  ch->shared->slot_size = slot_size;
+  __atomic_store_n(&ch->shared->magic, SHM_CHANNEL_MAGIC, __ATOMIC_RELEASE);
+
+  set_endpoint(ch, 1);
+
+  *res = ch;
+  return 0;
+
+ error:
+  if (fd != -1) {
+    close(fd);
+    shm_unlink(name);
+  }
+  if (ch->shared != MAP_FAILED) {
+    munmap(ch->shared, ch->map_len);
+  }
+  free(ch->name);
+  free(ch);
+  return -2;
+}
+
+int shm_channel_open(const char *name, shm_channel **res)
+{
+  shm_channel *ch = malloc(sizeof(*ch));
+  if (ch == NULL) {
+    log_error("No memory to create shm channel endpoint");
+    return -2;
+  }
+  ch->name = NULL;
+
+  int fd = shm_open(name, O_RDWR, 0);
+  if (fd == -1) {
+    free(ch);
+    if (errno == ENOENT) {
+      return -1;
+    }
+    log_syserror("Cannot open shm channel %s", name);
+    return -2;
+  }
+
+  struct stat fd_stat;
+  if (fstat(fd, &fd_stat) != 0) {
+    log_syserror("Cannot obtain the size of shm channel %s", name);
+    goto error;
+  }
+  ch->map_len = fd_stat.st_size;
+  if (ch->map_len < slots_offset()) {
+    log_error("%s is not a shm channel", name);
+    goto error;
+  }
+
+  ch->shared = mmap(NULL, ch->map_len, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    fd, 0);
+  if (ch->shared == MAP_FAILED) {
+    log_syserror("Cannot map shm channel %s", name);
+    goto error;
+  }
+  if (close(fd) != 0) {
+    log_syserror("Cannot close shm channel %s descriptor", name);
+  }
+  fd = -1;
+
+  if (__atomic_load_n(&ch->shared->magic, __ATOMIC_ACQUIRE)
+      != SHM_CHANNEL_MAGIC
+      || map_len(ch->shared->slot_count, ch->shared->slot_size)
+      != ch->map_len) {
+    log_error("%s is not a shm channel", name);
+    goto error;
+  }
+
+  uint32_t detached = 0;
+  if (!__atomic_compare_exchange_n(&ch->shared->client_attached, &detached, 1,
+                                   0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+    munmap(ch->shared, ch->map_len);
+    free(ch);
+    return -1;
+  }
+
+  set_endpoint(ch, 0);
+
+  *res = ch;
+  return 0;
+
+ error:
+  if (fd != -1) {
+    close(fd);
+  } else {
+    munmap(ch->shared, ch->map_len);
+  }
+  free(ch);
+  return -2;
+}
+
+void shm_channel_close(shm_channel *ch)
+{
+  if (ch->name == NULL) {
+    __atomic_store_n(&ch->shared->client_attached, 0, __ATOMIC_RELEASE);
+  } else {
+    if (shm_unlink(ch->name) != 0) {
+      log_syserror("Cannot remove shm channel %s", ch->name);
+    }
+    free(ch->name);
+  }
+
+  if (munmap(ch->shared, ch->map_len) != 0) {
+    log_syserror("Cannot unmap shm channel");
+  }
+  free(ch);
+}
+
+/* Sleep until *word is no longer seen. The other process calls
+   wake_up() after changing *word. */
+static int wait_for_change(uint32_t *word, uint32_t *waiting, uint32_t seen)
+{
+  int rc = 0;
+
+  __atomic_store_n(waiting, 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (__atomic_load_n(word, __ATOMIC_RELAXED) == seen
+      && syscall(SYS_futex, word, FUTEX_WAIT, seen, NULL, NULL, 0) != 0
+      && errno != EAGAIN) {
+    if (errno != EINTR) {
+      log_syserror("Cannot wait for shm channel");
+    }
+    rc = -1;
+  }
+  __atomic_store_n(waiting, 0, __ATOMIC_RELAXED);
+
+  return rc;
+}
+
+static void wake_up(uint32_t *word, uint32_t *waiting)
+{
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (__atomic_load_n(waiting, __ATOMIC_RELAXED)
+      && syscall(SYS_futex, word, FUTEX_WAKE, 1, NULL, NULL, 0) == -1) {
+    log_syserror("Cannot wake up shm channel peer");
+  }
+}
+
+ssize_t shm_channel_send(shm_channel *ch, const void *msg, size_t len)
+{
+  struct shm_ring *ring = ch->tx;
+  uint32_t slot_count = ch->shared->slot_count;
+  uint32_t head = ring->head;
+  uint32_t tail;
+
+  if (len > ch->shared->msg_size_max) {
+    errno = EMSGSIZE;
+    return -1;
+  }
+
+  while (head - (tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE))
+         == slot_count) {
+    if (wait_for_change(&ring->tail, &ring->producer_waiting, tail) != 0) {
+      return -1;
+    }
+  }
+
+  char *slot = ch->tx_slots + (head & (slot_count - 1)) * ch->shared->slot_size;
+  *(uint64_t *) slot = len;
+  memcpy(slot + sizeof(uint64_t), msg, len);
+
+  __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+  wake_up(&ring->head, &ring->consumer_waiting);
+
+  return len;
+}
+
+ssize_t shm_channel_recv(shm_channel *ch, void *buffer, size_t len)
+{
+  struct shm_ring *ring = ch->rx;
+  uint32_t slot_count = ch->shared->slot_count;
+  uint32_t tail = ring->tail;
+  uint32_t head;
+
+  while ((head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) == tail) {
+    if (wait_for_change(&ring->head, &ring->consumer_waiting, head) != 0) {
+      return -1;
+    }
+  }
+
+  char *slot = ch->rx_slots + (tail & (slot_count - 1)) * ch->shared->slot_size;
+  uint64_t msg_len = *(uint64_t *) slot;
+  if (msg_len < len) {
+    len = msg_len;
+  }
+  memcpy(buffer, slot + sizeof(uint64_t), len);
+
+  __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+  wake_up(&ring->tail, &ring->producer_waiting);
+
+  return len;
+}
+
+size_t shm_channel_msg_size_max(const shm_channel *ch)
+{
+  return ch->shared->msg_size_max;
+}
+
+unsigned shm_channel_slot_count(const shm_channel *ch)
+{
+  return ch->shared->slot_count;
+}
@@ -0,0 +1,154 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+/**
+ * @file utility_shm_channel.h
+ * @brief A request-response channel between two processes on the same
+ * host that bypasses the network stack.
+ *
+ * A channel is a POSIX shared memory object holding two
+ * single-producer single-consumer (SPSC) rings of fixed-size message
+ * slots: one carries the requests from the client to the server and
+ * the other carries the responses back. A process that finds a ring
+ * empty (or full) sleeps on a futex that is woken by the other
+ * process only when there is a sleeper, so that exchanging a message
+ * costs no system call when both processes are awake.
+ *
+ * The server creates the channel using shm_channel_create() and
+ * exactly one client at a time attaches to the channel using
+ * shm_channel_open(). Both then exchange messages using
+ * shm_channel_send() and shm_channel_recv() whose semantics mimic
+ * those of send(2) and recv(2) on a datagram socket.
+ *
+ * @author Tadeus Prastowo <eus@member.fsf.org>
+ */
+
+#ifndef UTILITY_SHM_CHANNEL
+#define UTILITY_SHM_CHANNEL
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "utility_log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /**
+   * A channel endpoint.
+   * This is an opaque type; do not manipulate any of its instances directly.
+   */
+  typedef struct shm_channel shm_channel;
+
+  /**
+   * Create a channel to be served by the caller. Any stale channel
+   * having the same name is replaced.
+   *
+   * @param name the name of the POSIX shared memory object that
+   * starts with '/' and contains no other '/' (c.f., shm_open(3)).
+   * @param slot_count the number of messages that can be queued in
+   * each direction, which must be a power of two.
+   * @param msg_size_max the maximum size in bytes of a message.
+   * @param res a pointer to the object to store the server endpoint.
+   *
+   * @return 0 if the channel is created, -1 if slot_count is not a
+   * power of two or msg_size_max is zero or too big, or -2 in case of
+   * hard error that requires the investigation of the output of the
+   * logging facility to fix the error.
+   */
+  int shm_channel_create(const char *name, unsigned slot_count,
+                         size_t msg_size_max, shm_channel **res);
+
+  /**
+   * Attach the caller as the client of a channel created by
+   * shm_channel_create().
+   *
+   * @param name the name given to shm_channel_create().
+   * @param res a pointer to the object to store the client endpoint.
+   *
+   * @return 0 if the caller is attached, -1 if the channel does not
+   * exist or another client is already attached, or -2 in case of
+   * hard error that requires the investigation of the output of the
+   * logging facility to fix the error.
+   */
+  int shm_channel_open(const char *name, shm_channel **res);
+
+  /**
+   * Close a channel endpoint. Closing a client endpoint lets another
+   * client attach to the channel while closing the server endpoint
+   * also removes the name of the channel.
+   *
+   * @param ch a pointer to the endpoint to be closed.
+   */
+  void shm_channel_close(shm_channel *ch);
+
+  /**
+   * Send a message to the other endpoint blocking while the ring is
+   * full.
+   *
+   * @param ch a pointer to the endpoint.
+   * @param msg a pointer to the message.
+   * @param len the size of the message.
+   *
+   * @return len if the message is sent. Otherwise, -1 is returned
+   * and errno is set to EMSGSIZE if len exceeds the msg_size_max of
+   * the channel, to EINTR if a signal interrupts the blocking, or to
+   * another value in case of hard error that is logged.
+   */
+  ssize_t shm_channel_send(shm_channel *ch, const void *msg, size_t len);
+
+  /**
+   * Receive a message from the other endpoint blocking while the
+   * ring is empty. Like recv(2) on a datagram socket, the message is
+   * truncated if it is larger than the buffer.
+   *
+   * @param ch a pointer to the endpoint.
+   * @param buffer a pointer to the buffer to store the message.
+   * @param len the size of the buffer.
+   *
+   * @return the number of bytes stored in the buffer. Otherwise, -1
+   * is returned and errno is set to EINTR if a signal interrupts the
+   * blocking, or to another value in case of hard error that is
+   * logged.
+   */
+  ssize_t shm_channel_recv(shm_channel *ch, void *buffer, size_t len);
+
+  /**
+   * @return the maximum size in bytes of a message of the channel.
+   */
+  size_t shm_channel_msg_size_max(const shm_channel *ch);
+
+  /**
+   * @return the number of messages that can be queued in each
+   * direction of the channel.
+   */
+  unsigned shm_channel_slot_count(const shm_channel *ch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UTILITY_SHM_CHANNEL */
@@ -0,0 +1,180 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "utility_testcase.h"
+#include "utility_log.h"
+#include "utility_shm_channel.h"
+
+#define SLOT_COUNT 4
+#define MSG_SIZE_MAX 128
+#define ROUND_TRIP_COUNT 10000
+
+static char channel_name[64];
+static void cleanup(void)
+{
+  shm_unlink(channel_name);
+}
+
+static void fill_message(char *msg, size_t len, unsigned seq)
+{
+  size_t i;
+  for (i = 0; i < len; i++) {
+    msg[i] = (char) (seq + i);
+  }
+}
+
+/* The client process: send requests and check the echoed responses */
+static int run_client(int burst)
+{
+  shm_channel *ch;
+  char request[MSG_SIZE_MAX], response[MSG_SIZE_MAX];
+  unsigned i;
+
+  if (shm_channel_open(channel_name, &ch) != 0) {
+    return 1;
+  }
+
+  if (burst) {
+    /* Fill the ring beyond its capacity while the server is asleep */
+    for (i = 0; i < SLOT_COUNT * 4; i++) {
+      size_t len = 1 + i % MSG_SIZE_MAX;
+      fill_message(request, len, i);
+      if (shm_channel_send(ch, request, len) != len) {
+        return 2;
+      }
+    }
+  } else {
+    for (i = 0; i < ROUND_TRIP_COUNT; i++) {
+      size_t len = 1 + i % MSG_SIZE_MAX;
+      fill_message(request, len, i);
+      if (shm_channel_send(ch, request, len) != len) {
+        return 3;
+      }
+      if (shm_channel_recv(ch, response, sizeof(response)) != len
+          || memcmp(request, response, len) != 0) {
+        return 4;
+      }
+    }
+  }
+
+  shm_channel_close(ch);
+  return 0;
+}
+
+static void interrupt(int signo)
+{
+}
+
+MAIN_UNIT_TEST_BEGIN("utility_shm_channel_test", "stderr", NULL, cleanup)
+{
+  shm_channel *server, *client;
+  char buffer[MSG_SIZE_MAX], msg[MSG_SIZE_MAX];
+  pid_t child;
+  int status;
+  unsigned i;
+
+  snprintf(channel_name, sizeof(channel_name),
+           "/utility_shm_channel_test-%d", getpid());
+
+  /* Testcase 1: invalid parameters */
+  gracious_assert(shm_channel_create(channel_name, 0, MSG_SIZE_MAX, &server)
+                  == -1);
+  gracious_assert(shm_channel_create(channel_name, 3, MSG_SIZE_MAX, &server)
+                  == -1);
+  gracious_assert(shm_channel_create(channel_name, SLOT_COUNT, 0, &server)
+                  == -1);
+  gracious_assert(shm_channel_open(channel_name, &client) == -1);
+
+  /* Testcase 2: only one client can be attached at a time */
+  gracious_assert(shm_channel_create(channel_name, SLOT_COUNT, MSG_SIZE_MAX,
+                                     &server) == 0);
+  gracious_assert(shm_channel_msg_size_max(server) == MSG_SIZE_MAX);
+  gracious_assert(shm_channel_open(channel_name, &client) == 0);
+  gracious_assert(shm_channel_msg_size_max(client) == MSG_SIZE_MAX);
+  gracious_assert(shm_channel_slot_count(client) == SLOT_COUNT);
+  shm_channel *another_client;
+  gracious_assert(shm_channel_open(channel_name, &another_client) == -1);
+
+  /* Testcase 3: message boundary and truncation in both directions */
+  fill_message(msg, sizeof(msg), 7);
+  gracious_assert(shm_channel_send(client, msg, sizeof(msg) + 1) == -1
+                  && errno == EMSGSIZE);
+  gracious_assert(shm_channel_send(client, msg, 10) == 10);
+  gracious_assert(shm_channel_send(client, msg, sizeof(msg)) == sizeof(msg));
+  gracious_assert(shm_channel_recv(server, buffer, sizeof(buffer)) == 10);
+  gracious_assert(memcmp(buffer, msg, 10) == 0);
+  gracious_assert(shm_channel_recv(server, buffer, 5) == 5);
+  gracious_assert(memcmp(buffer, msg, 5) == 0);
+  gracious_assert(shm_channel_send(server, "pong", 5) == 5);
+  gracious_assert(shm_channel_recv(client, buffer, sizeof(buffer)) == 5);
+  gracious_assert(strcmp(buffer, "pong") == 0);
+
+  /* Testcase 4: a blocked receiver is interrupted by a signal */
+  struct sigaction act = {
+    .sa_handler = interrupt,
+  };
+  gracious_assert(sigaction(SIGALRM, &act, NULL) == 0);
+  gracious_assert(ualarm(50000, 0) == 0);
+  gracious_assert(shm_channel_recv(server, buffer, sizeof(buffer)) == -1
+                  && errno == EINTR);
+
+  shm_channel_close(client);
+  gracious_assert(shm_channel_open(channel_name, &client) == 0);
+  shm_channel_close(client);
+
+  /* Testcase 5: request-response with a client process */
+  child = fork();
+  gracious_assert(child != -1);
+  if (child == 0) {
+    _exit(run_client(0));
+  }
+  for (i = 0; i < ROUND_TRIP_COUNT; i++) {
+    ssize_t len = shm_channel_recv(server, buffer, sizeof(buffer));
+    ssize_t expected_len = 1 + i % MSG_SIZE_MAX;
+    gracious_assert(len == expected_len);
+    gracious_assert(shm_channel_send(server, buffer, len) == len);
+  }
+  gracious_assert(waitpid(child, &status, 0) == child);
+  gracious_assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+  /* Testcase 6: a client blocked on a full ring is woken up in order */
+  child = fork();
+  gracious_assert(child != -1);
+  if (child == 0) {
+    _exit(run_client(1));
+  }
+  usleep(100000);
+  for (i = 0; i < SLOT_COUNT * 4; i++) {
+    size_t len = 1 + i % MSG_SIZE_MAX;
+    fill_message(msg, len, i);
+    gracious_assert(shm_channel_recv(server, buffer, sizeof(buffer)) == len);
+    gracious_assert(memcmp(buffer, msg, len) == 0);
+  }
+  gracious_assert(waitpid(child, &status, 0) == child);
+  gracious_assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+  /* Testcase 7: closing the server endpoint removes the channel */
+  shm_channel_close(server);
+  gracious_assert(shm_channel_open(channel_name, &client) == -1);
+
+} MAIN_UNIT_TEST_END
@@ -0,0 +1,653 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include "utility_simulator.h"
+
+#define NEVER (~0ULL)
+#define NS_PER_S 1000000000ULL
+
+/* The PID of the first task in the trace */
+#define FIRST_PID 1000
+/* The priority of the idle task in the trace */
+#define IDLE_PRIO 120
+
+/* At the same time, a replenishment is processed before a release so
+   that a released job sees the replenished budget */
+enum event_kind
+{
+  EVENT_REPLENISH,
+  EVENT_RELEASE,
+};
+
+struct event
+{
+  unsigned long long t;
+  enum event_kind kind;
+  unsigned task_idx;
+};
+
+struct sim_task
+{
+  struct simulator_task desc; /* The strings are owned by this. */
+
+  unsigned long released; /* The number of released jobs. */
+  unsigned long finished; /* The number of completed jobs. */
+  unsigned long long remaining; /* The execution time left of the
+                                   oldest pending job. */
+  int started; /* Non-zero if the oldest pending job has started. */
+  unsigned long long t_start; /* When the oldest pending job started. */
+  unsigned long long stamp; /* When the task became ready in terms of
+                               simulator::stamp. */
+
+  unsigned long long budget; /* The remaining runtime of the CBS. */
+  unsigned long long server_deadline; /* The deadline of the CBS. */
+  int throttled; /* Non-zero if the CBS waits for a replenishment. */
+
+  jobstats_ringbuf *jobs;
+  unsigned long late_count;
+  unsigned long long max_response;
+};
+
+struct sim_cpu
+{
+  struct event *events; /* The min-heap of the events of the CPU. */
+  unsigned event_count;
+  unsigned event_capacity;
+  int running; /* The index of the dispatched task or -1 if idle. */
+  int dispatching; /* Non-zero while the overhead is being paid. */
+  unsigned long long t_dispatched; /* When the overhead is paid. */
+  unsigned long long t_last; /* Until when the running task is
+                                accounted. */
+};
+
+struct simulator
+{
+  unsigned long long overhead_ns;
+  FILE *trace;
+  struct sim_task *tasks;
+  unsigned task_count;
+  unsigned task_capacity;
+  struct sim_cpu *cpus;
+  unsigned cpu_count;
+  unsigned long long start;
+  unsigned long long stop;
+  unsigned long long stamp;
+  unsigned long dispatch_count;
+  unsigned long event_count;
+  unsigned long long t_end;
+  int done;
+};
+
+/* Event heap section */
+static int event_before(const struct event *a, const struct event *b)
+{
+  if (a->t != b->t) {
+    return a->t < b->t;
+  }
+  if (a->kind != b->kind) {
+    return a->kind < b->kind;
+  }
+  return a->task_idx < b->task_idx;
+}
+
+static int event_push(struct sim_cpu *cpu, unsigned long long t,
+                      enum event_kind kind, unsigned task_idx)
+{
+  unsigned i;
+
+  if (cpu->event_count == cpu->event_capacity) {
+    unsigned capacity = (cpu->event_capacity == 0
+                         ? 16 : cpu->event_capacity * 2);
+    struct event *events = realloc(cpu->events, sizeof(*events) * capacity);
+    if (events == NULL) {
+      log_error("Not enough memory to schedule an event");
+      return -1;
+    }
+    cpu->events = events;
+    cpu->event_capacity = capacity;
+  }
+
+  i = cpu->event_count++;
+  cpu->events[i].t = t;
+  cpu->events[i].kind = kind;
+  cpu->events[i].task_idx = task_idx;
+  while (i > 0 && event_before(&cpu->events[i], &cpu->events[(i - 1) / 2])) {
+    struct event tmp = cpu->events[i];
+    cpu->events[i] = cpu->events[(i - 1) / 2];
+    cpu->events[(i - 1) / 2] = tmp;
+    i = (i - 1) / 2;
+  }
+
+  return 0;
+}
+
+static struct event event_pop(struct sim_cpu *cpu)
+{
+  struct event top = cpu->events[0];
+  unsigned i = 0;
+
+  cpu->events[0] = cpu->events[--cpu->event_count];
+  for (;;) {
+    unsigned smallest = i, child;
+    for (child = 2 * i + 1; child <= 2 * i + 2; child++) {
+      if (child < cpu->event_count
+          && event_before(&cpu->events[child], &cpu->events[smallest])) {
+        smallest = child;
+      }
+    }
+    if (smallest == i) {
+      break;
+    }
+    struct event tmp = cpu->events[i];
+    cpu->events[i] = cpu->events[smallest];
+    cpu->events[smallest] = tmp;
+    i = smallest;
+  }
+
+  return top;
+}
+/* END: Event heap section */
+
+/* Trace section */
+static void trace_time(FILE *trace, unsigned long long t)
+{
+  fprintf(trace, "%llu.%06llu:", t / NS_PER_S, t % NS_PER_S / 1000);
+}
+
+static void trace_task(const simulator *sim, int idx, unsigned *pid,
+                       unsigned *prio, const char **name)
+{
+  if (idx == -1) {
+    *pid = 0;
+    *prio = IDLE_PRIO;
+    *name = "<idle>";
+  } else {
+    const struct simulator_task *desc = &sim->tasks[idx].desc;
+    *pid = FIRST_PID + idx;
+    *prio = (desc->policy == SIMULATOR_FP ? desc->prio_level : 0);
+    *name = desc->name;
+  }
+}
+
+static void trace_line(const simulator *sim, unsigned cpu_id,
+                       unsigned long long t, int from, const char *from_state,
+                       const char *op, int to)
+{
+  unsigned from_pid, from_prio, to_pid, to_prio;
+  const char *from_name, *to_name;
+
+  if (sim->trace == NULL) {
+    return;
+  }
+
+  trace_task(sim, from, &from_pid, &from_prio, &from_name);
+  trace_task(sim, to, &to_pid, &to_prio, &to_name);
+  fprintf(sim->trace, "%16s-%-5u [%03u] ", from_name, from_pid, cpu_id);
+  trace_time(sim->trace, t);
+  fprintf(sim->trace, " %5u:%3u:%s %s [%03u] %5u:%3u:R\n", from_pid,
+          from_prio, from_state, op, cpu_id, to_pid, to_prio);
+}
+/* END: Trace section */
+
+/* Scheduling section */
+static unsigned long pending(const struct sim_task *t)
+{
+  return t->released - t->finished;
+}
+
+static unsigned long long release_time(const simulator *sim,
+                                       const struct sim_task *t,
+                                       unsigned long job_idx)
+{
+  return sim->start + t->desc.offset_ns + job_idx * t->desc.period_ns;
+}
+
+static int is_ready(const struct sim_task *t)
+{
+  return pending(t) != 0 && !t->throttled;
+}
+
+/* Return non-zero if task a should run instead of task b */
+static int runs_before(const simulator *sim, const struct sim_task *a,
+                       const struct sim_task *b)
+{
+  int a_is_fp = (a->desc.policy == SIMULATOR_FP);
+  int b_is_fp = (b->desc.policy == SIMULATOR_FP);
+
+  if (a_is_fp != b_is_fp) {
+    return !a_is_fp;
+  }
+
+  if (a_is_fp) {
+    if (a->desc.prio_level != b->desc.prio_level) {
+      return a->desc.prio_level < b->desc.prio_level;
+    }
+  } else {
+    unsigned long long a_deadline
+      = (a->desc.policy == SIMULATOR_CBS
+         ? a->server_deadline
+         : release_time(sim, a, a->finished) + a->desc.deadline_ns);
+    unsigned long long b_deadline
+      = (b->desc.policy == SIMULATOR_CBS
+         ? b->server_deadline
+         : release_time(sim, b, b->finished) + b->desc.deadline_ns);
+    if (a_deadline != b_deadline) {
+      return a_deadline < b_deadline;
+    }
+  }
+
+  return a->stamp < b->stamp;
+}
+
+static int pick(const simulator *sim, unsigned cpu_id)
+{
+  int best = -1;
+  unsigned i;
+
+  for (i = 0; i < sim->task_count; i++) {
+    const struct sim_task *t = &sim->tasks[i];
+    if (t->desc.cpu == cpu_id && is_ready(t)
+        && (best == -1 || runs_before(sim, t, &sim->tasks[best]))) {
+      best = i;
+    }
+  }
+
+  return best;
+}
+
+/* Return the time of the next event or decision of the given CPU */
+static unsigned long long next_time(const simulator *sim,
+                                    const struct sim_cpu *cpu)
+{
+  unsigned long long t = (cpu->event_count == 0 ? NEVER : cpu->events[0].t);
+
+  if (cpu->dispatching) {
+    if (cpu->t_dispatched < t) {
+      t = cpu->t_dispatched;
+    }
+  } else if (cpu->running != -1) {
+    const struct sim_task *r = &sim->tasks[cpu->running];
+    unsigned long long left = r->remaining;
+    if (r->desc.policy == SIMULATOR_CBS && r->budget < left) {
+      left = r->budget;
+    }
+    if (cpu->t_last + left < t) {
+      t = cpu->t_last + left;
+    }
+  }
+
+  return t;
+}
+
+static void complete_job(simulator *sim, struct sim_task *t,
+                         unsigned long long now)
+{
+  unsigned long long t_release = release_time(sim, t, t->finished);
+  struct timespec t_begin = {
+    .tv_sec = t->t_start / NS_PER_S,
+    .tv_nsec = t->t_start % NS_PER_S,
+  };
+  struct timespec t_end = {
+    .tv_sec = now / NS_PER_S,
+    .tv_nsec = now % NS_PER_S,
+  };
+
+  job_record(t->jobs, &t_begin, &t_end);
+  if (now - t_release > t->max_response) {
+    t->max_response = now - t_release;
+  }
+  if (now > t_release + t->desc.deadline_ns) {
+    t->late_count++;
+  }
+  t->finished++;
+  t->started = 0;
+  t->remaining = t->desc.exec_ns;
+  if (now > sim->t_end) {
+    sim->t_end = now;
+  }
+}
+
+static int process_event(simulator *sim, unsigned cpu_id,
+                         const struct event *e)
+{
+  struct sim_cpu *cpu = &sim->cpus[cpu_id];
+  struct sim_task *t = &sim->tasks[e->task_idx];
+  unsigned long long next_release;
+
+  sim->event_count++;
+
+  if (e->kind == EVENT_REPLENISH) {
+    t->throttled = 0;
+    t->server_deadline += t->desc.period_ns;
+    t->budget = t->desc.wcet_ns;
+    return 0;
+  }
+
+  /* EVENT_RELEASE */
+  if (pending(t) == 0) {
+    t->stamp = ++sim->stamp;
+    if (t->desc.policy == SIMULATOR_CBS && !t->throttled
+        && (t->server_deadline <= e->t
+            || ((unsigned __int128) t->budget * t->desc.deadline_ns
+                > ((unsigned __int128) (t->server_deadline - e->t)
+                   * t->desc.wcet_ns)))) {
+      t->server_deadline = e->t + t->desc.deadline_ns;
+      t->budget = t->desc.wcet_ns;
+    }
+    trace_line(sim, cpu_id, e->t, cpu->running, "R", "+", e->task_idx);
+  }
+  t->released++;
+
+  next_release = release_time(sim, t, t->released);
+  if (next_release < sim->stop
+      && event_push(cpu, next_release, EVENT_RELEASE, e->task_idx) != 0) {
+    return -1;
+  }
+
+  return 0;
+}
+
+static int step(simulator *sim, unsigned cpu_id, unsigned long long now)
+{
+  struct sim_cpu *cpu = &sim->cpus[cpu_id];
+  int next;
+
+  /* Account the running task */
+  if (cpu->dispatching && now >= cpu->t_dispatched) {
+    cpu->dispatching = 0;
+  } else if (!cpu->dispatching && cpu->running != -1) {
+    struct sim_task *r = &sim->tasks[cpu->running];
+    unsigned long long ran = now - cpu->t_last;
+
+    r->remaining -= ran;
+    if (r->desc.policy == SIMULATOR_CBS) {
+      r->budget -= ran;
+    }
+    if (r->remaining == 0) {
+      complete_job(sim, r, now);
+    }
+    if (r->desc.policy == SIMULATOR_CBS && r->budget == 0) {
+      r->throttled = 1;
+      if (event_push(cpu, (r->server_deadline - r->desc.deadline_ns
+                           + r->desc.period_ns),
+                     EVENT_REPLENISH, cpu->running) != 0) {
+        return -1;
+      }
+    }
+  }
+  cpu->t_last = now;
+  /* END: Account the running task */
+
+  while (cpu->event_count != 0 && cpu->events[0].t <= now) {
+    struct event e = event_pop(cpu);
+    if (process_event(sim, cpu_id, &e) != 0) {
+      return -1;
+    }
+  }
+
+  if (cpu->dispatching) {
+    return 0;
+  }
+
+  /* Dispatch */
+  next = pick(sim, cpu_id);
+  if (next != cpu->running) {
+    trace_line(sim, cpu_id, now, cpu->running,
+               (cpu->running == -1 || is_ready(&sim->tasks[cpu->running])
+                ? "R" : "S"), "==>", next);
+    cpu->running = next;
+    if (next != -1) {
+      sim->dispatch_count++;
+      if (sim->overhead_ns != 0) {
+        cpu->dispatching = 1;
+        cpu->t_dispatched = now + sim->overhead_ns;
+        return 0;
+      }
+    }
+  }
+  if (next != -1 && !sim->tasks[next].started) {
+    sim->tasks[next].started = 1;
+    sim->tasks[next].t_start = now;
+  }
+  /* END: Dispatch */
+
+  return 0;
+}
+/* END: Scheduling section */
+
+/* Statistics section */
+static int write_stats(const simulator *sim, const struct sim_task *t)
+{
+  FILE *stats_log;
+  int rc;
+
+  stats_log = utility_file_open_for_writing_bin(t->desc.stats_file_path);
+  if (stats_log == NULL) {
+    log_error("Cannot open '%s' for binary writing", t->desc.stats_file_path);
+    return -1;
+  }
+
+  rc = task_statistics_write(stats_log, t->desc.name,
+                             to_utility_time_dyn(t->desc.wcet_ns, ns),
+                             to_utility_time_dyn(t->desc.period_ns, ns),
+                             to_utility_time_dyn(t->desc.deadline_ns, ns),
+                             to_utility_time_dyn(sim->start, ns),
+                             to_utility_time_dyn(t->desc.offset_ns, ns),
+                             to_utility_time_dyn(0, ns),
+                             to_utility_time_dyn(sim->overhead_ns, ns),
+                             t->jobs);
+
+  if (utility_file_close(stats_log, t->desc.stats_file_path) != 0) {
+    rc = -1;
+  }
+
+  return rc;
+}
+/* END: Statistics section */
+
+simulator *simulator_create(unsigned long long overhead_ns, FILE *trace)
+{
+  simulator *sim = calloc(1, sizeof(*sim));
+
+  if (sim == NULL) {
+    log_error("Not enough memory to create a simulator");
+    return NULL;
+  }
+
+  sim->overhead_ns = overhead_ns;
+  sim->trace = trace;
+
+  return sim;
+}
+
+void simulator_destroy(simulator *sim)
+{
+  unsigned i;
+
+  for (i = 0; i < sim->task_count; i++) {
+    struct sim_task *t = &sim->tasks[i];
+    free((char *) t->desc.name);
+    free((char *) t->desc.stats_file_path);
+    if (t->jobs != NULL) {
+      jobstats_ringbuf_destroy(t->jobs);
+    }
+  }
+  free(sim->tasks);
+
+  for (i = 0; i < sim->cpu_count; i++) {
+    free(sim->cpus[i].events);
+  }
+  free(sim->cpus);
+
+  free(sim);
+}
+
+int simulator_add(simulator *sim, const struct simulator_task *desc)
+{
+  struct sim_task *t;
+
+  if (desc->name == NULL || desc->name[0] == '\0' || desc->exec_ns == 0
+      || desc->period_ns == 0 || desc->deadline_ns == 0
+      || (desc->policy == SIMULATOR_CBS && desc->wcet_ns == 0)
+      || (desc->policy == SIMULATOR_FP && desc->prio_level == 0)) {
+    return -1;
+  }
+
+  if (sim->task_count == sim->task_capacity) {
+    unsigned capacity = (sim->task_capacity == 0
+                         ? 8 : sim->task_capacity * 2);
+    struct sim_task *tasks = realloc(sim->tasks, sizeof(*tasks) * capacity);
+    if (tasks == NULL) {
+      log_error("Not enough memory to add a task");
+      return -2;
+    }
+    sim->tasks = tasks;
+    sim->task_capacity = capacity;
+  }
+
+  t = &sim->tasks[sim->task_count];
+  memset(t, 0, sizeof(*t));
+  t->desc = *desc;
+  t->desc.name = strdup(desc->name);
+  t->desc.stats_file_path = (desc->stats_file_path == NULL
+                             ? NULL : strdup(desc->stats_file_path));
+  if (t->desc.name == NULL
+      || (desc->stats_file_path != NULL && t->desc.stats_file_path == NULL)) {
+    log_error("Not enough memory to add a task");
+    free((char *) t->desc.name);
+    free((char *) t->desc.stats_file_path);
+    return -2;
+  }
+  t->remaining = desc->exec_ns;
+  t->budget = desc->wcet_ns;
+
+  return sim->task_count++;
+}
+
+int simulator_run(simulator *sim, unsigned long long start_ns,
+                  unsigned long long stop_ns)
+{
+  unsigned i;
+  int rc = 0;
+
+  if (sim->done) {
+    return -1;
+  }
+  sim->done = 1;
+  sim->start = start_ns;
+  sim->stop = stop_ns;
+
+  /* Prepare the CPUs and the first releases */
+  for (i = 0; i < sim->task_count; i++) {
+    if (sim->tasks[i].desc.cpu >= sim->cpu_count) {
+      sim->cpu_count = sim->tasks[i].desc.cpu + 1;
+    }
+  }
+  if (sim->cpu_count != 0) {
+    sim->cpus = calloc(sim->cpu_count, sizeof(*sim->cpus));
+    if (sim->cpus == NULL) {
+      log_error("Not enough memory to simulate the CPUs");
+      return -1;
+    }
+  }
+  for (i = 0; i < sim->cpu_count; i++) {
+    sim->cpus[i].running = -1;
+  }
+
+  for (i = 0; i < sim->task_count; i++) {
+    struct sim_task *t = &sim->tasks[i];
+    unsigned long long t_release = release_time(sim, t, 0);
+    unsigned long job_count = 1;
+
+    if (t_release < stop_ns) {
+      job_count = (stop_ns - t_release - 1) / t->desc.period_ns + 1;
+      if (event_push(&sim->cpus[t->desc.cpu], t_release, EVENT_RELEASE, i)
+          != 0) {
+        return -1;
+      }
+    }
+    if (t->desc.stats_file_path != NULL) {
+      t->jobs = jobstats_ringbuf_create(job_count, 1);
+      if (t->jobs == NULL) {
+        log_error("Not enough memory to record the jobs of %s", t->desc.name);
+        return -1;
+      }
+    }
+  }
+  /* END: Prepare the CPUs and the first releases */
+
+  /* Simulate */
+  for (;;) {
+    unsigned long long t_min = NEVER;
+    unsigned cpu_id = 0;
+
+    for (i = 0; i < sim->cpu_count; i++) {
+      unsigned long long t = next_time(sim, &sim->cpus[i]);
+      if (t < t_min) {
+        t_min = t;
+        cpu_id = i;
+      }
+    }
+    if (t_min == NEVER) {
+      break;
+    }
+
+    if (step(sim, cpu_id, t_min) != 0) {
+      return -1;
+    }
+  }
+  /* END: Simulate */
+
+  for (i = 0; i < sim->task_count; i++) {
+    if (sim->tasks[i].desc.stats_file_path != NULL
+        && write_stats(sim, &sim->tasks[i]) != 0) {
+      rc = -2;
+    }
+  }
+
+  return rc;
+}
+
+unsigned long simulator_job_count(const simulator *sim, unsigned idx)
+{
+  return sim->tasks[idx].finished;
+}
+
+unsigned long simulator_late_count(const simulator *sim, unsigned idx)
+{
+  return sim->tasks[idx].late_count;
+}
+
+unsigned long long simulator_max_response(const simulator *sim, unsigned idx)
+{
+  return sim->tasks[idx].max_response;
+}
+
+unsigned long simulator_dispatch_count(const simulator *sim)
+{
+  return sim->dispatch_count;
+}
+
+unsigned long simulator_event_count(const simulator *sim)
+{
+  return sim->event_count;
+}
+
+unsigned long long simulator_end(const simulator *sim)
+{
+  return sim->t_end;
+}
@@ -0,0 +1,206 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+/**
+ * @file utility_simulator.h
+ * @brief Discrete-event simulation of periodic tasks on partitioned
+ * CPUs.
+ *
+ * A simulator runs periodic tasks in simulated time instead of on
+ * the real CPUs so that a scheduling question can be answered in a
+ * fraction of the time and without any privilege before the tasks
+ * are run for real. Each task is bound to a CPU and is scheduled
+ * like a thread created by task_start() of task.h: its jobs are run
+ * one after another so that a late job delays the next one. A task
+ * is scheduled by either:
+ * - preemptive fixed priority like SCHED_FIFO, where the tasks of the
+ *   same priority are run in the order they become ready and a
+ *   preempted task stays at the head of its priority.
+ * - preemptive EDF without any budget enforcement.
+ * - preemptive EDF of hard constant bandwidth servers (CBS) like
+ *   SCHED_DEADLINE, where a server whose runtime is exhausted is
+ *   throttled until its next period and a server that wakes up too
+ *   late for its current deadline gets a new deadline.
+ * Like in Linux, the EDF tasks of a CPU always run before the
+ * fixed-priority tasks of the CPU.
+ *
+ * Every dispatch of a task, including the resumption of a preempted
+ * task, costs the CPU a given overhead (e.g., that given by
+ * finish_to_start_overhead() of task.h) before the task can run.
+ *
+ * The result of a simulation is written as task statistics files
+ * like those written by task_create() of task.h so that they can be
+ * read using read_task_stats_file, and optionally as a trace of the
+ * context switches in the format of the ftrace sched_switch plugin so
+ * that it can be converted to a timeline using sched_switch.
+ *
+ * @author Tadeus Prastowo <eus@member.fsf.org>
+ */
+
+#ifndef UTILITY_SIMULATOR
+#define UTILITY_SIMULATOR
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "utility_log.h"
+#include "utility_time.h"
+#include "utility_file.h"
+#include "job.h"
+#include "task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /* I */
+  /**
+   * @name Collection of main data structures.
+   * @{
+   */
+
+  /** The simulator of a set of tasks. */
+  typedef struct simulator simulator;
+
+  /** The scheduling policy of a simulated task. */
+  enum simulator_policy
+  {
+    SIMULATOR_FP, /**< Fixed priority like SCHED_FIFO. */
+    SIMULATOR_EDF, /**< EDF without budget enforcement. */
+    SIMULATOR_CBS, /**< EDF of hard CBS like SCHED_DEADLINE. */
+  };
+
+  /** The description of a simulated task. All times are in ns. */
+  struct simulator_task
+  {
+    const char *name;
+    /** The execution time of every job, which can differ from the
+        WCET to simulate an overrun. */
+    unsigned long long exec_ns;
+    /** The WCET, which is also the runtime of the CBS. */
+    unsigned long long wcet_ns;
+    unsigned long long period_ns;
+    unsigned long long deadline_ns;
+    /** The release time of the first job relative to the start of
+        the simulation. */
+    unsigned long long offset_ns;
+    enum simulator_policy policy;
+    /** The priority level of a SIMULATOR_FP task where 1 is the
+        highest (c.f., sched_fifo_prio() of utility_sched_fifo.h). */
+    unsigned prio_level;
+    unsigned cpu;
+    /** If not NULL, the path of the task statistics file to write. */
+    const char *stats_file_path;
+  };
+  /** @} End of collection of main data structures */
+
+  /* II */
+  /**
+   * @name Collection of simulation functions.
+   * @{
+   */
+
+  /**
+   * Create a simulator.
+   *
+   * @param overhead_ns the time that a CPU spends to dispatch a task.
+   * @param trace if not NULL, the stream to write the sched_switch
+   * trace to.
+   *
+   * @return the simulator or NULL if there is insufficient memory.
+   */
+  simulator *simulator_create(unsigned long long overhead_ns, FILE *trace);
+
+  /**
+   * Destroy the given simulator.
+   */
+  void simulator_destroy(simulator *sim);
+
+  /**
+   * Add a task to simulate. The description is copied.
+   *
+   * @return the index of the task if successful, -1 if the
+   * description is invalid (e.g., a zero period), or -2 if there is
+   * insufficient memory.
+   */
+  int simulator_add(simulator *sim, const struct simulator_task *desc);
+
+  /**
+   * Simulate the added tasks by releasing every job whose release time
+   * is before stop_ns and running until all released jobs complete.
+   * Afterwards, the task statistics files, if any, are written with
+   * start_ns as the t_0 of the tasks. This can only be done once.
+   *
+   * @param start_ns the time at which the offsets of the tasks start.
+   * @param stop_ns the time from which no job is released.
+   *
+   * @return 0 if successful, -1 if there is insufficient memory or
+   * the simulation has been done, or -2 if some task statistics file
+   * cannot be written (the error is @ref utility_log.h "logged").
+   */
+  int simulator_run(simulator *sim, unsigned long long start_ns,
+                    unsigned long long stop_ns);
+  /** @} End of collection of simulation functions */
+
+  /* III */
+  /**
+   * @name Collection of simulation result functions.
+   * @{
+   */
+
+  /**
+   * @return the number of completed jobs of the task of the given
+   * index.
+   */
+  unsigned long simulator_job_count(const simulator *sim, unsigned idx);
+
+  /**
+   * @return the number of jobs of the task of the given index that
+   * complete after their deadlines.
+   */
+  unsigned long simulator_late_count(const simulator *sim, unsigned idx);
+
+  /**
+   * @return the maximum response time in ns of the jobs of the task
+   * of the given index.
+   */
+  unsigned long long simulator_max_response(const simulator *sim,
+                                            unsigned idx);
+
+  /**
+   * @return the number of dispatches of all tasks.
+   */
+  unsigned long simulator_dispatch_count(const simulator *sim);
+
+  /**
+   * @return the number of processed events (job releases and budget
+   * replenishments).
+   */
+  unsigned long simulator_event_count(const simulator *sim);
+
+  /**
+   * @return the simulated time at which the last job completes.
+   */
+  unsigned long long simulator_end(const simulator *sim);
+  /** @} End of collection of simulation result functions */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UTILITY_SIMULATOR */
@@ -0,0 +1,307 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "utility_testcase.h"
+#include "utility_log.h"
+#include "utility_time.h"
+#include "utility_file.h"
+#include "utility_sched_analysis.h"
+#include "utility_simulator.h"
+#include "task.h"
+
+#define MS(x) ((x) * 1000000ULL)
+
+static struct simulator_task make_task(const char *name,
+                                       unsigned long long c_ms,
+                                       unsigned long long t_ms,
+                                       enum simulator_policy policy,
+                                       unsigned prio_level)
+{
+  struct simulator_task t = {
+    .name = name,
+    .exec_ns = MS(c_ms),
+    .wcet_ns = MS(c_ms),
+    .period_ns = MS(t_ms),
+    .deadline_ns = MS(t_ms),
+    .offset_ns = 0,
+    .policy = policy,
+    .prio_level = prio_level,
+    .cpu = 0,
+    .stats_file_path = NULL,
+  };
+  return t;
+}
+
+struct stats_check
+{
+  relative_time period;
+  relative_time offset;
+  absolute_time t_0;
+  unsigned long nth_job;
+  unsigned long job_count;
+  unsigned long long max_response;
+};
+
+static int check_task(task *tau, void *args)
+{
+  struct stats_check *prms = args;
+
+  utility_time_to_utility_time_gc(task_statistics_period(tau),
+                                  &prms->period);
+  utility_time_to_utility_time_gc(task_statistics_offset(tau),
+                                  &prms->offset);
+  utility_time_to_utility_time_gc(task_statistics_t0(tau), &prms->t_0);
+  prms->nth_job = task_statistics_oldest_job_pos(tau);
+
+  return 0;
+}
+
+static int check_job(job_statistics *stats, void *args)
+{
+  struct stats_check *prms = args;
+  struct timespec t_release, t_finish;
+  unsigned long long response;
+
+  to_timespec_gc(utility_time_add_dyn_gc
+                 (utility_time_add_dyn(&prms->t_0, &prms->offset),
+                  utility_time_mul_dyn(&prms->period, prms->nth_job - 1)),
+                 &t_release);
+  to_timespec_gc(job_statistics_time_finish(stats), &t_finish);
+  response = ((t_finish.tv_sec - t_release.tv_sec) * 1000000000ULL
+              + t_finish.tv_nsec - t_release.tv_nsec);
+  if (response > prms->max_response) {
+    prms->max_response = response;
+  }
+  prms->nth_job++;
+  prms->job_count++;
+
+  return 0;
+}
+
+MAIN_UNIT_TEST_BEGIN("utility_simulator_test", "stderr", NULL, NULL)
+{
+  struct simulator_task desc;
+  simulator *sim;
+  unsigned i;
+
+  /* Testcase 1: fixed priority meets response-time analysis */
+  {
+    sched_analysis_taskset *set = sched_analysis_taskset_create();
+    unsigned long long c[] = {1, 2, 3}, t[] = {4, 6, 13};
+    char path[] = "/tmp/utility_simulator_test.XXXXXX";
+    FILE *trace = tmpfile();
+    char line[256];
+    unsigned long wakeup_count = 0, switch_count = 0;
+    int fd;
+
+    gracious_assert(set != NULL && trace != NULL);
+    fd = mkstemp(path);
+    gracious_assert(fd != -1);
+    close(fd);
+
+    sim = simulator_create(0, trace);
+    gracious_assert(sim != NULL);
+    for (i = 0; i < 3; i++) {
+      desc = make_task("tau", c[i], t[i], SIMULATOR_FP, i + 1);
+      if (i == 2) {
+        desc.stats_file_path = path;
+      }
+      gracious_assert(simulator_add(sim, &desc) == i);
+      gracious_assert(sched_analysis_taskset_add(set,
+                                                 to_utility_time_dyn(c[i], ms),
+                                                 to_utility_time_dyn(t[i], ms),
+                                                 to_utility_time_dyn(t[i], ms))
+                      == 0);
+    }
+    gracious_assert(sched_analysis_fp(set, SCHED_ANALYSIS_RM) == 1);
+
+    /* One hyperperiod from 1 s */
+    gracious_assert(simulator_run(sim, MS(1000), MS(1000 + 156)) == 0);
+    gracious_assert(simulator_run(sim, MS(1000), MS(1000 + 156)) == -1);
+    for (i = 0; i < 3; i++) {
+      struct timespec rt;
+      to_timespec_gc(sched_analysis_response_time(set, i), &rt);
+      gracious_assert(simulator_max_response(sim, i)
+                      == rt.tv_sec * 1000000000ULL + rt.tv_nsec);
+      gracious_assert(simulator_job_count(sim, i) == 156 / t[i]);
+      gracious_assert(simulator_late_count(sim, i) == 0);
+      wakeup_count += simulator_job_count(sim, i);
+    }
+    gracious_assert(simulator_event_count(sim) == wakeup_count);
+    gracious_assert(simulator_end(sim) <= MS(1000 + 156));
+
+    /* The task statistics file reads like that of a real task */
+    {
+      FILE *stats_file = utility_file_open_for_reading_bin(path);
+      struct stats_check prms = {
+        .job_count = 0,
+        .max_response = 0,
+      };
+      utility_time_init(&prms.period);
+      utility_time_init(&prms.offset);
+      utility_time_init(&prms.t_0);
+
+      gracious_assert(stats_file != NULL);
+      gracious_assert(task_statistics_read(stats_file, check_task, &prms,
+                                           check_job, &prms) == 0);
+      gracious_assert(utility_file_close(stats_file, path) == 0);
+      gracious_assert(prms.job_count == simulator_job_count(sim, 2));
+      gracious_assert(prms.max_response == simulator_max_response(sim, 2));
+      gracious_assert(utility_time_eq_gc_t2(&prms.t_0,
+                                            to_utility_time_dyn(1, s)));
+    }
+    unlink(path);
+
+    /* The trace reads like that of the sched_switch plugin */
+    rewind(trace);
+    while (fgets(line, sizeof(line), trace) != NULL) {
+      char program_name[64], from_state[8], op[8], to_state[8];
+      unsigned from_cpu, to_cpu, from_pid, from_prio, to_pid, to_prio;
+      double t;
+
+      int field_count = sscanf(line,
+                               " %s [ %u ] %lf : %u : %u : %s %s [ %u ]"
+                               " %u : %u : %s ",
+                               program_name, &from_cpu, &t, &from_pid,
+                               &from_prio, from_state, op, &to_cpu, &to_pid,
+                               &to_prio, to_state);
+      gracious_assert(field_count == 11);
+      gracious_assert(t >= 1 && t <= 1.156);
+      if (strcmp(op, "+") == 0) {
+        wakeup_count--;
+      } else {
+        gracious_assert(strcmp(op, "==>") == 0);
+        switch_count++;
+      }
+    }
+    gracious_assert(wakeup_count == 0);
+    gracious_assert(switch_count >= simulator_dispatch_count(sim));
+    fclose(trace);
+
+    simulator_destroy(sim);
+    sched_analysis_taskset_destroy(set);
+  }
+
+  /* Testcase 2: EDF schedules what RM cannot */
+  {
+    sim = simulator_create(0, NULL);
+    gracious_assert(sim != NULL);
+    desc = make_task("tau_1", 2, 4, SIMULATOR_FP, 1);
+    gracious_assert(simulator_add(sim, &desc) == 0);
+    desc = make_task("tau_2", 3, 6, SIMULATOR_FP, 2);
+    gracious_assert(simulator_add(sim, &desc) == 1);
+    gracious_assert(simulator_run(sim, 0, MS(120)) == 0);
+    gracious_assert(simulator_late_count(sim, 0) == 0);
+    gracious_assert(simulator_late_count(sim, 1) != 0);
+    simulator_destroy(sim);
+
+    sim = simulator_create(0, NULL);
+    gracious_assert(sim != NULL);
+    desc = make_task("tau_1", 2, 4, SIMULATOR_EDF, 0);
+    gracious_assert(simulator_add(sim, &desc) == 0);
+    desc = make_task("tau_2", 3, 6, SIMULATOR_EDF, 0);
+    gracious_assert(simulator_add(sim, &desc) == 1);
+    gracious_assert(simulator_run(sim, 0, MS(120)) == 0);
+    gracious_assert(simulator_late_count(sim, 0) == 0);
+    gracious_assert(simulator_late_count(sim, 1) == 0);
+    gracious_assert(simulator_end(sim) == MS(120));
+    simulator_destroy(sim);
+  }
+
+  /* Testcase 3: CBS isolates an overrunning task */
+  {
+    enum simulator_policy policies[] = {SIMULATOR_EDF, SIMULATOR_CBS};
+
+    for (i = 0; i < 2; i++) {
+      sim = simulator_create(0, NULL);
+      gracious_assert(sim != NULL);
+      desc = make_task("overrun", 2, 10, policies[i], 0);
+      desc.exec_ns = MS(7);
+      gracious_assert(simulator_add(sim, &desc) == 0);
+      desc = make_task("victim", 5, 10, policies[i], 0);
+      gracious_assert(simulator_add(sim, &desc) == 1);
+      gracious_assert(simulator_run(sim, 0, MS(100)) == 0);
+
+      gracious_assert(simulator_job_count(sim, 0) == 10);
+      gracious_assert(simulator_late_count(sim, 0) != 0);
+      if (policies[i] == SIMULATOR_CBS) {
+        gracious_assert(simulator_late_count(sim, 1) == 0);
+        /* 70 ms of work at 2 ms every 10 ms */
+        gracious_assert(simulator_end(sim) > MS(340));
+      } else {
+        gracious_assert(simulator_late_count(sim, 1) != 0);
+        gracious_assert(simulator_end(sim) == MS(120));
+      }
+      simulator_destroy(sim);
+    }
+  }
+
+  /* Testcase 4: dispatch overhead */
+  {
+    sim = simulator_create(100000, NULL);
+    gracious_assert(sim != NULL);
+    desc = make_task("tau", 1, 10, SIMULATOR_FP, 1);
+    gracious_assert(simulator_add(sim, &desc) == 0);
+    gracious_assert(simulator_run(sim, 0, MS(100)) == 0);
+    gracious_assert(simulator_job_count(sim, 0) == 10);
+    gracious_assert(simulator_dispatch_count(sim) == 10);
+    gracious_assert(simulator_max_response(sim, 0) == 1100000);
+    simulator_destroy(sim);
+  }
+
+  /* Testcase 5: SCHED_FIFO within the same priority */
+  {
+    unsigned level;
+
+    for (level = 1; level <= 2; level++) {
+      sim = simulator_create(0, NULL);
+      gracious_assert(sim != NULL);
+      desc = make_task("long", 3, 10, SIMULATOR_FP, 2);
+      gracious_assert(simulator_add(sim, &desc) == 0);
+      desc = make_task("short", 1, 10, SIMULATOR_FP, level);
+      desc.offset_ns = MS(1);
+      gracious_assert(simulator_add(sim, &desc) == 1);
+      gracious_assert(simulator_run(sim, 0, MS(10)) == 0);
+      gracious_assert(simulator_max_response(sim, 1)
+                      == (level == 1 ? MS(1) : MS(3)));
+      gracious_assert(simulator_max_response(sim, 0)
+                      == (level == 1 ? MS(4) : MS(3)));
+      simulator_destroy(sim);
+    }
+  }
+
+  /* Testcase 6: invalid tasks */
+  {
+    sim = simulator_create(0, NULL);
+    gracious_assert(sim != NULL);
+    desc = make_task("tau", 1, 10, SIMULATOR_FP, 0);
+    gracious_assert(simulator_add(sim, &desc) == -1);
+    desc = make_task("tau", 0, 10, SIMULATOR_EDF, 0);
+    gracious_assert(simulator_add(sim, &desc) == -1);
+    desc = make_task("tau", 1, 0, SIMULATOR_EDF, 0);
+    gracious_assert(simulator_add(sim, &desc) == -1);
+    desc = make_task("", 1, 10, SIMULATOR_EDF, 0);
+    gracious_assert(simulator_add(sim, &desc) == -1);
+    gracious_assert(simulator_run(sim, 0, MS(10)) == 0);
+    simulator_destroy(sim);
+  }
+
+} MAIN_UNIT_TEST_END
@@ -0,0 +1,489 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#define _GNU_SOURCE /* pipe2() */
+#include "utility_supervisor.h"
+
+#define EVENT_COUNT_MAX 16
+
+enum watch_kind {
+  WATCH_SIGNAL, WATCH_READY, WATCH_EXIT,
+};
+
+struct proc;
+
+/* What an epoll event is about */
+struct watch
+{
+  enum watch_kind kind;
+  struct proc *proc; /* NULL for WATCH_SIGNAL */
+};
+
+struct proc
+{
+  struct proc *next;
+  pid_t proc_id;
+  int pidfd; /* -1 once the process is reaped */
+  int ready_fd; /* -1 once the notification or EOF is read */
+  int ready;
+  int status;
+  struct watch ready_watch;
+  struct watch exit_watch;
+};
+
+struct supervisor
+{
+  int epoll_fd;
+  int signal_fd;
+  sigset_t old_mask;
+  int interrupted;
+  struct watch signal_watch;
+  struct proc *procs;
+};
+
+static int watch_fd(supervisor *sv, int fd, struct watch *watch)
+{
+  struct epoll_event event = {
+    .events = EPOLLIN,
+    .data.ptr = watch,
+  };
+
+  if (epoll_ctl(sv->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+    log_syserror("Cannot watch fd %d", fd);
+    return -1;
+  }
+  return 0;
+}
+
+static void unwatch_fd(supervisor *sv, int *fd)
+{
+  epoll_ctl(sv->epoll_fd, EPOLL_CTL_DEL, *fd, NULL);
+  close(*fd);
+  *fd = -1;
+}
+
+static struct proc *find_proc(supervisor *sv, pid_t proc_id)
+{
+  struct proc *itr;
+
+  for (itr = sv->procs; itr != NULL; itr = itr->next) {
+    if (itr->proc_id == proc_id) {
+      return itr;
+    }
+  }
+
+  log_error("Process %d is not supervised", proc_id);
+  return NULL;
+}
+
+static void deadline_init(struct timespec *deadline, unsigned long timeout_ms)
+{
+  clock_gettime(CLOCK_MONOTONIC, deadline);
+  deadline->tv_sec += timeout_ms / 1000;
+  deadline->tv_nsec += (timeout_ms % 1000) * 1000000;
+  if (deadline->tv_nsec >= 1000000000) {
+    deadline->tv_sec++;
+    deadline->tv_nsec -= 1000000000;
+  }
+}
+
+/* Return the number of milliseconds to the deadline rounded up or 0
+   if the deadline has passed */
+static int deadline_remaining_ms(const struct timespec *deadline)
+{
+  struct timespec t_now;
+  long long remaining_ns;
+
+  clock_gettime(CLOCK_MONOTONIC, &t_now);
+  remaining_ns = ((deadline->tv_sec - t_now.tv_sec) * 1000000000LL
+                  + (deadline->tv_nsec - t_now.tv_nsec));
+  if (remaining_ns <= 0) {
+    return 0;
+  }
+  return (remaining_ns + 999999) / 1000000;
+}
+
+/* Wait for at most timeout_ms for events and process them. Return 0
+   if successful or -2 in case of hard error. */
+static int supervisor_poll(supervisor *sv, int timeout_ms)
+{
+  struct epoll_event events[EVENT_COUNT_MAX];
+  int event_count, i;
+
+  event_count = epoll_wait(sv->epoll_fd, events, EVENT_COUNT_MAX, timeout_ms);
+  if (event_count == -1) {
+    if (errno == EINTR) {
+      return 0;
+    }
+    log_syserror("Cannot wait for events");
+    return -2;
+  }
+
+  for (i = 0; i < event_count; i++) {
+    struct watch *watch = events[i].data.ptr;
+    struct proc *proc = watch->proc;
+
+    switch (watch->kind) {
+    case WATCH_SIGNAL:
+      {
+        struct signalfd_siginfo info;
+        if (read(sv->signal_fd, &info, sizeof(info)) == sizeof(info)) {
+          sv->interrupted = info.ssi_signo;
+        }
+      }
+      break;
+    case WATCH_READY:
+      {
+        char notification;
+        if (read(proc->ready_fd, &notification, 1) == 1) {
+          proc->ready = 1;
+        }
+        /* Either notified or the process closed the pipe without
+           notifying; nothing more will come either way */
+        unwatch_fd(sv, &proc->ready_fd);
+      }
+      break;
+    case WATCH_EXIT:
+      if (waitpid(proc->proc_id, &proc->status, WNOHANG) == proc->proc_id) {
+        unwatch_fd(sv, &proc->pidfd);
+      }
+      break;
+    }
+  }
+
+  return 0;
+}
+
+int supervisor_create(supervisor **res)
+{
+  supervisor *sv = malloc(sizeof(*sv));
+  sigset_t mask;
+
+  if (sv == NULL) {
+    log_error("No memory to create supervisor");
+    return -2;
+  }
+  memset(sv, 0, sizeof(*sv));
+  sv->signal_watch.kind = WATCH_SIGNAL;
+
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGINT);
+  sigaddset(&mask, SIGTERM);
+  if (sigprocmask(SIG_BLOCK, &mask, &sv->old_mask) != 0) {
+    log_syserror("Cannot block SIGINT and SIGTERM");
+    free(sv);
+    return -2;
+  }
+
+  sv->signal_fd = signalfd(-1, &mask, SFD_CLOEXEC);
+  if (sv->signal_fd == -1) {
+    log_syserror("Cannot create signalfd");
+    goto error_restore_mask;
+  }
+
+  sv->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (sv->epoll_fd == -1) {
+    log_syserror("Cannot create epoll instance");
+    goto error_close_signal_fd;
+  }
+
+  if (watch_fd(sv, sv->signal_fd, &sv->signal_watch) != 0) {
+    goto error_close_epoll_fd;
+  }
+
+  *res = sv;
+  return 0;
+
+ error_close_epoll_fd:
+  close(sv->epoll_fd);
+ error_close_signal_fd:
+  close(sv->signal_fd);
+ error_restore_mask:
+  sigprocmask(SIG_SETMASK, &sv->old_mask, NULL);
+  free(sv);
+  return -2;
+}
+
+void supervisor_destroy(supervisor *sv)
+{
+  struct proc *itr = sv->procs, *next;
+
+  while (itr != NULL) {
+    next = itr->next;
+
+    if (itr->pidfd != -1) {
+      kill(itr->proc_id, SIGKILL);
+      waitpid(itr->proc_id, NULL, 0);
+      close(itr->pidfd);
+    }
+    if (itr->ready_fd != -1) {
+      close(itr->ready_fd);
+    }
+    free(itr);
+
+    itr = next;
+  }
+
+  close(sv->epoll_fd);
+  close(sv->signal_fd);
+  sigprocmask(SIG_SETMASK, &sv->old_mask, NULL);
+  free(sv);
+}
+
+pid_t supervisor_spawn(supervisor *sv, char *const argv[])
+{
+  struct proc *proc;
+  int ready_pipe[2];
+
+  proc = malloc(sizeof(*proc));
+  if (proc == NULL) {
+    log_error("No memory to supervise %s", argv[0]);
+    return -1;
+  }
+  memset(proc, 0, sizeof(*proc));
+  proc->pidfd = -1;
+  proc->ready_fd = -1;
+  proc->ready_watch.kind = WATCH_READY;
+  proc->ready_watch.proc = proc;
+  proc->exit_watch.kind = WATCH_EXIT;
+  proc->exit_watch.proc = proc;
+
+  if (pipe2(ready_pipe, O_CLOEXEC) != 0) {
+    log_syserror("Cannot create the readiness pipe of %s", argv[0]);
+    free(proc);
+    return -1;
+  }
+
+  proc->proc_id = fork();
+  if (proc->proc_id == -1) {
+    log_syserror("Cannot fork %s", argv[0]);
+    close(ready_pipe[0]);
+    close(ready_pipe[1]);
+    free(proc);
+    return -1;
+  } else if (proc->proc_id == 0) {
+    /* Unlike the pipe, the duplicate survives the exec */
+    int ready_fd = dup(ready_pipe[1]);
+    char ready_fd_str[16];
+
+    if (ready_fd == -1) {
+      log_syserror("Cannot duplicate the readiness pipe");
+      _exit(EXIT_FAILURE);
+    }
+    snprintf(ready_fd_str, sizeof(ready_fd_str), "%d", ready_fd);
+    if (setenv(SUPERVISOR_READY_FD_ENV, ready_fd_str, 1) != 0) {
+      log_syserror("Cannot set %s", SUPERVISOR_READY_FD_ENV);
+      _exit(EXIT_FAILURE);
+    }
+    sigprocmask(SIG_SETMASK, &sv->old_mask, NULL);
+
+    execv(argv[0], argv);
+    log_syserror("Cannot exec %s", argv[0]);
+    _exit(EXIT_FAILURE);
+  }
+
+  close(ready_pipe[1]);
+  proc->ready_fd = ready_pipe[0];
+  proc->next = sv->procs;
+  sv->procs = proc;
+
+  proc->pidfd = syscall(SYS_pidfd_open, proc->proc_id, 0);
+  if (proc->pidfd == -1) {
+    log_syserror("Cannot open the pidfd of %s", argv[0]);
+    kill(proc->proc_id, SIGKILL);
+    waitpid(proc->proc_id, &proc->status, 0);
+    return -1;
+  }
+  if (watch_fd(sv, proc->pidfd, &proc->exit_watch) != 0
+      || watch_fd(sv, proc->ready_fd, &proc->ready_watch) != 0) {
+    return -1;
+  }
+
+  return proc->proc_id;
+}
+
+int supervisor_kill(supervisor *sv, pid_t proc_id, int signo)
+{
+  struct proc *proc = find_proc(sv, proc_id);
+
+  if (proc == NULL) {
+    return -1;
+  }
+  if (proc->pidfd == -1) {
+    return 0;
+  }
+
+  if (syscall(SYS_pidfd_send_signal, proc->pidfd, signo, NULL, 0) != 0
+      && errno != ESRCH) {
+    log_syserror("Cannot send signal %d to process %d", signo, proc_id);
+    return -1;
+  }
+  return 0;
+}
+
+int supervisor_wait_ready(supervisor *sv, pid_t proc_id,
+                          unsigned long timeout_ms)
+{
+  struct proc *proc = find_proc(sv, proc_id);
+  struct timespec deadline;
+
+  if (proc == NULL) {
+    return -2;
+  }
+
+  deadline_init(&deadline, timeout_ms);
+  while (1) {
+    if (proc->ready) {
+      return 0;
+    }
+    if (proc->pidfd == -1) {
+      log_error("Process %d terminates before being ready", proc_id);
+      return -1;
+    }
+    if (proc->ready_fd == -1) {
+      log_error("Process %d closes its readiness pipe without notifying",
+                proc_id);
+      return -1;
+    }
+    if (sv->interrupted) {
+      return -1;
+    }
+
+    int remaining_ms = deadline_remaining_ms(&deadline);
+    if (remaining_ms == 0) {
+      log_error("Process %d is not ready after %lu ms", proc_id, timeout_ms);
+      return -1;
+    }
+    if (supervisor_poll(sv, remaining_ms) != 0) {
+      return -2;
+    }
+  }
+}
+
+int supervisor_sleep(supervisor *sv, unsigned long duration_ms)
+{
+  struct timespec deadline;
+  struct proc *itr;
+
+  deadline_init(&deadline, duration_ms);
+  while (1) {
+    if (sv->interrupted) {
+      return -1;
+    }
+    for (itr = sv->procs; itr != NULL; itr = itr->next) {
+      if (itr->pidfd == -1) {
+        log_error("Process %d terminates prematurely", itr->proc_id);
+        return -1;
+      }
+    }
+
+    int remaining_ms = deadline_remaining_ms(&deadline);
+    if (remaining_ms == 0) {
+      return 0;
+    }
+    if (supervisor_poll(sv, remaining_ms) != 0) {
+      return -2;
+    }
+  }
+}
+
+int supervisor_wait_exit(supervisor *sv, const pid_t *proc_ids,
+                         int proc_count, unsigned long timeout_ms)
+{
+  struct timespec deadline;
+  int i, rc = 0;
+
+  for (i = 0; i < proc_count; i++) {
+    if (find_proc(sv, proc_ids[i]) == NULL) {
+      return -2;
+    }
+  }
+
+  /* Wait for all of them */
+  deadline_init(&deadline, timeout_ms);
+  while (1) {
+    int running_count = 0;
+    for (i = 0; i < proc_count; i++) {
+      if (find_proc(sv, proc_ids[i])->pidfd != -1) {
+        running_count++;
+      }
+    }
+    if (running_count == 0) {
+      break;
+    }
+
+    int remaining_ms = deadline_remaining_ms(&deadline);
+    if (remaining_ms == 0) {
+      break;
+    }
+    if (supervisor_poll(sv, remaining_ms) != 0) {
+      return -2;
+    }
+  }
+  /* END: Wait for all of them */
+
+  for (i = 0; i < proc_count; i++) {
+    struct proc *proc = find_proc(sv, proc_ids[i]);
+
+    if (proc->pidfd != -1) {
+      log_error("Process %d does not terminate within %lu ms",
+                proc->proc_id, timeout_ms);
+      kill(proc->proc_id, SIGKILL);
+      waitpid(proc->proc_id, &proc->status, 0);
+      unwatch_fd(sv, &proc->pidfd);
+      rc = -1;
+    } else if (!WIFEXITED(proc->status)) {
+      log_error("Process %d does not terminate normally", proc->proc_id);
+      if (WIFSIGNALED(proc->status)) {
+        log_error("Process %d got signal %d", proc->proc_id,
+                  WTERMSIG(proc->status));
+      }
+      rc = -1;
+    } else if (WEXITSTATUS(proc->status) != EXIT_SUCCESS) {
+      log_error("Process %d terminates due to an error", proc->proc_id);
+      rc = -1;
+    }
+  }
+
+  return rc;
+}
+
+int supervisor_interrupted(const supervisor *sv)
+{
+  return sv->interrupted;
+}
+
+int supervisor_notify_ready(void)
+{
+  const char *ready_fd_str = getenv(SUPERVISOR_READY_FD_ENV);
+  int ready_fd;
+
+  if (ready_fd_str == NULL) {
+    return 0;
+  }
+  ready_fd = atoi(ready_fd_str);
+  unsetenv(SUPERVISOR_READY_FD_ENV);
+
+  if (write(ready_fd, "R", 1) != 1) {
+    log_syserror("Cannot notify the supervisor");
+    close(ready_fd);
+    return -1;
+  }
+  close(ready_fd);
+
+  return 0;
+}
@@ -0,0 +1,188 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+/**
+ * @file utility_supervisor.h
+ * @brief An event-driven supervisor of the processes of an experiment.
+ *
+ * A supervisor starts processes, waits until each of them is ready,
+ * lets the experiment run for a given duration and tears the
+ * processes down, all without polling or fixed sleeps. Every process
+ * is watched through a pidfd and every readiness notification arrives
+ * through a pipe so that a single epoll instance wakes the supervisor
+ * up as soon as something happens. SIGINT and SIGTERM are received
+ * through a signalfd on the same epoll instance so that the
+ * experiment can be stopped at any time without an asynchronous
+ * signal handler.
+ *
+ * A supervised process tells the supervisor that it is ready (e.g.,
+ * its busy loops are calibrated) by calling supervisor_notify_ready().
+ * The function writes to the pipe whose file descriptor is given in
+ * the environment variable named by SUPERVISOR_READY_FD_ENV and does
+ * nothing when the process is not supervised.
+ *
+ * @author Tadeus Prastowo <eus@member.fsf.org>
+ */
+
+#ifndef UTILITY_SUPERVISOR
+#define UTILITY_SUPERVISOR
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "utility_log.h"
+
+/**
+ * The name of the environment variable holding the file descriptor
+ * to which a supervised process writes to notify its readiness.
+ */
+#define SUPERVISOR_READY_FD_ENV "SUPERVISOR_READY_FD"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /**
+   * A supervisor.
+   * This is an opaque type; do not manipulate any of its instances directly.
+   */
+  typedef struct supervisor supervisor;
+
+  /**
+   * Create a supervisor. SIGINT and SIGTERM are blocked in the caller
+   * until the supervisor is destroyed so that they can only be
+   * received by the supervisor. The signal mask should therefore be
+   * set before creating any thread.
+   *
+   * @param res a pointer to the object to store the created supervisor.
+   *
+   * @return 0 if the supervisor is created or -2 in case of hard
+   * error that requires the investigation of the output of the
+   * logging facility to fix the error.
+   */
+  int supervisor_create(supervisor **res);
+
+  /**
+   * Kill with SIGKILL and reap every supervised process that is still
+   * running, restore the signal mask of the caller and destroy the
+   * supervisor.
+   */
+  void supervisor_destroy(supervisor *sv);
+
+  /**
+   * Fork and execute a process to be supervised. The process starts
+   * with the signal mask that the caller had before creating the
+   * supervisor.
+   *
+   * @param argv the NULL-terminated arguments of the process whose
+   * first element is the path to the executable.
+   *
+   * @return the ID of the process or -1 in case of hard error that
+   * requires the investigation of the output of the logging facility
+   * to fix the error.
+   */
+  pid_t supervisor_spawn(supervisor *sv, char *const argv[]);
+
+  /**
+   * Send a signal to a supervised process through its pidfd so that
+   * the signal never reaches another process reusing the ID of a
+   * terminated one.
+   *
+   * @param proc_id the ID returned by supervisor_spawn().
+   * @param signo the signal to send.
+   *
+   * @return 0 if the signal is sent or the process has terminated, or
+   * -1 in case of hard error that requires the investigation of the
+   * output of the logging facility to fix the error.
+   */
+  int supervisor_kill(supervisor *sv, pid_t proc_id, int signo);
+
+  /**
+   * Wait until a supervised process notifies its readiness.
+   *
+   * @param proc_id the ID returned by supervisor_spawn().
+   * @param timeout_ms the maximum waiting time in millisecond.
+   *
+   * @return 0 if the process is ready, -1 if the process terminates
+   * or does not notify within the timeout or the supervisor receives
+   * SIGINT or SIGTERM, or -2 in case of hard error that requires the
+   * investigation of the output of the logging facility to fix the
+   * error.
+   */
+  int supervisor_wait_ready(supervisor *sv, pid_t proc_id,
+                            unsigned long timeout_ms);
+
+  /**
+   * Let the supervised processes run for the given duration.
+   *
+   * @param duration_ms the duration in millisecond.
+   *
+   * @return 0 if the duration has elapsed, -1 if the supervisor
+   * receives SIGINT or SIGTERM or a supervised process terminates
+   * before the duration has elapsed, or -2 in case of hard error that
+   * requires the investigation of the output of the logging facility
+   * to fix the error.
+   */
+  int supervisor_sleep(supervisor *sv, unsigned long duration_ms);
+
+  /**
+   * Wait until the given supervised processes terminate. A process
+   * still running after the timeout is killed with SIGKILL.
+   *
+   * @param proc_ids the IDs returned by supervisor_spawn().
+   * @param proc_count the number of IDs in proc_ids.
+   * @param timeout_ms the maximum waiting time in millisecond.
+   *
+   * @return 0 if all of the processes exit with EXIT_SUCCESS within
+   * the timeout, -1 if one of them does not (the details are logged),
+   * or -2 in case of hard error that requires the investigation of
+   * the output of the logging facility to fix the error.
+   */
+  int supervisor_wait_exit(supervisor *sv, const pid_t *proc_ids,
+                           int proc_count, unsigned long timeout_ms);
+
+  /**
+   * @return the signal number of SIGINT or SIGTERM if the supervisor
+   * has received one of them, or 0 otherwise.
+   */
+  int supervisor_interrupted(const supervisor *sv);
+
+  /**
+   * Notify the supervisor of the calling process that the caller is
+   * ready. This must be called at most once.
+   *
+   * @return 0 if the supervisor is notified or the caller is not
+   * supervised, or -1 in case of hard error that requires the
+   * investigation of the output of the logging facility to fix the
+   * error.
+   */
+  int supervisor_notify_ready(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UTILITY_SUPERVISOR */
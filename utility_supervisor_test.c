@@ -0,0 +1,209 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <time.h>
+#include "utility_testcase.h"
+#include "utility_log.h"
+#include "utility_supervisor.h"
+
+/* The test re-executes itself in one of these modes to play the
+   supervised process */
+static const char *const modes[] = {
+  "ready_until_sigterm", "exit_unready", "ready_then_exit",
+  "ready_ignoring_sigterm", "unready_forever", NULL
+};
+enum mode_idx {
+  READY_UNTIL_SIGTERM, EXIT_UNREADY, READY_THEN_EXIT,
+  READY_IGNORING_SIGTERM, UNREADY_FOREVER,
+};
+
+static int run_mode(int mode)
+{
+  sigset_t sigterm_mask;
+  int signo;
+
+  switch (mode) {
+  case READY_UNTIL_SIGTERM:
+    sigemptyset(&sigterm_mask);
+    sigaddset(&sigterm_mask, SIGTERM);
+    sigprocmask(SIG_BLOCK, &sigterm_mask, NULL);
+    if (supervisor_notify_ready() != 0) {
+      return EXIT_FAILURE;
+    }
+    sigwait(&sigterm_mask, &signo);
+    return EXIT_SUCCESS;
+  case EXIT_UNREADY:
+    return EXIT_SUCCESS;
+  case READY_THEN_EXIT:
+    if (supervisor_notify_ready() != 0) {
+      return EXIT_FAILURE;
+    }
+    usleep(50000);
+    return EXIT_SUCCESS;
+  case READY_IGNORING_SIGTERM:
+    signal(SIGTERM, SIG_IGN);
+    if (supervisor_notify_ready() != 0) {
+      return EXIT_FAILURE;
+    }
+    sleep(10);
+    return EXIT_SUCCESS;
+  case UNREADY_FOREVER:
+    sleep(10);
+    return EXIT_SUCCESS;
+  }
+
+  return EXIT_FAILURE;
+}
+
+static pid_t spawn_mode(supervisor *sv, int mode)
+{
+  char *argv[] = {"/proc/self/exe", (char *) modes[mode], NULL};
+  return supervisor_spawn(sv, argv);
+}
+
+static double elapsed_ms(const struct timespec *t_start)
+{
+  struct timespec t_now;
+  clock_gettime(CLOCK_MONOTONIC, &t_now);
+  return ((t_now.tv_sec - t_start->tv_sec) * 1e3
+          + (t_now.tv_nsec - t_start->tv_nsec) / 1e6);
+}
+
+MAIN_UNIT_TEST_BEGIN("utility_supervisor_test", "stderr", NULL, NULL)
+{
+  supervisor *sv;
+  pid_t proc_ids[2];
+  struct timespec t_start;
+  int i;
+
+  if (argc == 2) {
+    for (i = 0; modes[i] != NULL; i++) {
+      if (strcmp(argv[1], modes[i]) == 0) {
+        return run_mode(i);
+      }
+    }
+  }
+
+  /* Testcase 1: an unsupervised process is not notifying anything */
+  gracious_assert(getenv(SUPERVISOR_READY_FD_ENV) == NULL);
+  gracious_assert(supervisor_notify_ready() == 0);
+
+  /* Testcase 2: notification through the given file descriptor */
+  {
+    int fds[2];
+    char fd_str[16], notification;
+    gracious_assert(pipe(fds) == 0);
+    snprintf(fd_str, sizeof(fd_str), "%d", fds[1]);
+    gracious_assert(setenv(SUPERVISOR_READY_FD_ENV, fd_str, 1) == 0);
+    gracious_assert(supervisor_notify_ready() == 0);
+    gracious_assert(getenv(SUPERVISOR_READY_FD_ENV) == NULL);
+    gracious_assert(read(fds[0], &notification, 1) == 1);
+    gracious_assert(read(fds[0], &notification, 1) == 0); /* Closed */
+    close(fds[0]);
+  }
+
+  /* Testcase 3: start, run and stop processes */
+  gracious_assert(supervisor_create(&sv) == 0);
+  proc_ids[0] = spawn_mode(sv, READY_UNTIL_SIGTERM);
+  gracious_assert(proc_ids[0] != -1);
+  proc_ids[1] = spawn_mode(sv, READY_UNTIL_SIGTERM);
+  gracious_assert(proc_ids[1] != -1);
+  gracious_assert(supervisor_wait_ready(sv, proc_ids[0], 5000) == 0);
+  gracious_assert(supervisor_wait_ready(sv, proc_ids[1], 5000) == 0);
+  clock_gettime(CLOCK_MONOTONIC, &t_start);
+  gracious_assert(supervisor_sleep(sv, 100) == 0);
+  gracious_assert(elapsed_ms(&t_start) >= 100);
+  gracious_assert(kill(proc_ids[0], SIGTERM) == 0);
+  gracious_assert(supervisor_kill(sv, proc_ids[1], SIGTERM) == 0);
+  gracious_assert(supervisor_wait_exit(sv, proc_ids, 2, 5000) == 0);
+  gracious_assert(supervisor_interrupted(sv) == 0);
+  supervisor_destroy(sv);
+
+  /* Testcase 4: a process terminating before being ready */
+  gracious_assert(supervisor_create(&sv) == 0);
+  proc_ids[0] = spawn_mode(sv, EXIT_UNREADY);
+  gracious_assert(proc_ids[0] != -1);
+  clock_gettime(CLOCK_MONOTONIC, &t_start);
+  gracious_assert(supervisor_wait_ready(sv, proc_ids[0], 5000) == -1);
+  gracious_assert(elapsed_ms(&t_start) < 2500);
+  gracious_assert(supervisor_wait_exit(sv, proc_ids, 1, 5000) == 0);
+  supervisor_destroy(sv);
+
+  /* Testcase 5: a process never being ready */
+  gracious_assert(supervisor_create(&sv) == 0);
+  proc_ids[0] = spawn_mode(sv, UNREADY_FOREVER);
+  gracious_assert(proc_ids[0] != -1);
+  clock_gettime(CLOCK_MONOTONIC, &t_start);
+  gracious_assert(supervisor_wait_ready(sv, proc_ids[0], 200) == -1);
+  gracious_assert(elapsed_ms(&t_start) >= 200);
+  gracious_assert(elapsed_ms(&t_start) < 2500);
+  supervisor_destroy(sv); /* Must kill the process */
+  gracious_assert(kill(proc_ids[0], 0) == -1 && errno == ESRCH);
+
+  /* Testcase 6: a process terminating prematurely ends the sleep */
+  gracious_assert(supervisor_create(&sv) == 0);
+  proc_ids[0] = spawn_mode(sv, READY_THEN_EXIT);
+  gracious_assert(proc_ids[0] != -1);
+  gracious_assert(supervisor_wait_ready(sv, proc_ids[0], 5000) == 0);
+  clock_gettime(CLOCK_MONOTONIC, &t_start);
+  gracious_assert(supervisor_sleep(sv, 10000) == -1);
+  gracious_assert(elapsed_ms(&t_start) < 2500);
+  gracious_assert(supervisor_wait_exit(sv, proc_ids, 1, 0) == 0);
+  /* Signaling a terminated process is harmless */
+  gracious_assert(supervisor_kill(sv, proc_ids[0], SIGTERM) == 0);
+  supervisor_destroy(sv);
+
+  /* Testcase 7: SIGINT ends the sleep */
+  gracious_assert(supervisor_create(&sv) == 0);
+  proc_ids[0] = spawn_mode(sv, READY_UNTIL_SIGTERM);
+  gracious_assert(proc_ids[0] != -1);
+  gracious_assert(supervisor_wait_ready(sv, proc_ids[0], 5000) == 0);
+  gracious_assert(kill(getpid(), SIGINT) == 0);
+  clock_gettime(CLOCK_MONOTONIC, &t_start);
+  gracious_assert(supervisor_sleep(sv, 10000) == -1);
+  gracious_assert(elapsed_ms(&t_start) < 2500);
+  gracious_assert(supervisor_interrupted(sv) == SIGINT);
+  gracious_assert(supervisor_wait_ready(sv, proc_ids[0], 5000) == 0);
+  supervisor_destroy(sv);
+
+  /* Testcase 8: a process ignoring SIGTERM is killed after the timeout */
+  gracious_assert(supervisor_create(&sv) == 0);
+  proc_ids[0] = spawn_mode(sv, READY_IGNORING_SIGTERM);
+  gracious_assert(proc_ids[0] != -1);
+  gracious_assert(supervisor_wait_ready(sv, proc_ids[0], 5000) == 0);
+  gracious_assert(kill(proc_ids[0], SIGTERM) == 0);
+  clock_gettime(CLOCK_MONOTONIC, &t_start);
+  gracious_assert(supervisor_wait_exit(sv, proc_ids, 1, 200) == -1);
+  gracious_assert(elapsed_ms(&t_start) >= 200);
+  gracious_assert(elapsed_ms(&t_start) < 2500);
+  gracious_assert(kill(proc_ids[0], 0) == -1 && errno == ESRCH);
+  supervisor_destroy(sv);
+
+  /* Testcase 9: the signal mask is restored */
+  {
+    sigset_t mask;
+    gracious_assert(sigprocmask(SIG_BLOCK, NULL, &mask) == 0);
+    gracious_assert(!sigismember(&mask, SIGINT));
+    gracious_assert(!sigismember(&mask, SIGTERM));
+  }
+
+} MAIN_UNIT_TEST_END
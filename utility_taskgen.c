@@ -0,0 +1,203 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include "utility_taskgen.h"
+
+/* The number of discarded draws before giving up */
+#define MAX_TRIES 1000
+
+#define NS_PER_US 1000ULL
+
+/* The finalizer of splitmix64 by Sebastiano Vigna */
+static uint64_t mix(uint64_t z)
+{
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+static uint64_t rng_next(taskgen_rng *rng)
+{
+  return mix(rng->state += 0x9E3779B97F4A7C15ULL);
+}
+
+void taskgen_rng_seed(taskgen_rng *rng, uint64_t seed, uint64_t stream)
+{
+  /* Seeds differing by a multiple of the increment of rng_next()
+     would otherwise yield shifted copies of the same stream */
+  rng->state = mix(seed) ^ mix(~stream);
+}
+
+double taskgen_uniform(taskgen_rng *rng)
+{
+  return (rng_next(rng) >> 11) * 0x1.0p-53;
+}
+
+unsigned long long taskgen_log_uniform(taskgen_rng *rng,
+                                       unsigned long long min,
+                                       unsigned long long max,
+                                       unsigned long long granularity)
+{
+  double log_min = log(min), log_max = log(max + granularity);
+  unsigned long long t;
+
+  t = exp(log_min + taskgen_uniform(rng) * (log_max - log_min));
+  t = t / granularity * granularity;
+  if (t < min) {
+    t = (min + granularity - 1) / granularity * granularity;
+  }
+  if (t > max) {
+    t = max / granularity * granularity;
+  }
+
+  return t;
+}
+
+int taskgen_uunifast(taskgen_rng *rng, unsigned n, double total_u, double *u)
+{
+  unsigned tries, i;
+
+  if (n == 0 || total_u <= 0 || total_u > n) {
+    return -1;
+  }
+
+  for (tries = 0; tries < MAX_TRIES; tries++) {
+    double sum = total_u;
+    int discarded = 0;
+
+    for (i = 1; i < n; i++) {
+      double next = sum * pow(taskgen_uniform(rng), 1.0 / (n - i));
+      u[i - 1] = sum - next;
+      sum = next;
+    }
+    u[n - 1] = sum;
+
+    /* UUniFast-Discard */
+    for (i = 0; i < n && total_u > 1; i++) {
+      if (u[i] > 1) {
+        discarded = 1;
+        break;
+      }
+    }
+    if (!discarded) {
+      return 0;
+    }
+  }
+
+  return -1;
+}
+
+int taskgen_generate(taskgen_rng *rng, const struct taskgen_params *params,
+                     struct taskgen_task *tasks)
+{
+  unsigned long long wcet_min = (params->wcet_min_ns < NS_PER_US
+                                 ? NS_PER_US : params->wcet_min_ns);
+  unsigned n = params->task_count;
+  unsigned tries, i;
+  double *u;
+
+  if (params->period_granularity_ns == 0
+      || params->period_granularity_ns % NS_PER_US != 0
+      || params->period_min_ns < params->period_granularity_ns
+      || params->period_min_ns > params->period_max_ns
+      || params->deadline_min_ratio < 0 || params->deadline_min_ratio > 1) {
+    return -1;
+  }
+
+  u = malloc(sizeof(*u) * (n == 0 ? 1 : n));
+  if (u == NULL) {
+    log_error("Not enough memory to generate a task set");
+    return -1;
+  }
+
+  for (tries = 0; tries < MAX_TRIES; tries++) {
+    if (taskgen_uunifast(rng, n, params->utilization, u) != 0) {
+      break;
+    }
+
+    for (i = 0; i < n; i++) {
+      struct taskgen_task *t = &tasks[i];
+      double d_ratio = (params->deadline_min_ratio
+                        + ((1 - params->deadline_min_ratio)
+                           * taskgen_uniform(rng)));
+
+      t->period_ns = taskgen_log_uniform(rng, params->period_min_ns,
+                                         params->period_max_ns,
+                                         params->period_granularity_ns);
+      t->wcet_ns = ((unsigned long long) (u[i] * t->period_ns)
+                    / NS_PER_US * NS_PER_US);
+      if (t->wcet_ns < wcet_min) {
+        break;
+      }
+      t->deadline_ns = (t->wcet_ns
+                        + ((unsigned long long)
+                           (d_ratio * (t->period_ns - t->wcet_ns))
+                           / NS_PER_US * NS_PER_US));
+      if (t->deadline_ns > t->period_ns) {
+        t->deadline_ns = t->period_ns;
+      }
+    }
+
+    if (i == n) {
+      free(u);
+      return 0;
+    }
+  }
+
+  free(u);
+  return -1;
+}
+
+int taskgen_to_analysis(const struct taskgen_task *tasks, unsigned n,
+                        sched_analysis_taskset *taskset)
+{
+  unsigned i;
+  int rc;
+
+  for (i = 0; i < n; i++) {
+    if ((rc = sched_analysis_taskset_add(taskset,
+                                         to_utility_time_dyn(tasks[i].wcet_ns,
+                                                             ns),
+                                         to_utility_time_dyn
+                                         (tasks[i].period_ns, ns),
+                                         to_utility_time_dyn
+                                         (tasks[i].deadline_ns, ns)))
+        != 0) {
+      return rc;
+    }
+  }
+
+  return 0;
+}
+
+int taskgen_write(FILE *stream, const struct taskgen_task *tasks, unsigned n,
+                  const char *attributes)
+{
+  unsigned i;
+
+  for (i = 0; i < n; i++) {
+    if (fprintf(stream, "TASK tau_%u C=%lluus T=%lluus D=%lluus%s%s\n", i + 1,
+                tasks[i].wcet_ns / NS_PER_US, tasks[i].period_ns / NS_PER_US,
+                tasks[i].deadline_ns / NS_PER_US,
+                attributes == NULL ? "" : " ",
+                attributes == NULL ? "" : attributes) < 0) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,181 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+/**
+ * @file utility_taskgen.h
+ * @brief Random generation of periodic task sets for schedulability
+ * experiments.
+ *
+ * The utilizations of the tasks are drawn using UUniFast by Bini and
+ * Buttazzo, which samples uniformly among the utilization vectors
+ * having the given sum. If the sum exceeds one, UUniFast-Discard by
+ * Davis and Burns is used instead, which discards every vector having
+ * a task utilization greater than one. The periods are drawn from a
+ * log-uniform distribution so that every order of magnitude is
+ * equally represented, and the relative deadlines are drawn
+ * uniformly between the WCET and the period (constrained deadlines).
+ *
+ * The pseudo-random numbers of each task set come from a generator
+ * seeded with both a seed and the index of the task set so that a
+ * task set does not depend on which thread generates it or on the
+ * order of generation.
+ *
+ * @author Tadeus Prastowo <eus@member.fsf.org>
+ */
+
+#ifndef UTILITY_TASKGEN
+#define UTILITY_TASKGEN
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include "utility_log.h"
+#include "utility_time.h"
+#include "utility_sched_analysis.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /* I */
+  /**
+   * @name Collection of main data structures.
+   * @{
+   */
+
+  /** The state of a pseudo-random number generator. */
+  typedef struct
+  {
+    uint64_t state;
+  } taskgen_rng;
+
+  /** The parameters of the generated task sets. */
+  struct taskgen_params
+  {
+    unsigned task_count;
+    /** The total utilization, which must not exceed task_count. */
+    double utilization;
+    unsigned long long period_min_ns;
+    unsigned long long period_max_ns;
+    /** Every period is a multiple of this (at least 1 us). */
+    unsigned long long period_granularity_ns;
+    /** The relative deadline D of a task having WCET C and period T
+        is drawn uniformly from [C + ratio * (T - C), T] so that 1
+        gives implicit deadlines. */
+    double deadline_min_ratio;
+    /** A task set having a smaller WCET is discarded. */
+    unsigned long long wcet_min_ns;
+  };
+
+  /** A generated task whose times are multiples of 1 us. */
+  struct taskgen_task
+  {
+    unsigned long long wcet_ns;
+    unsigned long long period_ns;
+    unsigned long long deadline_ns;
+  };
+  /** @} End of collection of main data structures */
+
+  /* II */
+  /**
+   * @name Collection of pseudo-random number functions.
+   * @{
+   */
+
+  /**
+   * Seed the generator for the stream of the given index (e.g., the
+   * index of the task set) so that different streams of the same
+   * seed are independent.
+   */
+  void taskgen_rng_seed(taskgen_rng *rng, uint64_t seed, uint64_t stream);
+
+  /**
+   * @return a number drawn uniformly from [0, 1).
+   */
+  double taskgen_uniform(taskgen_rng *rng);
+
+  /**
+   * @return a multiple of granularity drawn log-uniformly from [min,
+   * max] where 0 < granularity <= min <= max.
+   */
+  unsigned long long taskgen_log_uniform(taskgen_rng *rng,
+                                         unsigned long long min,
+                                         unsigned long long max,
+                                         unsigned long long granularity);
+  /** @} End of collection of pseudo-random number functions */
+
+  /* III */
+  /**
+   * @name Collection of task set generation functions.
+   * @{
+   */
+
+  /**
+   * Draw n task utilizations summing up to total_u using UUniFast, or
+   * UUniFast-Discard if total_u is greater than one.
+   *
+   * @param u a pointer to an array of n elements to store the
+   * utilizations.
+   *
+   * @return 0 if successful or -1 if n is zero, total_u is not in (0,
+   * n] or UUniFast-Discard keeps discarding because total_u is too
+   * close to n.
+   */
+  int taskgen_uunifast(taskgen_rng *rng, unsigned n, double total_u,
+                       double *u);
+
+  /**
+   * Generate a task set. A WCET is rounded down to a multiple of 1 us
+   * so that the total utilization can be slightly less than the
+   * requested one.
+   *
+   * @param tasks a pointer to an array of params->task_count elements
+   * to store the tasks.
+   *
+   * @return 0 if successful or -1 if the parameters are invalid or no
+   * task set satisfies wcet_min_ns after many tries.
+   */
+  int taskgen_generate(taskgen_rng *rng, const struct taskgen_params *params,
+                       struct taskgen_task *tasks);
+
+  /**
+   * Add the given tasks to the given task set to analyze.
+   *
+   * @return like that of sched_analysis_taskset_add().
+   */
+  int taskgen_to_analysis(const struct taskgen_task *tasks, unsigned n,
+                          sched_analysis_taskset *taskset);
+
+  /**
+   * Write the given tasks as TASK declarations of a task set file
+   * (c.f., utility_taskset.h) named tau_1, tau_2 and so on.
+   *
+   * @param attributes if not NULL, the attributes like "policy=deadline"
+   * appended to every declaration.
+   *
+   * @return 0 if successful or -1 if the stream cannot be written.
+   */
+  int taskgen_write(FILE *stream, const struct taskgen_task *tasks,
+                    unsigned n, const char *attributes);
+  /** @} End of collection of task set generation functions */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UTILITY_TASKGEN */
@@ -0,0 +1,193 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include "utility_testcase.h"
+#include "utility_log.h"
+#include "utility_time.h"
+#include "utility_taskgen.h"
+#include "utility_taskset.h"
+
+#define DRAW_COUNT 100000
+#define TASK_COUNT 8
+
+MAIN_UNIT_TEST_BEGIN("utility_taskgen_test", "stderr", NULL, NULL)
+{
+  taskgen_rng rng, rng_2;
+  double u[TASK_COUNT];
+  struct taskgen_task tasks[TASK_COUNT];
+  unsigned long i, j;
+
+  /* Testcase 1: reproducible and independent streams */
+  taskgen_rng_seed(&rng, 42, 7);
+  taskgen_rng_seed(&rng_2, 42, 7);
+  for (i = 0; i < 100; i++) {
+    gracious_assert(taskgen_uniform(&rng) == taskgen_uniform(&rng_2));
+  }
+  taskgen_rng_seed(&rng_2, 42, 8);
+  gracious_assert(taskgen_uniform(&rng) != taskgen_uniform(&rng_2));
+
+  /* Testcase 2: uniform and log-uniform distributions */
+  {
+    double sum = 0;
+    unsigned long below_geometric_mean = 0;
+
+    for (i = 0; i < DRAW_COUNT; i++) {
+      double x = taskgen_uniform(&rng);
+      gracious_assert(x >= 0 && x < 1);
+      sum += x;
+
+      unsigned long long t = taskgen_log_uniform(&rng, 10000000, 1000000000,
+                                                 1000000);
+      unsigned long long t_remainder = t % 1000000;
+      gracious_assert(t >= 10000000 && t <= 1000000000 && t_remainder == 0);
+      if (t < 100000000) {
+        below_geometric_mean++;
+      }
+    }
+    gracious_assert(fabs(sum / DRAW_COUNT - 0.5) < 0.01);
+    gracious_assert(fabs((double) below_geometric_mean / DRAW_COUNT - 0.5)
+                    < 0.01);
+  }
+
+  /* Testcase 3: UUniFast and UUniFast-Discard */
+  {
+    double first_sum = 0;
+
+    for (i = 0; i < DRAW_COUNT / 10; i++) {
+      double sum = 0;
+      gracious_assert(taskgen_uunifast(&rng, TASK_COUNT, 0.8, u) == 0);
+      for (j = 0; j < TASK_COUNT; j++) {
+        gracious_assert(u[j] >= 0);
+        sum += u[j];
+      }
+      gracious_assert(fabs(sum - 0.8) < 1e-9);
+      first_sum += u[0];
+    }
+    /* Every task is equally likely to get a large utilization */
+    gracious_assert(fabs(first_sum / (DRAW_COUNT / 10) - 0.1) < 0.005);
+
+    gracious_assert(taskgen_uunifast(&rng, 4, 2.5, u) == 0);
+    for (j = 0; j < 4; j++) {
+      gracious_assert(u[j] <= 1);
+    }
+    gracious_assert(taskgen_uunifast(&rng, 1, 1, u) == 0 && u[0] == 1);
+    gracious_assert(taskgen_uunifast(&rng, 0, 0.5, u) == -1);
+    gracious_assert(taskgen_uunifast(&rng, 2, 0, u) == -1);
+    gracious_assert(taskgen_uunifast(&rng, 2, 2.5, u) == -1);
+  }
+
+  /* Testcase 4: task sets */
+  {
+    struct taskgen_params params = {
+      .task_count = TASK_COUNT,
+      .utilization = 0.7,
+      .period_min_ns = 10000000,
+      .period_max_ns = 1000000000,
+      .period_granularity_ns = 1000000,
+      .deadline_min_ratio = 0.5,
+      .wcet_min_ns = 0,
+    };
+
+    for (i = 0; i < 1000; i++) {
+      double total_u = 0;
+      gracious_assert(taskgen_generate(&rng, &params, tasks) == 0);
+      for (j = 0; j < TASK_COUNT; j++) {
+        const struct taskgen_task *t = &tasks[j];
+        unsigned long long wcet_remainder = t->wcet_ns % 1000;
+        unsigned long long period_remainder = t->period_ns % 1000000;
+        unsigned long long deadline_remainder = t->deadline_ns % 1000;
+        gracious_assert(t->wcet_ns >= 1000 && wcet_remainder == 0);
+        gracious_assert(period_remainder == 0);
+        gracious_assert(deadline_remainder == 0);
+        gracious_assert(t->wcet_ns + (t->period_ns - t->wcet_ns) / 2
+                        <= t->deadline_ns + 1000);
+        gracious_assert(t->deadline_ns <= t->period_ns);
+        total_u += (double) t->wcet_ns / t->period_ns;
+      }
+      gracious_assert(total_u <= 0.7 && total_u > 0.7 - TASK_COUNT * 1e-4);
+    }
+
+    params.deadline_min_ratio = 1;
+    params.wcet_min_ns = 1000000;
+    gracious_assert(taskgen_generate(&rng, &params, tasks) == 0);
+    for (j = 0; j < TASK_COUNT; j++) {
+      gracious_assert(tasks[j].deadline_ns == tasks[j].period_ns);
+      gracious_assert(tasks[j].wcet_ns >= 1000000);
+    }
+
+    params.wcet_min_ns = 200000000;
+    gracious_assert(taskgen_generate(&rng, &params, tasks) == -1);
+    params.wcet_min_ns = 0;
+    params.period_granularity_ns = 1500;
+    gracious_assert(taskgen_generate(&rng, &params, tasks) == -1);
+    params.period_granularity_ns = 1000000;
+    params.period_min_ns = params.period_max_ns + 1;
+    gracious_assert(taskgen_generate(&rng, &params, tasks) == -1);
+  }
+
+  /* Testcase 5: the analysis and the task set file of the same tasks */
+  {
+    sched_analysis_taskset *set = sched_analysis_taskset_create();
+    char path[] = "/tmp/utility_taskgen_test.XXXXXX";
+    taskset_desc *ts;
+    double total_u = 0;
+    FILE *f;
+    int fd;
+
+    gracious_assert(set != NULL);
+    gracious_assert(taskgen_to_analysis(tasks, TASK_COUNT, set) == 0);
+    gracious_assert(sched_analysis_taskset_size(set) == TASK_COUNT);
+    for (j = 0; j < TASK_COUNT; j++) {
+      total_u += (double) tasks[j].wcet_ns / tasks[j].period_ns;
+    }
+    gracious_assert(fabs(sched_analysis_utilization(set) - total_u) < 1e-9);
+    sched_analysis_taskset_destroy(set);
+
+    fd = mkstemp(path);
+    gracious_assert(fd != -1);
+    f = fdopen(fd, "w");
+    gracious_assert(f != NULL);
+    gracious_assert(fputs("STOP 5s\n", f) >= 0);
+    gracious_assert(taskgen_write(f, tasks, TASK_COUNT,
+                                  "kernel=sleep") == 0);
+    gracious_assert(fclose(f) == 0);
+
+    gracious_assert(taskset_load(path, &ts) == 0);
+    unlink(path);
+    gracious_assert(taskset_task_count(ts) == TASK_COUNT);
+    for (j = 0; j < TASK_COUNT; j++) {
+      const struct taskset_task *t = taskset_task(ts, j);
+      gracious_assert(t->kernel == TASKSET_KERNEL_SLEEP);
+      gracious_assert(utility_time_eq_gc_t2(&t->wcet,
+                                            to_utility_time_dyn
+                                            (tasks[j].wcet_ns, ns)));
+      gracious_assert(utility_time_eq_gc_t2(&t->period,
+                                            to_utility_time_dyn
+                                            (tasks[j].period_ns, ns)));
+      gracious_assert(utility_time_eq_gc_t2(&t->deadline,
+                                            to_utility_time_dyn
+                                            (tasks[j].deadline_ns, ns)));
+    }
+    taskset_destroy(ts);
+  }
+
+} MAIN_UNIT_TEST_END
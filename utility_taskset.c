@@ -0,0 +1,782 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include "utility_taskset.h"
+
+#define LINE_MAX_LEN 1024
+#define DEFAULT_START_S 3
+
+struct taskset_desc
+{
+  relative_time start;
+  relative_time stop;
+  struct taskset_task *tasks;
+  unsigned task_count;
+  unsigned task_capacity;
+  struct taskset_resource *resources;
+  unsigned resource_count;
+  unsigned resource_capacity;
+  int explicit_prio; /* The fifo tasks have prio */
+};
+
+/* The position in the file being loaded for error messages */
+struct file_pos
+{
+  const char *path;
+  unsigned line;
+};
+
+#define file_error(pos, msg, ...)                                       \
+  log_error("%s:%u: " msg, (pos)->path, (pos)->line, ##__VA_ARGS__)
+
+static const char *const policy_names[] = {
+  "fifo", "deadline",
+};
+
+static const char *const kernel_names[] = {
+  "busyloop", "sleep",
+};
+
+static int parse_enum(const char *str, const char *const *names,
+                      unsigned name_count, unsigned *res)
+{
+  unsigned i;
+
+  for (i = 0; i < name_count; i++) {
+    if (strcmp(str, names[i]) == 0) {
+      *res = i;
+      return 0;
+    }
+  }
+
+  return -1;
+}
+
+/* Parse TIME as documented in the header returning 0 if successful or
+   -1 otherwise */
+static int parse_time(const char *str, relative_time *res)
+{
+  unsigned long long value;
+  char *unit;
+
+  if (!isdigit(*str)) {
+    return -1;
+  }
+  errno = 0;
+  value = strtoull(str, &unit, 10);
+  if (errno != 0) {
+    return -1;
+  }
+
+  utility_time_init(res);
+  if (strcmp(unit, "s") == 0) {
+    to_utility_time(value, s, res);
+  } else if (strcmp(unit, "ms") == 0) {
+    to_utility_time(value, ms, res);
+  } else if (strcmp(unit, "us") == 0) {
+    to_utility_time(value, us, res);
+  } else if (strcmp(unit, "ns") == 0) {
+    to_utility_time(value, ns, res);
+  } else if (*unit != '\0' || value != 0) {
+    return -1;
+  }
+
+  return 0;
+}
+
+static int parse_name(const char *str, char *res)
+{
+  size_t len = strlen(str);
+  size_t i;
+
+  if (len == 0 || len >= TASKSET_NAME_MAX) {
+    return -1;
+  }
+  for (i = 0; i < len; i++) {
+    if (!isalnum(str[i]) && str[i] != '_' && str[i] != '-') {
+      return -1;
+    }
+  }
+
+  memcpy(res, str, len + 1);
+  return 0;
+}
+
+static int parse_unsigned(const char *str, unsigned *res)
+{
+  unsigned long value;
+  char *end;
+
+  if (!isdigit(*str)) {
+    return -1;
+  }
+  errno = 0;
+  value = strtoul(str, &end, 10);
+  if (errno != 0 || *end != '\0' || value > 0xFFFFU) {
+    return -1;
+  }
+
+  *res = value;
+  return 0;
+}
+
+static int find_resource(const taskset_desc *ts, const char *name)
+{
+  unsigned i;
+
+  for (i = 0; i < ts->resource_count; i++) {
+    if (strcmp(ts->resources[i].name, name) == 0) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+static int find_task(const taskset_desc *ts, const char *name)
+{
+  unsigned i;
+
+  for (i = 0; i < ts->task_count; i++) {
+    if (strcmp(ts->tasks[i].name, name) == 0) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+/* Grow an array of element_size-byte elements to hold one more
+   element returning 0 if successful or -2 otherwise */
+static int grow(void **array, unsigned count, unsigned *capacity,
+                size_t element_size)
+{
+  void *new_array;
+
+  if (count < *capacity) {
+    return 0;
+  }
+
+  new_array = realloc(*array, element_size * (*capacity * 2 + 4));
+  if (new_array == NULL) {
+    log_error("Not enough memory to load the task set");
+    return -2;
+  }
+  *array = new_array;
+  *capacity = *capacity * 2 + 4;
+
+  return 0;
+}
+
+static int parse_resource(taskset_desc *ts, const struct file_pos *pos,
+                          char **save_ptr)
+{
+  const char *name = strtok_r(NULL, " \t\r\n", save_ptr);
+  const char *protocol = strtok_r(NULL, " \t\r\n", save_ptr);
+  struct taskset_resource *r;
+  int rc;
+
+  if (name == NULL || protocol == NULL
+      || strtok_r(NULL, " \t\r\n", save_ptr) != NULL) {
+    file_error(pos, "Expecting RESOURCE NAME PROTOCOL");
+    return -1;
+  }
+
+  if ((rc = grow((void **) &ts->resources, ts->resource_count,
+                 &ts->resource_capacity, sizeof(*ts->resources))) != 0) {
+    return rc;
+  }
+  r = &ts->resources[ts->resource_count];
+
+  if (parse_name(name, r->name) != 0) {
+    file_error(pos, "Invalid resource name '%s'", name);
+    return -1;
+  }
+  if (find_resource(ts, r->name) != -1) {
+    file_error(pos, "Resource %s is already declared", r->name);
+    return -1;
+  }
+  if (rt_lock_protocol_parse(protocol, &r->protocol) != 0) {
+    file_error(pos, "Unknown locking protocol '%s'", protocol);
+    return -1;
+  }
+  r->ceiling_level = 0;
+
+  ts->resource_count++;
+  return 0;
+}
+
+/* Parse RESOURCE@TIME+TIME into the next critical section of t
+   returning 0 if successful or -1 otherwise */
+static int parse_cs(const taskset_desc *ts, const struct file_pos *pos,
+                    char *value, struct taskset_task *t)
+{
+  char *at = strchr(value, '@');
+  char *plus = (at == NULL ? NULL : strchr(at, '+'));
+  struct taskset_cs *cs;
+  int resource;
+
+  if (at == NULL || plus == NULL) {
+    file_error(pos, "Expecting cs=RESOURCE@TIME+TIME");
+    return -1;
+  }
+  *at = '\0';
+  *plus = '\0';
+
+  if (t->cs_count == TASKSET_CS_MAX) {
+    file_error(pos, "Task %s has more than %d critical sections", t->name,
+               TASKSET_CS_MAX);
+    return -1;
+  }
+  cs = &t->cs[t->cs_count];
+
+  if ((resource = find_resource(ts, value)) == -1) {
+    file_error(pos, "Resource '%s' is not declared", value);
+    return -1;
+  }
+  cs->resource = resource;
+
+  if (parse_time(at + 1, &cs->start) != 0
+      || parse_time(plus + 1, &cs->length) != 0) {
+    file_error(pos, "Invalid time in the critical section of %s", value);
+    return -1;
+  }
+  if (utility_time_eq_gc_t2(&cs->length, to_utility_time_dyn(0, ns))) {
+    file_error(pos, "The critical section of %s is empty", value);
+    return -1;
+  }
+  if (t->cs_count > 0) {
+    const struct taskset_cs *prev = &t->cs[t->cs_count - 1];
+    if (utility_time_lt_gc_t2(&cs->start,
+                              utility_time_add_dyn(&prev->start,
+                                                   &prev->length))) {
+      file_error(pos, "The critical section of %s overlaps the previous one",
+                 value);
+      return -1;
+    }
+  }
+
+  t->cs_count++;
+  return 0;
+}
+
+static int parse_task(taskset_desc *ts, const struct file_pos *pos,
+                      char **save_ptr)
+{
+  const char *name = strtok_r(NULL, " \t\r\n", save_ptr);
+  char *token;
+  struct taskset_task *t;
+  int wcet_given = 0, period_given = 0, deadline_given = 0;
+  int rc;
+
+  if (name == NULL) {
+    file_error(pos, "Expecting TASK NAME KEY=VALUE...");
+    return -1;
+  }
+
+  if ((rc = grow((void **) &ts->tasks, ts->task_count, &ts->task_capacity,
+                 sizeof(*ts->tasks))) != 0) {
+    return rc;
+  }
+  t = &ts->tasks[ts->task_count];
+  memset(t, 0, sizeof(*t));
+  t->cpu = -1;
+
+  if (parse_name(name, t->name) != 0) {
+    file_error(pos, "Invalid task name '%s'", name);
+    return -1;
+  }
+  if (find_task(ts, t->name) != -1) {
+    file_error(pos, "Task %s is already declared", t->name);
+    return -1;
+  }
+
+  while ((token = strtok_r(NULL, " \t\r\n", save_ptr)) != NULL) {
+    char *value = strchr(token, '=');
+    unsigned enum_value;
+
+    if (value == NULL) {
+      file_error(pos, "Expecting KEY=VALUE instead of '%s'", token);
+      return -1;
+    }
+    *value++ = '\0';
+
+    if (strcmp(token, "C") == 0) {
+      rc = parse_time(value, &t->wcet);
+      wcet_given = 1;
+    } else if (strcmp(token, "T") == 0) {
+      rc = parse_time(value, &t->period);
+      period_given = 1;
+    } else if (strcmp(token, "D") == 0) {
+      rc = parse_time(value, &t->deadline);
+      deadline_given = 1;
+    } else if (strcmp(token, "offset") == 0) {
+      rc = parse_time(value, &t->offset);
+    } else if (strcmp(token, "policy") == 0) {
+      rc = parse_enum(value, policy_names,
+                      sizeof(policy_names) / sizeof(*policy_names),
+                      &enum_value);
+      if (rc == 0) {
+        t->policy = enum_value;
+      }
+    } else if (strcmp(token, "prio") == 0) {
+      rc = parse_unsigned(value, &t->prio_level);
+      if (rc == 0 && t->prio_level == 0) {
+        rc = -1;
+      }
+    } else if (strcmp(token, "cpu") == 0) {
+      unsigned cpu;
+      rc = parse_unsigned(value, &cpu);
+      if (rc == 0) {
+        t->cpu = cpu;
+      }
+    } else if (strcmp(token, "kernel") == 0) {
+      rc = parse_enum(value, kernel_names,
+                      sizeof(kernel_names) / sizeof(*kernel_names),
+                      &enum_value);
+      if (rc == 0) {
+        t->kernel = enum_value;
+      }
+    } else if (strcmp(token, "cs") == 0) {
+      if (parse_cs(ts, pos, value, t) != 0) {
+        return -1;
+      }
+      rc = 0;
+    } else {
+      file_error(pos, "Unknown task parameter '%s'", token);
+      return -1;
+    }
+
+    if (rc != 0) {
+      file_error(pos, "Invalid value '%s' of %s", value, token);
+      return -1;
+    }
+  }
+
+  /* Check the parameters */
+  if (!wcet_given || !period_given) {
+    file_error(pos, "Task %s needs C and T", t->name);
+    return -1;
+  }
+  if (!deadline_given) {
+    utility_time_to_utility_time(&t->period, &t->deadline);
+  }
+  if (utility_time_eq_gc_t2(&t->wcet, to_utility_time_dyn(0, ns))
+      || utility_time_gt(&t->wcet, &t->deadline)) {
+    file_error(pos, "Task %s needs 0 < C <= D", t->name);
+    return -1;
+  }
+  if (t->policy == TASKSET_POLICY_DEADLINE
+      && utility_time_gt(&t->deadline, &t->period)) {
+    file_error(pos, "Deadline task %s needs D <= T", t->name);
+    return -1;
+  }
+  if (t->policy == TASKSET_POLICY_DEADLINE && t->prio_level != 0) {
+    file_error(pos, "Deadline task %s cannot have prio", t->name);
+    return -1;
+  }
+  if (t->cs_count > 0) {
+    const struct taskset_cs *last = &t->cs[t->cs_count - 1];
+    if (utility_time_gt_gc_t2(utility_time_add_dyn(&last->start,
+                                                   &last->length),
+                              &t->wcet)) {
+      file_error(pos, "The critical sections of %s exceed C", t->name);
+      return -1;
+    }
+  }
+  /* END: Check the parameters */
+
+  ts->task_count++;
+  return 0;
+}
+
+/* Derive the priority levels and the resource ceilings once every
+   line has been parsed returning 0 if successful or -1 otherwise */
+static int complete(taskset_desc *ts, const char *path)
+{
+  unsigned fifo_count = 0, level_count = 0;
+  unsigned i, j;
+
+  for (i = 0; i < ts->task_count; i++) {
+    if (ts->tasks[i].policy == TASKSET_POLICY_FIFO) {
+      fifo_count++;
+      if (ts->tasks[i].prio_level != 0) {
+        level_count++;
+      }
+    }
+  }
+  if (level_count != 0 && level_count != fifo_count) {
+    log_error("%s: Either every fifo task or none has prio", path);
+    return -1;
+  }
+  ts->explicit_prio = (level_count != 0);
+
+  /* Deadline monotonic priority levels */
+  if (level_count == 0) {
+    for (i = 0; i < ts->task_count; i++) {
+      struct taskset_task *t = &ts->tasks[i];
+      if (t->policy != TASKSET_POLICY_FIFO) {
+        continue;
+      }
+      t->prio_level = 1;
+      for (j = 0; j < ts->task_count; j++) {
+        const struct taskset_task *other = &ts->tasks[j];
+        if (other->policy == TASKSET_POLICY_FIFO
+            && (utility_time_lt(&other->deadline, &t->deadline)
+                || (j < i && utility_time_eq(&other->deadline,
+                                             &t->deadline)))) {
+          t->prio_level++;
+        }
+      }
+    }
+  }
+  /* END: Deadline monotonic priority levels */
+
+  /* Resource ceilings */
+  for (i = 0; i < ts->task_count; i++) {
+    const struct taskset_task *t = &ts->tasks[i];
+    for (j = 0; j < t->cs_count; j++) {
+      struct taskset_resource *r = &ts->resources[t->cs[j].resource];
+      if (t->policy == TASKSET_POLICY_DEADLINE) {
+        if (r->protocol == RT_LOCK_PROTECT || r->protocol == RT_LOCK_SRP) {
+          log_error("%s: Deadline task %s cannot use %s resource %s",
+                    path, t->name, rt_lock_protocol_name(r->protocol),
+                    r->name);
+          return -1;
+        }
+      } else if (r->ceiling_level == 0 || t->prio_level < r->ceiling_level) {
+        r->ceiling_level = t->prio_level;
+      }
+    }
+  }
+  /* END: Resource ceilings */
+
+  return 0;
+}
+
+int taskset_load(const char *path, taskset_desc **res)
+{
+  struct file_pos pos = {
+    .path = path,
+    .line = 0,
+  };
+  char line[LINE_MAX_LEN];
+  int stop_given = 0;
+  int rc = -2;
+  taskset_desc *ts;
+  FILE *f;
+
+  ts = calloc(1, sizeof(*ts));
+  if (ts == NULL) {
+    log_error("Not enough memory to load the task set");
+    return -2;
+  }
+  utility_time_init(&ts->start);
+  utility_time_init(&ts->stop);
+  to_utility_time(DEFAULT_START_S, s, &ts->start);
+
+  f = fopen(path, "r");
+  if (f == NULL) {
+    log_syserror("Cannot open %s", path);
+    goto error;
+  }
+
+  while (fgets(line, sizeof(line), f) != NULL) {
+    char *save_ptr, *keyword, *comment;
+
+    pos.line++;
+    if (strchr(line, '\n') == NULL && !feof(f)) {
+      file_error(&pos, "The line is longer than %d characters",
+                 LINE_MAX_LEN - 2);
+      rc = -1;
+      goto error;
+    }
+    if ((comment = strchr(line, '#')) != NULL) {
+      *comment = '\0';
+    }
+
+    keyword = strtok_r(line, " \t\r\n", &save_ptr);
+    if (keyword == NULL) {
+      continue;
+    }
+
+    if (strcmp(keyword, "START") == 0 || strcmp(keyword, "STOP") == 0) {
+      const char *value = strtok_r(NULL, " \t\r\n", &save_ptr);
+      relative_time *t = (keyword[2] == 'A' ? &ts->start : &ts->stop);
+      if (value == NULL || parse_time(value, t) != 0
+          || strtok_r(NULL, " \t\r\n", &save_ptr) != NULL) {
+        file_error(&pos, "Expecting %s TIME", keyword);
+        rc = -1;
+        goto error;
+      }
+      if (t == &ts->stop) {
+        stop_given = 1;
+      }
+    } else if (strcmp(keyword, "RESOURCE") == 0) {
+      if ((rc = parse_resource(ts, &pos, &save_ptr)) != 0) {
+        goto error;
+      }
+    } else if (strcmp(keyword, "TASK") == 0) {
+      if ((rc = parse_task(ts, &pos, &save_ptr)) != 0) {
+        goto error;
+      }
+    } else {
+      file_error(&pos, "Unknown declaration '%s'", keyword);
+      rc = -1;
+      goto error;
+    }
+  }
+  if (ferror(f)) {
+    log_syserror("Cannot read %s", path);
+    rc = -2;
+    goto error;
+  }
+
+  rc = -1;
+  if (!stop_given || utility_time_le(&ts->stop, &ts->start)) {
+    log_error("%s: STOP must be declared after START", path);
+    goto error;
+  }
+  if (ts->task_count == 0) {
+    log_error("%s: No task is declared", path);
+    goto error;
+  }
+  if (complete(ts, path) != 0) {
+    goto error;
+  }
+
+  fclose(f);
+  *res = ts;
+  return 0;
+
+ error:
+  if (f != NULL) {
+    fclose(f);
+  }
+  taskset_destroy(ts);
+  return rc;
+}
+
+void taskset_destroy(taskset_desc *ts)
+{
+  free(ts->tasks);
+  free(ts->resources);
+  free(ts);
+}
+
+const relative_time *taskset_start(const taskset_desc *ts)
+{
+  return &ts->start;
+}
+
+const relative_time *taskset_stop(const taskset_desc *ts)
+{
+  return &ts->stop;
+}
+
+unsigned taskset_task_count(const taskset_desc *ts)
+{
+  return ts->task_count;
+}
+
+const struct taskset_task *taskset_task(const taskset_desc *ts, unsigned idx)
+{
+  return &ts->tasks[idx];
+}
+
+unsigned taskset_resource_count(const taskset_desc *ts)
+{
+  return ts->resource_count;
+}
+
+const struct taskset_resource *taskset_resource(const taskset_desc *ts,
+                                                unsigned idx)
+{
+  return &ts->resources[idx];
+}
+
+int taskset_has_cpu_binding(const taskset_desc *ts)
+{
+  unsigned i;
+
+  for (i = 0; i < ts->task_count; i++) {
+    if (ts->tasks[i].cpu != -1) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+/* Analyze the tasks running on the given CPU returning like
+   taskset_analyze() */
+static int analyze_cpu(const taskset_desc *ts, int cpu, int experiment_cpu,
+                       FILE *stream)
+{
+  sched_analysis_taskset *fifo_set = sched_analysis_taskset_create();
+  sched_analysis_taskset *deadline_set = sched_analysis_taskset_create();
+  unsigned *fifo_tasks = malloc(sizeof(*fifo_tasks) * ts->task_count);
+  unsigned fifo_count = 0;
+  int rc = -2;
+  unsigned i;
+
+  if (fifo_set == NULL || deadline_set == NULL || fifo_tasks == NULL) {
+    log_error("Not enough memory to analyze the task set");
+    goto out;
+  }
+
+  for (i = 0; i < ts->task_count; i++) {
+    const struct taskset_task *t = &ts->tasks[i];
+    sched_analysis_taskset *set;
+
+    if ((t->cpu == -1 ? experiment_cpu : t->cpu) != cpu) {
+      continue;
+    }
+    if (t->policy == TASKSET_POLICY_FIFO) {
+      set = fifo_set;
+      fifo_tasks[fifo_count++] = i;
+    } else {
+      set = deadline_set;
+    }
+    if (sched_analysis_taskset_add(set,
+                                   utility_time_to_utility_time_dyn(&t->wcet),
+                                   utility_time_to_utility_time_dyn
+                                   (&t->period),
+                                   utility_time_to_utility_time_dyn
+                                   (&t->deadline)) != 0) {
+      log_error("Cannot add %s to the task set to analyze", t->name);
+      goto out;
+    }
+  }
+
+  if (stream != NULL) {
+    fprintf(stream, "CPU %d: U = %.3f (fifo) + %.3f (deadline)\n", cpu,
+            sched_analysis_utilization(fifo_set),
+            sched_analysis_utilization(deadline_set));
+  }
+
+  rc = -1;
+  if (fifo_count > 0 && sched_analysis_taskset_size(deadline_set) > 0) {
+    log_error("CPU %d runs both fifo and deadline tasks", cpu);
+    goto out;
+  }
+
+  if (fifo_count > 0) {
+    /* Only the derived levels follow the order used by the test */
+    if (ts->explicit_prio) {
+      log_error("CPU %d has fifo tasks with explicit prio", cpu);
+      goto out;
+    }
+
+    switch (sched_analysis_fp(fifo_set, SCHED_ANALYSIS_DM)) {
+    case 1:
+      rc = 1;
+      break;
+    case 0:
+      rc = 0;
+      break;
+    default:
+      log_error("CPU %d has a fifo task with D > T", cpu);
+      goto out;
+    }
+
+    if (stream != NULL) {
+      for (i = 0; i < fifo_count; i++) {
+        relative_time *r = sched_analysis_response_time(fifo_set, i);
+        if (r == NULL) {
+          fprintf(stream, "  %s response time: unknown\n",
+                  ts->tasks[fifo_tasks[i]].name);
+        } else {
+          char r_str[32];
+          to_string_gc(r, r_str, sizeof(r_str));
+          fprintf(stream, "  %s response time: %s\n",
+                  ts->tasks[fifo_tasks[i]].name, r_str);
+        }
+      }
+    }
+  } else {
+    rc = sched_analysis_edf(deadline_set) ? 1 : 0;
+    if (stream != NULL) {
+      fprintf(stream, "  EDF: %s\n", rc ? "schedulable" : "not schedulable");
+    }
+    if (rc == 1) {
+      switch (sched_analysis_deadline_admissible(deadline_set, 1)) {
+      case 1:
+        break;
+      case 0:
+        log_error("CPU %d exceeds the SCHED_DEADLINE bandwidth limit", cpu);
+        rc = 0;
+        break;
+      default:
+        rc = -2;
+        break;
+      }
+    }
+  }
+
+ out:
+  free(fifo_tasks);
+  if (deadline_set != NULL) {
+    sched_analysis_taskset_destroy(deadline_set);
+  }
+  if (fifo_set != NULL) {
+    sched_analysis_taskset_destroy(fifo_set);
+  }
+  return rc;
+}
+
+int taskset_analyze(const taskset_desc *ts, int experiment_cpu, FILE *stream)
+{
+  int unschedulable = 0, unknown = 0;
+  unsigned i, j;
+
+  for (i = 0; i < ts->task_count; i++) {
+    const struct taskset_task *t = &ts->tasks[i];
+    int cpu = (t->cpu == -1 ? experiment_cpu : t->cpu);
+
+    /* Analyze each CPU once at its first task */
+    for (j = 0; j < i; j++) {
+      const struct taskset_task *prev = &ts->tasks[j];
+      if ((prev->cpu == -1 ? experiment_cpu : prev->cpu) == cpu) {
+        break;
+      }
+    }
+    if (j < i) {
+      continue;
+    }
+
+    switch (analyze_cpu(ts, cpu, experiment_cpu, stream)) {
+    case 1:
+      break;
+    case 0:
+      unschedulable = 1;
+      break;
+    case -1:
+      unknown = 1;
+      break;
+    default:
+      return -2;
+    }
+  }
+
+  if (unschedulable) {
+    return 0;
+  } else if (unknown) {
+    return -1;
+  }
+  return 1;
+}
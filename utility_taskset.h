@@ -0,0 +1,266 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+/**
+ * @file utility_taskset.h
+ * @brief A declarative description of a task set so that a
+ * scheduling experiment can be written as data instead of C code.
+ *
+ * A task set file is a text file where everything following '#' up
+ * to the end of a line is a comment and every other non-blank line
+ * is one of the following declarations whose words are separated by
+ * blanks:
+ * - START TIME: the time from the start of the experiment to the
+ *   release of the tasks (3s by default), which leaves the time to
+ *   create the busyloops.
+ * - STOP TIME: the time from the start of the experiment to the stop
+ *   of the tasks, which is mandatory.
+ * - RESOURCE NAME PROTOCOL: a shared resource protected using the
+ *   given locking protocol (see rt_lock_protocol_parse()).
+ * - TASK NAME KEY=VALUE...: a periodic task whose parameters are the
+ *   following:
+ *   - C=TIME: the WCET (mandatory).
+ *   - T=TIME: the period (mandatory).
+ *   - D=TIME: the relative deadline (T by default).
+ *   - offset=TIME: the release offset (0 by default).
+ *   - policy=fifo|deadline: SCHED_FIFO or SCHED_DEADLINE, which uses
+ *     a CBS whose runtime, deadline and period are C, D and T (fifo
+ *     by default).
+ *   - prio=LEVEL: the priority level of a fifo task where 1 is the
+ *     highest (c.f., sched_fifo_prio()). Either every fifo task or
+ *     none has a priority level; in the latter case, the levels
+ *     follow the deadline monotonic order with ties broken in favor
+ *     of the task declared earlier.
+ *   - cpu=CPU: the CPU running the task (the experiment CPU by
+ *     default).
+ *   - kernel=busyloop|sleep: the workload of a job, which either
+ *     keeps the CPU busy for C or sleeps for C to model a
+ *     self-suspension (busyloop by default).
+ *   - cs=RESOURCE@TIME+TIME: a critical section of the given
+ *     resource starting at the given execution time of a job and
+ *     lasting for the given time. This can be repeated for
+ *     consecutive non-overlapping critical sections in the order of
+ *     their starting times.
+ *
+ * A TIME is a non-negative integer directly followed by one of s, ms,
+ * us or ns. A zero time may omit the unit. A name consists of at
+ * most TASKSET_NAME_MAX - 1 letters, digits, '_' and '-'.
+ *
+ * For example, the following is the task set of the experiment
+ * component rate_monotonic:
+ * @code
+ * STOP 13s
+ * TASK tau_1 C=2ms T=10ms
+ * TASK tau_2 C=3ms T=15ms
+ * TASK tau_3 C=6ms T=26ms
+ * TASK tau_4 C=6ms T=36ms
+ * @endcode
+ *
+ * @author Tadeus Prastowo <eus@member.fsf.org>
+ */
+
+#ifndef UTILITY_TASKSET
+#define UTILITY_TASKSET
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include "utility_log.h"
+#include "utility_time.h"
+#include "utility_lock.h"
+#include "utility_sched_analysis.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /* I */
+  /**
+   * @name Collection of main data structures.
+   * @{
+   */
+
+  /** The size of the buffer of a name including the terminating NUL. */
+#define TASKSET_NAME_MAX 32
+
+  /** The maximum number of critical sections of a task. */
+#define TASKSET_CS_MAX 8
+
+  /** The scheduling policies of a task. */
+  enum taskset_policy {
+    TASKSET_POLICY_FIFO, /**< SCHED_FIFO at a priority level. */
+    TASKSET_POLICY_DEADLINE, /**< SCHED_DEADLINE. */
+  };
+
+  /** The workloads of a job. */
+  enum taskset_kernel {
+    TASKSET_KERNEL_BUSYLOOP, /**< Keep the CPU busy. */
+    TASKSET_KERNEL_SLEEP, /**< Sleep (self-suspension). */
+  };
+
+  /** A shared resource. */
+  struct taskset_resource
+  {
+    char name[TASKSET_NAME_MAX];
+    enum rt_lock_protocol protocol;
+    /** The highest priority level (the smallest number) of the fifo
+        tasks using the resource or 0 if no fifo task uses it. */
+    unsigned ceiling_level;
+  };
+
+  /** A critical section of a job. */
+  struct taskset_cs
+  {
+    unsigned resource; /**< The index of the resource. */
+    relative_time start; /**< The execution time before the entry. */
+    relative_time length; /**< The execution time inside. */
+  };
+
+  /** A periodic task. */
+  struct taskset_task
+  {
+    char name[TASKSET_NAME_MAX];
+    relative_time wcet;
+    relative_time period;
+    relative_time deadline;
+    relative_time offset;
+    enum taskset_policy policy;
+    unsigned prio_level; /**< Only meaningful for a fifo task. */
+    int cpu; /**< -1 for the experiment CPU. */
+    enum taskset_kernel kernel;
+    unsigned cs_count;
+    struct taskset_cs cs[TASKSET_CS_MAX];
+  };
+
+  /**
+   * A task set loaded from a file.
+   * This is an opaque type; do not manipulate any of its instances directly.
+   */
+  typedef struct taskset_desc taskset_desc;
+  /** @} End of collection of main data structures */
+
+  /* II */
+  /**
+   * @name Collection of functions to load a task set.
+   * @{
+   */
+
+  /**
+   * Load a task set file. Every error in the file is logged together
+   * with its line number.
+   *
+   * @param path the path to the task set file.
+   * @param res a pointer to the object to store the loaded task set.
+   *
+   * @return 0 if the task set is loaded, -1 if the file is invalid,
+   * or -2 in case of hard error that requires the investigation of
+   * the output of the logging facility to fix the error.
+   */
+  int taskset_load(const char *path, taskset_desc **res);
+
+  /**
+   * Destroy a loaded task set.
+   */
+  void taskset_destroy(taskset_desc *ts);
+  /** @} End of collection of functions to load a task set */
+
+  /* III */
+  /**
+   * @name Collection of accessors.
+   * @{
+   */
+
+  /**
+   * @return the time from the start of the experiment to the release
+   * of the tasks.
+   */
+  const relative_time *taskset_start(const taskset_desc *ts);
+
+  /**
+   * @return the time from the start of the experiment to the stop of
+   * the tasks.
+   */
+  const relative_time *taskset_stop(const taskset_desc *ts);
+
+  /**
+   * @return the number of tasks.
+   */
+  unsigned taskset_task_count(const taskset_desc *ts);
+
+  /**
+   * @return the task at the given position in the order of
+   * declaration starting from zero.
+   */
+  const struct taskset_task *taskset_task(const taskset_desc *ts,
+                                          unsigned idx);
+
+  /**
+   * @return the number of resources.
+   */
+  unsigned taskset_resource_count(const taskset_desc *ts);
+
+  /**
+   * @return the resource at the given position in the order of
+   * declaration starting from zero.
+   */
+  const struct taskset_resource *taskset_resource(const taskset_desc *ts,
+                                                  unsigned idx);
+
+  /**
+   * @return non-zero if some task is bound to a CPU using cpu=CPU or
+   * zero otherwise.
+   */
+  int taskset_has_cpu_binding(const taskset_desc *ts);
+  /** @} End of collection of accessors */
+
+  /* IV */
+  /**
+   * @name Collection of analysis functions.
+   * @{
+   */
+
+  /**
+   * Analyze the schedulability of the task set on each of its CPUs
+   * using utility_sched_analysis while ignoring the blocking on the
+   * resources: the fifo tasks are analyzed using response-time
+   * analysis in the deadline monotonic order and the deadline tasks
+   * are analyzed using the processor demand criterion and the
+   * SCHED_DEADLINE admission control. A CPU running both kinds of
+   * tasks or fifo tasks whose priority levels are given explicitly
+   * cannot be analyzed.
+   *
+   * @param ts a pointer to the task set.
+   * @param experiment_cpu the CPU running the tasks without cpu=CPU.
+   * @param stream if not NULL, the stream to print the utilization
+   * of each CPU and the response time of each fifo task.
+   *
+   * @return 1 if the task set is schedulable, 0 if it is not, -1 if
+   * it cannot be analyzed, or -2 in case of hard error that requires
+   * the investigation of the output of the logging facility to fix
+   * the error.
+   */
+  int taskset_analyze(const taskset_desc *ts, int experiment_cpu,
+                      FILE *stream);
+  /** @} End of collection of analysis functions */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UTILITY_TASKSET */
@@ -0,0 +1,163 @@
+/*****************************************************************************
+ * Copyright (C) 2011  Tadeus Prastowo (eus@member.fsf.org)                  *
+ *                                                                           *
+ * This program is free software: you can redistribute it and/or modify      *
+ * it under the terms of the GNU General Public License as published by      *
+ * the Free Software Foundation, either version 3 of the License, or         *
+ * (at your option) any later version.                                       *
+ *                                                                           *
+ * This program is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ * GNU General Public License for more details.                              *
+ *                                                                           *
+ * You should have received a copy of the GNU General Public License         *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.     *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "utility_testcase.h"
+#include "utility_log.h"
+#include "utility_time.h"
+#include "utility_taskset.h"
+
+static char taskset_path[] = "/tmp/utility_taskset_test.XXXXXX";
+
+/* Load the given content as a task set file */
+static int load(const char *content, taskset_desc **res)
+{
+  FILE *f = fopen(taskset_path, "w");
+  gracious_assert(f != NULL);
+  gracious_assert(fputs(content, f) >= 0);
+  gracious_assert(fclose(f) == 0);
+
+  return taskset_load(taskset_path, res);
+}
+
+static int eq_ms(const relative_time *t, unsigned long long t_ms)
+{
+  return utility_time_eq_gc_t2(t, to_utility_time_dyn(t_ms, ms));
+}
+
+MAIN_UNIT_TEST_BEGIN("utility_taskset_test", "stderr", NULL, NULL)
+{
+  taskset_desc *ts;
+  const struct taskset_task *t;
+  const struct taskset_resource *r;
+  int fd;
+
+  fd = mkstemp(taskset_path);
+  gracious_assert(fd != -1);
+  close(fd);
+
+  /* Testcase 1: the task set of rate_monotonic */
+  gracious_assert(load("# Rate monotonic\n"
+                       "STOP 13s\n"
+                       "\n"
+                       "TASK tau_1 C=2ms T=10ms\n"
+                       "TASK tau_2 C=3ms T=15ms # Comment\n"
+                       "  TASK\ttau_3 C=6ms T=26ms\n"
+                       "TASK tau_4 C=6ms T=36ms\n", &ts) == 0);
+  gracious_assert(taskset_task_count(ts) == 4);
+  gracious_assert(taskset_resource_count(ts) == 0);
+  gracious_assert(eq_ms(taskset_start(ts), 3000));
+  gracious_assert(eq_ms(taskset_stop(ts), 13000));
+  gracious_assert(!taskset_has_cpu_binding(ts));
+  t = taskset_task(ts, 2);
+  gracious_assert(strcmp(t->name, "tau_3") == 0);
+  gracious_assert(eq_ms(&t->wcet, 6) && eq_ms(&t->period, 26));
+  gracious_assert(eq_ms(&t->deadline, 26) && eq_ms(&t->offset, 0));
+  gracious_assert(t->policy == TASKSET_POLICY_FIFO);
+  gracious_assert(t->kernel == TASKSET_KERNEL_BUSYLOOP);
+  gracious_assert(t->prio_level == 3 && t->cpu == -1 && t->cs_count == 0);
+  gracious_assert(taskset_analyze(ts, 0, stderr) == 1);
+  taskset_destroy(ts);
+
+  /* Testcase 2: deadline monotonic levels, ceilings and critical
+     sections */
+  gracious_assert(load("START 1s\n"
+                       "STOP 2s\n"
+                       "RESOURCE R1 srp\n"
+                       "RESOURCE R2 inherit\n"
+                       "TASK a C=3ms T=50ms D=20ms cs=R1@1ms+1ms"
+                       " cs=R2@2ms+1ms\n"
+                       "TASK b C=1ms T=10ms offset=500us cpu=0"
+                       " kernel=sleep cs=R2@0+1ms\n"
+                       "TASK c C=1ms T=20ms cs=R1@0+500us\n", &ts) == 0);
+  gracious_assert(eq_ms(taskset_start(ts), 1000));
+  gracious_assert(taskset_has_cpu_binding(ts));
+  gracious_assert(taskset_task(ts, 0)->prio_level == 2);
+  gracious_assert(taskset_task(ts, 1)->prio_level == 1);
+  gracious_assert(taskset_task(ts, 2)->prio_level == 3);
+  t = taskset_task(ts, 0);
+  gracious_assert(t->cs_count == 2 && t->cs[1].resource == 1);
+  gracious_assert(eq_ms(&t->cs[0].start, 1) && eq_ms(&t->cs[1].length, 1));
+  t = taskset_task(ts, 1);
+  gracious_assert(utility_time_eq_gc_t2(&t->offset,
+                                        to_utility_time_dyn(500, us)));
+  gracious_assert(t->cpu == 0 && t->kernel == TASKSET_KERNEL_SLEEP);
+  r = taskset_resource(ts, 0);
+  gracious_assert(strcmp(r->name, "R1") == 0 && r->protocol == RT_LOCK_SRP);
+  gracious_assert(r->ceiling_level == 2);
+  gracious_assert(taskset_resource(ts, 1)->ceiling_level == 1);
+  gracious_assert(taskset_analyze(ts, 0, stderr) == 1);
+  taskset_destroy(ts);
+
+  /* Testcase 3: deadline tasks and unschedulable task sets */
+  gracious_assert(load("STOP 10s\n"
+                       "TASK a C=5ms T=10ms policy=deadline\n"
+                       "TASK b C=6ms T=10ms D=9ms policy=deadline\n", &ts)
+                  == 0);
+  gracious_assert(taskset_analyze(ts, 0, stderr) == 0);
+  taskset_destroy(ts);
+
+  gracious_assert(load("STOP 10s\n"
+                       "TASK a C=5ms T=10ms prio=2\n"
+                       "TASK b C=5ms T=10ms prio=1\n", &ts) == 0);
+  gracious_assert(taskset_task(ts, 0)->prio_level == 2);
+  gracious_assert(taskset_analyze(ts, 0, stderr) == -1);
+  taskset_destroy(ts);
+
+  gracious_assert(load("STOP 10s\n"
+                       "TASK a C=5ms T=10ms\n"
+                       "TASK b C=1ms T=10ms policy=deadline\n", &ts) == 0);
+  gracious_assert(taskset_analyze(ts, 0, stderr) == -1);
+  gracious_assert(taskset_analyze(ts, 1, stderr) == -1);
+  taskset_destroy(ts);
+
+  /* Testcase 4: invalid task set files */
+  gracious_assert(load("TASK a C=1ms T=10ms\n", &ts) == -1);
+  gracious_assert(load("STOP 10s\n", &ts) == -1);
+  gracious_assert(load("START 2s\nSTOP 1s\nTASK a C=1ms T=10ms\n", &ts)
+                  == -1);
+  gracious_assert(load("STOP 10s\nTASK a C=1 T=10ms\n", &ts) == -1);
+  gracious_assert(load("STOP 10s\nTASK a C=1ms\n", &ts) == -1);
+  gracious_assert(load("STOP 10s\nTASK a C=11ms T=10ms\n", &ts) == -1);
+  gracious_assert(load("STOP 10s\nTASK a C=1ms T=10ms Q=1\n", &ts) == -1);
+  gracious_assert(load("STOP 10s\nTASK a C=1ms T=10ms\n"
+                       "TASK a C=1ms T=10ms\n", &ts) == -1);
+  gracious_assert(load("STOP 10s\n"
+                       "TASK a C=1ms T=10ms D=20ms policy=deadline\n", &ts)
+                  == -1);
+  gracious_assert(load("STOP 10s\nTASK a C=1ms T=10ms prio=1\n"
+                       "TASK b C=1ms T=10ms\n", &ts) == -1);
+  gracious_assert(load("STOP 10s\nTASK a C=1ms T=10ms cs=R1@0+1ms\n", &ts)
+                  == -1);
+  gracious_assert(load("STOP 10s\nRESOURCE R1 ceiling\n", &ts) == -1);
+  gracious_assert(load("STOP 10s\nRESOURCE R1 srp\n"
+                       "TASK a C=1ms T=10ms policy=deadline cs=R1@0+1ms\n",
+                       &ts) == -1);
+  gracious_assert(load("STOP 10s\nRESOURCE R1 none\n"
+                       "TASK a C=2ms T=10ms cs=R1@1ms+2ms\n", &ts) == -1);
+  gracious_assert(load("STOP 10s\nRESOURCE R1 none\n"
+                       "TASK a C=3ms T=10ms cs=R1@1ms+1ms"
+                       " cs=R1@1500us+1ms\n", &ts) == -1);
+  gracious_assert(load("STOP 10s\nPERIOD 1s\n", &ts) == -1);
+
+  unlink(taskset_path);
+  gracious_assert(taskset_load(taskset_path, &ts) == -2);
+
+} MAIN_UNIT_TEST_END